@@ -0,0 +1,376 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Final approach position servo. Rather than shuttle at a fixed slow speed
+ * and stop at a point worked out ahead of time, the last part of a locate
+ * follows a reference profile that brings the tape to rest on the cue
+ * point. The profile speeds up or slows to a cruise speed, holds it, then
+ * slows at a constant rate to a creep just short of the cue point. The
+ * transport is stopped from the creep as the cue point is reached.
+ *
+ * The velocity commanded to the DTC is the profile velocity, taken one
+ * command lag ahead so the transport responds on time, plus a PID
+ * correction from the error between the profile position and the tape
+ * position. Any error in the DTC velocity scale, tape slip or a late
+ * response is taken out by the position loop as the approach runs.
+ *
+ * Distances are in inches along the approach toward the cue point and
+ * speeds are in IPS, negative away from the cue point. The module has no
+ * RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "ApproachServo.h"
+
+/* Static Function Prototypes */
+static void Reference(APPROACH_SERVO* servo, float t, float* pos, float* vel);
+static float StopDist(APPROACH_SERVO* servo, float v);
+
+//*****************************************************************************
+// Start a final approach to the cue point dist inches away, moving toward
+// it at v0 IPS. The profile cruises at no more than vmax, speeding up at
+// accel and slowing to the cue point at decel IPS/sec. The braking rate
+// and command lag are those of the transport after a stop. The scale
+// converts IPS to the DTC velocity to command.
+//*****************************************************************************
+
+void ApproachServo_begin(APPROACH_SERVO* servo, float dist, float v0,
+                         float vmax, float accel, float decel, float brake,
+                         float lag, float scale, uint32_t now)
+{
+    float ve = SERVO_VEL_MIN;
+    float d, dup, ddn;
+    float dc = 0.0f;
+    float vp;
+
+    if (dist < 0.0f)
+        dist = 0.0f;
+
+    if (v0 < 0.0f)
+        v0 = 0.0f;
+
+    if (vmax < v0)
+        vmax = v0;
+
+    if (vmax < ve)
+        vmax = ve;
+
+    /* Distance to cover before the creep */
+    d = dist - SERVO_CREEP_DIST;
+
+    if (d < 0.0f)
+        d = 0.0f;
+
+    ddn = ((v0 * v0) - (ve * ve)) / (2.0f * decel);
+
+    if (v0 <= ve)
+    {
+        /* Speed up from the creep speed or less */
+        vp  = ve;
+        dup = ((vmax * vmax) - (v0 * v0)) / (2.0f * accel);
+        ddn = ((vmax * vmax) - (ve * ve)) / (2.0f * decel);
+
+        if ((dup + ddn) <= d)
+        {
+            vp = vmax;
+            dc = d - dup - ddn;
+        }
+        else if (d > 0.0f)
+        {
+            vp = sqrtf((d + ((v0 * v0) / (2.0f * accel)) + ((ve * ve) / (2.0f * decel))) /
+                       ((0.5f / accel) + (0.5f / decel)));
+        }
+
+        if (vp < ve)
+            vp = ve;
+    }
+    else if (ddn >= d)
+    {
+        /* Too close to slow at the normal rate, slow harder */
+        vp = v0;
+
+        if (d > 0.0f)
+            decel = ((v0 * v0) - (ve * ve)) / (2.0f * d);
+    }
+    else
+    {
+        /* Find the cruise speed and how long it is held */
+        dup = ((vmax * vmax) - (v0 * v0)) / (2.0f * accel);
+        ddn = ((vmax * vmax) - (ve * ve)) / (2.0f * decel);
+
+        if ((dup + ddn) <= d)
+        {
+            vp = vmax;
+            dc = d - dup - ddn;
+        }
+        else
+        {
+            vp = sqrtf((d + ((v0 * v0) / (2.0f * accel)) + ((ve * ve) / (2.0f * decel))) /
+                       ((0.5f / accel) + (0.5f / decel)));
+        }
+    }
+
+    servo->dist  = dist;
+    servo->v0    = v0;
+    servo->vp    = vp;
+    servo->ve    = ve;
+    servo->accel = accel;
+    servo->decel = decel;
+    servo->t1    = (vp - v0) / accel;
+    servo->d1    = (v0 + vp) * 0.5f * servo->t1;
+    servo->t2    = servo->t1 + (dc / vp);
+    servo->d2    = servo->d1 + dc;
+    servo->t3    = servo->t2 + ((decel > 0.0f) ? ((vp - ve) / decel) : 0.0f);
+    servo->d3    = servo->d2 + ((vp + ve) * 0.5f * (servo->t3 - servo->t2));
+
+    servo->lag   = lag;
+    servo->brake = brake;
+    servo->scale = scale;
+
+    servo->startTime = now;
+    servo->lastTime  = now;
+    servo->integral  = 0.0f;
+    servo->error     = 0.0f;
+    servo->command   = 0.0f;
+    servo->cmdTime   = now;
+    servo->commanded = false;
+    servo->commands  = 0;
+    servo->velocity  = 0;
+    servo->reverse   = false;
+    servo->sumVel    = 0.0f;
+    servo->sumCmd    = 0.0f;
+    servo->gainTime  = 0;
+}
+
+//*****************************************************************************
+// Update the servo with the distance traveled since the approach began and
+// the tape speed toward the cue point. Returns the action to carry out.
+//*****************************************************************************
+
+SERVO_ACTION ApproachServo_update(APPROACH_SERVO* servo, float travel,
+                                  float velocity, uint32_t now)
+{
+    float t  = (float)(now - servo->startTime) * 0.001f;
+    float dt = (float)(now - servo->lastTime) * 0.001f;
+    float rem = servo->dist - travel;
+    float speed = fabsf(velocity);
+    float pref, vref;
+    float pff, vff;
+    float limit;
+    float cmd;
+
+    servo->lastTime = now;
+
+    /* Stop once the tape will come to rest on the cue point */
+    if ((velocity > 0.0f) && (speed <= SERVO_STOP_VEL) &&
+        (rem <= StopDist(servo, speed)))
+        return SERVO_STOP;
+
+    if ((fabsf(rem) <= SERVO_STOP_TOL) && (speed < SERVO_VEL_MIN))
+        return SERVO_STOP;
+
+    /* Measure the transport gain while the profile cruise is held */
+    if (servo->commanded && (t >= (servo->t1 + servo->lag)) && (t < servo->t2))
+    {
+        servo->sumVel   += velocity * dt;
+        servo->sumCmd   += servo->command * dt;
+        servo->gainTime += (uint32_t)(dt * 1000.0f + 0.5f);
+    }
+
+    Reference(servo, t, &pref, &vref);
+    Reference(servo, t + servo->lag, &pff, &vff);
+
+    servo->error = pref - travel;
+
+    cmd = vff + (SERVO_KP * servo->error) + (SERVO_KI * servo->integral) +
+          (SERVO_KD * (vref - velocity));
+
+    /* Keep moving toward the cue point until it is reached */
+    if (fabsf(cmd) < SERVO_VEL_MIN)
+        cmd = (rem >= 0.0f) ? SERVO_VEL_MIN : -SERVO_VEL_MIN;
+
+    /* Allow some headroom over the profile for the transport gain */
+    limit = ((servo->vp > servo->v0) ? servo->vp : servo->v0) * SERVO_HEADROOM;
+
+    if (cmd > limit)
+        cmd = limit;
+    else if (cmd < -limit)
+        cmd = -limit;
+    else
+    {
+        /* Only integrate while the command isn't limited, so the integral
+         * doesn't wind up and carry the tape past the cue point.
+         */
+        servo->integral += servo->error * dt;
+
+        limit = SERVO_I_LIMIT / SERVO_KI;
+
+        if (servo->integral > limit)
+            servo->integral = limit;
+        else if (servo->integral < -limit)
+            servo->integral = -limit;
+    }
+
+    /* Only send a new command if it has changed enough */
+    if (servo->commanded)
+    {
+        if ((now - servo->cmdTime) < SERVO_PERIOD)
+            return SERVO_NONE;
+
+        if (((cmd < 0.0f) == (servo->command < 0.0f)) &&
+            (fabsf(cmd - servo->command) < SERVO_VEL_DELTA))
+            return SERVO_NONE;
+    }
+
+    servo->command   = cmd;
+    servo->cmdTime   = now;
+    servo->commanded = true;
+    servo->commands++;
+
+    /* Never command zero, the DTC takes that as its default velocity */
+    servo->velocity = (uint32_t)((fabsf(cmd) * servo->scale) + 0.5f);
+
+    if (!servo->velocity)
+        servo->velocity = 1;
+
+    servo->reverse = (cmd < 0.0f);
+
+    return SERVO_VELOCITY;
+}
+
+//*****************************************************************************
+// Return the ms from now until the servo must be updated again if the tape
+// keeps moving at the speed given. This is the next SERVO_PERIOD boundary
+// after the last command, or when the tape reaches the point to stop if
+// that is sooner. Between encoder samples the speed estimate is held, so
+// only the predicted position moves.
+//*****************************************************************************
+
+uint32_t ApproachServo_deadline(APPROACH_SERVO* servo, float travel,
+                                float velocity, uint32_t now)
+{
+    float rem = servo->dist - travel;
+    float speed = fabsf(velocity);
+    float t;
+    float u;
+    uint32_t ms;
+
+    /* A command may go once each SERVO_PERIOD after the last one */
+    if (servo->commanded)
+    {
+        ms = SERVO_PERIOD - ((now - servo->cmdTime) % SERVO_PERIOD);
+        t = (float)ms * 0.001f;
+    }
+    else
+    {
+        t = 0.0f;
+    }
+
+    /* Time until the stop point is reached at this speed */
+    if ((velocity > 0.0f) && (speed <= SERVO_STOP_VEL))
+    {
+        if ((u = (rem - StopDist(servo, speed)) / speed) < t)
+            t = u;
+
+        if ((speed < SERVO_VEL_MIN) && ((u = (rem - SERVO_STOP_TOL) / speed) < t))
+            t = u;
+    }
+
+    if (t <= 0.0f)
+        return 0;
+
+    return (uint32_t)(t * 1000.0f);
+}
+
+//*****************************************************************************
+// Return the seconds left until the tape is stopped on the cue point.
+//*****************************************************************************
+
+float ApproachServo_time(APPROACH_SERVO* servo, uint32_t now)
+{
+    float t = servo->t3 + ((servo->dist - servo->d3) / servo->ve) -
+              ((float)(now - servo->startTime) * 0.001f);
+
+    if (t < 0.0f)
+        t = 0.0f;
+
+    return t + servo->lag;
+}
+
+//*****************************************************************************
+// Return the measured ratio of the speed reached to the speed commanded,
+// or zero if the cruise wasn't held long enough to measure it.
+//*****************************************************************************
+
+float ApproachServo_gain(APPROACH_SERVO* servo)
+{
+    if ((servo->gainTime < (uint32_t)(SERVO_GAIN_TIME * 1000.0f)) || (servo->sumCmd <= 0.0f))
+        return 0.0f;
+
+    return servo->sumVel / servo->sumCmd;
+}
+
+//*****************************************************************************
+// Return the profile position and velocity t seconds into the approach.
+//*****************************************************************************
+
+static void Reference(APPROACH_SERVO* servo, float t, float* pos, float* vel)
+{
+    float a;
+    float u;
+
+    if (t <= 0.0f)
+    {
+        *pos = 0.0f;
+        *vel = servo->v0;
+    }
+    else if (t < servo->t1)
+    {
+        a = (servo->vp - servo->v0) / servo->t1;
+        *pos = (servo->v0 * t) + (0.5f * a * t * t);
+        *vel = servo->v0 + (a * t);
+    }
+    else if (t < servo->t2)
+    {
+        *pos = servo->d1 + (servo->vp * (t - servo->t1));
+        *vel = servo->vp;
+    }
+    else if (t < servo->t3)
+    {
+        u = t - servo->t2;
+        *pos = servo->d2 + (servo->vp * u) - (0.5f * servo->decel * u * u);
+        *vel = servo->vp - (servo->decel * u);
+    }
+    else
+    {
+        /* Creep on to the cue point and hold there */
+        *pos = servo->d3 + (servo->ve * (t - servo->t3));
+        *vel = servo->ve;
+
+        if (*pos >= servo->dist)
+        {
+            *pos = servo->dist;
+            *vel = 0.0f;
+        }
+    }
+}
+
+/* Distance to stop from speed v after a stop command */
+static float StopDist(APPROACH_SERVO* servo, float v)
+{
+    return (v * servo->lag) + ((v * v) / (2.0f * servo->brake));
+}
+
+/* End-Of-File */
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _APPROACHSERVO_H_
+#define _APPROACHSERVO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Position loop gains. The position error is in inches and the output is
+ * a correction to the feed-forward velocity in IPS. The derivative term
+ * acts on the velocity error, which is the derivative of the position
+ * error without the encoder tick quantization.
+ */
+#define SERVO_KP                8.0f    /* IPS per inch                 */
+#define SERVO_KI                1.0f    /* IPS per inch-second          */
+#define SERVO_KD                0.25f   /* IPS per IPS                  */
+
+/* Largest correction in IPS the integral term may make */
+#define SERVO_I_LIMIT           15.0f
+
+/* Commands may go this much over the profile speed to make up for the
+ * DTC velocity scale being off.
+ */
+#define SERVO_HEADROOM          1.25f
+
+/* Velocity commands are sent no more often than every SERVO_PERIOD ms and
+ * only when the velocity has changed by SERVO_VEL_DELTA IPS, so the IPC
+ * link to the DTC isn't flooded.
+ */
+#define SERVO_PERIOD            10
+#define SERVO_VEL_DELTA         1.0f
+
+/* Slowest velocity in IPS commanded. The DTC can't servo the reels any
+ * slower, so the profile slows to this speed SERVO_CREEP_DIST inches
+ * short of the cue point and creeps the rest of the way. The stop from
+ * creep speed is short, so the lag in stopping barely matters.
+ */
+#define SERVO_VEL_MIN           3.0f
+#define SERVO_CREEP_DIST        0.50f
+
+/* The servo stops the transport once it is below SERVO_STOP_VEL IPS and
+ * would come to rest on the cue point, or once it is creeping within
+ * SERVO_STOP_TOL inches of the cue point.
+ */
+#define SERVO_STOP_VEL          10.0f
+#define SERVO_STOP_TOL          0.10f
+
+/* Seconds of the profile cruise needed to measure the transport gain */
+#define SERVO_GAIN_TIME         0.100f
+
+/* Servo actions returned for the caller to carry out */
+typedef enum _SERVO_ACTION {
+    SERVO_NONE,                 /* nothing to do this update        */
+    SERVO_VELOCITY,             /* command the servo velocity       */
+    SERVO_STOP,                 /* stop the transport, servo done   */
+} SERVO_ACTION;
+
+/*** APPROACH SERVO DATA ***************************************************/
+
+typedef struct _APPROACH_SERVO {
+    /* Reference profile, distances in inches from the start */
+    float       dist;           /* distance to the cue point        */
+    float       v0;             /* speed at the start               */
+    float       vp;             /* profile cruise speed             */
+    float       ve;             /* profile creep speed at the end   */
+    float       accel;          /* rate to reach the cruise speed   */
+    float       decel;          /* rate to stop at the cue point    */
+    float       t1;             /* end of speed change to cruise    */
+    float       t2;             /* end of cruise                    */
+    float       t3;             /* end of slowing, creep to the cue */
+    float       d1;             /* distance at t1                   */
+    float       d2;             /* distance at t2                   */
+    float       d3;             /* distance at t3                   */
+    /* Transport */
+    float       lag;            /* seconds to respond to a command  */
+    float       brake;          /* braking rate after a stop        */
+    float       scale;          /* DTC velocity per IPS             */
+    /* Loop state */
+    uint32_t    startTime;      /* ms the profile started           */
+    uint32_t    lastTime;       /* ms of the last update            */
+    float       integral;       /* position error integral          */
+    float       error;          /* last position error in inches    */
+    float       command;        /* last IPS commanded, signed       */
+    uint32_t    cmdTime;        /* ms of the last command           */
+    bool        commanded;      /* a command has been sent          */
+    uint32_t    commands;       /* velocity commands sent           */
+    /* Output */
+    uint32_t    velocity;       /* DTC velocity to command          */
+    bool        reverse;        /* command away from the cue point  */
+    /* Gain measurement */
+    float       sumVel;         /* speed measured during cruise     */
+    float       sumCmd;         /* speed commanded during cruise    */
+    uint32_t    gainTime;       /* ms of cruise measured            */
+} APPROACH_SERVO;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void ApproachServo_begin(APPROACH_SERVO* servo, float dist, float v0,
+                         float vmax, float accel, float decel, float brake,
+                         float lag, float scale, uint32_t now);
+
+SERVO_ACTION ApproachServo_update(APPROACH_SERVO* servo, float travel,
+                                  float velocity, uint32_t now);
+
+uint32_t ApproachServo_deadline(APPROACH_SERVO* servo, float travel,
+                                float velocity, uint32_t now);
+
+float ApproachServo_time(APPROACH_SERVO* servo, uint32_t now);
+
+float ApproachServo_gain(APPROACH_SERVO* servo);
+
+#endif  /* _APPROACHSERVO_H_ */
@@ -0,0 +1,189 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Auto-punch timing. Once the locate task has located to the pre-roll
+ * point and put the transport in play, this works out when the punch-in
+ * and punch-out commands must be sent so record starts and ends with the
+ * tape at the punch points.
+ *
+ * Each update takes the tape position predicted from the motion estimate
+ * and the tape velocity, and gives the time until the tape reaches the
+ * next punch point less the command lead time. The lead is the time from
+ * a command being sent to the transport acting on it. The caller sleeps
+ * until that time runs out or the next encoder sample comes in, so the
+ * punch is sent on the system tick it falls due rather than on the next
+ * pass of a polled loop. After punch-out the tape plays on for the post
+ * roll time before the punch is done.
+ *
+ * The lead is learned from how long the transport takes to report record
+ * on or off after each punch is sent. This is kept apart from the locate
+ * planner command lag, which is timed to the reel servo braking and so
+ * takes in some of the servo response as well. The module has no RTOS
+ * dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "AutoPunch.h"
+
+/* Static Function Prototypes */
+static float DueTime(AUTO_PUNCH* ap, int32_t point, float pos, float velocity);
+
+//*****************************************************************************
+// Return the pre-roll point to locate to, the given seconds of play ahead
+// of the punch-in point.
+//*****************************************************************************
+
+int32_t AutoPunch_preroll(int32_t in, float seconds, float ips, float inchesPerTick)
+{
+    return in - (int32_t)lroundf((seconds * ips) / inchesPerTick);
+}
+
+//*****************************************************************************
+// Start a punch with the transport in play ahead of the punch-in point.
+//*****************************************************************************
+
+void AutoPunch_begin(AUTO_PUNCH* ap, int32_t in, int32_t out, float inchesPerTick,
+                     float lead, uint32_t postroll)
+{
+    ap->in            = in;
+    ap->out           = out;
+    ap->inchesPerTick = inchesPerTick;
+    ap->lead          = lead;
+    ap->postroll      = postroll;
+    ap->phase         = PUNCH_ARMED;
+    ap->sentTime      = 0;
+    ap->outTime       = 0;
+    ap->due           = 0.0f;
+    ap->pending       = false;
+}
+
+//*****************************************************************************
+// Run the punch from a new tape position and velocity. The position is in
+// encoder counts and may carry a fraction of a count. Returns the action
+// the caller must take now.
+//*****************************************************************************
+
+PUNCH_ACTION AutoPunch_update(AUTO_PUNCH* ap, float pos, float velocity, uint32_t now)
+{
+    switch(ap->phase)
+    {
+    case PUNCH_ARMED:
+        if ((ap->due = DueTime(ap, ap->in, pos, velocity)) > PUNCH_DUE_TIME)
+            break;
+
+        ap->phase    = PUNCH_RECORD;
+        ap->due      = DueTime(ap, ap->out, pos, velocity);
+        ap->sentTime = now;
+        ap->pending  = true;
+        return PUNCH_IN;
+
+    case PUNCH_RECORD:
+        if ((ap->due = DueTime(ap, ap->out, pos, velocity)) > PUNCH_DUE_TIME)
+            break;
+
+        ap->phase    = PUNCH_POSTROLL;
+        ap->outTime  = now;
+        ap->due      = (float)ap->postroll * 0.001f;
+        ap->sentTime = now;
+        ap->pending  = true;
+        return PUNCH_OUT;
+
+    case PUNCH_POSTROLL:
+        if ((now - ap->outTime) < ap->postroll)
+        {
+            ap->due = (float)(ap->postroll - (now - ap->outTime)) * 0.001f;
+            break;
+        }
+
+        ap->phase = PUNCH_DONE;
+        ap->due   = 0.0f;
+        return PUNCH_END;
+
+    default:
+        ap->due = 0.0f;
+        break;
+    }
+
+    return PUNCH_NONE;
+}
+
+//*****************************************************************************
+// Return the ms the caller may sleep before the next punch action is due,
+// or zero to run the update again at once. This is at least 1 ms while a
+// punch is still ahead, as the caller can't wake any sooner.
+//*****************************************************************************
+
+uint32_t AutoPunch_deadline(AUTO_PUNCH* ap)
+{
+    float ms;
+
+    if (ap->phase == PUNCH_DONE)
+        return 0;
+
+    if ((ms = ap->due * 1000.0f) >= (float)UINT32_MAX)
+        return UINT32_MAX;
+
+    /* Round down so the update runs no later than the punch time */
+    return (ms < 1.0f) ? 1 : (uint32_t)ms;
+}
+
+//*****************************************************************************
+// Learn the punch lag from the transport record state and the ms it last
+// turned on or off. The lag is only learned once for each punch, when the
+// transport reports the record state the punch asked for after it was
+// sent. Returns true if the lag was learned.
+//*****************************************************************************
+
+bool AutoPunch_response(AUTO_PUNCH* ap, bool record, uint32_t time, float* lag)
+{
+    float t;
+
+    if (!ap->pending || (record != (ap->phase == PUNCH_RECORD)))
+        return false;
+
+    /* Record changed before this punch was sent */
+    if ((int32_t)(time - ap->sentTime) < 0)
+        return false;
+
+    ap->pending = false;
+
+    if ((t = (float)(time - ap->sentTime) * 0.001f) > PUNCH_LAG_MAX)
+        return false;
+
+    *lag += PUNCH_LEARN_RATE * (t - *lag);
+
+    /* The punch-out is sent with the lag just learned */
+    ap->lead = *lag;
+
+    return true;
+}
+
+/* Seconds until the command for a punch point must be sent */
+static float DueTime(AUTO_PUNCH* ap, int32_t point, float pos, float velocity)
+{
+    float dist = ((float)point - pos) * ap->inchesPerTick;
+
+    /* Already at or past the point */
+    if (dist <= 0.0f)
+        return 0.0f;
+
+    /* Not moving toward it fast enough to tell when */
+    if (velocity < PUNCH_VEL_MIN)
+        return HUGE_VALF;
+
+    return (dist / velocity) - ap->lead;
+}
+
+/* End-Of-File */
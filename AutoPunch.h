@@ -0,0 +1,79 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _AUTOPUNCH_H_
+#define _AUTOPUNCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Below this tape speed in IPS the time to a punch point isn't predicted
+ * and a punch is only due once the tape is past the point.
+ */
+#define PUNCH_VEL_MIN           1.0f
+
+/* A punch is sent once it is due within this many seconds, half of the
+ * 1 ms system tick the caller wakes on.
+ */
+#define PUNCH_DUE_TIME          0.0005f
+
+/* The punch lag is learned from the time the transport takes to report
+ * record on or off after each punch. Longer times are ignored.
+ */
+#define PUNCH_LEARN_RATE        0.25f
+#define PUNCH_LAG_MAX           0.250f
+
+/*** AUTO PUNCH DATA *******************************************************/
+
+typedef enum PUNCH_PHASE {
+    PUNCH_ARMED=0,              /* playing toward the punch-in point  */
+    PUNCH_RECORD,               /* punched in, toward the punch-out   */
+    PUNCH_POSTROLL,             /* punched out, playing the post-roll */
+    PUNCH_DONE
+} PUNCH_PHASE;
+
+typedef enum PUNCH_ACTION {
+    PUNCH_NONE=0,
+    PUNCH_IN,                   /* send the punch-in now              */
+    PUNCH_OUT,                  /* send the punch-out now             */
+    PUNCH_END                   /* post-roll over, stop the transport */
+} PUNCH_ACTION;
+
+typedef struct _AUTO_PUNCH {
+    int32_t     in;             /* punch-in encoder count             */
+    int32_t     out;            /* punch-out encoder count            */
+    float       inchesPerTick;  /* roller travel per encoder tick     */
+    float       lead;           /* seconds from command to response   */
+    uint32_t    postroll;       /* ms to play on after punch-out      */
+    PUNCH_PHASE phase;
+    uint32_t    sentTime;       /* ms the last punch was sent         */
+    uint32_t    outTime;        /* ms the punch-out was sent          */
+    float       due;            /* seconds until the next punch is sent */
+    bool        pending;        /* last punch not yet reported        */
+} AUTO_PUNCH;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+int32_t AutoPunch_preroll(int32_t in, float seconds, float ips, float inchesPerTick);
+
+void AutoPunch_begin(AUTO_PUNCH* ap, int32_t in, int32_t out, float inchesPerTick,
+                     float lead, uint32_t postroll);
+
+PUNCH_ACTION AutoPunch_update(AUTO_PUNCH* ap, float pos, float velocity, uint32_t now);
+
+uint32_t AutoPunch_deadline(AUTO_PUNCH* ap);
+
+bool AutoPunch_response(AUTO_PUNCH* ap, bool record, uint32_t time, float* lag);
+
+#endif  /* _AUTOPUNCH_H_ */
@@ -127,6 +127,9 @@ MK_CMD(rtz);
 MK_CMD(zero);
 MK_CMD(speed);
 MK_CMD(smpte);
+MK_CMD(slip);
+MK_CMD(telem);
+MK_CMD(plan);
 MK_CMD(time);
 MK_CMD(date);
 MK_CMD(stat);
@@ -160,6 +163,9 @@ cmd_t dispatch[] = {
     CMD(zero,   "Tape time counter zero reset"),
     CMD(speed,  "Show or set tape speed {15:30}"),
     CMD(smpte,  "SMPTE generator {start|stop}"),
+    CMD(slip,   "Roller slip status or correct {on|off}"),
+    CMD(telem,  "Telemetry status or sample period {ms|off}"),
+    CMD(plan,   "Locate planner model {reset|learn on|off}"),
     CMD(time,   "Time show or set {hh:mm:ss}"),
     CMD(date,   "Date show or set {mm/dd/yyyy}"),
     CMD(stat,   "Show system status"),
@@ -239,6 +245,8 @@ int CLI_init(void)
     if (s_handleUart == NULL)
         System_abort("Error initializing UART\n");
 
+    xmodem_init();
+
     return 1;
 }
 
@@ -702,14 +710,44 @@ void cmd_mac(int argc, char *argv[])
 
 void cmd_stat(int argc, char *argv[])
 {
+    TRANSPORT_STATE ts;
+    INDEX_STATS index;
+
+    TransportState_get(&ts);
+    PositionGetIndexStats(&index);
+
     /* Show basic system status */
     CLI_printf("\nSYSTEM STATUS\n\n");
-    CLI_printf("Tape roller tach   : %u\n", (uint32_t)g_sys.tapeTach);
+    CLI_printf("Tape roller tach   : %u\n", (uint32_t)ts.tapeTach);
+    CLI_printf("Tape velocity      : %.1f IPS\n", ts.tapeVelocity);
     CLI_printf("Tape roller errors : %u\n", g_sys.qei_error_cnt);
-    CLI_printf("Encoder position   : %d\n", g_sys.tapePosition);
-    CLI_printf("Tape Speed         : %d IPS\n", g_sys.tapeSpeed);
+    CLI_printf("Encoder position   : %d\n", ts.tapePosition);
+    CLI_printf("Roller circ (uin)  : %u\n", TapeTime_getCircumference());
+    CLI_printf("Index revolutions  : %u\n", index.revolutions);
+    CLI_printf("Index miscounts    : %u (last %d)\n", index.miscounts, index.lastError);
+    CLI_printf("Index corrections  : %u (%u ticks)\n", index.corrections, index.ticksCorrected);
+    CLI_printf("Index faults       : %u\n", index.faults);
+    CLI_printf("Tape Speed         : %d IPS\n", ts.tapeSpeed);
+    CLI_printf("State version      : %u\n", ts.version);
+    CLI_printf("Locate ETA         : %u ms\n", ts.searching ? ts.searchETA : 0);
     CLI_printf("RTC clock type     : %s\n", (g_sys.rtcFound) ? "RTC" : "CPU");
     CLI_printf("IPC rx errors      : %d\n", g_ipc.rxErrors);
+    CLI_printf("IPC rx bad frames  : %u (%u crc, %u resyncs)\n",
+               g_ipc.rxParser.stats.preamble + g_ipc.rxParser.stats.length +
+               g_ipc.rxParser.stats.crc + g_ipc.rxParser.stats.aborted,
+               g_ipc.rxParser.stats.crc, g_ipc.rxParser.stats.resyncs);
+    CLI_printf("IPC rx bytes lost  : %u\n", g_ipc.rxParser.stats.skipped);
+#if (IPC_ARQ_ENABLED > 0)
+    CLI_printf("IPC tx resent      : %u (%u nak, %u given up)\n", g_ipc.arq.stats.txResent,
+               g_ipc.arq.stats.txNaks, g_ipc.arq.stats.txFailed);
+    CLI_printf("IPC rx held        : %u (%u dups, %u skipped)\n", g_ipc.arq.stats.rxHeld,
+               g_ipc.arq.stats.rxDuplicates, g_ipc.arq.stats.rxSkipped);
+    CLI_printf("IPC retransmit     : %u ms (%u ms max rtt)\n", g_ipc.arq.rto,
+               g_ipc.arq.stats.rttMax);
+#endif
+    CLI_printf("IPC transactions   : %u (%u timeouts, %u late, %u peak)\n",
+               g_ipc.trans.stats.opened, g_ipc.trans.stats.timeouts,
+               g_ipc.trans.stats.late, g_ipc.trans.stats.peak);
     CLI_printf("Standby Mon Active : %c\n", (g_sys.standbyActive) ? '1' : '0');
 
     /* Show if DCS controller found or not */
@@ -993,6 +1031,121 @@ void cmd_smpte(int argc, char *argv[])
     }
 }
 
+void cmd_slip(int argc, char *argv[])
+{
+    if (argc == 1)
+    {
+        if (strcmp(argv[0], "on") == 0)
+            g_sys.cfgSTC.slipCorrect = TRUE;
+        else if (strcmp(argv[0], "off") == 0)
+            g_sys.cfgSTC.slipCorrect = FALSE;
+        else
+        {
+            CLI_puts("Usage: slip {on|off}\n");
+            return;
+        }
+    }
+
+    CLI_printf("Slip correction    : %s\n", (g_sys.cfgSTC.slipCorrect) ? "ON" : "OFF");
+    CLI_printf("Roller slipping    : %c\n", (g_sys.slipFlags & SLIP_F_SLIP) ? '1' : '0');
+    CLI_printf("QEI error burst    : %c\n", (g_sys.slipFlags & SLIP_F_ERRORS) ? '1' : '0');
+    CLI_printf("DTC reel tach      : %.1f\n", g_sys.dtcTach);
+}
+
+void cmd_telem(int argc, char *argv[])
+{
+    uint32_t period;
+
+    if (argc == 1)
+    {
+        if (strcmp(argv[0], "off") == 0)
+            period = 0;
+        else
+            period = (uint32_t)atoi(argv[0]);
+
+        if (!period && strcmp(argv[0], "off"))
+        {
+            CLI_puts("Usage: telem {1-1000|off}\n");
+            return;
+        }
+
+        if (!Telemetry_setPeriod(period))
+        {
+            CLI_puts("Invalid period\n");
+            return;
+        }
+    }
+
+    period = Telemetry_getPeriod();
+
+    if (period)
+        CLI_printf("Telemetry period   : %u ms\n", period);
+    else
+        CLI_printf("Telemetry period   : OFF\n");
+
+    CLI_printf("Telemetry samples  : %u\n", Telemetry_getSequence());
+    CLI_printf("Telemetry port     : %u\n", STC_PORT_TELEMETRY);
+}
+
+void cmd_plan(int argc, char *argv[])
+{
+    int i;
+    int dir;
+    STC_LOCATE_MODEL* model = &g_sys.cfgSTC.locateModel;
+    static const char* dirName[2] = { "FWD", "REW" };
+
+    if ((argc == 1) && (strcmp(argv[0], "reset") == 0))
+    {
+        LocatePlan_initModel(model);
+    }
+    else if ((argc == 2) && (strcmp(argv[0], "learn") == 0))
+    {
+        if (strcmp(argv[1], "on") == 0)
+            g_sys.cfgSTC.locateLearn = TRUE;
+        else if (strcmp(argv[1], "off") == 0)
+            g_sys.cfgSTC.locateLearn = FALSE;
+        else
+        {
+            CLI_puts("Usage: plan learn {on|off}\n");
+            return;
+        }
+    }
+    else if (argc)
+    {
+        CLI_puts("Usage: plan {reset|learn on|off}\n");
+        return;
+    }
+
+    CLI_printf("Model learning     : %s\n", (g_sys.cfgSTC.locateLearn) ? "ON" : "OFF");
+    CLI_printf("Locates learned    : %u\n", model->locates);
+
+    for (dir=PLAN_FWD; dir <= PLAN_REW; dir++)
+    {
+        CLI_printf("%s cruise (IPS)    : %.1f %.1f %.1f\n", dirName[dir],
+                   model->cruise[dir][PLAN_SPEED_FAR],
+                   model->cruise[dir][PLAN_SPEED_MID],
+                   model->cruise[dir][PLAN_SPEED_NEAR]);
+        CLI_printf("%s slow (IPS)      : %.1f\n", dirName[dir], model->slow[dir]);
+        CLI_printf("%s accel (IPS/s)   : %.1f\n", dirName[dir], model->accel[dir]);
+        CLI_printf("%s lag (ms)        : %.1f\n", dirName[dir], model->lag[dir] * 1000.0f);
+        CLI_printf("%s decel (IPS/s)   :", dirName[dir]);
+
+        for (i=0; i < STC_PLAN_BANDS; i++)
+            CLI_printf(" %.0f", model->decel[dir][i]);
+
+        CLI_printf("\n");
+    }
+
+    CLI_printf("Punch lag (ms)     : %.1f\n", model->punch * 1000.0f);
+    CLI_printf("Loop spin-up (in)  : %.2f\n", model->spinup);
+    CLI_printf("Loop turn (IPS/s)  :");
+
+    for (i=0; i < STC_PLAN_BANDS; i++)
+        CLI_printf(" %.0f", model->reverse[i]);
+
+    CLI_printf("\n");
+}
+
 //*****************************************************************************
 // TIME AND DATE COMMANDS
 //*****************************************************************************
@@ -10,19 +10,33 @@
  *
  ***************************************************************************/
 
+/* CRC-16 for the IPC and RAMP frames and the XMODEM transfers.
+ *
+ * The frame CRC sums a byte at a time through the table below, shifting
+ * the CRC a byte left. The table is the one for the reflected CCITT
+ * polynomial, so the frame CRC is not one of the usual CRC-16s, but it is
+ * what the DTC and the remote send and has to stay. It is still linear, so
+ * a block is summed eight or four bytes at a time with a table for each
+ * byte position, built from the first table by running zero bytes through
+ * it. Each table gives what a byte sums to with the given number of bytes
+ * after it. The result is the same as summing a byte at a time.
+ *
+ * XMODEM uses the CCITT polynomial sent MSB first. The TM4C129 CRC module
+ * does this one, so on the target the XMODEM blocks are summed by the
+ * hardware. The host tools use a byte table.
+ */
 
-/* BIOS Header files */
-#include <ti/sysbios/family/arm/m3/Hwi.h>
-
-#include <file.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #include "CRC16.h"
 
+#if (CRC16_HW_CCM > 0)
+#include <inc/hw_memmap.h>
+#include <driverlib/sysctl.h>
+#include <driverlib/crc.h>
+#endif
+
 /* Static CRC Data */
 
 static const uint16_t s_table[256] = {
@@ -60,7 +74,382 @@ static const uint16_t s_table[256] = {
      0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
 };
 
+/* Frame CRC tables for the bytes ahead of the last in a slice */
+static const uint16_t s_slice[CRC16_SLICE - 1][256] = {
+    {   /* byte 1 from the end */
+        0x0000, 0x8808, 0x0199, 0x8991, 0x0332, 0x8B3A, 0x02AB, 0x8AA3,
+        0x0664, 0x8E6C, 0x07FD, 0x8FF5, 0x0556, 0x8D5E, 0x04CF, 0x8CC7,
+        0x9181, 0x1989, 0x9018, 0x1810, 0x92B3, 0x1ABB, 0x932A, 0x1B22,
+        0x97E5, 0x1FED, 0x967C, 0x1E74, 0x94D7, 0x1CDF, 0x954E, 0x1D46,
+        0x328B, 0xBA83, 0x3312, 0xBB1A, 0x31B9, 0xB9B1, 0x3020, 0xB828,
+        0x34EF, 0xBCE7, 0x3576, 0xBD7E, 0x37DD, 0xBFD5, 0x3644, 0xBE4C,
+        0xA30A, 0x2B02, 0xA293, 0x2A9B, 0xA038, 0x2830, 0xA1A1, 0x29A9,
+        0xA56E, 0x2D66, 0xA4F7, 0x2CFF, 0xA65C, 0x2E54, 0xA7C5, 0x2FCD,
+        0x6516, 0xED1E, 0x648F, 0xEC87, 0x6624, 0xEE2C, 0x67BD, 0xEFB5,
+        0x6372, 0xEB7A, 0x62EB, 0xEAE3, 0x6040, 0xE848, 0x61D9, 0xE9D1,
+        0xF497, 0x7C9F, 0xF50E, 0x7D06, 0xF7A5, 0x7FAD, 0xF63C, 0x7E34,
+        0xF2F3, 0x7AFB, 0xF36A, 0x7B62, 0xF1C1, 0x79C9, 0xF058, 0x7850,
+        0x579D, 0xDF95, 0x5604, 0xDE0C, 0x54AF, 0xDCA7, 0x5536, 0xDD3E,
+        0x51F9, 0xD9F1, 0x5060, 0xD868, 0x52CB, 0xDAC3, 0x5352, 0xDB5A,
+        0xC61C, 0x4E14, 0xC785, 0x4F8D, 0xC52E, 0x4D26, 0xC4B7, 0x4CBF,
+        0xC078, 0x4870, 0xC1E1, 0x49E9, 0xC34A, 0x4B42, 0xC2D3, 0x4ADB,
+        0xCA2C, 0x4224, 0xCBB5, 0x43BD, 0xC91E, 0x4116, 0xC887, 0x408F,
+        0xCC48, 0x4440, 0xCDD1, 0x45D9, 0xCF7A, 0x4772, 0xCEE3, 0x46EB,
+        0x5BAD, 0xD3A5, 0x5A34, 0xD23C, 0x589F, 0xD097, 0x5906, 0xD10E,
+        0x5DC9, 0xD5C1, 0x5C50, 0xD458, 0x5EFB, 0xD6F3, 0x5F62, 0xD76A,
+        0xF8A7, 0x70AF, 0xF93E, 0x7136, 0xFB95, 0x739D, 0xFA0C, 0x7204,
+        0xFEC3, 0x76CB, 0xFF5A, 0x7752, 0xFDF1, 0x75F9, 0xFC68, 0x7460,
+        0x6926, 0xE12E, 0x68BF, 0xE0B7, 0x6A14, 0xE21C, 0x6B8D, 0xE385,
+        0x6F42, 0xE74A, 0x6EDB, 0xE6D3, 0x6C70, 0xE478, 0x6DE9, 0xE5E1,
+        0xAF3A, 0x2732, 0xAEA3, 0x26AB, 0xAC08, 0x2400, 0xAD91, 0x2599,
+        0xA95E, 0x2156, 0xA8C7, 0x20CF, 0xAA6C, 0x2264, 0xABF5, 0x23FD,
+        0x3EBB, 0xB6B3, 0x3F22, 0xB72A, 0x3D89, 0xB581, 0x3C10, 0xB418,
+        0x38DF, 0xB0D7, 0x3946, 0xB14E, 0x3BED, 0xB3E5, 0x3A74, 0xB27C,
+        0x9DB1, 0x15B9, 0x9C28, 0x1420, 0x9E83, 0x168B, 0x9F1A, 0x1712,
+        0x9BD5, 0x13DD, 0x9A4C, 0x1244, 0x98E7, 0x10EF, 0x997E, 0x1176,
+        0x0C30, 0x8438, 0x0DA9, 0x85A1, 0x0F02, 0x870A, 0x0E9B, 0x8693,
+        0x0A54, 0x825C, 0x0BCD, 0x83C5, 0x0966, 0x816E, 0x08FF, 0x80F7
+    },
+    {   /* byte 2 from the end */
+        0x0000, 0x0040, 0x8889, 0x88C9, 0x009B, 0x00DB, 0x8812, 0x8852,
+        0x0136, 0x0176, 0x89BF, 0x89FF, 0x01AD, 0x01ED, 0x8924, 0x8964,
+        0x0400, 0x0440, 0x8C89, 0x8CC9, 0x049B, 0x04DB, 0x8C12, 0x8C52,
+        0x0536, 0x0576, 0x8DBF, 0x8DFF, 0x05AD, 0x05ED, 0x8D24, 0x8D64,
+        0x9991, 0x99D1, 0x1118, 0x1158, 0x990A, 0x994A, 0x1183, 0x11C3,
+        0x98A7, 0x98E7, 0x102E, 0x106E, 0x983C, 0x987C, 0x10B5, 0x10F5,
+        0x9D91, 0x9DD1, 0x1518, 0x1558, 0x9D0A, 0x9D4A, 0x1583, 0x15C3,
+        0x9CA7, 0x9CE7, 0x142E, 0x146E, 0x9C3C, 0x9C7C, 0x14B5, 0x14F5,
+        0x22AB, 0x22EB, 0xAA22, 0xAA62, 0x2230, 0x2270, 0xAAB9, 0xAAF9,
+        0x239D, 0x23DD, 0xAB14, 0xAB54, 0x2306, 0x2346, 0xAB8F, 0xABCF,
+        0x26AB, 0x26EB, 0xAE22, 0xAE62, 0x2630, 0x2670, 0xAEB9, 0xAEF9,
+        0x279D, 0x27DD, 0xAF14, 0xAF54, 0x2706, 0x2746, 0xAF8F, 0xAFCF,
+        0xBB3A, 0xBB7A, 0x33B3, 0x33F3, 0xBBA1, 0xBBE1, 0x3328, 0x3368,
+        0xBA0C, 0xBA4C, 0x3285, 0x32C5, 0xBA97, 0xBAD7, 0x321E, 0x325E,
+        0xBF3A, 0xBF7A, 0x37B3, 0x37F3, 0xBFA1, 0xBFE1, 0x3728, 0x3768,
+        0xBE0C, 0xBE4C, 0x3685, 0x36C5, 0xBE97, 0xBED7, 0x361E, 0x365E,
+        0x4556, 0x4516, 0xCDDF, 0xCD9F, 0x45CD, 0x458D, 0xCD44, 0xCD04,
+        0x4460, 0x4420, 0xCCE9, 0xCCA9, 0x44FB, 0x44BB, 0xCC72, 0xCC32,
+        0x4156, 0x4116, 0xC9DF, 0xC99F, 0x41CD, 0x418D, 0xC944, 0xC904,
+        0x4060, 0x4020, 0xC8E9, 0xC8A9, 0x40FB, 0x40BB, 0xC872, 0xC832,
+        0xDCC7, 0xDC87, 0x544E, 0x540E, 0xDC5C, 0xDC1C, 0x54D5, 0x5495,
+        0xDDF1, 0xDDB1, 0x5578, 0x5538, 0xDD6A, 0xDD2A, 0x55E3, 0x55A3,
+        0xD8C7, 0xD887, 0x504E, 0x500E, 0xD85C, 0xD81C, 0x50D5, 0x5095,
+        0xD9F1, 0xD9B1, 0x5178, 0x5138, 0xD96A, 0xD92A, 0x51E3, 0x51A3,
+        0x67FD, 0x67BD, 0xEF74, 0xEF34, 0x6766, 0x6726, 0xEFEF, 0xEFAF,
+        0x66CB, 0x668B, 0xEE42, 0xEE02, 0x6650, 0x6610, 0xEED9, 0xEE99,
+        0x63FD, 0x63BD, 0xEB74, 0xEB34, 0x6366, 0x6326, 0xEBEF, 0xEBAF,
+        0x62CB, 0x628B, 0xEA42, 0xEA02, 0x6250, 0x6210, 0xEAD9, 0xEA99,
+        0xFE6C, 0xFE2C, 0x76E5, 0x76A5, 0xFEF7, 0xFEB7, 0x767E, 0x763E,
+        0xFF5A, 0xFF1A, 0x77D3, 0x7793, 0xFFC1, 0xFF81, 0x7748, 0x7708,
+        0xFA6C, 0xFA2C, 0x72E5, 0x72A5, 0xFAF7, 0xFAB7, 0x727E, 0x723E,
+        0xFB5A, 0xFB1A, 0x73D3, 0x7393, 0xFBC1, 0xFB81, 0x7348, 0x7308
+    },
+    {   /* byte 3 from the end */
+        0x0000, 0x4000, 0x8140, 0xC140, 0x9B00, 0xDB00, 0x1A40, 0x5A40,
+        0x2789, 0x6789, 0xA6C9, 0xE6C9, 0xBC89, 0xFC89, 0x3DC9, 0x7DC9,
+        0x4624, 0x0624, 0xC764, 0x8764, 0xDD24, 0x9D24, 0x5C64, 0x1C64,
+        0x61AD, 0x21AD, 0xE0ED, 0xA0ED, 0xFAAD, 0xBAAD, 0x7BED, 0x3BED,
+        0x9848, 0xD848, 0x1908, 0x5908, 0x0348, 0x4348, 0x8208, 0xC208,
+        0xBFC1, 0xFFC1, 0x3E81, 0x7E81, 0x24C1, 0x64C1, 0xA581, 0xE581,
+        0xDE6C, 0x9E6C, 0x5F2C, 0x1F2C, 0x456C, 0x056C, 0xC42C, 0x842C,
+        0xF9E5, 0xB9E5, 0x78A5, 0x38A5, 0x62E5, 0x22E5, 0xE3A5, 0xA3A5,
+        0xA910, 0xE910, 0x2850, 0x6850, 0x3210, 0x7210, 0xB350, 0xF350,
+        0x8E99, 0xCE99, 0x0FD9, 0x4FD9, 0x1599, 0x5599, 0x94D9, 0xD4D9,
+        0xEF34, 0xAF34, 0x6E74, 0x2E74, 0x7434, 0x3434, 0xF574, 0xB574,
+        0xC8BD, 0x88BD, 0x49FD, 0x09FD, 0x53BD, 0x13BD, 0xD2FD, 0x92FD,
+        0x3158, 0x7158, 0xB018, 0xF018, 0xAA58, 0xEA58, 0x2B18, 0x6B18,
+        0x16D1, 0x56D1, 0x9791, 0xD791, 0x8DD1, 0xCDD1, 0x0C91, 0x4C91,
+        0x777C, 0x377C, 0xF63C, 0xB63C, 0xEC7C, 0xAC7C, 0x6D3C, 0x2D3C,
+        0x50F5, 0x10F5, 0xD1B5, 0x91B5, 0xCBF5, 0x8BF5, 0x4AB5, 0x0AB5,
+        0x43A9, 0x03A9, 0xC2E9, 0x82E9, 0xD8A9, 0x98A9, 0x59E9, 0x19E9,
+        0x6420, 0x2420, 0xE560, 0xA560, 0xFF20, 0xBF20, 0x7E60, 0x3E60,
+        0x058D, 0x458D, 0x84CD, 0xC4CD, 0x9E8D, 0xDE8D, 0x1FCD, 0x5FCD,
+        0x2204, 0x6204, 0xA344, 0xE344, 0xB904, 0xF904, 0x3844, 0x7844,
+        0xDBE1, 0x9BE1, 0x5AA1, 0x1AA1, 0x40E1, 0x00E1, 0xC1A1, 0x81A1,
+        0xFC68, 0xBC68, 0x7D28, 0x3D28, 0x6768, 0x2768, 0xE628, 0xA628,
+        0x9DC5, 0xDDC5, 0x1C85, 0x5C85, 0x06C5, 0x46C5, 0x8785, 0xC785,
+        0xBA4C, 0xFA4C, 0x3B0C, 0x7B0C, 0x214C, 0x614C, 0xA00C, 0xE00C,
+        0xEAB9, 0xAAB9, 0x6BF9, 0x2BF9, 0x71B9, 0x31B9, 0xF0F9, 0xB0F9,
+        0xCD30, 0x8D30, 0x4C70, 0x0C70, 0x5630, 0x1630, 0xD770, 0x9770,
+        0xAC9D, 0xEC9D, 0x2DDD, 0x6DDD, 0x379D, 0x779D, 0xB6DD, 0xF6DD,
+        0x8B14, 0xCB14, 0x0A54, 0x4A54, 0x1014, 0x5014, 0x9154, 0xD154,
+        0x72F1, 0x32F1, 0xF3B1, 0xB3B1, 0xE9F1, 0xA9F1, 0x68B1, 0x28B1,
+        0x5578, 0x1578, 0xD438, 0x9438, 0xCE78, 0x8E78, 0x4F38, 0x0F38,
+        0x34D5, 0x74D5, 0xB595, 0xF595, 0xAFD5, 0xEFD5, 0x2E95, 0x6E95,
+        0x135C, 0x535C, 0x921C, 0xD21C, 0x885C, 0xC85C, 0x091C, 0x491C
+    },
+#if (CRC16_SLICE > 4)
+    {   /* byte 4 from the end */
+        0x0000, 0x4204, 0xD581, 0x9785, 0x2A5A, 0x685E, 0xFFDB, 0xBDDF,
+        0xDCBD, 0x9EB9, 0x093C, 0x4B38, 0xF6E7, 0xB4E3, 0x2366, 0x6162,
+        0x0332, 0x4136, 0xD6B3, 0x94B7, 0x2968, 0x6B6C, 0xFCE9, 0xBEED,
+        0xDF8F, 0x9D8B, 0x0A0E, 0x480A, 0xF5D5, 0xB7D1, 0x2054, 0x6250,
+        0x50C1, 0x12C5, 0x8540, 0xC744, 0x7A9B, 0x389F, 0xAF1A, 0xED1E,
+        0x8C7C, 0xCE78, 0x59FD, 0x1BF9, 0xA626, 0xE422, 0x73A7, 0x31A3,
+        0x53F3, 0x11F7, 0x8672, 0xC476, 0x79A9, 0x3BAD, 0xAC28, 0xEE2C,
+        0x8F4E, 0xCD4A, 0x5ACF, 0x18CB, 0xA514, 0xE710, 0x7095, 0x3291,
+        0x28CB, 0x6ACF, 0xFD4A, 0xBF4E, 0x0291, 0x4095, 0xD710, 0x9514,
+        0xF476, 0xB672, 0x21F7, 0x63F3, 0xDE2C, 0x9C28, 0x0BAD, 0x49A9,
+        0x2BF9, 0x69FD, 0xFE78, 0xBC7C, 0x01A3, 0x43A7, 0xD422, 0x9626,
+        0xF744, 0xB540, 0x22C5, 0x60C1, 0xDD1E, 0x9F1A, 0x089F, 0x4A9B,
+        0x780A, 0x3A0E, 0xAD8B, 0xEF8F, 0x5250, 0x1054, 0x87D1, 0xC5D5,
+        0xA4B7, 0xE6B3, 0x7136, 0x3332, 0x8EED, 0xCCE9, 0x5B6C, 0x1968,
+        0x7B38, 0x393C, 0xAEB9, 0xECBD, 0x5162, 0x1366, 0x84E3, 0xC6E7,
+        0xA785, 0xE581, 0x7204, 0x3000, 0x8DDF, 0xCFDB, 0x585E, 0x1A5A,
+        0xD99F, 0x9B9B, 0x0C1E, 0x4E1A, 0xF3C5, 0xB1C1, 0x2644, 0x6440,
+        0x0522, 0x4726, 0xD0A3, 0x92A7, 0x2F78, 0x6D7C, 0xFAF9, 0xB8FD,
+        0xDAAD, 0x98A9, 0x0F2C, 0x4D28, 0xF0F7, 0xB2F3, 0x2576, 0x6772,
+        0x0610, 0x4414, 0xD391, 0x9195, 0x2C4A, 0x6E4E, 0xF9CB, 0xBBCF,
+        0x895E, 0xCB5A, 0x5CDF, 0x1EDB, 0xA304, 0xE100, 0x7685, 0x3481,
+        0x55E3, 0x17E7, 0x8062, 0xC266, 0x7FB9, 0x3DBD, 0xAA38, 0xE83C,
+        0x8A6C, 0xC868, 0x5FED, 0x1DE9, 0xA036, 0xE232, 0x75B7, 0x37B3,
+        0x56D1, 0x14D5, 0x8350, 0xC154, 0x7C8B, 0x3E8F, 0xA90A, 0xEB0E,
+        0xF154, 0xB350, 0x24D5, 0x66D1, 0xDB0E, 0x990A, 0x0E8F, 0x4C8B,
+        0x2DE9, 0x6FED, 0xF868, 0xBA6C, 0x07B3, 0x45B7, 0xD232, 0x9036,
+        0xF266, 0xB062, 0x27E7, 0x65E3, 0xD83C, 0x9A38, 0x0DBD, 0x4FB9,
+        0x2EDB, 0x6CDF, 0xFB5A, 0xB95E, 0x0481, 0x4685, 0xD100, 0x9304,
+        0xA195, 0xE391, 0x7414, 0x3610, 0x8BCF, 0xC9CB, 0x5E4E, 0x1C4A,
+        0x7D28, 0x3F2C, 0xA8A9, 0xEAAD, 0x5772, 0x1576, 0x82F3, 0xC0F7,
+        0xA2A7, 0xE0A3, 0x7726, 0x3522, 0x88FD, 0xCAF9, 0x5D7C, 0x1F78,
+        0x7E1A, 0x3C1E, 0xAB9B, 0xE99F, 0x5440, 0x1644, 0x81C1, 0xC3C5
+    },
+    {   /* byte 5 from the end */
+        0x0000, 0x6516, 0x0020, 0x6536, 0xD458, 0xB14E, 0xD478, 0xB16E,
+        0xA1E1, 0xC4F7, 0xA1C1, 0xC4D7, 0x75B9, 0x10AF, 0x7599, 0x108F,
+        0x009B, 0x658D, 0x00BB, 0x65AD, 0xD4C3, 0xB1D5, 0xD4E3, 0xB1F5,
+        0xA17A, 0xC46C, 0xA15A, 0xC44C, 0x7522, 0x1034, 0x7502, 0x1014,
+        0x9385, 0xF693, 0x93A5, 0xF6B3, 0x47DD, 0x22CB, 0x47FD, 0x22EB,
+        0x3264, 0x5772, 0x3244, 0x5752, 0xE63C, 0x832A, 0xE61C, 0x830A,
+        0x931E, 0xF608, 0x933E, 0xF628, 0x4746, 0x2250, 0x4766, 0x2270,
+        0x32FF, 0x57E9, 0x32DF, 0x57C9, 0xE6A7, 0x83B1, 0xE687, 0x8391,
+        0x664A, 0x035C, 0x666A, 0x037C, 0xB212, 0xD704, 0xB232, 0xD724,
+        0xC7AB, 0xA2BD, 0xC78B, 0xA29D, 0x13F3, 0x76E5, 0x13D3, 0x76C5,
+        0x66D1, 0x03C7, 0x66F1, 0x03E7, 0xB289, 0xD79F, 0xB2A9, 0xD7BF,
+        0xC730, 0xA226, 0xC710, 0xA206, 0x1368, 0x767E, 0x1348, 0x765E,
+        0xF5CF, 0x90D9, 0xF5EF, 0x90F9, 0x2197, 0x4481, 0x21B7, 0x44A1,
+        0x542E, 0x3138, 0x540E, 0x3118, 0x8076, 0xE560, 0x8056, 0xE540,
+        0xF554, 0x9042, 0xF574, 0x9062, 0x210C, 0x441A, 0x212C, 0x443A,
+        0x54B5, 0x31A3, 0x5495, 0x3183, 0x80ED, 0xE5FB, 0x80CD, 0xE5DB,
+        0xD44C, 0xB15A, 0xD46C, 0xB17A, 0x0014, 0x6502, 0x0034, 0x6522,
+        0x75AD, 0x10BB, 0x758D, 0x109B, 0xA1F5, 0xC4E3, 0xA1D5, 0xC4C3,
+        0xD4D7, 0xB1C1, 0xD4F7, 0xB1E1, 0x008F, 0x6599, 0x00AF, 0x65B9,
+        0x7536, 0x1020, 0x7516, 0x1000, 0xA16E, 0xC478, 0xA14E, 0xC458,
+        0x47C9, 0x22DF, 0x47E9, 0x22FF, 0x9391, 0xF687, 0x93B1, 0xF6A7,
+        0xE628, 0x833E, 0xE608, 0x831E, 0x3270, 0x5766, 0x3250, 0x5746,
+        0x4752, 0x2244, 0x4772, 0x2264, 0x930A, 0xF61C, 0x932A, 0xF63C,
+        0xE6B3, 0x83A5, 0xE693, 0x8385, 0x32EB, 0x57FD, 0x32CB, 0x57DD,
+        0xB206, 0xD710, 0xB226, 0xD730, 0x665E, 0x0348, 0x667E, 0x0368,
+        0x13E7, 0x76F1, 0x13C7, 0x76D1, 0xC7BF, 0xA2A9, 0xC79F, 0xA289,
+        0xB29D, 0xD78B, 0xB2BD, 0xD7AB, 0x66C5, 0x03D3, 0x66E5, 0x03F3,
+        0x137C, 0x766A, 0x135C, 0x764A, 0xC724, 0xA232, 0xC704, 0xA212,
+        0x2183, 0x4495, 0x21A3, 0x44B5, 0xF5DB, 0x90CD, 0xF5FB, 0x90ED,
+        0x8062, 0xE574, 0x8042, 0xE554, 0x543A, 0x312C, 0x541A, 0x310C,
+        0x2118, 0x440E, 0x2138, 0x442E, 0xF540, 0x9056, 0xF560, 0x9076,
+        0x80F9, 0xE5EF, 0x80D9, 0xE5CF, 0x54A1, 0x31B7, 0x5481, 0x3197
+    },
+    {   /* byte 6 from the end */
+        0x0000, 0x22AB, 0x2000, 0x02AB, 0xC8A9, 0xEA02, 0xE8A9, 0xCA02,
+        0x5583, 0x7728, 0x7583, 0x5728, 0x9D2A, 0xBF81, 0xBD2A, 0x9F81,
+        0x9B00, 0xB9AB, 0xBB00, 0x99AB, 0x53A9, 0x7102, 0x73A9, 0x5102,
+        0xCE83, 0xEC28, 0xEE83, 0xCC28, 0x062A, 0x2481, 0x262A, 0x0481,
+        0x2312, 0x01B9, 0x0312, 0x21B9, 0xEBBB, 0xC910, 0xCBBB, 0xE910,
+        0x7691, 0x543A, 0x5691, 0x743A, 0xBE38, 0x9C93, 0x9E38, 0xBC93,
+        0xB812, 0x9AB9, 0x9812, 0xBAB9, 0x70BB, 0x5210, 0x50BB, 0x7210,
+        0xED91, 0xCF3A, 0xCD91, 0xEF3A, 0x2538, 0x0793, 0x0538, 0x2793,
+        0x4C30, 0x6E9B, 0x6C30, 0x4E9B, 0x8499, 0xA632, 0xA499, 0x8632,
+        0x19B3, 0x3B18, 0x39B3, 0x1B18, 0xD11A, 0xF3B1, 0xF11A, 0xD3B1,
+        0xD730, 0xF59B, 0xF730, 0xD59B, 0x1F99, 0x3D32, 0x3F99, 0x1D32,
+        0x82B3, 0xA018, 0xA2B3, 0x8018, 0x4A1A, 0x68B1, 0x6A1A, 0x48B1,
+        0x6F22, 0x4D89, 0x4F22, 0x6D89, 0xA78B, 0x8520, 0x878B, 0xA520,
+        0x3AA1, 0x180A, 0x1AA1, 0x380A, 0xF208, 0xD0A3, 0xD208, 0xF0A3,
+        0xF422, 0xD689, 0xD422, 0xF689, 0x3C8B, 0x1E20, 0x1C8B, 0x3E20,
+        0xA1A1, 0x830A, 0x81A1, 0xA30A, 0x6908, 0x4BA3, 0x4908, 0x6BA3,
+        0xDCA9, 0xFE02, 0xFCA9, 0xDE02, 0x1400, 0x36AB, 0x3400, 0x16AB,
+        0x892A, 0xAB81, 0xA92A, 0x8B81, 0x4183, 0x6328, 0x6183, 0x4328,
+        0x47A9, 0x6502, 0x67A9, 0x4502, 0x8F00, 0xADAB, 0xAF00, 0x8DAB,
+        0x122A, 0x3081, 0x322A, 0x1081, 0xDA83, 0xF828, 0xFA83, 0xD828,
+        0xFFBB, 0xDD10, 0xDFBB, 0xFD10, 0x3712, 0x15B9, 0x1712, 0x35B9,
+        0xAA38, 0x8893, 0x8A38, 0xA893, 0x6291, 0x403A, 0x4291, 0x603A,
+        0x64BB, 0x4610, 0x44BB, 0x6610, 0xAC12, 0x8EB9, 0x8C12, 0xAEB9,
+        0x3138, 0x1393, 0x1138, 0x3393, 0xF991, 0xDB3A, 0xD991, 0xFB3A,
+        0x9099, 0xB232, 0xB099, 0x9232, 0x5830, 0x7A9B, 0x7830, 0x5A9B,
+        0xC51A, 0xE7B1, 0xE51A, 0xC7B1, 0x0DB3, 0x2F18, 0x2DB3, 0x0F18,
+        0x0B99, 0x2932, 0x2B99, 0x0932, 0xC330, 0xE19B, 0xE330, 0xC19B,
+        0x5E1A, 0x7CB1, 0x7E1A, 0x5CB1, 0x96B3, 0xB418, 0xB6B3, 0x9418,
+        0xB38B, 0x9120, 0x938B, 0xB120, 0x7B22, 0x5989, 0x5B22, 0x7989,
+        0xE608, 0xC4A3, 0xC608, 0xE4A3, 0x2EA1, 0x0C0A, 0x0EA1, 0x2C0A,
+        0x288B, 0x0A20, 0x088B, 0x2A20, 0xE022, 0xC289, 0xC022, 0xE289,
+        0x7D08, 0x5FA3, 0x5D08, 0x7FA3, 0xB5A1, 0x970A, 0x95A1, 0xB70A
+    },
+    {   /* byte 7 from the end */
+        0x0000, 0xA910, 0x2102, 0x8812, 0xE344, 0x4A54, 0xC246, 0x6B56,
+        0x8628, 0x2F38, 0xA72A, 0x0E3A, 0x656C, 0xCC7C, 0x446E, 0xED7E,
+        0x2A5A, 0x834A, 0x0B58, 0xA248, 0xC91E, 0x600E, 0xE81C, 0x410C,
+        0xAC72, 0x0562, 0x8D70, 0x2460, 0x4F36, 0xE626, 0x6E34, 0xC724,
+        0x0199, 0xA889, 0x209B, 0x898B, 0xE2DD, 0x4BCD, 0xC3DF, 0x6ACF,
+        0x87B1, 0x2EA1, 0xA6B3, 0x0FA3, 0x64F5, 0xCDE5, 0x45F7, 0xECE7,
+        0x2BC3, 0x82D3, 0x0AC1, 0xA3D1, 0xC887, 0x6197, 0xE985, 0x4095,
+        0xADEB, 0x04FB, 0x8CE9, 0x25F9, 0x4EAF, 0xE7BF, 0x6FAD, 0xC6BD,
+        0xB868, 0x1178, 0x996A, 0x307A, 0x5B2C, 0xF23C, 0x7A2E, 0xD33E,
+        0x3E40, 0x9750, 0x1F42, 0xB652, 0xDD04, 0x7414, 0xFC06, 0x5516,
+        0x9232, 0x3B22, 0xB330, 0x1A20, 0x7176, 0xD866, 0x5074, 0xF964,
+        0x141A, 0xBD0A, 0x3518, 0x9C08, 0xF75E, 0x5E4E, 0xD65C, 0x7F4C,
+        0xB9F1, 0x10E1, 0x98F3, 0x31E3, 0x5AB5, 0xF3A5, 0x7BB7, 0xD2A7,
+        0x3FD9, 0x96C9, 0x1EDB, 0xB7CB, 0xDC9D, 0x758D, 0xFD9F, 0x548F,
+        0x93AB, 0x3ABB, 0xB2A9, 0x1BB9, 0x70EF, 0xD9FF, 0x51ED, 0xF8FD,
+        0x1583, 0xBC93, 0x3481, 0x9D91, 0xF6C7, 0x5FD7, 0xD7C5, 0x7ED5,
+        0xB5E1, 0x1CF1, 0x94E3, 0x3DF3, 0x56A5, 0xFFB5, 0x77A7, 0xDEB7,
+        0x33C9, 0x9AD9, 0x12CB, 0xBBDB, 0xD08D, 0x799D, 0xF18F, 0x589F,
+        0x9FBB, 0x36AB, 0xBEB9, 0x17A9, 0x7CFF, 0xD5EF, 0x5DFD, 0xF4ED,
+        0x1993, 0xB083, 0x3891, 0x9181, 0xFAD7, 0x53C7, 0xDBD5, 0x72C5,
+        0xB478, 0x1D68, 0x957A, 0x3C6A, 0x573C, 0xFE2C, 0x763E, 0xDF2E,
+        0x3250, 0x9B40, 0x1352, 0xBA42, 0xD114, 0x7804, 0xF016, 0x5906,
+        0x9E22, 0x3732, 0xBF20, 0x1630, 0x7D66, 0xD476, 0x5C64, 0xF574,
+        0x180A, 0xB11A, 0x3908, 0x9018, 0xFB4E, 0x525E, 0xDA4C, 0x735C,
+        0x0D89, 0xA499, 0x2C8B, 0x859B, 0xEECD, 0x47DD, 0xCFCF, 0x66DF,
+        0x8BA1, 0x22B1, 0xAAA3, 0x03B3, 0x68E5, 0xC1F5, 0x49E7, 0xE0F7,
+        0x27D3, 0x8EC3, 0x06D1, 0xAFC1, 0xC497, 0x6D87, 0xE595, 0x4C85,
+        0xA1FB, 0x08EB, 0x80F9, 0x29E9, 0x42BF, 0xEBAF, 0x63BD, 0xCAAD,
+        0x0C10, 0xA500, 0x2D12, 0x8402, 0xEF54, 0x4644, 0xCE56, 0x6746,
+        0x8A38, 0x2328, 0xAB3A, 0x022A, 0x697C, 0xC06C, 0x487E, 0xE16E,
+        0x264A, 0x8F5A, 0x0748, 0xAE58, 0xC50E, 0x6C1E, 0xE40C, 0x4D1C,
+        0xA062, 0x0972, 0x8160, 0x2870, 0x4326, 0xEA36, 0x6224, 0xCB34
+    }
+#endif
+};
+
+#if (CRC16_HW_CCM == 0)
+/* XMODEM CRC table, polynomial 0x1021 MSB first */
+static const uint16_t s_xmodem[256] = {
+     0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+     0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+     0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+     0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+     0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+     0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+     0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+     0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+     0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+     0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+     0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+     0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+     0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+     0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+     0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+     0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+     0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+     0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+     0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+     0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+     0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+     0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+     0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+     0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+     0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+     0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+     0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+     0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+     0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+     0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+     0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+     0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+#endif
+
+//*****************************************************************************
+// Enable the CRC module on the target. Call once at startup before any
+// XMODEM transfer.
+//*****************************************************************************
+
+void CRC16Init(void)
+{
+#if (CRC16_HW_CCM > 0)
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_CCM0);
+
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_CCM0))
+        ;
+#endif
+}
+
+//*****************************************************************************
+// Sum one byte into the frame CRC.
+//*****************************************************************************
+
 uint16_t CRC16Update(uint16_t crc, uint8_t d)
 {
     return s_table[d ^ (uint8_t)(crc >> (16 - 8))] ^ (crc << 8);
 }
+
+//*****************************************************************************
+// Sum a block of bytes into the frame CRC, the same as CRC16Update() for
+// each byte in turn. The CRC goes into the first two bytes of a slice and
+// the slice is summed from zero.
+//*****************************************************************************
+
+uint16_t CRC16Block(uint16_t crc, const void* buf, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+
+#if (CRC16_SLICE > 4)
+    while (len >= 8)
+    {
+        crc = s_slice[6][p[0] ^ (uint8_t)(crc >> 8)] ^
+              s_slice[5][p[1] ^ (uint8_t)crc] ^
+              s_slice[4][p[2]] ^ s_slice[3][p[3]] ^
+              s_slice[2][p[4]] ^ s_slice[1][p[5]] ^
+              s_slice[0][p[6]] ^ s_table[p[7]];
+        p   += 8;
+        len -= 8;
+    }
+#endif
+
+    while (len >= 4)
+    {
+        crc = s_slice[2][p[0] ^ (uint8_t)(crc >> 8)] ^
+              s_slice[1][p[1] ^ (uint8_t)crc] ^
+              s_slice[0][p[2]] ^ s_table[p[3]];
+        p   += 4;
+        len -= 4;
+    }
+
+    while (len--)
+        crc = CRC16Update(crc, *p++);
+
+    return crc;
+}
+
+//*****************************************************************************
+// Sum a block of bytes into an XMODEM CRC. On the target this is done by
+// the CRC module a byte at a time. The module holds the CRC between bytes,
+// so it must only be used from one task at a time. The XMODEM transfers
+// are its only users and run one at a time under the xmodem.c gate, so no
+// lock is taken here and interrupts are left on.
+//*****************************************************************************
+
+uint16_t CRC16XmodemBlock(uint16_t crc, const void* buf, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+
+#if (CRC16_HW_CCM > 0)
+    if (!len)
+        return crc;
+
+    CRCConfigSet(CCM0_BASE, CRC_CFG_INIT_SEED | CRC_CFG_TYPE_P1021 | CRC_CFG_SIZE_8BIT);
+    CRCSeedSet(CCM0_BASE, crc);
+
+    /* In 8-bit mode only the low byte of each write is summed */
+    while (len--)
+        CRCDataWrite(CCM0_BASE, *p++);
+
+    crc = (uint16_t)CRCResultRead(CCM0_BASE, false);
+
+    return crc;
+#else
+    while (len--)
+        crc = s_xmodem[(uint8_t)(crc >> 8) ^ *p++] ^ (crc << 8);
+
+    return crc;
+#endif
+}
+
+/* End-Of-File */
@@ -13,6 +13,34 @@
 #ifndef _CRC16_H_
 #define _CRC16_H_
 
+#include <stdint.h>
+#include <stddef.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Frame CRC bytes summed at a time by CRC16Block(), 8 or 4. Four takes a
+ * quarter of the table space.
+ */
+#ifndef CRC16_SLICE
+#define CRC16_SLICE             8
+#endif
+
+/* Set to sum the XMODEM CRC with the TM4C129 CRC module. It is set for the
+ * target build, the host tools sum it with a table.
+ */
+#ifndef CRC16_HW_CCM
+#if defined(__TI_COMPILER_VERSION__)
+#define CRC16_HW_CCM            1
+#else
+#define CRC16_HW_CCM            0
+#endif
+#endif
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void CRC16Init(void);
 uint16_t CRC16Update(uint16_t crc, uint8_t d);
+uint16_t CRC16Block(uint16_t crc, const void* buf, size_t len);
+uint16_t CRC16XmodemBlock(uint16_t crc, const void* buf, size_t len);
 
 #endif  /* _CRC16_H_ */
@@ -0,0 +1,214 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Cue list sequencer. The cue list is an ordered list of steps to locate
+ * to a cue point, play for a time, stop or dwell for a time. The locate
+ * task runs the steps one after another, so a run of segments plays back
+ * to back without the operator starting each locate from the remote.
+ *
+ * The sequencer only keeps the list and the step timing. The caller
+ * carries out each step and asks for the next one once the step is done:
+ * a locate when the tape arrives at the cue point, a stop or untimed play
+ * at once and a timed play or dwell at its deadline. A timed step is timed
+ * from when its command is sent, so the transport command lag delays the
+ * start and the end of a play segment alike. The next step can be looked
+ * at while a step runs so the caller can plan it ahead. A play step with
+ * no time leaves the tape playing and ends the sequence. The module has no
+ * RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "CueSeq.h"
+
+/* Static Function Prototypes */
+static bool IsTimed(const SEQ_STEP* step);
+
+//*****************************************************************************
+// Clear the cue list.
+//*****************************************************************************
+
+void CueSeq_init(CUE_SEQ* seq)
+{
+    memset(seq, 0, sizeof(CUE_SEQ));
+}
+
+//*****************************************************************************
+// Store a step in the cue list. A step may replace one in the list or be
+// added at the end. Storing STC_SEQ_END ends the list at that step. The
+// list can't be changed while the sequence is running.
+//*****************************************************************************
+
+bool CueSeq_set(CUE_SEQ* seq, size_t index, uint32_t op, uint32_t param,
+                uint32_t flags)
+{
+    SEQ_STEP* step;
+
+    if (seq->running || (index > seq->count))
+        return false;
+
+    switch(op)
+    {
+    case STC_SEQ_END:
+        seq->count = index;
+        return true;
+
+    case STC_SEQ_LOCATE:
+        if (param >= STC_MAX_CUE_POINTS)
+            return false;
+        break;
+
+    case STC_SEQ_PLAY:
+    case STC_SEQ_STOP:
+    case STC_SEQ_DWELL:
+        break;
+
+    default:
+        return false;
+    }
+
+    if (index >= SEQ_MAX_STEPS)
+        return false;
+
+    step = &seq->step[index];
+
+    step->op    = op;
+    step->param = param;
+    step->flags = flags;
+
+    if (index == seq->count)
+        seq->count++;
+
+    return true;
+}
+
+//*****************************************************************************
+// Return a step from the cue list.
+//*****************************************************************************
+
+bool CueSeq_get(CUE_SEQ* seq, size_t index, SEQ_STEP* step)
+{
+    if (index >= seq->count)
+        return false;
+
+    *step = seq->step[index];
+
+    return true;
+}
+
+//*****************************************************************************
+// Start the sequence at the step given. The first step is returned by the
+// next call to CueSeq_next().
+//*****************************************************************************
+
+bool CueSeq_start(CUE_SEQ* seq, size_t first, uint32_t now)
+{
+    if (first >= seq->count)
+        return false;
+
+    seq->index     = first;
+    seq->current   = first;
+    seq->running   = true;
+    seq->startTime = now;
+    seq->stepTime  = now;
+    seq->steps     = 0;
+
+    return true;
+}
+
+//*****************************************************************************
+// Move on to the next step. The step timing starts now. Returns NULL and
+// ends the sequence once the cue list has run out.
+//*****************************************************************************
+
+const SEQ_STEP* CueSeq_next(CUE_SEQ* seq, uint32_t now)
+{
+    const SEQ_STEP* step;
+
+    if (!seq->running)
+        return NULL;
+
+    if (seq->index >= seq->count)
+    {
+        seq->running = false;
+        return NULL;
+    }
+
+    seq->current  = seq->index++;
+    seq->stepTime = now;
+    seq->steps++;
+
+    step = &seq->step[seq->current];
+
+    /* Play with no time limit is the last step run */
+    if ((step->op == STC_SEQ_PLAY) && !step->param)
+        seq->index = seq->count;
+
+    return step;
+}
+
+//*****************************************************************************
+// Return the step that runs after the current one, or NULL if the current
+// step is the last. The caller uses this to plan the next step while the
+// current one runs.
+//*****************************************************************************
+
+const SEQ_STEP* CueSeq_peek(CUE_SEQ* seq)
+{
+    if (!seq->running || (seq->index >= seq->count))
+        return NULL;
+
+    return &seq->step[seq->index];
+}
+
+//*****************************************************************************
+// Return the ms left until the next step must be started, or zero if it
+// is due now. Only timed play and dwell steps have a deadline.
+//*****************************************************************************
+
+uint32_t CueSeq_deadline(CUE_SEQ* seq, uint32_t now)
+{
+    const SEQ_STEP* step = &seq->step[seq->current];
+    uint32_t elapsed;
+
+    if (!seq->running || !IsTimed(step))
+        return 0;
+
+    elapsed = now - seq->stepTime;
+
+    return (elapsed >= step->param) ? 0 : (step->param - elapsed);
+}
+
+//*****************************************************************************
+// End the sequence. The cue list is kept.
+//*****************************************************************************
+
+void CueSeq_stop(CUE_SEQ* seq)
+{
+    seq->running = false;
+}
+
+/* True if the step runs for a time */
+static bool IsTimed(const SEQ_STEP* step)
+{
+    if (step->op == STC_SEQ_DWELL)
+        return true;
+
+    return (step->op == STC_SEQ_PLAY) && (step->param != 0);
+}
+
+/* End-Of-File */
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _CUESEQ_H_
+#define _CUESEQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Steps held in the cue list. The step op codes and flags are the
+ * STC_SEQ_xxx values from STC1200TCP.h.
+ */
+#define SEQ_MAX_STEPS           STC_SEQ_MAX_STEPS
+
+/*** CUE SEQUENCER DATA ****************************************************/
+
+typedef struct _SEQ_STEP {
+    uint32_t    op;             /* STC_SEQ_xxx step op code         */
+    uint32_t    param;          /* cue point index or ms            */
+    uint32_t    flags;          /* STC_SEQ_F_xxx step flags         */
+} SEQ_STEP;
+
+typedef struct _CUE_SEQ {
+    SEQ_STEP    step[SEQ_MAX_STEPS];
+    size_t      count;          /* steps in the cue list            */
+    size_t      index;          /* next step to run                 */
+    size_t      current;        /* step running                     */
+    bool        running;        /* sequence in progress             */
+    uint32_t    startTime;      /* ms the sequence started          */
+    uint32_t    stepTime;       /* ms the current step started      */
+    uint32_t    steps;          /* steps run since the start        */
+} CUE_SEQ;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void CueSeq_init(CUE_SEQ* seq);
+
+bool CueSeq_set(CUE_SEQ* seq, size_t index, uint32_t op, uint32_t param,
+                uint32_t flags);
+
+bool CueSeq_get(CUE_SEQ* seq, size_t index, SEQ_STEP* step);
+
+bool CueSeq_start(CUE_SEQ* seq, size_t first, uint32_t now);
+
+const SEQ_STEP* CueSeq_next(CUE_SEQ* seq, uint32_t now);
+
+const SEQ_STEP* CueSeq_peek(CUE_SEQ* seq);
+
+uint32_t CueSeq_deadline(CUE_SEQ* seq, uint32_t now);
+
+void CueSeq_stop(CUE_SEQ* seq);
+
+#endif  /* _CUESEQ_H_ */
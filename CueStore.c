@@ -0,0 +1,441 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Named cue store. This holds the named cues for a reel, grouped in banks
+ * so each song on the reel can have its own set. A cue is known by its
+ * handle, which stays the same while the cue is in the store.
+ *
+ * The handles are kept in an index sorted by bank and then tape position,
+ * so the cues of a bank are together in position order. The next or
+ * previous cue from a tape position, the cue count of a bank and the nth
+ * cue of a bank are all found by a binary search of the index. Adding or
+ * removing a cue moves the index entries after it along by one. Finding a
+ * cue by name is a scan of the bank.
+ *
+ * The ten locate memories and the system cue points stay in the cue point
+ * table. A named cue is recalled into a locate memory to locate to it.
+ * The module has no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "CueStore.h"
+
+/* Static Function Prototypes */
+static uint64_t Key(uint32_t bank, int32_t ipos);
+static uint64_t EntryKey(CUE_STORE* cs, uint16_t handle);
+static size_t LowerBound(CUE_STORE* cs, uint64_t key);
+static size_t UpperBound(CUE_STORE* cs, uint64_t key);
+static void Insert(CUE_STORE* cs, uint16_t handle);
+static void Remove(CUE_STORE* cs, uint16_t handle);
+static int FreeHandle(CUE_STORE* cs);
+static bool IsUsed(CUE_STORE* cs, int handle);
+static void CopyName(char* dst, const char* src);
+
+//*****************************************************************************
+// Empty the cue store.
+//*****************************************************************************
+
+void CueStore_init(CUE_STORE* cs)
+{
+    memset(cs->used, 0, sizeof(cs->used));
+
+    cs->count = 0;
+}
+
+//*****************************************************************************
+// Add a cue to a bank. Returns the handle of the new cue, or CUE_NONE if
+// the store is full.
+//*****************************************************************************
+
+int CueStore_add(CUE_STORE* cs, uint32_t bank, int32_t ipos, uint32_t flags,
+                 const char* name)
+{
+    CUE_ENTRY* cue;
+    int handle;
+
+    if ((bank > 255) || ((handle = FreeHandle(cs)) == CUE_NONE))
+        return CUE_NONE;
+
+    cue = &cs->entry[handle];
+
+    cue->ipos     = ipos;
+    cue->bank     = (uint8_t)bank;
+    cue->flags    = (uint8_t)flags;
+    cue->reserved = 0;
+
+    CopyName(cue->name, name);
+
+    cs->used[handle / 32] |= (1U << (handle % 32));
+
+    Insert(cs, (uint16_t)handle);
+
+    return handle;
+}
+
+//*****************************************************************************
+// Store a cue under the handle given, as when loading the store from a
+// file. The handle must not be in use.
+//*****************************************************************************
+
+bool CueStore_put(CUE_STORE* cs, int handle, const CUE_ENTRY* cue)
+{
+    if ((handle < 0) || (handle >= CUE_STORE_MAX) || IsUsed(cs, handle))
+        return false;
+
+    cs->entry[handle] = *cue;
+    cs->entry[handle].name[CUE_NAME_LEN - 1] = '\0';
+
+    cs->used[handle / 32] |= (1U << (handle % 32));
+
+    Insert(cs, (uint16_t)handle);
+
+    return true;
+}
+
+//*****************************************************************************
+// Remove a cue from the store.
+//*****************************************************************************
+
+bool CueStore_remove(CUE_STORE* cs, int handle)
+{
+    if (!IsUsed(cs, handle))
+        return false;
+
+    Remove(cs, (uint16_t)handle);
+
+    cs->used[handle / 32] &= ~(1U << (handle % 32));
+
+    return true;
+}
+
+//*****************************************************************************
+// Remove all the cues of a bank. Returns the number of cues removed.
+//*****************************************************************************
+
+size_t CueStore_clearBank(CUE_STORE* cs, uint32_t bank)
+{
+    size_t lo = LowerBound(cs, Key(bank, INT32_MIN));
+    size_t hi = LowerBound(cs, Key(bank + 1, INT32_MIN));
+    size_t i;
+    uint16_t handle;
+
+    for (i=lo; i < hi; i++)
+    {
+        handle = cs->index[i];
+        cs->used[handle / 32] &= ~(1U << (handle % 32));
+    }
+
+    memmove(&cs->index[lo], &cs->index[hi], (cs->count - hi) * sizeof(uint16_t));
+
+    cs->count -= hi - lo;
+
+    return hi - lo;
+}
+
+//*****************************************************************************
+// Change the tape position of a cue.
+//*****************************************************************************
+
+bool CueStore_move(CUE_STORE* cs, int handle, int32_t ipos)
+{
+    if (!IsUsed(cs, handle))
+        return false;
+
+    Remove(cs, (uint16_t)handle);
+
+    cs->entry[handle].ipos = ipos;
+
+    Insert(cs, (uint16_t)handle);
+
+    return true;
+}
+
+//*****************************************************************************
+// Change the name of a cue.
+//*****************************************************************************
+
+bool CueStore_rename(CUE_STORE* cs, int handle, const char* name)
+{
+    if (!IsUsed(cs, handle))
+        return false;
+
+    CopyName(cs->entry[handle].name, name);
+
+    return true;
+}
+
+//*****************************************************************************
+// Return the cue for a handle, or NULL if the handle isn't in use.
+//*****************************************************************************
+
+const CUE_ENTRY* CueStore_get(CUE_STORE* cs, int handle)
+{
+    if (!IsUsed(cs, handle))
+        return NULL;
+
+    return &cs->entry[handle];
+}
+
+//*****************************************************************************
+// Return the first cue of the bank past the tape position given, or
+// CUE_NONE if there are none.
+//*****************************************************************************
+
+int CueStore_next(CUE_STORE* cs, uint32_t bank, int32_t ipos)
+{
+    size_t i = UpperBound(cs, Key(bank, ipos));
+
+    if ((i >= cs->count) || (cs->entry[cs->index[i]].bank != bank))
+        return CUE_NONE;
+
+    return cs->index[i];
+}
+
+//*****************************************************************************
+// Return the last cue of the bank before the tape position given, or
+// CUE_NONE if there are none.
+//*****************************************************************************
+
+int CueStore_prev(CUE_STORE* cs, uint32_t bank, int32_t ipos)
+{
+    size_t i = LowerBound(cs, Key(bank, ipos));
+
+    if ((i == 0) || (cs->entry[cs->index[i - 1]].bank != bank))
+        return CUE_NONE;
+
+    return cs->index[i - 1];
+}
+
+//*****************************************************************************
+// Return the cue of the bank nearest the tape position given, or CUE_NONE
+// if the bank is empty. A cue at the position counts as nearest.
+//*****************************************************************************
+
+int CueStore_nearest(CUE_STORE* cs, uint32_t bank, int32_t ipos)
+{
+    size_t i = LowerBound(cs, Key(bank, ipos));
+    int after = CUE_NONE;
+    int before = CUE_NONE;
+    int64_t da;
+    int64_t db;
+
+    if ((i < cs->count) && (cs->entry[cs->index[i]].bank == bank))
+        after = cs->index[i];
+
+    if ((i > 0) && (cs->entry[cs->index[i - 1]].bank == bank))
+        before = cs->index[i - 1];
+
+    if ((after == CUE_NONE) || (before == CUE_NONE))
+        return (after == CUE_NONE) ? before : after;
+
+    da = (int64_t)cs->entry[after].ipos - ipos;
+    db = (int64_t)ipos - cs->entry[before].ipos;
+
+    return (db < da) ? before : after;
+}
+
+//*****************************************************************************
+// Return the nth cue of the bank in tape position order, or CUE_NONE if
+// the bank has no more than n cues.
+//*****************************************************************************
+
+int CueStore_at(CUE_STORE* cs, uint32_t bank, size_t n)
+{
+    size_t i = LowerBound(cs, Key(bank, INT32_MIN)) + n;
+
+    if ((i >= cs->count) || (cs->entry[cs->index[i]].bank != bank))
+        return CUE_NONE;
+
+    return cs->index[i];
+}
+
+//*****************************************************************************
+// Return the number of cues in a bank.
+//*****************************************************************************
+
+size_t CueStore_count(CUE_STORE* cs, uint32_t bank)
+{
+    return LowerBound(cs, Key(bank + 1, INT32_MIN)) - LowerBound(cs, Key(bank, INT32_MIN));
+}
+
+//*****************************************************************************
+// Return the first cue of the bank in position order with the name given,
+// or CUE_NONE if there is none.
+//*****************************************************************************
+
+int CueStore_find(CUE_STORE* cs, uint32_t bank, const char* name)
+{
+    size_t i = LowerBound(cs, Key(bank, INT32_MIN));
+    size_t hi = LowerBound(cs, Key(bank + 1, INT32_MIN));
+
+    for ( ; i < hi; i++)
+    {
+        if (strncmp(cs->entry[cs->index[i]].name, name, CUE_NAME_LEN) == 0)
+            return cs->index[i];
+    }
+
+    return CUE_NONE;
+}
+
+//*****************************************************************************
+// Return the first handle in use from the handle given on, or CUE_NONE if
+// there are none. This walks the store in handle order to save it.
+//*****************************************************************************
+
+int CueStore_scan(CUE_STORE* cs, int handle)
+{
+    if (handle < 0)
+        handle = 0;
+
+    for ( ; handle < CUE_STORE_MAX; handle++)
+    {
+        /* Skip the words with no handles in use */
+        if (!(handle % 32) && !cs->used[handle / 32])
+        {
+            handle += 31;
+            continue;
+        }
+
+        if (cs->used[handle / 32] & (1U << (handle % 32)))
+            return handle;
+    }
+
+    return CUE_NONE;
+}
+
+/* Index sort key, bank then signed tape position */
+static uint64_t Key(uint32_t bank, int32_t ipos)
+{
+    return ((uint64_t)bank << 32) | ((uint32_t)ipos ^ 0x80000000U);
+}
+
+/* Index sort key of a cue */
+static uint64_t EntryKey(CUE_STORE* cs, uint16_t handle)
+{
+    return Key(cs->entry[handle].bank, cs->entry[handle].ipos);
+}
+
+/* First index entry with a key at or past the key given */
+static size_t LowerBound(CUE_STORE* cs, uint64_t key)
+{
+    size_t lo = 0;
+    size_t hi = cs->count;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2);
+
+        if (EntryKey(cs, cs->index[mid]) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* First index entry with a key past the key given */
+static size_t UpperBound(CUE_STORE* cs, uint64_t key)
+{
+    size_t lo = 0;
+    size_t hi = cs->count;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2);
+
+        if (EntryKey(cs, cs->index[mid]) <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* Add a handle to the index after any cues at the same position */
+static void Insert(CUE_STORE* cs, uint16_t handle)
+{
+    size_t i = UpperBound(cs, EntryKey(cs, handle));
+
+    memmove(&cs->index[i + 1], &cs->index[i], (cs->count - i) * sizeof(uint16_t));
+
+    cs->index[i] = handle;
+
+    cs->count++;
+}
+
+/* Take a handle out of the index */
+static void Remove(CUE_STORE* cs, uint16_t handle)
+{
+    size_t i = LowerBound(cs, EntryKey(cs, handle));
+
+    /* Other cues may be at the same position */
+    while ((i < cs->count) && (cs->index[i] != handle))
+        i++;
+
+    if (i >= cs->count)
+        return;
+
+    memmove(&cs->index[i], &cs->index[i + 1], (cs->count - i - 1) * sizeof(uint16_t));
+
+    cs->count--;
+}
+
+/* Lowest handle not in use, or CUE_NONE if the store is full */
+static int FreeHandle(CUE_STORE* cs)
+{
+    size_t w;
+    uint32_t bits;
+    int handle;
+
+    for (w=0; w < ((CUE_STORE_MAX + 31) / 32); w++)
+    {
+        if ((bits = ~cs->used[w]) == 0)
+            continue;
+
+        for (handle = (int)(w * 32); !(bits & 1); bits >>= 1)
+            handle++;
+
+        return (handle < CUE_STORE_MAX) ? handle : CUE_NONE;
+    }
+
+    return CUE_NONE;
+}
+
+/* True if the handle is a cue in the store */
+static bool IsUsed(CUE_STORE* cs, int handle)
+{
+    if ((handle < 0) || (handle >= CUE_STORE_MAX))
+        return false;
+
+    return (cs->used[handle / 32] & (1U << (handle % 32))) != 0;
+}
+
+/* Copy a cue name, cut short to fit */
+static void CopyName(char* dst, const char* src)
+{
+    memset(dst, 0, CUE_NAME_LEN);
+
+    if (src)
+        strncpy(dst, src, CUE_NAME_LEN - 1);
+}
+
+/* End-Of-File */
@@ -0,0 +1,107 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _CUESTORE_H_
+#define _CUESTORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Named cues held for the reel loaded. Each takes a CUE_ENTRY and two
+ * bytes of index, about 53K in all. The host tools build with more.
+ */
+#ifndef CUE_STORE_MAX
+#define CUE_STORE_MAX           2048
+#endif
+
+#if (CUE_STORE_MAX > 65535)
+#error "CUE_STORE_MAX must fit the 16-bit cue index"
+#endif
+
+#define CUE_NAME_LEN            STC_CUE_NAME_LEN
+
+/* Returned for no cue found */
+#define CUE_NONE                (-1)
+
+/* Cue store file header. The file holds the header and then a
+ * CUE_FILE_REC for each cue in the store.
+ */
+#define CUE_FILE_MAGIC          0x53455543      /* 'CUES' little endian */
+#define CUE_FILE_VERSION        1
+
+/*** CUE STORE DATA ********************************************************/
+
+typedef struct _CUE_ENTRY {
+    int32_t     ipos;               /* tape position of the cue     */
+    uint8_t     bank;               /* cue set the cue belongs to   */
+    uint8_t     flags;              /* CF_xxx cue flags             */
+    uint16_t    reserved;
+    char        name[CUE_NAME_LEN]; /* zero terminated cue name     */
+} CUE_ENTRY;
+
+typedef struct _CUE_FILE_HDR {
+    uint32_t    magic;              /* CUE_FILE_MAGIC               */
+    uint32_t    version;            /* CUE_FILE_VERSION             */
+    uint32_t    count;              /* cue records that follow      */
+    uint32_t    reserved;
+} CUE_FILE_HDR;
+
+typedef struct _CUE_FILE_REC {
+    uint16_t    handle;             /* cue handle when saved        */
+    uint16_t    reserved;
+    CUE_ENTRY   cue;
+} CUE_FILE_REC;
+
+typedef struct _CUE_STORE {
+    CUE_ENTRY   entry[CUE_STORE_MAX];   /* cue for each handle      */
+    uint16_t    index[CUE_STORE_MAX];   /* handles by bank, position */
+    uint32_t    used[(CUE_STORE_MAX + 31) / 32]; /* handles in use  */
+    size_t      count;                  /* cues in the store        */
+} CUE_STORE;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void CueStore_init(CUE_STORE* cs);
+
+int CueStore_add(CUE_STORE* cs, uint32_t bank, int32_t ipos, uint32_t flags,
+                 const char* name);
+
+bool CueStore_put(CUE_STORE* cs, int handle, const CUE_ENTRY* cue);
+
+bool CueStore_remove(CUE_STORE* cs, int handle);
+
+size_t CueStore_clearBank(CUE_STORE* cs, uint32_t bank);
+
+bool CueStore_move(CUE_STORE* cs, int handle, int32_t ipos);
+
+bool CueStore_rename(CUE_STORE* cs, int handle, const char* name);
+
+const CUE_ENTRY* CueStore_get(CUE_STORE* cs, int handle);
+
+int CueStore_next(CUE_STORE* cs, uint32_t bank, int32_t ipos);
+
+int CueStore_prev(CUE_STORE* cs, uint32_t bank, int32_t ipos);
+
+int CueStore_nearest(CUE_STORE* cs, uint32_t bank, int32_t ipos);
+
+int CueStore_at(CUE_STORE* cs, uint32_t bank, size_t n);
+
+size_t CueStore_count(CUE_STORE* cs, uint32_t bank);
+
+int CueStore_find(CUE_STORE* cs, uint32_t bank, const char* name);
+
+int CueStore_scan(CUE_STORE* cs, int handle);
+
+#endif  /* _CUESTORE_H_ */
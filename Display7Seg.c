@@ -0,0 +1,111 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Tape time display packets for the ATMega88 which multiplexes the seven
+ * segment display on the transport. A packet is only sent when the digits
+ * or flags shown change, or when the keep alive time has passed. This
+ * module only builds the packets, the caller writes them to the UART.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "TapeTime.h"
+#include "Display7Seg.h"
+
+//*****************************************************************************
+// Initialize the display link. The first update always sends a packet.
+//*****************************************************************************
+
+void Disp7_init(DISP7_LINK* link, bool extended)
+{
+    memset(link->last, 0, sizeof(link->last));
+
+    link->lastLen  = 0;
+    link->lastTime = 0;
+    link->extended = extended;
+}
+
+//*****************************************************************************
+// Build a display packet in the buffer and return the packet length. The
+// display packet is composed in the following form.
+//
+//    Byte   Description
+//    ----   -------------------------------------
+//    [0]    Preamble 1, must be 0x89
+//    [1]    Preamble 2, 0xFC standard or 0xFD extended
+//    [2]    The SECONDS (0-59)
+//    [3]    The MINUTES (0-59)
+//    [4]    The HOUR digit (0 or 1)
+//    [5]    Bit flags (+sign, blink, blank)
+//    [6]    Tenths of seconds (0-9), extended only
+//    [7]    Frame number, extended only
+//    [n]    8-Bit Checksum
+//
+//*****************************************************************************
+
+size_t Disp7_encode(TAPETIME* p, uint8_t* buf, bool extended)
+{
+    size_t i;
+    size_t len = 2;
+    uint16_t csum = 0;
+
+    buf[0] = DISP7_PREAMBLE;
+    buf[1] = extended ? DISP7_PREAMBLE_EXT : DISP7_PREAMBLE_STD;
+
+    buf[len++] = p->secs;
+    buf[len++] = p->mins;
+    buf[len++] = p->hour;
+    buf[len++] = p->flags;
+
+    if (extended)
+    {
+        buf[len++] = p->tens;
+        buf[len++] = p->frame;
+    }
+
+    /* The checksum doesn't include the preamble bytes */
+    for (i=2; i < len; i++)
+        csum += buf[i];
+
+    buf[len++] = (uint8_t)(csum & 0xFF);
+
+    return len;
+}
+
+//*****************************************************************************
+// Build the display packet for the tape time and return its length if it
+// needs to be sent, or zero if the display is already showing it. The
+// time now in ms is used for the keep alive.
+//*****************************************************************************
+
+size_t Disp7_update(DISP7_LINK* link, TAPETIME* p, uint8_t* buf, uint32_t now)
+{
+    size_t len = Disp7_encode(p, buf, link->extended);
+
+    if ((len == link->lastLen) && (memcmp(buf, link->last, len) == 0))
+    {
+        if ((now - link->lastTime) < DISP7_KEEPALIVE)
+            return 0;
+    }
+
+    memcpy(link->last, buf, len);
+
+    link->lastLen  = len;
+    link->lastTime = now;
+
+    return len;
+}
+
+/* End-Of-File */
@@ -0,0 +1,61 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _DISPLAY7SEG_H_
+#define _DISPLAY7SEG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Display packet preamble bytes. The second preamble byte selects the
+ * standard packet or the extended packet which adds the tenths and
+ * frame digits.
+ */
+#define DISP7_PREAMBLE          0x89
+#define DISP7_PREAMBLE_STD      0xFC
+#define DISP7_PREAMBLE_EXT      0xFD
+
+#define DISP7_PACKET_STD        7       /* standard packet length */
+#define DISP7_PACKET_EXT        9       /* extended packet length */
+#define DISP7_PACKET_MAX        DISP7_PACKET_EXT
+
+/* Set to 1 to send the extended packet with the tenths and frame digits.
+ * The ATMega88 display firmware must support the extended packet.
+ */
+#ifndef DISP7_EXTENDED
+#define DISP7_EXTENDED          0
+#endif
+
+/* An unchanged display is sent again at this interval in ms so the
+ * display recovers from any packet lost on the serial link.
+ */
+#define DISP7_KEEPALIVE         1000
+
+/*** DISPLAY LINK DATA *****************************************************/
+
+typedef struct _DISP7_LINK {
+    uint8_t     last[DISP7_PACKET_MAX]; /* last packet sent          */
+    size_t      lastLen;                /* length of the last packet */
+    uint32_t    lastTime;               /* time last packet was sent */
+    bool        extended;               /* send extended packets     */
+} DISP7_LINK;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void Disp7_init(DISP7_LINK* link, bool extended);
+size_t Disp7_encode(TAPETIME* p, uint8_t* buf, bool extended);
+size_t Disp7_update(DISP7_LINK* link, TAPETIME* p, uint8_t* buf, uint32_t now);
+
+#endif  /* _DISPLAY7SEG_H_ */
@@ -0,0 +1,178 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* IPC and RAMP frame assembly. A whole frame, preamble to CRC, is built
+ * into a contiguous buffer so the caller can hand it to the UART in one
+ * write. The UARTs run on the uDMA driver, so a frame then goes out as a
+ * single DMA transfer rather than one driver call and semaphore wait for
+ * each byte.
+ *
+ * The frames built are byte for byte the ones IPC_FrameTx() and
+ * RAMP_TxFrame() sent a byte at a time, and the frame type flags in the
+ * FCB are set the same way. The module has no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "CRC16.h"
+#include "IPCFrameDefs.h"
+#include "RAMPFrameDefs.h"
+#include "FrameBuild.h"
+
+/* Static Function Prototypes */
+static size_t Finish(uint8_t* frame, size_t n, uint8_t seed);
+
+//*****************************************************************************
+// Build an IPC frame into the buffer given, which must hold IPC_FRAME_MAX
+// bytes. Returns the frame length in bytes, or zero if the text is too
+// long to send.
+//*****************************************************************************
+
+size_t IPC_FrameBuild(uint8_t* frame, IPC_FCB* fcb, const void* txtbuf, uint16_t txtlen)
+{
+    uint8_t type;
+    uint16_t framelen;
+    size_t n = 0;
+
+    if (txtlen > IPC_MAX_TEXT_LEN)
+        return 0;
+
+    /* Get the frame type less any flag bits */
+    type = (fcb->type & IPC_TYPE_MASK);
+
+    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
+    {
+        framelen = IPC_ACK_FRAME_LEN;
+
+        /* Set the ACK/NAK flag bit */
+        fcb->type |= IPC_F_ACKNAK;
+    }
+    else
+    {
+        framelen = txtlen + (IPC_FRAME_OVERHEAD - IPC_PREAMBLE_OVERHEAD);
+
+        /* If message is piggyback ACK/NAK, set flag bit also */
+        if ((type == IPC_MSG_ACK) || (type == IPC_MSG_NAK))
+            fcb->type |= IPC_F_ACKNAK;
+        else
+            fcb->type &= ~(IPC_F_ACKNAK);
+    }
+
+    frame[n++] = IPC_PREAMBLE_MSB;
+    frame[n++] = IPC_PREAMBLE_LSB;
+    frame[n++] = (uint8_t)((framelen >> 8) & 0xFF);
+    frame[n++] = (uint8_t)(framelen & 0xFF);
+    frame[n++] = fcb->type;
+
+    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
+    {
+        frame[n++] = fcb->acknak;
+    }
+    else
+    {
+        frame[n++] = fcb->seqnum;
+        frame[n++] = fcb->acknak;
+        frame[n++] = (uint8_t)((txtlen >> 8) & 0xFF);
+        frame[n++] = (uint8_t)(txtlen & 0xFF);
+
+        /* The text length is sent even if there is no text to send */
+        if (txtbuf && txtlen)
+        {
+            memcpy(&frame[n], txtbuf, txtlen);
+            n += txtlen;
+        }
+    }
+
+    return Finish(frame, n, IPC_CRC_SEED_BYTE);
+}
+
+//*****************************************************************************
+// Build a RAMP frame into the buffer given, which must hold RAMP_FRAME_MAX
+// bytes. Returns the frame length in bytes, or zero if the text is too
+// long to send.
+//*****************************************************************************
+
+size_t RAMP_FrameBuild(uint8_t* frame, RAMP_FCB* fcb, const void* txtbuf, uint16_t txtlen)
+{
+    uint8_t type;
+    uint16_t framelen;
+    size_t n = 0;
+
+    if (txtlen > MAX_TEXT_LEN)
+        return 0;
+
+    /* Get the frame type less any flag bits */
+    type = (fcb->type & FRAME_TYPE_MASK);
+
+    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
+    {
+        framelen = ACK_FRAME_LEN;
+
+        /* Set the ACK/NAK flag bit */
+        fcb->type |= F_ACKNAK;
+    }
+    else
+    {
+        framelen = txtlen + (FRAME_OVERHEAD - PREAMBLE_OVERHEAD);
+
+        /* If message is piggyback ACK/NAK, set flag bit also */
+        if ((type == TYPE_MSG_ACK) || (type == TYPE_MSG_NAK))
+            fcb->type |= F_ACKNAK;
+        else
+            fcb->type &= ~(F_ACKNAK);
+    }
+
+    frame[n++] = PREAMBLE_MSB;
+    frame[n++] = PREAMBLE_LSB;
+    frame[n++] = (uint8_t)((framelen >> 8) & 0xFF);
+    frame[n++] = (uint8_t)(framelen & 0xFF);
+    frame[n++] = fcb->type;
+    frame[n++] = fcb->address;
+
+    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
+    {
+        frame[n++] = fcb->acknak;
+    }
+    else
+    {
+        frame[n++] = fcb->seqnum;
+        frame[n++] = fcb->acknak;
+        frame[n++] = (uint8_t)((txtlen >> 8) & 0xFF);
+        frame[n++] = (uint8_t)(txtlen & 0xFF);
+
+        /* The text length is sent even if there is no text to send */
+        if (txtbuf && txtlen)
+        {
+            memcpy(&frame[n], txtbuf, txtlen);
+            n += txtlen;
+        }
+    }
+
+    return Finish(frame, n, CRC_SEED_BYTE);
+}
+
+/* Append the CRC, seeded and summed from the frame length on */
+static size_t Finish(uint8_t* frame, size_t n, uint8_t seed)
+{
+    uint16_t crc;
+
+    crc = CRC16Block(CRC16Update(0, seed), &frame[2], n - 2);
+
+    frame[n++] = (uint8_t)(crc >> 8);
+    frame[n++] = (uint8_t)(crc & 0xFF);
+
+    return n;
+}
+
+/* End-Of-File */
@@ -0,0 +1,25 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _FRAMEBUILD_H_
+#define _FRAMEBUILD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+size_t IPC_FrameBuild(uint8_t* frame, IPC_FCB* fcb, const void* txtbuf, uint16_t txtlen);
+
+size_t RAMP_FrameBuild(uint8_t* frame, RAMP_FCB* fcb, const void* txtbuf, uint16_t txtlen);
+
+#endif  /* _FRAMEBUILD_H_ */
@@ -0,0 +1,446 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* IPC and RAMP frame parsing. The parser is a state machine fed whatever
+ * bytes have arrived, a few or many at a time, and picks up where it left
+ * off on the next feed. It never blocks, so the same code runs from a UART
+ * reader task, the simulator or a test fed from a recorded stream.
+ *
+ * Frames are gathered into a buffer owned by the caller and handed back in
+ * place, with the text pointing into the buffer. When a frame is found bad
+ * the bytes held after its first are searched again for a frame start, so
+ * a stray preamble byte in line noise costs no more than the noise itself
+ * and a good frame that began inside a bad one is still received.
+ *
+ * A UART reader feeds the parser through a small receive ring. It asks the
+ * parser for space, reads into it and commits the bytes read. The space
+ * given never runs past the end of the frame being received, so a blocking
+ * read returns as soon as a frame is complete, and once the frame length is
+ * known the text is read straight into the frame buffer. The module has no
+ * RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "CRC16.h"
+#include "IPCFrameDefs.h"
+#include "RAMPFrameDefs.h"
+#include "FrameParse.h"
+
+/* Frame format of each protocol */
+typedef struct _FRAME_FORMAT {
+    uint8_t     msb;                /* preamble bytes               */
+    uint8_t     lsb;
+    uint8_t     seed;               /* CRC seed byte                */
+    uint8_t     address;            /* address bytes in the header  */
+    bool        ackOnly;            /* ACK/NAK types are ACK frames only */
+    uint16_t    ackLen;             /* frame lengths less preamble  */
+    uint16_t    minLen;
+    uint16_t    maxLen;
+} FRAME_FORMAT;
+
+static const FRAME_FORMAT s_format[] = {
+    { IPC_PREAMBLE_MSB, IPC_PREAMBLE_LSB, IPC_CRC_SEED_BYTE, 0, true,
+      IPC_ACK_FRAME_LEN, IPC_MIN_FRAME_LEN, IPC_MAX_FRAME_LEN },
+    { PREAMBLE_MSB, PREAMBLE_LSB, CRC_SEED_BYTE, 1, false,
+      ACK_FRAME_LEN, MIN_FRAME_LEN, MAX_FRAME_LEN },
+};
+
+/* Step() results */
+#define STEP_MORE               0       /* frame not complete yet       */
+#define STEP_FOUND              1       /* good frame found             */
+#define STEP_BAD                2       /* bad frame to search again    */
+
+/* Static Function Prototypes */
+static size_t Step(FRAME_PARSER* p, const uint8_t* src, size_t len, FRAME_RX* frame,
+                   int* result);
+static bool Check(FRAME_PARSER* p, FRAME_RX* frame);
+static void Resync(FRAME_PARSER* p);
+static size_t Want(FRAME_PARSER* p);
+
+//*****************************************************************************
+// Set up a parser for the protocol given, gathering frames into the buffer
+// given. Returns false if the buffer can't hold the largest frame.
+//*****************************************************************************
+
+bool FrameParse_init(FRAME_PARSER* p, int protocol, uint8_t* buf, size_t size)
+{
+    memset(p, 0, sizeof(FRAME_PARSER));
+
+    p->protocol = (uint8_t)protocol;
+    p->state    = FRAME_HUNT;
+    p->buf      = buf;
+    p->size     = size;
+
+    return (size >= (size_t)s_format[protocol].maxLen + PREAMBLE_OVERHEAD);
+}
+
+//*****************************************************************************
+// Feed received bytes to the parser. Returns true when a frame is found,
+// with the count of bytes used to find it. The rest of the data is to be
+// fed again once the frame has been dealt with. Returns false once all the
+// data is used without finding a frame.
+//*****************************************************************************
+
+bool FrameParse_feed(FRAME_PARSER* p, const uint8_t* data, size_t len, size_t* used,
+                     FRAME_RX* frame)
+{
+    size_t pos = 0;
+    size_t n;
+    int result = STEP_MORE;
+
+    while (result != STEP_FOUND)
+    {
+        if (p->replay < p->replayEnd)
+        {
+            /* Bytes held from a bad frame are searched before new ones */
+            n = Step(p, &p->buf[p->replay], p->replayEnd - p->replay, frame, &result);
+
+            p->replay += n;
+        }
+        else if (pos < len)
+        {
+            n = Step(p, &data[pos], len - pos, frame, &result);
+
+            pos += n;
+            p->stats.bytes += (uint32_t)n;
+        }
+        else
+        {
+            break;
+        }
+
+        /* Search again once the bytes taken are accounted for, as this
+         * starts a new replay of the bytes held.
+         */
+        if (result == STEP_BAD)
+            Resync(p);
+    }
+
+    *used = pos;
+
+    return (result == STEP_FOUND);
+}
+
+//*****************************************************************************
+// Return the space to read into and the number of bytes that may be read,
+// which is never past the end of the frame being received. This is in the
+// frame buffer once the frame length is known and nothing is waiting in
+// the ring. Returns zero if the parser has bytes to go through first.
+//*****************************************************************************
+
+size_t FrameParse_space(FRAME_PARSER* p, uint8_t** ptr)
+{
+    FRAME_RING* ring = &p->ring;
+    size_t want;
+
+    p->direct = false;
+
+    if ((p->replay < p->replayEnd) || (ring->head != ring->tail))
+        return 0;
+
+    want = Want(p);
+
+    if (p->state == FRAME_BODY)
+    {
+        p->direct = true;
+        *ptr = &p->buf[p->fill];
+        return want;
+    }
+
+    /* The ring is empty, so start from the top to read in one piece */
+    ring->head = ring->tail = 0;
+
+    *ptr = ring->data;
+
+    return (want < FRAME_RING_SIZE) ? want : FRAME_RING_SIZE;
+}
+
+//*****************************************************************************
+// Note the bytes read into the space last given.
+//*****************************************************************************
+
+void FrameParse_commit(FRAME_PARSER* p, size_t n)
+{
+    if (p->direct)
+    {
+        p->fill += n;
+        p->stats.bytes += (uint32_t)n;
+    }
+    else
+    {
+        p->ring.head += (uint32_t)n;
+    }
+
+    p->direct = false;
+}
+
+//*****************************************************************************
+// Parse the bytes committed. Returns true when a frame is found, or false
+// once all the bytes are used without finding one.
+//*****************************************************************************
+
+bool FrameParse_next(FRAME_PARSER* p, FRAME_RX* frame)
+{
+    FRAME_RING* ring = &p->ring;
+    uint32_t offset;
+    size_t len;
+    size_t used;
+    bool found = false;
+
+    /* Text read straight into the frame buffer may have completed it */
+    if ((p->state == FRAME_BODY) && (p->fill == p->need))
+    {
+        if (Check(p, frame))
+            return true;
+
+        Resync(p);
+    }
+
+    while (!found)
+    {
+        offset = ring->tail & (FRAME_RING_SIZE - 1);
+        len = ring->head - ring->tail;
+
+        if (len > (FRAME_RING_SIZE - offset))
+            len = FRAME_RING_SIZE - offset;
+
+        found = FrameParse_feed(p, &ring->data[offset], len, &used, frame);
+
+        ring->tail += (uint32_t)used;
+
+        if (!len)
+            break;
+    }
+
+    return found;
+}
+
+//*****************************************************************************
+// Drop a frame cut short by a receive timeout. Its bytes are searched again
+// for another frame start on the next feed.
+//*****************************************************************************
+
+void FrameParse_abort(FRAME_PARSER* p)
+{
+    if (p->state == FRAME_HUNT)
+        return;
+
+    p->stats.aborted++;
+
+    Resync(p);
+}
+
+/* Take bytes in the current state, returning the count used. A bad frame
+ * is left for the caller to search again.
+ */
+static size_t Step(FRAME_PARSER* p, const uint8_t* src, size_t len, FRAME_RX* frame,
+                   int* result)
+{
+    const FRAME_FORMAT* f = &s_format[p->protocol];
+    const uint8_t* sof;
+    size_t framelen;
+    size_t n;
+
+    *result = STEP_MORE;
+
+    switch(p->state)
+    {
+    case FRAME_HUNT:
+        if ((sof = memchr(src, f->msb, len)) == NULL)
+        {
+            p->stats.skipped += (uint32_t)len;
+            return len;
+        }
+
+        n = (size_t)(sof - src);
+        p->stats.skipped += (uint32_t)n;
+
+        p->buf[0] = f->msb;
+        p->fill   = 1;
+        p->state  = FRAME_PREAMBLE;
+        return n + 1;
+
+    case FRAME_PREAMBLE:
+        p->buf[p->fill++] = *src;
+
+        if (*src == f->lsb)
+        {
+            p->state = FRAME_LENGTH;
+        }
+        else
+        {
+            p->stats.preamble++;
+            *result = STEP_BAD;
+        }
+        return 1;
+
+    case FRAME_LENGTH:
+        p->buf[p->fill++] = *src;
+
+        if (p->fill < PREAMBLE_OVERHEAD)
+            return 1;
+
+        framelen = ((size_t)p->buf[2] << 8) | p->buf[3];
+
+        if ((framelen < f->ackLen) || (framelen > f->maxLen))
+        {
+            p->stats.length++;
+            *result = STEP_BAD;
+        }
+        else
+        {
+            p->need  = framelen + PREAMBLE_OVERHEAD;
+            p->state = FRAME_BODY;
+        }
+        return 1;
+
+    default:
+        n = p->need - p->fill;
+
+        if (n > len)
+            n = len;
+
+        /* Replayed bytes are moved down, never over the bytes to come */
+        memmove(&p->buf[p->fill], src, n);
+        p->fill += n;
+
+        if (p->fill < p->need)
+            return n;
+
+        *result = Check(p, frame) ? STEP_FOUND : STEP_BAD;
+
+        return n;
+    }
+}
+
+/* Validate a whole frame held and return its contents */
+static bool Check(FRAME_PARSER* p, FRAME_RX* frame)
+{
+    const FRAME_FORMAT* f = &s_format[p->protocol];
+    uint8_t* buf = p->buf;
+    size_t framelen = p->need - PREAMBLE_OVERHEAD;
+    size_t hdr = 5 + f->address;
+    uint16_t textlen;
+    uint16_t crc;
+    uint8_t type;
+
+    /* Sum from the frame length up to the CRC */
+    crc = CRC16Block(CRC16Update(0, f->seed), &buf[2], p->need - 4);
+
+    if (crc != (uint16_t)((buf[p->need - 2] << 8) | buf[p->need - 1]))
+    {
+        p->stats.crc++;
+        return false;
+    }
+
+    /* The frame type codes are the same in both protocols */
+    type = buf[4] & FRAME_TYPE_MASK;
+
+    frame->type    = buf[4];
+    frame->address = f->address ? buf[5] : 0;
+
+    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
+    {
+        if (framelen == f->ackLen)
+        {
+            frame->seqnum  = 0;
+            frame->acknak  = buf[hdr];
+            frame->text    = NULL;
+            frame->textlen = 0;
+            goto done;
+        }
+
+        if (f->ackOnly)
+        {
+            p->stats.length++;
+            return false;
+        }
+    }
+
+    if (framelen < f->minLen)
+    {
+        p->stats.length++;
+        return false;
+    }
+
+    textlen = (uint16_t)((buf[hdr + 2] << 8) | buf[hdr + 3]);
+
+    if ((size_t)textlen + f->minLen != framelen)
+    {
+        p->stats.length++;
+        return false;
+    }
+
+    frame->seqnum  = buf[hdr];
+    frame->acknak  = buf[hdr + 1];
+    frame->text    = &buf[hdr + 4];
+    frame->textlen = textlen;
+
+done:
+    p->stats.frames++;
+    p->state = FRAME_HUNT;
+    p->fill  = 0;
+
+    return true;
+}
+
+/* Drop the first byte of a bad frame and search the rest again */
+static void Resync(FRAME_PARSER* p)
+{
+    const FRAME_FORMAT* f = &s_format[p->protocol];
+    const uint8_t* sof = NULL;
+    size_t start = p->fill;
+    size_t held;
+    size_t rest;
+
+    p->stats.resyncs++;
+
+    if (p->fill > 1)
+        sof = memchr(&p->buf[1], f->msb, p->fill - 1);
+
+    if (sof)
+        start = (size_t)(sof - p->buf);
+
+    p->stats.skipped += (uint32_t)start;
+
+    /* Put the bytes from the next frame start ahead of any still to be
+     * searched from an earlier bad frame, at the bottom of the buffer.
+     */
+    held = p->fill - start;
+    rest = p->replayEnd - p->replay;
+
+    memmove(&p->buf[0], &p->buf[start], held);
+    memmove(&p->buf[held], &p->buf[p->replay], rest);
+
+    p->replay    = 0;
+    p->replayEnd = held + rest;
+    p->fill      = 0;
+    p->state     = FRAME_HUNT;
+}
+
+/* Bytes that may be read without reading past the frame being received */
+static size_t Want(FRAME_PARSER* p)
+{
+    const FRAME_FORMAT* f = &s_format[p->protocol];
+
+    if (p->state == FRAME_BODY)
+        return p->need - p->fill;
+
+    /* Nothing shorter than an ACK frame can follow */
+    return (f->ackLen + PREAMBLE_OVERHEAD) - p->fill;
+}
+
+/* End-Of-File */
@@ -0,0 +1,100 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _FRAMEPARSE_H_
+#define _FRAMEPARSE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Frame protocols parsed */
+#define FRAME_IPC               0
+#define FRAME_RAMP              1
+
+/* Receive ring size in bytes, a power of two. Only the frame preamble and
+ * header pass through the ring, the text is read straight into the frame
+ * buffer.
+ */
+#define FRAME_RING_SIZE         64
+
+/* Parser states */
+typedef enum _FRAME_STATE {
+    FRAME_HUNT,                 /* looking for the preamble MSB     */
+    FRAME_PREAMBLE,             /* preamble MSB found               */
+    FRAME_LENGTH,               /* reading the frame length         */
+    FRAME_BODY,                 /* reading the rest of the frame    */
+} FRAME_STATE;
+
+/*** FRAME PARSER DATA *****************************************************/
+
+/* A frame received. The text is in the parser frame buffer and is only
+ * good until the parser is fed again.
+ */
+typedef struct _FRAME_RX {
+    uint8_t         type;           /* frame type and flag bits     */
+    uint8_t         seqnum;         /* zero for an ACK/NAK frame    */
+    uint8_t         acknak;
+    uint8_t         address;        /* RAMP node address            */
+    const uint8_t*  text;
+    uint16_t        textlen;
+} FRAME_RX;
+
+typedef struct _FRAME_STATS {
+    uint32_t    bytes;              /* bytes received               */
+    uint32_t    frames;             /* good frames received         */
+    uint32_t    skipped;            /* bytes dropped finding frames */
+    uint32_t    preamble;           /* preamble MSB not followed by the LSB */
+    uint32_t    length;             /* bad frame or text lengths    */
+    uint32_t    crc;                /* frames failing the CRC       */
+    uint32_t    aborted;            /* frames cut short by a timeout */
+    uint32_t    resyncs;            /* bad frames searched again    */
+} FRAME_STATS;
+
+typedef struct _FRAME_RING {
+    uint8_t     data[FRAME_RING_SIZE];
+    uint32_t    head;               /* bytes put in                 */
+    uint32_t    tail;               /* bytes taken out              */
+} FRAME_RING;
+
+typedef struct _FRAME_PARSER {
+    uint8_t     protocol;           /* FRAME_IPC or FRAME_RAMP      */
+    uint8_t     state;              /* FRAME_STATE                  */
+    bool        direct;             /* space given in the frame buffer */
+    uint8_t*    buf;                /* frame buffer                 */
+    size_t      size;
+    size_t      fill;               /* bytes of the frame held      */
+    size_t      need;               /* whole frame length in bytes  */
+    size_t      replay;             /* bad frame bytes to search    */
+    size_t      replayEnd;
+    FRAME_RING  ring;
+    FRAME_STATS stats;
+} FRAME_PARSER;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+bool FrameParse_init(FRAME_PARSER* p, int protocol, uint8_t* buf, size_t size);
+
+bool FrameParse_feed(FRAME_PARSER* p, const uint8_t* data, size_t len, size_t* used,
+                     FRAME_RX* frame);
+
+size_t FrameParse_space(FRAME_PARSER* p, uint8_t** ptr);
+
+void FrameParse_commit(FRAME_PARSER* p, size_t n);
+
+bool FrameParse_next(FRAME_PARSER* p, FRAME_RX* frame);
+
+void FrameParse_abort(FRAME_PARSER* p);
+
+#endif  /* _FRAMEPARSE_H_ */
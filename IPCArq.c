@@ -0,0 +1,668 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Selective repeat ARQ for the IPC link. Every message frame is sent with
+ * a sequence number and kept until the peer ACKs it, and up to
+ * IPC_MAX_WINDOW frames can be waiting on an ACK. A frame not ACKed
+ * within the retransmit timeout is sent again, up to IPC_ARQ_TRIES times,
+ * and the timeout follows the round trips measured as RFC 6298 does for
+ * TCP, leaving out frames that were sent more than once.
+ *
+ * The receiver ACKs each message frame with an ACK only frame, except a
+ * transaction request, which is ACKed by the MSG+ACK reply carrying its
+ * sequence number in the ACK/NAK field. A request received again before
+ * the reply goes out is ACKed on its own. Frames received again are ACKed
+ * and dropped, and frames received ahead of a missing one are held and
+ * delivered in order once it arrives. The missing frame is NAKed, as is the
+ * next frame expected when a frame fails its CRC, and the sender resends
+ * a NAKed frame at once.
+ *
+ * Sequence numbers run from IPC_MIN_SEQ to IPC_MAX_SEQ, three windows, so
+ * the window ahead of the receiver and the window behind it, where frames
+ * received again fall, never overlap. A frame beyond the receive window
+ * means the sender has given up on the frames it moved past, and those
+ * still missing are skipped rather than waited on.
+ *
+ * The module keeps the state only, the IPC server tasks send and receive
+ * the frames. Times are in ms and there are no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "IPCArq.h"
+
+/* Frame states */
+#define ARQ_FREE                0
+#define ARQ_QUEUED              1       /* tx: sequence number given */
+#define ARQ_SENT                2       /* tx: waiting on an ACK */
+#define ARQ_ACKED               3       /* tx: ACKed or given up on */
+#define ARQ_HELD                1       /* rx: waiting to be delivered */
+#define ARQ_DONE                2       /* rx: delivered or skipped */
+
+#define ARQ_WINDOW              IPC_MAX_WINDOW
+
+/* Slot and mask bit for a sequence number */
+#define ARQ_INDEX(seq)          ((size_t)((seq) - IPC_MIN_SEQ))
+#define ARQ_BIT(seq)            (1UL << ARQ_INDEX(seq))
+
+/* Static Function Prototypes */
+static uint8_t Seq(uint8_t seq, int n);
+static int Dist(uint8_t from, uint8_t to);
+static bool Before(uint32_t a, uint32_t b);
+static void Ack(IPC_ARQ* arq, uint8_t seq, uint32_t now);
+static void Nak(IPC_ARQ* arq, uint8_t seq, uint32_t now);
+static void Slide(IPC_ARQ* arq);
+static void Sample(IPC_ARQ* arq, uint32_t rtt);
+static uint32_t Timeout(IPC_ARQ* arq, uint8_t tries);
+static int Hold(IPC_ARQ* arq, const IPC_FCB* fcb, const void* text, uint16_t textlen,
+                uint32_t now);
+static void Advance(IPC_ARQ* arq);
+static bool Expiry(IPC_ARQ* arq, uint32_t* when);
+static void Copy(IPC_ARQ_FRAME* f, IPC_FCB* fcb, void* text, uint16_t* textlen);
+
+//*****************************************************************************
+// Start the link with nothing sent or received.
+//*****************************************************************************
+
+void IPCArq_init(IPC_ARQ* arq)
+{
+    memset(arq, 0, sizeof(IPC_ARQ));
+
+    arq->txBase = IPC_MIN_SEQ;
+    arq->txNext = IPC_MIN_SEQ;
+    arq->rxBase = IPC_MIN_SEQ;
+    arq->rto    = IPC_ARQ_RTO_INIT;
+}
+
+//*****************************************************************************
+// Give a message frame the next sequence number and keep a copy of it for
+// resending. The sequence number is set in the FCB. Returns false if the
+// window is full or the text too long to keep.
+//*****************************************************************************
+
+bool IPCArq_reserve(IPC_ARQ* arq, IPC_FCB* fcb, const void* text, uint16_t textlen)
+{
+    IPC_ARQ_FRAME* f;
+
+    if ((arq->txCount >= ARQ_WINDOW) || (textlen > IPC_ARQ_TEXT_MAX))
+        return false;
+
+    f = &arq->tx[ARQ_INDEX(arq->txNext)];
+
+    f->state   = ARQ_QUEUED;
+    f->tries   = 0;
+    f->type    = fcb->type;
+    f->acknak  = fcb->acknak;
+    f->textlen = textlen;
+    f->nak     = false;
+
+    if (text && textlen)
+        memcpy(f->text, text, textlen);
+
+    fcb->seqnum = arq->txNext;
+
+    arq->txNext = IPC_INC_SEQ(arq->txNext);
+    arq->txCount++;
+
+    return true;
+}
+
+//*****************************************************************************
+// Note a reserved frame has been sent the first time and start its
+// retransmit timer.
+//*****************************************************************************
+
+void IPCArq_sent(IPC_ARQ* arq, uint8_t seqnum, uint32_t now)
+{
+    IPC_ARQ_FRAME* f;
+
+    if ((seqnum < IPC_MIN_SEQ) || (seqnum > IPC_MAX_SEQ))
+        return;
+
+    f = &arq->tx[ARQ_INDEX(seqnum)];
+
+    if (f->state != ARQ_QUEUED)
+        return;
+
+    f->state = ARQ_SENT;
+    f->tries = 1;
+    f->time  = now;
+    f->due   = now + Timeout(arq, 1);
+
+    arq->stats.txFrames++;
+}
+
+//*****************************************************************************
+// Return the number of send window slots freed by ACKs and frames given up
+// on since the last call.
+//*****************************************************************************
+
+uint8_t IPCArq_freed(IPC_ARQ* arq)
+{
+    uint8_t n = arq->txFreed;
+
+    arq->txFreed = 0;
+
+    return n;
+}
+
+//*****************************************************************************
+// Take a frame received. ACKs and NAKs are applied to the frames sent, and
+// a message frame is held for delivery in order, with any ACK or NAK it
+// needs queued to send. Returns one of the IPC_ARQ_RX codes.
+//*****************************************************************************
+
+int IPCArq_rxFrame(IPC_ARQ* arq, const IPC_FCB* fcb, const void* text, uint16_t textlen,
+                   uint32_t now)
+{
+    uint8_t type = (fcb->type & IPC_TYPE_MASK);
+
+    switch(type)
+    {
+    case IPC_ACK_ONLY:
+        Ack(arq, fcb->acknak, now);
+        return IPC_ARQ_CONTROL;
+
+    case IPC_NAK_ONLY:
+        Nak(arq, fcb->acknak, now);
+        return IPC_ARQ_CONTROL;
+
+    case IPC_MSG_ACK:
+        Ack(arq, fcb->acknak, now);
+        break;
+
+    case IPC_MSG_NAK:
+        Nak(arq, fcb->acknak, now);
+        break;
+    }
+
+    /* An unsequenced frame from a peer without ARQ */
+    if (fcb->seqnum == IPC_NULL_SEQ)
+        return IPC_ARQ_DELIVER;
+
+    if ((fcb->seqnum < IPC_MIN_SEQ) || (fcb->seqnum > IPC_MAX_SEQ) ||
+        (textlen > IPC_ARQ_TEXT_MAX))
+        return IPC_ARQ_REJECTED;
+
+    return Hold(arq, fcb, text, textlen, now);
+}
+
+//*****************************************************************************
+// A frame failed its CRC. NAK the next frame expected so the peer resends
+// it now if that was the one, rather than after its timeout.
+//*****************************************************************************
+
+void IPCArq_rxError(IPC_ARQ* arq)
+{
+    IPC_ARQ_FRAME* f = &arq->rx[ARQ_INDEX(arq->rxBase)];
+
+    if (!arq->rxSynced || (f->state != ARQ_FREE) || f->nak)
+        return;
+
+    f->nak = true;
+
+    arq->nakMask |= ARQ_BIT(arq->rxBase);
+}
+
+//*****************************************************************************
+// Return the next frame to deliver, in sequence order. A missing frame is
+// given up on once a frame after it has been held for IPC_ARQ_HOLD ms.
+//*****************************************************************************
+
+bool IPCArq_rxNext(IPC_ARQ* arq, IPC_FCB* fcb, void* text, uint16_t* textlen, uint32_t now)
+{
+    IPC_ARQ_FRAME* f;
+    uint32_t when;
+    uint8_t seq;
+
+    /* Frames from before the receiver synced go first */
+    if (arq->lateMask)
+    {
+        for (seq=IPC_MIN_SEQ; !(arq->lateMask & ARQ_BIT(seq)); seq++)
+            ;
+
+        arq->lateMask &= ~ARQ_BIT(seq);
+
+        f = &arq->rx[ARQ_INDEX(seq)];
+
+        Copy(f, fcb, text, textlen);
+        fcb->seqnum = seq;
+
+        return true;
+    }
+
+    while (arq->rxSynced)
+    {
+        f = &arq->rx[ARQ_INDEX(arq->rxBase)];
+
+        if (arq->rxBase == arq->rxSkipTo)
+            arq->rxSkipTo = IPC_NULL_SEQ;
+
+        if (f->state == ARQ_HELD)
+        {
+            Copy(f, fcb, text, textlen);
+            fcb->seqnum = arq->rxBase;
+
+            Advance(arq);
+
+            return true;
+        }
+
+        /* Frames the sender moved past go at once, others after the hold */
+        if (!arq->rxSkipTo && (!Expiry(arq, &when) || Before(now, when)))
+            break;
+
+        /* The sender has given up on it */
+        f->state = ARQ_DONE;
+
+        arq->stats.rxSkipped++;
+
+        Advance(arq);
+    }
+
+    return false;
+}
+
+//*****************************************************************************
+// Return the next frame to send now, an ACK or NAK or a frame to resend.
+// Frames out of tries are given up on. Returns false if there is nothing
+// to send.
+//*****************************************************************************
+
+bool IPCArq_poll(IPC_ARQ* arq, uint32_t now, IPC_FCB* fcb, void* text, uint16_t* textlen)
+{
+    IPC_ARQ_FRAME* f;
+    uint32_t* mask;
+    uint8_t seq;
+    int i;
+
+    /* NAKs first so the peer can start resending, then the ACKs */
+    mask = arq->nakMask ? &arq->nakMask : (arq->ackMask ? &arq->ackMask : NULL);
+
+    if (mask)
+    {
+        for (seq=IPC_MIN_SEQ; !(*mask & ARQ_BIT(seq)); seq++)
+            ;
+
+        *mask &= ~ARQ_BIT(seq);
+
+        fcb->type   = IPC_MAKETYPE(0, (mask == &arq->nakMask) ? IPC_NAK_ONLY : IPC_ACK_ONLY);
+        fcb->seqnum = IPC_NULL_SEQ;
+        fcb->acknak = seq;
+        fcb->rsvd   = 0;
+
+        *textlen = 0;
+
+        arq->stats.txAcks++;
+
+        return true;
+    }
+
+    for (i=0; i < arq->txCount; i++)
+    {
+        seq = Seq(arq->txBase, i);
+        f   = &arq->tx[ARQ_INDEX(seq)];
+
+        if ((f->state != ARQ_SENT) || Before(now, f->due))
+            continue;
+
+        if (f->tries >= IPC_ARQ_TRIES)
+        {
+            f->state = ARQ_ACKED;
+
+            arq->stats.txFailed++;
+
+            continue;
+        }
+
+        f->tries++;
+
+        /* A NAK shows the peer is there, only silence backs off */
+        if (f->nak)
+        {
+            arq->stats.txNaks++;
+            f->due = now + Timeout(arq, 1);
+        }
+        else
+        {
+            arq->stats.txTimeouts++;
+            f->due = now + Timeout(arq, f->tries);
+        }
+
+        arq->stats.txResent++;
+
+        f->nak = false;
+
+        Copy(f, fcb, text, textlen);
+        fcb->seqnum = seq;
+
+        Slide(arq);
+
+        return true;
+    }
+
+    Slide(arq);
+
+    return false;
+}
+
+//*****************************************************************************
+// Return the ms until IPCArq_poll() or IPCArq_rxNext() next has something
+// to do, zero if now, or IPC_ARQ_IDLE if nothing is waiting.
+//*****************************************************************************
+
+uint32_t IPCArq_due(IPC_ARQ* arq, uint32_t now)
+{
+    IPC_ARQ_FRAME* f;
+    uint32_t when = 0;
+    bool waiting;
+    int i;
+
+    if (arq->ackMask || arq->nakMask || arq->lateMask || arq->rxSkipTo)
+        return 0;
+
+    waiting = Expiry(arq, &when);
+
+    for (i=0; i < arq->txCount; i++)
+    {
+        f = &arq->tx[ARQ_INDEX(Seq(arq->txBase, i))];
+
+        if (f->state != ARQ_SENT)
+            continue;
+
+        if (!waiting || Before(f->due, when))
+            when = f->due;
+
+        waiting = true;
+    }
+
+    if (!waiting)
+        return IPC_ARQ_IDLE;
+
+    return Before(now, when) ? (when - now) : 0;
+}
+
+/* Step a sequence number n frames on, or back for n down to -IPC_MAX_SEQ */
+static uint8_t Seq(uint8_t seq, int n)
+{
+    return (uint8_t)(((seq - IPC_MIN_SEQ + n + IPC_MAX_SEQ) % IPC_MAX_SEQ) + IPC_MIN_SEQ);
+}
+
+/* Frames from one sequence number forward to another */
+static int Dist(uint8_t from, uint8_t to)
+{
+    return (to - from + IPC_MAX_SEQ) % IPC_MAX_SEQ;
+}
+
+/* True if time a is before time b */
+static bool Before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/* A frame sent was ACKed */
+static void Ack(IPC_ARQ* arq, uint8_t seq, uint32_t now)
+{
+    IPC_ARQ_FRAME* f;
+
+    if ((seq < IPC_MIN_SEQ) || (seq > IPC_MAX_SEQ) || (Dist(arq->txBase, seq) >= arq->txCount))
+        return;
+
+    f = &arq->tx[ARQ_INDEX(seq)];
+
+    if ((f->state != ARQ_SENT) && (f->state != ARQ_QUEUED))
+        return;
+
+    /* Karn's rule, the round trip of a frame sent twice is ambiguous */
+    if ((f->state == ARQ_SENT) && (f->tries == 1))
+        Sample(arq, now - f->time);
+
+    f->state = ARQ_ACKED;
+
+    Slide(arq);
+}
+
+/* A frame sent was NAKed, resend it at the next poll */
+static void Nak(IPC_ARQ* arq, uint8_t seq, uint32_t now)
+{
+    IPC_ARQ_FRAME* f;
+
+    if ((seq < IPC_MIN_SEQ) || (seq > IPC_MAX_SEQ) || (Dist(arq->txBase, seq) >= arq->txCount))
+        return;
+
+    f = &arq->tx[ARQ_INDEX(seq)];
+
+    if (f->state != ARQ_SENT)
+        return;
+
+    f->nak = true;
+    f->due = now;
+}
+
+/* Move the send window past the frames done with */
+static void Slide(IPC_ARQ* arq)
+{
+    IPC_ARQ_FRAME* f;
+
+    while (arq->txCount)
+    {
+        f = &arq->tx[ARQ_INDEX(arq->txBase)];
+
+        if (f->state != ARQ_ACKED)
+            break;
+
+        f->state = ARQ_FREE;
+
+        arq->txBase = IPC_INC_SEQ(arq->txBase);
+        arq->txCount--;
+        arq->txFreed++;
+    }
+}
+
+/* Fold a round trip into the retransmit timeout, as RFC 6298 */
+static void Sample(IPC_ARQ* arq, uint32_t rtt)
+{
+    int32_t delta;
+    uint32_t rto;
+
+    if (!arq->stats.rttSamples)
+    {
+        arq->srtt   = rtt << 3;
+        arq->rttvar = rtt << 1;
+    }
+    else
+    {
+        delta = (int32_t)rtt - (int32_t)(arq->srtt >> 3);
+
+        arq->srtt += delta;
+
+        if (delta < 0)
+            delta = -delta;
+
+        arq->rttvar += delta - (int32_t)(arq->rttvar >> 2);
+    }
+
+    arq->stats.rttSamples++;
+
+    if (rtt > arq->stats.rttMax)
+        arq->stats.rttMax = rtt;
+
+    rto = (arq->srtt >> 3) + (arq->rttvar ? arq->rttvar : 1);
+
+    if (rto < IPC_ARQ_RTO_MIN)
+        rto = IPC_ARQ_RTO_MIN;
+    else if (rto > IPC_ARQ_RTO_MAX)
+        rto = IPC_ARQ_RTO_MAX;
+
+    arq->rto = rto;
+}
+
+/* Retransmit timeout for a frame sent the number of times given. It backs
+ * off once only, the line has no other traffic to make room for and more
+ * only holds up the window.
+ */
+static uint32_t Timeout(IPC_ARQ* arq, uint8_t tries)
+{
+    uint32_t rto = (tries > 1) ? (arq->rto << 1) : arq->rto;
+
+    return (rto > IPC_ARQ_RTO_MAX) ? IPC_ARQ_RTO_MAX : rto;
+}
+
+/* Hold a message frame received for delivery and queue its ACK or NAKs */
+static int Hold(IPC_ARQ* arq, const IPC_FCB* fcb, const void* text, uint16_t textlen,
+                uint32_t now)
+{
+    IPC_ARQ_FRAME* f;
+    uint8_t seq = fcb->seqnum;
+    uint8_t base;
+    bool request;
+    int d, i;
+
+    /* A transaction request is ACKed by its reply */
+    request = (((fcb->type & IPC_TYPE_MASK) == IPC_MSG_ONLY) && !(fcb->type & IPC_F_DATAGRAM));
+
+    if (!arq->rxSynced)
+    {
+        arq->rxSynced = true;
+        arq->rxBase   = seq;
+    }
+
+    f = &arq->rx[ARQ_INDEX(seq)];
+    d = Dist(arq->rxBase, seq);
+
+    if (d >= (2 * ARQ_WINDOW))
+    {
+        /* Behind the window, received again unless from before the sync */
+        if (f->state != ARQ_FREE)
+        {
+            arq->ackMask |= ARQ_BIT(seq);
+            arq->stats.rxDuplicates++;
+            return IPC_ARQ_DUPLICATE;
+        }
+
+        arq->lateMask |= ARQ_BIT(seq);
+    }
+    else if (d >= ARQ_WINDOW)
+    {
+        /* The sender moved past frames still missing, skip up to here */
+        arq->rxSkipTo = Seq(seq, 1 - ARQ_WINDOW);
+    }
+    else if (f->state != ARQ_FREE)
+    {
+        arq->ackMask |= ARQ_BIT(seq);
+        arq->stats.rxDuplicates++;
+        return IPC_ARQ_DUPLICATE;
+    }
+
+    f->state   = ARQ_HELD;
+    f->type    = fcb->type;
+    f->acknak  = fcb->acknak;
+    f->textlen = textlen;
+    f->time    = now;
+
+    if (text && textlen)
+        memcpy(f->text, text, textlen);
+
+    if (!request)
+        arq->ackMask |= ARQ_BIT(seq);
+
+    arq->nakMask &= ~ARQ_BIT(seq);
+
+    /* NAK the frames missing ahead of it that are not skipped, once each */
+    if ((d > 0) && (d < (2 * ARQ_WINDOW)))
+    {
+        arq->stats.rxHeld++;
+
+        base = arq->rxBase;
+
+        if (arq->rxSkipTo && (Dist(base, arq->rxSkipTo) < d))
+            base = arq->rxSkipTo;
+
+        for (i=Dist(base, seq); i > 0; i--)
+        {
+            IPC_ARQ_FRAME* m = &arq->rx[ARQ_INDEX(Seq(base, i - 1))];
+
+            if ((m->state == ARQ_FREE) && !m->nak)
+            {
+                m->nak = true;
+                arq->nakMask |= ARQ_BIT(Seq(base, i - 1));
+            }
+        }
+    }
+
+    return IPC_ARQ_QUEUED;
+}
+
+/* Move the receive window on a frame, clearing the frame that drops out of
+ * the window behind it.
+ */
+static void Advance(IPC_ARQ* arq)
+{
+    IPC_ARQ_FRAME* f = &arq->rx[ARQ_INDEX(Seq(arq->rxBase, IPC_MAX_SEQ - ARQ_WINDOW))];
+
+    f->state = ARQ_FREE;
+    f->nak   = false;
+
+    arq->rxBase = IPC_INC_SEQ(arq->rxBase);
+
+    arq->stats.rxFrames++;
+}
+
+/* Find when the oldest frame held behind a missing one will have waited
+ * IPC_ARQ_HOLD ms. Returns false if none are held.
+ */
+static bool Expiry(IPC_ARQ* arq, uint32_t* when)
+{
+    IPC_ARQ_FRAME* f;
+    uint32_t oldest = 0;
+    bool held = false;
+    int i;
+
+    if (!arq->rxSynced || (arq->rx[ARQ_INDEX(arq->rxBase)].state == ARQ_HELD))
+        return false;
+
+    for (i=1; i < ARQ_WINDOW; i++)
+    {
+        f = &arq->rx[ARQ_INDEX(Seq(arq->rxBase, i))];
+
+        if (f->state != ARQ_HELD)
+            continue;
+
+        if (!held || Before(f->time, oldest))
+            oldest = f->time;
+
+        held = true;
+    }
+
+    if (held)
+        *when = oldest + IPC_ARQ_HOLD;
+
+    return held;
+}
+
+/* Return a frame kept */
+static void Copy(IPC_ARQ_FRAME* f, IPC_FCB* fcb, void* text, uint16_t* textlen)
+{
+    fcb->type   = f->type;
+    fcb->acknak = f->acknak;
+    fcb->rsvd   = 0;
+
+    if (text && f->textlen)
+        memcpy(text, f->text, f->textlen);
+
+    *textlen = f->textlen;
+}
+
+/* End-Of-File */
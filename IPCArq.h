@@ -0,0 +1,130 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _IPCARQ_H_
+#define _IPCARQ_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "IPCFrameDefs.h"
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Set to 1 to run selective repeat ARQ on the IPC link. Both ends must
+ * agree. The deployed DTC firmware sends unsequenced datagrams and never
+ * ACKs, so with the ARQ on against it every frame is sent IPC_ARQ_TRIES
+ * times, the window fills and IPC_Message_post() stalls its callers.
+ * On a noisy line the ARQ trades lost frames for long stalls, a p99
+ * latency near 1 s at a bit error rate of 1e-3 in arqbench.
+ */
+#ifndef IPC_ARQ_ENABLED
+#define IPC_ARQ_ENABLED         0
+#endif
+
+/* Largest message text held for resending */
+#define IPC_ARQ_TEXT_MAX        16
+
+/* Times a frame is sent before it is given up on */
+#define IPC_ARQ_TRIES           5
+
+/* Retransmit timeout in ms, before the first round trip is measured and
+ * the limits it is kept between. It is doubled for a frame resent.
+ */
+#define IPC_ARQ_RTO_INIT        100
+#define IPC_ARQ_RTO_MIN         20
+#define IPC_ARQ_RTO_MAX         500
+
+/* ms frames received after a missing frame are held for it. This must be
+ * longer than the sender takes to give up on a frame.
+ */
+#define IPC_ARQ_HOLD            3000
+
+/* IPCArq_due() with nothing to wait for */
+#define IPC_ARQ_IDLE            0xFFFFFFFF
+
+/* IPCArq_rxFrame() results */
+typedef enum _IPC_ARQ_RX {
+    IPC_ARQ_CONTROL,            /* ACK/NAK only frame, nothing to deliver */
+    IPC_ARQ_DELIVER,            /* unsequenced frame, deliver as received */
+    IPC_ARQ_QUEUED,             /* taken, deliver with IPCArq_rxNext()    */
+    IPC_ARQ_DUPLICATE,          /* already received, ACKed again          */
+    IPC_ARQ_REJECTED,           /* text too long to hold                  */
+} IPC_ARQ_RX;
+
+/*** IPC ARQ DATA **********************************************************/
+
+/* A frame sent or received, kept by its sequence number */
+typedef struct _IPC_ARQ_FRAME {
+    uint8_t     state;
+    uint8_t     tries;              /* times sent                   */
+    uint8_t     type;
+    uint8_t     acknak;
+    uint16_t    textlen;
+    bool        nak;                /* NAK received or sent for it  */
+    uint32_t    time;               /* ms first sent or received    */
+    uint32_t    due;                /* ms resend due                */
+    uint8_t     text[IPC_ARQ_TEXT_MAX];
+} IPC_ARQ_FRAME;
+
+typedef struct _IPC_ARQ_STATS {
+    uint32_t    txFrames;           /* frames sent the first time   */
+    uint32_t    txResent;           /* frames sent again            */
+    uint32_t    txTimeouts;         /* resent for a timeout         */
+    uint32_t    txNaks;             /* resent for a NAK             */
+    uint32_t    txFailed;           /* frames given up on           */
+    uint32_t    txAcks;             /* ACK/NAK only frames sent     */
+    uint32_t    rxFrames;           /* frames delivered             */
+    uint32_t    rxDuplicates;       /* frames received again        */
+    uint32_t    rxHeld;             /* frames received out of order */
+    uint32_t    rxSkipped;          /* missing frames given up on   */
+    uint32_t    rttSamples;
+    uint32_t    rttMax;             /* longest round trip in ms     */
+} IPC_ARQ_STATS;
+
+typedef struct _IPC_ARQ {
+    uint8_t     txBase;             /* oldest frame not ACKed       */
+    uint8_t     txNext;             /* next sequence number to send */
+    uint8_t     txCount;            /* frames in the send window    */
+    uint8_t     txFreed;            /* window slots freed           */
+    uint8_t     rxBase;             /* next frame to deliver        */
+    uint8_t     rxSkipTo;           /* frames before it are skipped */
+    bool        rxSynced;           /* peer sequence known          */
+    uint32_t    ackMask;            /* ACKs to send, bit seq-1      */
+    uint32_t    nakMask;            /* NAKs to send                 */
+    uint32_t    lateMask;           /* frames from before the sync  */
+    uint32_t    srtt;               /* smoothed round trip, ms x 8  */
+    uint32_t    rttvar;             /* round trip variation, ms x 4 */
+    uint32_t    rto;                /* retransmit timeout in ms     */
+    IPC_ARQ_FRAME tx[IPC_MAX_SEQ];
+    IPC_ARQ_FRAME rx[IPC_MAX_SEQ];
+    IPC_ARQ_STATS stats;
+} IPC_ARQ;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void IPCArq_init(IPC_ARQ* arq);
+
+bool IPCArq_reserve(IPC_ARQ* arq, IPC_FCB* fcb, const void* text, uint16_t textlen);
+void IPCArq_sent(IPC_ARQ* arq, uint8_t seqnum, uint32_t now);
+uint8_t IPCArq_freed(IPC_ARQ* arq);
+
+int IPCArq_rxFrame(IPC_ARQ* arq, const IPC_FCB* fcb, const void* text, uint16_t textlen,
+                   uint32_t now);
+void IPCArq_rxError(IPC_ARQ* arq);
+bool IPCArq_rxNext(IPC_ARQ* arq, IPC_FCB* fcb, void* text, uint16_t* textlen, uint32_t now);
+
+bool IPCArq_poll(IPC_ARQ* arq, uint32_t now, IPC_FCB* fcb, void* text, uint16_t* textlen);
+uint32_t IPCArq_due(IPC_ARQ* arq, uint32_t now);
+
+#endif  /* _IPCARQ_H_ */
@@ -145,6 +145,8 @@ IPCCMD_Handle IPCCMD_construct(
     IPC_FrameInit(&(obj->txFCB));
     IPC_FrameInit(&(obj->rxFCB));
 
+    FrameParse_init(&(obj->rxParser), FRAME_IPC, obj->rxFrame, sizeof(obj->rxFrame));
+
     /* Initialize object data members */
 #if (IPCCMD_THREAD_SAFE > 0)
     GateMutex_construct(&(obj->gate), NULL);
@@ -243,7 +245,7 @@ int IPCCMD_Transaction(
     if (rc == IPC_ERR_SUCCESS)
     {
         /* Try to read ack/nak response back */
-        rc = IPC_FrameRx(handle->uartHandle, &(handle->rxFCB), reply, &(reply->length));
+        rc = IPC_FrameRx(handle->uartHandle, &(handle->rxParser), &(handle->rxFCB), reply, &(reply->length));
 
         if (rc == IPC_ERR_SUCCESS)
         {
@@ -279,7 +281,7 @@ int IPCCMD_ReadMessage(
 #endif
 
     /* Try to read ack/nak response back */
-    rc = IPC_FrameRx(handle->uartHandle, &(handle->rxFCB), request, &(request->length));
+    rc = IPC_FrameRx(handle->uartHandle, &(handle->rxParser), &(handle->rxFCB), request, &(request->length));
 
 #if (IPCCMD_THREAD_SAFE > 0)
     GateMutex_leave(GateMutex_handle(&(handle->gate)), key);
@@ -69,6 +69,8 @@ typedef struct IPCCMD_Object {
     UART_Handle      	uartHandle;         /* handle for SPI object   */
     IPC_FCB             txFCB;
     IPC_FCB             rxFCB;
+    FRAME_PARSER        rxParser;           /* rx frame parser         */
+    uint8_t             rxFrame[IPC_FRAME_MAX];
 #if (IPCCMD_THREAD_SAFE > 0)
     GateMutex_Struct    gate;
 #endif
@@ -203,6 +203,44 @@ Bool Transport_GetMode(uint32_t* mode, uint32_t* speed)
     return TRUE;
 }
 
+Bool Transport_GetVelocity(float* velocity)
+{
+    IPC_MSG msgTx;
+    IPC_MSG msgRx;
+
+    msgTx.type     = IPC_TYPE_TRANSPORT;
+    msgTx.opcode   = OP_TRANSPORT_GET_VELOCITY;
+    msgTx.param1.U = 0;
+    msgTx.param2.U = 0;
+
+    if (!IPC_Transaction(&msgTx, &msgRx, IPC_TIMEOUT))
+        return FALSE;
+
+    /* return current servo velocity */
+    *velocity = msgRx.param1.F;
+
+    return TRUE;
+}
+
+Bool Transport_GetTach(float* tach)
+{
+    IPC_MSG msgTx;
+    IPC_MSG msgRx;
+
+    msgTx.type     = IPC_TYPE_TRANSPORT;
+    msgTx.opcode   = OP_TRANSPORT_GET_TACH;
+    msgTx.param1.U = 0;
+    msgTx.param2.U = 0;
+
+    if (!IPC_Transaction(&msgTx, &msgRx, IPC_TIMEOUT))
+        return FALSE;
+
+    /* return current reel tach */
+    *tach = msgRx.param1.F;
+
+    return TRUE;
+}
+
 /*****************************************************************************
  * DTC-1200 CONFIGURATION PARAMETERS
  *****************************************************************************/
@@ -24,6 +24,8 @@ Bool Transport_RecExit(void);
 Bool Transport_Fwd(uint32_t velocity, uint32_t flags);
 Bool Transport_Rew(uint32_t velocity, uint32_t flags);
 Bool Transport_GetMode(uint32_t* mode, uint32_t* speed);
+Bool Transport_GetVelocity(float* velocity);
+Bool Transport_GetTach(float* tach);
 
 Bool Config_SetShuttleVelocity(uint32_t velocity);
 Bool Config_GetShuttleVelocity(uint32_t* velocity);
@@ -76,6 +76,11 @@
 
 #include "CRC16.h"
 #include "IPCFrame.h"
+#include "RAMP.h"
+#include "FrameBuild.h"
+
+/* Transmit frame buffer, guarded by g_semaIPCFrame */
+static uint8_t s_frame[IPC_FRAME_MAX];
 
 //*****************************************************************************
 //
@@ -103,10 +108,12 @@ void IPC_FrameInit(IPC_FCB* fcb)
 //
 // Name:        IPC_FrameRx()
 //
-// Synopsis:    int IPC_FrameRx(handle, fcb, txtbuf, txtlen)
+// Synopsis:    int IPC_FrameRx(handle, parser, fcb, txtbuf, txtlen)
 //
 //              UART_Handle handle  - UART handle
 //
+//              FRAME_PARSER* parser - Ptr to the port frame parser
+//
 //              IPC_FCB*    fcb     - Ptr to frame control block
 //
 //              void*       txtbuf  - Ptr to msg txt rx buffer
@@ -121,196 +128,88 @@ void IPC_FrameInit(IPC_FCB* fcb)
 //              Upon return, it contains the actual length of the message
 //              received. If no message or ACK only message, it contains zero.
 //
+//              The port is read through its frame parser, no further than
+//              the end of the frame being received, so a frame takes a few
+//              reads rather than one for each byte. Bad frames are counted
+//              in the parser stats and skipped, and receiving carries on
+//              until a good frame arrives or a read times out with no
+//              bytes. A frame cut short by the line going quiet, as one
+//              with a corrupt length would be, is dropped then.
+//
 // Return:      Returns IPC_ERR_SUCCESS on success, otherwise error code.
 //
 //*****************************************************************************
 
 int IPC_FrameRx(
-        UART_Handle handle,
-        IPC_FCB*    fcb,
-        void*       txtbuf,
-        uint16_t*   txtlen
+        UART_Handle     handle,
+        FRAME_PARSER*   parser,
+        IPC_FCB*        fcb,
+        void*           txtbuf,
+        uint16_t*       txtlen
         )
 {
-    int i;
     int rc = IPC_ERR_SUCCESS;
-    uint8_t b;
+    int n;
+    size_t room;
     uint8_t type;
-    uint16_t lsb;
-    uint16_t msb;
-    uint16_t framelen;
-    uint16_t rxcrc;
-    uint16_t crc = 0;
+    uint8_t* ptr;
+    FRAME_RX frame;
 
-    uint8_t *textbuf = txtbuf;
     uint16_t textlen = *txtlen;
 
     /* No message text bytes received yet */
     *txtlen = 0;
 
-    /* First, try to synchronize to 0x79 SOF byte */
+    /* Take any frame the parser already holds before reading more */
+    while (!FrameParse_next(parser, &frame))
+    {
+        room = FrameParse_space(parser, &ptr);
 
-    i = 0;
+        n = UART_read(handle, ptr, room);
 
-    do {
+        if (n > 0)
+            FrameParse_commit(parser, (size_t)n);
 
-        /* Read the preamble MSB for the frame start */
-        if (UART_read(handle, &b, 1) != 1)
-            return IPC_ERR_TIMEOUT;
+        /* Bytes still arriving, only a quiet line ends a frame early */
+        if (n > 0)
+            continue;
 
-        /* Garbage flood check, synch lost?? */
-        if (i++ > (IPC_FRAME_OVERHEAD + IPC_PREAMBLE_OVERHEAD + IPC_MAX_TEXT_LEN))
-            return IPC_ERR_SYNC;
+        /* Timed out, a frame may still be complete in the bytes read */
+        if (FrameParse_next(parser, &frame))
+            break;
 
-    } while (b != IPC_PREAMBLE_MSB);
+        /* Drop any frame cut short, a frame may have started inside it */
+        FrameParse_abort(parser);
 
-    /* We found the first 0x79 sequence, next byte
-     * has to be 0xFC for a valid SOF sequence.
-     */
+        if (FrameParse_next(parser, &frame))
+            break;
 
-    if (UART_read(handle, &b, 1) != 1)
         return IPC_ERR_TIMEOUT;
+    }
 
-    if (b != IPC_PREAMBLE_LSB)
-        return IPC_ERR_SYNC;
-
-    /* Got the preamble word */
-
-    /* CRC starts here, sum in the seed byte first */
-    crc = CRC16Update(crc, IPC_CRC_SEED_BYTE);
-
-    /* Read the Frame length (MSB) */
-    if (UART_read(handle, &b, 1) != 1)
-        return IPC_ERR_SHORT_FRAME;
-
-    crc = CRC16Update(crc, b);
-    msb = (uint16_t)b;
-
-    /* Read the Frame length (LSB) */
-    if (UART_read(handle, &b, 1) != 1)
-        return IPC_ERR_SHORT_FRAME;
-
-    crc = CRC16Update(crc, b);
-    lsb = (uint16_t)b;
-
-    /* Build and validate maximum frame length */
-    framelen = (size_t)((msb << 8) | lsb) & 0xFFFF;
-
-    if (framelen > IPC_MAX_FRAME_LEN)
-        return IPC_ERR_FRAME_LEN;
-
-    /* Read the Frame Type Byte */
-    if (UART_read(handle, &b, 1) != 1)
-        return IPC_ERR_SHORT_FRAME;
-
-    crc = CRC16Update(crc, b);
-    fcb->type = b;
-
-    /* Check for ACK/NAK only frame (type always 11H or 12H) */
+    fcb->type = frame.type;
+    fcb->acknak = frame.acknak;
 
     /* Get the frame type less any flag bits */
-    type = (fcb->type & IPC_TYPE_MASK);
+    type = (frame.type & IPC_TYPE_MASK);
 
+    /* An ACK/NAK only frame has no sequence number or text */
     if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
-    {
-        /* If ACK/NAK only, length must be ACK_FRAME_LEN */
-        if (framelen != IPC_ACK_FRAME_LEN)
-            return IPC_ERR_ACK_LEN;
-
-        /* Read the ACK/NAK Sequence Number */
-        if (UART_read(handle, &b, 1) != 1)
-            return IPC_ERR_SHORT_FRAME;
-
-        crc = CRC16Update(crc, b);
-        fcb->acknak = b;
-    }
-    else
-    {
-        /* It's a full IPC frame, continue decoding the rest of the frame */
-
-        /* Read the Frame Sequence Number */
-        if (UART_read(handle, &b, 1) != 1)
-            return IPC_ERR_SHORT_FRAME;
-
-        crc = CRC16Update(crc, b);
-        fcb->seqnum = b;
-
-        /* Read the ACK/NAK Sequence Number */
-        if (UART_read(handle, &b, 1) != 1)
-            return IPC_ERR_SHORT_FRAME;
-
-        crc = CRC16Update(crc, b);
-        fcb->acknak = b;
-
-        /* Read the Text length (MSB) */
-        if (UART_read(handle, &b, 1) != 1)
-            return IPC_ERR_SHORT_FRAME;
-
-        crc = CRC16Update(crc, b);
-        msb = (uint16_t)b;
-
-        /* Read the Text length (LSB) */
-        if (UART_read(handle, &b, 1) != 1)
-            return IPC_ERR_SHORT_FRAME;
-
-        crc = CRC16Update(crc, b);
-        lsb = (uint16_t)b;
-
-        /* Get the frame length received and validate it */
-        uint16_t rxtextlen = (size_t)((msb << 8) | lsb) & 0xFFFF;
-
-        /* Return the message text length received */
-        *txtlen = rxtextlen;
-
-        /* The text length should be the frame overhead minus the preamble overhead
-         * plus the text length specified in the received frame. If these don't match
-         * then we have either a packet data error or a malformed packet.
-         */
-        if (rxtextlen + (IPC_FRAME_OVERHEAD - IPC_PREAMBLE_OVERHEAD) != framelen)
-            return IPC_ERR_TEXT_LEN;
-
-        /* Read text data associated with the frame */
+        return IPC_ERR_SUCCESS;
 
-        for (i=0; i < rxtextlen; i++)
-        {
-            if (UART_read(handle, &b, 1) != 1)
-                return IPC_ERR_SHORT_FRAME;
+    fcb->seqnum = frame.seqnum;
 
-            /* update the CRC */
-            crc = CRC16Update(crc, b);
+    /* Return the message text length received */
+    *txtlen = frame.textlen;
 
-            /* If we overflow, continue reading the packet
-             * data, but don't store the data into the buffer.
-             */
-            if (i >= textlen)
-            {
-                rc = IPC_ERR_RX_OVERFLOW;
-                continue;
-            }
-
-            if (textbuf)
-                *textbuf++ = b;
-        }
-    }
-
-    /* Read the packet CRC MSB */
-    if (UART_read(handle, &b, 1) != 1)
-        return IPC_ERR_SHORT_FRAME;
-
-    msb = (uint16_t)b & 0xFF;
-
-    /* Read the packet CRC LSB */
-    if (UART_read(handle, &b, 1) != 1)
-        return IPC_ERR_SHORT_FRAME;
-
-    lsb = (uint16_t)b & 0xFF;
-
-    /* Build and validate the CRC */
-    rxcrc = (uint16_t)((msb << 8) | lsb) & 0xFFFF;
+    /* If we overflow, return as much of the text as fits */
+    if (frame.textlen > textlen)
+        rc = IPC_ERR_RX_OVERFLOW;
+    else
+        textlen = frame.textlen;
 
-    /* Validate the CRC values match */
-    if (rxcrc != crc)
-        rc = IPC_ERR_CRC;
+    if (txtbuf && textlen)
+        memcpy(txtbuf, frame.text, textlen);
 
     return rc;
 }
@@ -333,7 +232,8 @@ int IPC_FrameRx(
 //              pointed to by txtlen contains the number of message bytes
 //              to transmit. This will be reset to zero if an error occurs
 //              attempting to transmit the message or if an ACK only
-//              frame is sent.
+//              frame is sent. The frame is built in a buffer and written
+//              to the UART in one call.
 //
 // Return:      Returns IPC_ERR_SUCCESS on success, otherwise error code.
 //
@@ -346,127 +246,25 @@ int IPC_FrameTx(
         uint16_t    txtlen
         )
 {
-    uint8_t b;
-    uint8_t type;
-    uint16_t i;
-    uint16_t framelen;
-    uint16_t crc;
-
-    uint8_t *textbuf = txtbuf;
-    uint16_t textlen = txtlen;
+    int rc = IPC_ERR_SUCCESS;
+    size_t framelen;
 
     /* First check the text length is valid */
-    if (textlen > IPC_MAX_TEXT_LEN)
+    if (txtlen > IPC_MAX_TEXT_LEN)
         return IPC_ERR_TEXT_LEN;
 
-    /* Get the frame type less any flag bits */
-    type = (fcb->type & IPC_TYPE_MASK);
-
-    /* Are we sending a ACK or NAK only frame? */
-    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
-    {
-        textbuf = NULL;
-        textlen = 0;
-
-        framelen = IPC_ACK_FRAME_LEN;
-
-        /* Set the ACK/NAK flag bit */
-        fcb->type |= IPC_F_ACKNAK;
-    }
-    else
-    {
-        /* Build the frame length with text length given */
-        framelen = textlen + (IPC_FRAME_OVERHEAD - IPC_PREAMBLE_OVERHEAD);
-
-        /* If message is piggyback ACK/NAK, set flag bit also */
-        if ((type == IPC_MSG_ACK) || (type == IPC_MSG_NAK))
-            fcb->type |= IPC_F_ACKNAK;
-        else
-            fcb->type &= ~(IPC_F_ACKNAK);
-    }
-
-    /* Send the preamble MSB for the frame start */
-    b = IPC_PREAMBLE_MSB;
-    UART_write(handle, &b, 1);
-
-    /* Send the preamble LSB for the frame start */
-    b = IPC_PREAMBLE_LSB;
-    UART_write(handle, &b, 1);
-
-    /* CRC starts here, sum in the seed byte first */
-    crc = CRC16Update(0, IPC_CRC_SEED_BYTE);
-
-    /* Send the frame length (MSB) */
-    b = (uint8_t)((framelen >> 8) & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
-
-    /* Send the frame length (LSB) */
-    b = (uint8_t)(framelen & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
-
-    /* Send the frame type & flags byte */
-    b = (uint8_t)(fcb->type & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
+    /* The frame buffer is shared by the tasks sending on either port */
+    Semaphore_pend(g_semaIPCFrame, BIOS_WAIT_FOREVER);
 
-    /* Sending ACK or NAK only frame? */
+    /* Build the whole frame and send it in a single write */
+    framelen = IPC_FrameBuild(s_frame, fcb, txtbuf, txtlen);
 
-    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
-    {
-        /* Sending ACK/NAK frame only  */
+    if (UART_write(handle, s_frame, framelen) != (int)framelen)
+        rc = IPC_ERR_TIMEOUT;
 
-        b = (uint8_t)(fcb->acknak & 0xFF);
-        crc = CRC16Update(crc, b);
-        UART_write(handle, &b, 1);
-    }
-    else
-    {
-        /* Continue sending a full IPC frame */
-
-        /* Send the Frame Sequence Number */
-        b = (uint8_t)(fcb->seqnum & 0xFF);
-        crc = CRC16Update(crc, b);
-        UART_write(handle, &b, 1);
-
-        /* Send the ACK/NAK Sequence Number */
-        b = (uint8_t)(fcb->acknak & 0xFF);
-        crc = CRC16Update(crc, b);
-        UART_write(handle, &b, 1);
-
-        /* Send the Text length (MSB) */
-        b = (uint8_t)((textlen >> 8) & 0xFF);
-        crc = CRC16Update(crc, b);
-        UART_write(handle, &b, 1);
-
-        /* Send the Text length (LSB) */
-        b = (uint8_t)(textlen & 0xFF);
-        crc = CRC16Update(crc, b);
-        UART_write(handle, &b, 1);
-
-        /* Send any text data associated with the frame */
-
-        if (textbuf && textlen)
-        {
-            for (i=0; i < textlen; i++)
-            {
-                b = *textbuf++;
-                crc = CRC16Update(crc, b);
-                UART_write(handle, &b, 1);
-            }
-        }
-    }
-
-    /* Send the CRC MSB */
-    b = (uint8_t)(crc >> 8);
-    UART_write(handle, &b, 1);
+    Semaphore_post(g_semaIPCFrame);
 
-    /* Send the CRC LSB */
-    b = (uint8_t)(crc & 0xFF);
-    UART_write(handle, &b, 1);
-
-    return IPC_ERR_SUCCESS;
+    return rc;
 }
 
 // End-Of-File
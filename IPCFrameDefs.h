@@ -0,0 +1,95 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* IPC frame constants and the frame control block, kept apart from the
+ * UART frame functions so modules with no RTOS or driver dependencies can
+ * use them. The frame format is described in IPCFrame.h.
+ */
+
+#ifndef _IPCFRAMEDEFS_H_
+#define _IPCFRAMEDEFS_H_
+
+#include <stdint.h>
+
+/*** IPC Constants and Defines *********************************************/
+
+#define IPC_PREAMBLE_MSB        0x79        /* first byte of preamble SOF  */
+#define IPC_PREAMBLE_LSB        0xBA        /* second byte of preamble SOF */
+
+#define IPC_MAX_WINDOW          8           /* maximum window size         */
+
+#define IPC_PREAMBLE_OVERHEAD   4           /* preamble overhead (SOF+LEN) */
+#define IPC_HEADER_OVERHEAD     3           /* frame header overhead       */
+#define IPC_TEXT_OVERHEAD       2           /* text length overhead        */
+#define IPC_CRC_OVERHEAD        2           /* 16-bit CRC overhead         */
+#define IPC_FRAME_OVERHEAD      ( IPC_PREAMBLE_OVERHEAD + IPC_HEADER_OVERHEAD + \
+                                  IPC_TEXT_OVERHEAD + IPC_CRC_OVERHEAD )
+
+#define IPC_CRC_SEED_BYTE       0xAB
+
+#define IPC_MIN_SEQ             1           /* min/max frame sequence num   */
+#define IPC_MAX_SEQ             ( 3 * IPC_MAX_WINDOW )
+#define IPC_NULL_SEQ            ( (uint8_t)0 )
+
+#define IPC_ACK_FRAME_LEN       4
+#define IPC_MAX_TEXT_LEN        512
+#define IPC_MIN_FRAME_LEN       ( IPC_FRAME_OVERHEAD - IPC_PREAMBLE_OVERHEAD )
+#define IPC_MAX_FRAME_LEN       ( IPC_MIN_FRAME_LEN + IPC_MAX_TEXT_LEN )
+#define IPC_FRAME_MAX           ( IPC_FRAME_OVERHEAD + IPC_MAX_TEXT_LEN )
+
+#define IPC_INC_SEQ(n)          ( (uint8_t)((n >= IPC_MAX_SEQ) ? IPC_MIN_SEQ : n+1) )
+
+/* Frame Type Flag Bits (upper nibble) */
+#define IPC_F_ACKNAK            0x10        /* frame is ACK/NAK only frame */
+#define IPC_F_PRIORITY          0x20        /* high priority message frame */
+#define IPC_F_DATAGRAM          0x40        /* no ACK/NAK required         */
+#define IPC_F_ERROR             0x80        /* frame error flag bit        */
+
+#define IPC_FLAG_MASK           0xF0        /* flag mask is upper 4 bits   */
+
+/* Frame Type Code (lower nibble) */
+#define IPC_ACK_ONLY            1           /* ACK message frame only      */
+#define IPC_NAK_ONLY            2           /* NAK message frame only      */
+#define IPC_MSG_ONLY            3           /* message only frame          */
+#define IPC_MSG_ACK             4           /* piggyback message plus ACK  */
+#define IPC_MSG_NAK             5           /* piggyback message plus NAK  */
+#define IPC_MSG_USER            6           /* user defined message packet */
+
+#define IPC_TYPE_MASK           0x0F        /* type mask is lower 4 bits   */
+
+#define IPC_MAKETYPE(f, t)      ( (uint8_t)((f & 0xF0) | (t & 0x0F)) )
+
+/* Error Code Constants */
+#define IPC_ERR_SUCCESS         0
+#define IPC_ERR_TIMEOUT         1           /* comm port timeout     */
+#define IPC_ERR_SYNC            2           /* SOF frame sync error  */
+#define IPC_ERR_SHORT_FRAME     3           /* short rx-frame error  */
+#define IPC_ERR_RX_OVERFLOW     4           /* rx buffer overflow    */
+#define IPC_ERR_SEQ_NUM         5           /* bad sequence number   */
+#define IPC_ERR_FRAME_TYPE      6           /* invalid frame type    */
+#define IPC_ERR_FRAME_LEN       7           /* bad rx-frame length   */
+#define IPC_ERR_ACK_LEN         8           /* bad ACK/NAK frame len */
+#define IPC_ERR_TEXT_LEN        9           /* bad rx-text length    */
+#define IPC_ERR_ACKNAK_LEN      10          /* bad rx-text length    */
+#define IPC_ERR_CRC             11          /* rx-frame checksum bad */
+
+/* IPC Frame Control Block */
+
+typedef struct _IPC_FCB {
+    /* frame data */
+    uint8_t     type;                       /* frame type bits       */
+    uint8_t     seqnum;                     /* frame tx/rx seq#      */
+    uint8_t     acknak;                     /* frame ACK/NAK seq#    */
+    uint8_t     rsvd;                       /* keep on 32-bit align  */
+} IPC_FCB;
+
+#endif /* _IPCFRAMEDEFS_H_ */
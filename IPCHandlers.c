@@ -115,7 +115,11 @@ Bool IPC_Handle_transaction(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout)
     fcbReply.type    = MAKETYPE(IPC_F_ACKNAK, IPC_MSG_ACK);
     fcbReply.acknak  = fcb->seqnum;
     fcbReply.rsvd    = fcb->rsvd;
+#if (IPC_ARQ_ENABLED > 0)
+    fcbReply.seqnum  = IPC_NULL_SEQ;        /* numbered by the ARQ */
+#else
     fcbReply.seqnum  = IPC_GetTxSeqNum();
+#endif
 
     return IPC_Message_post(&msgReply, &fcbReply, timeout);
 }
@@ -163,8 +167,17 @@ Bool IPC_Handle_datagram(IPC_MSG* msg, IPC_FCB* fcb)
 
     case OP_NOTIFY_TRANSPORT:
         /* The DTC sends this notification with the current
-         * transport mode (stop, play, etc).
+         * transport mode (stop, play, etc). The time record goes
+         * on or off is noted for the auto punch timing, and each
+         * pass in record is logged as a take.
          */
+        if ((msg->param1.U ^ g_sys.transportMode) & M_RECORD)
+        {
+            g_sys.recordTime = Clock_getTicks();
+
+            TakeJournalRecord((msg->param1.U & M_RECORD) ? TRUE : FALSE);
+        }
+
         g_sys.transportMode = msg->param1.U;
 
         if (g_sys.transportMode & M_RECORD)
@@ -192,6 +205,9 @@ Bool IPC_Handle_datagram(IPC_MSG* msg, IPC_FCB* fcb)
         break;
     }
 
+    /* Publish any transport mode, speed or lamp change */
+    TransportState_publishMode();
+
     /* Signal the TCP worker a transport switch or LED state changed */
     Event_post(g_eventTransport, Event_Id_01);
 
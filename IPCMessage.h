@@ -38,8 +38,8 @@
 #define OP_MODE_REW_LIB             305
 
 #define OP_TRANSPORT_GET_MODE       320     /* get current transport mode */
-#define OP_TRANSPORT_GET_VELOCITY   321
-#define OP_TRANSPORT_GET_TACH       322
+#define OP_TRANSPORT_GET_VELOCITY   321     /* param1.F = servo velocity  */
+#define OP_TRANSPORT_GET_TACH       322     /* param1.F = reel tach       */
 
 /*** DTC CONSTANTS AND FLAGS ***********************************************/
 
@@ -55,6 +55,7 @@
 /* BIOS Header files */
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
@@ -80,13 +81,38 @@
 #include "IPCServer.h"
 #include "Board.h"
 
+/* Reader UART timeout in ms. A frame the line goes quiet in for this long
+ * is dropped, and frames held by the ARQ are checked at least this often.
+ */
+#define IPC_READ_TIMEOUT        10
+
+/* Longest the worker task waits before checking for async transactions
+ * timed out, so one started while it waits is timed out close to time.
+ */
+#define IPC_TRANS_POLL          50
+
 /* Global Data Items */
 IPCSVR_OBJECT g_ipc;
 
+/* Receive frame buffer, only used by the reader task */
+static uint8_t s_rxFrame[IPC_FRAME_MAX];
+
 /* Static Function Prototypes */
 static Void IPCReaderTaskFxn(UArg a0, UArg a1);
 static Void IPCWriterTaskFxn(UArg arg0, UArg arg1);
 static Void IPCWorkerTaskFxn(UArg arg0, UArg arg1);
+static Bool Post(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout, Int slot);
+static void Deliver(IPC_FCB* fcb, IPC_MSG* msg);
+static Int TransOpen(IPC_TRANS_FXN fxn, void* arg, UInt32 timeout);
+static Bool TransPost(IPC_MSG* msgTx, Int slot, UInt32 timeout);
+static void TransClose(Int slot);
+static void TransReply(IPC_FCB* fcb, IPC_MSG* msg);
+static UInt32 TransExpire(void);
+#if (IPC_ARQ_ENABLED > 0)
+static void ArqReceive(int rc, IPC_FCB* fcb, IPC_MSG* msg, uint16_t rxlen);
+static UInt32 ArqSend(void);
+static uint32_t ArqRelease(void);
+#endif
 
 //*****************************************************************************
 // This function initializes the IPC server and creates all it's worker
@@ -112,8 +138,28 @@ Bool IPC_Server_init(void)
     g_ipc.rxFreeSem = Semaphore_create(IPC_MAX_WINDOW, NULL, NULL);
     g_ipc.rxDataSem = Semaphore_create(0, NULL, NULL);
 
+    /* One completion semaphore for each transaction slot */
+    g_ipc.transFreeSem = Semaphore_create(IPC_TRANS_MAX, NULL, NULL);
+
+    for (i=0; i < IPC_TRANS_MAX; i++)
+        g_ipc.transSem[i] = Semaphore_create(0, NULL, NULL);
+
+    Error_init(&eb);
+    g_ipc.transGate = GateMutex_create(NULL, &eb);
+
+    if (g_ipc.transGate == NULL)
+        System_abort("Transaction gate create failed");
+
+#if (IPC_ARQ_ENABLED > 0)
+    /* Frames are kept until ACKed, a window of them at most */
+    g_ipc.txWinSem  = Semaphore_create(IPC_MAX_WINDOW, NULL, NULL);
+
     Error_init(&eb);
-    g_ipc.ackEvent  = Event_create(NULL, NULL);
+    g_ipc.arqGate   = GateMutex_create(NULL, &eb);
+
+    if (g_ipc.arqGate == NULL)
+        System_abort("ARQ gate create failed");
+#endif
 
     //g_ipc.datagramHandlerFxn    = NULL;
     //g_ipc.transactionHandlerFxn = NULL;
@@ -154,17 +200,6 @@ Bool IPC_Server_init(void)
         Queue_enqueue(g_ipc.rxFreeQue, (Queue_Elem*)msg);
     }
 
-    /*
-     * Allocate and ACK RECEIVE Buffer Memory
-     */
-
-    Error_init(&eb);
-
-    g_ipc.ackBuf = (IPC_ACK*)Memory_alloc(NULL, sizeof(IPC_ACK) * IPC_MAX_WINDOW, 0, &eb);
-
-    if (g_ipc.ackBuf == NULL)
-        System_abort("AckBuf allocation failed");
-
     /* Initialize Server Data Items */
 
     g_ipc.txErrors      = 0;
@@ -178,6 +213,16 @@ Bool IPC_Server_init(void)
     g_ipc.rxLastSeq     = 0;                /* last seq# accepted   */
     g_ipc.rxExpectedSeq = IPC_MIN_SEQ;      /* expected recv seq#   */
 
+    FrameParse_init(&g_ipc.rxParser, FRAME_IPC, s_rxFrame, sizeof(s_rxFrame));
+
+    IPCTrans_init(&g_ipc.trans);
+
+#if (IPC_ARQ_ENABLED > 0)
+    g_ipc.rxBadFrames   = 0;
+
+    IPCArq_init(&g_ipc.arq);
+#endif
+
     return TRUE;
 }
 
@@ -195,7 +240,7 @@ Bool IPC_Server_startup(void)
 
     uartParams.readMode       = UART_MODE_BLOCKING;
     uartParams.writeMode      = UART_MODE_BLOCKING;
-    uartParams.readTimeout    = 2000;                   // 1 second read timeout
+    uartParams.readTimeout    = IPC_READ_TIMEOUT;
     uartParams.writeTimeout   = BIOS_WAIT_FOREVER;
     uartParams.readCallback   = NULL;
     uartParams.writeCallback  = NULL;
@@ -314,10 +359,25 @@ Bool IPC_Message_pend(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout)
 //*****************************************************************************
 
 Bool IPC_Message_post(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout)
+{
+    return Post(msg, fcb, timeout, -1);
+}
+
+/* Post a message, keying the transaction slot given, if any, on its
+ * sequence number before the frame can go out.
+ */
+static Bool Post(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout, Int slot)
 {
     UInt key;
+    IArg gate;
     IPC_ELEM* elem;
 
+#if (IPC_ARQ_ENABLED > 0)
+    /* Wait for room in the send window, frames are kept until ACKed */
+    if (!Semaphore_pend(g_ipc.txWinSem, timeout))
+        return FALSE;
+#endif
+
     /* Wait for a free transmit buffer and timeout if necessary */
     if (Semaphore_pend(g_ipc.txFreeSem, timeout))
     {
@@ -331,6 +391,9 @@ Bool IPC_Message_post(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout)
         if (elem == (IPC_ELEM*)(g_ipc.txFreeQue))
         {
             Hwi_restore(key);
+#if (IPC_ARQ_ENABLED > 0)
+            Semaphore_post(g_ipc.txWinSem);
+#endif
             return FALSE;
         }
 
@@ -344,6 +407,25 @@ Bool IPC_Message_post(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout)
         memcpy(&(elem->msg), msg, sizeof(IPC_MSG));
         memcpy(&(elem->fcb), fcb, sizeof(IPC_FCB));
 
+#if (IPC_ARQ_ENABLED > 0)
+        /* Number the frame and keep a copy to resend, the window slot
+         * pended for makes sure there is room. The caller gets the
+         * sequence number back in its FCB.
+         */
+        gate = GateMutex_enter(g_ipc.arqGate);
+        IPCArq_reserve(&g_ipc.arq, &(elem->fcb), &(elem->msg), sizeof(IPC_MSG));
+        GateMutex_leave(g_ipc.arqGate, gate);
+
+        fcb->seqnum = elem->fcb.seqnum;
+#endif
+
+        if (slot >= 0)
+        {
+            gate = GateMutex_enter(g_ipc.transGate);
+            IPCTrans_start(&g_ipc.trans, slot, elem->fcb.seqnum);
+            GateMutex_leave(g_ipc.transGate, gate);
+        }
+
         /* put message on txDataQueue */
         if (fcb->type & IPC_F_PRIORITY)
             Queue_putHead(g_ipc.txDataQue, (Queue_Elem *)elem);
@@ -356,6 +438,10 @@ Bool IPC_Message_post(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout)
         return TRUE;          /* success */
     }
 
+#if (IPC_ARQ_ENABLED > 0)
+    Semaphore_post(g_ipc.txWinSem);
+#endif
+
     return FALSE;         /* error */
 }
 
@@ -368,17 +454,39 @@ Void IPCWriterTaskFxn(UArg arg0, UArg arg1)
 {
     UInt key;
     IPC_ELEM* elem;
+#if (IPC_ARQ_ENABLED > 0)
+    IArg gate;
+#endif
 
     /* Begin the packet transmit task loop */
 
     while (TRUE)
     {
+#if (IPC_ARQ_ENABLED > 0)
+        /* Send any ACKs, NAKs and resends due, then wait for a packet in
+         * the tx queue or until the next of them is due.
+         */
+        if (!Semaphore_pend(g_ipc.txDataSem, ArqSend()))
+            continue;
+
+        /* The reader may wake us with only ACKs to send */
+        if (Queue_empty(g_ipc.txDataQue))
+            continue;
+#else
         /* Wait for a packet in the tx queue */
         Semaphore_pend(g_ipc.txDataSem, BIOS_WAIT_FOREVER);
+#endif
 
         /* Get the message from txDataQue */
         elem = Queue_get(g_ipc.txDataQue);
 
+#if (IPC_ARQ_ENABLED > 0)
+        /* Start its retransmit timer */
+        gate = GateMutex_enter(g_ipc.arqGate);
+        IPCArq_sent(&g_ipc.arq, elem->fcb.seqnum, Clock_getTicks());
+        GateMutex_leave(g_ipc.arqGate, gate);
+#endif
+
         /* Transmit the packet! */
 
         IPC_FrameTx(g_ipc.uartHandle, &(elem->fcb), &(elem->msg), sizeof(IPC_MSG));
@@ -408,82 +516,40 @@ Void IPCWriterTaskFxn(UArg arg0, UArg arg1)
 // buffer queue for processing messages from the peer. The rxDataSem
 // semaphore is signaled to indicate data is available to the IPCServer
 // task that dispatches all the messages between the two peer nodes.
+// With the ARQ, frames go through it to be ACKed and delivered in order,
+// and the read timeout wakes the task to deliver frames held too long.
 //*****************************************************************************
 
 Void IPCReaderTaskFxn(UArg arg0, UArg arg1)
 {
     int rc;
     uint16_t rxlen;
-    UInt key;
-    IPC_ELEM* elem;
+    IPC_FCB fcb;
+    IPC_MSG msg;
 
     /* Begin the packet receive task loop */
 
     while (TRUE)
     {
-        /* Wait for a free receive buffer if necessary */
-        if (!Semaphore_pend(g_ipc.rxFreeSem, 1000))
-        {
-            /* See if any packets have not been ACK'ed
-             * and re-send if necessary.
-             */
-            continue;
-        }
+        /* Attempt to read a frame from the peer */
+        rxlen = sizeof(IPC_MSG);
+        rc = IPC_FrameRx(g_ipc.uartHandle, &g_ipc.rxParser, &fcb, &msg, &rxlen);
 
-        /* perform the dequeue and decrement numFreeMsgs atomically */
-        key = Hwi_disable();
-
-        /* get a rx buffer from the free queue */
-        elem = Queue_dequeue(g_ipc.rxFreeQue);
-
-        /* Make sure that a valid pointer was returned. */
-        if (elem == (IPC_ELEM*)(g_ipc.rxFreeQue))
+        if (rc > IPC_ERR_TIMEOUT)
         {
-            Hwi_restore(key);
-            continue;
-        }
-
-        /* decrement the numFreeMsgs */
-        g_ipc.rxNumFreeMsgs--;
-
-        /* re-enable ints */
-        Hwi_restore(key);
-
-        /* Buffer allocated, wait for a packet from peer */
+            g_ipc.rxErrors++;
 
-        while (1)
-        {
-            /* Attempt to read a frame from the peer */
-            rxlen = sizeof(IPC_MSG);
-            rc = IPC_FrameRx(g_ipc.uartHandle, &(elem->fcb), &(elem->msg), &rxlen);
-
-            /* Zero means packet received successfully */
-            if (rc == 0)
-                break;
-
-            if (rc > IPC_ERR_TIMEOUT)
-            {
-                g_ipc.rxErrors++;
-
-                System_printf("IPC RxError %d\n", rc);
-                System_flush();
-            }
+            System_printf("IPC RxError %d\n", rc);
+            System_flush();
         }
 
-        /* Packet received, save the sequence number received */
-        g_ipc.rxLastSeq = elem->fcb.seqnum;
-
-        /* Increment the total packets received count */
-        g_ipc.rxCount++;
-
-        /*Put message on rxDataQueue */
-        if (elem->fcb.type & IPC_F_PRIORITY)
-            Queue_putHead(g_ipc.rxDataQue, (Queue_Elem*)elem);
-        else
-            Queue_put(g_ipc.rxDataQue, (Queue_Elem*)elem);
-
-        /* post the semaphore */
-        Semaphore_post(g_ipc.rxDataSem);
+#if (IPC_ARQ_ENABLED > 0)
+        ArqReceive(rc, &fcb, &msg, rxlen);
+#else
+        /* Zero means packet received successfully */
+        if (rc == 0)
+            Deliver(&fcb, &msg);
+#endif
     }
 }
 
@@ -498,17 +564,12 @@ Void IPCWorkerTaskFxn(UArg arg0, UArg arg1)
 
     while (1)
     {
-        /* Wait for a IPC message from peer */
+        /* Wait for a IPC message from peer, or for an async
+         * transaction to time out.
+         */
 
-        if (!IPC_Message_pend(&msg, &fcb, 1000))
-        {
-            /* Timeout, no message received, check to see if we have
-             * any messages with ACK pending that haven't been
-             * acknowledge yet. If so, then retransmit until
-             * for max number of retries.
-             */
+        if (!IPC_Message_pend(&msg, &fcb, TransExpire()))
             continue;
-        }
 
         /* We've received a valid IPC message frame. Check the
          * message type received as follows:
@@ -533,27 +594,10 @@ Void IPCWorkerTaskFxn(UArg arg0, UArg arg1)
         }
         else if ((fcb.type & IPC_TYPE_MASK) == IPC_MSG_ACK)
         {
-            /* Handle MSG+ACK response from peer */
-
-            uint8_t acknak = fcb.acknak;
-
-            if ((acknak < IPC_MIN_SEQ) || (acknak > IPC_MAX_SEQ))
-            {
-                System_printf("IPC invalid ACK seqnum\n");
-                System_flush();
-                continue;
-            }
-
-            size_t index = (size_t)((acknak - 1) % IPC_MAX_WINDOW);
-
-            /* Save the reply MSG+ACK in the ACK buffer */
-            memcpy(&g_ipc.ackBuf[index].msg, &msg, sizeof(IPC_MSG));
-
-            /* Notify any pending transactions blocked that a MSG+ACK was received */
-
-            UInt mask = Event_Id_00 << index;
-
-            Event_post(g_ipc.ackEvent, mask);
+            /* Handle MSG+ACK response from peer, completing the
+             * transaction waiting on it.
+             */
+            TransReply(&fcb, &msg);
         }
     }
 }
@@ -575,62 +619,335 @@ Bool IPC_Notify(IPC_MSG* msg, UInt32 timeout)
 }
 
 //*****************************************************************************
-//
+// Send a transaction request to the peer and block until its MSG+ACK reply
+// arrives or the timeout expires. Each reply wakes only the task waiting
+// on it, so any number of tasks can wait on transactions at once, up to
+// IPC_TRANS_MAX. The reply is returned in msgRx.
 //*****************************************************************************
 
 Bool IPC_Transaction(IPC_MSG* msgTx, IPC_MSG* msgRx, UInt32 timeout)
 {
-    IPC_FCB fcb;
+    Int slot;
+    IArg gate;
+    Bool done;
 
-    memset(msgRx, 0, sizeof(IPC_MSG));
+    if (msgRx)
+        memset(msgRx, 0, sizeof(IPC_MSG));
 
-    fcb.type    = IPC_MAKETYPE(IPC_F_ACKNAK, IPC_MSG_ONLY);
-    fcb.acknak  = 0;
-    fcb.seqnum  = IPC_GetTxSeqNum();
-    fcb.rsvd    = 0;
-
-    size_t index = (fcb.seqnum - 1) % IPC_MAX_WINDOW;
-
-    g_ipc.ackBuf[index].flags  = 0x01;          /* ACK pending flag */
-    g_ipc.ackBuf[index].retry  = 5;
-    g_ipc.ackBuf[index].acknak = fcb.seqnum;
-    g_ipc.ackBuf[index].type   = fcb.type;
+    if ((slot = TransOpen(NULL, NULL, timeout)) < 0)
+        return FALSE;
 
     /* post the message to the transmit queue. We use the
      * transmit sequence number as our unique identifier
      * in the received message to locate the corresponding
      * response packet when it's received later by the
-     * reader task.
+     * worker task.
      */
 
-    if (!IPC_Message_post(msgTx, &fcb, timeout))
+    if (!TransPost(msgTx, slot, timeout))
     {
-        /* ACK no longer pending */
-        g_ipc.ackBuf[index].flags = 0x00;
+        TransClose(slot);
         return FALSE;
     }
 
-    /* Now block until we timeout or the selected bit fires */
-    UInt events = Event_pend(g_ipc.ackEvent, Event_Id_NONE, 0xFFFF, timeout);
+    /* Now block until we timeout or our reply arrives */
+    Semaphore_pend(g_ipc.transSem[slot], timeout);
+
+    gate = GateMutex_enter(g_ipc.transGate);
+
+    /* The reply may have come in as the wait timed out */
+    if ((done = IPCTrans_done(&g_ipc.trans, slot)) && msgRx)
+        memcpy(msgRx, g_ipc.trans.slot[slot].reply, sizeof(IPC_MSG));
 
-    if (events)
+    GateMutex_leave(g_ipc.transGate, gate);
+
+    TransClose(slot);
+
+    return done;
+}
+
+//*****************************************************************************
+// Send a transaction request without waiting on the reply. The callback is
+// called once from the IPC worker task, with the reply as an IPC_MSG or
+// with IPC_TRANS_TIMEOUT if none arrives within the timeout, and must not
+// block. Returns FALSE, with no callback, if the request could not be
+// posted within the timeout.
+//*****************************************************************************
+
+Bool IPC_TransactionAsync(IPC_MSG* msgTx, IPC_TRANS_FXN fxn, void* arg, UInt32 timeout)
+{
+    Int slot;
+
+    if ((slot = TransOpen(fxn, arg, timeout)) < 0)
+        return FALSE;
+
+    if (!TransPost(msgTx, slot, timeout))
     {
-        /* ACK no longer pending */
-        g_ipc.ackBuf[index].flags = 0x00;
+        TransClose(slot);
+        return FALSE;
+    }
 
-        /* Return reply in the callers buffer */
-        if (msgRx)
-        {
-            msgRx->type   = g_ipc.ackBuf[index].msg.type;
-            msgRx->opcode = g_ipc.ackBuf[index].msg.opcode;
-            msgRx->param1 = g_ipc.ackBuf[index].msg.param1;
-            msgRx->param2 = g_ipc.ackBuf[index].msg.param2;
-        }
+    return TRUE;
+}
 
-        return TRUE;
+/* Put a message received on the rx queue for the worker task, waiting for
+ * a free receive buffer if necessary.
+ */
+static void Deliver(IPC_FCB* fcb, IPC_MSG* msg)
+{
+    UInt key;
+    IPC_ELEM* elem;
+
+    /* Wait for a free receive buffer */
+    Semaphore_pend(g_ipc.rxFreeSem, BIOS_WAIT_FOREVER);
+
+    /* perform the dequeue and decrement numFreeMsgs atomically */
+    key = Hwi_disable();
+
+    /* get a rx buffer from the free queue */
+    elem = Queue_dequeue(g_ipc.rxFreeQue);
+
+    /* Make sure that a valid pointer was returned. */
+    if (elem == (IPC_ELEM*)(g_ipc.rxFreeQue))
+    {
+        Hwi_restore(key);
+        return;
     }
 
-    return FALSE;
+    /* decrement the numFreeMsgs */
+    g_ipc.rxNumFreeMsgs--;
+
+    /* re-enable ints */
+    Hwi_restore(key);
+
+    memcpy(&(elem->fcb), fcb, sizeof(IPC_FCB));
+    memcpy(&(elem->msg), msg, sizeof(IPC_MSG));
+
+    /* Packet received, save the sequence number received */
+    g_ipc.rxLastSeq = elem->fcb.seqnum;
+
+    /* Increment the total packets received count */
+    g_ipc.rxCount++;
+
+    /*Put message on rxDataQueue */
+    if (elem->fcb.type & IPC_F_PRIORITY)
+        Queue_putHead(g_ipc.rxDataQue, (Queue_Elem*)elem);
+    else
+        Queue_put(g_ipc.rxDataQue, (Queue_Elem*)elem);
+
+    /* post the semaphore */
+    Semaphore_post(g_ipc.rxDataSem);
+}
+
+/* Wait for a free transaction slot and open it. Returns -1 on a timeout */
+static Int TransOpen(IPC_TRANS_FXN fxn, void* arg, UInt32 timeout)
+{
+    Int slot;
+    IArg key;
+
+    if (!Semaphore_pend(g_ipc.transFreeSem, timeout))
+        return -1;
+
+    key = GateMutex_enter(g_ipc.transGate);
+    slot = IPCTrans_open(&g_ipc.trans, fxn, arg, Clock_getTicks(), timeout);
+    GateMutex_leave(g_ipc.transGate, key);
+
+    /* Clear a completion posted after its last waiter gave up */
+    Semaphore_reset(g_ipc.transSem[slot], 0);
+
+    return slot;
+}
+
+/* Post the request frame for a transaction slot */
+static Bool TransPost(IPC_MSG* msgTx, Int slot, UInt32 timeout)
+{
+    IPC_FCB fcb;
+
+    fcb.type    = IPC_MAKETYPE(IPC_F_ACKNAK, IPC_MSG_ONLY);
+    fcb.acknak  = 0;
+#if (IPC_ARQ_ENABLED > 0)
+    fcb.seqnum  = IPC_NULL_SEQ;                 /* numbered by the ARQ */
+#else
+    fcb.seqnum  = IPC_GetTxSeqNum();
+#endif
+    fcb.rsvd    = 0;
+
+    return Post(msgTx, &fcb, timeout, slot);
+}
+
+/* Free a transaction slot */
+static void TransClose(Int slot)
+{
+    IArg key;
+
+    key = GateMutex_enter(g_ipc.transGate);
+    IPCTrans_close(&g_ipc.trans, slot);
+    GateMutex_leave(g_ipc.transGate, key);
+
+    Semaphore_post(g_ipc.transFreeSem);
+}
+
+/* Complete the transaction a MSG+ACK reply answers, waking its task or
+ * calling its callback. A reply to one given up on is dropped.
+ */
+static void TransReply(IPC_FCB* fcb, IPC_MSG* msg)
+{
+    Int slot;
+    IArg key;
+    IPC_TRANS_FXN fxn = NULL;
+    void* arg = NULL;
+
+    key = GateMutex_enter(g_ipc.transGate);
+
+    if ((slot = IPCTrans_reply(&g_ipc.trans, fcb->acknak, msg, sizeof(IPC_MSG))) >= 0)
+    {
+        fxn = g_ipc.trans.slot[slot].fxn;
+        arg = g_ipc.trans.slot[slot].arg;
+
+        /* Wake the waiter while the slot is still its own. The gate keeps
+         * the post ahead of the slot being closed and opened again, which
+         * clears a post its waiter missed.
+         */
+        if (!fxn)
+            Semaphore_post(g_ipc.transSem[slot]);
+    }
+
+    GateMutex_leave(g_ipc.transGate, key);
+
+    if ((slot < 0) || !fxn)
+        return;
+
+    fxn(arg, IPC_TRANS_OK, msg, sizeof(IPC_MSG));
+
+    TransClose(slot);
+}
+
+/* Call back the async transactions timed out. Returns the ticks for the
+ * worker task to wait until the next may have.
+ */
+static UInt32 TransExpire(void)
+{
+    Int slot;
+    IArg key;
+    IPC_TRANS_FXN fxn;
+    void* arg;
+    uint32_t due = IPC_TRANS_FOREVER;
+
+    while (1)
+    {
+        key = GateMutex_enter(g_ipc.transGate);
+
+        if ((slot = IPCTrans_expire(&g_ipc.trans, Clock_getTicks())) < 0)
+            due = IPCTrans_due(&g_ipc.trans, Clock_getTicks());
+
+        fxn = (slot >= 0) ? g_ipc.trans.slot[slot].fxn : NULL;
+        arg = (slot >= 0) ? g_ipc.trans.slot[slot].arg : NULL;
+
+        GateMutex_leave(g_ipc.transGate, key);
+
+        if (slot < 0)
+            break;
+
+        fxn(arg, IPC_TRANS_TIMEOUT, NULL, 0);
+
+        TransClose(slot);
+    }
+
+    return (due < IPC_TRANS_POLL) ? (UInt32)due : IPC_TRANS_POLL;
+}
+
+#if (IPC_ARQ_ENABLED > 0)
+
+/* Pass a frame read, or a read that timed out, to the ARQ and deliver the
+ * messages it has ready in sequence order.
+ */
+static void ArqReceive(int rc, IPC_FCB* fcb, IPC_MSG* msg, uint16_t rxlen)
+{
+    IArg gate;
+    Bool ready;
+    uint32_t bad;
+    int result = IPC_ARQ_CONTROL;
+
+    gate = GateMutex_enter(g_ipc.arqGate);
+
+    /* A frame failing its CRC may have been the one expected next */
+    bad = g_ipc.rxParser.stats.crc + g_ipc.rxParser.stats.length;
+
+    if (bad != g_ipc.rxBadFrames)
+    {
+        g_ipc.rxBadFrames = bad;
+        IPCArq_rxError(&g_ipc.arq);
+    }
+
+    if (rc == IPC_ERR_SUCCESS)
+        result = IPCArq_rxFrame(&g_ipc.arq, fcb, msg, rxlen, Clock_getTicks());
+
+    GateMutex_leave(g_ipc.arqGate, gate);
+
+    /* A frame from a peer without the ARQ */
+    if (result == IPC_ARQ_DELIVER)
+        Deliver(fcb, msg);
+
+    do {
+        gate = GateMutex_enter(g_ipc.arqGate);
+        ready = IPCArq_rxNext(&g_ipc.arq, fcb, msg, &rxlen, Clock_getTicks());
+        GateMutex_leave(g_ipc.arqGate, gate);
+
+        if (ready)
+            Deliver(fcb, msg);
+    } while (ready);
+
+    /* Wake the writer to send the ACKs and NAKs queued */
+    if (ArqRelease() == 0)
+        Semaphore_post(g_ipc.txDataSem);
+}
+
+/* Send the ACKs, NAKs and resends due. Returns the ticks until the next is
+ * due, for the writer task to wait on.
+ */
+static UInt32 ArqSend(void)
+{
+    IArg gate;
+    Bool send;
+    uint16_t len;
+    uint32_t due;
+    IPC_FCB fcb;
+    IPC_MSG msg;
+
+    do {
+        gate = GateMutex_enter(g_ipc.arqGate);
+        send = IPCArq_poll(&g_ipc.arq, Clock_getTicks(), &fcb, &msg, &len);
+        GateMutex_leave(g_ipc.arqGate, gate);
+
+        if (send)
+            IPC_FrameTx(g_ipc.uartHandle, &fcb, &msg, len);
+    } while (send);
+
+    due = ArqRelease();
+
+    return (due == IPC_ARQ_IDLE) ? BIOS_WAIT_FOREVER : (UInt32)due;
 }
 
+/* Give back the send window slots freed by ACKs and frames given up on.
+ * Returns the ms until the ARQ next has something to send.
+ */
+static uint32_t ArqRelease(void)
+{
+    IArg gate;
+    uint8_t freed;
+    uint32_t due;
+
+    gate = GateMutex_enter(g_ipc.arqGate);
+    freed = IPCArq_freed(&g_ipc.arq);
+    due = IPCArq_due(&g_ipc.arq, Clock_getTicks());
+    GateMutex_leave(g_ipc.arqGate, gate);
+
+    while (freed--)
+        Semaphore_post(g_ipc.txWinSem);
+
+    return due;
+}
+
+#endif
+
 // End-Of-File
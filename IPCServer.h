@@ -13,6 +13,8 @@
 #include "CRC16.h"
 #include "IPCFrame.h"
 #include "IPCMessage.h"
+#include "IPCArq.h"
+#include "IPCTrans.h"
 
 /*** IPC MESSAGE STRUCTURE *************************************************/
 
@@ -39,14 +41,6 @@ typedef struct _IPC_ELEM {
     IPC_MSG     msg;
 } IPC_ELEM;
 
-typedef struct _IPC_ACK {
-    uint8_t     flags;
-    uint8_t     acknak;
-    uint8_t     retry;
-    uint8_t     type;
-    IPC_MSG     msg;
-} IPC_ACK;
-
 /*** IPC MESSAGE SERVER OBJECT *********************************************/
 
 typedef struct _IPCSVR_OBJECT {
@@ -56,7 +50,6 @@ typedef struct _IPCSVR_OBJECT {
     Queue_Handle        txDataQue;
     Semaphore_Handle    txDataSem;
     Semaphore_Handle    txFreeSem;
-    Event_Handle        ackEvent;
     /* rx queues and semaphores */
     Queue_Handle        rxFreeQue;
     Queue_Handle        rxDataQue;
@@ -72,13 +65,25 @@ typedef struct _IPCSVR_OBJECT {
     uint32_t            rxCount;
     uint8_t             rxExpectedSeq;		/* expected recv seq#   */
     uint8_t             rxLastSeq;       	/* last seq# accepted   */
+    FRAME_PARSER        rxParser;           /* rx frame parser      */
+#if (IPC_ARQ_ENABLED > 0)
+    /* selective repeat ARQ state */
+    Semaphore_Handle    txWinSem;           /* send window slots    */
+    GateMutex_Handle    arqGate;
+    uint32_t            rxBadFrames;        /* parser errors seen   */
+    IPC_ARQ             arq;
+#endif
+    /* transactions waiting on replies */
+    GateMutex_Handle    transGate;
+    Semaphore_Handle    transFreeSem;       /* free table slots     */
+    Semaphore_Handle    transSem[IPC_TRANS_MAX];
+    IPC_TRANS_TABLE     trans;
     /* callback handlers */
     //Bool (*datagramHandlerFxn)(IPC_MSG* msg, IPC_FCB* fcb);
     //Bool (*transactionHandlerFxn)(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout);
     /* frame memory buffers */
     IPC_ELEM*           txBuf;
     IPC_ELEM*           rxBuf;
-    IPC_ACK*            ackBuf;
 } IPCSVR_OBJECT;
 
 /*** IPC FUNCTION PROTOTYPES ***********************************************/
@@ -99,5 +104,6 @@ Bool IPC_Message_pend(IPC_MSG* msg, IPC_FCB* fcb, UInt32 timeout);
 /* High level functions to send messages */
 Bool IPC_Notify(IPC_MSG* msg, UInt32 timeout);
 Bool IPC_Transaction(IPC_MSG* msgTx, IPC_MSG* msgRx, UInt32 timeout);
+Bool IPC_TransactionAsync(IPC_MSG* msgTx, IPC_TRANS_FXN fxn, void* arg, UInt32 timeout);
 
 #endif /* _IPCTASK_H_ */
@@ -0,0 +1,242 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Table of IPC transactions waiting on a reply. A transaction takes a slot
+ * before its request is posted and is keyed on the request sequence
+ * number once the frame has one. The peer's MSG+ACK reply carries that
+ * number in its ACK/NAK field, so a reply is matched to the one slot
+ * waiting on it, and any number of tasks can have requests in flight.
+ *
+ * A slot is completed either by a task waiting on it, or by the callback
+ * given when it was opened, for a request made without waiting. Callback
+ * slots time out here, waiters time out their own wait and close the
+ * slot. A reply arriving after its slot has closed is dropped.
+ *
+ * The sequence number is the only tag a frame carries back, so a reply
+ * held up until IPC_MAX_SEQ more requests had been sent could be taken for
+ * a newer request given the same number.
+ *
+ * The module keeps the table only, the IPC server locks it and wakes the
+ * waiters. Times are in ms and there are no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "IPCTrans.h"
+
+/* Slot states */
+#define TRANS_FREE              0
+#define TRANS_OPEN              1       /* request not yet numbered */
+#define TRANS_PENDING           2       /* waiting on the reply */
+#define TRANS_DONE              3       /* reply received */
+#define TRANS_EXPIRED           4       /* timed out, callback due */
+
+/* Static Function Prototypes */
+static bool Before(uint32_t a, uint32_t b);
+
+//*****************************************************************************
+// Start with no transactions open.
+//*****************************************************************************
+
+void IPCTrans_init(IPC_TRANS_TABLE* tbl)
+{
+    memset(tbl, 0, sizeof(IPC_TRANS_TABLE));
+}
+
+//*****************************************************************************
+// Take a slot for a transaction about to be posted. The callback is NULL
+// for a task that waits on the reply itself. Returns the slot, or -1 if
+// all are in use.
+//*****************************************************************************
+
+int IPCTrans_open(IPC_TRANS_TABLE* tbl, IPC_TRANS_FXN fxn, void* arg, uint32_t now,
+                  uint32_t timeout)
+{
+    IPC_TRANS* t;
+    int i;
+
+    for (i=0; i < IPC_TRANS_MAX; i++)
+    {
+        t = &tbl->slot[i];
+
+        if (t->state != TRANS_FREE)
+            continue;
+
+        t->state    = TRANS_OPEN;
+        t->seqnum   = IPC_NULL_SEQ;
+        t->replylen = 0;
+        t->timeout  = timeout;
+        t->deadline = now + timeout;
+        t->fxn      = fxn;
+        t->arg      = arg;
+
+        tbl->open++;
+        tbl->stats.opened++;
+
+        if (tbl->open > tbl->stats.peak)
+            tbl->stats.peak = tbl->open;
+
+        return i;
+    }
+
+    return -1;
+}
+
+//*****************************************************************************
+// Key a slot on the sequence number its request frame was given. This must
+// be done before the frame can be sent, or the reply could beat it.
+//*****************************************************************************
+
+void IPCTrans_start(IPC_TRANS_TABLE* tbl, int slot, uint8_t seqnum)
+{
+    IPC_TRANS* t = &tbl->slot[slot];
+
+    t->seqnum = seqnum;
+    t->state  = TRANS_PENDING;
+}
+
+//*****************************************************************************
+// Free a slot once its reply has been taken or it has timed out.
+//*****************************************************************************
+
+void IPCTrans_close(IPC_TRANS_TABLE* tbl, int slot)
+{
+    IPC_TRANS* t = &tbl->slot[slot];
+
+    if (t->state == TRANS_FREE)
+        return;
+
+    if (t->state != TRANS_DONE)
+        tbl->stats.timeouts++;
+
+    t->state = TRANS_FREE;
+
+    tbl->open--;
+}
+
+//*****************************************************************************
+// Match a MSG+ACK reply to the transaction waiting on it and keep its text.
+// Returns the slot completed, or -1 if no one is waiting on it any longer.
+//*****************************************************************************
+
+int IPCTrans_reply(IPC_TRANS_TABLE* tbl, uint8_t acknak, const void* text, uint16_t textlen)
+{
+    IPC_TRANS* t;
+    int i;
+
+    if (acknak != IPC_NULL_SEQ)
+    {
+        for (i=0; i < IPC_TRANS_MAX; i++)
+        {
+            t = &tbl->slot[i];
+
+            if ((t->state != TRANS_PENDING) || (t->seqnum != acknak))
+                continue;
+
+            if (textlen > IPC_TRANS_TEXT_MAX)
+                textlen = IPC_TRANS_TEXT_MAX;
+
+            if (text && textlen)
+                memcpy(t->reply, text, textlen);
+
+            t->replylen = textlen;
+            t->state    = TRANS_DONE;
+
+            tbl->stats.completed++;
+
+            return i;
+        }
+    }
+
+    tbl->stats.late++;
+
+    return -1;
+}
+
+//*****************************************************************************
+// Returns true if the reply for a slot has arrived.
+//*****************************************************************************
+
+bool IPCTrans_done(IPC_TRANS_TABLE* tbl, int slot)
+{
+    return (tbl->slot[slot].state == TRANS_DONE);
+}
+
+//*****************************************************************************
+// Return a callback slot whose timeout has passed with no reply, for its
+// callback to be called and the slot closed. Returns -1 if there are none.
+//*****************************************************************************
+
+int IPCTrans_expire(IPC_TRANS_TABLE* tbl, uint32_t now)
+{
+    IPC_TRANS* t;
+    int i;
+
+    for (i=0; i < IPC_TRANS_MAX; i++)
+    {
+        t = &tbl->slot[i];
+
+        if ((t->state != TRANS_PENDING) || !t->fxn || (t->timeout == IPC_TRANS_FOREVER))
+            continue;
+
+        if (Before(now, t->deadline))
+            continue;
+
+        t->state = TRANS_EXPIRED;
+
+        return i;
+    }
+
+    return -1;
+}
+
+//*****************************************************************************
+// Return the ms until the next callback slot times out, zero if one has,
+// or IPC_TRANS_FOREVER if none can.
+//*****************************************************************************
+
+uint32_t IPCTrans_due(IPC_TRANS_TABLE* tbl, uint32_t now)
+{
+    IPC_TRANS* t;
+    uint32_t when = 0;
+    bool waiting = false;
+    int i;
+
+    for (i=0; i < IPC_TRANS_MAX; i++)
+    {
+        t = &tbl->slot[i];
+
+        if ((t->state != TRANS_PENDING) || !t->fxn || (t->timeout == IPC_TRANS_FOREVER))
+            continue;
+
+        if (!waiting || Before(t->deadline, when))
+            when = t->deadline;
+
+        waiting = true;
+    }
+
+    if (!waiting)
+        return IPC_TRANS_FOREVER;
+
+    return Before(now, when) ? (when - now) : 0;
+}
+
+/* Compare ms times across the wrap */
+static bool Before(uint32_t a, uint32_t b)
+{
+    return ((int32_t)(a - b) < 0);
+}
+
+/* End-Of-File */
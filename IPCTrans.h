@@ -0,0 +1,86 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _IPCTRANS_H_
+#define _IPCTRANS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "IPCFrameDefs.h"
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Transactions that can wait on a reply at once, one for each frame the
+ * send window holds.
+ */
+#define IPC_TRANS_MAX           IPC_MAX_WINDOW
+
+/* Largest reply text kept */
+#define IPC_TRANS_TEXT_MAX      16
+
+/* A timeout that never expires, and IPCTrans_due() with none to expire */
+#define IPC_TRANS_FOREVER       0xFFFFFFFF
+
+/* Completion status passed to a transaction callback */
+#define IPC_TRANS_OK            0           /* reply received           */
+#define IPC_TRANS_TIMEOUT       1           /* no reply in the timeout  */
+
+/* Called once when an async transaction completes. The reply is NULL on a
+ * timeout.
+ */
+typedef void (*IPC_TRANS_FXN)(void* arg, int status, const void* reply, uint16_t replylen);
+
+/*** IPC TRANSACTION TABLE *************************************************/
+
+typedef struct _IPC_TRANS {
+    uint8_t         state;
+    uint8_t         seqnum;             /* request sequence number, the key */
+    uint16_t        replylen;
+    uint32_t        deadline;           /* ms an async request times out    */
+    uint32_t        timeout;            /* ms, or IPC_TRANS_FOREVER         */
+    IPC_TRANS_FXN   fxn;                /* callback, or NULL for a waiter   */
+    void*           arg;
+    uint8_t         reply[IPC_TRANS_TEXT_MAX];
+} IPC_TRANS;
+
+typedef struct _IPC_TRANS_STATS {
+    uint32_t        opened;             /* transactions started         */
+    uint32_t        completed;          /* replies matched              */
+    uint32_t        timeouts;           /* given up with no reply       */
+    uint32_t        late;               /* replies no one waited on     */
+    uint32_t        peak;               /* most open at once            */
+} IPC_TRANS_STATS;
+
+typedef struct _IPC_TRANS_TABLE {
+    uint32_t        open;               /* slots in use                 */
+    IPC_TRANS       slot[IPC_TRANS_MAX];
+    IPC_TRANS_STATS stats;
+} IPC_TRANS_TABLE;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void IPCTrans_init(IPC_TRANS_TABLE* tbl);
+
+int IPCTrans_open(IPC_TRANS_TABLE* tbl, IPC_TRANS_FXN fxn, void* arg, uint32_t now,
+                  uint32_t timeout);
+void IPCTrans_start(IPC_TRANS_TABLE* tbl, int slot, uint8_t seqnum);
+void IPCTrans_close(IPC_TRANS_TABLE* tbl, int slot);
+
+int IPCTrans_reply(IPC_TRANS_TABLE* tbl, uint8_t acknak, const void* text, uint16_t textlen);
+bool IPCTrans_done(IPC_TRANS_TABLE* tbl, int slot);
+
+int IPCTrans_expire(IPC_TRANS_TABLE* tbl, uint32_t now);
+uint32_t IPCTrans_due(IPC_TRANS_TABLE* tbl, uint32_t now);
+
+#endif  /* _IPCTRANS_H_ */
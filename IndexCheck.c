@@ -0,0 +1,191 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Timer roller index pulse check. The roller encoder gives one index pulse
+ * per revolution at the same roller angle every time, so the encoder count
+ * at each index pulse should always be the same modulo the ticks per
+ * revolution. A count that has moved is an encoder miscount, usually from
+ * a quadrature phase error, and it stays in the position until corrected.
+ * Checking the phase at each index pulse is the same as checking that
+ * ROLLER_TICKS_PER_REV ticks were counted between index pulses, but it
+ * also works when the tape changes direction between index pulses.
+ *
+ * The index edge is seen at a slightly different angle in each direction,
+ * so the index phase is learned separately for forward and reverse.
+ *
+ * The caller gives the raw encoder count, unwrapped but without any
+ * corrections made to the tape position. Corrections returned are for the
+ * caller to apply to the tape position. The module has no RTOS
+ * dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "TapeTime.h"
+#include "IndexCheck.h"
+
+/* Static Function Prototypes */
+static bool Vote(int32_t* hist, uint32_t count, int32_t* value);
+static int32_t Phase(int32_t ticks);
+static int32_t Wrap(int32_t ticks);
+
+//*****************************************************************************
+// Initialize the index check and clear the statistics.
+//*****************************************************************************
+
+void IndexCheck_init(INDEX_CHECK* ic)
+{
+    memset(&ic->stats, 0, sizeof(INDEX_STATS));
+
+    IndexCheck_reset(ic);
+}
+
+//*****************************************************************************
+// Start over after the encoder count has been reset. The index phase is
+// learned again from the next index pulses.
+//*****************************************************************************
+
+void IndexCheck_reset(INDEX_CHECK* ic)
+{
+    ic->refValid[0] = false;
+    ic->refValid[1] = false;
+    ic->ref[0]      = 0;
+    ic->ref[1]      = 0;
+    ic->refCount[0] = 0;
+    ic->refCount[1] = 0;
+    ic->count       = 0;
+    ic->shift       = 0;
+    ic->applied     = 0;
+}
+
+//*****************************************************************************
+// Check the raw encoder count at an index pulse. Returns the number of
+// ticks to add to the tape position to correct any miscount, or zero.
+//*****************************************************************************
+
+int32_t IndexCheck_update(INDEX_CHECK* ic, int32_t raw, int32_t direction)
+{
+    int32_t dir = (direction > 0) ? 0 : 1;
+    int32_t error;
+    int32_t observed;
+    int32_t correction;
+
+    ic->stats.revolutions++;
+
+    /* Learn the index phase for this direction. Any miscount already
+     * confirmed is taken out so both directions agree on the miscount.
+     */
+    if (!ic->refValid[dir])
+    {
+        ic->refHist[dir][ic->refCount[dir]++ % INDEX_WINDOW] = Phase(raw - ic->shift);
+
+        if (Vote(ic->refHist[dir], ic->refCount[dir], &ic->ref[dir]))
+            ic->refValid[dir] = true;
+
+        return 0;
+    }
+
+    /* Ticks the index has moved since the last confirmed miscount */
+    error = Wrap(Wrap(Phase(raw) - ic->ref[dir]) - Wrap(ic->shift));
+
+    ic->stats.lastError = error;
+
+    if (error)
+        ic->stats.miscounts++;
+
+    /* Reject an index pulse too far out to be an encoder miscount */
+    if ((error > INDEX_MAX_ERROR) || (error < -INDEX_MAX_ERROR))
+    {
+        ic->stats.faults++;
+        return 0;
+    }
+
+    ic->hist[ic->count++ % INDEX_WINDOW] = ic->shift + error;
+
+    if (!Vote(ic->hist, ic->count, &observed))
+        return 0;
+
+    ic->shift = observed;
+
+    /* Ticks needed to take out the total miscount */
+    correction = -ic->shift - ic->applied;
+
+    if (correction)
+    {
+        ic->applied += correction;
+        ic->stats.corrections++;
+        ic->stats.ticksCorrected += (correction < 0) ? -correction : correction;
+    }
+
+    return correction;
+}
+
+//*****************************************************************************
+// Look for a value that at least INDEX_VOTES of the last INDEX_WINDOW
+// entries in the history agree on. Returns false if there isn't one.
+//*****************************************************************************
+
+static bool Vote(int32_t* hist, uint32_t count, int32_t* value)
+{
+    uint32_t i, j;
+    uint32_t votes;
+
+    if (count < INDEX_WINDOW)
+        return false;
+
+    for (i=0; i <= (INDEX_WINDOW - INDEX_VOTES); i++)
+    {
+        votes = 0;
+
+        for (j=0; j < INDEX_WINDOW; j++)
+        {
+            if (hist[j] == hist[i])
+                votes++;
+        }
+
+        if (votes >= INDEX_VOTES)
+        {
+            *value = hist[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//*****************************************************************************
+// Return the encoder ticks modulo one revolution (0 to TICKS_PER_REV-1).
+//*****************************************************************************
+
+static int32_t Phase(int32_t ticks)
+{
+    int32_t phase = ticks % ROLLER_TICKS_PER_REV;
+
+    if (phase < 0)
+        phase += ROLLER_TICKS_PER_REV;
+
+    return phase;
+}
+
+//*****************************************************************************
+// Return the encoder ticks as the shortest way around one revolution,
+// from -TICKS_PER_REV/2 to TICKS_PER_REV/2-1.
+//*****************************************************************************
+
+static int32_t Wrap(int32_t ticks)
+{
+    return Phase(ticks + (ROLLER_TICKS_PER_REV / 2)) - (ROLLER_TICKS_PER_REV / 2);
+}
+
+/* End-Of-File */
@@ -0,0 +1,63 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _INDEXCHECK_H_
+#define _INDEXCHECK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Largest miscount in encoder ticks accepted for one revolution of the
+ * roller. Anything larger is taken to be a bad index pulse and ignored.
+ */
+#define INDEX_MAX_ERROR         8
+
+/* A miscount is only corrected once at least INDEX_VOTES of the last
+ * INDEX_WINDOW index pulses agree on it. The index phase for each
+ * direction is learned the same way. This keeps interrupt latency
+ * jitter on the index sample from being taken as a miscount.
+ */
+#define INDEX_WINDOW            5
+#define INDEX_VOTES             4
+
+/*** INDEX CHECK DATA ******************************************************/
+
+typedef struct _INDEX_STATS {
+    uint32_t    revolutions;    /* index pulses checked             */
+    uint32_t    miscounts;      /* revolutions with a tick miscount */
+    uint32_t    corrections;    /* corrections made to the position */
+    uint32_t    ticksCorrected; /* total ticks corrected            */
+    uint32_t    faults;         /* index pulses rejected            */
+    int32_t     lastError;      /* ticks off on the last revolution */
+} INDEX_STATS;
+
+typedef struct _INDEX_CHECK {
+    bool        refValid[2];    /* index phase learned fwd/rew      */
+    int32_t     ref[2];         /* index phase fwd/rew              */
+    int32_t     refHist[2][INDEX_WINDOW]; /* phases seen learning   */
+    uint32_t    refCount[2];    /* index pulses seen learning       */
+    int32_t     hist[INDEX_WINDOW]; /* recent miscounts observed    */
+    uint32_t    count;          /* index pulses observed            */
+    int32_t     shift;          /* confirmed miscount in ticks      */
+    int32_t     applied;        /* ticks of correction handed out   */
+    INDEX_STATS stats;
+} INDEX_CHECK;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void IndexCheck_init(INDEX_CHECK* ic);
+void IndexCheck_reset(INDEX_CHECK* ic);
+int32_t IndexCheck_update(INDEX_CHECK* ic, int32_t raw, int32_t direction);
+
+#endif  /* _INDEXCHECK_H_ */
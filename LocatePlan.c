@@ -0,0 +1,833 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Locate planner. The planner keeps a simple model of the transport for
+ * each direction: the speed reached at each jog velocity, the shuttle
+ * acceleration, the braking rate in each speed band and the delay from a
+ * command to the transport responding. From the model it works out which
+ * jog velocity gets to the cue point soonest and the point to start
+ * braking so the servo speed is reached just short of the cue point. The
+ * approach servo then takes the tape the rest of the way onto the cue
+ * point under position control.
+ *
+ * Each phase of a locate is measured against the model as it runs and the
+ * model is moved a little toward what was measured, so the planner tracks
+ * each machine and the reels on it. The model is kept in the config so it
+ * is saved along with the other settings.
+ *
+ * The planner runs in inches and seconds and has no RTOS dependencies.
+ * The locator calls it with each new position and carries out the
+ * transport commands it returns.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "ApproachServo.h"
+#include "LocatePlan.h"
+
+/* Static Function Prototypes */
+static float Remaining(LOCATE_PLAN* plan, int32_t pos);
+static float ShuttleDist(LOCATE_PLAN* plan, float v);
+static float Travel(LOCATE_PLAN* plan, int32_t pos);
+static float Brake(const STC_LOCATE_MODEL* model, int32_t dir, float v1, float v2, float* time);
+static float BrakeTime(const STC_LOCATE_MODEL* model, int32_t dir, float v1, float v2);
+static float BrakeDist(const STC_LOCATE_MODEL* model, int32_t dir, float v, float v1);
+static float Response(const STC_LOCATE_MODEL* model, int32_t dir, float v, float vt);
+static float CommandDist(const STC_LOCATE_MODEL* model, int32_t dir, float v, float vt, float v1);
+static float ApproachDist(void);
+static float ApproachTime(const STC_LOCATE_MODEL* model, int32_t dir);
+static float ProfileTime(const STC_LOCATE_MODEL* model, int32_t dir, float vc, float v0, float dist);
+static float Eta(LOCATE_PLAN* plan, float v, float rem, uint32_t now);
+static void ServoBegin(const STC_LOCATE_MODEL* model, int32_t dir, APPROACH_SERVO* servo,
+                       float dist, float v0, float scale, uint32_t now);
+static float ServoTime(const STC_LOCATE_MODEL* model, int32_t dir, float v0, float dist);
+static PLAN_ACTION Approach(LOCATE_PLAN* plan, int32_t pos, float velocity, uint32_t now);
+static PLAN_ACTION Servo(LOCATE_PLAN* plan, int32_t pos, float velocity, uint32_t now);
+static void PhaseBegin(LOCATE_PLAN* plan, PLAN_PHASE phase, int32_t pos, float v, uint32_t now);
+static void PhaseResponse(LOCATE_PLAN* plan, float vt);
+static PLAN_ACTION Settled(LOCATE_PLAN* plan, int32_t pos, uint32_t now, bool timeout);
+static bool Learn(float* value, float sample, float lo, float hi);
+static void LearnBrake(STC_LOCATE_MODEL* model, int32_t dir, float v0, float v1, float dist);
+
+//*****************************************************************************
+// Set the model to the defaults. These are on the slow side so the first
+// locates brake early rather than overshoot while the model is learned.
+//*****************************************************************************
+
+void LocatePlan_initModel(STC_LOCATE_MODEL* model)
+{
+    int32_t dir;
+    uint32_t band;
+
+    for (dir=PLAN_FWD; dir <= PLAN_REW; dir++)
+    {
+        model->cruise[dir][PLAN_SPEED_FAR]  = 300.0f;
+        model->cruise[dir][PLAN_SPEED_MID]  = 150.0f;
+        model->cruise[dir][PLAN_SPEED_NEAR] = 50.0f;
+        model->slow[dir]  = 50.0f;
+        model->accel[dir] = 100.0f;
+        model->lag[dir]   = 0.100f;
+
+        for (band=0; band < STC_PLAN_BANDS; band++)
+            model->decel[dir][band] = 150.0f;
+    }
+
+    /* Loop turns are sent late rather than early until learned */
+    for (band=0; band < STC_PLAN_BANDS; band++)
+        model->reverse[band] = 500.0f;
+
+    model->punch   = 0.050f;
+    model->spinup  = 6.0f;
+    model->locates = 0;
+}
+
+//*****************************************************************************
+// Start a plan to locate the cue point from the current position. The jog
+// and slow shuttle velocities are the DTC velocities to command. Returns
+// the first action to carry out.
+//*****************************************************************************
+
+PLAN_ACTION LocatePlan_begin(LOCATE_PLAN* plan, STC_LOCATE_MODEL* model,
+                             const uint32_t* jogVel, uint32_t slowVel,
+                             bool learn, float inchesPerTick,
+                             int32_t cue, int32_t pos, float velocity,
+                             uint32_t now)
+{
+    int32_t speed;
+    float dist;
+    float time;
+    float best;
+
+    plan->model         = model;
+    plan->learn         = learn;
+    plan->slowVel       = slowVel;
+    plan->inchesPerTick = inchesPerTick;
+    plan->cue           = cue;
+    plan->retries       = 0;
+    plan->reversals     = 0;
+    plan->overshoot     = false;
+
+    for (speed=0; speed < STC_PLAN_SPEEDS; speed++)
+        plan->jogVel[speed] = jogVel[speed];
+
+    plan->dir = (cue >= pos) ? PLAN_FWD : PLAN_REW;
+
+    dist = Remaining(plan, pos);
+
+    /* Pick the jog velocity that gets there soonest. On a tie the slower
+     * one is used, so short locates don't use the high speed shuttle.
+     */
+    plan->speed = PLAN_SPEED_NEAR;
+
+    best = LocatePlan_time(model, plan->dir, PLAN_SPEED_NEAR, dist);
+
+    for (speed=PLAN_SPEED_MID; speed >= PLAN_SPEED_FAR; speed--)
+    {
+        if ((time = LocatePlan_time(model, plan->dir, speed, dist)) < best)
+        {
+            best = time;
+            plan->speed = speed;
+        }
+    }
+
+    plan->eta       = best;
+    plan->startTime = now;
+    plan->fromRest  = (fabsf(velocity) < PLAN_STOPPED_VEL);
+    plan->reached   = false;
+    plan->peak      = 0.0f;
+
+    /* Go straight to the servo approach if the jog is no faster */
+    if (model->cruise[plan->dir][plan->speed] <= PLAN_SERVO_VEL)
+        return Approach(plan, pos, (plan->dir == PLAN_FWD) ? velocity : -velocity, now);
+
+    plan->velocity = plan->jogVel[plan->speed];
+    PhaseBegin(plan, PLAN_PHASE_SHUTTLE, pos, 0.0f, now);
+
+    return PLAN_SHUTTLE;
+}
+
+//*****************************************************************************
+// Update the plan with a new tape position and signed velocity in IPS.
+// Returns the action the locator should carry out.
+//*****************************************************************************
+
+PLAN_ACTION LocatePlan_update(LOCATE_PLAN* plan, int32_t pos, float velocity,
+                              uint32_t now)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+    int32_t dir = plan->dir;
+    PLAN_ACTION action;
+    float rem;
+    float vt;
+    float v;
+    float vc;
+    float v1 = PLAN_SERVO_VEL;
+    float t;
+
+    /* Distance left and speed toward the cue point */
+    rem = Remaining(plan, pos);
+
+    vt = (dir == PLAN_FWD) ? velocity : -velocity;
+    v  = (vt > 0.0f) ? vt : 0.0f;
+
+    switch(plan->phase)
+    {
+    case PLAN_PHASE_SHUTTLE:
+
+        vc = model->cruise[dir][plan->speed];
+
+        if (v > plan->peak)
+            plan->peak = v;
+
+        /* Measure the acceleration when the shuttle reaches speed */
+        if (!plan->reached && (v >= (vc * 0.9f)))
+        {
+            plan->reached   = true;
+            plan->reachTime = now;
+
+            t = ((float)(now - plan->startTime) * 0.001f) - model->lag[dir];
+
+            if (plan->learn && plan->fromRest && (t > 0.0f))
+                Learn(&model->accel[dir], v / t, PLAN_RATE_MIN, PLAN_RATE_MAX);
+        }
+
+        if (rem < 0.0f)
+        {
+            plan->overshoot = true;
+            PhaseBegin(plan, PLAN_PHASE_SETTLE, pos, v, now);
+            return PLAN_STOP;
+        }
+
+        if (rem > ShuttleDist(plan, v))
+            break;
+
+        /* Measure the cruise speed if it was held long enough. If it was
+         * never reached after twice the time it should have taken, the
+         * model is too fast so the highest speed seen is used.
+         */
+        if (plan->learn)
+        {
+            t = (float)(now - plan->startTime) * 0.001f;
+
+            if (plan->reached)
+            {
+                if ((float)(now - plan->reachTime) * 0.001f >= PLAN_CRUISE_HOLD)
+                    Learn(&model->cruise[dir][plan->speed], v, PLAN_VEL_MIN, PLAN_VEL_MAX);
+            }
+            else if (plan->fromRest && (t > (2.0f * (model->lag[dir] + (vc / model->accel[dir])))))
+            {
+                Learn(&model->cruise[dir][plan->speed], plan->peak, PLAN_VEL_MIN, PLAN_VEL_MAX);
+            }
+        }
+
+        if (v > v1)
+        {
+            PhaseBegin(plan, PLAN_PHASE_BRAKE, pos, v, now);
+            PhaseResponse(plan, vc);
+            plan->peak = v;
+            return PLAN_STOP;
+        }
+
+        return Approach(plan, pos, vt, now);
+
+    case PLAN_PHASE_BRAKE:
+
+        /* Measure the delay for the transport to respond to the stop.
+         * The times the speed is 2% and 10% down from the peak are taken
+         * back to where the speed first started to drop.
+         */
+        if (v > plan->peak)
+            plan->peak = v;
+
+        if (!plan->lagFound)
+        {
+            if (!plan->lagDrop && (v < (plan->peak * 0.98f)))
+            {
+                plan->lagDrop = true;
+                plan->lagTime = now;
+            }
+            else if (plan->lagDrop && (v < (plan->peak * 0.90f)))
+            {
+                plan->lagFound = true;
+
+                t = (float)(plan->lagTime - plan->phaseTime) -
+                    ((float)(now - plan->lagTime) * 0.25f);
+
+                if (plan->learn)
+                    Learn(&model->lag[dir], t * 0.001f, 0.0f, PLAN_LAG_MAX);
+            }
+        }
+
+        if (rem < 0.0f)
+        {
+            /* Already stopping, carry on and measure it as a full stop */
+            plan->overshoot = true;
+            plan->phase = PLAN_PHASE_SETTLE;
+            plan->steady = true;
+            plan->stillTime = now;
+            break;
+        }
+
+        if (v > v1)
+            break;
+
+        if (plan->learn)
+        {
+            LearnBrake(model, dir, plan->respVel, v, Travel(plan, pos) - plan->lagDist);
+        }
+
+        /* If there's no room left for the servo approach, let it stop.
+         * It is already braking so there's no delay for the transport.
+         */
+        if (rem <= (Brake(model, dir, 0.0f, v, NULL) + (v * PLAN_LOOKAHEAD)))
+        {
+            plan->phase = PLAN_PHASE_SETTLE;
+            plan->steady = true;
+            plan->stillTime = now;
+            break;
+        }
+
+        return Approach(plan, pos, vt, now);
+
+    case PLAN_PHASE_APPROACH:
+
+        /* The servo brings the tape back if it goes past */
+        if (rem < 0.0f)
+            plan->overshoot = true;
+
+        action = Servo(plan, pos, vt, now);
+
+        plan->eta = Eta(plan, v, rem, now);
+
+        return action;
+
+    case PLAN_PHASE_SETTLE:
+
+        if (fabsf(velocity) >= PLAN_STOPPED_VEL)
+            plan->stillTime = now;
+        else if ((now - plan->stillTime) >= PLAN_SETTLE_TIME)
+            return Settled(plan, pos, now, false);
+
+        if ((now - plan->phaseTime) >= PLAN_SETTLE_TIMEOUT)
+            return Settled(plan, pos, now, true);
+        break;
+
+    case PLAN_PHASE_DONE:
+    default:
+        plan->eta = 0.0f;
+        return PLAN_ARRIVED;
+    }
+
+    plan->eta = Eta(plan, v, rem, now);
+
+    return PLAN_NONE;
+}
+
+//*****************************************************************************
+// Return the ms from now until the plan must be updated again if no new
+// encoder sample comes in first. The speed is taken as held, so this is
+// when the predicted position reaches the next point the plan acts on or
+// a settle time runs out. The locator can sleep until then or until the
+// next position update.
+//*****************************************************************************
+
+uint32_t LocatePlan_deadline(LOCATE_PLAN* plan, int32_t pos, float velocity,
+                             uint32_t now)
+{
+    float t = (float)PLAN_DEADLINE_MAX * 0.001f;
+    float rem;
+    float v;
+    uint32_t ms = PLAN_DEADLINE_MAX;
+    uint32_t end;
+
+    rem = Remaining(plan, pos);
+    v = (plan->dir == PLAN_FWD) ? velocity : -velocity;
+
+    switch(plan->phase)
+    {
+    case PLAN_PHASE_SHUTTLE:
+        if (v > 0.0f)
+            t = (rem - ShuttleDist(plan, v)) / v;
+        break;
+
+    case PLAN_PHASE_BRAKE:
+        /* Braking ends on the speed, which only a new sample changes */
+        if (v > 0.0f)
+            t = rem / v;
+        break;
+
+    case PLAN_PHASE_APPROACH:
+        ms = ApproachServo_deadline(&plan->servo, Travel(plan, pos), v, now);
+        break;
+
+    case PLAN_PHASE_SETTLE:
+        end = plan->phaseTime + PLAN_SETTLE_TIMEOUT;
+
+        if (fabsf(velocity) < PLAN_STOPPED_VEL)
+        {
+            if ((int32_t)((plan->stillTime + PLAN_SETTLE_TIME) - end) < 0)
+                end = plan->stillTime + PLAN_SETTLE_TIME;
+        }
+
+        ms = ((int32_t)(end - now) > 0) ? (end - now) : 0;
+        break;
+
+    default:
+        return 0;
+    }
+
+    if (t <= 0.0f)
+        return 0;
+
+    if ((uint32_t)(t * 1000.0f) < ms)
+        ms = (uint32_t)(t * 1000.0f);
+
+    return (ms < PLAN_DEADLINE_MAX) ? ms : PLAN_DEADLINE_MAX;
+}
+
+//*****************************************************************************
+// Return the time in seconds the model gives to locate a cue point the
+// distance given in inches away using the jog velocity given, starting
+// from a stop.
+//*****************************************************************************
+
+float LocatePlan_time(const STC_LOCATE_MODEL* model, int32_t dir,
+                      uint32_t speed, float distance)
+{
+    return model->lag[dir] + ProfileTime(model, dir, model->cruise[dir][speed], 0.0f, distance);
+}
+
+//*****************************************************************************
+// The tape has stopped. Measure the stop against the model and either
+// finish or start the servo approach again if too far from the cue.
+//*****************************************************************************
+
+static PLAN_ACTION Settled(LOCATE_PLAN* plan, int32_t pos, uint32_t now, bool timeout)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+    int32_t dir = plan->dir;
+    float rem;
+
+    if (plan->learn && plan->steady && !timeout && (plan->respVel >= PLAN_VEL_MIN))
+        LearnBrake(model, dir, plan->respVel, 0.0f, Travel(plan, pos) - plan->lagDist);
+
+    rem = Remaining(plan, pos);
+
+    if ((fabsf(rem) <= PLAN_ARRIVE_TOL) || (plan->retries >= PLAN_MAX_RETRY))
+    {
+        if (plan->learn)
+            model->locates++;
+
+        plan->phase = PLAN_PHASE_DONE;
+        plan->eta = 0.0f;
+        return PLAN_ARRIVED;
+    }
+
+    /* Servo the rest of the way, reversing if we went past */
+    plan->retries++;
+
+    if (rem < 0.0f)
+    {
+        plan->dir = (dir == PLAN_FWD) ? PLAN_REW : PLAN_FWD;
+        plan->reversals++;
+    }
+
+    plan->eta = ServoTime(model, plan->dir, 0.0f, fabsf(rem));
+
+    return Approach(plan, pos, 0.0f, now);
+}
+
+//*****************************************************************************
+// Start the servo approach to the cue point at the given speed toward it.
+// The servo velocity scale comes from the speed learned at slow shuttle.
+//*****************************************************************************
+
+static PLAN_ACTION Approach(LOCATE_PLAN* plan, int32_t pos, float velocity, uint32_t now)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+    float v = (velocity > 0.0f) ? velocity : 0.0f;
+
+    PhaseBegin(plan, PLAN_PHASE_APPROACH, pos, v, now);
+
+    ServoBegin(model, plan->dir, &plan->servo, Remaining(plan, pos), v,
+               (float)plan->slowVel / model->slow[plan->dir], now);
+
+    return Servo(plan, pos, velocity, now);
+}
+
+//*****************************************************************************
+// Run the servo approach and return the action it needs. Once the servo
+// stops the transport, the speed it reached for the speed commanded is
+// used to correct the slow shuttle speed, which sets the servo scale.
+//*****************************************************************************
+
+static PLAN_ACTION Servo(LOCATE_PLAN* plan, int32_t pos, float velocity, uint32_t now)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+    int32_t dir = plan->dir;
+    float gain;
+
+    switch(ApproachServo_update(&plan->servo, Travel(plan, pos), velocity, now))
+    {
+    case SERVO_VELOCITY:
+        plan->velocity = plan->servo.velocity;
+        plan->reverse  = plan->servo.reverse;
+        return PLAN_SHUTTLE;
+
+    case SERVO_STOP:
+        gain = ApproachServo_gain(&plan->servo);
+
+        if (plan->learn && (gain > 0.0f))
+            Learn(&model->slow[dir], model->slow[dir] * gain, PLAN_VEL_MIN, PLAN_VEL_MAX);
+
+        PhaseBegin(plan, PLAN_PHASE_SETTLE, pos, fabsf(velocity), now);
+        return PLAN_STOP;
+
+    default:
+        break;
+    }
+
+    return PLAN_NONE;
+}
+
+//*****************************************************************************
+// Estimate the time left in seconds from the current phase.
+//*****************************************************************************
+
+static float Eta(LOCATE_PLAN* plan, float v, float rem, uint32_t now)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+    int32_t dir = plan->dir;
+    float v1 = PLAN_SERVO_VEL;
+    float d;
+
+    switch(plan->phase)
+    {
+    case PLAN_PHASE_SHUTTLE:
+        return ProfileTime(model, dir, model->cruise[dir][plan->speed], v, rem);
+
+    case PLAN_PHASE_BRAKE:
+        d = rem - BrakeDist(model, dir, v, v1);
+        if (d < 0.0f)
+            d = 0.0f;
+        return BrakeTime(model, dir, v1, v) + model->lag[dir] + ServoTime(model, dir, v1, d);
+
+    case PLAN_PHASE_APPROACH:
+        return ApproachServo_time(&plan->servo, now);
+
+    case PLAN_PHASE_SETTLE:
+        return BrakeTime(model, dir, 0.0f, v);
+
+    default:
+        break;
+    }
+
+    return 0.0f;
+}
+
+//*****************************************************************************
+// Time in seconds to cover the distance given starting at speed v0 with a
+// shuttle at cruise speed vc, braking to the servo speed and the servo
+// approach. If there isn't room to reach the cruise speed the shuttle is
+// stopped at the peak speed that just leaves room to brake.
+//*****************************************************************************
+
+static float ProfileTime(const STC_LOCATE_MODEL* model, int32_t dir, float vc, float v0, float dist)
+{
+    float a  = model->accel[dir];
+    float v1 = PLAN_SERVO_VEL;
+    float lo, hi;
+    float vp;
+    float d;
+    int i;
+
+    d = dist - ApproachDist();
+
+    /* Only room for the servo approach */
+    if ((vc <= v1) || (d <= 0.0f))
+        return ServoTime(model, dir, v0, dist);
+
+    if (v0 > vc)
+        vc = v0;
+
+    /* Distance to reach cruise speed and brake from it */
+    vp = (((vc * vc) - (v0 * v0)) / (2.0f * a)) + BrakeDist(model, dir, vc, v1);
+
+    if (vp <= d)
+    {
+        return ((vc - v0) / a) + ((d - vp) / vc) + model->lag[dir] +
+               BrakeTime(model, dir, v1, vc) + ApproachTime(model, dir);
+    }
+
+    /* Find the peak speed where the shuttle must start braking */
+    lo = (v0 > v1) ? v0 : v1;
+    hi = vc;
+
+    for (i=0; i < 16; i++)
+    {
+        vp = (lo + hi) * 0.5f;
+
+        if ((((vp * vp) - (v0 * v0)) / (2.0f * a)) + BrakeDist(model, dir, vp, v1) > d)
+            hi = vp;
+        else
+            lo = vp;
+    }
+
+    vp = lo;
+
+    return ((vp - v0) / a) + model->lag[dir] + BrakeTime(model, dir, v1, vp) +
+           ApproachTime(model, dir);
+}
+
+//*****************************************************************************
+// Distance in inches to brake from speed v2 down to v1 once braking has
+// begun. The braking rate is taken as constant over each speed band.
+// The time taken is returned as well if time is not NULL.
+//*****************************************************************************
+
+static float Brake(const STC_LOCATE_MODEL* model, int32_t dir, float v1, float v2, float* time)
+{
+    uint32_t band;
+    float lo, hi;
+    float b;
+    float d = 0.0f;
+    float t = 0.0f;
+
+    for (band=0; band < STC_PLAN_BANDS; band++)
+    {
+        lo = (float)band * PLAN_BAND_IPS;
+        hi = (band < (STC_PLAN_BANDS - 1)) ? (lo + PLAN_BAND_IPS) : v2;
+
+        if (lo < v1)
+            lo = v1;
+
+        if (hi > v2)
+            hi = v2;
+
+        if (hi <= lo)
+            continue;
+
+        b  = model->decel[dir][band];
+        d += ((hi * hi) - (lo * lo)) / (2.0f * b);
+        t += (hi - lo) / b;
+    }
+
+    if (time)
+        *time = t;
+
+    return d;
+}
+
+//*****************************************************************************
+// Move the braking rates toward a measured brake from v0 down to v1. The
+// correction is shared out over the speed bands by the distance braked in
+// each.
+//*****************************************************************************
+
+static void LearnBrake(STC_LOCATE_MODEL* model, int32_t dir, float v0, float v1, float dist)
+{
+    uint32_t band;
+    float lo, hi;
+    float ratio;
+    float share;
+    float b;
+    float d;
+
+    if ((dist <= 0.0f) || ((d = Brake(model, dir, v1, v0, NULL)) <= 0.0f))
+        return;
+
+    /* The braking rate needed to brake in the distance measured */
+    ratio = d / dist;
+
+    if ((ratio < 0.25f) || (ratio > 4.0f))
+        return;
+
+    for (band=0; band < STC_PLAN_BANDS; band++)
+    {
+        lo = (float)band * PLAN_BAND_IPS;
+        hi = (band < (STC_PLAN_BANDS - 1)) ? (lo + PLAN_BAND_IPS) : v0;
+
+        if (lo < v1)
+            lo = v1;
+
+        if (hi > v0)
+            hi = v0;
+
+        if (hi <= lo)
+            continue;
+
+        b = model->decel[dir][band];
+
+        share = (((hi * hi) - (lo * lo)) / (2.0f * b)) / d;
+
+        b *= 1.0f + (PLAN_LEARN_RATE * share * (ratio - 1.0f));
+
+        if (b < PLAN_RATE_MIN)
+            b = PLAN_RATE_MIN;
+
+        if (b > PLAN_RATE_MAX)
+            b = PLAN_RATE_MAX;
+
+        model->decel[dir][band] = b;
+    }
+}
+
+//*****************************************************************************
+// Helper functions for the model.
+//*****************************************************************************
+
+/* Inches left to the cue point in the plan direction */
+static float Remaining(LOCATE_PLAN* plan, int32_t pos)
+{
+    float d = (float)(plan->cue - pos) * plan->inchesPerTick;
+
+    return (plan->dir == PLAN_FWD) ? d : -d;
+}
+
+/* Inches left when the shuttle must brake to the servo speed and make
+ * the approach, at speed v toward the cue point.
+ */
+static float ShuttleDist(LOCATE_PLAN* plan, float v)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+    int32_t dir = plan->dir;
+
+    return CommandDist(model, dir, v, model->cruise[dir][plan->speed], PLAN_SERVO_VEL) +
+           ApproachDist() + (v * PLAN_LOOKAHEAD);
+}
+
+/* Inches traveled in the plan direction since the phase began */
+static float Travel(LOCATE_PLAN* plan, int32_t pos)
+{
+    float d = (float)(pos - plan->phasePos) * plan->inchesPerTick;
+
+    return (plan->dir == PLAN_FWD) ? d : -d;
+}
+
+/* Time to brake from speed v2 down to v1 */
+static float BrakeTime(const STC_LOCATE_MODEL* model, int32_t dir, float v1, float v2)
+{
+    float t;
+
+    Brake(model, dir, v1, v2, &t);
+
+    return t;
+}
+
+/* Distance to brake from speed v down to v1 after a stop command */
+static float BrakeDist(const STC_LOCATE_MODEL* model, int32_t dir, float v, float v1)
+{
+    return (v * model->lag[dir]) + Brake(model, dir, v1, v, NULL);
+}
+
+/* Speed the transport is at when it responds to a command given at
+ * speed v. If the shuttle is still getting up to speed vt it keeps
+ * speeding up until then.
+ */
+static float Response(const STC_LOCATE_MODEL* model, int32_t dir, float v, float vt)
+{
+    float vr;
+
+    if (v >= vt)
+        return v;
+
+    vr = v + (model->accel[dir] * model->lag[dir]);
+
+    return (vr < vt) ? vr : vt;
+}
+
+/* Distance to brake down to v1 from a stop command given at speed v while
+ * shuttling toward speed vt.
+ */
+static float CommandDist(const STC_LOCATE_MODEL* model, int32_t dir, float v, float vt, float v1)
+{
+    float vr = Response(model, dir, v, vt);
+
+    return (((v + vr) * 0.5f) * model->lag[dir]) + Brake(model, dir, v1, vr, NULL);
+}
+
+/* Distance for the servo approach from the servo speed */
+static float ApproachDist(void)
+{
+    float v1 = PLAN_SERVO_VEL;
+    float ve = SERVO_VEL_MIN;
+
+    return (v1 * PLAN_APPROACH_TIME) + (((v1 * v1) - (ve * ve)) / (2.0f * PLAN_SERVO_DECEL)) +
+           SERVO_CREEP_DIST;
+}
+
+/* Time for the servo approach from the servo speed */
+static float ApproachTime(const STC_LOCATE_MODEL* model, int32_t dir)
+{
+    return ServoTime(model, dir, PLAN_SERVO_VEL, ApproachDist());
+}
+
+/* Start a servo approach profile from the model */
+static void ServoBegin(const STC_LOCATE_MODEL* model, int32_t dir, APPROACH_SERVO* servo,
+                       float dist, float v0, float scale, uint32_t now)
+{
+    ApproachServo_begin(servo, dist, v0, PLAN_SERVO_VEL,
+                        model->accel[dir] * PLAN_SERVO_ACCEL, PLAN_SERVO_DECEL,
+                        model->decel[dir][0], model->lag[dir], scale, now);
+}
+
+/* Time for a servo approach over the distance given */
+static float ServoTime(const STC_LOCATE_MODEL* model, int32_t dir, float v0, float dist)
+{
+    APPROACH_SERVO servo;
+
+    ServoBegin(model, dir, &servo, dist, v0, 1.0f, 0);
+
+    return ApproachServo_time(&servo, 0);
+}
+
+static void PhaseBegin(LOCATE_PLAN* plan, PLAN_PHASE phase, int32_t pos, float v, uint32_t now)
+{
+    plan->phase     = phase;
+    plan->phaseTime = now;
+    plan->phasePos  = pos;
+    plan->phaseVel  = v;
+    plan->respVel   = v;
+    plan->lagDist   = v * plan->model->lag[plan->dir];
+    plan->lagFound  = false;
+    plan->lagDrop   = false;
+    plan->steady    = false;
+    plan->stillTime = now;
+    plan->reverse   = false;
+}
+
+/* Set the expected response to a stop given while shuttling toward vt */
+static void PhaseResponse(LOCATE_PLAN* plan, float vt)
+{
+    STC_LOCATE_MODEL* model = plan->model;
+
+    plan->respVel = Response(model, plan->dir, plan->phaseVel, vt);
+    plan->lagDist = (plan->phaseVel + plan->respVel) * 0.5f * model->lag[plan->dir];
+}
+
+/* Move a model value toward a new measurement if it is in range */
+static bool Learn(float* value, float sample, float lo, float hi)
+{
+    if ((sample < lo) || (sample > hi))
+        return false;
+
+    *value += PLAN_LEARN_RATE * (sample - *value);
+
+    return true;
+}
+
+/* End-Of-File */
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _LOCATEPLAN_H_
+#define _LOCATEPLAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ApproachServo.h"
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Direction index into the model tables */
+#define PLAN_FWD                0
+#define PLAN_REW                1
+
+/* Shuttle speed index, these are the config jog velocities */
+#define PLAN_SPEED_FAR          0
+#define PLAN_SPEED_MID          1
+#define PLAN_SPEED_NEAR         2
+
+/* Width of each braking speed band in IPS. The top band covers all
+ * speeds above the others.
+ */
+#define PLAN_BAND_IPS           50.0f
+
+/* Braking ends and the approach servo takes over at this speed in IPS.
+ * The servo speeds up at PLAN_SERVO_ACCEL of the shuttle acceleration and
+ * slows at PLAN_SERVO_DECEL IPS/sec, well inside what the transport can
+ * do at low speed, so the position loop has room to correct.
+ */
+#define PLAN_SERVO_VEL          40.0f
+#define PLAN_SERVO_ACCEL        0.50f
+#define PLAN_SERVO_DECEL        30.0f
+
+/* Seconds at the servo speed allowed for before the servo slows. This
+ * takes up any error in the braking so the servo never has to slow
+ * harder than planned.
+ */
+#define PLAN_APPROACH_TIME      0.250f
+
+/* Time in seconds between planner updates allowed for in the braking
+ * decisions, so a decision is never made one update too late.
+ */
+#define PLAN_LOOKAHEAD          0.005f
+
+/* Longest ms LocatePlan_deadline() returns. Any change in speed comes
+ * with a new encoder sample, so this is only a backstop.
+ */
+#define PLAN_DEADLINE_MAX       100
+
+/* Tape is stopped below this velocity in IPS for PLAN_SETTLE_TIME ms */
+#define PLAN_STOPPED_VEL        1.0f
+#define PLAN_SETTLE_TIME        50
+#define PLAN_SETTLE_TIMEOUT     3000
+
+/* Stopping further than this from the cue point in inches starts the
+ * servo approach again, up to PLAN_MAX_RETRY times.
+ */
+#define PLAN_ARRIVE_TOL         1.00f
+#define PLAN_MAX_RETRY          1
+
+/* Shuttle must hold within 10% of cruise speed this many seconds before
+ * the cruise speed is learned.
+ */
+#define PLAN_CRUISE_HOLD        0.500f
+
+/* Weight given each new measurement when learning the model */
+#define PLAN_LEARN_RATE         0.25f
+
+/* Measurements outside these limits are thrown away */
+#define PLAN_VEL_MIN            5.0f
+#define PLAN_VEL_MAX            1000.0f
+#define PLAN_RATE_MIN           10.0f
+#define PLAN_RATE_MAX           5000.0f
+#define PLAN_LAG_MAX            0.500f
+
+/* Planner actions returned for the locator to carry out */
+typedef enum _PLAN_ACTION {
+    PLAN_NONE,                  /* nothing to do this update        */
+    PLAN_SHUTTLE,               /* shuttle at plan velocity and dir */
+    PLAN_STOP,                  /* stop the transport               */
+    PLAN_ARRIVED,               /* tape is stopped at the cue point */
+} PLAN_ACTION;
+
+/* Planner phases */
+typedef enum _PLAN_PHASE {
+    PLAN_PHASE_SHUTTLE,         /* shuttle toward the cue point     */
+    PLAN_PHASE_BRAKE,           /* braking down to the servo speed  */
+    PLAN_PHASE_APPROACH,        /* servo onto the cue point         */
+    PLAN_PHASE_SETTLE,          /* stopping, waiting for standstill */
+    PLAN_PHASE_DONE,
+} PLAN_PHASE;
+
+/*** LOCATE PLAN DATA ******************************************************/
+
+typedef struct _LOCATE_PLAN {
+    STC_LOCATE_MODEL* model;    /* transport model, in the config   */
+    bool        learn;          /* update the model from this plan  */
+    PLAN_PHASE  phase;
+    int32_t     dir;            /* PLAN_FWD or PLAN_REW             */
+    uint32_t    speed;          /* PLAN_SPEED_xxx for the shuttle   */
+    uint32_t    velocity;       /* DTC velocity to shuttle at       */
+    bool        reverse;        /* shuttle away from the cue point  */
+    uint32_t    jogVel[STC_PLAN_SPEEDS]; /* DTC jog velocities      */
+    uint32_t    slowVel;        /* DTC slow shuttle velocity        */
+    float       inchesPerTick;
+    int32_t     cue;            /* cue point position in ticks      */
+    float       eta;            /* seconds until stopped at the cue */
+    uint32_t    retries;        /* slow approaches started again    */
+    uint32_t    reversals;      /* direction changes                */
+    bool        overshoot;      /* passed the cue point             */
+    /* Measurements for learning the model */
+    uint32_t    startTime;      /* ms the shuttle was started       */
+    bool        fromRest;       /* shuttle started from a stop      */
+    bool        reached;        /* reached 90% of cruise speed      */
+    uint32_t    reachTime;      /* ms cruise speed was reached      */
+    float       peak;           /* highest speed seen this phase    */
+    uint32_t    phaseTime;      /* ms the current phase began       */
+    int32_t     phasePos;       /* position the phase began         */
+    float       phaseVel;       /* speed the phase began at         */
+    float       respVel;        /* speed when the transport responds */
+    float       lagDist;        /* distance before it responds      */
+    bool        lagDrop;        /* speed first seen to drop         */
+    uint32_t    lagTime;        /* ms the speed was first seen to drop */
+    bool        lagFound;       /* response to stop command seen    */
+    bool        steady;         /* stop made from a steady speed    */
+    uint32_t    stillTime;      /* ms the tape was first stopped    */
+    APPROACH_SERVO servo;       /* final approach position servo    */
+} LOCATE_PLAN;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void LocatePlan_initModel(STC_LOCATE_MODEL* model);
+
+PLAN_ACTION LocatePlan_begin(LOCATE_PLAN* plan, STC_LOCATE_MODEL* model,
+                             const uint32_t* jogVel, uint32_t slowVel,
+                             bool learn, float inchesPerTick,
+                             int32_t cue, int32_t pos, float velocity,
+                             uint32_t now);
+
+PLAN_ACTION LocatePlan_update(LOCATE_PLAN* plan, int32_t pos, float velocity,
+                              uint32_t now);
+
+uint32_t LocatePlan_deadline(LOCATE_PLAN* plan, int32_t pos, float velocity,
+                             uint32_t now);
+
+float LocatePlan_time(const STC_LOCATE_MODEL* model, int32_t dir,
+                      uint32_t speed, float distance);
+
+#endif  /* _LOCATEPLAN_H_ */
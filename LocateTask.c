@@ -51,6 +51,7 @@
 /* BIOS Header files */
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
@@ -64,6 +65,7 @@
 #include <ti/drivers/SDSPI.h>
 #include <ti/drivers/I2C.h>
 #include <ti/drivers/UART.h>
+#include <ti/mw/fatfs/ff.h>
 
 /* NDK BSD support */
 #include <sys/socket.h>
@@ -102,31 +104,61 @@
 
 #define IPC_TIMEOUT     1000
 
+/* Longest ms the search loop sleeps without a position update. The
+ * position task posts one at least every 5ms, so this only matters if
+ * the encoder samples stop.
+ */
+#define LOCATE_WAIT_MAX         50
+
+/* Auto punch rehearse flag and post-roll ms in the locate message. The
+ * rehearse lead is the time for the track task to switch the monitors on
+ * the DCS, as the rehearse doesn't wait on the DTC.
+ */
+#define LOCATE_PUNCH_REHEARSE   0x80000000
+#define LOCATE_PUNCH_MS_MASK    0x0000FFFF
+
+#define LOCATE_REHEARSE_LEAD    0.005f
+
 /* Locator States */
 typedef enum _LocateState {
     STATE_START_STATE,
-    STATE_BEGIN_SHUTTLE,
-    STATE_SEARCH_FAR,
-    STATE_SEARCH_MID,
-    STATE_SEARCH_NEAR,
-    STATE_BRAKE_STATE,
-    STATE_BRAKE_VELOCITY,
-    STATE_PAST_ZERO,
-    STATE_ZERO_DIR,
-    STATE_ZERO_CROSS,
+    STATE_SEARCH,
     STATE_BEGIN_LOOP,
     STATE_MARK_OUT,
     STATE_LOOP,
+    STATE_SEQ_STEP,
+    STATE_SEQ_WAIT,
+    STATE_PUNCH_ROLL,
+    STATE_PUNCH,
     STATE_COMPLETE,
 } LocateState;
 
 /*** External Data Items ***/
 
 extern Mailbox_Handle g_mailboxLocate;
+extern Event_Handle g_eventLocate;
+
+/*** Static Data Items ***/
+
+/* Cue list sequencer steps, guarded by g_semaCue */
+static CUE_SEQ s_cueSeq;
+
+/* Named cue store and the file used to save it, guarded by g_semaCue */
+static CUE_STORE s_cueStore;
+static FIL s_cueFile;
 
 /*** Static Function Prototypes ***/
 
 Bool IsTransportHaltMode(void);
+static Bool LocateAction(LOCATE_PLAN* plan, PLAN_ACTION action);
+static UInt LocateDeadline(LOCATE_PLAN* plan, int32_t tape_pos, float velocity);
+static UInt LoopDeadline(LOOP_PLAN* loop);
+static Bool SequenceNext(SEQ_STEP* step, SEQ_STEP* next);
+static void SequenceEnd(void);
+static uint32_t SequencePlan(SEQ_STEP* next, int32_t tape_pos, uint32_t ms);
+static void CueStorePath(char* path, const char* name);
+static Bool PunchPoints(size_t* in, size_t* out);
+static void PunchEnd(AUTO_PUNCH* punch, Bool rehearse);
 
 /*****************************************************************************
  * This function stores the current tape position to a cue point memory
@@ -145,6 +177,8 @@ void CuePointClear(size_t index)
 		g_sys.cuePoint[index].flags = CF_NONE;
 
 		Hwi_restore(key);
+
+		TransportState_publishCues();
 	}
 
 	Semaphore_post(g_semaCue);
@@ -171,6 +205,8 @@ void CuePointClearAll(void)
         Hwi_restore(key);
     }
 
+    TransportState_publishCues();
+
     Semaphore_post(g_semaCue);
 }
 
@@ -197,6 +233,8 @@ void CuePointSet(size_t index, int ipos, uint32_t cue_flags)
         g_sys.cuePoint[index].flags = cue_flags;
 
         Hwi_restore(key);
+
+        TransportState_publishCues();
     }
 
     Semaphore_post(g_semaCue);
@@ -231,6 +269,8 @@ void CuePointMask(size_t index, uint32_t setmask, uint32_t clearmask)
         g_sys.cuePoint[index].flags = cue_flags;
 
         Hwi_restore(key);
+
+        TransportState_publishCues();
     }
 
     Semaphore_post(g_semaCue);
@@ -318,7 +358,13 @@ Bool LocateSearch(size_t cuePointIndex, uint32_t cue_flags)
     msgLocate.param1  = (uint32_t)cuePointIndex;
     msgLocate.param2  = cue_flags;
 
-    return Mailbox_post(g_mailboxLocate, &msgLocate, 1000);
+    if (!Mailbox_post(g_mailboxLocate, &msgLocate, 1000))
+        return FALSE;
+
+    /* Wake the locator if it's searching */
+    Event_post(g_eventLocate, LOCATE_EVT_COMMAND);
+
+    return TRUE;
 }
 
 Bool LocateLoop(uint32_t cue_flags)
@@ -332,11 +378,90 @@ Bool LocateLoop(uint32_t cue_flags)
     if (!IsCuePointFlags(CUE_POINT_MARK_OUT, CF_ACTIVE))
         return FALSE;
 
+    /* The loop plays forward from mark-in to mark-out */
+    if (g_sys.cuePoint[CUE_POINT_MARK_OUT].ipos <= g_sys.cuePoint[CUE_POINT_MARK_IN].ipos)
+        return FALSE;
+
     msgLocate.command = LOCATE_LOOP;
     msgLocate.param1  = CUE_POINT_MARK_IN;
     msgLocate.param2  = cue_flags;
 
-    return Mailbox_post(g_mailboxLocate, &msgLocate, 1000);
+    if (!Mailbox_post(g_mailboxLocate, &msgLocate, 1000))
+        return FALSE;
+
+    Event_post(g_eventLocate, LOCATE_EVT_COMMAND);
+
+    return TRUE;
+}
+
+Bool LocateSequence(size_t first)
+{
+    size_t count;
+    LocateMessage msgLocate;
+
+    /* Make sure the cue list has a step to start at */
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+    count = s_cueSeq.count;
+    Semaphore_post(g_semaCue);
+
+    if (first >= count)
+        return FALSE;
+
+    msgLocate.command = LOCATE_SEQUENCE;
+    msgLocate.param1  = (uint32_t)first;
+    msgLocate.param2  = 0;
+
+    if (!Mailbox_post(g_mailboxLocate, &msgLocate, 1000))
+        return FALSE;
+
+    Event_post(g_eventLocate, LOCATE_EVT_COMMAND);
+
+    return TRUE;
+}
+
+//*****************************************************************************
+// Start an auto punch. The locator locates to the pre-roll point ahead of
+// the punch-in point, plays from there and punches in and out of record
+// on the punch points. The transport stops once the post-roll has played.
+// With rehearse set the ready tracks switch to input monitor on the punch
+// points instead and record is not entered. Auto punch must be armed.
+//*****************************************************************************
+
+Bool LocatePunch(uint32_t preroll, uint32_t postroll, Bool rehearse)
+{
+    size_t in;
+    size_t out;
+    LocateMessage msgLocate;
+
+    if (!g_sys.autoPunch)
+        return FALSE;
+
+    /* Make sure there are punch points to punch on */
+    if (!PunchPoints(&in, &out))
+        return FALSE;
+
+    if (!preroll)
+        preroll = STC_PUNCH_PREROLL;
+    else if (preroll < STC_PUNCH_ROLL_MIN)
+        preroll = STC_PUNCH_ROLL_MIN;
+    else if (preroll > STC_PUNCH_ROLL_MAX)
+        preroll = STC_PUNCH_ROLL_MAX;
+
+    if (!postroll)
+        postroll = STC_PUNCH_POSTROLL;
+    else if (postroll > STC_PUNCH_ROLL_MAX)
+        postroll = STC_PUNCH_ROLL_MAX;
+
+    msgLocate.command = LOCATE_PUNCH;
+    msgLocate.param1  = preroll;
+    msgLocate.param2  = postroll | (rehearse ? LOCATE_PUNCH_REHEARSE : 0);
+
+    if (!Mailbox_post(g_mailboxLocate, &msgLocate, 1000))
+        return FALSE;
+
+    Event_post(g_eventLocate, LOCATE_EVT_COMMAND);
+
+    return TRUE;
 }
 
 //*****************************************************************************
@@ -349,6 +474,7 @@ Bool LocateCancel(void)
     uint32_t key = Hwi_disable();
     g_sys.searchCancel = TRUE;
     Hwi_restore(key);
+    Event_post(g_eventLocate, LOCATE_EVT_CANCEL);
     return TRUE;
 }
 
@@ -360,6 +486,12 @@ Bool IsLocating(void)
     if (g_sys.autoLoop)
         return TRUE;
 
+    if (g_sys.sequencing)
+        return TRUE;
+
+    if (g_sys.punching)
+        return TRUE;
+
     return FALSE;
 }
 
@@ -378,498 +510,1039 @@ Bool IsLocatorAutoPunch(void)
     return g_sys.autoPunch;
 }
 
-//*****************************************************************************
-// Test to see if transport is out of tape or in thread mode.
-//*****************************************************************************
-
-Bool IsTransportHaltMode(void)
+Bool IsLocatorSequencing(void)
 {
-    uint32_t mode = (g_sys.transportMode & MODE_MASK);
-
-    /* Abort if transport halted, must be tape out? */
-    if ((mode == MODE_HALT) || (mode == MODE_THREAD))
-        return TRUE;
+    return g_sys.sequencing;
+}
 
-    return FALSE;
+Bool IsLocatorPunching(void)
+{
+    return g_sys.punching;
 }
 
 //*****************************************************************************
-// Position reader/display task. This function reads the tape roller
-// quadrature encoder and stores the current position data. The 7-segement
-// tape position display is also updated via the task so the current tape
-// position is always being shown on the machine's display on the transport.
+// Cue list sequencer steps. The cue list is guarded by the cue point
+// semaphore and can't be changed while the sequence is running.
 //*****************************************************************************
 
-Void LocateTaskFxn(UArg arg0, UArg arg1)
+Bool SequenceClear(void)
 {
-    Bool     cancel;
-    Bool     done;
-    Bool     looping;
-    int32_t  dir;
-    int32_t  cue_from;
-    int32_t  out_dist;
-	int32_t  cue_dist;
-	int32_t  abs_dist;
-    size_t   cue_index;
-    uint32_t cue_flags;
-	uint32_t shuttle_vel;
-    uint32_t key;
-    LocateState state;
-    LocateMessage msg;
+    Bool status = FALSE;
 
-    /* Get current transport mode & speed from DTC */
-    Transport_GetMode(&g_sys.transportMode, &g_sys.tapeSpeed);
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-    /* Clear SEARCHING_OUT status i/o pin */
-    GPIO_write(Board_SEARCHING, PIN_HIGH);
+    if (!s_cueSeq.running)
+    {
+        CueSeq_init(&s_cueSeq);
+        status = TRUE;
+    }
 
-    /* Set home cue point memory to zero */
-    CuePointSet(CUE_POINT_HOME, 0, CF_ACTIVE);
+    Semaphore_post(g_semaCue);
 
-    /* Initialize LOC-0 to zero */
-    CuePointSet(g_sys.cueIndex, 0, CF_ACTIVE);
+    return status;
+}
 
-    g_sys.searchCancel = false;             /* true if search canceling   */
-    g_sys.searching    = false;             /* true if search in progress */
-    g_sys.autoLoop     = false;             /* true if loop mode running  */
-    g_sys.autoPunch    = false;
+Bool SequenceStepSet(size_t index, uint32_t op, uint32_t param, uint32_t flags)
+{
+    Bool status;
 
-    /*
-     * ENTER THE MAIN LOCATOR SEARCH LOOP!
-     */
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-    while(TRUE)
-    {
-        /* Send TCP state change notification */
-        Event_post(g_eventTransport, Event_Id_00);
+    status = CueSeq_set(&s_cueSeq, index, op, param, flags);
 
-        /* Wait for a locate request */
-        Mailbox_pend(g_mailboxLocate, &msg, BIOS_WAIT_FOREVER);
+    Semaphore_post(g_semaCue);
 
-        /* Discard locate request if in halt mode */
-        if (IsTransportHaltMode())
-            continue;
+    return status;
+}
 
-        looping = FALSE;
+Bool SequenceStepGet(size_t index, uint32_t* op, uint32_t* param, uint32_t* flags)
+{
+    Bool status;
+    SEQ_STEP step;
 
-        /* Only look for search requests initially */
-        if (msg.command == LOCATE_LOOP)
-        {
-            cue_index = CUE_POINT_MARK_IN;
-            cue_flags = msg.param2;
-            looping = TRUE;
-#if (TTY_DEBUG_MSGS > 0)
-            CLI_printf("LOOP COMMAND!\n");
-#endif
-        }
-        else if (msg.command == LOCATE_SEARCH)
-        {
-            /* Get the cue point memory index. The cue point table is arranged
-             * with 64 memory positions from 0-63. Memory location 64 is reserved
-             * for the single point cue/search buttons on the machine timer/roller.
-             */
-            cue_index = (size_t)msg.param1;
-            cue_flags = msg.param2;
-#if (TTY_DEBUG_MSGS > 0)
-            CLI_printf("SEARCH COMMAND!\n");
-#endif
-        }
-        else
-        {
-#if (TTY_DEBUG_MSGS > 0)
-            CLI_printf("BAD SEARCH COMMAND!\n");
-#endif
-            /* Unknown command */
-            continue;
-        }
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-        if (cue_index >= MAX_CUE_POINTS)
-        {
-#if (TTY_DEBUG_MSGS > 0)
-            CLI_printf("INVALID CUE INDEX %u\n", cue_index);
-#endif
-            continue;
-        }
+    status = CueSeq_get(&s_cueSeq, index, &step);
 
-        /* Is the cue point is active? */
-        if ((g_sys.cuePoint[cue_index].flags & CF_ACTIVE) == 0)
-        {
-#if (TTY_DEBUG_MSGS > 0)
-            CLI_printf("LOCATE CUE %u NOT ACTIVE - IGNORING!\n", cue_index);
-#endif
-            continue;
-        }
+    Semaphore_post(g_semaCue);
 
-        /* Set SEARCHING_OUT status i/o pin */
-        GPIO_write(Board_SEARCHING, PIN_LOW);
+    if (status)
+    {
+        *op    = step.op;
+        *param = step.param;
+        *flags = step.flags;
+    }
 
-        /* If user cue memory, turn on the button LED */
-        if (cue_index < USER_CUE_POINTS)
-            SetLocateButtonLED(cue_index);
+    return status;
+}
 
-        /* Set transport to STOP mode initially */
-        Transport_Stop();
+Bool SequenceStatus(size_t* step, uint32_t* remaining)
+{
+    Bool running;
 
-        /* Save cue from point distance */
-        cue_from = g_sys.cuePoint[cue_index].ipos - g_sys.tapePosition;
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-        if (!cue_from)
-            cue_from = 1;
+    running    = s_cueSeq.running;
+    *step      = s_cueSeq.current;
+    *remaining = CueSeq_deadline(&s_cueSeq, Clock_getTicks());
 
-        /* Clear the global search cancel flag */
-        key = Hwi_disable();
-        g_sys.searching = TRUE;
-        g_sys.autoLoop  = looping;
-        g_sys.searchProgress = 0;
-        Hwi_restore(key);
+    Semaphore_post(g_semaCue);
 
-        /* Send TCP state change notification */
-        //Event_post(g_eventTransport, Event_Id_00);
+    return running;
+}
 
-        /**************************************/
-        /* BEGIN MAIN AUTO-LOCATE SEARCH LOOP */
-        /**************************************/
+//*****************************************************************************
+// Named cue store. This holds the named cues for the reel in banks, one
+// for each song, apart from the cue point memories. The store is guarded
+// by the cue point semaphore. A named cue is located to by recalling it
+// into a cue point memory.
+//*****************************************************************************
 
-        state = STATE_START_STATE;
+int CueStoreAdd(uint32_t bank, int ipos, uint32_t flags, const char* name)
+{
+    int handle;
 
-        done = FALSE;
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-	    do
-	    {
-	        float time, mark;
-            float velocity;
+    handle = CueStore_add(&s_cueStore, bank, ipos, flags, name);
 
-            /* Abort if transport halted, must be tape out? */
-            if (IsTransportHaltMode())
-            {
-#if (TTY_DEBUG_MSGS > 0)
-                CLI_printf("*** TRANSPORT HALT STATE 1 ***\n");
-#endif
-                break;
-            }
+    Semaphore_post(g_semaCue);
 
-			/* Get the signed and absolute position(distance) cue_from the cue point */
-            cue_dist = g_sys.cuePoint[cue_index].ipos - g_sys.tapePosition;
+    return handle;
+}
 
-            abs_dist = abs(cue_dist);
+Bool CueStoreDelete(int handle)
+{
+    Bool status;
 
-			/* v = d/t */
-			if ((velocity = g_sys.tapeTach) < 1.0f)
-			    velocity = 1.0f;
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-			/* d = v * t */
-			/* t = d/v */
-			time = (float)abs_dist / velocity;
+    status = CueStore_remove(&s_cueStore, handle);
 
-			/* Calculate the search progress as percentage */
+    Semaphore_post(g_semaCue);
 
-            float progress = fabs(((float)cue_dist / cue_from) * 100.0f);
+    return status;
+}
 
-            if (progress > 100.0f)
-                progress = 100.0f;
+size_t CueStoreClearBank(uint32_t bank)
+{
+    size_t count;
 
-            if (progress < 0.0f)
-                progress = 0.0f;
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-            g_sys.searchProgress = 100 - (int32_t)progress;
+    count = CueStore_clearBank(&s_cueStore, bank);
 
-#if (TTY_DEBUG_MSGS > 0)
-            //if (state >= STATE_SEARCH_FAR)
-            //    CLI_printf("d=%d, t=%u, v=%u\n", cue_dist, (uint32_t)time, (uint32_t)velocity);
-#endif
-			/*
-			 * SEARCH FINITE STATE MACHINE
-			 */
+    Semaphore_post(g_semaCue);
 
-            /* Send TCP state change notification */
-            //Event_post(g_eventTransport, Event_Id_00);
+    return count;
+}
 
-			switch(state)
-			{
-			case STATE_START_STATE:
+Bool CueStoreGet(int handle, int* ipos, uint32_t* bank, uint32_t* flags, char* name)
+{
+    const CUE_ENTRY* entry;
 
-			    /* Reset the search cancel flag! This gets set by a
-			     * button interrupt handler in the program main.
-			     */
-		        key = Hwi_disable();
-			    g_sys.searchCancel = false;
-		        Hwi_restore(key);
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
 
-                cancel = false;
+    if ((entry = CueStore_get(&s_cueStore, handle)) != NULL)
+    {
+        if (ipos)
+            *ipos = entry->ipos;
 
-			    /* Determine which direction we need to go initially */
-#if (TTY_DEBUG_MSGS > 0)
-			    CLI_printf("BEGIN LOCATE[%u] ", cue_index);
+        if (bank)
+            *bank = entry->bank;
+
+        if (flags)
+            *flags = entry->flags;
+
+        if (name)
+            memcpy(name, entry->name, CUE_NAME_LEN);
+    }
+
+    Semaphore_post(g_semaCue);
+
+    return (entry != NULL) ? TRUE : FALSE;
+}
+
+Bool CueStoreMove(int handle, int ipos)
+{
+    Bool status;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    status = CueStore_move(&s_cueStore, handle, ipos);
+
+    Semaphore_post(g_semaCue);
+
+    return status;
+}
+
+Bool CueStoreRename(int handle, const char* name)
+{
+    Bool status;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    status = CueStore_rename(&s_cueStore, handle, name);
+
+    Semaphore_post(g_semaCue);
+
+    return status;
+}
+
+//*****************************************************************************
+// Find a cue of a bank from a tape position for jog-to-cue, or by name.
+// The mode is one of STC_CS_FIND_xxx. Returns CUE_NONE if none is found.
+//*****************************************************************************
+
+int CueStoreFind(uint32_t bank, int ipos, uint32_t mode, const char* name)
+{
+    int handle = CUE_NONE;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    switch(mode)
+    {
+    case STC_CS_FIND_NEXT:
+        handle = CueStore_next(&s_cueStore, bank, ipos);
+        break;
+
+    case STC_CS_FIND_PREV:
+        handle = CueStore_prev(&s_cueStore, bank, ipos);
+        break;
+
+    case STC_CS_FIND_NEAREST:
+        handle = CueStore_nearest(&s_cueStore, bank, ipos);
+        break;
+
+    case STC_CS_FIND_NAME:
+        handle = CueStore_find(&s_cueStore, bank, name);
+        break;
+
+    default:
+        break;
+    }
+
+    Semaphore_post(g_semaCue);
+
+    return handle;
+}
+
+//*****************************************************************************
+// Return the nth cue of a bank in tape position order and the number of
+// cues in the bank. This lets the remote page through a bank.
+//*****************************************************************************
+
+int CueStoreAt(uint32_t bank, size_t n, size_t* count)
+{
+    int handle;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    handle = CueStore_at(&s_cueStore, bank, n);
+
+    if (count)
+        *count = CueStore_count(&s_cueStore, bank);
+
+    Semaphore_post(g_semaCue);
+
+    return handle;
+}
+
+//*****************************************************************************
+// Copy a named cue into a cue point memory so it can be located to with
+// the locate buttons or STC_CMD_LOCATE.
+//*****************************************************************************
+
+Bool CueStoreRecall(int handle, size_t index)
+{
+    const CUE_ENTRY* entry;
+
+    if (index >= MAX_CUE_POINTS)
+        return FALSE;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    if ((entry = CueStore_get(&s_cueStore, handle)) != NULL)
+    {
+        uint32_t key = Hwi_disable();
+
+        g_sys.cuePoint[index].ipos  = entry->ipos;
+        g_sys.cuePoint[index].flags = entry->flags | CF_ACTIVE;
+
+        Hwi_restore(key);
+
+        TransportState_publishCues();
+    }
+
+    Semaphore_post(g_semaCue);
+
+    return (entry != NULL) ? TRUE : FALSE;
+}
+
+//*****************************************************************************
+// Load the cue store from a file on the SD card. The store is emptied and
+// then filled from the file. The name is the file name without the ".cue"
+// extension, or NULL for the default file. The cue point semaphore is held
+// while the file is read.
+//*****************************************************************************
+
+Bool CueStoreLoad(const char* name)
+{
+    Bool status = FALSE;
+    CUE_FILE_HDR hdr;
+    CUE_FILE_REC rec;
+    FRESULT res;
+    UINT br;
+    size_t i;
+    char path[STC_CUE_NAME_LEN + 8];
+
+    CueStorePath(path, name);
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    if (f_open(&s_cueFile, path, FA_READ) == FR_OK)
+    {
+        res = f_read(&s_cueFile, &hdr, sizeof(hdr), &br);
+
+        if ((res == FR_OK) && (br == sizeof(hdr)) &&
+            (hdr.magic == CUE_FILE_MAGIC) && (hdr.version == CUE_FILE_VERSION))
+        {
+            CueStore_init(&s_cueStore);
+
+            for (i=0; i < hdr.count; i++)
+            {
+                res = f_read(&s_cueFile, &rec, sizeof(rec), &br);
+
+                if ((res != FR_OK) || (br != sizeof(rec)))
+                    break;
+
+                if (!CueStore_put(&s_cueStore, rec.handle, &rec.cue))
+                    break;
+            }
+
+            status = (i == hdr.count) ? TRUE : FALSE;
+        }
+
+        f_close(&s_cueFile);
+    }
+
+    Semaphore_post(g_semaCue);
+
+    return status;
+}
+
+//*****************************************************************************
+// Save the cue store to a file on the SD card. Each cue is saved with its
+// handle so the handles are the same once the file is loaded again.
+//*****************************************************************************
+
+Bool CueStoreSave(const char* name)
+{
+    CUE_FILE_HDR hdr;
+    CUE_FILE_REC rec;
+    FRESULT res;
+    UINT bw;
+    int handle;
+    char path[STC_CUE_NAME_LEN + 8];
+
+    CueStorePath(path, name);
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    if ((res = f_open(&s_cueFile, path, FA_WRITE | FA_CREATE_ALWAYS)) == FR_OK)
+    {
+        hdr.magic    = CUE_FILE_MAGIC;
+        hdr.version  = CUE_FILE_VERSION;
+        hdr.count    = s_cueStore.count;
+        hdr.reserved = 0;
+
+        if (((res = f_write(&s_cueFile, &hdr, sizeof(hdr), &bw)) == FR_OK) && (bw != sizeof(hdr)))
+            res = FR_DENIED;
+
+        handle = CueStore_scan(&s_cueStore, 0);
+
+        while ((res == FR_OK) && (handle != CUE_NONE))
+        {
+            rec.handle   = (uint16_t)handle;
+            rec.reserved = 0;
+            rec.cue      = s_cueStore.entry[handle];
+
+            /* A short write means the card is full */
+            if (((res = f_write(&s_cueFile, &rec, sizeof(rec), &bw)) == FR_OK) && (bw != sizeof(rec)))
+                res = FR_DENIED;
+
+            handle = CueStore_scan(&s_cueStore, handle + 1);
+        }
+
+        if (f_close(&s_cueFile) != FR_OK)
+            res = FR_DISK_ERR;
+    }
+
+    Semaphore_post(g_semaCue);
+
+    return (res == FR_OK) ? TRUE : FALSE;
+}
+
+//*****************************************************************************
+// Test to see if transport is out of tape or in thread mode.
+//*****************************************************************************
+
+Bool IsTransportHaltMode(void)
+{
+    uint32_t mode = (g_sys.transportMode & MODE_MASK);
+
+    /* Abort if transport halted, must be tape out? */
+    if ((mode == MODE_HALT) || (mode == MODE_THREAD))
+        return TRUE;
+
+    return FALSE;
+}
+
+//*****************************************************************************
+// Position reader/display task. This function reads the tape roller
+// quadrature encoder and stores the current position data. The 7-segement
+// tape position display is also updated via the task so the current tape
+// position is always being shown on the machine's display on the transport.
+//*****************************************************************************
+
+Void LocateTaskFxn(UArg arg0, UArg arg1)
+{
+    Bool     cancel;
+    Bool     done;
+    Bool     looping;
+    Bool     sequencing;
+    Bool     punching;
+    Bool     rehearse;
+    int32_t  cue_pos;
+    int32_t  cue_from;
+	int32_t  cue_dist;
+    size_t   cue_index;
+    size_t   punch_out;
+    int32_t  roll_from;
+    uint32_t postroll;
+    uint32_t cue_flags;
+    uint32_t jog_vel[STC_PLAN_SPEEDS];
+    uint32_t key;
+    uint32_t seq_eta;
+    int32_t  tape_pos;
+    UInt     wait;
+    SEQ_STEP step;
+    SEQ_STEP next;
+    MOTION_STATE motion;
+    LOCATE_PLAN plan;
+    PLAN_ACTION action;
+    LOOP_ACTION loop_action;
+    AUTO_PUNCH punch;
+    LOOP_PLAN loop;
+    LocateState state;
+    LocateMessage msg;
+
+    /* Get current transport mode & speed from DTC */
+    Transport_GetMode(&g_sys.transportMode, &g_sys.tapeSpeed);
+
+    TransportState_publishMode();
+
+    /* Clear SEARCHING_OUT status i/o pin */
+    GPIO_write(Board_SEARCHING, PIN_HIGH);
+
+    /* Set home cue point memory to zero */
+    CuePointSet(CUE_POINT_HOME, 0, CF_ACTIVE);
+
+    /* Initialize LOC-0 to zero */
+    CuePointSet(g_sys.cueIndex, 0, CF_ACTIVE);
+
+    g_sys.searchCancel = false;             /* true if search canceling   */
+    g_sys.searching    = false;             /* true if search in progress */
+    g_sys.autoLoop     = false;             /* true if loop mode running  */
+    g_sys.autoPunch    = false;
+    g_sys.sequencing   = false;             /* true if cue list running   */
+    g_sys.punching     = false;             /* true if auto punch running */
+
+    seq_eta = 0;
+    roll_from = postroll = 0;
+    rehearse = FALSE;
+
+    TransportState_publishSearch();
+
+    /*
+     * ENTER THE MAIN LOCATOR SEARCH LOOP!
+     */
+
+    while(TRUE)
+    {
+        /* Send TCP state change notification */
+        Event_post(g_eventTransport, Event_Id_00);
+
+        /* Wait for a locate request */
+        Mailbox_pend(g_mailboxLocate, &msg, BIOS_WAIT_FOREVER);
+
+        /* Discard locate request if in halt mode */
+        if (IsTransportHaltMode())
+            continue;
+
+        looping = FALSE;
+        sequencing = FALSE;
+        punching = FALSE;
+
+        /* Only look for search requests initially */
+        if (msg.command == LOCATE_LOOP)
+        {
+            cue_index = CUE_POINT_MARK_IN;
+            cue_flags = msg.param2;
+            looping = TRUE;
+
+            /* Each pass locates back to a pre-roll point ahead of mark-in
+             * so the tape is at play speed by mark-in. A loop in record
+             * starts from mark-in so record never starts ahead of it.
+             */
+            LoopPlan_begin(&loop, &g_sys.cfgSTC.locateModel,
+                           g_sys.cfgSTC.locateLearn,
+                           g_sys.cuePoint[CUE_POINT_MARK_IN].ipos,
+                           g_sys.cuePoint[CUE_POINT_MARK_OUT].ipos,
+                           POSITION_TO_INCHES(1.0f), (float)g_sys.tapeSpeed,
+                           (cue_flags & CF_AUTO_REC) ? false : true);
+
+            roll_from = LoopPlan_preroll(&loop);
+#if (TTY_DEBUG_MSGS > 0)
+            CLI_printf("LOOP COMMAND!\n");
 #endif
-			    if (g_sys.cuePoint[cue_index].ipos > g_sys.tapePosition)
-		        {
+        }
+        else if (msg.command == LOCATE_SEARCH)
+        {
+            /* Get the cue point memory index. The cue point table is arranged
+             * with 64 memory positions from 0-63. Memory location 64 is reserved
+             * for the single point cue/search buttons on the machine timer/roller.
+             */
+            cue_index = (size_t)msg.param1;
+            cue_flags = msg.param2;
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("FWD > ");
+            CLI_printf("SEARCH COMMAND!\n");
 #endif
-		            dir = DIR_FWD;
-		        }
-		        else if (g_sys.cuePoint[cue_index].ipos < g_sys.tapePosition)
-		        {
+        }
+        else if (msg.command == LOCATE_SEQUENCE)
+        {
+            /* Start the cue list at the step given in param1 */
+            Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+            sequencing = CueSeq_start(&s_cueSeq, (size_t)msg.param1, Clock_getTicks());
+            Semaphore_post(g_semaCue);
+
+            if (!sequencing)
+                continue;
+
+            /* The cue list steps give the cue points to locate to. The
+             * home cue point is always active and only stands in until
+             * the first locate step.
+             */
+            cue_index = CUE_POINT_HOME;
+            cue_flags = 0;
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("REW < ");
+            CLI_printf("SEQUENCE COMMAND!\n");
 #endif
-		            dir = DIR_REW;
-		        }
-		        else
-		        {
+        }
+        else if (msg.command == LOCATE_PUNCH)
+        {
+            /* Locate to the pre-roll point the time given in param1 ahead
+             * of the punch-in point. The cue index is the punch-in point.
+             */
+            if (!PunchPoints(&cue_index, &punch_out))
+                continue;
+
+            roll_from = AutoPunch_preroll(g_sys.cuePoint[cue_index].ipos,
+                                          (float)msg.param1 * 0.001f,
+                                          (float)g_sys.tapeSpeed,
+                                          POSITION_TO_INCHES(1.0f));
+
+            postroll = msg.param2 & LOCATE_PUNCH_MS_MASK;
+            rehearse = (msg.param2 & LOCATE_PUNCH_REHEARSE) ? TRUE : FALSE;
+            cue_flags = 0;
+            punching = TRUE;
+
+            /* Nothing is punched until the tape rolls */
+            punch.phase = PUNCH_DONE;
+#if (TTY_DEBUG_MSGS > 0)
+            CLI_printf("PUNCH COMMAND!\n");
+#endif
+        }
+        else
+        {
+#if (TTY_DEBUG_MSGS > 0)
+            CLI_printf("BAD SEARCH COMMAND!\n");
+#endif
+            /* Unknown command */
+            continue;
+        }
+
+        if (cue_index >= MAX_CUE_POINTS)
+        {
+#if (TTY_DEBUG_MSGS > 0)
+            CLI_printf("INVALID CUE INDEX %u\n", cue_index);
+#endif
+            continue;
+        }
+
+        /* Is the cue point is active? */
+        if ((g_sys.cuePoint[cue_index].flags & CF_ACTIVE) == 0)
+        {
+#if (TTY_DEBUG_MSGS > 0)
+            CLI_printf("LOCATE CUE %u NOT ACTIVE - IGNORING!\n", cue_index);
+#endif
+            continue;
+        }
+
+        /* Set SEARCHING_OUT status i/o pin */
+        GPIO_write(Board_SEARCHING, PIN_LOW);
+
+        /* If user cue memory, turn on the button LED */
+        if (cue_index < USER_CUE_POINTS)
+            SetLocateButtonLED(cue_index);
+
+        /* Set transport to STOP mode initially */
+        Transport_Stop();
+
+        /* Save cue from point distance */
+        cue_pos = (punching || looping) ? roll_from : g_sys.cuePoint[cue_index].ipos;
+
+        cue_from = cue_pos - g_sys.tapePosition;
+
+        if (!cue_from)
+            cue_from = 1;
+
+        /* Clear the global search cancel flag */
+        key = Hwi_disable();
+        g_sys.searching  = !sequencing;
+        g_sys.autoLoop   = looping;
+        g_sys.sequencing = sequencing;
+        g_sys.punching   = punching;
+        g_sys.searchProgress = 0;
+        Hwi_restore(key);
+
+        TransportState_publishSearch();
+
+        /* Send TCP state change notification */
+        //Event_post(g_eventTransport, Event_Id_00);
+
+        /**************************************/
+        /* BEGIN MAIN AUTO-LOCATE SEARCH LOOP */
+        /**************************************/
+
+        state = sequencing ? STATE_SEQ_STEP : STATE_START_STATE;
+
+        done = cancel = FALSE;
+
+	    do
+	    {
+            /* Sleep until the next position update unless a state
+             * below needs to run again sooner.
+             */
+            wait = LOCATE_WAIT_MAX;
+
+            /* Abort if transport halted, must be tape out? */
+            if (IsTransportHaltMode())
+            {
+#if (TTY_DEBUG_MSGS > 0)
+                CLI_printf("*** TRANSPORT HALT STATE 1 ***\n");
+#endif
+                break;
+            }
+
+            /* Get the tape position predicted for right now from the
+             * motion estimator along with the tape velocity.
+             */
+            tape_pos = PositionPredict(&motion);
+
+            /* An auto punch or loop locates to the pre-roll point */
+            cue_pos = (punching || looping) ? roll_from : g_sys.cuePoint[cue_index].ipos;
+
+			/* Get the signed position(distance) cue_from the cue point */
+            cue_dist = cue_pos - tape_pos;
+
+			/* Calculate the search progress as percentage */
+
+            float progress = fabs(((float)cue_dist / cue_from) * 100.0f);
+
+            if (progress > 100.0f)
+                progress = 100.0f;
+
+            if (progress < 0.0f)
+                progress = 0.0f;
+
+            g_sys.searchProgress = 100 - (int32_t)progress;
+
+            TransportState_publishSearch();
+
+#if (TTY_DEBUG_MSGS > 0)
+            //if (state >= STATE_SEARCH_FAR)
+            //    CLI_printf("d=%d, t=%u, v=%u\n", cue_dist, (uint32_t)time, (uint32_t)velocity);
+#endif
+			/*
+			 * SEARCH FINITE STATE MACHINE
+			 */
+
+            /* Send TCP state change notification */
+            //Event_post(g_eventTransport, Event_Id_00);
+
+			switch(state)
+			{
+			case STATE_START_STATE:
+
+			    /* Reset the search cancel flag! This gets set by a
+			     * button interrupt handler in the program main.
+			     */
+		        key = Hwi_disable();
+			    g_sys.searchCancel = false;
+		        Hwi_restore(key);
+
+                cancel = false;
+
+                if (!cue_dist)
+                {
 #if (TTY_DEBUG_MSGS > 0)
                     CLI_printf("AT ZERO!!\n");
 #endif
+                    if (sequencing)
+                    {
+                        state = STATE_SEQ_STEP;
+                        wait = BIOS_NO_WAIT;
+                        break;
+                    }
+
+                    if (punching)
+                    {
+                        state = STATE_PUNCH_ROLL;
+                        wait = BIOS_NO_WAIT;
+                        break;
+                    }
+
                     done = TRUE;
-		            dir = DIR_ZERO;
-		            break;
-		        }
+                    break;
+                }
 
-			    /* Determine the shuttle speed range based on distance out */
+                /* Plan the locate from the learned transport model. The
+                 * planner picks the jog velocity that gets to the cue point
+                 * soonest and works out when to brake from what it learned
+                 * of the transport on earlier locates.
+                 */
+                jog_vel[PLAN_SPEED_FAR]  = g_sys.cfgSTC.jog_vel_far;
+                jog_vel[PLAN_SPEED_MID]  = g_sys.cfgSTC.jog_vel_mid;
+                jog_vel[PLAN_SPEED_NEAR] = g_sys.cfgSTC.jog_vel_near;
+
+                action = LocatePlan_begin(&plan, &g_sys.cfgSTC.locateModel,
+                                          jog_vel, SHUTTLE_SLOW_VEL,
+                                          g_sys.cfgSTC.locateLearn,
+                                          POSITION_TO_INCHES(1.0f),
+                                          cue_pos, tape_pos, motion.velocity,
+                                          Clock_getTicks());
+#if (TTY_DEBUG_MSGS > 0)
+			    CLI_printf("BEGIN LOCATE[%u] %s speed=%u eta=%f\n", cue_index,
+			               (plan.dir == PLAN_FWD) ? "FWD" : "REW",
+			               plan.speed, plan.eta);
+#endif
+                state = STATE_SEARCH;
+
+                g_sys.searchETA = (uint32_t)(plan.eta * 1000.0f);
+
+                LocateAction(&plan, action);
+
+                wait = LocateDeadline(&plan, tape_pos, motion.velocity);
+                break;
+
+            case STATE_SEARCH:
+
+                /* On the way back round a loop the loop plan takes over once
+                 * the tape heads back. Play is sent with the tape still
+                 * shuttling, once it can turn around and be up to play speed
+                 * by mark-in, rather than braking and stopping on the
+                 * pre-roll point first.
+                 */
+                loop_action = looping ? LoopPlan_return(&loop, tape_pos, motion.velocity) : LOOP_NONE;
+
+                if (loop_action == LOOP_HOLD)
+                {
+                    wait = LoopDeadline(&loop);
+                    break;
+                }
 
-			    if (abs_dist > 9000)
+                if (loop_action == LOOP_PLAY)
                 {
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("FAR\n");
+                    CLI_printf("LOOP PLAY pos=%d, vel=%f\n", tape_pos, motion.velocity);
 #endif
-                    shuttle_vel = JOG_VEL_FAR;
-                    state = STATE_SEARCH_FAR;
+                    g_sys.searchProgress = 100;
+                    g_sys.searchETA = 0;
+
+                    state = STATE_BEGIN_LOOP;
+                    wait = BIOS_NO_WAIT;
+                    break;
                 }
-                else if (abs_dist > 3000)
+
+                /* Let the planner decide when to brake and stop */
+                action = LocatePlan_update(&plan, tape_pos, motion.velocity,
+                                           Clock_getTicks());
+
+                g_sys.searchETA = (uint32_t)(plan.eta * 1000.0f);
+
+                if (!LocateAction(&plan, action))
                 {
+                    wait = LocateDeadline(&plan, tape_pos, motion.velocity);
+                    break;
+                }
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("MID\n");
+                CLI_printf("ARRIVED cue=%d, retries=%u, overshoot=%u\n",
+                           cue_dist, plan.retries, plan.overshoot);
 #endif
-                    shuttle_vel = JOG_VEL_MID;
-                    state = STATE_SEARCH_MID;
-                }
-                else
+                g_sys.searchProgress = 100;
+                g_sys.searchETA = 0;
+
+                if (looping)
                 {
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("NEAR\n");
+                    CLI_printf("*** AUTO-LOOPING ***\n");
 #endif
-                    shuttle_vel = JOG_VEL_NEAR;
-                    state = STATE_SEARCH_NEAR;
+                    state = STATE_BEGIN_LOOP;
+                    wait = BIOS_NO_WAIT;
+                    break;
                 }
 
-                //CLI_printf(" d=%d, t=%d\n", cue_dist, (int32_t)time);
-
-                /* Start the transport in either FWD or REV direction
-		         * based on the cue point and current location. We set
-		         * the M_NOSLOW so the DTC auto-slow function will be
-		         * disabled for the shuttle command requested.
-		         */
-                if (dir == DIR_FWD)
-		            Transport_Fwd(shuttle_vel, M_NOSLOW);
-		        else
-		            Transport_Rew(shuttle_vel, M_NOSLOW);
-			    break;
+                if (sequencing)
+                {
+                    g_sys.searching = FALSE;
+
+                    TransportState_publishSearch();
+
+                    state = STATE_SEQ_STEP;
+                    wait = BIOS_NO_WAIT;
+                    break;
+                }
+
+                if (punching)
+                {
+                    state = STATE_PUNCH_ROLL;
+                    wait = BIOS_NO_WAIT;
+                    break;
+                }
+
+                done = TRUE;
+                break;
 
-            case STATE_SEARCH_FAR:
+            case STATE_BEGIN_LOOP:
 
-                if (time < 130.0f)  /* RES120722 changed to 130, was 110 */
-			    {
-                    state = STATE_BRAKE_VELOCITY;
+                g_sys.searching = FALSE;
 
-	                if (velocity > 35.0f)
-	                {
-#if (TTY_DEBUG_MSGS > 0)
-                        CLI_printf("SHUTTLE FAR BRAKE STATE d=%d\n", cue_dist);
-#endif
-	                    state = STATE_BRAKE_STATE;
-	                }
-			    }
-			    break;
+                TransportState_publishSearch();
 
-            case STATE_SEARCH_MID:
+                if (cue_flags & CF_AUTO_REC)
+                    Transport_Play(M_RECORD);
+                else
+                    Transport_Play(0);
 
-                if (time < 70.0f)
-                {
-                    state = STATE_BRAKE_VELOCITY;
+                /* Measure the spin-up to play speed for the next pass */
+                LoopPlan_play(&loop, tape_pos, motion.velocity);
 
-                    if (velocity > 35.0f)
-                    {
 #if (TTY_DEBUG_MSGS > 0)
-                        CLI_printf("SHUTTLE MID BRAKE STATE d=%d\n", cue_dist);
+                CLI_printf("BEGIN LOOP MODE\n");
 #endif
-                        state = STATE_BRAKE_STATE;
-                    }
-                }
+                /* Next look for zero cross */
+                state = STATE_MARK_OUT;
                 break;
 
-            case STATE_SEARCH_NEAR:
+            case STATE_MARK_OUT:
 
-                if (time < 30.0f)
+                /* Turn around the learned command lag ahead of the tape
+                 * reaching mark-out, so the transport starts braking on
+                 * the mark-out point.
+                 */
+                if (LoopPlan_update(&loop, tape_pos, motion.velocity) == LOOP_TURN)
                 {
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("SHUTTLE NEAR BRAKE STATE d=%d\n", cue_dist);
+                    CLI_printf("MARK-OUT REACHED pos=%d\n", tape_pos);
 #endif
-                    state = STATE_BRAKE_VELOCITY;
+                    state = STATE_LOOP;
+                    wait = BIOS_NO_WAIT;
+                    break;
                 }
+
+                /* Wake when the turnaround falls due at this speed */
+                wait = LoopDeadline(&loop);
                 break;
 
-            case STATE_BRAKE_STATE:
+            case STATE_LOOP:
+                /* Queue up the locate request again and loop again. The
+                 * pre-roll point moves with the spin-up just learned.
+                 */
+                roll_from = LoopPlan_preroll(&loop);
+                cue_flags |=  CF_AUTO_PLAY;
+                state = STATE_START_STATE;
+                continue;
 
-                //CLI_printf("CHECK BRAKE STATE: d=%d, t=%d, v=%u\n", abs_dist, (int32_t)time, (uint32_t)velocity);
+            case STATE_SEQ_STEP:
 
-                if (velocity > 30.0f)
+                /* Run the next step in the cue list. The sequence is
+                 * done once the cue list runs out.
+                 */
+                if (!SequenceNext(&step, &next))
                 {
-#if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("BEGIN DYNAMIC BRAKE: v=%u\n", (uint32_t)velocity);
-#endif
-                    Transport_Stop();
-
-                    state = STATE_BRAKE_VELOCITY;
+                    done = TRUE;
+                    break;
                 }
-                else
-                {
-#if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("BEGIN COAST BRAKE: v=%u\n", (uint32_t)velocity);
-#endif
-                    /* Begin low speed shuttle */
-                    if (dir == DIR_FWD)
-                        Transport_Fwd(SHUTTLE_SLOW_VEL, M_NOSLOW);
-                    else
-                        Transport_Rew(SHUTTLE_SLOW_VEL, M_NOSLOW);
 
-                    state = STATE_ZERO_CROSS;
-                }
+                wait = BIOS_NO_WAIT;
 
-                /* Fall through to next velocity check state */
+                switch(step.op)
+                {
+                case STC_SEQ_LOCATE:
 
-			case STATE_BRAKE_VELOCITY:
+                    cue_index = (size_t)step.param;
+                    cue_flags = 0;
 
-			    /* Wait for velocity to drop to 15 or below */
-                //CLI_printf("d=%d, f=%d, t=%u, v=%u\n", cue_dist, cue_from, (uint32_t)time, (uint32_t)velocity);
+                    /* End the sequence on a cue point that was cleared */
+                    if (!IsCuePointFlags(cue_index, CF_ACTIVE))
+                    {
+                        done = TRUE;
+                        break;
+                    }
 
-			    if (velocity > 40.0f)
-			        break;
-#if (TTY_DEBUG_MSGS > 0)
-			    CLI_printf("BEGIN SLOW SHUTTLE d=%d, t=%d, v=%u\n", cue_dist, (int32_t)time, (uint32_t)velocity);
-#endif
-                /* Begin low speed shuttle */
-                if (dir == DIR_FWD)
-                    Transport_Fwd(SHUTTLE_SLOW_VEL, M_NOSLOW);
-                else
-                    Transport_Rew(SHUTTLE_SLOW_VEL, M_NOSLOW);
+                    if (cue_index < USER_CUE_POINTS)
+                        SetLocateButtonLED(cue_index);
 
-                /* Next look for zero cross */
-                state = STATE_ZERO_CROSS;
+                    cue_from = g_sys.cuePoint[cue_index].ipos - tape_pos;
 
-                /* Fall through... */
+                    if (!cue_from)
+                        cue_from = 1;
 
-            case STATE_ZERO_CROSS:
+                    key = Hwi_disable();
+                    g_sys.searching = TRUE;
+                    g_sys.searchProgress = 0;
+                    Hwi_restore(key);
 
-                /* ZERO CROSS - check taking direction into account */
+                    TransportState_publishSearch();
 
-                //CLI_printf("d=%d, f=%d, t=%u, v=%u\n", cue_dist, cue_from, (uint32_t)time, (uint32_t)velocity);
+                    /* The locate is planned from the tape motion as it is,
+                     * so it follows straight on from a play segment.
+                     */
+                    state = STATE_START_STATE;
+                    break;
 
-                /* Check for overshoot! */
-                if (dir == DIR_FWD)
-                {
-                    if (cue_from < cue_dist)
-                    {
-#if (TTY_DEBUG_MSGS > 0)
-                        CLI_printf("OVERSHOOT FWD: %d, %d\n", cue_dist, cue_from);
-#endif
-                        g_sys.searchProgress = 100;
+                case STC_SEQ_PLAY:
 
-                        Transport_Stop();
+                    if (step.flags & STC_SEQ_F_RECORD)
+                        Transport_Play(M_RECORD);
+                    else
+                        Transport_Play(0);
 
-                        if (looping)
-                        {
-                            state = STATE_BEGIN_LOOP;
-                            break;
-                        }
-                        done = TRUE;
+                    /* Play with no time limit leaves the tape playing */
+                    if (!step.param)
+                    {
+                        cancel = done = TRUE;
                         break;
                     }
-                }
-                else
-                {
-                    if (cue_from > cue_dist)
-                    {
-#if (TTY_DEBUG_MSGS > 0)
-                        CLI_printf("OVERSHOOT REW: %d, %d\n", cue_dist, cue_from);
-#endif
-                        g_sys.searchProgress = 100;
 
-                        Transport_Stop();
+                    /* Plan the next locate while this segment plays */
+                    seq_eta = SequencePlan(&next, tape_pos, step.param);
 
-                        if (looping)
-                        {
-                            state = STATE_BEGIN_LOOP;
-                            break;
-                        }
-                        done = TRUE;
-                        break;
-                    }
-                }
+                    state = STATE_SEQ_WAIT;
+                    break;
 
-                if (time < 15.0f)
-                {
-                    g_sys.searchProgress = 100;
+                case STC_SEQ_STOP:
                     Transport_Stop();
+                    break;
+
+                case STC_SEQ_DWELL:
+                    seq_eta = SequencePlan(&next, tape_pos, 0);
+                    state = STATE_SEQ_WAIT;
+                    break;
+
+                default:
+                    done = TRUE;
+                    break;
+                }
 #if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("ZERO CROSSED cue=%d, abs=%d\n", cue_dist, abs_dist);
-#endif
-                    if (looping)
-                    {
-#if (TTY_DEBUG_MSGS > 0)
-                        CLI_printf("*** AUTO-LOOPING ***\n");
+                CLI_printf("SEQUENCE STEP %u op=%u param=%u eta=%u\n",
+                           s_cueSeq.current, step.op, step.param, seq_eta);
 #endif
-                        state = STATE_BEGIN_LOOP;
-                        break;
-                    }
+                break;
 
-                    done = TRUE;
+            case STATE_SEQ_WAIT:
+
+                /* Wait out a timed play or dwell step */
+                wait = (UInt)CueSeq_deadline(&s_cueSeq, Clock_getTicks());
+
+                /* Time to the next cue point, planned as the step began */
+                g_sys.searchETA = (uint32_t)wait + seq_eta;
+
+                if (!wait)
+                {
+                    state = STATE_SEQ_STEP;
+                    break;
                 }
+
+                if (wait > LOCATE_WAIT_MAX)
+                    wait = LOCATE_WAIT_MAX;
                 break;
 
-            case STATE_BEGIN_LOOP:
+            case STATE_PUNCH_ROLL:
 
                 g_sys.searching = FALSE;
 
-                if (cue_flags & CF_AUTO_REC)
-                    Transport_Play(M_RECORD);
-                else
-                    Transport_Play(0);
+                TransportState_publishSearch();
 
+                /* Roll from the pre-roll point. The punches are sent ahead
+                 * of the punch points by the punch lag learned on earlier
+                 * punches, so record starts and ends on the punch points.
+                 */
+                Transport_Play(0);
+
+                AutoPunch_begin(&punch, g_sys.cuePoint[cue_index].ipos,
+                                g_sys.cuePoint[punch_out].ipos,
+                                POSITION_TO_INCHES(1.0f),
+                                rehearse ? LOCATE_REHEARSE_LEAD : g_sys.cfgSTC.locateModel.punch,
+                                postroll);
 #if (TTY_DEBUG_MSGS > 0)
-                CLI_printf("BEGIN LOOP MODE\n");
+                CLI_printf("BEGIN PUNCH %s\n", rehearse ? "REHEARSE" : "RECORD");
 #endif
-                /* Next look for zero cross */
-                state = STATE_MARK_OUT;
+                state = STATE_PUNCH;
                 break;
 
-            case STATE_MARK_OUT:
+            case STATE_PUNCH:
 
-                /* Look for tape position to reach/pass mark-out point */
+                /* Learn the punch lag as the DTC reports record on or off */
+                if (!rehearse && g_sys.cfgSTC.locateLearn)
+                {
+                    AutoPunch_response(&punch, (g_sys.transportMode & M_RECORD) ? true : false,
+                                       g_sys.recordTime, &g_sys.cfgSTC.locateModel.punch);
+                }
 
-                out_dist = g_sys.cuePoint[CUE_POINT_MARK_OUT].ipos - g_sys.tapePosition;
+                switch(AutoPunch_update(&punch, (float)tape_pos, motion.velocity, Clock_getTicks()))
+                {
+                case PUNCH_IN:
+                    if (rehearse)
+                        TRACK_Manager_rehearse(true);
+                    else
+                        Transport_Play(M_RECORD);
+                    break;
 
-                /* d = v * t */
-                /* t = d/v */
-                mark = fabs((float)out_dist) / velocity;
+                case PUNCH_OUT:
+                    if (rehearse)
+                        TRACK_Manager_rehearse(false);
+                    else
+                        Transport_Play(0);
+                    break;
 
-                //CLI_printf("MARK-OUT pos=%d, out=%f\n", g_sysData.tapePosition, mark);
+                case PUNCH_END:
+                    done = TRUE;
+                    break;
 
-                if (mark < 10.0f)
-                {
-#if (TTY_DEBUG_MSGS > 0)
-                    CLI_printf("MARK-OUT REACHED pos=%d, out=%f\n", g_sys.tapePosition, mark);
-#endif
-                    state = STATE_LOOP;
+                default:
                     break;
                 }
+#if (TTY_DEBUG_MSGS > 0)
+                if (punch.phase != PUNCH_ARMED)
+                    CLI_printf("PUNCH phase=%u pos=%d\n", punch.phase, tape_pos);
+#endif
+                /* Wake on the next position update or as the punch is due */
+                if ((wait = (UInt)AutoPunch_deadline(&punch)) > LOCATE_WAIT_MAX)
+                    wait = LOCATE_WAIT_MAX;
                 break;
 
-            case STATE_LOOP:
-                /* Queue up the locate request again and loop again */
-                cue_flags |=  CF_AUTO_PLAY;
-                state = STATE_START_STATE;
-                continue;
-
             default:
 #if (TTY_DEBUG_MSGS > 0)
                 CLI_printf("*** INVALID STATE %d ***\n", state);
@@ -894,6 +1567,13 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
                 break;
             }
 
+			/* Wait for the position task to post a new position, a new locate
+			 * command or cancel, or for the time the planner must act by. The
+			 * locator then runs as soon as each encoder sample is in rather
+			 * than on the next tick, and sleeps while nothing has changed.
+			 */
+	        Event_pend(g_eventLocate, Event_Id_NONE, LOCATE_EVT_ALL, wait);
+
 			/* Check for a new locate command. It's possible the user may have requested
 			 * a new locate cue point while a locate command was already in progress.
 			 * If so, we cancel the current locate request and reset to start searching
@@ -907,7 +1587,7 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
 	            break;
 	        }
 #else
-	        if (Mailbox_pend(g_mailboxLocate, &msg, 1))
+	        if (Mailbox_pend(g_mailboxLocate, &msg, BIOS_NO_WAIT))
 	        {
                 if (msg.command == LOCATE_SEARCH)
 	            {
@@ -916,6 +1596,20 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
 #endif
                     cancel = looping = FALSE;
 
+                    /* A new search ends any cue list sequence */
+                    if (sequencing)
+                    {
+                        SequenceEnd();
+                        sequencing = FALSE;
+                    }
+
+                    /* or auto punch */
+                    if (punching)
+                    {
+                        PunchEnd(&punch, rehearse);
+                        punching = FALSE;
+                    }
+
                     /* New search requested! */
 
                     cue_index = (size_t)msg.param1;
@@ -940,12 +1634,16 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
 
                     /* Clear the global search cancel flag */
                     key = Hwi_disable();
-                    g_sys.searching = TRUE;
-                    g_sys.autoLoop  = FALSE;
+                    g_sys.searching  = TRUE;
+                    g_sys.autoLoop   = FALSE;
+                    g_sys.sequencing = FALSE;
+                    g_sys.punching   = FALSE;
                     //g_sysData.searchCancel = FALSE;
                     g_sys.searchProgress = 0;
                     Hwi_restore(key);
 
+                    TransportState_publishSearch();
+
                     /* Set SEARCHING_OUT status i/o pin */
                     GPIO_write(Board_SEARCHING, PIN_LOW);
 
@@ -957,7 +1655,7 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
                     Transport_Stop();
 
                     /* Save cue from distance */
-                    cue_from = g_sys.cuePoint[cue_index].ipos - g_sys.tapePosition;
+                    cue_from = g_sys.cuePoint[cue_index].ipos - tape_pos;
 
                     if (!cue_from)
                         cue_from = 1;
@@ -1002,11 +1700,22 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
 
         /* Clear the search in progress flag */
         key = Hwi_disable();
-        g_sys.searching = FALSE;
-        g_sys.autoLoop  = FALSE;
+        g_sys.searching  = FALSE;
+        g_sys.autoLoop   = FALSE;
+        g_sys.sequencing = FALSE;
+        g_sys.punching   = FALSE;
         //g_sysData.searchCancel = FALSE;
         Hwi_restore(key);
 
+        if (sequencing)
+            SequenceEnd();
+
+        /* Switch the monitors back from a rehearse canceled early */
+        if (punching)
+            PunchEnd(&punch, rehearse);
+
+        TransportState_publishSearch();
+
         /* Send STOP button pulse to stop transport. If the
          * user canceled the search, then don't stop or
          * auto-play and just exit the loop allowing the
@@ -1045,6 +1754,230 @@ Void LocateTaskFxn(UArg arg0, UArg arg1)
  * HELPER FUNCTIONS
  *****************************************************************************/
 
+//*****************************************************************************
+// Carry out an action from the locate planner. Returns TRUE once the tape
+// has stopped at the cue point. The M_NOSLOW flag is set on shuttle
+// commands so the DTC auto-slow function is disabled during the locate.
+//*****************************************************************************
+
+static Bool LocateAction(LOCATE_PLAN* plan, PLAN_ACTION action)
+{
+    switch(action)
+    {
+    case PLAN_SHUTTLE:
+        /* The approach servo may reverse to bring the tape back */
+        if ((plan->dir == PLAN_FWD) != plan->reverse)
+            Transport_Fwd(plan->velocity, M_NOSLOW);
+        else
+            Transport_Rew(plan->velocity, M_NOSLOW);
+        break;
+
+    case PLAN_STOP:
+        Transport_Stop();
+        break;
+
+    case PLAN_ARRIVED:
+        return TRUE;
+
+    default:
+        break;
+    }
+
+    return FALSE;
+}
+
+//*****************************************************************************
+// Return the ticks to sleep until the locate planner must be run again if
+// no new position comes in first. At least one tick is always given up so
+// the loop can't spin on a deadline that has just run out.
+//*****************************************************************************
+
+static UInt LocateDeadline(LOCATE_PLAN* plan, int32_t tape_pos, float velocity)
+{
+    uint32_t ms = LocatePlan_deadline(plan, tape_pos, velocity, Clock_getTicks());
+
+    if (!ms)
+        ms = 1;
+
+    return (ms < LOCATE_WAIT_MAX) ? (UInt)ms : LOCATE_WAIT_MAX;
+}
+
+//*****************************************************************************
+// Return the ticks to sleep until the loop plan must be run again if no
+// new position comes in first, at least one tick and no more than
+// LOCATE_WAIT_MAX.
+//*****************************************************************************
+
+static UInt LoopDeadline(LOOP_PLAN* loop)
+{
+    uint32_t ms = LoopPlan_deadline(loop);
+
+    return (ms < LOCATE_WAIT_MAX) ? (UInt)ms : LOCATE_WAIT_MAX;
+}
+
+//*****************************************************************************
+// Move on to the next cue list step. The step after it is returned in next,
+// or STC_SEQ_END if there is none, so it can be planned while the step runs.
+// Returns FALSE once the cue list has run out.
+//*****************************************************************************
+
+static Bool SequenceNext(SEQ_STEP* step, SEQ_STEP* next)
+{
+    const SEQ_STEP* p;
+    Bool status = FALSE;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    if ((p = CueSeq_next(&s_cueSeq, Clock_getTicks())) != NULL)
+    {
+        *step = *p;
+
+        if ((p = CueSeq_peek(&s_cueSeq)) != NULL)
+            *next = *p;
+        else
+            memset(next, 0, sizeof(SEQ_STEP));
+
+        status = TRUE;
+    }
+
+    Semaphore_post(g_semaCue);
+
+    return status;
+}
+
+//*****************************************************************************
+// End the cue list sequence early.
+//*****************************************************************************
+
+static void SequenceEnd(void)
+{
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    CueSeq_stop(&s_cueSeq);
+
+    Semaphore_post(g_semaCue);
+}
+
+//*****************************************************************************
+// Plan the locate for the next cue list step while a timed step runs. The
+// tape is taken to play on for the ms given, or to stay put if zero, and
+// the time in ms to locate the cue point from there is returned. This is
+// the time the locate planner gives from a stop at its fastest jog
+// velocity, or zero if the next step isn't a locate.
+//*****************************************************************************
+
+static uint32_t SequencePlan(SEQ_STEP* next, int32_t tape_pos, uint32_t ms)
+{
+    STC_LOCATE_MODEL* model = &g_sys.cfgSTC.locateModel;
+    uint32_t flags = 0;
+    uint32_t speed;
+    int32_t dir;
+    int cue_pos = 0;
+    float dist;
+    float eta;
+    float t;
+
+    if (next->op != STC_SEQ_LOCATE)
+        return 0;
+
+    CuePointGet((size_t)next->param, &cue_pos, &flags);
+
+    if (!(flags & CF_ACTIVE))
+        return 0;
+
+    /* Where the tape will be when the step ends at play speed */
+    tape_pos += (int32_t)INCHES_TO_POSITION((float)g_sys.tapeSpeed * (float)ms * 0.001f);
+
+    dist = POSITION_TO_INCHES((float)(cue_pos - tape_pos));
+
+    dir = (dist < 0.0f) ? PLAN_REW : PLAN_FWD;
+
+    dist = fabsf(dist);
+
+    eta = LocatePlan_time(model, dir, PLAN_SPEED_FAR, dist);
+
+    for (speed=PLAN_SPEED_MID; speed < STC_PLAN_SPEEDS; speed++)
+    {
+        if ((t = LocatePlan_time(model, dir, speed, dist)) < eta)
+            eta = t;
+    }
+
+    return (uint32_t)(eta * 1000.0f);
+}
+
+//*****************************************************************************
+// Build the SD card path of a cue store file. The name is used up to the
+// first character that isn't allowed in a plain file name, and an empty
+// name gives the default file. The path buffer must hold at least
+// STC_CUE_NAME_LEN + 8 characters.
+//*****************************************************************************
+
+static void CueStorePath(char* path, const char* name)
+{
+    size_t i = 0;
+
+    strcpy(path, "0:");
+
+    if (name)
+    {
+        while ((i < STC_CUE_NAME_LEN - 1) && name[i] &&
+               (isalnum((int)name[i]) || (name[i] == '_') || (name[i] == '-')))
+        {
+            path[i + 2] = name[i];
+            i++;
+        }
+    }
+
+    path[i + 2] = '\0';
+
+    if (!i)
+        strcat(path, "cues");
+
+    strcat(path, ".cue");
+}
+
+//*****************************************************************************
+// Get the cue points to auto punch on. These are the punch in/out points,
+// or the loop mark in/out points if the punch points aren't both set.
+// Returns FALSE if neither pair is set with the out point after the in.
+//*****************************************************************************
+
+static Bool PunchPoints(size_t* in, size_t* out)
+{
+    if (IsCuePointFlags(CUE_POINT_PUNCH_IN, CF_ACTIVE) &&
+        IsCuePointFlags(CUE_POINT_PUNCH_OUT, CF_ACTIVE))
+    {
+        *in  = CUE_POINT_PUNCH_IN;
+        *out = CUE_POINT_PUNCH_OUT;
+    }
+    else if (IsCuePointFlags(CUE_POINT_MARK_IN, CF_ACTIVE) &&
+             IsCuePointFlags(CUE_POINT_MARK_OUT, CF_ACTIVE))
+    {
+        *in  = CUE_POINT_MARK_IN;
+        *out = CUE_POINT_MARK_OUT;
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    return (g_sys.cuePoint[*out].ipos > g_sys.cuePoint[*in].ipos) ? TRUE : FALSE;
+}
+
+//*****************************************************************************
+// End an auto punch early. A rehearse that punched in and hasn't punched
+// out switches the monitors back. A record punch is left to the transport
+// command that canceled it, as the transport buttons take it out of record.
+//*****************************************************************************
+
+static void PunchEnd(AUTO_PUNCH* punch, Bool rehearse)
+{
+    if (rehearse && (punch->phase == PUNCH_RECORD))
+        TRACK_Manager_rehearse(false);
+
+    punch->phase = PUNCH_DONE;
+}
+
 //*****************************************************************************
 // Pulse and I/O line LOW for the specified ms duration. The following
 // gpio lines are used to control the transport directly. Index should
@@ -65,7 +65,9 @@ typedef struct _CUE_POINT {
 
 typedef enum LocateType {
     LOCATE_SEARCH=0,
-    LOCATE_LOOP
+    LOCATE_LOOP,
+    LOCATE_SEQUENCE,
+    LOCATE_PUNCH
 } LocateType;
 
 typedef struct _LocateMessage {
@@ -74,6 +76,18 @@ typedef struct _LocateMessage {
     uint32_t	param2;
 } LocateMessage;
 
+/* Events that wake the locate task while it is searching. The position
+ * task posts LOCATE_EVT_POSITION with each new motion estimate, so the
+ * locator acts as soon as an encoder sample arrives and otherwise sleeps
+ * until the planner deadline.
+ */
+#define LOCATE_EVT_POSITION Event_Id_00 /* new tape position estimate     */
+#define LOCATE_EVT_COMMAND  Event_Id_01 /* locate request in the mailbox  */
+#define LOCATE_EVT_CANCEL   Event_Id_02 /* search cancel requested        */
+
+#define LOCATE_EVT_ALL      (LOCATE_EVT_POSITION | LOCATE_EVT_COMMAND | \
+                             LOCATE_EVT_CANCEL)
+
 /*** FUNCTION PROTOTYPES ***************************************************/
 
 void CuePointGet(size_t index, int* ipos,  uint32_t* flags);
@@ -87,11 +101,32 @@ Bool IsCuePointFlags(size_t index, uint32_t flags);
 Bool LocateCancel(void);
 Bool LocateSearch(size_t cuePointIndex, uint32_t cue_flags);
 Bool LocateLoop(uint32_t cue_flags);
+Bool LocateSequence(size_t first);
+Bool LocatePunch(uint32_t preroll, uint32_t postroll, Bool rehearse);
 Bool IsLocatorSearching(void);
 Bool IsLocatorAutoLoop(void);
 Bool IsLocatorAutoPunch(void);
+Bool IsLocatorSequencing(void);
+Bool IsLocatorPunching(void);
 Bool IsLocating(void);
 
+Bool SequenceClear(void);
+Bool SequenceStepSet(size_t index, uint32_t op, uint32_t param, uint32_t flags);
+Bool SequenceStepGet(size_t index, uint32_t* op, uint32_t* param, uint32_t* flags);
+Bool SequenceStatus(size_t* step, uint32_t* remaining);
+
+int CueStoreAdd(uint32_t bank, int ipos, uint32_t flags, const char* name);
+Bool CueStoreDelete(int handle);
+size_t CueStoreClearBank(uint32_t bank);
+Bool CueStoreGet(int handle, int* ipos, uint32_t* bank, uint32_t* flags, char* name);
+Bool CueStoreMove(int handle, int ipos);
+Bool CueStoreRename(int handle, const char* name);
+int CueStoreFind(uint32_t bank, int ipos, uint32_t mode, const char* name);
+int CueStoreAt(uint32_t bank, size_t n, size_t* count);
+Bool CueStoreRecall(int handle, size_t index);
+Bool CueStoreLoad(const char* name);
+Bool CueStoreSave(const char* name);
+
 Void LocateTaskFxn(UArg arg0, UArg arg1);
 
 #endif /* _LOCATETASK_H_ */
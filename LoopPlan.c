@@ -0,0 +1,246 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Loop play timing. A loop plays from the mark-in point to the mark-out
+ * point, turns around and locates back to play again, so each pass should
+ * cross mark-in already at play speed and leave the least dead time
+ * between passes.
+ *
+ * While the loop plays this gives the time to send the turnaround, the
+ * command lag ahead of the tape reaching mark-out, so the transport starts
+ * braking on the mark-out point and not before. The locate back is aimed
+ * at a pre-roll point ahead of mark-in by the distance the transport takes
+ * to spin up to play speed, plus a short margin. On the way back it gives
+ * the time to send play while the tape is still shuttling back, so the
+ * transport turns around and runs up to speed short of mark-in without
+ * braking, stopping and settling on the pre-roll point first. The locate
+ * planner only picks the shuttle speed for the way back.
+ *
+ * The spin-up distance and the rate the transport turns from rewind into
+ * play are learned from each pass and kept in the locate model. The turn
+ * rate is learned by speed band, as the command lag the turn is worked
+ * out with is the planner's and the rate takes up the rest of the reel
+ * servo response at each speed. The module runs in encoder counts and
+ * seconds and has no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "LocatePlan.h"
+#include "LoopPlan.h"
+
+/* Static Function Prototypes */
+static void Rolling(LOOP_PLAN* loop, int32_t pos, float velocity);
+static bool Learn(float* value, float sample, float lo, float hi);
+static uint32_t Band(float v);
+
+//*****************************************************************************
+// Start a loop between the mark-in and mark-out points given in encoder
+// counts. The play speed is in IPS. Without the pre-roll each pass starts
+// from a stop on the mark-in point, as a loop in record must so record
+// never starts ahead of mark-in.
+//*****************************************************************************
+
+void LoopPlan_begin(LOOP_PLAN* loop, STC_LOCATE_MODEL* model, bool learn,
+                    int32_t in, int32_t out, float inchesPerTick, float ips,
+                    bool preroll)
+{
+    loop->model         = model;
+    loop->learn         = learn;
+    loop->in            = in;
+    loop->out           = out;
+    loop->inchesPerTick = inchesPerTick;
+    loop->ips           = ips;
+    loop->preroll       = preroll;
+    loop->due           = 0.0f;
+    loop->passes        = 0;
+    loop->rolling       = false;
+    loop->playPos       = in;
+    loop->playVel       = 0.0f;
+    loop->low           = in;
+}
+
+//*****************************************************************************
+// Return the point to locate back to. This is ahead of the mark-in point by
+// the learned spin-up distance and the margin, or mark-in itself without
+// the pre-roll.
+//*****************************************************************************
+
+int32_t LoopPlan_preroll(LOOP_PLAN* loop)
+{
+    float dist = loop->model->spinup + (LOOP_MARGIN_TIME * loop->ips);
+
+    if (!loop->preroll)
+        return loop->in;
+
+    return loop->in - (int32_t)lroundf(dist / loop->inchesPerTick);
+}
+
+//*****************************************************************************
+// Note that play was sent at the tape position and velocity given, so the
+// spin-up to play speed can be measured.
+//*****************************************************************************
+
+void LoopPlan_play(LOOP_PLAN* loop, int32_t pos, float velocity)
+{
+    loop->rolling = true;
+    loop->playPos = pos;
+    loop->playVel = velocity;
+    loop->low     = pos;
+    loop->passes++;
+}
+
+//*****************************************************************************
+// Run the loop from a new tape position and velocity while it plays toward
+// the mark-out point. Returns LOOP_TURN once the turnaround must be sent.
+//*****************************************************************************
+
+LOOP_ACTION LoopPlan_update(LOOP_PLAN* loop, int32_t pos, float velocity)
+{
+    float dist = (float)(loop->out - pos) * loop->inchesPerTick;
+
+    if (loop->rolling)
+        Rolling(loop, pos, velocity);
+
+    if (velocity < LOOP_VEL_MIN)
+    {
+        /* Not moving toward it fast enough to tell when, or still
+         * turning around from the locate back.
+         */
+        loop->due = HUGE_VALF;
+    }
+    else if (dist <= 0.0f)
+    {
+        /* Already at or past the mark-out point */
+        loop->due = 0.0f;
+    }
+    else
+    {
+        /* Sent the command lag ahead so braking starts on mark-out */
+        loop->due = (dist / velocity) - loop->model->lag[PLAN_FWD];
+    }
+
+    return (loop->due > LOOP_DUE_TIME) ? LOOP_NONE : LOOP_TURN;
+}
+
+//*****************************************************************************
+// Run the loop from a new tape position and velocity while it locates back
+// toward the pre-roll point. Returns LOOP_PLAY once play must be sent for
+// the tape to turn around and reach play speed ahead of mark-in. Until then
+// it returns LOOP_HOLD while the tape heads back, and the caller holds off
+// the locate planner so it doesn't brake for the pre-roll point. Returns
+// LOOP_NONE when the planner is to run as for any locate.
+//*****************************************************************************
+
+LOOP_ACTION LoopPlan_return(LOOP_PLAN* loop, int32_t pos, float velocity)
+{
+    STC_LOCATE_MODEL* model = loop->model;
+    float v = -velocity;
+    float room;
+
+    /* Not yet heading back toward mark-in, or stopping on it */
+    if (!loop->preroll || (v < LOOP_VEL_MIN))
+    {
+        loop->due = HUGE_VALF;
+        return LOOP_NONE;
+    }
+
+    /* Inches the tape may still run back before play is sent. Once it is
+     * sent the tape runs on for the command lag and then turns around, and
+     * needs the spin-up distance and margin from there to reach mark-in.
+     */
+    room = ((float)(pos - loop->in) * loop->inchesPerTick) -
+           (v * model->lag[PLAN_REW]) -
+           ((v * v) / (2.0f * model->reverse[Band(v)])) +
+           model->spinup + (LOOP_MARGIN_TIME * loop->ips) + (LOOP_TURN_SPREAD * v);
+
+    /* The tape is slowing, so this errs on the early side */
+    loop->due = room / v;
+
+    return (loop->due > LOOP_DUE_TIME) ? LOOP_HOLD : LOOP_PLAY;
+}
+
+//*****************************************************************************
+// Return the ms the caller may sleep before the next loop action is due,
+// or UINT32_MAX if none is due yet. This is at least 1 ms, as the caller
+// can't wake any sooner.
+//*****************************************************************************
+
+uint32_t LoopPlan_deadline(LOOP_PLAN* loop)
+{
+    float ms;
+
+    if ((ms = loop->due * 1000.0f) >= (float)UINT32_MAX)
+        return UINT32_MAX;
+
+    /* Round down so the update runs no later than the action is due */
+    return (ms < 1.0f) ? 1 : (uint32_t)ms;
+}
+
+/* Learn the spin-up and turnaround once the tape is up to play speed */
+static void Rolling(LOOP_PLAN* loop, int32_t pos, float velocity)
+{
+    STC_LOCATE_MODEL* model = loop->model;
+    float v0 = -loop->playVel;
+    float dist;
+
+    if (pos < loop->low)
+        loop->low = pos;
+
+    if (velocity < (LOOP_AT_SPEED * loop->ips))
+        return;
+
+    loop->rolling = false;
+
+    if (!loop->learn)
+        return;
+
+    /* Distance run up to speed from where the tape turned or stood */
+    Learn(&model->spinup, (float)(pos - loop->low) * loop->inchesPerTick,
+          LOOP_SPINUP_MIN, LOOP_SPINUP_MAX);
+
+    /* Play sent heading back, so the turn gives the reversing rate */
+    if (v0 < LOOP_VEL_MIN)
+        return;
+
+    dist = ((float)(loop->playPos - loop->low) * loop->inchesPerTick) -
+           (v0 * model->lag[PLAN_REW]);
+
+    if (dist > 0.0f)
+        Learn(&model->reverse[Band(v0)], (v0 * v0) / (2.0f * dist),
+              PLAN_RATE_MIN, PLAN_RATE_MAX);
+}
+
+/* Speed band the turn rate is learned in for a speed in IPS */
+static uint32_t Band(float v)
+{
+    uint32_t band = (uint32_t)(v / PLAN_BAND_IPS);
+
+    return (band < STC_PLAN_BANDS) ? band : (STC_PLAN_BANDS - 1);
+}
+
+/* Move a model value toward a new measurement if it is in range */
+static bool Learn(float* value, float sample, float lo, float hi)
+{
+    if ((sample < lo) || (sample > hi))
+        return false;
+
+    *value += PLAN_LEARN_RATE * (sample - *value);
+
+    return true;
+}
+
+/* End-Of-File */
@@ -0,0 +1,91 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _LOOPPLAN_H_
+#define _LOOPPLAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Seconds of play at full speed allowed for ahead of the mark-in point.
+ * This takes up any error in the learned spin-up.
+ */
+#define LOOP_MARGIN_TIME        0.200f
+
+/* Seconds at the speed heading back allowed for the spread in the
+ * command lag and the update timing when play is sent on the way back.
+ */
+#define LOOP_TURN_SPREAD        0.010f
+
+/* Tape is up to play speed at this fraction of the play speed */
+#define LOOP_AT_SPEED           0.95f
+
+/* Below this tape speed in IPS the time to mark-out is worked out at this
+ * speed, and the tape is not yet counted as heading back to mark-in.
+ */
+#define LOOP_VEL_MIN            2.5f
+
+/* An action is taken once it is due within this many seconds, half of the
+ * 1 ms system tick the caller wakes on.
+ */
+#define LOOP_DUE_TIME           0.0005f
+
+/* Spin-up distances in inches outside these limits are not learned */
+#define LOOP_SPINUP_MIN         0.1f
+#define LOOP_SPINUP_MAX         60.0f
+
+/* Loop actions returned for the locator to carry out */
+typedef enum _LOOP_ACTION {
+    LOOP_NONE,                  /* nothing to do this update        */
+    LOOP_TURN,                  /* start the locate back to mark-in */
+    LOOP_HOLD,                  /* shuttle on back, planner held off */
+    LOOP_PLAY,                  /* put the transport in play now    */
+} LOOP_ACTION;
+
+/*** LOOP PLAN DATA ********************************************************/
+
+typedef struct _LOOP_PLAN {
+    STC_LOCATE_MODEL* model;    /* transport model, in the config   */
+    bool        learn;          /* update the model from this loop  */
+    int32_t     in;             /* mark-in encoder count            */
+    int32_t     out;            /* mark-out encoder count           */
+    float       inchesPerTick;
+    float       ips;            /* play speed in IPS                */
+    bool        preroll;        /* roll up to speed ahead of mark-in */
+    float       due;            /* seconds until the next action    */
+    uint32_t    passes;         /* times play was sent              */
+    /* Measurements for learning the model */
+    bool        rolling;        /* play sent, not yet up to speed   */
+    int32_t     playPos;        /* position play was sent           */
+    float       playVel;        /* velocity play was sent at        */
+    int32_t     low;            /* furthest back since play was sent */
+} LOOP_PLAN;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void LoopPlan_begin(LOOP_PLAN* loop, STC_LOCATE_MODEL* model, bool learn,
+                    int32_t in, int32_t out, float inchesPerTick, float ips,
+                    bool preroll);
+
+int32_t LoopPlan_preroll(LOOP_PLAN* loop);
+
+void LoopPlan_play(LOOP_PLAN* loop, int32_t pos, float velocity);
+
+LOOP_ACTION LoopPlan_update(LOOP_PLAN* loop, int32_t pos, float velocity);
+
+LOOP_ACTION LoopPlan_return(LOOP_PLAN* loop, int32_t pos, float velocity);
+
+uint32_t LoopPlan_deadline(LOOP_PLAN* loop);
+
+#endif  /* _LOOPPLAN_H_ */
@@ -105,6 +105,7 @@ static Void MasterTaskFxn(UArg arg0, UArg arg1);
 static Void SlaveTaskFxn(UArg arg0, UArg arg1);
 static int SlaveRxCommand(MIDI_Handle handle, uint8_t* pbyDeviceID, uint8_t* pBuffer, int* puNumBytesRead);
 static int SlaveTxResponse(MIDI_Handle handle, uint8_t* pBuffer, int uNumBytesToWrite);
+static int MasterTxCommand(MIDI_Handle handle, uint8_t* pBuffer, int uNumBytesToWrite);
 
 //*****************************************************************************
 // MIDI Controller Construction/Destruction
@@ -258,9 +259,31 @@ Bool MIDI_Server_startup(void)
 
 Bool MidiQueueResponse(MidiMessage* msg)
 {
+    msg->type = MIDI_MCR;
+
     return Mailbox_post(g_mailboxMidi, msg, 500);
 }
 
+//*****************************************************************************
+// Queue a single byte MMC command to send out the MIDI port. This never
+// waits, so it may be called from the position task. The command is
+// dropped if the queue is full or the MIDI server isn't running.
+//*****************************************************************************
+
+Bool MidiQueueCommand(uint8_t command)
+{
+    MidiMessage msg;
+
+    if (!g_mailboxMidi)
+        return FALSE;
+
+    msg.type    = MIDI_MCC;
+    msg.length  = 1;
+    msg.data[0] = command;
+
+    return Mailbox_post(g_mailboxMidi, &msg, BIOS_NO_WAIT);
+}
+
 //*****************************************************************************
 //
 //*****************************************************************************
@@ -273,7 +296,10 @@ Void MasterTaskFxn(UArg arg0, UArg arg1)
     {
         if (Mailbox_pend(g_mailboxMidi, &msgMidi, BIOS_WAIT_FOREVER))
         {
-            SlaveTxResponse(g_midiHandle, msgMidi.data, msgMidi.length);
+            if (msgMidi.type == MIDI_MCC)
+                MasterTxCommand(g_midiHandle, msgMidi.data, msgMidi.length);
+            else
+                SlaveTxResponse(g_midiHandle, msgMidi.data, msgMidi.length);
         }
     }
 }
@@ -479,4 +505,33 @@ int SlaveTxResponse(MIDI_Handle handle, uint8_t* pBuffer, int uNumBytesToWrite)
     return uNumBytesToWrite;
 }
 
+//*****************************************************************************
+// Send a MIDI MCC command packet out to the other machines.
+//*****************************************************************************
+
+int MasterTxCommand(MIDI_Handle handle, uint8_t* pBuffer, int uNumBytesToWrite)
+{
+    uint8_t b;
+    uint8_t hdr[4];
+
+    hdr[0] = 0xF0;                  /* 0xF0 Preamble */
+    hdr[1] = 0x7F;                  /* 0x7F Preamble */
+    hdr[2] = handle->deviceID;      /* the device ID */
+    hdr[3] = MIDI_MCC;              /* motion control command byte */
+
+    /* Write the command packet header */
+    if (UART_write(handle->uartHandle, hdr, 4) != 4)
+        return MIDI_ERR_TIMEOUT;
+
+    /* Write the command data */
+    if (UART_write(handle->uartHandle, pBuffer, uNumBytesToWrite) != uNumBytesToWrite)
+        return MIDI_ERR_TIMEOUT;
+
+    /* Write the command packet termination indicator byte */
+    b = 0xF7;
+    UART_write(handle->uartHandle, &b, 1);
+
+    return uNumBytesToWrite;
+}
+
 // End-Of-File
@@ -137,6 +137,7 @@ typedef MIDI_Object *MIDI_Handle;
 #define MIDI_MAX_PACKET_SIZE        48
 
 typedef struct MidiMessage {
+    uint8_t     type;           /* MIDI_MCC command or MIDI_MCR response */
     uint8_t     length;
     uint8_t     data[8];
 } MidiMessage;
@@ -153,5 +154,6 @@ Bool MIDI_Server_init(void);
 Bool MIDI_Server_startup(void);
 
 Bool MidiQueueResponse(MidiMessage* msg);
+Bool MidiQueueCommand(uint8_t command);
 
 #endif /* _MIDITASK_H_ */
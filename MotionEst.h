@@ -0,0 +1,100 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _MOTIONEST_H_
+#define _MOTIONEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* If the encoder count has not changed for this long the tape is taken
+ * as stopped and the velocity and acceleration estimates are zeroed. At
+ * 80 ticks per roller revolution this is about 1.25 IPS.
+ */
+#define MOTION_STOP_TIME        0.050f
+
+/* The tape is taken as stopped once no encoder edge has come for this
+ * many of the last edge intervals, or MOTION_STOP_TIME if that is longer.
+ * This holds the moving flag through the gaps between edges at creep
+ * speeds while a stop at play speed is seen after MOTION_STOP_TIME. It
+ * is never longer than MOTION_EDGE_SPAN_MAX.
+ */
+#define MOTION_STOP_EDGES       2.0f
+
+/* Limit on how far ahead of the last sample a position is predicted */
+#define MOTION_PREDICT_MAX      0.050f
+
+/* Number of encoder edge events kept for the period velocity. The period
+ * is measured over as few edges as span at least MOTION_EDGE_SPAN_MIN,
+ * and edges older than MOTION_EDGE_SPAN_MAX are not used.
+ */
+#define MOTION_EDGES            16
+#define MOTION_EDGE_SPAN_MIN    0.050f
+#define MOTION_EDGE_SPAN_MAX    0.250f
+
+/* Below MOTION_BLEND_LO the velocity comes from the encoder edge period,
+ * above MOTION_BLEND_HI from the tracking filter. In between the two are
+ * blended linearly. These are in IPS.
+ */
+#define MOTION_BLEND_LO         3.0f
+#define MOTION_BLEND_HI         10.0f
+
+/*** MOTION ESTIMATOR DATA *************************************************/
+
+/* Snapshot of the estimator output. The position is split into the
+ * encoder count and a sub-tick offset so no precision is lost when the
+ * count gets large.
+ */
+typedef struct _MOTION_STATE {
+    uint32_t    timestamp;      /* timestamp count of the estimate */
+    int32_t     position;       /* encoder count at the timestamp  */
+    float       offset;         /* filtered offset from count      */
+    float       velocity;       /* tape velocity in IPS, signed    */
+    float       velocityPeriod; /* edge period velocity in IPS     */
+    float       accel;          /* tape acceleration in IPS/sec    */
+    bool        moving;         /* false once the tape has stopped */
+} MOTION_STATE;
+
+/* Alpha-beta-gamma tracking filter state. The filter runs in encoder
+ * ticks and seconds. The position estimate is held as an offset from
+ * the last measured count.
+ */
+typedef struct _MOTION_EST {
+    float       secsPerCount;   /* timestamp period in seconds     */
+    float       inchesPerTick;  /* roller travel per encoder tick  */
+    float       x;              /* position offset in ticks        */
+    float       v;              /* velocity in ticks/sec           */
+    float       a;              /* acceleration in ticks/sec^2     */
+    int64_t     count;          /* last measured encoder count     */
+    uint32_t    timestamp;      /* time of the last measurement    */
+    uint32_t    moveTime;       /* time the count last changed     */
+    bool        seeded;         /* false until the first sample    */
+    /* Encoder edge event history for the period velocity */
+    uint32_t    edgeTime[MOTION_EDGES];
+    int64_t     edgeCount[MOTION_EDGES];
+    uint32_t    edgeHead;       /* index of the newest edge event  */
+    uint32_t    edgeNum;        /* number of edge events held      */
+} MOTION_EST;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void MotionEst_init(MOTION_EST* est, uint32_t timestampFreq, float inchesPerTick);
+void MotionEst_reset(MOTION_EST* est);
+void MotionEst_setScale(MOTION_EST* est, float inchesPerTick);
+void MotionEst_update(MOTION_EST* est, int64_t count, uint32_t timestamp);
+void MotionEst_getState(MOTION_EST* est, MOTION_STATE* state);
+
+float MotionEst_predict(MOTION_EST* est, MOTION_STATE* state, uint32_t timestamp);
+
+#endif  /* _MOTIONEST_H_ */
@@ -46,6 +46,8 @@
 #include <xdc/runtime/System.h>
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/Gate.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
 
 /* BIOS Header files */
 #include <ti/sysbios/BIOS.h>
@@ -53,6 +55,7 @@
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Mailbox.h>
 #include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/gates/GateMutex.h>
 #include <ti/sysbios/family/arm/m3/Hwi.h>
 
@@ -92,19 +95,58 @@
 #include "STC1200.h"
 #include "Board.h"
 #include "IPCMessage.h"
+#include "IPCCommands.h"
 #include "TrackCtrl.h"
+#include "SMPTE.h"
+#include "Display7Seg.h"
+#include "Seqlock.h"
+#include "MidiTask.h"
+#include "Timeline.h"
+
+/* Global Data Items */
+QEI_RING g_qeiRing;
+
+/* External Data Items */
+extern Event_Handle g_eventLocate;
 
 /* Static Data Items */
 static Hwi_Struct qeiHwiStruct;
+static QEI_READER s_qeiReader;
+static int64_t    s_qeiCount;
+static uint32_t   s_qeiLast;
+static bool       s_qeiReset;
+static MOTION_EST s_motion;
+static SEQLOCK s_motionLock;
+static volatile POSITION_STATE s_motionState[2];
+static SLIP_DETECT s_slip;
+static INDEX_CHECK s_index;
+static int32_t    s_indexRaw;
+static uint32_t   s_indexLast;
+static DISP7_LINK s_disp7;
+
+/* Position timeline events, guarded by g_semaTimeline */
+static TIMELINE   s_timeline;
+static bool       s_timelineSeek;
+static bool       s_timelinePost;
+
+/* Aux outputs a timeline GPIO event may drive */
+static const uint32_t s_timelineGPIO[] = {
+    Board_EXPIO_PK2,
+};
+
+#define TIMELINE_GPIO_COUNT     (sizeof(s_timelineGPIO) / sizeof(s_timelineGPIO[0]))
 
 /* Static Function Prototypes */
 
 void QEI_initialize(void);
-void Write7SegDisplay(UART_Handle handle, TAPETIME* p);
+static void Write7SegDisplay(UART_Handle handle, TAPETIME* p);
 
 static void StandbyModeEnter(void);
 static void StandbyModeLeave(void);
 static Void QEIHwi(UArg arg);
+static void TapeTimeConfigure(void);
+static void TimelineUpdate(int32_t ipos);
+static void TimelineFire(const TL_ENTRY* entry, int dir, void* arg);
 
 /*****************************************************************************
  * These handlers are called whenever the transport enters or leaves standby
@@ -128,118 +170,236 @@ void StandbyModeLeave(void)
 
 void PositionZeroReset(void)
 {
+    UInt key = Hwi_disable();
+
 	QEIPositionSet(QEI_BASE_ROLLER, 0);
+
+	/* Reset the unwrapped position count kept by the ISR */
+	s_qeiLast  = 0;
+	s_qeiCount = 0;
+
+	/* Tag the next sample so the motion estimator starts over */
+	s_qeiReset = true;
+
+	Hwi_restore(key);
 }
 
 /*****************************************************************************
- * Convert absolute encoder position to tape time units.
+ * Move the tape position count by the number of ticks given. This is used
+ * to correct the position for distance the roller missed while slipping.
  *****************************************************************************/
 
-/* The MM1200 timer-counter roller wheel measures closely to 1.592
- * in diameter. This gives a circumference of 5.0014 (c = PI * d).
- * Thus, one revolution of the tachometer wheel equals 5 of
- * tape travel.
- *
- * The formula for time traveled is distance/speed:
- *
- *     time     = distance / speed
- *     speed    = distance / time
- *     distance = speed * time
- *
- * The tape moves on the transport at either 15 or 30 inches per
- * second (IPS) depending on the speed switch setting.
- *
- * The time taken to cover 30 inches of tape travel is one second.
- *
- * The time taken to cover 1 inch of tape travel is 1/30 of a second.
- *
- *     time = (distance inches / 30 inches) * second
- */
+void PositionAdjust(int32_t ticks)
+{
+    UInt key = Hwi_disable();
 
-#define INV_ROLLER_TICKS_PER_REV    (1.0f / ROLLER_TICKS_PER_REV_F)
+    s_qeiCount += ticks;
 
-void PositionToTapeTime(int tapePosition, TAPETIME* tapeTime)
+    Hwi_restore(key);
+}
+
+/*****************************************************************************
+ * Return a copy of the roller index pulse check statistics.
+ *****************************************************************************/
+
+void PositionGetIndexStats(INDEX_STATS* stats)
 {
-    /* Get the current encoder position */
-    //float position = fabsf((float)tapePosition);
-    float position = (float)tapePosition;
+    *stats = s_index.stats;
+}
 
-    /* Calculate the number of revolutions from the position */
-    //float revolutions = position / ROLLER_TICKS_PER_REV_F;
-    float revolutions = position * INV_ROLLER_TICKS_PER_REV;
+/*****************************************************************************
+ * Return a copy of the most recent tape motion estimate.
+ *****************************************************************************/
 
-    /* Calculate the distance in inches based on the number of revolutions */
-    float distance = revolutions * ROLLER_CIRCUMFERENCE_F;
+void PositionGetMotion(MOTION_STATE* state)
+{
+    POSITION_STATE pos;
 
-    /* Get the current speed setting */
-    float invspeed = GPIO_read(Board_SPEED_SELECT) ? (1.0f/30.0f) : (1.0f/15.0f);
+    PositionGetState(&pos);
 
-    /* Finally, calculate the time in seconds from the distance
-     * and speed while avoiding any divisions.
-     */
-    float seconds = distance * invspeed;
+    *state = pos.motion;
+}
 
-    /* Convert the total seconds value into binary H:MM:SS:T values */
-    SecondsToTapeTime(seconds, tapeTime);
+/*****************************************************************************
+ * Return a copy of the most recent tape motion estimate along with the
+ * roller tach and direction of the encoder sample it was made from.
+ *****************************************************************************/
+
+void PositionGetState(POSITION_STATE* state)
+{
+    uint32_t seq;
+
+    do {
+        seq = Seqlock_readBegin(&s_motionLock);
+
+        *state = s_motionState[Seqlock_index(seq)];
+
+    } while (Seqlock_readRetry(&s_motionLock, seq));
 }
 
 /*****************************************************************************
- * Convert tape time to absolute encoder position units.
+ * Return the tape position predicted for the current time from the most
+ * recent motion estimate. If state is not NULL the estimate used is
+ * returned also.
  *****************************************************************************/
 
-void TapeTimeToPosition(TAPETIME* tapeTime, int* tapePosition)
+int32_t PositionPredict(MOTION_STATE* state)
 {
-    float time;
+    int32_t position;
+    POSITION_STATE pos;
 
-    /* Convert tape to total seconds */
-    TapeTimeToSeconds(tapeTime, &time);
+    position = PositionPredictState(&pos);
 
-    /* Get the current speed setting */
-    float speed = GPIO_read(Board_SPEED_SELECT) ? 30.0f : 15.0f;
+    if (state)
+        *state = pos.motion;
 
-    /* Calculate the distance in inches */
-    float distance = speed * time;
+    return position;
+}
 
-    float position = (distance / ROLLER_CIRCUMFERENCE_F) * ROLLER_TICKS_PER_REV_F;
+/*****************************************************************************
+ * As PositionPredict(), but returns the whole position state the
+ * prediction was made from, tach and direction included.
+ *****************************************************************************/
+
+int32_t PositionPredictState(POSITION_STATE* state)
+{
+    float offset;
 
-    *tapePosition = (int)position;
+    PositionGetState(state);
+
+    offset = MotionEst_predict(&s_motion, &state->motion, Timestamp_get32());
+
+    return state->motion.position + (int32_t)lroundf(offset);
 }
 
-/****************************************************************************
- * This function takes a 32-bit time value in total seconds and
- * calculates the hours, minutes and seconds members.
- ***************************************************************************/
+/*****************************************************************************
+ * Add an event to the position timeline. Returns the index of the event
+ * in tape position order, or TL_NONE if the timeline is full or the event
+ * is not valid.
+ *****************************************************************************/
+
+int TimelineAdd(int32_t ipos, uint32_t action, uint32_t flags, uint32_t arg, uint32_t param)
+{
+    int index;
+    TL_ENTRY entry;
+
+    if ((action > STC_TL_EVENT) || (flags > 0xFF) || (arg > 0xFFFF))
+        return TL_NONE;
+
+    entry.ipos   = ipos;
+    entry.action = (uint8_t)action;
+    entry.flags  = (uint8_t)flags;
+    entry.arg    = (uint16_t)arg;
+    entry.param  = param;
+
+    Semaphore_pend(g_semaTimeline, BIOS_WAIT_FOREVER);
+
+    index = Timeline_add(&s_timeline, &entry);
 
-#define SECS_DAY    (24L * 60L * 60L)
+    Semaphore_post(g_semaTimeline);
 
-void SecondsToTapeTime(float time, TAPETIME* p)
+    return index;
+}
+
+/*****************************************************************************
+ * Delete an event from the position timeline by index, or all events for
+ * STC_TL_ALL. Returns the number of events deleted.
+ *****************************************************************************/
+
+size_t TimelineDelete(int index)
 {
-    float ftime = fabsf(time);
+    size_t count = 0;
 
-    uint32_t dayclock = (uint32_t)ftime % SECS_DAY;
+    Semaphore_pend(g_semaTimeline, BIOS_WAIT_FOREVER);
 
-    float intpart;
-    float fractpart = modff(ftime, &intpart);
+    if (index == STC_TL_ALL)
+    {
+        count = Timeline_count(&s_timeline);
+        Timeline_clear(&s_timeline);
+    }
+    else if (Timeline_remove(&s_timeline, index))
+    {
+        count = 1;
+    }
+
+    Semaphore_post(g_semaTimeline);
+
+    return count;
+}
+
+/*****************************************************************************
+ * Return a copy of a position timeline event by index and the number of
+ * events in the timeline.
+ *****************************************************************************/
+
+bool TimelineGet(int index, int32_t* ipos, uint32_t* action, uint32_t* flags,
+                 uint32_t* arg, uint32_t* param, size_t* count)
+{
+    const TL_ENTRY* entry;
+
+    Semaphore_pend(g_semaTimeline, BIOS_WAIT_FOREVER);
+
+    *count = Timeline_count(&s_timeline);
 
-    p->hour  = (uint8_t)(dayclock / 3600);
-    p->mins  = (uint8_t)((dayclock % 3600) / 60);
-    p->secs  = (uint8_t)(dayclock % 60);
-    p->tens  = (uint8_t)(fractpart * 10.0f);
-    p->frame = (uint8_t)(fractpart * 30.0f);
-    p->flags = (time < 0.0f) ? 0 : F_PLUS;
+    if ((entry = Timeline_get(&s_timeline, index)) != NULL)
+    {
+        *ipos   = entry->ipos;
+        *action = entry->action;
+        *flags  = entry->flags;
+        *arg    = entry->arg;
+        *param  = entry->param;
+    }
+
+    Semaphore_post(g_semaTimeline);
+
+    return (entry != NULL) ? true : false;
 }
 
-void TapeTimeToSeconds(TAPETIME* p, float* time)
+/*****************************************************************************
+ * Set the tape speed and frame rate used for tape time conversions. The
+ * speed select switch is read here once per pass of the position task
+ * rather than on every conversion. The calibrated roller circumference
+ * is also applied here so a new calibration takes effect right away.
+ *****************************************************************************/
+
+void TapeTimeConfigure(void)
 {
-    float secs;
+    uint32_t ips = GPIO_read(Board_SPEED_SELECT) ? 30 : 15;
+    uint32_t circumference = g_sys.cfgSTC.rollerCircumference;
 
-    secs  = (float)(p->hour * 3600);
-    secs += (float)(p->mins % 3600) * 60.0f;
-    secs += (float)(p->secs % 60);
-    secs += (float)(p->tens % 10) * 0.10f;
-  //secs += (float)(p->frame % 30) * (1.0f/30.0f);
+    if (circumference != TapeTime_getCircumference())
+    {
+        /* Put a bad value back to nominal in the config too, or it would
+         * not match and be applied again on every pass.
+         */
+        if (!TapeTime_setCircumference(circumference))
+        {
+            TapeTime_setCircumference(ROLLER_CIRCUMFERENCE_UIN);
+            g_sys.cfgSTC.rollerCircumference = ROLLER_CIRCUMFERENCE_UIN;
+        }
 
-    *time = secs + 0.1f;
+        MotionEst_setScale(&s_motion, ROLLER_CIRCUMFERENCE() / ROLLER_TICKS_PER_REV_F);
+    }
+
+    switch(g_sys.cfgSTC.smpteFPS)
+    {
+    case SMPTE_CTL_FPS24:
+        TapeTime_configure(ips, 24, false);
+        break;
+
+    case SMPTE_CTL_FPS25:
+        TapeTime_configure(ips, 25, false);
+        break;
+
+    case SMPTE_CTL_FPS30D:
+        TapeTime_configure(ips, 30, true);
+        break;
+
+    case SMPTE_CTL_FPS30:
+    default:
+        TapeTime_configure(ips, 30, false);
+        break;
+    }
 }
 
 //*****************************************************************************
@@ -251,10 +411,14 @@ void TapeTimeToSeconds(TAPETIME* p, float* time)
 
 Void PositionTaskFxn(UArg arg0, UArg arg1)
 {
+    bool got;
     uint8_t mode;
-	uint32_t rcount = 0;
+	QEI_SAMPLE sample;
 	UART_Params uartParams;
 	UART_Handle uartHandle;
+	MOTION_STATE motion;
+	POSITION_STATE pos;
+	Types_FreqHz freq;
     Error_Block eb;
 
 	/* Create interrupt signal event */
@@ -264,6 +428,20 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
 	/* Initialize the quadrature encoder module */
 	QEI_initialize();
 
+	/* Attach to the encoder sample ring */
+	QEIRing_readerInit(&g_qeiRing, &s_qeiReader);
+
+	/* Initialize the tape motion estimator */
+	Timestamp_getFreq(&freq);
+
+	MotionEst_init(&s_motion, freq.lo, ROLLER_CIRCUMFERENCE() / ROLLER_TICKS_PER_REV_F);
+
+	/* Initialize the roller index pulse check */
+	IndexCheck_init(&s_index);
+
+	/* Start with an empty timeline at the first sample position */
+	Timeline_init(&s_timeline);
+
 	/* Initialize the UART to the ATmegaa88 */
 	UART_Params_init(&uartParams);
 	uartParams.readMode       = UART_MODE_BLOCKING;
@@ -287,6 +465,8 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
 
 	uartHandle = UART_open(Board_UART_ATMEGA88, &uartParams);
 
+	Disp7_init(&s_disp7, DISP7_EXTENDED);
+
 	/* This is the main tape position/counter task. Here we read the tape
 	 * roller quadrature encoder to keep track of the absolute tape position.
 	 * This position is relative to the last counter reset, either at power
@@ -297,14 +477,29 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
 
     while (TRUE)
     {
-    	/* Wait for any ISR events to be posted */
+    	/* Wait for the ISR to post new encoder samples to the ring */
     	UInt events = Event_pend(g_sys.handleEventQEI, Event_Id_NONE, Event_Id_00 | Event_Id_01, 5);
 
-    	/* not used */
-    	if (events & Event_Id_00)
-        {
-
-        }
+    	/* If no encoder interrupts occurred within the last 5ms, post the
+    	 * QEI interrupt so the ISR captures a poll sample. This keeps the
+    	 * ISR as the only writer to the ring and still gives us position
+    	 * samples between the 25ms velocity timer interrupts.
+    	 *
+    	 * This is safe against a real QEI interrupt coming in at the same
+    	 * time. Hwi_post() only sets the NVIC pending bit the QEI itself
+    	 * sets, so if both are pending the ISR runs once, takes the status
+    	 * bits the QEI raised and tags that one sample with them. If the ISR
+    	 * is already running, the post makes it run once more after it
+    	 * returns, which adds a poll sample. The ISR can't preempt itself,
+    	 * so it stays the only writer to the ring either way. Status bits
+    	 * raised after the ISR reads them are not cleared and interrupt
+    	 * again.
+    	 */
+    	if (!events)
+    	{
+    	    Hwi_post(INT_QEI0);
+    	    continue;
+    	}
 
     	/* Quadrature encoder error interrupt */
     	if (events & Event_Id_01)
@@ -313,11 +508,79 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
     		System_flush();
     	}
 
-    	/* Read the tape roller tachometer value */
-    	g_sys.tapeTach = QEIVelocityGet(QEI_BASE_ROLLER);
+    	/* Drain the sample ring, running each sample through the motion
+    	 * estimator. The newest sample is left in the sample buffer.
+    	 */
+    	got = false;
+
+    	while (QEIRing_get(&g_qeiRing, &s_qeiReader, &sample))
+    	{
+    	    if (sample.source & QEI_SRC_RESET)
+    	    {
+    	        MotionEst_reset(&s_motion);
+
+    	        /* The encoder counter was zeroed */
+    	        IndexCheck_reset(&s_index);
+    	        s_indexRaw  = 0;
+    	        s_indexLast = 0;
+
+    	        /* Don't fire the events between the old and new count */
+    	        s_timelineSeek = true;
+    	    }
+
+    	    /* Count the raw encoder ticks, without any corrections made to
+    	     * the position, for the index pulse check.
+    	     */
+    	    s_indexRaw += POSITION_DELTA(sample.position, s_indexLast);
+    	    s_indexLast = sample.position;
+
+    	    /* Correct any encoder miscount found at the index pulse */
+    	    if (sample.source & QEI_SRC_INDEX)
+    	    {
+    	        int32_t ticks = IndexCheck_update(&s_index, s_indexRaw, sample.direction);
+
+    	        if (ticks)
+    	            PositionAdjust(ticks);
+    	    }
+
+    	    MotionEst_update(&s_motion, sample.count, sample.timestamp);
+
+    	    /* Fire any timeline events crossed since the last sample */
+    	    TimelineUpdate((int32_t)sample.count);
+
+    	    got = true;
+    	}
+
+    	if (!got)
+    	    continue;
 
-    	/* Get the tape direction status from the QEI controller */
-    	g_sys.tapeDirection = QEIDirectionGet(QEI_BASE_ROLLER);
+    	/* Publish the new motion estimate */
+    	MotionEst_getState(&s_motion, &motion);
+
+    	/* With the tach and direction of the newest sample taken */
+    	pos.motion    = motion;
+    	pos.tach      = (float)sample.velocity;
+    	pos.direction = sample.direction;
+
+    	Seqlock_writeBegin(&s_motionLock);
+    	s_motionState[0] = pos;
+    	Seqlock_writeSwap(&s_motionLock);
+    	s_motionState[1] = pos;
+
+    	/* Wake the locator to act on the new position */
+    	Event_post(g_eventLocate, LOCATE_EVT_POSITION);
+
+    	g_sys.tapeVelocity = motion.velocity;
+    	g_sys.tapeAccel    = motion.accel;
+
+    	/* Time the current position and velocity were captured */
+    	g_sys.tapeTimestamp = sample.timestamp;
+
+    	/* The tape roller tachometer value */
+    	g_sys.tapeTach = (float)sample.velocity;
+
+    	/* The tape direction status from the QEI controller */
+    	g_sys.tapeDirection = sample.direction;
 
     	/* Set the tape direction output indicator pin either high or low
 		 * 1 = tape forward direction, 0 = tape rewind direction
@@ -327,14 +590,17 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
     	else
     		GPIO_write(Board_TAPE_DIR, PIN_LOW);
 
-    	/* Read the absolute position from the QEI controller */
-    	g_sys.tapePositionAbs = QEIPositionGet(QEI_BASE_ROLLER);
+    	/* The absolute position from the QEI controller */
+    	g_sys.tapePositionAbs = sample.position;
 
-    	/* Convert absolute tape position to signed relative position */
-    	g_sys.tapePosition = POSITION_TO_INT(g_sys.tapePositionAbs);
+    	/* The signed position count unwrapped by the ISR */
+    	g_sys.tapePosition = (int32_t)sample.count;
 
-        /* Get the tape time member values */
-        PositionToTapeTime(g_sys.tapePosition, &g_sys.tapeTime);
+    	/* Pick up any speed or frame rate change */
+    	TapeTimeConfigure();
+
+        /* Get the tape time member values from the filtered position */
+        PositionToTapeTime(motion.position + (int32_t)lroundf(motion.offset), &g_sys.tapeTime);
 
     	/* Here we're determining if any motion is present by looking at the previous
     	 * position and comparing to the current position. If the position has changed,
@@ -382,7 +648,7 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
             if ((mode == MODE_STOP) || (mode == MODE_HALT) || (mode == MODE_THREAD))
             {
                 /* Wait until no motion */
-                if (g_sys.tapeTach == 0)
+                if (!motion.moving)
                 {
                     /* If we were not already in standby mode,
                      * then switch to standby mode now.
@@ -418,24 +684,180 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
             }
     	}
 
-    	/* Check if time to refresh the 7-segment display on the machine */
+        /* Blink 7-seg display during searches */
+        if (g_sys.cfgSTC.searchBlink)
+        {
+            if (g_sys.searching)
+                g_sys.tapeTime.flags |= F_BLINK;
+            else
+                g_sys.tapeTime.flags &= ~(F_BLINK);
+        }
 
-    	if (++rcount >= 20)
-    	{
-    		rcount = 0;
+        /* Publish the new position and tape time snapshot */
+        TransportState_publishPosition();
 
-			/* Blink 7-seg display during searches */
-			if (g_sys.cfgSTC.searchBlink)
-			{
-                if (g_sys.searching)
-                    g_sys.tapeTime.flags |= F_BLINK;
-                else
-                    g_sys.tapeTime.flags &= ~(F_BLINK);
-			}
+        /* Tell the TCP clients about any timeline event posted */
+        if (s_timelinePost)
+        {
+            s_timelinePost = false;
+            Event_post(g_eventTransport, Event_Id_00);
+        }
 
-			/* Refresh the 7-segment display with the new values */
-			Write7SegDisplay(uartHandle, &g_sys.tapeTime);
-    	}
+        /* Refresh the 7-segment display if anything shown has changed */
+        Write7SegDisplay(uartHandle, &g_sys.tapeTime);
+    }
+}
+
+/*****************************************************************************
+ * Advance the position timeline to a new encoder sample position. This
+ * never waits on a timeline edit in progress. If an edit holds the lock
+ * the events crossed fire on the first sample after the edit is done.
+ *****************************************************************************/
+
+void TimelineUpdate(int32_t ipos)
+{
+    if (!Semaphore_pend(g_semaTimeline, BIOS_NO_WAIT))
+        return;
+
+    if (s_timelineSeek)
+    {
+        s_timelineSeek = false;
+        Timeline_seek(&s_timeline, ipos);
+    }
+    else
+    {
+        Timeline_advance(&s_timeline, ipos, TimelineFire, NULL);
+    }
+
+    Semaphore_post(g_semaTimeline);
+}
+
+/*****************************************************************************
+ * Run the action for a timeline event the tape crossed. This is called
+ * from the sample loop of the position task, so each action only posts
+ * its work or sets a pin and never blocks.
+ *****************************************************************************/
+
+void TimelineFire(const TL_ENTRY* entry, int dir, void* arg)
+{
+    uint32_t gpio;
+
+    /* Play only events don't fire while locating or winding */
+    if (entry->flags & STC_TL_F_PLAY)
+    {
+        if ((g_sys.transportMode & MODE_MASK) != MODE_PLAY)
+            return;
+    }
+
+    switch(entry->action)
+    {
+    case STC_TL_GPIO:
+        if (entry->arg >= TIMELINE_GPIO_COUNT)
+            break;
+
+        gpio = s_timelineGPIO[entry->arg];
+
+        if (entry->param == STC_TL_GPIO_TOGGLE)
+            GPIO_toggle(gpio);
+        else
+            GPIO_write(gpio, entry->param ? PIN_HIGH : PIN_LOW);
+        break;
+
+    case STC_TL_MIDI:
+        MidiQueueCommand((uint8_t)entry->param);
+        break;
+
+    case STC_TL_TRACK:
+        TRACK_Manager_monitor((size_t)entry->arg, (uint8_t)entry->param);
+        break;
+
+    case STC_TL_EVENT:
+        g_sys.timelineEvent = (uint16_t)entry->param;
+        g_sys.timelineCount++;
+        s_timelinePost = true;
+        break;
+
+    default:
+        break;
+    }
+}
+
+//*****************************************************************************
+// Roller slip cross check task. This periodically reads the reel tach from
+// the DTC while tape is moving and compares it with the roller velocity.
+// Slip and QEI phase error bursts are flagged in g_sys.slipFlags. If slip
+// correction is enabled the distance the roller missed during a fast wind
+// is added back to the tape position.
+//*****************************************************************************
+
+#define SLIP_CHECK_PERIOD   100         /* cross check period in ms */
+
+Void SlipTaskFxn(UArg arg0, UArg arg1)
+{
+    uint8_t mode;
+    bool shuttle;
+    float tach;
+    float dt;
+    float inches = 0.0f;
+    float ticks;
+    uint32_t now;
+    uint32_t last;
+    MOTION_STATE motion;
+    Types_FreqHz freq;
+
+    Timestamp_getFreq(&freq);
+
+    SlipDetect_init(&s_slip, g_sys.qei_error_cnt);
+
+    last = Timestamp_get32();
+
+    while (TRUE)
+    {
+        Task_sleep(SLIP_CHECK_PERIOD);
+
+        now = Timestamp_get32();
+        dt  = (float)(now - last) / (float)freq.lo;
+        last = now;
+
+        PositionGetMotion(&motion);
+
+        /* No need to load the IPC link while the tape is stopped */
+        if (!motion.moving)
+        {
+            g_sys.slipFlags = SlipDetect_update(&s_slip, 0.0f, 0.0f,
+                                                g_sys.qei_error_cnt, false, dt);
+            continue;
+        }
+
+        if (!Transport_GetTach(&tach))
+            continue;
+
+        g_sys.dtcTach = tach;
+
+        mode = g_sys.transportMode & MODE_MASK;
+
+        shuttle = ((mode == MODE_FWD) || (mode == MODE_REW)) ? true : false;
+
+        g_sys.slipFlags = SlipDetect_update(&s_slip, motion.velocity, tach,
+                                            g_sys.qei_error_cnt, shuttle, dt);
+
+        /* Add the distance the roller missed back in the direction of travel */
+        inches += SlipDetect_takeCorrection(&s_slip);
+
+        if (!g_sys.cfgSTC.slipCorrect)
+        {
+            inches = 0.0f;
+            continue;
+        }
+
+        ticks = INCHES_TO_POSITION(inches);
+
+        if (ticks >= 1.0f)
+        {
+            inches -= POSITION_TO_INCHES(floorf(ticks));
+
+            PositionAdjust((motion.velocity < 0.0f) ? -(int32_t)ticks : (int32_t)ticks);
+        }
     }
 }
 
@@ -446,30 +868,59 @@ Void PositionTaskFxn(UArg arg0, UArg arg1)
 Void QEIHwi(UArg arg)
 {
     uint32_t ulIntStat;
+    QEI_SAMPLE sample;
 
     /* Get and clear the current interrupt source(s) */
     ulIntStat = QEIIntStatus(QEI_BASE_ROLLER, true);
     QEIIntClear(QEI_BASE_ROLLER, ulIntStat);
 
-    /* Determine which interrupt occurred */
+    /* Capture the encoder state along with the time it was taken. When the
+     * position task posts this interrupt to request a sample, no status
+     * bits are set and the sample is tagged as a poll sample.
+     */
+    sample.timestamp = Timestamp_get32();
+    sample.position  = QEIPositionGet(QEI_BASE_ROLLER);
+    sample.velocity  = QEIVelocityGet(QEI_BASE_ROLLER);
+    sample.direction = QEIDirectionGet(QEI_BASE_ROLLER);
+    sample.source    = QEI_SRC_POLL;
+
+    /* Accumulate the distance moved since the last sample so the signed
+     * position never has to be derived from the wrapped counter value.
+     */
+    s_qeiCount += POSITION_DELTA(sample.position, s_qeiLast);
+    s_qeiLast   = sample.position;
+
+    sample.count = s_qeiCount;
+
+    /* Flag the first sample after a position reset */
+    if (s_qeiReset)
+    {
+        s_qeiReset = false;
+        sample.source |= QEI_SRC_RESET;
+    }
+
+    /* Determine which interrupt(s) occurred */
 
     if (ulIntStat & QEI_INTERROR)       	/* phase error detected */
     {
     	g_sys.qei_error_cnt++;
+    	sample.source |= QEI_SRC_ERROR;
     	Event_post(g_sys.handleEventQEI, Event_Id_01);
     }
-    else if (ulIntStat & QEI_INTTIMER)  	/* velocity timer expired */
-    {
-    	Event_post(g_sys.handleEventQEI, Event_Id_02);
-    }
-    else if (ulIntStat & QEI_INTDIR)    	/* direction change */
-    {
-    	Event_post(g_sys.handleEventQEI, Event_Id_03);
-    }
-    else if (ulIntStat & QEI_INTINDEX)  	/* Index pulse detected */
-    {
-    	Event_post(g_sys.handleEventQEI, Event_Id_04);
-    }
+
+    if (ulIntStat & QEI_INTTIMER)  	    /* velocity timer expired */
+    	sample.source |= QEI_SRC_TIMER;
+
+    if (ulIntStat & QEI_INTDIR)    	    /* direction change */
+    	sample.source |= QEI_SRC_DIR;
+
+    if (ulIntStat & QEI_INTINDEX)  	    /* Index pulse detected */
+    	sample.source |= QEI_SRC_INDEX;
+
+    /* Store the sample and signal the position task */
+    QEIRing_put(&g_qeiRing, &sample);
+
+    Event_post(g_sys.handleEventQEI, Event_Id_00);
 
     QEIIntEnable(QEI_BASE_ROLLER, ulIntStat);
 }
@@ -510,6 +961,9 @@ void QEI_initialize(void)
 	/* Set initial position to zero */
 	QEIPositionSet(QEI_BASE_ROLLER, 0);
 
+	s_qeiLast  = 0;
+	s_qeiCount = 0;
+
 	/* Configure the Velocity capture period - 1200000 is 10ms at 120MHz.
 	 * This is how many 4 pulse trains we receive in half a second.
 	 */
@@ -521,6 +975,9 @@ void QEI_initialize(void)
 	/* Enable velocity mode */
 	QEIVelocityEnable(QEI_BASE_ROLLER);
 
+	/* Reset the sample ring before the ISR can write to it */
+	QEIRing_init(&g_qeiRing);
+
 	/* Construct hwi object for quadrature encoder interface */
 	Error_init(&eb);
     Hwi_Params_init(&hwiParams);
@@ -533,57 +990,21 @@ void QEI_initialize(void)
 }
 
 //*****************************************************************************
-//
+// Send the tape time to the ATMega88 7-segment display. The packet is only
+// written if the digits or flags have changed since the last one sent, or
+// the keep alive time has passed. See Display7Seg.c for the packet format.
 //*****************************************************************************
 
-void Write7SegDisplay(UART_Handle handle, TAPETIME* p)
+static void Write7SegDisplay(UART_Handle handle, TAPETIME* p)
 {
-	uint8_t	 b;
-	uint16_t csum = 0;
-
-    /* Write a display packet of data to the UART. The display
-     * packet is composed in the following form.
-	 *
-     *    Byte   Description
-	 *    ----   -------------------------------------
-     *    [0]    Preamble 1, must be 0x89
-	 *    [1]    Preamble 2, must be 0xFC
-     *    [2]    The SECONDS (0-59)
-	 *    [3]    The MINUTES (0-59)
-     *    [4]    The HOUR digit (0 or 1)
-     *    [5]    Bit flags (+sign, blink, blank)
-     *    [6]    8-Bit Checksum
-	 */
-
-	/* Write the 0x89 and 0xFC preamble bytes out */
-
-	b = 0x89;
-	UART_write(handle, &b, 1);
-
-	b = 0xFC;
-	UART_write(handle, &b, 1);
-
-	/* Write the secs, mins, hour & sign values out */
-
-	b = p->secs;
-	csum += b;
-	UART_write(handle, &b, 1);
-
-	b = p->mins;
-	csum += b;
-	UART_write(handle, &b, 1);
-
-	b = p->hour;
-	csum += b;
-	UART_write(handle, &b, 1);
+    size_t len;
+    uint8_t buf[DISP7_PACKET_MAX];
 
-	b = p->flags;
-	csum += b;
-	UART_write(handle, &b, 1);
+    /* Clock ticks are 1ms */
+    len = Disp7_update(&s_disp7, p, buf, Clock_getTicks());
 
-	/* Write the 8 checksum values out */
-	b = csum & 0xFF;
-	UART_write(handle, &b, 1);
+    if (len)
+        UART_write(handle, buf, len);
 }
 
 /* End-Of-File */
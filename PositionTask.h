@@ -15,80 +15,84 @@
 
 /*** CONSTANTS AND CONFIGURATION *******************************************/
 
-/* The Ampex tape roller quadrature encoder wheel has 40 ppr. This gives
- * either 80 or 160 edges per revolution depending on the quadrature encoder
- * configuration set by QEIConfig(). Currently we use Cha-A mode which
- * gives 80 edges per revolution. If Cha-A/B mode is used this must be
- * set to 160.
- */
-
-#define ROLLER_TICKS_PER_REV        80
-#define ROLLER_TICKS_PER_REV_F      80.0f
-
-/* This is the diameter of the tape timer roller */
-#define ROLLER_CIRCUMFERENCE_F      5.0014f
-
-/* This is the maximum signed position value we can have. Anything past
- * this is treated as a negative position value.
+/* This is the maximum value of the QEI position counter. The counter
+ * wraps to zero past this value going forward and back to this value
+ * going backward past zero.
  */
 #define MAX_ROLLER_POSITION			(0x7FFFFFFF - 1UL)
 #define MIN_ROLLER_POSITION			(-MAX_ROLLER_POSITION - 1)
 
-/*** TAPE TIME/POSITION DATA ***********************************************/
+/*** POSITION STATE DATA *************************************************/
 
-/* Tape position time as h:m:s form. These values get transmitted
- * to the 7-segment ATMega88 display processor.
+/* The motion estimate published by the position task, with the roller
+ * tach and direction from the newest encoder sample it was made from.
  */
-typedef struct _TAPETIME {
-    uint8_t     hour;       /* hour (0-1)      */
-    uint8_t     mins;       /* minutes (0-59)  */
-    uint8_t     secs;       /* seconds  (0-59) */
-    uint8_t     tens;       /* tens secs (0-9) */
-    uint8_t     frame;      /* smpte frame#    */
-    uint8_t     flags;	    /* display flags   */
-    uint16_t    align;      /* word alignment  */
-} TAPETIME;
-
-/* TAPETIME.flags */
-#define F_PLUS		0x01	/* 7-seg plus segment, negative if clear */
-#define F_BLINK		0x02	/* blink all seven segment displays      */
-#define F_BLANK		0x80	/* blank the entire display if set       */
+typedef struct _POSITION_STATE {
+    MOTION_STATE    motion;
+    float           tach;           /* edges per velocity timer period */
+    int32_t         direction;      /* 1=fwd, -1=rew                   */
+} POSITION_STATE;
+
+/*** GLOBAL DATA ITEMS ****************************************************/
+
+/* Timestamped encoder samples written by the QEI interrupt handler */
+extern QEI_RING g_qeiRing;
 
 /*** FUNCTION PROTOTYPES ***************************************************/
 
 void PositionZeroReset(void);
+void PositionAdjust(int32_t ticks);
+void PositionGetMotion(MOTION_STATE* state);
+void PositionGetState(POSITION_STATE* state);
+void PositionGetIndexStats(INDEX_STATS* stats);
+int32_t PositionPredict(MOTION_STATE* state);
+int32_t PositionPredictState(POSITION_STATE* state);
+int TimelineAdd(int32_t ipos, uint32_t action, uint32_t flags, uint32_t arg, uint32_t param);
+size_t TimelineDelete(int index);
+bool TimelineGet(int index, int32_t* ipos, uint32_t* action, uint32_t* flags,
+                 uint32_t* arg, uint32_t* param, size_t* count);
 Void PositionTaskFxn(UArg arg0, UArg arg1);
-
-/* Tape time helper functions */
-void SecondsToTapeTime(float time, TAPETIME* p);
-void TapeTimeToSeconds(TAPETIME* p, float* time);
-
-void TapeTimeToPosition(TAPETIME* tapeTime, int* tapePosition);
-void PositionToTapeTime(int tapePosition, TAPETIME* tapeTime);
+Void SlipTaskFxn(UArg arg0, UArg arg1);
 
 /*** INLINE FUNCTIONS ******************************************************/
 
-/* Converts encoder absolute position to relative signed position */
+/* Returns the signed distance moved between two absolute encoder
+ * positions. The QEI position counter wraps between zero and
+ * MAX_ROLLER_POSITION, so the shortest way around the counter
+ * range is taken as the distance moved.
+ */
 
-static inline int POSITION_TO_INT(uint32_t upos)
+static inline int32_t POSITION_DELTA(uint32_t upos, uint32_t uprev)
 {
-	/* Check for max position wrap around if negative position */
-	if (upos >= (MAX_ROLLER_POSITION / 2))
-		return (int)upos - (int)MAX_ROLLER_POSITION;
+    const int64_t range = (int64_t)MAX_ROLLER_POSITION + 1;
+
+    int64_t delta = (int64_t)upos - (int64_t)uprev;
 
-	return (int)upos;
+    if (delta > (range / 2))
+        delta -= range;
+    else if (delta < -(range / 2))
+        delta += range;
+
+    return (int32_t)delta;
 }
 
-/* This function calculates the distance in inches from a position */
+/* This function calculates the distance in inches from a position
+ * using the current calibrated roller circumference.
+ */
+
+static inline float ROLLER_CIRCUMFERENCE(void)
+{
+    return (float)TapeTime_getCircumference() * 1.0e-6f;
+}
 
 static inline float POSITION_TO_INCHES(float pos)
 {
-	return ((pos / ROLLER_TICKS_PER_REV_F) * ROLLER_CIRCUMFERENCE_F);
+	return ((pos / ROLLER_TICKS_PER_REV_F) * ROLLER_CIRCUMFERENCE());
 }
 
 static inline float INCHES_TO_POSITION(float inches)
 {
-    return ((inches / ROLLER_CIRCUMFERENCE_F) * ROLLER_TICKS_PER_REV_F);
+    return ((inches / ROLLER_CIRCUMFERENCE()) * ROLLER_TICKS_PER_REV_F);
 }
 
 #endif /* __POSITIONTASK_H */
@@ -0,0 +1,165 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* This module has no RTOS or driver dependencies. The QEI interrupt handler
+ * is the only producer and writes samples into the ring. Tasks that read
+ * the ring may be preempted by the producer at any point, so a reader copies
+ * the slot out first and then checks the head again to make sure the slot
+ * was not recycled while it was being copied.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "QEIRing.h"
+
+/* Static Function Prototypes */
+
+static void CopySample(QEI_SAMPLE* dst, volatile QEI_SAMPLE* src);
+
+//*****************************************************************************
+// Reset the ring to the empty state.
+//*****************************************************************************
+
+void QEIRing_init(QEI_RING* ring)
+{
+    uint32_t i;
+
+    for (i=0; i < QEI_RING_SIZE; i++)
+    {
+        ring->sample[i].count     = 0;
+        ring->sample[i].timestamp = 0;
+        ring->sample[i].position  = 0;
+        ring->sample[i].velocity  = 0;
+        ring->sample[i].direction = 0;
+        ring->sample[i].source    = 0;
+    }
+
+    ring->head = 0;
+}
+
+//*****************************************************************************
+// Producer side, called from the QEI interrupt handler only. The slot is
+// filled in before the head is advanced so readers never see a partially
+// written sample as the newest one.
+//*****************************************************************************
+
+void QEIRing_put(QEI_RING* ring, const QEI_SAMPLE* sample)
+{
+    uint32_t head = ring->head;
+
+    volatile QEI_SAMPLE* p = &ring->sample[head & QEI_RING_MASK];
+
+    p->count     = sample->count;
+    p->timestamp = sample->timestamp;
+    p->position  = sample->position;
+    p->velocity  = sample->velocity;
+    p->direction = sample->direction;
+    p->source    = sample->source;
+
+    ring->head = head + 1;
+}
+
+//*****************************************************************************
+// Return the most recent sample written. Returns false if the producer
+// has not written any samples yet.
+//*****************************************************************************
+
+bool QEIRing_latest(QEI_RING* ring, QEI_SAMPLE* sample)
+{
+    uint32_t head;
+    uint32_t seq;
+
+    do {
+        head = ring->head;
+
+        if (!head)
+            return false;
+
+        seq = head - 1;
+
+        CopySample(sample, &ring->sample[seq & QEI_RING_MASK]);
+
+        /* Retry if the producer lapped us during the copy */
+    } while ((ring->head - seq) >= QEI_RING_SIZE);
+
+    return true;
+}
+
+//*****************************************************************************
+// Attach a reader to the ring. The reader starts with the next sample
+// written, any samples already in the ring are skipped.
+//*****************************************************************************
+
+void QEIRing_readerInit(QEI_RING* ring, QEI_READER* reader)
+{
+    reader->tail     = ring->head;
+    reader->overruns = 0;
+}
+
+//*****************************************************************************
+// Read the next sample for a reader. Returns false if the reader has
+// consumed all samples written. If the reader has fallen more than a ring
+// length behind the producer, the lost samples are counted in the reader
+// overrun count and reading resumes at the oldest sample still valid.
+//*****************************************************************************
+
+bool QEIRing_get(QEI_RING* ring, QEI_READER* reader, QEI_SAMPLE* sample)
+{
+    uint32_t head;
+    uint32_t lag;
+
+    for (;;)
+    {
+        head = ring->head;
+
+        if (reader->tail == head)
+            return false;
+
+        /* The slot the producer will write next is never read, it
+         * may be in the middle of being written from another context.
+         */
+        lag = head - reader->tail;
+
+        if (lag >= QEI_RING_SIZE)
+        {
+            reader->overruns += lag - (QEI_RING_SIZE - 1);
+            reader->tail = head - (QEI_RING_SIZE - 1);
+        }
+
+        CopySample(sample, &ring->sample[reader->tail & QEI_RING_MASK]);
+
+        /* Make sure the slot wasn't recycled while copying it out */
+        if ((ring->head - reader->tail) < QEI_RING_SIZE)
+            break;
+    }
+
+    reader->tail++;
+
+    return true;
+}
+
+//*****************************************************************************
+// Copy a sample out of the ring.
+//*****************************************************************************
+
+static void CopySample(QEI_SAMPLE* dst, volatile QEI_SAMPLE* src)
+{
+    dst->count     = src->count;
+    dst->timestamp = src->timestamp;
+    dst->position  = src->position;
+    dst->velocity  = src->velocity;
+    dst->direction = src->direction;
+    dst->source    = src->source;
+}
+
+/* End-Of-File */
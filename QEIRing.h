@@ -0,0 +1,77 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _QEIRING_H_
+#define _QEIRING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Number of encoder samples held in the ring. This must be a power of two.
+ * At the 25ms velocity timer rate plus the 5ms poll samples we see about
+ * 240 samples per second, so 64 gives each reader roughly 250ms of slack
+ * before samples get overwritten.
+ */
+#define QEI_RING_SIZE       64
+#define QEI_RING_MASK       (QEI_RING_SIZE - 1)
+
+/* QEI_SAMPLE.source bits. These identify the interrupt that captured
+ * the sample. A value of zero is a poll sample requested by a task.
+ */
+#define QEI_SRC_POLL        0x00        /* task requested sample   */
+#define QEI_SRC_TIMER       0x01        /* velocity timer expired  */
+#define QEI_SRC_DIR         0x02        /* direction change        */
+#define QEI_SRC_INDEX       0x04        /* roller index pulse      */
+#define QEI_SRC_ERROR       0x08        /* quadrature phase error  */
+#define QEI_SRC_RESET       0x10        /* first after count reset */
+
+/*** SAMPLE RING DATA ******************************************************/
+
+/* One encoder sample as captured by the QEI interrupt handler */
+typedef struct _QEI_SAMPLE {
+    int64_t     count;          /* signed tape position, unwrapped */
+    uint32_t    timestamp;      /* timestamp count at capture time */
+    uint32_t    position;       /* absolute encoder position       */
+    uint32_t    velocity;       /* edges per velocity timer period */
+    int32_t     direction;      /* 1=fwd, -1=rew                   */
+    uint32_t    source;         /* QEI_SRC_* capture source flags  */
+} QEI_SAMPLE;
+
+/* Single producer broadcast ring. The head is a free running count of all
+ * samples ever written and is only advanced by the producer once a slot
+ * has been completely filled in.
+ */
+typedef struct _QEI_RING {
+    volatile uint32_t   head;
+    volatile QEI_SAMPLE sample[QEI_RING_SIZE];
+} QEI_RING;
+
+/* Each consumer keeps its own read cursor so any number of tasks can
+ * read the same sample stream without locking against each other.
+ */
+typedef struct _QEI_READER {
+    uint32_t    tail;           /* sequence number of next sample  */
+    uint32_t    overruns;       /* samples lost to the producer    */
+} QEI_READER;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void QEIRing_init(QEI_RING* ring);
+void QEIRing_put(QEI_RING* ring, const QEI_SAMPLE* sample);
+bool QEIRing_latest(QEI_RING* ring, QEI_SAMPLE* sample);
+
+void QEIRing_readerInit(QEI_RING* ring, QEI_READER* reader);
+bool QEIRing_get(QEI_RING* ring, QEI_READER* reader, QEI_SAMPLE* sample);
+
+#endif  /* _QEIRING_H_ */
@@ -67,6 +67,11 @@
 /* PMX42 Board Header file */
 #include "Board.h"
 #include "RAMP.h"
+#include "IPCFrame.h"
+#include "FrameBuild.h"
+
+/* Transmit frame buffer, only used by the RAMP writer task */
+static uint8_t s_frame[RAMP_FRAME_MAX];
 
 //*****************************************************************************
 // Initialize FCB structure to default values
@@ -81,351 +86,103 @@ void RAMP_InitFcb(RAMP_FCB* fcb)
 }
 
 //*****************************************************************************
-// Transmit a RAMP frame of data out the RS-422 port
+// Transmit a RAMP frame of data out the RS-422 port. The frame is built in
+// a buffer and written to the UART in one call. This is only called from
+// the RAMP writer task, which owns the frame buffer.
 //*****************************************************************************
 
 int RAMP_TxFrame(UART_Handle handle, RAMP_FCB* fcb, void* text, uint16_t textlen)
 {
-	uint8_t b;
-	uint8_t type;
-    uint16_t i;
-    uint16_t framelen;
-    uint16_t crc = 0;
-    uint8_t *textbuf = (uint8_t*)text;
+    size_t framelen;
 
 	/* First check the text length is valid */
 	if (textlen > MAX_TEXT_LEN)
 		return ERR_TEXT_LEN;
 
-    /* Get the frame type less any flag bits */
-    type = (fcb->type & FRAME_TYPE_MASK);
-
-    /* Are we sending a ACK or NAK only frame? */
-    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
-    {
-        textbuf = NULL;
-        textlen = 0;
-
-        framelen = ACK_FRAME_LEN;
-
-		/* Set the ACK/NAK flag bit */
-		fcb->type |= F_ACKNAK;
-    }
-    else
-    {
-        framelen = textlen + (FRAME_OVERHEAD - PREAMBLE_OVERHEAD);
-
-        /* If message is piggyback ACK/NAK, set flag bit also */
-        if ((type == TYPE_MSG_ACK) || (type == TYPE_MSG_NAK))
-            fcb->type |= F_ACKNAK;
-        else
-            fcb->type &= ~(F_ACKNAK);
-    }
-
-    /* Send the preamble MSB for the frame start */
-    b = PREAMBLE_MSB;
-    UART_write(handle, &b, 1);
-
-    /* Send the preamble LSB for the frame start */
-    b = PREAMBLE_LSB;
-    UART_write(handle, &b, 1);
-
-    /* CRC starts here, sum in the seed byte first */
-    crc = CRC16Update(crc, CRC_SEED_BYTE);
-
-    /* Send the frame length (MSB) */
-    b = (uint8_t)((framelen >> 8) & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
-
-    /* Send the frame length (LSB) */
-    b = (uint8_t)(framelen & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
-
-    /* Send the frame type & flags byte */
-    b = (uint8_t)(fcb->type & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
-
-    /* Send the frame address byte */
-    b = (uint8_t)(fcb->address & 0xFF);
-    crc = CRC16Update(crc, b);
-    UART_write(handle, &b, 1);
-
-    /* Sending ACK or NAK only frame? */
-
-    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
-    {
-		/* Sending ACK/NAK frame only  */
-
-		b = (uint8_t)(fcb->acknak & 0xFF);
-		crc = CRC16Update(crc, b);
-		UART_write(handle, &b, 1);
-    }
-    else
-    {
-    	/* Continue sending a full RAMP frame */
-
-		/* Send the Frame Sequence Number */
-		b = (uint8_t)(fcb->seqnum & 0xFF);
-		crc = CRC16Update(crc, b);
-		UART_write(handle, &b, 1);
-
-		/* Send the ACK/NAK Sequence Number */
-		b = (uint8_t)(fcb->acknak & 0xFF);
-		crc = CRC16Update(crc, b);
-		UART_write(handle, &b, 1);
-
-		/* Send the Text length (MSB) */
-		b = (uint8_t)((textlen >> 8) & 0xFF);
-		crc = CRC16Update(crc, b);
-		UART_write(handle, &b, 1);
-
-		/* Send the Text length (LSB) */
-		b = (uint8_t)(textlen & 0xFF);
-		crc = CRC16Update(crc, b);
-		UART_write(handle, &b, 1);
-
-		/* Send any text data associated with the frame */
-
-		if (textbuf && textlen)
-		{
-#if 0
-			for (i=0; i < textlen; i++)
-			{
-				b = *textbuf++;
-				crc = CRC16Update(crc, b);
-				UART_write(handle, &b, 1);
-			}
-#else
-            UART_write(handle, textbuf, textlen);
-
-            /* Continue sum the CRC for the text block */
-            for (i=0; i < textlen; i++)
-                crc = CRC16Update(crc, *textbuf++);
-#endif
-		}
-    }
-
-    /* Send the CRC MSB */
-    b = (uint8_t)(crc >> 8);
-    UART_write(handle, &b, 1);
+    /* Build the whole frame and send it in a single write */
+    framelen = RAMP_FrameBuild(s_frame, fcb, text, textlen);
 
-    /* Send the CRC LSB */
-    b = (uint8_t)(crc & 0xFF);
-    UART_write(handle, &b, 1);
+    if (UART_write(handle, s_frame, framelen) != (int)framelen)
+        return ERR_TIMEOUT;
 
     return ERR_SUCCESS;
 }
 
 //*****************************************************************************
-// Receive a RAMP data frame from the RS-422 port
+// Receive a RAMP data frame from the RS-422 port. The port is read through
+// its frame parser, no further than the end of the frame being received.
+// Bad frames are counted in the parser stats and skipped, and receiving
+// carries on until a good frame arrives or the read times out.
 //*****************************************************************************
 
-int RAMP_RxFrame(UART_Handle handle, RAMP_FCB* fcb, void* text, uint16_t textlen)
+int RAMP_RxFrame(UART_Handle handle, FRAME_PARSER* parser, RAMP_FCB* fcb, void* text,
+                 uint16_t textlen)
 {
-    int i;
-	int rc = ERR_SUCCESS;
-	uint8_t b;
+    int n;
+    size_t room;
     uint8_t type;
-    uint16_t lsb;
-    uint16_t msb;
-    uint16_t framelen;
-    uint16_t rxcrc;
-    uint16_t crc = 0;
-    uint8_t *textbuf = (uint8_t*)text;
+    uint8_t* ptr;
+    uint8_t* textbuf = (uint8_t*)text;
+    FRAME_RX frame;
 
-    /* First, try to synchronize to 0x89 SOF byte */
+    /* Take any frame the parser already holds before reading more */
+    while (!FrameParse_next(parser, &frame))
+    {
+        room = FrameParse_space(parser, &ptr);
 
-    i = 0;
+        n = UART_read(handle, ptr, room);
 
-    do {
+        if (n > 0)
+            FrameParse_commit(parser, (size_t)n);
 
-        /* Read the preamble MSB for the frame start */
-        if (UART_read(handle, &b, 1) != 1)
-            return ERR_TIMEOUT;
+        if (n == (int)room)
+            continue;
 
-        /* Garbage flood check, synch lost?? */
-        if (i++ > (FRAME_OVERHEAD + PREAMBLE_OVERHEAD + MAX_TEXT_LEN))
-            return ERR_SYNC;
+        /* Timed out, a frame may still be complete in the bytes read */
+        if (FrameParse_next(parser, &frame))
+            break;
 
-    } while (b != PREAMBLE_MSB);
+        /* Drop any frame cut short, a frame may have started inside it */
+        FrameParse_abort(parser);
 
-    /* We found the first 0x89 sequence, next byte
-     * has to be 0xFC for a valid SOF sequence.
-     */
+        if (FrameParse_next(parser, &frame))
+            break;
 
-    if (UART_read(handle, &b, 1) != 1)
         return ERR_TIMEOUT;
+    }
 
-    if (b != PREAMBLE_LSB)
-        return ERR_SYNC;
-
-    /* CRC starts here, sum in the seed byte first */
-    crc = CRC16Update(crc, CRC_SEED_BYTE);
-
-    /* Read the Frame length (MSB) */
-    if (UART_read(handle, &b, 1) != 1)
-    	return ERR_SHORT_FRAME;
-
-    crc = CRC16Update(crc, b);
-    msb = (uint16_t)b;
-
-    /* Read the Frame length (LSB) */
-    if (UART_read(handle, &b, 1) != 1)
-    	return ERR_SHORT_FRAME;
-
-    crc = CRC16Update(crc, b);
-    lsb = (uint16_t)b;
-
-    /* Build and validate maximum frame length */
-    framelen = (size_t)((msb << 8) | lsb) & 0xFFFF;
-
-    if (framelen > MAX_FRAME_LEN)
-    	return ERR_FRAME_LEN;
-
-    /* Read the Frame Type Byte */
-    if (UART_read(handle, &b, 1) != 1)
-    	return ERR_SHORT_FRAME;
-
-    crc = CRC16Update(crc, b);
-    fcb->type = b;
-
-	/* Read the Frame Address Byte */
-	if (UART_read(handle, &b, 1) != 1)
-		return ERR_SHORT_FRAME;
-
-	crc = CRC16Update(crc, b);
-	fcb->address = b;
+    fcb->type    = frame.type;
+    fcb->address = frame.address;
+    fcb->acknak  = frame.acknak;
 
-    /* Check for ACK/NAK only frame (type always 11H or 12H) */
+    /* An ACK/NAK only frame has no sequence number or text */
+    if (frame.text == NULL)
+        return ERR_SUCCESS;
 
-	/* Get the frame type less any flag bits */
-    type = (fcb->type & FRAME_TYPE_MASK);
+    fcb->seqnum = frame.seqnum;
 
-    if ((framelen == ACK_FRAME_LEN) && ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY)))
-    {
-		/* Read the ACK/NAK Sequence Number */
-		if (UART_read(handle, &b, 1) != 1)
-			return ERR_SHORT_FRAME;
+    /* Get the frame type less any flag bits */
+    type = (frame.type & FRAME_TYPE_MASK);
 
-		crc = CRC16Update(crc, b);
-		fcb->acknak = b;
-    }
-    else
+    /* If it's a user defined message, then it's a display buffer frame
+     * and goes into the display memory buffer. Note we have two extra
+     * bytes after the video buffer with the button LED bitmask and
+     * transport mode. The frame was checked first, so a bad frame never
+     * reaches the display.
+     */
+    if (type == TYPE_MSG_USER)
     {
-    	/* It's a full RAMP frame, continue decoding the rest of the frame */
-
-		/* Read the Frame Sequence Number */
-		if (UART_read(handle, &b, 1) != 1)
-			return ERR_SHORT_FRAME;
-
-		crc = CRC16Update(crc, b);
-		fcb->seqnum = b;
-
-		/* Read the ACK/NAK Sequence Number */
-		if (UART_read(handle, &b, 1) != 1)
-			return ERR_SHORT_FRAME;
-
-		crc = CRC16Update(crc, b);
-		fcb->acknak = b;
-
-		/* Read the Text length (MSB) */
-		if (UART_read(handle, &b, 1) != 1)
-			return ERR_SHORT_FRAME;
-
-		crc = CRC16Update(crc, b);
-		msb = (uint16_t)b;
-
-		/* Read the Text length (LSB) */
-		if (UART_read(handle, &b, 1) != 1)
-			return ERR_SHORT_FRAME;
-
-		crc = CRC16Update(crc, b);
-		lsb = (uint16_t)b;
-
-		/* Get the frame length received and validate it */
-		uint16_t rxtextlen = (size_t)((msb << 8) | lsb) & 0xFFFF;
-
-		/* The text length should be the frame overhead minus the preamble overhead
-		 * plus the text length specified in the received frame. If these don't match
-		 * then we have either a packet data error or a malformed packet.
-		 */
-		if (rxtextlen + (FRAME_OVERHEAD - PREAMBLE_OVERHEAD) != framelen)
-			return ERR_TEXT_LEN;
-
-		/* If it's a user defined message, then it's a display buffer frame
-		 * and we read the data directly into the display memory buffer.
-		 * Note we have two extra bytes after the video buffer with the
-		 * button LED bitmask and transport mode.
-		 */
-		if (type == TYPE_MSG_USER)
-		{
-            textbuf = GrGetScreenBuffer(5);
-            textlen = 1024 + 8;
-		}
-
-		/* Read text data associated with the frame */
-#if 1
-        if (rxtextlen > textlen)
-        {
-            rc = ERR_RX_OVERFLOW;
-        }
-        else
-        {
-            /* Read the entire text block */
-            if (UART_read(handle, textbuf, rxtextlen) != rxtextlen)
-                return ERR_SHORT_FRAME;
-
-            /* Continue sum the CRC for the text block */
-            for (i=0; i < rxtextlen; i++)
-                crc = CRC16Update(crc, *textbuf++);
-        }
-#else
-		for (i=0; i < rxtextlen; i++)
-		{
-			if (UART_read(handle, &b, 1) != 1)
-				return ERR_SHORT_FRAME;
-
-			/* update the CRC */
-			crc = CRC16Update(crc, b);
-
-			/* If we overflow, continue reading the packet
-			 * data, but don't store the data into the buffer.
-			 */
-			if (i >= textlen)
-			{
-				rc = ERR_RX_OVERFLOW;
-				continue;
-			}
-
-			if (textbuf)
-				*textbuf++ = b;
-		}
-#endif
+        textbuf = GrGetScreenBuffer(5);
+        textlen = 1024 + 8;
     }
 
-    /* Read the packet CRC MSB */
-    if (UART_read(handle, &b, 1) != 1)
-    	return ERR_SHORT_FRAME;
-
-    msb = (uint16_t)b & 0xFF;
-
-    /* Read the packet CRC LSB */
-    if (UART_read(handle, &b, 1) != 1)
-    	return ERR_SHORT_FRAME;
+    if (frame.textlen > textlen)
+        return ERR_RX_OVERFLOW;
 
-    lsb = (uint16_t)b & 0xFF;
+    if (textbuf && frame.textlen)
+        memcpy(textbuf, frame.text, frame.textlen);
 
-    /* Build and validate the CRC */
-    rxcrc = (uint16_t)((msb << 8) | lsb) & 0xFFFF;
-
-    /* Validate the CRC values match */
-    if (rxcrc != crc)
-    	rc = ERR_CRC;
-
-    return rc;
+    return ERR_SUCCESS;
 }
 
 // End-Of-File
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* RAMP frame constants and the frame control block, kept apart from the
+ * UART frame functions so modules with no RTOS or driver dependencies can
+ * use them. The frame format is described in RAMP.h.
+ */
+
+#ifndef __RAMPFRAMEDEFS_H
+#define __RAMPFRAMEDEFS_H
+
+#include <stdint.h>
+
+/*** RAMP Constants and Defines ********************************************/
+
+#define PREAMBLE_MSB			0x89		/* first byte of preamble SOF  */
+#define PREAMBLE_LSB			0xBA		/* second byte of preamble SOF */
+
+#define MAX_WINDOW              8       	/* maximum window size         */
+
+#define PREAMBLE_OVERHEAD       4       	/* preamble overhead (SOF+LEN) */
+#define HEADER_OVERHEAD         4       	/* frame header overhead       */
+#define TEXT_OVERHEAD           2       	/* text length overhead        */
+#define CRC_OVERHEAD            2       	/* 16-bit CRC overhead         */
+#define FRAME_OVERHEAD          ( PREAMBLE_OVERHEAD + HEADER_OVERHEAD + TEXT_OVERHEAD + CRC_OVERHEAD )
+
+#define CRC_SEED_BYTE		    0xAB
+
+#define MIN_SEQ_NUM             1       	/* min/max frame sequence num   */
+#define MAX_SEQ_NUM             ( 3 * MAX_WINDOW )
+#define NULL_SEQ_NUM            ( (uint8_t)0 )
+
+#define ACK_FRAME_LEN           5
+#define MAX_TEXT_LEN            2048
+#define MIN_FRAME_LEN           ( FRAME_OVERHEAD - PREAMBLE_OVERHEAD )
+#define MAX_FRAME_LEN           ( MIN_FRAME_LEN + MAX_TEXT_LEN )
+#define RAMP_FRAME_MAX          ( FRAME_OVERHEAD + MAX_TEXT_LEN )
+
+#define INC_SEQ_NUM(n)		    ( (uint8_t)((n >= MAX_SEQ_NUM) ? MIN_SEQ_NUM : n+1) )
+
+/* Frame Type Flag Bits (upper nibble) */
+#define F_ACKNAK        		0x10		/* frame is ACK/NAK only frame */
+#define F_PRIORITY      		0x20    	/* high priority message frame */
+#define F_DATAGRAM        		0x40		/* no ACK/NAK required         */
+#define F_ERROR         		0x80		/* frame error flag bit        */
+
+#define FRAME_FLAG_MASK    		0xF0		/* flag mask is upper 4 bits   */
+
+/* Frame Type Code (lower nibble) */
+#define TYPE_ACK_ONLY   		1			/* ACK message frame only      */
+#define TYPE_NAK_ONLY   		2			/* NAK message frame only      */
+#define TYPE_MSG_ONLY   		3			/* message only frame          */
+#define TYPE_MSG_ACK    		4			/* piggyback message plus ACK  */
+#define TYPE_MSG_NAK    		5			/* piggyback message plus NAK  */
+#define TYPE_MSG_USER           6           /* user defined message packet */
+
+#define FRAME_TYPE_MASK    		0x0F		/* type mask is lower 4 bits   */
+
+#define MAKETYPE(f, t)			( (uint8_t)((f & 0xF0) | (t & 0x0F)) )
+
+/* Error Code Constants */
+#define ERR_SUCCESS             0
+#define ERR_TIMEOUT             1           /* comm port timeout           */
+#define ERR_SYNC                2           /* SOF frame sync error        */
+#define ERR_SHORT_FRAME         3           /* short rx-frame error        */
+#define ERR_RX_OVERFLOW         4           /* rx buffer overflow          */
+#define ERR_SEQ_NUM             5           /* bad sequence number         */
+#define ERR_FRAME_TYPE          6           /* invalid frame type          */
+#define ERR_FRAME_LEN           7           /* bad rx-frame length         */
+#define ERR_TEXT_LEN            8           /* bad rx-text length          */
+#define ERR_ACKNAK_LEN          9           /* bad rx-text length          */
+#define ERR_CRC                 10          /* rx-frame checksum bad       */
+
+/*** RAMP Structure Definitions ********************************************/
+
+/* RAMP Frame Control Block Structure */
+
+typedef struct fcb_t {
+    uint8_t     type;               /* frame type bits       */
+    uint8_t     seqnum;             /* frame tx/rx seq#      */
+    uint8_t     acknak;             /* frame ACK/NAK seq#    */
+    uint8_t     address;            /* tx/rx node address    */
+} RAMP_FCB;
+
+#endif /* __RAMPFRAMEDEFS_H */
+
+/* end-of-file */
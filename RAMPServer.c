@@ -98,6 +98,9 @@
 /* Static Function Prototypes */
 static RAMP_SVR_OBJECT g_svr;
 
+/* Receive frame buffer, only used by the reader task */
+static uint8_t s_rxFrame[RAMP_FRAME_MAX];
+
 /* Static Function Prototypes */
 static Void RAMPReaderTaskFxn(UArg a0, UArg a1);
 static Void RAMPWriterTaskFxn(UArg arg0, UArg arg1);
@@ -226,6 +229,8 @@ Bool RAMP_Server_init(void)
     g_svr.rxLastSeq     = 0;                /* last seq# accepted   */
     g_svr.rxExpectedSeq = MIN_SEQ_NUM;      /* expected recv seq#   */
 
+    FrameParse_init(&g_svr.rxParser, FRAME_RAMP, s_rxFrame, sizeof(s_rxFrame));
+
     /*
      * Finally, create the reader, writer and worker tasks
      */
@@ -488,7 +493,7 @@ Void RAMPReaderTaskFxn(UArg arg0, UArg arg1)
         {
             /* Attempt to read a frame from the peer */
 
-            rc = RAMP_RxFrame(g_svr.uartHandle, &(elem->fcb), &(elem->msg), sizeof(RAMP_MSG));
+            rc = RAMP_RxFrame(g_svr.uartHandle, &g_svr.rxParser, &(elem->fcb), &(elem->msg), sizeof(RAMP_MSG));
 
             /* Zero means packet received successfully */
             if (rc == 0)
@@ -74,6 +74,7 @@ typedef struct _RAMP_SVR_OBJECT {
     uint32_t            rxCount;
     uint8_t             rxExpectedSeq;      /* expected recv seq#   */
     uint8_t             rxLastSeq;          /* last seq# accepted   */
+    FRAME_PARSER        rxParser;           /* rx frame parser      */
     /* frame memory buffers */
     RAMP_ELEM*          txBuf;
     RAMP_ELEM*          rxBuf;
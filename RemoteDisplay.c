@@ -282,6 +282,10 @@ void drawTimeTop(void)
     int32_t x, y;
     int32_t len;
     int32_t width;
+    TRANSPORT_STATE ts;
+
+    /* Take a consistent copy of the transport state */
+    TransportState_get(&ts);
 
     /*
      * Draw the current transport mode text on top line
@@ -297,7 +301,7 @@ void drawTimeTop(void)
     }
     else
     {
-        switch(g_sys.transportMode & MODE_MASK)
+        switch(ts.transportMode & MODE_MASK)
         {
         case MODE_HALT:
             len = sprintf(buf, "HALT");
@@ -312,21 +316,21 @@ void drawTimeTop(void)
             break;
 
         case MODE_PLAY:
-            if (g_sys.transportMode & M_RECORD)
+            if (ts.transportMode & M_RECORD)
                 len = sprintf(buf, "PLAY+REC");
             else
                 len = sprintf(buf, "PLAY");
             break;
 
         case MODE_FWD:
-            if (g_sys.transportMode & M_LIBWIND)
+            if (ts.transportMode & M_LIBWIND)
                 len = sprintf(buf, "FWD+LIB");
             else
                 len = sprintf(buf, "FWD");
             break;
 
         case MODE_REW:
-            if (g_sys.transportMode & M_LIBWIND)
+            if (ts.transportMode & M_LIBWIND)
                 len = sprintf(buf, "REW+LIB");
             else
                 len = sprintf(buf, "REW");
@@ -374,7 +378,7 @@ void drawTimeTop(void)
     }
     else
     {
-        len = sprintf(buf, "%s IPS", (g_sys.tapeSpeed == 30) ? "30" : "15");
+        len = sprintf(buf, "%s IPS", (ts.tapeSpeed == 30) ? "30" : "15");
     }
 
     width = GrStringWidthGet(&g_context, buf, len);
@@ -390,6 +394,10 @@ void drawTimeMiddle(void)
     int32_t len;
     int32_t width;
     int32_t height;
+    TRANSPORT_STATE ts;
+
+    /* Take a consistent copy of the transport state */
+    TransportState_get(&ts);
 
     /*
      * Draw the big time digits centered
@@ -405,9 +413,9 @@ void drawTimeMiddle(void)
         height = GrStringHeightGet(&g_context);
 
         len = sprintf(buf, "%1u:%02u:%02u:",
-                 g_sys.tapeTime.hour,
-                 g_sys.tapeTime.mins,
-                 g_sys.tapeTime.secs);
+                 ts.tapeTime.hour,
+                 ts.tapeTime.mins,
+                 ts.tapeTime.secs);
 
         width = GrStringWidthGet(&g_context, buf, len);
 
@@ -416,12 +424,12 @@ void drawTimeMiddle(void)
         GrStringDraw(&g_context, buf, len, x, y, 0);
 
         GrContextFontSet(&g_context, g_psFontWDseg7bold10pt);
-        len = sprintf(buf, "%02u", g_sys.tapeTime.frame);
+        len = sprintf(buf, "%02u", ts.tapeTime.frame);
         GrStringDraw(&g_context, buf, len, x+width, y+1, 0);
 
         /* Draw the sign in a different font as 7-seg does not have these chars */
         GrContextFontSet(&g_context, g_psFontCm14); //g_psFontCmss12);
-        len = sprintf(buf, "%c", (g_sys.tapeTime.flags & F_PLUS) ? '+' : '-');
+        len = sprintf(buf, "%c", (ts.tapeTime.flags & F_PLUS) ? '+' : '-');
         GrStringDrawCentered(&g_context, buf, len, 6, y+6, 1);
 
         y += height + 4;
@@ -442,10 +450,10 @@ void drawTimeMiddle(void)
         height = GrStringHeightGet(&g_context);
 
         len = sprintf(buf, "%1u:%02u:%02u:%1u",
-                 g_sys.tapeTime.hour,
-                 g_sys.tapeTime.mins,
-                 g_sys.tapeTime.secs,
-                 g_sys.tapeTime.tens);
+                 ts.tapeTime.hour,
+                 ts.tapeTime.mins,
+                 ts.tapeTime.secs,
+                 ts.tapeTime.tens);
 
         x = (SCREEN_WIDTH / 2) - 3;
         y = (SCREEN_HEIGHT / 2) - 5;
@@ -453,7 +461,7 @@ void drawTimeMiddle(void)
 
         /* Draw the sign in a different font as 7-seg does not have these chars */
         GrContextFontSet(&g_context, g_psFontCm14);
-        len = sprintf(buf, "%c", (g_sys.tapeTime.flags & F_PLUS) ? '+' : '-');
+        len = sprintf(buf, "%c", (ts.tapeTime.flags & F_PLUS) ? '+' : '-');
         GrStringDrawCentered(&g_context, buf, len, 6, y-3, FALSE);
 
         y += height - 5;
@@ -476,6 +484,10 @@ void drawTimeBottom(void)
     int32_t height;
     tRectangle rect, rect2;
     TAPETIME tapeTime;
+    TRANSPORT_STATE ts;
+
+    /* Take a consistent copy of the transport state */
+    TransportState_get(&ts);
 
     /*
      *  Bottom line - show current locate memory time
@@ -527,7 +539,7 @@ void drawTimeBottom(void)
 
     if (!IsLocatorSearching())
     {
-        if (g_sys.transportMode & M_RECORD)
+        if (ts.transportMode & M_RECORD)
         {
             GrContextFontSet(&g_context, g_psFontFixed6x8);
             height = GrStringHeightGet(&g_context);
@@ -560,7 +572,7 @@ void drawTimeBottom(void)
         {
             /* Draw progress as text only */
             GrContextFontSet(&g_context, g_psFontFixed6x8);
-            sprintf(buf, "%d%%", g_sys.searchProgress);
+            sprintf(buf, "%d%%", ts.searchProgress);
             GrStringDraw(&g_context, buf, -1, 100, y, 0);
         }
         else
@@ -589,7 +601,7 @@ void drawTimeBottom(void)
             int32_t x1 = rect2.i16XMin;
             int32_t x2 = rect2.i16XMax;
 
-            float progress = (float)g_sys.searchProgress * 0.01f;
+            float progress = (float)ts.searchProgress * 0.01f;
 
             x = (int16_t)((float)(x2 - x1) * progress) + x1;
 
@@ -0,0 +1,144 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Roller circumference calibration. During play the decoded SMPTE time
+ * code advances at exactly the recorded rate, so the slope of time code
+ * seconds against roller encoder position gives the seconds per encoder
+ * tick. At a known tape speed that is the tape travel per tick, and
+ * the roller circumference follows from the ticks per revolution. This
+ * takes out roller wear and any steady tape slip on the roller.
+ *
+ * The module has no RTOS dependencies. The SMPTE read task feeds it.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "TapeTime.h"
+#include "RollerCal.h"
+
+//*****************************************************************************
+// Discard all calibration data.
+//*****************************************************************************
+
+void RollerCal_init(ROLLER_CAL* cal)
+{
+    cal->x0     = 0;
+    cal->y0     = 0.0;
+    cal->xLast  = 0;
+    cal->yLast  = 0.0;
+    cal->sx     = 0.0;
+    cal->sy     = 0.0;
+    cal->sxx    = 0.0;
+    cal->sxy    = 0.0;
+    cal->n      = 0;
+    cal->pxx    = 0.0;
+    cal->pxy    = 0.0;
+    cal->points = 0;
+}
+
+//*****************************************************************************
+// Add a time code frame and the encoder position it was decoded at. If
+// the point does not follow on from the previous one the current segment
+// is ended and a new one started.
+//*****************************************************************************
+
+void RollerCal_addPoint(ROLLER_CAL* cal, int32_t position, double seconds)
+{
+    double dx;
+    double dy;
+
+    if (cal->n)
+    {
+        dx = (double)(position - cal->xLast);
+        dy = seconds - cal->yLast;
+
+        /* Time code must advance with the tape moving forward */
+        if ((dx <= 0.0) || (dy <= 0.0) || (dy > ROLLER_CAL_MAX_GAP))
+            RollerCal_segmentEnd(cal);
+    }
+
+    if (!cal->n)
+    {
+        cal->x0  = position;
+        cal->y0  = seconds;
+        cal->sx  = 0.0;
+        cal->sy  = 0.0;
+        cal->sxx = 0.0;
+        cal->sxy = 0.0;
+    }
+
+    dx = (double)(position - cal->x0);
+    dy = seconds - cal->y0;
+
+    cal->sx  += dx;
+    cal->sy  += dy;
+    cal->sxx += dx * dx;
+    cal->sxy += dx * dy;
+    cal->n++;
+
+    cal->xLast = position;
+    cal->yLast = seconds;
+}
+
+//*****************************************************************************
+// End the current segment and pool its sums about the segment mean.
+//*****************************************************************************
+
+void RollerCal_segmentEnd(ROLLER_CAL* cal)
+{
+    double n = (double)cal->n;
+
+    if (cal->n > 1)
+    {
+        cal->pxx += cal->sxx - ((cal->sx * cal->sx) / n);
+        cal->pxy += cal->sxy - ((cal->sx * cal->sy) / n);
+        cal->points += cal->n;
+    }
+
+    cal->n = 0;
+}
+
+//*****************************************************************************
+// Return the roller circumference in micro-inches for the tape speed
+// given. Returns false if there is not enough data yet.
+//*****************************************************************************
+
+bool RollerCal_result(ROLLER_CAL* cal, uint32_t ips, uint32_t* circumference)
+{
+    double pxx = cal->pxx;
+    double pxy = cal->pxy;
+    double n = (double)cal->n;
+    double slope;
+
+    /* Include the segment in progress */
+    if (cal->n > 1)
+    {
+        pxx += cal->sxx - ((cal->sx * cal->sx) / n);
+        pxy += cal->sxy - ((cal->sx * cal->sy) / n);
+    }
+
+    if (((cal->points + cal->n) < ROLLER_CAL_MIN_POINTS) || (pxx <= 0.0))
+        return false;
+
+    /* Seconds per encoder tick */
+    slope = pxy / pxx;
+
+    if (slope <= 0.0)
+        return false;
+
+    *circumference = (uint32_t)((slope * (double)ips * ROLLER_TICKS_PER_REV * 1.0e6) + 0.5);
+
+    return true;
+}
+
+/* End-Of-File */
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _ROLLERCAL_H_
+#define _ROLLERCAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Minimum number of time code frames of continuous play needed before a
+ * calibration result is given, this is about one minute at 30 fps.
+ */
+#define ROLLER_CAL_MIN_POINTS       1800
+
+/* Longest gap between two consecutive time code frames before a new
+ * segment is started, in seconds.
+ */
+#define ROLLER_CAL_MAX_GAP          0.200
+
+/*** CALIBRATION DATA ******************************************************/
+
+/* Least squares fit of time code seconds against encoder position. Each
+ * run of continuous time code is a segment with its own offset, so the
+ * sums for each segment are kept relative to the segment mean and pooled
+ * together as the segment ends. Only the slope is used.
+ */
+typedef struct _ROLLER_CAL {
+    /* Current segment */
+    int32_t     x0;             /* position of first segment point */
+    double      y0;             /* seconds at first segment point  */
+    int32_t     xLast;          /* position of the last point      */
+    double      yLast;          /* seconds at the last point       */
+    double      sx;             /* sums relative to the first point */
+    double      sy;
+    double      sxx;
+    double      sxy;
+    uint32_t    n;              /* points in the segment           */
+    /* Pooled over all segments */
+    double      pxx;
+    double      pxy;
+    uint32_t    points;         /* points in all segments          */
+} ROLLER_CAL;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void RollerCal_init(ROLLER_CAL* cal);
+void RollerCal_addPoint(ROLLER_CAL* cal, int32_t position, double seconds);
+void RollerCal_segmentEnd(ROLLER_CAL* cal);
+bool RollerCal_result(ROLLER_CAL* cal, uint32_t ips, uint32_t* circumference);
+
+#endif  /* _ROLLERCAL_H_ */
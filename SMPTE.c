@@ -80,6 +80,13 @@
 #include "STC1200.h"
 #include "Board.h"
 #include "SMPTE.h"
+#include "IPCMessage.h"
+#include "RollerCal.h"
+
+/* A new roller calibration is written to EEPROM only if it differs from
+ * the stored value by more than this many micro-inches (about 100ppm).
+ */
+#define ROLLER_CAL_SAVE_DELTA   500
 
 /* Default AT45DB parameters structure */
 const SMPTE_Params SMPTE_defaultParams = {
@@ -92,11 +99,16 @@ static SMPTE_Handle g_smpteHandle;
 
 static Semaphore_Handle g_smpteIntSemaphore;
 
+static ROLLER_CAL s_rollerCal;
+static uint32_t s_rollerCalIps;
+static uint32_t s_rollerCalSaved;
+
 /* Static Function Prototypes */
 static bool SMPTE_WriteReg(uint16_t opcode);
 static bool SMPTE_ReadReg(uint16_t opcode, uint16_t *result);
 static Void gpioSMPTEHwi(unsigned int index);
 static Void SMPTEReadTask(UArg arg0, UArg arg1);
+static void SMPTE_Calibrate(int32_t position);
 
 //*****************************************************************************
 // SMPTE Controller Construction/Destruction
@@ -188,7 +200,7 @@ bool SMPTE_init(void)
     /* Create interrupt read task */
     Error_init(&eb);
     Task_Params_init(&taskParams);
-    taskParams.stackSize = 1024;
+    taskParams.stackSize = 1536;
     taskParams.priority  = 10;
     Task_create((Task_FuncPtr)SMPTEReadTask, &taskParams, &eb);
 
@@ -223,6 +235,9 @@ Void SMPTEReadTask(UArg arg0, UArg arg1)
     SPI_Transaction transaction1;
     SPI_Transaction transaction2;
     uint32_t key;
+    int32_t position;
+
+    RollerCal_init(&s_rollerCal);
 
     while (TRUE)
     {
@@ -231,6 +246,9 @@ Void SMPTEReadTask(UArg arg0, UArg arg1)
          */
         Semaphore_pend(g_smpteIntSemaphore, BIOS_WAIT_FOREVER);
 
+        /* Tape position as close to the frame decode time as we can */
+        position = PositionPredict(NULL);
+
         /* Serialize access to SMPTE controller */
         key = GateMutex_enter(GateMutex_handle(&(g_smpteHandle->gate)));
 
@@ -280,12 +298,82 @@ Void SMPTEReadTask(UArg arg0, UArg arg1)
         //              g_sys.smpteTime.secs, g_sys.smpteTime.frame);
         //System_flush();
 
+        /* Run the roller circumference calibration */
+        SMPTE_Calibrate(position);
 
         /* Signal the TCP worker thread that position has changed */
         Event_post(g_eventTransport, Event_Id_00);
     }
 }
 
+//*****************************************************************************
+// Roller circumference calibration. Each time code frame decoded in play
+// mode is fed to the regression with the tape position it was decoded at.
+// As each minute or so of play is collected the circumference is updated
+// in the configuration data, the position task picks up the new value
+// for the tape time conversions.
+//*****************************************************************************
+
+static void SMPTE_Calibrate(int32_t position)
+{
+    TAPETIME tc;
+    uint32_t key;
+    uint32_t circumference;
+    uint32_t ips = g_sys.tapeSpeed;
+    int32_t delta;
+
+    if ((ips != 15) && (ips != 30))
+        return;
+
+    if (!s_rollerCalSaved)
+        s_rollerCalSaved = g_sys.cfgSTC.rollerCircumference;
+
+    /* Calibration applies to one tape speed at a time */
+    if (ips != s_rollerCalIps)
+    {
+        RollerCal_init(&s_rollerCal);
+        s_rollerCalIps = ips;
+    }
+
+    /* Only use time code read in play mode */
+    if (((g_sys.transportMode & MODE_MASK) != MODE_PLAY) || g_sys.searching)
+    {
+        RollerCal_segmentEnd(&s_rollerCal);
+        return;
+    }
+
+    key = Hwi_disable();
+    tc = g_sys.smpteTime;
+    Hwi_restore(key);
+
+    RollerCal_addPoint(&s_rollerCal, position, TapeFramesToSeconds(&tc));
+
+    /* Update the result every ROLLER_CAL_MIN_POINTS frames */
+    if ((s_rollerCal.points + s_rollerCal.n) % ROLLER_CAL_MIN_POINTS)
+        return;
+
+    if (!RollerCal_result(&s_rollerCal, ips, &circumference))
+        return;
+
+    /* Make sure the value is within the range the conversions accept */
+    if (!TapeTime_setCircumference(circumference))
+        return;
+
+    g_sys.cfgSTC.rollerCircumference = circumference;
+
+    delta = (int32_t)(circumference - s_rollerCalSaved);
+
+    if (abs(delta) > ROLLER_CAL_SAVE_DELTA)
+    {
+        System_printf("Roller calibrated %u uin\n", circumference);
+        System_flush();
+
+        s_rollerCalSaved = circumference;
+
+        ConfigSave(0);
+    }
+}
+
 //*****************************************************************************
 // Read/Write a command to the SMPTE slave board
 //*****************************************************************************
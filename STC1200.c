@@ -108,6 +108,7 @@
 #include "Utils.h"
 #include "SMPTE.h"
 #include "TrackCtrl.h"
+#include "CRC16.h"
 
 /* Enable div-clock output if non-zero */
 #define DIV_CLOCK_ENABLED	0
@@ -125,6 +126,7 @@ AD9837_DEVICE g_ad9837;
 Mailbox_Handle g_mailboxLocate  = NULL;
 Mailbox_Handle g_mailboxRemote  = NULL;
 Mailbox_Handle g_mailboxCommand = NULL;
+Event_Handle   g_eventLocate    = NULL;
 
 /* Static Function Prototypes */
 static void Init_Hardware();
@@ -195,6 +197,13 @@ int main(void)
         System_abort("Mailbox create failed\n");
     }
 
+    /* Create locater task wake up event */
+    Error_init(&eb);
+    g_eventLocate = Event_create(NULL, &eb);
+    if (g_eventLocate == NULL) {
+        System_abort("Event create failed\n");
+    }
+
     /* Create display task mailbox */
     Error_init(&eb);
     Mailbox_Params_init(&mboxParams);
@@ -266,6 +275,9 @@ void Init_Hardware()
     /* Enables Floating Point Hardware Unit */
     FPUEnable();
 
+    /* Enable the CRC module used for XMODEM transfers */
+    CRC16Init();
+
     /* Initialize a 1 BPP off-screen OLED display buffer that we draw into */
     GrOffScreenMonoInit();
 
@@ -399,6 +411,9 @@ void Init_Application(void)
     /* Set default reference frequency */
     g_sys.ref_freq = g_sys.cfgSTC.ref_freq;
 
+    /* Publish the initial transport state snapshot */
+    TransportState_init();
+
     /* Startup the IPC server tasks */
     IPC_Server_startup();
 
@@ -496,6 +511,18 @@ void Init_Application(void)
     taskParams.priority  = 12;
     Task_create((Task_FuncPtr)PositionTaskFxn, &taskParams, &eb);
 
+    Error_init(&eb);
+    Task_Params_init(&taskParams);
+    taskParams.stackSize = 1024;
+    taskParams.priority  = 8;
+    Task_create((Task_FuncPtr)SlipTaskFxn, &taskParams, &eb);
+
+    Error_init(&eb);
+    Task_Params_init(&taskParams);
+    taskParams.stackSize = 1024;
+    taskParams.priority  = 9;
+    Task_create((Task_FuncPtr)TelemetryTaskFxn, &taskParams, &eb);
+
     Error_init(&eb);
     Task_Params_init(&taskParams);
     taskParams.stackSize = 1024;
@@ -560,6 +587,8 @@ int ConfigLoad(int level)
 
             /* Set current tape speed as the default */
             g_sys.tapeSpeed = g_sys.cfgSTC.tapeSpeed;
+
+            TransportState_publishMode();
         }
     }
 
@@ -579,6 +608,8 @@ int ConfigReset(int level)
 
         /* Set current tape speed as the default */
         g_sys.tapeSpeed = g_sys.cfgSTC.tapeSpeed;
+
+        TransportState_publishMode();
     }
 
     return 0;
@@ -602,6 +633,9 @@ Void MainTaskFxn(UArg arg0, UArg arg1)
     /* Initialize and startup the main application tasks */
     Init_Application();
 
+    /* Load the take history from the journal on the SD card */
+    TakeJournalLoad();
+
     /* Now begin the main program command task processing loop */
 
     while (TRUE)
@@ -622,6 +656,22 @@ Void MainTaskFxn(UArg arg0, UArg arg1)
     		continue;
         }
 
+        /*
+         * Handle Take Journal Events
+         */
+
+        if (msgCmd.command == TAKE_SAVE)
+        {
+            TakeJournalSave();
+            continue;
+        }
+
+        if (msgCmd.command == TAKE_CLEAR)
+        {
+            TakeJournalErase();
+            continue;
+        }
+
         /*
          * Handle Transport Deck Button Press Events
          */
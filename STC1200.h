@@ -13,8 +13,14 @@
 #ifndef __STC1200_H
 #define __STC1200_H
 
+#include "QEIRing.h"
+#include "TapeTime.h"
+#include "MotionEst.h"
+#include "SlipDetect.h"
+#include "IndexCheck.h"
 #include "PositionTask.h"
 #include "LocateTask.h"
+#include "TransportState.h"
 #include "MCP79410.h"
 #include "AD9837.h"
 
@@ -25,6 +31,15 @@
 #include "IPCToDTC.h"
 #include "TrackCtrl.h"
 #include "STC1200TCP.h"
+#include "LocatePlan.h"
+#include "CueSeq.h"
+#include "CueStore.h"
+#include "AutoPunch.h"
+#include "LoopPlan.h"
+#include "Timeline.h"
+#include "TakeLog.h"
+#include "TakeJournal.h"
+#include "Telemetry.h"
 
 //*****************************************************************************
 // CONSTANTS AND CONFIGURATION
@@ -39,7 +54,7 @@
  * to be reset or not.
  */
 #define FIRMWARE_VER        3           /* firmware version */
-#define FIRMWARE_REV        6           /* firmware revision */
+#define FIRMWARE_REV        7           /* firmware revision */
 #define FIRMWARE_BUILD      1           /* firmware build number */
 #define FIRMWARE_MIN_BUILD  1           /* min build req'd to force reset */
 
@@ -86,12 +101,25 @@ typedef struct _SYSDAT
     int32_t 	    tapePosition;				/* signed relative position   */
     int32_t 	    tapePositionPrev;			/* previous tape position     */
     int32_t         searchProgress;             /* progress to cue (0-100%)   */
+    uint32_t        searchETA;                  /* ms left to reach the cue   */
     uint32_t	    qei_error_cnt;				/* QEI phase error count      */
     float		    tapeTach;					/* tape speed from roller     */
+    uint32_t        tapeTimestamp;              /* time position was sampled  */
+    float           tapeVelocity;               /* filtered tape speed in IPS */
+    float           tapeAccel;                  /* tape acceleration IPS/sec  */
+    float           dtcTach;                    /* reel tach read from DTC    */
+    uint32_t        slipFlags;                  /* roller slip status flags   */
 	bool		    searchCancel;               /* true if search canceling   */
 	bool            searching;                  /* true if search in progress */
     bool            autoLoop;                   /* true if loop mode running  */
     bool            autoPunch;                  /* auto punch mode active     */
+    bool            sequencing;                 /* true if cue list running   */
+    bool            punching;                   /* true if auto punch running */
+    uint32_t        recordTime;                 /* tick record went on or off */
+    uint16_t        timelineEvent;              /* last timeline event code   */
+    uint16_t        timelineCount;              /* timeline events posted     */
+    uint32_t        takeLast;                   /* newest take logged         */
+    bool            takeRecording;              /* true if a take in record   */
     /* Remote control edit data */
     uint32_t        ledMaskRemote;              /* DRC remote button LED mask */
     int32_t         remoteMode;                 /* current remote mode        */
@@ -143,6 +171,8 @@ typedef struct _SYSDAT
 
 typedef enum CommandType {
     SWITCHPRESS,
+    TAKE_SAVE,                      /* append new takes to the journal */
+    TAKE_CLEAR,                     /* clear the take history          */
 } CommandType;
 
 typedef struct CommandMessage {
@@ -1,5 +1,5 @@
 // ==========================================================================
-// STC1200TCP.h     v1.05 01/13/2023
+// STC1200TCP.h     v1.06 10/17/2026
 //
 // STC-1200 Client/Server Network Packet Definitions for the software based
 // version of the DRC digital remote control. 
@@ -97,6 +97,25 @@ typedef struct _DTC_CONFIG_DATA {
 #ifndef _STC_CONFIG_DATA_DEFINED_
 #define _STC_CONFIG_DATA_DEFINED_
 
+/* Locator transport model learned from completed locates. Index [0] is
+ * forward and [1] is rewind. Velocities are in IPS, rates in IPS/sec.
+ */
+#define STC_PLAN_SPEEDS     3           /* far, mid and near shuttle */
+#define STC_PLAN_BANDS      8           /* braking speed bands       */
+
+typedef struct _STC_LOCATE_MODEL
+{
+    float       cruise[2][STC_PLAN_SPEEDS]; /* IPS reached at each jog velocity */
+    float       slow[2];                /* IPS reached at slow shuttle */
+    float       accel[2];               /* shuttle acceleration from stop */
+    float       decel[2][STC_PLAN_BANDS]; /* braking rate by speed band */
+    float       lag[2];                 /* seconds from command to response */
+    float       punch;                  /* seconds from punch to record on/off */
+    float       spinup;                 /* inches from play to play speed */
+    float       reverse[STC_PLAN_BANDS]; /* IPS/sec rewind to play by band */
+    uint32_t    locates;                /* locates learned from */
+} STC_LOCATE_MODEL;
+
 typedef struct _STC_CONFIG_DATA
 {
     uint32_t    magic;
@@ -121,6 +140,18 @@ typedef struct _STC_CONFIG_DATA
     /* MIDI config */
     uint8_t     midiDevID;              /* midi device ID */
     uint8_t     reserved;
+    /* v1.06 - the members from here down are new and change the size
+     * of the config messages. Clients must be built with this header,
+     * a config set with any other length is refused.
+     */
+    /* Tape timer roller calibration */
+    uint32_t    rollerCircumference;    /* roller circumference in micro-inches */
+    bool        slipCorrect;            /* correct position for roller slip */
+    /* Position telemetry journal */
+    uint32_t    telemetryPeriod;        /* sample period in ms, 0=off */
+    /* Locate planner transport model */
+    bool        locateLearn;            /* learn model from each locate */
+    STC_LOCATE_MODEL locateModel;
 } STC_CONFIG_DATA;
 
 #define STC_REF_FREQ        9600.0f
@@ -169,6 +200,7 @@ typedef struct _DATETIME
 
 #define STC_PORT_STATE          1200    /* streaming transport state   */
 #define STC_PORT_COMMAND        1201    /* transport cmd/response port */
+#define STC_PORT_TELEMETRY      1202    /* position telemetry stream   */
 
 /* Defines the maximum number of tracks supported by any machine.
  * Some machines may have less, like 16 or 8 track machines.
@@ -226,7 +258,12 @@ typedef struct _STC_STATE_MSG {
     uint8_t     smpteMode;              /* SMPTE master/slave mode    */
     uint8_t     smpteFPS;               /* SMPTE frame rate id        */
     TAPETIME    smpteTime;              /* smpte tape time position   */
-    uint8_t     reserved[24];           /* reserved for future use    */
+    float       tapeVelocityIPS;        /* filtered tape speed in IPS */
+    uint16_t    timelineEvent;          /* last timeline event code   */
+    uint16_t    timelineCount;          /* timeline events posted     */
+    uint32_t    takeLast;               /* newest take logged         */
+    uint8_t     takeRecording;          /* true if a take in record   */
+    uint8_t     reserved[11];           /* reserved for future use    */
     uint8_t     trackState[STC_MAX_TRACKS];
     uint8_t     cueState[STC_MAX_CUE_POINTS];
 } STC_STATE_MSG;
@@ -249,6 +286,8 @@ typedef struct _STC_STATE_MSG {
 #define STC_M_SEARCH        0x0100      /* search active bit flag     */
 #define STC_M_LOOP          0x0200      /* loop mode active bit flag  */
 #define STC_M_PUNCH         0x0400      /* auto punch active bit flag */
+#define STC_M_SEQUENCE      0x0800      /* cue list sequence running  */
+#define STC_M_PUNCHING      0x1000      /* auto punch pass running    */
 
 #define STC_MODE_MASK       0x07        /* low 3-bits transport mode  */
 
@@ -277,6 +316,80 @@ typedef struct _STC_STATE_MSG {
 #define STC_CF_AUTO_PLAY    0x02        /* auto-play after locate     */
 #define STC_CF_AUTO_REC     0x04        /* auto-play+rec after locate */
 
+/* Cue list sequencer steps for STC_CMD_SEQ_STEP_SET/GET. The step op code
+ * is in param1 and the cue point index or time in ms is in param2.
+ */
+#define STC_SEQ_MAX_STEPS   32          /* steps held in the cue list */
+
+#define STC_SEQ_END         0           /* end the cue list here      */
+#define STC_SEQ_LOCATE      1           /* locate to cue point param2 */
+#define STC_SEQ_PLAY        2           /* play param2 ms, 0=no limit */
+#define STC_SEQ_STOP        3           /* stop the transport         */
+#define STC_SEQ_DWELL       4           /* wait param2 ms             */
+
+#define STC_SEQ_F_RECORD    0x0001      /* play step enters record    */
+
+/* Named cue store for STC_CMD_CUESTORE_xxx. Cues are known by the handle
+ * returned when added and are grouped in banks 0-255, one per song. The
+ * bitflags word holds the STC_CS_F_xxx flags and the find mode goes in
+ * the header index of STC_CMD_CUESTORE_FIND.
+ */
+#define STC_CUE_NAME_LEN    16          /* cue name with terminator   */
+#define STC_CUE_NONE        0xFFFF      /* no cue handle              */
+
+#define STC_CS_F_HERE       0x0001      /* use the current tape pos   */
+#define STC_CS_F_BANK       0x0002      /* delete all cues of bank    */
+#define STC_CS_F_MOVE       0x0004      /* set the cue tape position  */
+#define STC_CS_F_RENAME     0x0008      /* set the cue name           */
+
+#define STC_CS_FIND_NEXT    0           /* first cue past position    */
+#define STC_CS_FIND_PREV    1           /* last cue before position   */
+#define STC_CS_FIND_NEAREST 2           /* cue nearest position       */
+#define STC_CS_FIND_NAME    3           /* first cue with the name    */
+
+/* Auto punch for STC_CMD_AUTO_PUNCH_START. The punch runs between the
+ * punch in/out cue points, or the loop mark in/out points if those are
+ * not set. A pre-roll or post-roll of zero selects the default.
+ */
+#define STC_PUNCH_PREROLL   3000        /* default pre-roll ms        */
+#define STC_PUNCH_POSTROLL  1000        /* default post-roll ms       */
+#define STC_PUNCH_ROLL_MIN  1000        /* shortest pre-roll ms       */
+#define STC_PUNCH_ROLL_MAX  60000       /* longest pre/post-roll ms   */
+
+#define STC_PUNCH_F_REHEARSE 0x0001     /* switch monitors, no record */
+
+/* Position timeline for STC_CMD_TIMELINE_xxx. Each event runs an action
+ * as the tape crosses its position in the directions flagged. Events are
+ * indexed in tape position order, so the index of an event changes as
+ * events are added or deleted ahead of it.
+ */
+#define STC_TL_ALL          0xFFFF      /* all events or all tracks   */
+
+#define STC_TL_GPIO         0           /* arg=aux output, param=0-2  */
+#define STC_TL_MIDI         1           /* send MMC command param     */
+#define STC_TL_TRACK        2           /* arg=track, param=mode      */
+#define STC_TL_EVENT        3           /* post event code to clients */
+
+#define STC_TL_GPIO_OFF     0           /* aux output low             */
+#define STC_TL_GPIO_ON      1           /* aux output high            */
+#define STC_TL_GPIO_TOGGLE  2           /* aux output inverted        */
+
+#define STC_TL_F_FWD        0x01        /* fire crossing forward      */
+#define STC_TL_F_REW        0x02        /* fire crossing in reverse   */
+#define STC_TL_F_PLAY       0x04        /* only fire in play mode     */
+
+/* Take history for STC_CMD_TAKE_xxx. A take is logged for each pass in
+ * record with the tape positions record went on and off, the tracks
+ * armed and the time of day. Takes are numbered from one and the newest
+ * takes are kept in a journal on the SD card.
+ */
+#define STC_TAKE_NONE       0           /* no take number             */
+
+#define STC_TAKE_F_PUNCH    0x01        /* take recorded by auto punch */
+
+#define STC_TAKE_CMD_FIND   0x0001      /* param1 is a tape position  */
+#define STC_TAKE_CMD_PUNCH  0x0002      /* set punch points to take   */
+
 /* STC_STATE_MSG.hardwareFlags status bit flags. These flags
  * indicate the status of optional hardware systems supported.
  */
@@ -292,6 +405,40 @@ typedef struct _STC_STATE_MSG {
 #define STC_SMPTE_ENCODER   1           /* master stripe mode active  */
 #define STC_SMPTE_SLAVE     2           /* slave mode decode active   */
 
+/* Position telemetry stream. Packets stream from the STC to the client
+ * on the telemetry port. Each packet is a header followed by the number
+ * of sample records given in the header. Samples are taken at the
+ * configured telemetry period (1ms minimum) from the time the STC starts
+ * and each client gets every sample from when it connects. The sequence
+ * number counts samples so a client can tell if any were lost.
+ */
+
+#define STC_TELEMETRY_MAGIC 0x4D4C4554  /* 'TELM' little endian       */
+
+typedef struct _STC_TELEMETRY_HDR {
+    uint32_t    magic;                  /* STC_TELEMETRY_MAGIC        */
+    uint16_t    length;                 /* size of this header        */
+    uint16_t    count;                  /* sample records following   */
+    uint32_t    sequence;               /* sequence of first record   */
+    uint32_t    lost;                   /* samples lost to this client*/
+    uint32_t    timestampFreq;          /* timestamp counts per sec   */
+    uint32_t    rollerCircumference;    /* roller circ micro-inches   */
+} STC_TELEMETRY_HDR;
+
+typedef struct _STC_TELEMETRY_REC {
+    uint32_t    timestamp;              /* time sample was taken      */
+    int32_t     tapePosition;           /* signed relative position   */
+    float       tapeVelocity;           /* filtered tape speed in IPS */
+    uint16_t    transportMode;          /* mode and STC_M_* flags     */
+    uint8_t     searchProgress;         /* search progress 0-100%     */
+    uint8_t     flags;                  /* STC_TF_* status flags      */
+} STC_TELEMETRY_REC;
+
+/* STC_TELEMETRY_REC.flags status bit flags */
+#define STC_TF_MOVING       0x01        /* tape is in motion          */
+#define STC_TF_SLIP         0x02        /* timer roller slipping      */
+#define STC_TF_QEI_ERROR    0x04        /* encoder phase error burst  */
+
 // ==========================================================================
 // STC Notification Bit Flags (MUST MATCH VALUES IN DRC1200 HEADERS!)
 // ==========================================================================
@@ -434,6 +581,27 @@ typedef struct _STC_COMMAND_ARG {
 #define STC_CMD_MACADDR_GET             31
 #define STC_CMD_SMPTE_ENCODER_CTRL      32
 #define STC_CMD_SMPTE_TIME_SET          33
+#define STC_CMD_SEQ_CLEAR               34  /* clear the cue list               */
+#define STC_CMD_SEQ_STEP_SET            35  /* index=step, param1=op, param2=arg */
+#define STC_CMD_SEQ_STEP_GET            36  /* index=step                       */
+#define STC_CMD_SEQ_START               37  /* index=first step to run          */
+#define STC_CMD_SEQ_STATUS_GET          38  /* index=step running, param2=ms    */
+#define STC_CMD_CUESTORE_ADD            39  /* param1=pos, param2=bank, name    */
+#define STC_CMD_CUESTORE_DELETE         40  /* index=handle or param2=bank      */
+#define STC_CMD_CUESTORE_GET            41  /* index=handle                     */
+#define STC_CMD_CUESTORE_SET            42  /* index=handle, param1=pos, name   */
+#define STC_CMD_CUESTORE_FIND           43  /* index=mode, param1=pos, param2=bank */
+#define STC_CMD_CUESTORE_LIST           44  /* param1=nth cue, param2=bank      */
+#define STC_CMD_CUESTORE_RECALL         45  /* index=handle, param1=cue point   */
+#define STC_CMD_CUESTORE_FILE           46  /* param1 0=load, 1=store, name     */
+#define STC_CMD_AUTO_PUNCH_START        47  /* param1=pre-roll, param2=post-roll */
+#define STC_CMD_TIMELINE_ADD            48  /* event, index=event added         */
+#define STC_CMD_TIMELINE_DELETE         49  /* index=event or STC_TL_ALL        */
+#define STC_CMD_TIMELINE_GET            50  /* index=event, param1=event count  */
+#define STC_CMD_TAKE_LIST               51  /* param1=nth take back, param2=count */
+#define STC_CMD_TAKE_GET                52  /* param1=take or tape position     */
+#define STC_CMD_TAKE_LOCATE             53  /* param1=take, param2=cue flags    */
+#define STC_CMD_TAKE_CLEAR              54  /* clear the take history           */
 
 /*** STC_CMD_STOP ***********************************************************/
 
@@ -692,6 +860,184 @@ typedef struct _STC_COMMAND_SMPTE_TIME_SET {
     uint8_t             frame;
 } STC_COMMAND_SMPTE_TIME_SET;
 
+/*** STC_CMD_SEQ_CLEAR ******************************************************/
+
+typedef struct _STC_COMMAND_SEQ_CLEAR {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=0, param2=0              */
+} STC_COMMAND_SEQ_CLEAR;
+
+/*** STC_CMD_SEQ_STEP_SET ***************************************************/
+
+typedef struct _STC_COMMAND_SEQ_STEP_SET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=op, param2=cue or ms     */
+} STC_COMMAND_SEQ_STEP_SET;
+
+/*** STC_CMD_SEQ_STEP_GET ***************************************************/
+
+typedef struct _STC_COMMAND_SEQ_STEP_GET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=op, param2=cue or ms     */
+} STC_COMMAND_SEQ_STEP_GET;
+
+/*** STC_CMD_SEQ_START ******************************************************/
+
+typedef struct _STC_COMMAND_SEQ_START {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=0, param2=0              */
+} STC_COMMAND_SEQ_START;
+
+/*** STC_CMD_SEQ_STATUS_GET *************************************************/
+
+typedef struct _STC_COMMAND_SEQ_STATUS_GET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1 1=running, param2=ms left */
+} STC_COMMAND_SEQ_STATUS_GET;
+
+/*** STC_CMD_CUESTORE_ADD ***************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_ADD {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=pos, param2=bank, flags  */
+    char                name[STC_CUE_NAME_LEN];
+} STC_COMMAND_CUESTORE_ADD;
+
+/*** STC_CMD_CUESTORE_DELETE ************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_DELETE {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=cues deleted, param2=bank */
+} STC_COMMAND_CUESTORE_DELETE;
+
+/*** STC_CMD_CUESTORE_GET ***************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_GET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=pos, param2=bank, flags  */
+    char                name[STC_CUE_NAME_LEN];
+} STC_COMMAND_CUESTORE_GET;
+
+/*** STC_CMD_CUESTORE_SET ***************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_SET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=pos, param2=0            */
+    char                name[STC_CUE_NAME_LEN];
+} STC_COMMAND_CUESTORE_SET;
+
+/*** STC_CMD_CUESTORE_FIND **************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_FIND {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=pos, param2=bank         */
+    char                name[STC_CUE_NAME_LEN];
+} STC_COMMAND_CUESTORE_FIND;
+
+/*** STC_CMD_CUESTORE_LIST **************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_LIST {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=pos, param2=bank count   */
+    char                name[STC_CUE_NAME_LEN];
+} STC_COMMAND_CUESTORE_LIST;
+
+/*** STC_CMD_CUESTORE_RECALL ************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_RECALL {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=cue point, param2=0      */
+} STC_COMMAND_CUESTORE_RECALL;
+
+/*** STC_CMD_CUESTORE_FILE **************************************************/
+
+typedef struct _STC_COMMAND_CUESTORE_FILE {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1 0=load, 1=store          */
+    char                name[STC_CUE_NAME_LEN];
+} STC_COMMAND_CUESTORE_FILE;
+
+/*** STC_CMD_AUTO_PUNCH_START ***********************************************/
+
+typedef struct _STC_COMMAND_AUTO_PUNCH_START {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=pre-roll ms, param2=post-roll ms */
+} STC_COMMAND_AUTO_PUNCH_START;
+
+/*** STC_TIMELINE_EVENT *****************************************************/
+
+typedef struct _STC_TIMELINE_EVENT {
+    int32_t             ipos;       /* tape position of the event      */
+    uint8_t             action;     /* STC_TL_xxx action               */
+    uint8_t             flags;      /* STC_TL_F_xxx flags              */
+    uint16_t            arg;        /* action argument                 */
+    uint32_t            param;      /* action parameter                */
+} STC_TIMELINE_EVENT;
+
+/*** STC_CMD_TIMELINE_ADD ***************************************************/
+
+typedef struct _STC_COMMAND_TIMELINE_ADD {
+    STC_COMMAND_HDR     hdr;
+    STC_TIMELINE_EVENT  event;
+} STC_COMMAND_TIMELINE_ADD;
+
+/*** STC_CMD_TIMELINE_DELETE ************************************************/
+
+typedef struct _STC_COMMAND_TIMELINE_DELETE {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=events deleted           */
+} STC_COMMAND_TIMELINE_DELETE;
+
+/*** STC_CMD_TIMELINE_GET ***************************************************/
+
+typedef struct _STC_COMMAND_TIMELINE_GET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=event count              */
+    STC_TIMELINE_EVENT  event;
+} STC_COMMAND_TIMELINE_GET;
+
+/*** STC_TAKE_INFO **********************************************************/
+
+typedef struct _STC_TAKE_INFO {
+    uint32_t            take;       /* take number, from 1             */
+    int32_t             start;      /* tape position record went on    */
+    int32_t             end;        /* tape position record went off   */
+    uint32_t            tracks;     /* tracks armed, bit per track     */
+    uint32_t            length;     /* ms in record                    */
+    DATETIME            time;       /* RTC time record went on         */
+    uint8_t             flags;      /* STC_TAKE_F_xxx flags            */
+} STC_TAKE_INFO;
+
+/*** STC_CMD_TAKE_LIST ******************************************************/
+
+typedef struct _STC_COMMAND_TAKE_LIST {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=take, param2=take count  */
+    STC_TAKE_INFO       take;
+} STC_COMMAND_TAKE_LIST;
+
+/*** STC_CMD_TAKE_GET *******************************************************/
+
+typedef struct _STC_COMMAND_TAKE_GET {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=take, param2=take count  */
+    STC_TAKE_INFO       take;
+} STC_COMMAND_TAKE_GET;
+
+/*** STC_CMD_TAKE_LOCATE ****************************************************/
+
+typedef struct _STC_COMMAND_TAKE_LOCATE {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=take, param2=cue flags   */
+} STC_COMMAND_TAKE_LOCATE;
+
+/*** STC_CMD_TAKE_CLEAR *****************************************************/
+
+typedef struct _STC_COMMAND_TAKE_CLEAR {
+    STC_COMMAND_HDR     hdr;
+    STC_COMMAND_ARG     arg;        /* param1=0, param2=0              */
+} STC_COMMAND_TAKE_CLEAR;
+
 #pragma pack(pop)
 
 /* End-Of-File */
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _SEQLOCK_H_
+#define _SEQLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Sequence lock for publishing a record to readers without disabling
+ * interrupts. The record is kept as two copies. The writer bumps the
+ * sequence before updating each copy, so readers are always pointed at
+ * the copy that is not being written. A reader copies the record out
+ * and retries if the sequence changed while it was copying.
+ *
+ * Since the reader never waits on a write in progress, a reader can't
+ * be held off by a lower priority writer it has preempted. The only
+ * retry is when a write completes during the copy, and then the copy
+ * taken on the retry is the newest.
+ *
+ *   Writer                          Reader
+ *
+ *   Seqlock_writeBegin(&lock);      do {
+ *   update(&data[0]);                   seq = Seqlock_readBegin(&lock);
+ *   Seqlock_writeSwap(&lock);           copy = data[Seqlock_index(seq)];
+ *   update(&data[1]);               } while (Seqlock_readRetry(&lock, seq));
+ *
+ * The data copies must be declared volatile. Writers must be serialized
+ * with each other by the caller if there is more than one.
+ */
+
+/* Memory barrier between the sequence and data accesses. None is needed
+ * on the single core Cortex-M4 since the sequence and data are volatile.
+ */
+#ifndef SEQLOCK_BARRIER
+#define SEQLOCK_BARRIER()
+#endif
+
+typedef struct _SEQLOCK {
+    volatile uint32_t   sequence;   /* two counts per completed write */
+} SEQLOCK;
+
+/*** INLINE FUNCTIONS ******************************************************/
+
+static inline void Seqlock_init(SEQLOCK* lock)
+{
+    lock->sequence = 0;
+}
+
+/* Point readers at copy 1 while copy 0 is updated */
+static inline void Seqlock_writeBegin(SEQLOCK* lock)
+{
+    lock->sequence++;
+    SEQLOCK_BARRIER();
+}
+
+/* Point readers at the updated copy 0 while copy 1 is updated */
+static inline void Seqlock_writeSwap(SEQLOCK* lock)
+{
+    SEQLOCK_BARRIER();
+    lock->sequence++;
+    SEQLOCK_BARRIER();
+}
+
+static inline uint32_t Seqlock_readBegin(SEQLOCK* lock)
+{
+    uint32_t seq = lock->sequence;
+    SEQLOCK_BARRIER();
+    return seq;
+}
+
+/* Index of the data copy readers should use for the sequence */
+static inline uint32_t Seqlock_index(uint32_t seq)
+{
+    return seq & 1;
+}
+
+static inline bool Seqlock_readRetry(SEQLOCK* lock, uint32_t seq)
+{
+    SEQLOCK_BARRIER();
+    return (lock->sequence != seq) ? true : false;
+}
+
+/* Number of writes completed as of the sequence read */
+static inline uint32_t Seqlock_version(uint32_t seq)
+{
+    return seq >> 1;
+}
+
+#endif  /* _SEQLOCK_H_ */
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Roller slip detection. The timer roller is driven only by friction with
+ * the tape, so at high wind speeds it can slip and the tape position falls
+ * behind the real tape. The DTC reel tach isn't affected by roller slip.
+ * The ratio of roller velocity to DTC tach is learned while the two agree.
+ * When the roller suddenly runs slow against the tach the roller is taken
+ * to be slipping. The distance the roller missed is kept so the caller
+ * can correct the position if it wants to.
+ *
+ * The module has no RTOS dependencies, the caller supplies the DTC tach
+ * read over IPC and the QEI phase error count.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "SlipDetect.h"
+
+//*****************************************************************************
+// Reset the slip detector. The current QEI phase error count is given so
+// any errors before now are not counted as a burst.
+//*****************************************************************************
+
+void SlipDetect_init(SLIP_DETECT* slip, uint32_t errorCount)
+{
+    slip->ratio       = 0.0f;
+    slip->learnCount  = 0;
+    slip->slipCount   = 0;
+    slip->errorCount  = errorCount;
+    slip->errorHold   = 0;
+    slip->correction  = 0.0f;
+    slip->flags       = 0;
+    slip->slipEvents  = 0;
+    slip->errorBursts = 0;
+}
+
+//*****************************************************************************
+// Run one cross check of the roller velocity in IPS against the DTC tach.
+// The shuttle flag is true if the transport is in fast wind, which is the
+// only time slip is checked for. The time since the last check is given
+// in seconds. Returns the SLIP_F_* flags.
+//*****************************************************************************
+
+uint32_t SlipDetect_update(SLIP_DETECT* slip, float rollerIPS, float dtcTach,
+                           uint32_t errorCount, bool shuttle, float dt)
+{
+    float roller = (rollerIPS < 0.0f) ? -rollerIPS : rollerIPS;
+    float tach = (dtcTach < 0.0f) ? -dtcTach : dtcTach;
+    float expected;
+    float ratio;
+
+    /* Look for a burst of QEI phase errors since the last check */
+    if ((errorCount - slip->errorCount) >= SLIP_ERROR_BURST)
+    {
+        if (!slip->errorHold)
+            slip->errorBursts++;
+
+        slip->errorHold = SLIP_ERROR_HOLD;
+    }
+
+    slip->errorCount = errorCount;
+
+    if (slip->errorHold)
+    {
+        slip->errorHold--;
+        slip->flags |= SLIP_F_ERRORS;
+    }
+    else
+    {
+        slip->flags &= ~(SLIP_F_ERRORS);
+    }
+
+    /* Nothing to compare against if either is too slow */
+    if ((tach <= 0.0f) || ((roller < SLIP_MIN_IPS) && !(slip->flags & SLIP_F_SLIP)))
+    {
+        slip->slipCount = 0;
+        slip->flags &= ~(SLIP_F_SLIP);
+        return slip->flags;
+    }
+
+    expected = slip->ratio * tach;
+
+    /* Check for the roller running slow against the tach */
+    if (shuttle && (slip->flags & SLIP_F_LEARNED) &&
+        (roller < (expected * (1.0f - SLIP_THRESHOLD))))
+    {
+        if (slip->slipCount < SLIP_CHECKS)
+        {
+            if (++slip->slipCount == SLIP_CHECKS)
+            {
+                slip->flags |= SLIP_F_SLIP;
+                slip->slipEvents++;
+            }
+        }
+
+        /* Keep the distance the roller has missed */
+        if (slip->flags & SLIP_F_SLIP)
+            slip->correction += (expected - roller) * dt;
+
+        return slip->flags;
+    }
+
+    slip->slipCount = 0;
+    slip->flags &= ~(SLIP_F_SLIP);
+
+    /* Don't learn the ratio while there are phase errors */
+    if (slip->flags & SLIP_F_ERRORS)
+        return slip->flags;
+
+    ratio = roller / tach;
+
+    if (!slip->learnCount)
+        slip->ratio = ratio;
+    else
+        slip->ratio += SLIP_RATIO_ALPHA * (ratio - slip->ratio);
+
+    if (++slip->learnCount >= (uint32_t)(1.0f / SLIP_RATIO_ALPHA))
+        slip->flags |= SLIP_F_LEARNED;
+
+    return slip->flags;
+}
+
+//*****************************************************************************
+// Return the distance in inches the roller has missed due to slip since
+// the last call, then clear it.
+//*****************************************************************************
+
+float SlipDetect_takeCorrection(SLIP_DETECT* slip)
+{
+    float correction = slip->correction;
+
+    slip->correction = 0.0f;
+
+    return correction;
+}
+
+/* End-Of-File */
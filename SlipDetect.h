@@ -0,0 +1,70 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _SLIPDETECT_H_
+#define _SLIPDETECT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Roller velocity below this fraction of the expected velocity counts
+ * as slipping. The expected velocity tracks the DTC tach, so this has to
+ * allow for the tach to roller ratio changing as the reel packs change.
+ */
+#define SLIP_THRESHOLD          0.10f
+
+/* Number of consecutive slipping checks before slip is flagged */
+#define SLIP_CHECKS             3
+
+/* Minimum tape speed in IPS the cross check is made at */
+#define SLIP_MIN_IPS            20.0f
+
+/* Smoothing for the learned roller to tach ratio */
+#define SLIP_RATIO_ALPHA        0.02f
+
+/* QEI phase errors in a single check counted as an error burst and the
+ * number of checks the error burst flag is held set.
+ */
+#define SLIP_ERROR_BURST        4
+#define SLIP_ERROR_HOLD         20
+
+/* SLIP_DETECT.flags */
+#define SLIP_F_SLIP             0x01    /* roller slipping on the tape  */
+#define SLIP_F_ERRORS           0x02    /* QEI phase error burst        */
+#define SLIP_F_LEARNED          0x04    /* roller to tach ratio learned */
+
+/*** SLIP DETECTOR DATA ****************************************************/
+
+typedef struct _SLIP_DETECT {
+    float       ratio;          /* learned roller IPS per tach unit */
+    uint32_t    learnCount;     /* checks the ratio was learned at  */
+    uint32_t    slipCount;      /* consecutive slipping checks      */
+    uint32_t    errorCount;     /* last QEI phase error count       */
+    uint32_t    errorHold;      /* checks left to hold error flag   */
+    float       correction;     /* distance lost to slip in inches  */
+    uint32_t    flags;          /* SLIP_F_* status flags            */
+    uint32_t    slipEvents;     /* times slip has been flagged      */
+    uint32_t    errorBursts;    /* times error bursts were flagged  */
+} SLIP_DETECT;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void SlipDetect_init(SLIP_DETECT* slip, uint32_t errorCount);
+
+uint32_t SlipDetect_update(SLIP_DETECT* slip, float rollerIPS, float dtcTach,
+                           uint32_t errorCount, bool shuttle, float dt);
+
+float SlipDetect_takeCorrection(SLIP_DETECT* slip);
+
+#endif  /* _SLIPDETECT_H_ */
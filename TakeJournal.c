@@ -0,0 +1,431 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Take journal. The IPC task reports each time the DTC turns record on or
+ * off, and a pass is logged in the take log (see TakeLog.c) with the tape
+ * positions, the tracks armed and the RTC time. The take log is guarded by
+ * g_semaTake and only held for the take log calls, so the IPC task never
+ * waits on the SD card.
+ *
+ * As each pass ends the main task is sent TAKE_SAVE and appends the new
+ * takes to the journal file on the SD card. The journal is loaded by the
+ * main task at power up, so the take history and take numbers carry on
+ * from the last session. A torn record at the end of the journal, or a
+ * journal grown well past the takes held, is rewritten with just the
+ * takes held.
+ */
+
+/* XDCtools Header files */
+#include <xdc/std.h>
+#include <xdc/cfg/global.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Error.h>
+
+/* BIOS Header files */
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Mailbox.h>
+#include <ti/sysbios/family/arm/m3/Hwi.h>
+
+/* TI-RTOS Driver files */
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/SDSPI.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/UART.h>
+#include <ti/mw/fatfs/ff.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "STC1200.h"
+#include "Board.h"
+
+/*** External Data Items ***/
+
+extern Mailbox_Handle g_mailboxCommand;
+
+/*** Static Data Items ***/
+
+/* Take log, guarded by g_semaTake */
+static TAKE_LOG s_takeLog;
+
+/* Journal file and the next take to append to it, used by the main task */
+static FIL s_takeFile;
+static uint32_t s_takeSave = 1;
+static size_t s_takeRecords = 0;
+
+/*** Static Function Prototypes ***/
+
+static void JournalRewrite(void);
+static void TakePublish(void);
+static void CuePointLoad(size_t index, int32_t ipos);
+
+//*****************************************************************************
+// Called by the IPC task as the DTC turns record on or off. Begins a pass
+// with the tracks armed, or ends it and has the main task save the take.
+//*****************************************************************************
+
+void TakeJournalRecord(Bool record)
+{
+    size_t i;
+    uint32_t tracks = 0;
+    DATETIME time;
+    CommandMessage msg;
+    const TAKE_ENTRY* entry = NULL;
+
+    Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+    if (record)
+    {
+        for (i=0; i < MAX_TRACKS; i++)
+        {
+            if (g_sys.trackState[i] & STC_T_READY)
+                tracks |= (1 << i);
+        }
+
+        time.sec     = g_sys.timeDate.sec;
+        time.min     = g_sys.timeDate.min;
+        time.hour    = g_sys.timeDate.hour;
+        time.weekday = g_sys.timeDate.weekday;
+        time.date    = g_sys.timeDate.date;
+        time.month   = g_sys.timeDate.month;
+        time.year    = g_sys.timeDate.year;
+
+        TakeLog_begin(&s_takeLog, g_sys.tapePosition, tracks, &time, Clock_getTicks(),
+                      g_sys.punching ? TAKE_F_PUNCH : 0);
+    }
+    else
+    {
+        entry = TakeLog_end(&s_takeLog, g_sys.tapePosition, Clock_getTicks());
+    }
+
+    TakePublish();
+
+    Semaphore_post(g_semaTake);
+
+    /* A take was logged, have the main task append it to the journal.
+     * If the mailbox is full it goes with the next take saved.
+     */
+    if (entry)
+    {
+        msg.command = TAKE_SAVE;
+        msg.param   = 0;
+
+        Mailbox_post(g_mailboxCommand, &msg, BIOS_NO_WAIT);
+    }
+}
+
+//*****************************************************************************
+// Copy a take by take number. The count of take numbers held is returned
+// if count is not NULL.
+//*****************************************************************************
+
+Bool TakeJournalGet(uint32_t take, TAKE_ENTRY* entry, size_t* count)
+{
+    const TAKE_ENTRY* p;
+
+    Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+    if ((p = TakeLog_get(&s_takeLog, take)) != NULL)
+        *entry = *p;
+
+    if (count)
+        *count = TakeLog_count(&s_takeLog);
+
+    Semaphore_post(g_semaTake);
+
+    return (p != NULL) ? TRUE : FALSE;
+}
+
+//*****************************************************************************
+// Copy the nth take back, where zero is the newest take.
+//*****************************************************************************
+
+Bool TakeJournalAt(size_t n, TAKE_ENTRY* entry, size_t* count)
+{
+    const TAKE_ENTRY* p;
+
+    Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+    if ((p = TakeLog_at(&s_takeLog, n)) != NULL)
+        *entry = *p;
+
+    if (count)
+        *count = TakeLog_count(&s_takeLog);
+
+    Semaphore_post(g_semaTake);
+
+    return (p != NULL) ? TRUE : FALSE;
+}
+
+//*****************************************************************************
+// Copy the newest take recorded over a tape position.
+//*****************************************************************************
+
+Bool TakeJournalFind(int32_t ipos, TAKE_ENTRY* entry, size_t* count)
+{
+    const TAKE_ENTRY* p;
+
+    Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+    if ((p = TakeLog_find(&s_takeLog, ipos)) != NULL)
+        *entry = *p;
+
+    if (count)
+        *count = TakeLog_count(&s_takeLog);
+
+    Semaphore_post(g_semaTake);
+
+    return (p != NULL) ? TRUE : FALSE;
+}
+
+//*****************************************************************************
+// Locate to the start of a take. The take start is loaded into the home
+// cue point, so the transport search button returns there again. With
+// punch set the punch in/out points are set to the take as well, ready
+// to punch the take again with STC_CMD_AUTO_PUNCH_START.
+//*****************************************************************************
+
+Bool TakeJournalLocate(uint32_t take, uint32_t cue_flags, Bool punch)
+{
+    TAKE_ENTRY entry;
+
+    if (!TakeJournalGet(take, &entry, NULL))
+        return FALSE;
+
+    if (punch)
+    {
+        CuePointLoad(CUE_POINT_PUNCH_IN, (entry.start <= entry.end) ? entry.start : entry.end);
+        CuePointLoad(CUE_POINT_PUNCH_OUT, (entry.start <= entry.end) ? entry.end : entry.start);
+    }
+
+    CuePointLoad(CUE_POINT_HOME, entry.start);
+
+    return LocateSearch(CUE_POINT_HOME, cue_flags);
+}
+
+//*****************************************************************************
+// Have the main task clear the take history and the journal.
+//*****************************************************************************
+
+Bool TakeJournalClear(void)
+{
+    CommandMessage msg;
+
+    msg.command = TAKE_CLEAR;
+    msg.param   = 0;
+
+    return Mailbox_post(g_mailboxCommand, &msg, BIOS_NO_WAIT);
+}
+
+//*****************************************************************************
+// Load the take log from the journal on the SD card. Called by the main
+// task at power up. The take log is held while the journal is read, as a
+// pass ended part way through would take a number the journal may hold.
+//*****************************************************************************
+
+void TakeJournalLoad(void)
+{
+    TAKE_FILE_HDR hdr;
+    TAKE_FILE_REC rec;
+    FRESULT res;
+    UINT br = 0;
+    Bool rewrite = FALSE;
+
+    Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+    TakeLog_init(&s_takeLog);
+
+    s_takeRecords = 0;
+
+    if (f_open(&s_takeFile, TAKE_JOURNAL_FILE, FA_READ) == FR_OK)
+    {
+        res = f_read(&s_takeFile, &hdr, sizeof(hdr), &br);
+
+        if ((res == FR_OK) && (br == sizeof(hdr)) &&
+            (hdr.magic == TAKE_FILE_MAGIC) && (hdr.version == TAKE_FILE_VERSION))
+        {
+            while (((res = f_read(&s_takeFile, &rec, sizeof(rec), &br)) == FR_OK) &&
+                   (br == sizeof(rec)))
+            {
+                if (!TakeLog_load(&s_takeLog, &rec))
+                    break;
+
+                s_takeRecords++;
+            }
+
+            /* Stopped short of the end on a torn record */
+            if ((res != FR_OK) || (br != 0))
+                rewrite = TRUE;
+        }
+        else
+        {
+            rewrite = TRUE;
+        }
+
+        f_close(&s_takeFile);
+    }
+
+    s_takeSave = s_takeLog.next;
+
+    TakePublish();
+
+    Semaphore_post(g_semaTake);
+
+    TransportState_publishMode();
+
+    if (rewrite || (s_takeRecords > TAKE_JOURNAL_MAX))
+        JournalRewrite();
+}
+
+//*****************************************************************************
+// Append the takes logged since the last save to the journal. Called by
+// the main task on TAKE_SAVE. A take that fails to write is tried again
+// with the next save.
+//*****************************************************************************
+
+void TakeJournalSave(void)
+{
+    TAKE_FILE_HDR hdr;
+    TAKE_FILE_REC rec;
+    const TAKE_ENTRY* entry;
+    FRESULT res;
+    UINT bw;
+    Bool more;
+
+    if (s_takeRecords >= TAKE_JOURNAL_MAX)
+    {
+        JournalRewrite();
+        return;
+    }
+
+    if (f_open(&s_takeFile, TAKE_JOURNAL_FILE, FA_WRITE | FA_OPEN_ALWAYS) != FR_OK)
+        return;
+
+    if (f_size(&s_takeFile) == 0)
+    {
+        hdr.magic       = TAKE_FILE_MAGIC;
+        hdr.version     = TAKE_FILE_VERSION;
+        hdr.reserved[0] = 0;
+        hdr.reserved[1] = 0;
+
+        if (((res = f_write(&s_takeFile, &hdr, sizeof(hdr), &bw)) == FR_OK) && (bw != sizeof(hdr)))
+            res = FR_DENIED;
+    }
+    else
+    {
+        res = f_lseek(&s_takeFile, f_size(&s_takeFile));
+    }
+
+    while (res == FR_OK)
+    {
+        entry = NULL;
+
+        Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+        /* Skip any takes the ring dropped before they were saved */
+        if (s_takeSave < s_takeLog.first)
+            s_takeSave = s_takeLog.first;
+
+        more = (s_takeSave < s_takeLog.next) ? TRUE : FALSE;
+
+        if (more && ((entry = TakeLog_get(&s_takeLog, s_takeSave)) != NULL))
+            TakeLog_seal(&rec, entry);
+
+        Semaphore_post(g_semaTake);
+
+        if (!more)
+            break;
+
+        /* Write the take, a short write means the card is full */
+        if (entry)
+        {
+            if (((res = f_write(&s_takeFile, &rec, sizeof(rec), &bw)) == FR_OK) && (bw != sizeof(rec)))
+                res = FR_DENIED;
+
+            if (res != FR_OK)
+                break;
+
+            s_takeRecords++;
+        }
+
+        s_takeSave++;
+    }
+
+    f_close(&s_takeFile);
+}
+
+//*****************************************************************************
+// Clear the take history and the journal. Called by the main task on
+// TAKE_CLEAR. Take numbers start again from one.
+//*****************************************************************************
+
+void TakeJournalErase(void)
+{
+    Semaphore_pend(g_semaTake, BIOS_WAIT_FOREVER);
+
+    TakeLog_init(&s_takeLog);
+
+    TakePublish();
+
+    Semaphore_post(g_semaTake);
+
+    TransportState_publishMode();
+
+    JournalRewrite();
+}
+
+/* Start the journal again and save the takes held to it */
+static void JournalRewrite(void)
+{
+    if (f_open(&s_takeFile, TAKE_JOURNAL_FILE, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return;
+
+    f_close(&s_takeFile);
+
+    s_takeRecords = 0;
+    s_takeSave    = 1;
+
+    TakeJournalSave();
+}
+
+/* Copy the newest take and record state for the transport state */
+static void TakePublish(void)
+{
+    g_sys.takeLast      = s_takeLog.next - 1;
+    g_sys.takeRecording = s_takeLog.recording;
+}
+
+/* Load a cue point memory, zero being a tape position like any other */
+static void CuePointLoad(size_t index, int32_t ipos)
+{
+    uint32_t key;
+
+    Semaphore_pend(g_semaCue, BIOS_WAIT_FOREVER);
+
+    key = Hwi_disable();
+
+    g_sys.cuePoint[index].ipos  = ipos;
+    g_sys.cuePoint[index].flags = CF_ACTIVE;
+
+    Hwi_restore(key);
+
+    TransportState_publishCues();
+
+    Semaphore_post(g_semaCue);
+}
+
+/* End-Of-File */
@@ -0,0 +1,40 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TAKEJOURNAL_H_
+#define _TAKEJOURNAL_H_
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Take journal file on the SD card */
+#define TAKE_JOURNAL_FILE       "0:takes"
+
+/* The journal is rewritten with just the takes held once it grows past
+ * this many records.
+ */
+#define TAKE_JOURNAL_MAX        (TAKE_LOG_MAX * 2)
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void TakeJournalRecord(Bool record);
+
+Bool TakeJournalGet(uint32_t take, TAKE_ENTRY* entry, size_t* count);
+Bool TakeJournalAt(size_t n, TAKE_ENTRY* entry, size_t* count);
+Bool TakeJournalFind(int32_t ipos, TAKE_ENTRY* entry, size_t* count);
+Bool TakeJournalLocate(uint32_t take, uint32_t cue_flags, Bool punch);
+Bool TakeJournalClear(void);
+
+void TakeJournalLoad(void);
+void TakeJournalSave(void);
+void TakeJournalErase(void);
+
+#endif  /* _TAKEJOURNAL_H_ */
@@ -0,0 +1,234 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Take history of record passes. Each time record goes on a pass is begun
+ * with the tape position, the tracks armed and the time of day. When record
+ * goes off the pass is ended with the tape position and the time spent in
+ * record, and becomes the next numbered take.
+ *
+ * Takes are numbered from one and held in a ring indexed by take number, so
+ * finding a take by number or by how many takes back it was is a single
+ * lookup. Once the ring is full each new take replaces the oldest. Finding
+ * the newest take that covers a tape position walks back from the newest.
+ *
+ * The caller saves each take to a journal file as it ends, sealed with a
+ * checksum, and loads the journal again at power up. A record torn by a
+ * power loss fails the checksum, so loading stops there and the takes before
+ * it are kept. The module has no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "TakeLog.h"
+
+/* Static Function Prototypes */
+static uint32_t Checksum(const void* data, size_t len);
+
+//*****************************************************************************
+// Clear the take log. Take numbers start again from one.
+//*****************************************************************************
+
+void TakeLog_init(TAKE_LOG* log)
+{
+    memset(log, 0, sizeof(TAKE_LOG));
+
+    log->first = 1;
+    log->next  = 1;
+}
+
+//*****************************************************************************
+// Begin a pass as record goes on at the tape position given. The tracks
+// are a bit mask of the tracks armed and now is the time in ms. A pass
+// already begun is dropped.
+//*****************************************************************************
+
+void TakeLog_begin(TAKE_LOG* log, int32_t ipos, uint32_t tracks, const DATETIME* time,
+                   uint32_t now, uint8_t flags)
+{
+    memset(&log->pass, 0, sizeof(TAKE_ENTRY));
+
+    log->pass.start  = ipos;
+    log->pass.end    = ipos;
+    log->pass.tracks = tracks;
+    log->pass.time   = *time;
+    log->pass.flags  = flags;
+
+    log->passTime  = now;
+    log->recording = true;
+}
+
+//*****************************************************************************
+// End the pass as record goes off at the tape position given and log it
+// as the next take. Returns the take logged, or NULL if no pass was begun
+// or it was too short to keep.
+//*****************************************************************************
+
+const TAKE_ENTRY* TakeLog_end(TAKE_LOG* log, int32_t ipos, uint32_t now)
+{
+    if (!log->recording)
+        return NULL;
+
+    log->recording = false;
+
+    log->pass.end    = ipos;
+    log->pass.length = now - log->passTime;
+
+    if (log->pass.length < TAKE_LENGTH_MIN)
+        return NULL;
+
+    log->pass.take = log->next;
+
+    if (!TakeLog_put(log, &log->pass))
+        return NULL;
+
+    return TakeLog_get(log, log->pass.take);
+}
+
+//*****************************************************************************
+// Add a take with its own take number, as when the journal is loaded. Takes
+// must be put in increasing take number order. Any numbers skipped are left
+// as gaps, and the take numbers carry on after the last take put.
+//*****************************************************************************
+
+bool TakeLog_put(TAKE_LOG* log, const TAKE_ENTRY* entry)
+{
+    if ((entry->take == 0) || (entry->take < log->next))
+        return false;
+
+    /* The first take put in an empty log is the oldest held */
+    if (log->first == log->next)
+        log->first = entry->take;
+
+    log->entry[entry->take % TAKE_LOG_MAX] = *entry;
+
+    log->next = entry->take + 1;
+
+    /* Drop the takes the ring no longer holds */
+    if ((log->next - log->first) > TAKE_LOG_MAX)
+        log->first = log->next - TAKE_LOG_MAX;
+
+    return true;
+}
+
+//*****************************************************************************
+// Return a take by take number, or NULL if the log doesn't hold it.
+//*****************************************************************************
+
+const TAKE_ENTRY* TakeLog_get(TAKE_LOG* log, uint32_t take)
+{
+    TAKE_ENTRY* entry;
+
+    if ((take < log->first) || (take >= log->next))
+        return NULL;
+
+    entry = &log->entry[take % TAKE_LOG_MAX];
+
+    /* A gap left in the take numbers */
+    if (entry->take != take)
+        return NULL;
+
+    return entry;
+}
+
+//*****************************************************************************
+// Return the nth take back, where zero is the newest take, or NULL if the
+// log doesn't hold it.
+//*****************************************************************************
+
+const TAKE_ENTRY* TakeLog_at(TAKE_LOG* log, size_t n)
+{
+    if (n >= TakeLog_count(log))
+        return NULL;
+
+    return TakeLog_get(log, log->next - 1 - (uint32_t)n);
+}
+
+//*****************************************************************************
+// Return the number of take numbers held, from the oldest to the newest.
+//*****************************************************************************
+
+size_t TakeLog_count(TAKE_LOG* log)
+{
+    return (size_t)(log->next - log->first);
+}
+
+//*****************************************************************************
+// Return the newest take recorded over the tape position given, or NULL
+// if there is none.
+//*****************************************************************************
+
+const TAKE_ENTRY* TakeLog_find(TAKE_LOG* log, int32_t ipos)
+{
+    const TAKE_ENTRY* entry;
+    uint32_t take;
+
+    for (take=log->next; take > log->first; take--)
+    {
+        if ((entry = TakeLog_get(log, take - 1)) == NULL)
+            continue;
+
+        if ((entry->start <= entry->end) ?
+            ((ipos >= entry->start) && (ipos <= entry->end)) :
+            ((ipos >= entry->end) && (ipos <= entry->start)))
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+// Fill a journal file record for a take.
+//*****************************************************************************
+
+void TakeLog_seal(TAKE_FILE_REC* rec, const TAKE_ENTRY* entry)
+{
+    rec->take  = *entry;
+    rec->check = Checksum(&rec->take, sizeof(TAKE_ENTRY));
+}
+
+//*****************************************************************************
+// Check a journal file record read back and add the take it holds. Returns
+// false if the record is torn or out of order.
+//*****************************************************************************
+
+bool TakeLog_load(TAKE_LOG* log, const TAKE_FILE_REC* rec)
+{
+    if (rec->check != Checksum(&rec->take, sizeof(TAKE_ENTRY)))
+        return false;
+
+    return TakeLog_put(log, &rec->take);
+}
+
+/* Fletcher-32 of the bytes given */
+static uint32_t Checksum(const void* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t a = 0xFFFF;
+    uint32_t b = 0xFFFF;
+
+    while (len--)
+    {
+        a = (a + *p++) % 65535;
+        b = (b + a) % 65535;
+    }
+
+    return (b << 16) | a;
+}
+
+/* End-Of-File */
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TAKELOG_H_
+#define _TAKELOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Record passes held, the newest replacing the oldest once full. Each
+ * takes a TAKE_ENTRY of 28 bytes, 7K in all. The host tools build with
+ * a smaller log so it wraps sooner.
+ */
+#ifndef TAKE_LOG_MAX
+#define TAKE_LOG_MAX            256
+#endif
+
+/* Passes with less than this many ms in record are not logged */
+#define TAKE_LENGTH_MIN         250
+
+/* Take flags */
+#define TAKE_F_PUNCH            STC_TAKE_F_PUNCH
+
+/* Take journal file header. The file holds the header and then a
+ * TAKE_FILE_REC appended for each pass as it ends.
+ */
+#define TAKE_FILE_MAGIC         0x454B4154      /* 'TAKE' little endian */
+#define TAKE_FILE_VERSION       1
+
+/*** TAKE LOG DATA *********************************************************/
+
+typedef struct _TAKE_ENTRY {
+    uint32_t    take;               /* take number, from 1          */
+    int32_t     start;              /* tape position record went on */
+    int32_t     end;                /* tape position record went off */
+    uint32_t    tracks;             /* tracks armed, bit per track  */
+    uint32_t    length;             /* ms in record                 */
+    DATETIME    time;               /* RTC time record went on      */
+    uint8_t     flags;              /* TAKE_F_xxx flags             */
+} TAKE_ENTRY;
+
+typedef struct _TAKE_FILE_HDR {
+    uint32_t    magic;              /* TAKE_FILE_MAGIC              */
+    uint32_t    version;            /* TAKE_FILE_VERSION            */
+    uint32_t    reserved[2];
+} TAKE_FILE_HDR;
+
+typedef struct _TAKE_FILE_REC {
+    TAKE_ENTRY  take;
+    uint32_t    check;              /* checksum of the take         */
+} TAKE_FILE_REC;
+
+typedef struct _TAKE_LOG {
+    TAKE_ENTRY  entry[TAKE_LOG_MAX];    /* takes by number modulo max */
+    TAKE_ENTRY  pass;                   /* pass in record now       */
+    uint32_t    passTime;               /* ms the pass went in record */
+    bool        recording;              /* a pass is in record      */
+    uint32_t    first;                  /* oldest take held         */
+    uint32_t    next;                   /* number of the next take  */
+} TAKE_LOG;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void TakeLog_init(TAKE_LOG* log);
+
+void TakeLog_begin(TAKE_LOG* log, int32_t ipos, uint32_t tracks, const DATETIME* time,
+                   uint32_t now, uint8_t flags);
+
+const TAKE_ENTRY* TakeLog_end(TAKE_LOG* log, int32_t ipos, uint32_t now);
+
+bool TakeLog_put(TAKE_LOG* log, const TAKE_ENTRY* entry);
+
+const TAKE_ENTRY* TakeLog_get(TAKE_LOG* log, uint32_t take);
+
+const TAKE_ENTRY* TakeLog_at(TAKE_LOG* log, size_t n);
+
+size_t TakeLog_count(TAKE_LOG* log);
+
+const TAKE_ENTRY* TakeLog_find(TAKE_LOG* log, int32_t ipos);
+
+void TakeLog_seal(TAKE_FILE_REC* rec, const TAKE_ENTRY* entry);
+
+bool TakeLog_load(TAKE_LOG* log, const TAKE_FILE_REC* rec);
+
+#endif  /* _TAKELOG_H_ */
@@ -0,0 +1,272 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Integer tape time conversions. The roller wheel measures closely to
+ * 1.592 inches in diameter, giving a circumference of 5.0014 inches. The
+ * time taken to cover a distance of tape is distance/speed, so for an
+ * encoder position the elapsed time in seconds is:
+ *
+ *     seconds = (position * circumference) / (ticks_per_rev * ips)
+ *
+ * With the circumference in micro-inches the numerator and denominator
+ * are both exact integers. All of the conversions below work on the
+ * 64-bit distance in micro-inches and never lose any precision until
+ * the final division to the units asked for.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "TapeTime.h"
+
+/*** Local Constants ***/
+
+#define SECS_DAY            (24UL * 60UL * 60UL)
+
+/* Divisor for the seconds conversion at each tape speed. This is the
+ * encoder ticks per revolution times the speed in micro-inches/second.
+ */
+#define SCALE_15IPS         ((uint64_t)ROLLER_TICKS_PER_REV * 15ULL * 1000000ULL)
+#define SCALE_30IPS         ((uint64_t)ROLLER_TICKS_PER_REV * 30ULL * 1000000ULL)
+
+/* A 29.97 frame lasts 1001/30000 seconds. Both scales divide exactly by
+ * 30000, which keeps the drop frame time code to position product well
+ * inside 64-bits for any hour a TAPETIME can hold.
+ */
+#define DF_RATE             30000ULL
+#define DF_SCALE(scale)     ((scale) / DF_RATE)
+
+/* 29.97 drop frame counting skips frame numbers 0 and 1 at the start of
+ * every minute, except for every tenth minute.
+ */
+#define DF_DROP_FRAMES      2
+#define DF_FRAMES_PER_MIN   ((30 * 60) - DF_DROP_FRAMES)
+#define DF_FRAMES_PER_10MIN ((DF_FRAMES_PER_MIN * 10) + DF_DROP_FRAMES)
+
+/* Conversion mode word bits. The speed and frame rate are kept in a
+ * single word so a task converting a time always sees a matched set
+ * even if the position task changes the configuration at that moment.
+ */
+#define MODE_IPS30          0x0100
+#define MODE_DROP           0x0080
+#define MODE_FPS_MASK       0x007F
+
+/*** Static Data Items ***/
+
+static volatile uint32_t s_mode = MODE_IPS30 | 30;
+static volatile uint32_t s_circumference = ROLLER_CIRCUMFERENCE_UIN;
+
+/*** Static Function Prototypes ***/
+
+static uint64_t MulDiv(uint64_t n, uint64_t m, uint64_t d);
+static uint64_t MulDivCeil(uint64_t n, uint64_t m, uint64_t d);
+static uint64_t FrameCount(uint32_t mode, TAPETIME* tapeTime);
+
+//*****************************************************************************
+// Select the tape speed and frame rate for the conversions.
+//*****************************************************************************
+
+void TapeTime_configure(uint32_t ips, uint32_t fps, bool dropFrame)
+{
+    uint32_t mode = (ips >= 30) ? MODE_IPS30 : 0;
+
+    if (dropFrame)
+        mode |= MODE_DROP | 30;
+    else if ((fps > 0) && (fps <= MODE_FPS_MASK))
+        mode |= fps;
+    else
+        mode |= 30;
+
+    s_mode = mode;
+}
+
+//*****************************************************************************
+// Set the roller circumference in micro-inches used for the conversions.
+// Returns false and leaves the current value if it is out of range.
+//*****************************************************************************
+
+bool TapeTime_setCircumference(uint32_t circumference)
+{
+    if ((circumference < ROLLER_CIRCUMFERENCE_MIN) || (circumference > ROLLER_CIRCUMFERENCE_MAX))
+        return false;
+
+    s_circumference = circumference;
+
+    return true;
+}
+
+uint32_t TapeTime_getCircumference(void)
+{
+    return s_circumference;
+}
+
+//*****************************************************************************
+// Convert absolute encoder position to tape time units.
+//*****************************************************************************
+
+void PositionToTapeTime(int tapePosition, TAPETIME* tapeTime)
+{
+    uint32_t mode = s_mode;
+    uint64_t scale = (mode & MODE_IPS30) ? SCALE_30IPS : SCALE_15IPS;
+    uint64_t dist;
+    uint64_t secs;
+    uint64_t frames;
+    uint64_t rem;
+    uint32_t tens;
+    uint32_t frame;
+
+    /* Distance traveled in micro-inches */
+    if (tapePosition < 0)
+        dist = (uint64_t)(-(int64_t)tapePosition);
+    else
+        dist = (uint64_t)tapePosition;
+
+    dist *= s_circumference;
+
+    if (mode & MODE_DROP)
+    {
+        /* Number of 29.97 frames elapsed (30000/1001 per second) */
+        frames = MulDiv(dist, DF_RATE, scale * 1001);
+
+        /* Add back the frame numbers skipped by drop frame counting */
+        rem = frames % DF_FRAMES_PER_10MIN;
+
+        frames += (DF_DROP_FRAMES * 9) * (frames / DF_FRAMES_PER_10MIN);
+
+        if (rem > DF_DROP_FRAMES)
+            frames += DF_DROP_FRAMES * ((rem - DF_DROP_FRAMES) / DF_FRAMES_PER_MIN);
+
+        secs  = frames / 30;
+        frame = (uint32_t)(frames % 30);
+        tens  = (frame * 10) / 30;
+    }
+    else
+    {
+        secs  = dist / scale;
+        rem   = dist % scale;
+        tens  = (uint32_t)((rem * 10) / scale);
+        frame = (uint32_t)((rem * (mode & MODE_FPS_MASK)) / scale);
+    }
+
+    secs %= SECS_DAY;
+
+    tapeTime->hour  = (uint8_t)(secs / 3600);
+    tapeTime->mins  = (uint8_t)((secs % 3600) / 60);
+    tapeTime->secs  = (uint8_t)(secs % 60);
+    tapeTime->tens  = (uint8_t)tens;
+    tapeTime->frame = (uint8_t)frame;
+    tapeTime->flags = (tapePosition < 0) ? 0 : F_PLUS;
+}
+
+//*****************************************************************************
+// Convert tape time to absolute encoder position units. The position is
+// rounded up so it always converts back to the same tape time.
+//*****************************************************************************
+
+void TapeTimeToPosition(TAPETIME* tapeTime, int* tapePosition)
+{
+    uint32_t mode = s_mode;
+    uint64_t scale = (mode & MODE_IPS30) ? SCALE_30IPS : SCALE_15IPS;
+    uint64_t circ = s_circumference;
+    uint64_t tenths;
+
+    tenths  = (uint64_t)tapeTime->hour * 3600;
+    tenths += (uint64_t)tapeTime->mins * 60;
+    tenths += (uint64_t)tapeTime->secs;
+    tenths *= 10;
+    tenths += (uint64_t)(tapeTime->tens % 10);
+
+    *tapePosition = (int)MulDivCeil(tenths, scale, circ * 10);
+}
+
+//*****************************************************************************
+// Convert an H:MM:SS:FF time code value at the configured frame rate to
+// absolute encoder position units.
+//*****************************************************************************
+
+void TapeFramesToPosition(TAPETIME* tapeTime, int* tapePosition)
+{
+    uint32_t mode = s_mode;
+    uint64_t scale = (mode & MODE_IPS30) ? SCALE_30IPS : SCALE_15IPS;
+    uint64_t circ = s_circumference;
+    uint64_t frames = FrameCount(mode, tapeTime);
+
+    if (mode & MODE_DROP)
+        *tapePosition = (int)MulDivCeil(frames * 1001, DF_SCALE(scale), circ);
+    else
+        *tapePosition = (int)MulDivCeil(frames, scale, circ * (mode & MODE_FPS_MASK));
+}
+
+//*****************************************************************************
+// Convert an H:MM:SS:FF time code value at the configured frame rate to
+// the elapsed time in seconds.
+//*****************************************************************************
+
+double TapeFramesToSeconds(TAPETIME* tapeTime)
+{
+    uint32_t mode = s_mode;
+    uint64_t frames = FrameCount(mode, tapeTime);
+
+    if (mode & MODE_DROP)
+        return ((double)frames * 1001.0) / (double)DF_RATE;
+
+    return (double)frames / (double)(mode & MODE_FPS_MASK);
+}
+
+//*****************************************************************************
+// Return the number of frames elapsed for an H:MM:SS:FF time code value.
+//*****************************************************************************
+
+static uint64_t FrameCount(uint32_t mode, TAPETIME* tapeTime)
+{
+    uint64_t frames;
+    uint64_t mins;
+
+    mins = ((uint64_t)tapeTime->hour * 60) + tapeTime->mins;
+
+    frames  = ((mins * 60) + tapeTime->secs) * (mode & MODE_FPS_MASK);
+    frames += tapeTime->frame;
+
+    /* Remove the frame numbers skipped by drop frame counting */
+    if (mode & MODE_DROP)
+        frames -= DF_DROP_FRAMES * (mins - (mins / 10));
+
+    return frames;
+}
+
+//*****************************************************************************
+// Return (n * m) / d without overflowing the intermediate product as long
+// as (d * m) fits in 64-bits. Every caller above keeps to this for a TAPETIME
+// hour up to 255 and any calibrated circumference:
+//
+//   drop frame position to time   d * m < 2.4e9 * 1001 * 30000 = 7.3e16
+//   tenths to position            d * m < 5.1e6 * 10 * 2.4e9   = 1.3e17
+//   time code to position         d * m < 5.1e6 * 127 * 2.4e9  = 1.6e18
+//   drop frame code to position   d * m < 5.1e6 * 80000        = 4.1e11
+//*****************************************************************************
+
+static uint64_t MulDiv(uint64_t n, uint64_t m, uint64_t d)
+{
+    return ((n / d) * m) + (((n % d) * m) / d);
+}
+
+static uint64_t MulDivCeil(uint64_t n, uint64_t m, uint64_t d)
+{
+    uint64_t q = MulDiv(n, m, d);
+
+    if (((n % d) * m) % d)
+        return q + 1;
+
+    return q;
+}
+
+/* End-Of-File */
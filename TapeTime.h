@@ -0,0 +1,93 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TAPETIME_H_
+#define _TAPETIME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* The Ampex tape roller quadrature encoder wheel has 40 ppr. This gives
+ * either 80 or 160 edges per revolution depending on the quadrature encoder
+ * configuration set by QEIConfig(). Currently we use Cha-A mode which
+ * gives 80 edges per revolution. If Cha-A/B mode is used this must be
+ * set to 160.
+ */
+
+#define ROLLER_TICKS_PER_REV        80
+#define ROLLER_TICKS_PER_REV_F      80.0f
+
+/* This is the diameter of the tape timer roller */
+#define ROLLER_CIRCUMFERENCE_F      5.0014f
+
+/* The same roller circumference in micro-inches so all of the
+ * tape time conversions can be done with integer math. This is the
+ * nominal value, the circumference actually used is calibrated
+ * against SMPTE time code when the SMPTE card is installed.
+ */
+#define ROLLER_CIRCUMFERENCE_UIN    5001400UL
+
+/* Limits on the roller circumference that will be accepted, these are
+ * about 2% either side of the nominal roller size.
+ */
+#define ROLLER_CIRCUMFERENCE_MIN    4900000UL
+#define ROLLER_CIRCUMFERENCE_MAX    5100000UL
+
+/*** TAPE TIME/POSITION DATA ***********************************************/
+
+/* Tape position time as h:m:s form. These values get transmitted
+ * to the 7-segment ATMega88 display processor.
+ */
+typedef struct _TAPETIME {
+    uint8_t     hour;       /* hour (0-1)      */
+    uint8_t     mins;       /* minutes (0-59)  */
+    uint8_t     secs;       /* seconds  (0-59) */
+    uint8_t     tens;       /* tens secs (0-9) */
+    uint8_t     frame;      /* smpte frame#    */
+    uint8_t     flags;	    /* display flags   */
+    uint16_t    align;      /* word alignment  */
+} TAPETIME;
+
+/* TAPETIME.flags */
+#define F_PLUS		0x01	/* 7-seg plus segment, negative if clear */
+#define F_BLINK		0x02	/* blink all seven segment displays      */
+#define F_BLANK		0x80	/* blank the entire display if set       */
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/* Select the tape speed (15 or 30 IPS) and the frame rate used for the
+ * frame numbers. The position task calls this each pass so the speed
+ * select switch is only read in one place.
+ */
+void TapeTime_configure(uint32_t ips, uint32_t fps, bool dropFrame);
+
+/* Set or get the roller circumference in micro-inches. The position task
+ * sets this from the calibrated value in the configuration data.
+ */
+bool TapeTime_setCircumference(uint32_t circumference);
+uint32_t TapeTime_getCircumference(void);
+
+/* Encoder position to H:MM:SS, tenths and frame number */
+void PositionToTapeTime(int tapePosition, TAPETIME* tapeTime);
+
+/* H:MM:SS and tenths to encoder position */
+void TapeTimeToPosition(TAPETIME* tapeTime, int* tapePosition);
+
+/* H:MM:SS:FF time code to encoder position */
+void TapeFramesToPosition(TAPETIME* tapeTime, int* tapePosition);
+
+/* H:MM:SS:FF time code to elapsed seconds */
+double TapeFramesToSeconds(TAPETIME* tapeTime);
+
+#endif  /* _TAPETIME_H_ */
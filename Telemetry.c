@@ -0,0 +1,209 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Position telemetry journal. The telemetry task samples the predicted tape
+ * position, velocity, transport mode and locate state at the configured
+ * period into a RAM ring. The TCP telemetry workers stream the samples to
+ * clients for tuning the locator and looking at servo behavior.
+ *
+ * The telemetry task is the only writer. Like the QEI sample ring, each
+ * reader keeps its own cursor and checks the head again after copying a
+ * sample out in case the writer recycled the slot while it was copying.
+ */
+
+/* XDCtools Header files */
+#include <xdc/std.h>
+#include <xdc/cfg/global.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Error.h>
+#include <xdc/runtime/Timestamp.h>
+
+/* BIOS Header files */
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Event.h>
+
+/* TI-RTOS Driver files */
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/SDSPI.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/UART.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "STC1200.h"
+#include "Board.h"
+#include "Telemetry.h"
+
+/* Static Data Items */
+static volatile uint32_t s_head;
+static volatile STC_TELEMETRY_REC s_ring[TELEMETRY_RING_SIZE];
+
+/* Static Function Prototypes */
+static void TelemetrySample(volatile STC_TELEMETRY_REC* rec);
+
+//*****************************************************************************
+// Telemetry sampling task. The sample period is read from the config each
+// pass so a change takes effect right away. A period of zero stops the
+// sampling.
+//*****************************************************************************
+
+Void TelemetryTaskFxn(UArg arg0, UArg arg1)
+{
+    uint32_t period;
+
+    s_head = 0;
+
+    while (TRUE)
+    {
+        period = g_sys.cfgSTC.telemetryPeriod;
+
+        if (!period)
+        {
+            Task_sleep(TELEMETRY_PERIOD_MAX);
+            continue;
+        }
+
+        Task_sleep(period);
+
+        /* Fill in the slot before advancing the head */
+        TelemetrySample(&s_ring[s_head & TELEMETRY_RING_MASK]);
+
+        s_head++;
+    }
+}
+
+//*****************************************************************************
+// Take one telemetry sample.
+//*****************************************************************************
+
+static void TelemetrySample(volatile STC_TELEMETRY_REC* rec)
+{
+    uint32_t mode;
+    uint8_t flags = 0;
+    MOTION_STATE motion;
+    TRANSPORT_STATE ts;
+
+    rec->timestamp = Timestamp_get32();
+    rec->tapePosition = PositionPredict(&motion);
+
+    TransportState_get(&ts);
+
+    mode = ts.transportMode;
+
+    if (ts.searching)
+        mode |= STC_M_SEARCH;
+    if (ts.autoLoop)
+        mode |= STC_M_LOOP;
+    if (ts.autoPunch)
+        mode |= STC_M_PUNCH;
+    if (ts.sequencing)
+        mode |= STC_M_SEQUENCE;
+    if (ts.punching)
+        mode |= STC_M_PUNCHING;
+
+    if (motion.moving)
+        flags |= STC_TF_MOVING;
+    if (g_sys.slipFlags & SLIP_F_SLIP)
+        flags |= STC_TF_SLIP;
+    if (g_sys.slipFlags & SLIP_F_ERRORS)
+        flags |= STC_TF_QEI_ERROR;
+
+    rec->tapeVelocity   = motion.velocity;
+    rec->transportMode  = (uint16_t)mode;
+    rec->searchProgress = (uint8_t)ts.searchProgress;
+    rec->flags          = flags;
+}
+
+//*****************************************************************************
+// Set the sample period in ms. A period of zero turns sampling off.
+// Returns false if the period is out of range.
+//*****************************************************************************
+
+bool Telemetry_setPeriod(uint32_t period)
+{
+    if (period && ((period < TELEMETRY_PERIOD_MIN) || (period > TELEMETRY_PERIOD_MAX)))
+        return false;
+
+    g_sys.cfgSTC.telemetryPeriod = period;
+
+    return true;
+}
+
+uint32_t Telemetry_getPeriod(void)
+{
+    return g_sys.cfgSTC.telemetryPeriod;
+}
+
+//*****************************************************************************
+// Return the number of samples taken since startup.
+//*****************************************************************************
+
+uint32_t Telemetry_getSequence(void)
+{
+    return s_head;
+}
+
+//*****************************************************************************
+// Attach a reader to the journal. The reader starts with the next sample
+// taken, any samples already in the journal are skipped.
+//*****************************************************************************
+
+void Telemetry_readerInit(TELEMETRY_READER* reader)
+{
+    reader->tail = s_head;
+    reader->lost = 0;
+}
+
+//*****************************************************************************
+// Read up to count samples for a reader and return the number read. If the
+// reader has fallen more than a journal length behind, the samples lost
+// are added to the reader lost count and reading resumes at the oldest
+// sample still valid.
+//*****************************************************************************
+
+size_t Telemetry_read(TELEMETRY_READER* reader, STC_TELEMETRY_REC* rec, size_t count)
+{
+    size_t n = 0;
+    uint32_t lag;
+
+    while (n < count)
+    {
+        lag = s_head - reader->tail;
+
+        if (!lag)
+            break;
+
+        /* Skip ahead if the writer has lapped us */
+        if (lag >= TELEMETRY_RING_SIZE)
+        {
+            reader->lost += lag - (TELEMETRY_RING_SIZE - 1);
+            reader->tail = s_head - (TELEMETRY_RING_SIZE - 1);
+        }
+
+        rec[n] = s_ring[reader->tail & TELEMETRY_RING_MASK];
+
+        /* Make sure the slot wasn't recycled while copying it out */
+        if ((s_head - reader->tail) >= TELEMETRY_RING_SIZE)
+            continue;
+
+        reader->tail++;
+        n++;
+    }
+
+    return n;
+}
+
+/* End-Of-File */
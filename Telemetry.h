@@ -0,0 +1,53 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Number of samples held in the journal. This must be a power of two.
+ * At the fastest 1ms sample period this holds about one second of
+ * samples, which gives each streaming client that long to catch up.
+ */
+#define TELEMETRY_RING_SIZE     1024
+#define TELEMETRY_RING_MASK     (TELEMETRY_RING_SIZE - 1)
+
+/* Sample period limits in ms (clock ticks) */
+#define TELEMETRY_PERIOD        10          /* default 100 samples/sec */
+#define TELEMETRY_PERIOD_MIN    1
+#define TELEMETRY_PERIOD_MAX    1000
+
+/* Streaming clients are sent a packet at this interval in ms with up to
+ * the number of samples given in each packet.
+ */
+#define TELEMETRY_SEND_PERIOD   20
+#define TELEMETRY_PACKET_RECS   64
+
+/* Each streaming client keeps its own journal read cursor */
+typedef struct _TELEMETRY_READER {
+    uint32_t    tail;           /* sequence number of next sample  */
+    uint32_t    lost;           /* samples lost to the journal     */
+} TELEMETRY_READER;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+Void TelemetryTaskFxn(UArg arg0, UArg arg1);
+
+bool Telemetry_setPeriod(uint32_t period);
+uint32_t Telemetry_getPeriod(void);
+uint32_t Telemetry_getSequence(void);
+
+void Telemetry_readerInit(TELEMETRY_READER* reader);
+size_t Telemetry_read(TELEMETRY_READER* reader, STC_TELEMETRY_REC* rec, size_t count);
+
+#endif  /* _TELEMETRY_H_ */
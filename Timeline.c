@@ -0,0 +1,217 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Position triggered event timeline. Each event is a tape position and an
+ * action to run as the tape crosses that position. The events are kept in
+ * an array sorted by position, with a cursor that splits the events at or
+ * behind the last tape position from those ahead of it.
+ *
+ * The position task advances the timeline with each encoder sample. Only
+ * the cursor moves, one event at a time, firing each event it steps over.
+ * So an advance costs the events crossed plus a compare, whatever the
+ * number of events held. Moving forward fires the events past the last
+ * position up to and at the new one. Moving backward fires the events at
+ * the last position and back to just past the new one. An event right at
+ * a position the tape stops on fires once going forward and once more if
+ * the tape then backs away from it.
+ *
+ * Adding or removing events keeps the cursor on the same side of each
+ * event, so an edit never fires anything. Seeking places the cursor by a
+ * binary search without firing anything, as needed after the counter is
+ * zeroed. The module has no RTOS dependencies.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "Timeline.h"
+
+/* Static Function Prototypes */
+static size_t UpperBound(TIMELINE* tl, int32_t ipos);
+
+//*****************************************************************************
+// Clear the timeline. The tape position is unknown until the next advance
+// or seek.
+//*****************************************************************************
+
+void Timeline_init(TIMELINE* tl)
+{
+    tl->count  = 0;
+    tl->cursor = 0;
+    tl->last   = 0;
+    tl->valid  = false;
+}
+
+//*****************************************************************************
+// Add an event to the timeline. Events at the same position are kept in
+// the order added and fire in that order going forward. Returns the index
+// of the event added, or TL_NONE if the timeline is full.
+//*****************************************************************************
+
+int Timeline_add(TIMELINE* tl, const TL_ENTRY* entry)
+{
+    size_t i;
+
+    if (tl->count >= TIMELINE_MAX)
+        return TL_NONE;
+
+    i = UpperBound(tl, entry->ipos);
+
+    memmove(&tl->entry[i + 1], &tl->entry[i], (tl->count - i) * sizeof(TL_ENTRY));
+
+    tl->entry[i] = *entry;
+    tl->count++;
+
+    /* The event is already behind the tape, keep it behind the cursor */
+    if (tl->valid && (entry->ipos <= tl->last))
+        tl->cursor++;
+
+    return (int)i;
+}
+
+//*****************************************************************************
+// Remove an event from the timeline by index. The events after it move
+// down one index.
+//*****************************************************************************
+
+bool Timeline_remove(TIMELINE* tl, int index)
+{
+    size_t i = (size_t)index;
+
+    if ((index < 0) || (i >= tl->count))
+        return false;
+
+    memmove(&tl->entry[i], &tl->entry[i + 1], (tl->count - i - 1) * sizeof(TL_ENTRY));
+
+    tl->count--;
+
+    if (i < tl->cursor)
+        tl->cursor--;
+
+    return true;
+}
+
+//*****************************************************************************
+// Remove all events. The last tape position is kept.
+//*****************************************************************************
+
+void Timeline_clear(TIMELINE* tl)
+{
+    tl->count  = 0;
+    tl->cursor = 0;
+}
+
+//*****************************************************************************
+// Return an event by index, in tape position order, or NULL if there is
+// no such event.
+//*****************************************************************************
+
+const TL_ENTRY* Timeline_get(TIMELINE* tl, int index)
+{
+    if ((index < 0) || ((size_t)index >= tl->count))
+        return NULL;
+
+    return &tl->entry[index];
+}
+
+//*****************************************************************************
+// Return the number of events in the timeline.
+//*****************************************************************************
+
+size_t Timeline_count(TIMELINE* tl)
+{
+    return tl->count;
+}
+
+//*****************************************************************************
+// Set the tape position without firing any events.
+//*****************************************************************************
+
+void Timeline_seek(TIMELINE* tl, int32_t ipos)
+{
+    tl->cursor = UpperBound(tl, ipos);
+    tl->last   = ipos;
+    tl->valid  = true;
+}
+
+//*****************************************************************************
+// Move to a new tape position, calling fire() for each event crossed in
+// the order the tape crosses them. The first advance after init only sets
+// the position. The fire function must not edit the timeline. Returns the
+// number of events fired.
+//*****************************************************************************
+
+size_t Timeline_advance(TIMELINE* tl, int32_t ipos, TL_FIRE fire, void* arg)
+{
+    TL_ENTRY* entry;
+    size_t fired = 0;
+
+    if (!tl->valid)
+    {
+        Timeline_seek(tl, ipos);
+        return 0;
+    }
+
+    /* Forward over the events past the last position */
+    while ((tl->cursor < tl->count) && (tl->entry[tl->cursor].ipos <= ipos))
+    {
+        entry = &tl->entry[tl->cursor++];
+
+        if (entry->flags & TL_F_FWD)
+        {
+            fire(entry, 1, arg);
+            ++fired;
+        }
+    }
+
+    /* Backward over the events at or behind the last position */
+    while ((tl->cursor > 0) && (tl->entry[tl->cursor - 1].ipos > ipos))
+    {
+        entry = &tl->entry[--tl->cursor];
+
+        if (entry->flags & TL_F_REW)
+        {
+            fire(entry, -1, arg);
+            ++fired;
+        }
+    }
+
+    tl->last = ipos;
+
+    return fired;
+}
+
+/* Index of the first event past the position given */
+static size_t UpperBound(TIMELINE* tl, int32_t ipos)
+{
+    size_t lo = 0;
+    size_t hi = tl->count;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2);
+
+        if (tl->entry[mid].ipos <= ipos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* End-Of-File */
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TIMELINE_H_
+#define _TIMELINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Timeline events held for the reel loaded. Each takes a TL_ENTRY of
+ * 12 bytes, 24K in all. The host tools build with more.
+ */
+#ifndef TIMELINE_MAX
+#define TIMELINE_MAX            2048
+#endif
+
+#if (TIMELINE_MAX > 65535)
+#error "TIMELINE_MAX must fit the 16-bit event index"
+#endif
+
+/* Returned for no event found */
+#define TL_NONE                 (-1)
+
+/* Direction of travel an event fires in. An event with neither flag
+ * set never fires.
+ */
+#define TL_F_FWD                STC_TL_F_FWD
+#define TL_F_REW                STC_TL_F_REW
+
+/*** TIMELINE DATA *********************************************************/
+
+/* The action, argument and parameter are not looked at here. They are
+ * handed back to the caller to run when the event fires.
+ */
+typedef struct _TL_ENTRY {
+    int32_t     ipos;               /* tape position of the event   */
+    uint8_t     action;             /* action to run when crossed   */
+    uint8_t     flags;              /* TL_F_xxx and caller flags    */
+    uint16_t    arg;                /* action argument              */
+    uint32_t    param;              /* action parameter             */
+} TL_ENTRY;
+
+typedef struct _TIMELINE {
+    TL_ENTRY    entry[TIMELINE_MAX];    /* events by tape position  */
+    size_t      count;                  /* events in the timeline   */
+    size_t      cursor;                 /* events at or behind last */
+    int32_t     last;                   /* last tape position seen  */
+    bool        valid;                  /* last position is known   */
+} TIMELINE;
+
+/* Called for each event crossed, dir is 1 forward or -1 backward */
+typedef void (*TL_FIRE)(const TL_ENTRY* entry, int dir, void* arg);
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void Timeline_init(TIMELINE* tl);
+
+int Timeline_add(TIMELINE* tl, const TL_ENTRY* entry);
+
+bool Timeline_remove(TIMELINE* tl, int index);
+
+void Timeline_clear(TIMELINE* tl);
+
+const TL_ENTRY* Timeline_get(TIMELINE* tl, int index);
+
+size_t Timeline_count(TIMELINE* tl);
+
+void Timeline_seek(TIMELINE* tl, int32_t ipos);
+
+size_t Timeline_advance(TIMELINE* tl, int32_t ipos, TL_FIRE fire, void* arg);
+
+#endif  /* _TIMELINE_H_ */
@@ -85,6 +85,12 @@ const TRACK_Params TRACK_defaultParams = {
 
 static Mailbox_Handle s_mailboxTrackControl = NULL;
 
+/* Track modes saved while an auto punch is rehearsed, one bit per track
+ * in the mask for each track switched to input.
+ */
+static uint8_t s_rehearseMode[MAX_TRACKS];
+static uint32_t s_rehearseMask = 0;
+
 //static uint8_t s_seqnum = IPC_MIN_SEQ;
 
 /* Static Function Prototypes */
@@ -186,6 +192,18 @@ Void TrackControllerTask(UArg arg0, UArg arg1)
         case TRACK_RECORD_EXIT:
             Track_RecordExitAll();
             break;
+
+        case TRACK_REHEARSE:
+            Track_RehearseAll((msg.ui32Param == 0) ? false : true);
+            break;
+
+        case TRACK_SET_MODE:
+            /* Upper word is the track, lower byte the monitor mode */
+            if ((msg.ui32Param >> 16) == 0xFFFF)
+                Track_SetModeAll((uint8_t)msg.ui32Param);
+            else
+                Track_SetMode((size_t)(msg.ui32Param >> 16), (uint8_t)msg.ui32Param);
+            break;
         }
     }
 }
@@ -237,6 +255,33 @@ bool TRACK_Manager_recordExit(void)
     return Mailbox_post(s_mailboxTrackControl, &msg, BIOS_NO_WAIT);
 }
 
+bool TRACK_Manager_rehearse(bool enable)
+{
+    TrackCtrlMessage msg;
+
+    if (!s_mailboxTrackControl)
+        return false;
+
+    msg.msgType   = TRACK_REHEARSE;
+    msg.ui32Param = enable ? 1 : 0;
+
+    return Mailbox_post(s_mailboxTrackControl, &msg, BIOS_NO_WAIT);
+}
+
+/* Set the monitor mode of a track, or all tracks for a track of 0xFFFF */
+bool TRACK_Manager_monitor(size_t track, uint8_t mode)
+{
+    TrackCtrlMessage msg;
+
+    if (!s_mailboxTrackControl)
+        return false;
+
+    msg.msgType   = TRACK_SET_MODE;
+    msg.ui32Param = ((uint32_t)(track & 0xFFFF) << 16) | (mode & STC_TRACK_MASK);
+
+    return Mailbox_post(s_mailboxTrackControl, &msg, BIOS_NO_WAIT);
+}
+
 //*****************************************************************************
 // Track Controller Construction/Destruction
 //*****************************************************************************
@@ -248,6 +293,8 @@ TRACK_Handle TRACK_construct(TRACK_Object *obj, UART_Handle uartHandle,
     obj->uartHandle = uartHandle;
     obj->seqnum     = IPC_MIN_SEQ;
 
+    FrameParse_init(&(obj->rxParser), FRAME_IPC, obj->rxFrame, sizeof(obj->rxFrame));
+
     GateMutex_construct(&(obj->gate), NULL);
 
     return (TRACK_Handle)obj;
@@ -323,7 +370,7 @@ int TRACK_Command(TRACK_Handle handle,
     if (rc == IPC_ERR_SUCCESS)
     {
         /* Try to read ack/nak response back */
-        rc = IPC_FrameRx(handle->uartHandle, &rxFCB, reply, &(reply->length));
+        rc = IPC_FrameRx(handle->uartHandle, &(handle->rxParser), &rxFCB, reply, &(reply->length));
 
         if (rc == IPC_ERR_SUCCESS)
         {
@@ -361,6 +408,8 @@ bool Track_SetTapeSpeed(int speed)
     g_sys.tapeSpeed = speed;
     g_sys.cfgSTC.tapeSpeed = speed;
 
+    TransportState_publishMode();
+
     rc = TRACK_Command(g_sys.handleDCS,
                        (DCS_IPCMSG_HDR*)&msg,
                        (DCS_IPCMSG_HDR*)&msg);
@@ -517,6 +566,25 @@ bool Track_SetModeAll(uint8_t mode)
     return true;
 }
 
+bool Track_SetMode(size_t track, uint8_t mode)
+{
+    uint8_t mask;
+
+    if (track >= MAX_TRACKS)
+        return false;
+
+    /* Store the new track mode, flags preserved */
+    mask = g_sys.trackState[track] & ~(STC_TRACK_MASK);
+
+    g_sys.trackState[track] = (mode & STC_TRACK_MASK) | mask;
+
+    Track_ApplyState(track, g_sys.trackState[track]);
+
+    Event_post(g_eventTransport, Event_Id_03);
+
+    return true;
+}
+
 bool Track_MaskAll(uint8_t setmask, uint8_t clearmask)
 {
     size_t i;
@@ -624,4 +692,46 @@ bool Track_RecordExitAll(void)
     return true;
 }
 
+//*****************************************************************************
+// Rehearse an auto punch. On punch-in the ready tracks switch to input
+// monitor as they would going into record, but record is not entered. On
+// punch-out the tracks switched go back to the mode they were in.
+//*****************************************************************************
+
+bool Track_RehearseAll(bool enable)
+{
+    size_t i;
+    uint8_t mask;
+
+    for (i=0; i < MAX_TRACKS; i++)
+    {
+        mask = g_sys.trackState[i] & ~(STC_TRACK_MASK);
+
+        if (enable)
+        {
+            if (!(g_sys.trackState[i] & STC_T_READY) || (s_rehearseMask & (1U << i)))
+                continue;
+
+            s_rehearseMode[i] = g_sys.trackState[i] & STC_TRACK_MASK;
+            s_rehearseMask |= (1U << i);
+
+            g_sys.trackState[i] = STC_TRACK_INPUT | mask;
+        }
+        else if (s_rehearseMask & (1U << i))
+        {
+            g_sys.trackState[i] = s_rehearseMode[i] | mask;
+        }
+    }
+
+    if (!enable)
+        s_rehearseMask = 0;
+
+    /* Update DCS channel switcher states */
+    Track_ApplyAllStates(g_sys.trackState);
+
+    Event_post(g_eventTransport, Event_Id_03);
+
+    return true;
+}
+
 /* End-Of-File */
@@ -27,6 +27,8 @@ typedef struct TRACK_Object {
     UART_Handle             uartHandle;
     GateMutex_Struct        gate;
     uint8_t                 seqnum;
+    FRAME_PARSER            rxParser;
+    uint8_t                 rxFrame[IPC_FRAME_MAX];
 } TRACK_Object;
 
 typedef TRACK_Object *TRACK_Handle;
@@ -38,6 +40,8 @@ typedef enum TrackCtrlMessageType{
     TRACK_STANDBY_TRANSFER,
     TRACK_RECORD_ENTER,
     TRACK_RECORD_EXIT,
+    TRACK_REHEARSE,
+    TRACK_SET_MODE,
 } TrackCtrlMessageType;
 
 typedef struct TrackCtrlMessage{
@@ -51,6 +55,8 @@ bool TRACK_Manager_startup(void);
 bool TRACK_Manager_standby(bool enable);
 bool TRACK_Manager_recordExit(void);
 bool TRACK_Manager_recordStrobe(void);
+bool TRACK_Manager_rehearse(bool enable);
+bool TRACK_Manager_monitor(size_t track, uint8_t mode);
 
 TRACK_Handle TRACK_construct(TRACK_Object *obj, UART_Handle uartHandle,
                              TRACK_Params *params);
@@ -72,11 +78,13 @@ bool Track_SetState(size_t track, uint8_t trackState);
 bool Track_GetState(size_t track, uint8_t* trackStates);
 bool Track_SetAll(uint8_t mode, uint8_t flags);
 bool Track_SetModeAll(uint8_t setmode);
+bool Track_SetMode(size_t track, uint8_t mode);
 bool Track_MaskAll(uint8_t setmask, uint8_t clearmask);
 bool Track_ToggleMaskAll(uint8_t flags);
 
 bool Track_StandbyTransferAll(bool enable);
 bool Track_RecordEnterAll(void);
 bool Track_RecordExitAll(void);
+bool Track_RehearseAll(bool enable);
 
 #endif /* _TRACKCTRL_H_ */
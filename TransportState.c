@@ -0,0 +1,181 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Transport state snapshots. The position task, the IPC notification
+ * handlers and the locator each own part of the transport state in g_sys.
+ * After changing their part they publish it here. Readers such as the TCP
+ * state worker, remote display and CLI take a whole record snapshot with
+ * TransportState_get() instead of reading g_sys field by field.
+ *
+ * The record is published with a sequence lock (see Seqlock.h), so readers
+ * never disable interrupts or block. The publishers are all tasks and are
+ * serialized with each other by disabling the task scheduler for the few
+ * microseconds it takes to update both copies of the record.
+ */
+
+/* XDCtools Header files */
+#include <xdc/std.h>
+#include <xdc/cfg/global.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Error.h>
+
+/* BIOS Header files */
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Event.h>
+
+/* TI-RTOS Driver files */
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/SDSPI.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/UART.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "STC1200.h"
+#include "Board.h"
+#include "Seqlock.h"
+
+/* Static Data Items */
+static SEQLOCK s_lock;
+static volatile TRANSPORT_STATE s_state[2];
+
+/* Static Function Prototypes */
+static void Publish(void (*update)(volatile TRANSPORT_STATE*));
+static void UpdatePosition(volatile TRANSPORT_STATE* p);
+static void UpdateMode(volatile TRANSPORT_STATE* p);
+static void UpdateSearch(volatile TRANSPORT_STATE* p);
+static void UpdateCues(volatile TRANSPORT_STATE* p);
+
+//*****************************************************************************
+// Publish the initial state from g_sys. Called once at startup after g_sys
+// has been initialized and before any tasks run.
+//*****************************************************************************
+
+void TransportState_init(void)
+{
+    Seqlock_init(&s_lock);
+
+    UpdatePosition(&s_state[0]);
+    UpdateMode(&s_state[0]);
+    UpdateSearch(&s_state[0]);
+    UpdateCues(&s_state[0]);
+
+    s_state[1] = s_state[0];
+}
+
+//*****************************************************************************
+// Return a consistent copy of the transport state. This may be called from
+// any task, Swi or Hwi context and never blocks.
+//*****************************************************************************
+
+void TransportState_get(TRANSPORT_STATE* state)
+{
+    uint32_t seq;
+
+    do {
+        seq = Seqlock_readBegin(&s_lock);
+
+        *state = s_state[Seqlock_index(seq)];
+
+    } while (Seqlock_readRetry(&s_lock, seq));
+
+    state->version = Seqlock_version(seq);
+}
+
+//*****************************************************************************
+// Publishers. Each copies the part of g_sys its caller owns into the
+// snapshot record. These may only be called from task context.
+//*****************************************************************************
+
+void TransportState_publishPosition(void)
+{
+    Publish(UpdatePosition);
+}
+
+void TransportState_publishMode(void)
+{
+    Publish(UpdateMode);
+}
+
+void TransportState_publishSearch(void)
+{
+    Publish(UpdateSearch);
+}
+
+void TransportState_publishCues(void)
+{
+    Publish(UpdateCues);
+}
+
+//*****************************************************************************
+// Apply an update to both copies of the record under the sequence lock.
+//*****************************************************************************
+
+static void Publish(void (*update)(volatile TRANSPORT_STATE*))
+{
+    UInt key = Task_disable();
+
+    Seqlock_writeBegin(&s_lock);
+    update(&s_state[0]);
+
+    Seqlock_writeSwap(&s_lock);
+    update(&s_state[1]);
+
+    Task_restore(key);
+}
+
+static void UpdatePosition(volatile TRANSPORT_STATE* p)
+{
+    p->tapePosition     = g_sys.tapePosition;
+    p->tapePositionAbs  = g_sys.tapePositionAbs;
+    p->tapeDirection    = g_sys.tapeDirection;
+    p->tapeTach         = g_sys.tapeTach;
+    p->tapeVelocity     = g_sys.tapeVelocity;
+    p->tapeTimestamp    = g_sys.tapeTimestamp;
+    p->tapeTime         = g_sys.tapeTime;
+    p->timelineEvent    = g_sys.timelineEvent;
+    p->timelineCount    = g_sys.timelineCount;
+}
+
+static void UpdateMode(volatile TRANSPORT_STATE* p)
+{
+    p->transportMode    = g_sys.transportMode;
+    p->tapeSpeed        = g_sys.tapeSpeed;
+    p->ledMaskTransport = g_sys.ledMaskTransport;
+    p->takeLast         = g_sys.takeLast;
+    p->takeRecording    = g_sys.takeRecording;
+}
+
+static void UpdateSearch(volatile TRANSPORT_STATE* p)
+{
+    p->searchProgress   = g_sys.searchProgress;
+    p->searchETA        = g_sys.searchETA;
+    p->searching        = g_sys.searching;
+    p->autoLoop         = g_sys.autoLoop;
+    p->autoPunch        = g_sys.autoPunch;
+    p->sequencing       = g_sys.sequencing;
+    p->punching         = g_sys.punching;
+}
+
+static void UpdateCues(volatile TRANSPORT_STATE* p)
+{
+    size_t i;
+
+    for (i=0; i < MAX_CUE_POINTS; i++)
+        p->cuePoint[i] = g_sys.cuePoint[i];
+}
+
+/* End-Of-File */
@@ -0,0 +1,63 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TRANSPORTSTATE_H_
+#define _TRANSPORTSTATE_H_
+
+/*** TRANSPORT STATE SNAPSHOT **********************************************/
+
+/* Consistent copy of the transport state held in g_sys. The tasks that
+ * own these items publish them after updating g_sys and readers take a
+ * snapshot of the whole record, so all values read are from the same
+ * instant and multi-word items like the tape time are never torn.
+ */
+
+typedef struct _TRANSPORT_STATE {
+    uint32_t    version;                    /* count of state updates     */
+    /* Published by the position task */
+    int32_t     tapePosition;               /* signed relative position   */
+    uint32_t    tapePositionAbs;            /* absolute tape position     */
+    int32_t     tapeDirection;              /* direction 1=fwd, -1=rew    */
+    float       tapeTach;                   /* tape speed from roller     */
+    float       tapeVelocity;               /* filtered tape speed in IPS */
+    uint32_t    tapeTimestamp;              /* time position was sampled  */
+    TAPETIME    tapeTime;                   /* current tape time position */
+    uint16_t    timelineEvent;              /* last timeline event code   */
+    uint16_t    timelineCount;              /* timeline events posted     */
+    /* Published from DTC notifications */
+    uint32_t    transportMode;              /* current transport mode     */
+    uint32_t    tapeSpeed;                  /* tape speed (15 or 30)      */
+    uint32_t    ledMaskTransport;           /* current transport LED mask */
+    uint32_t    takeLast;                   /* newest take logged         */
+    bool        takeRecording;              /* true if a take in record   */
+    /* Published by the locator */
+    int32_t     searchProgress;             /* progress to cue (0-100%)   */
+    uint32_t    searchETA;                  /* ms left to reach the cue   */
+    bool        searching;                  /* true if search in progress */
+    bool        autoLoop;                   /* true if loop mode running  */
+    bool        autoPunch;                  /* auto punch mode active     */
+    bool        sequencing;                 /* true if cue list running   */
+    bool        punching;                   /* true if auto punch running */
+    CUE_POINT   cuePoint[MAX_CUE_POINTS];   /* cue point table            */
+} TRANSPORT_STATE;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void TransportState_init(void);
+void TransportState_get(TRANSPORT_STATE* state);
+
+void TransportState_publishPosition(void);
+void TransportState_publishMode(void);
+void TransportState_publishSearch(void);
+void TransportState_publishCues(void);
+
+#endif  /* _TRANSPORTSTATE_H_ */
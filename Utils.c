@@ -473,6 +473,14 @@ void InitSysDefaults(STC_CONFIG_DATA* p)
     /** SMPE card config */
     p->smpteFPS     = SMPTE_CTL_FPS30;
     p->midiDevID    = MIDI_DEVID_ALL_CALL;  /* respond to any midi dev id   */
+    /** Tape roller calibration */
+    p->rollerCircumference = ROLLER_CIRCUMFERENCE_UIN;
+    p->slipCorrect  = FALSE;                /* only flag roller slip        */
+    /** Position telemetry */
+    p->telemetryPeriod = TELEMETRY_PERIOD;  /* default 100 samples/sec      */
+    /** Locate planner model */
+    p->locateLearn  = TRUE;                 /* learn from each locate       */
+    LocatePlan_initModel(&p->locateModel);
 
     /* Initial track state zero for all channels */
     memset(p->trackState, 0, STC_MAX_TRACKS);
@@ -48,6 +48,8 @@
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/Gate.h>
 #include <xdc/runtime/Memory.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
 
 /* BIOS Header files */
 #include <ti/sysbios/BIOS.h>
@@ -113,6 +115,7 @@ void netOpenHook(void);
 void netIPUpdate(unsigned int IPAddr, unsigned int IfIdx, unsigned int fAdd);
 Void tcpStateHandler(UArg arg0, UArg arg1);
 Void tcpStateWorker(UArg arg0, UArg arg1);
+Void tcpTelemetryWorker(UArg arg0, UArg arg1);
 Void tcpCommandHandler(UArg arg0, UArg arg1);
 Void tcpCommandWorker(UArg arg0, UArg arg1);
 
@@ -153,6 +156,28 @@ static uint16_t HandleRTCTimeDateSet(int fd, STC_COMMAND_RTC_TIMEDATE_SET* cmd);
 static uint16_t HandleMACAddrGet(int fd, STC_COMMAND_MACADDR_GET* cmd);
 static uint16_t HandleSMPTEEncoderCtrl(int fd, STC_COMMAND_SMPTE_ENCODER_CTRL* cmd);
 static uint16_t HandleSMPTETimeSet(int fd, STC_COMMAND_SMPTE_TIME_SET* cmd);
+static uint16_t HandleSeqClear(int fd, STC_COMMAND_SEQ_CLEAR* cmd);
+static uint16_t HandleSeqStepSet(int fd, STC_COMMAND_SEQ_STEP_SET* cmd);
+static uint16_t HandleSeqStepGet(int fd, STC_COMMAND_SEQ_STEP_GET* cmd);
+static uint16_t HandleSeqStart(int fd, STC_COMMAND_SEQ_START* cmd);
+static uint16_t HandleSeqStatusGet(int fd, STC_COMMAND_SEQ_STATUS_GET* cmd);
+static uint16_t HandleCueStoreAdd(int fd, STC_COMMAND_CUESTORE_ADD* cmd);
+static uint16_t HandleCueStoreDelete(int fd, STC_COMMAND_CUESTORE_DELETE* cmd);
+static uint16_t HandleCueStoreGet(int fd, STC_COMMAND_CUESTORE_GET* cmd);
+static uint16_t HandleCueStoreSet(int fd, STC_COMMAND_CUESTORE_SET* cmd);
+static uint16_t HandleCueStoreFind(int fd, STC_COMMAND_CUESTORE_FIND* cmd);
+static uint16_t HandleCueStoreList(int fd, STC_COMMAND_CUESTORE_LIST* cmd);
+static uint16_t HandleCueStoreRecall(int fd, STC_COMMAND_CUESTORE_RECALL* cmd);
+static uint16_t HandleCueStoreFile(int fd, STC_COMMAND_CUESTORE_FILE* cmd);
+static uint16_t HandleAutoPunchStart(int fd, STC_COMMAND_AUTO_PUNCH_START* cmd);
+static uint16_t HandleTimelineAdd(int fd, STC_COMMAND_TIMELINE_ADD* cmd);
+static uint16_t HandleTimelineDelete(int fd, STC_COMMAND_TIMELINE_DELETE* cmd);
+static uint16_t HandleTimelineGet(int fd, STC_COMMAND_TIMELINE_GET* cmd);
+static uint16_t HandleTakeList(int fd, STC_COMMAND_TAKE_LIST* cmd);
+static uint16_t HandleTakeGet(int fd, STC_COMMAND_TAKE_GET* cmd);
+static uint16_t HandleTakeLocate(int fd, STC_COMMAND_TAKE_LOCATE* cmd);
+static uint16_t HandleTakeClear(int fd, STC_COMMAND_TAKE_CLEAR* cmd);
+static void TakeInfo(STC_TAKE_INFO* info, const TAKE_ENTRY* entry);
 
 /* External Function Prototypes */
 extern void NtIPN2Str(uint32_t IPAddr, char *str);
@@ -243,6 +268,7 @@ void netOpenHook(void)
     taskParams.stackSize = TCPHANDLERSTACK;
     taskParams.priority  = 1;
     taskParams.arg0      = STC_PORT_STATE;
+    taskParams.arg1      = (UArg)tcpStateWorker;
 
     taskHandle = Task_create((Task_FuncPtr)tcpStateHandler, &taskParams, &eb);
 
@@ -252,6 +278,26 @@ void netOpenHook(void)
         System_flush();
     }
 
+    /* Create the task that listens for incoming TCP connections
+     * to stream position telemetry. This uses the same listener
+     * as the state port with the telemetry worker in arg1.
+     */
+
+    Task_Params_init(&taskParams);
+
+    taskParams.stackSize = TCPHANDLERSTACK;
+    taskParams.priority  = 1;
+    taskParams.arg0      = STC_PORT_TELEMETRY;
+    taskParams.arg1      = (UArg)tcpTelemetryWorker;
+
+    taskHandle = Task_create((Task_FuncPtr)tcpStateHandler, &taskParams, &eb);
+
+    if (taskHandle == NULL)
+    {
+        System_printf("netOpenHook: Failed to create telemetry handler Task\n");
+        System_flush();
+    }
+
     /* Create the Task that listens for incoming TCP connections
      * to handle command/response requests. The parameter arg0 will
      * be the port that this task listens on.
@@ -289,7 +335,8 @@ void netIPUpdate(unsigned int IPAddr, unsigned int IfIdx, unsigned int fAdd)
 }
 
 //*****************************************************************************
-// LISTENER CREATES TRANSPORT STATE STREAMING WORKER TASK FOR NEW CONNECTIONS.
+// LISTENER CREATES STREAMING WORKER TASK FOR NEW CONNECTIONS. THE PORT TO
+// LISTEN ON IS IN ARG0 AND THE WORKER TASK FUNCTION TO START IS IN ARG1.
 //*****************************************************************************
 
 Void tcpStateHandler(UArg arg0, UArg arg1)
@@ -362,7 +409,7 @@ Void tcpStateHandler(UArg arg0, UArg arg1)
         taskParams.stackSize = 1280;
         taskParams.priority  = 5;
 
-        taskHandle = Task_create((Task_FuncPtr)tcpStateWorker, &taskParams, &eb);
+        taskHandle = Task_create((Task_FuncPtr)arg1, &taskParams, &eb);
 
         if (taskHandle == NULL)
         {
@@ -446,6 +493,9 @@ Void tcpStateWorker(UArg arg0, UArg arg1)
     int     bytesToSend;
     size_t  i;
     bool    connected = true;
+    int32_t tapePosition;
+    POSITION_STATE pos;
+    TRANSPORT_STATE ts;
     STC_STATE_MSG stateMsg;
 
     System_printf("tcpStateWorker: CONNECT clientfd = 0x%x\n", clientfd);
@@ -472,30 +522,45 @@ Void tcpStateWorker(UArg arg0, UArg arg1)
          */
         UInt events = Event_pend(g_eventTransport, Event_Id_NONE, EVENT_MASK, 2500);
 
+        /* Take a consistent copy of the transport state */
+        TransportState_get(&ts);
+
+        /* The velocity, tach and direction sent all come from one motion
+         * estimate and the encoder sample it was made from. The position
+         * is that estimate carried forward to now.
+         */
+        tapePosition = PositionPredictState(&pos);
+
         /* Get the tape time member values */
-        PositionToTapeTime(g_sys.tapePosition, &stateMsg.tapeTime);
+        PositionToTapeTime(tapePosition, &stateMsg.tapeTime);
 
-        uint32_t transportMode = g_sys.transportMode;
+        uint32_t transportMode = ts.transportMode;
 
         /* Test for search mode active */
-        if (g_sys.searching)
+        if (ts.searching)
             transportMode |= STC_M_SEARCH;
         /* Test for loop mode active */
-        if (g_sys.autoLoop)
+        if (ts.autoLoop)
             transportMode |= STC_M_LOOP;
         /* Test for auto-punch mode */
-        if (g_sys.autoPunch)
+        if (ts.autoPunch)
             transportMode |= STC_M_PUNCH;
+        /* Test for cue list sequence running */
+        if (ts.sequencing)
+            transportMode |= STC_M_SEQUENCE;
+        /* Test for auto punch pass running */
+        if (ts.punching)
+            transportMode |= STC_M_PUNCHING;
 
         int8_t tapedir = 0;
 
-        if (g_sys.tapeTach > 0.0f)
-            tapedir = (g_sys.tapeDirection > 0) ?  1 : -1;
+        if (pos.motion.moving)
+            tapedir = (pos.direction > 0) ?  1 : -1;
 
-        uint32_t maskTransport = g_sys.ledMaskTransport;
+        uint32_t maskTransport = ts.ledMaskTransport;
 
         /* Simulate tape lifter button LED active flag */
-        if (g_sys.transportMode & M_LIFTER)
+        if (ts.transportMode & M_LIFTER)
             maskTransport |= STC_L_LDEF;
 
         /* Determine hardware status bit flags */
@@ -515,19 +580,24 @@ Void tcpStateWorker(UArg arg0, UArg arg1)
         stateMsg.errorCount         = g_sys.qei_error_cnt;
         stateMsg.ledMaskButton      = g_sys.ledMaskRemote;
         stateMsg.ledMaskTransport   = maskTransport;
-        stateMsg.tapePosition       = g_sys.tapePosition;
-        stateMsg.tapeVelocity       = (uint32_t)g_sys.tapeTach;
+        stateMsg.tapePosition       = tapePosition;
+        stateMsg.tapeVelocity       = (uint32_t)pos.tach;
+        stateMsg.tapeVelocityIPS    = pos.motion.velocity;
         stateMsg.transportMode      = (uint16_t)transportMode;
         stateMsg.tapeDirection      = tapedir;
-        stateMsg.tapeSpeed          = (uint8_t)g_sys.tapeSpeed;
+        stateMsg.tapeSpeed          = (uint8_t)ts.tapeSpeed;
         stateMsg.tapeSize           = (uint8_t)2;
-        stateMsg.searchProgress     = (uint8_t)g_sys.searchProgress;
-        stateMsg.searching          = g_sys.searching;
+        stateMsg.searchProgress     = (uint8_t)ts.searchProgress;
+        stateMsg.searching          = ts.searching;
         stateMsg.monitorFlags       = (uint8_t)g_sys.standbyMonitor;
         stateMsg.trackCount         = (uint8_t)g_sys.trackCount;
         stateMsg.hardwareFlags      = hardwareFlags;
         stateMsg.smpteMode          = (uint8_t)g_sys.smpteMode;
         stateMsg.smpteFPS           = (uint8_t)g_sys.cfgSTC.smpteFPS;
+        stateMsg.timelineEvent      = ts.timelineEvent;
+        stateMsg.timelineCount      = ts.timelineCount;
+        stateMsg.takeLast           = ts.takeLast;
+        stateMsg.takeRecording      = (uint8_t)ts.takeRecording;
 
         stateMsg.dateTime.date      = g_sys.timeDate.date;
         stateMsg.dateTime.hour      = g_sys.timeDate.hour;
@@ -537,7 +607,6 @@ Void tcpStateWorker(UArg arg0, UArg arg1)
         stateMsg.dateTime.weekday   = g_sys.timeDate.weekday;
         stateMsg.dateTime.year      = g_sys.timeDate.year;
 
-        memcpy(&stateMsg.tapeTime, &g_sys.tapeTime, sizeof(TAPETIME));
         memcpy(&stateMsg.smpteTime, &g_sys.smpteTime, sizeof(TAPETIME));
 
         /* Zero out the reserved space bytes */
@@ -549,7 +618,7 @@ Void tcpStateWorker(UArg arg0, UArg arg1)
 
         /* Copy the cue memory status bits */
         for (i=0; i < STC_MAX_CUE_POINTS; i++)
-            stateMsg.cueState[i] = (uint8_t)g_sys.cuePoint[i].flags;
+            stateMsg.cueState[i] = (uint8_t)ts.cuePoint[i].flags;
 
         /* Send state message buffer to all clients */
 
@@ -583,6 +652,80 @@ Void tcpStateWorker(UArg arg0, UArg arg1)
     close(clientfd);
 }
 
+//*****************************************************************************
+// STREAMS POSITION TELEMETRY SAMPLES TO CLIENT. EACH CLIENT READS THE
+// TELEMETRY JOURNAL WITH ITS OWN CURSOR STARTING WHEN IT CONNECTS.
+//*****************************************************************************
+
+typedef struct _TELEMETRY_PACKET {
+    STC_TELEMETRY_HDR   hdr;
+    STC_TELEMETRY_REC   rec[TELEMETRY_PACKET_RECS];
+} TELEMETRY_PACKET;
+
+Void tcpTelemetryWorker(UArg arg0, UArg arg1)
+{
+    int     clientfd = (int)arg0;
+    int     bytesToSend;
+    size_t  count;
+    uint32_t idle = 0;
+    Types_FreqHz freq;
+    Error_Block eb;
+    TELEMETRY_READER reader;
+    TELEMETRY_PACKET* packet;
+
+    System_printf("tcpTelemetryWorker: CONNECT clientfd = 0x%x\n", clientfd);
+    System_flush();
+
+    Error_init(&eb);
+
+    packet = (TELEMETRY_PACKET*)Memory_alloc(NULL, sizeof(TELEMETRY_PACKET), 0, &eb);
+
+    if (packet == NULL)
+    {
+        close(clientfd);
+        return;
+    }
+
+    Timestamp_getFreq(&freq);
+
+    Telemetry_readerInit(&reader);
+
+    while (TRUE)
+    {
+        Task_sleep(TELEMETRY_SEND_PERIOD);
+
+        count = Telemetry_read(&reader, packet->rec, TELEMETRY_PACKET_RECS);
+
+        /* Send an empty packet once a second while idle so
+         * we find out if the client has gone away.
+         */
+        if (!count && (++idle < (1000 / TELEMETRY_SEND_PERIOD)))
+            continue;
+
+        idle = 0;
+
+        packet->hdr.magic               = STC_TELEMETRY_MAGIC;
+        packet->hdr.length              = sizeof(STC_TELEMETRY_HDR);
+        packet->hdr.count               = (uint16_t)count;
+        packet->hdr.lost                = reader.lost;
+        packet->hdr.timestampFreq       = freq.lo;
+        packet->hdr.rollerCircumference = TapeTime_getCircumference();
+        packet->hdr.sequence            = reader.tail - count;
+
+        bytesToSend = sizeof(STC_TELEMETRY_HDR) + (count * sizeof(STC_TELEMETRY_REC));
+
+        if (WriteData(clientfd, packet, bytesToSend, 0) <= 0)
+            break;
+    }
+
+    System_printf("tcpTelemetryWorker DISCONNECT clientfd = 0x%x\n", clientfd);
+    System_flush();
+
+    Memory_free(NULL, packet, sizeof(TELEMETRY_PACKET));
+
+    close(clientfd);
+}
+
 //*****************************************************************************
 // LISTENER CREATES COMMAND/RESPONSE WORKER TASK FOR NEW CONNECTIONS.
 //*****************************************************************************
@@ -911,6 +1054,92 @@ Void tcpCommandWorker(UArg arg0, UArg arg1)
             notify = true;
             break;
 
+        case STC_CMD_SEQ_CLEAR:
+            status = HandleSeqClear(clientfd, (STC_COMMAND_SEQ_CLEAR*)buf);
+            break;
+
+        case STC_CMD_SEQ_STEP_SET:
+            status = HandleSeqStepSet(clientfd, (STC_COMMAND_SEQ_STEP_SET*)buf);
+            break;
+
+        case STC_CMD_SEQ_STEP_GET:
+            status = HandleSeqStepGet(clientfd, (STC_COMMAND_SEQ_STEP_GET*)buf);
+            break;
+
+        case STC_CMD_SEQ_START:
+            status = HandleSeqStart(clientfd, (STC_COMMAND_SEQ_START*)buf);
+            notify = true;
+            break;
+
+        case STC_CMD_SEQ_STATUS_GET:
+            status = HandleSeqStatusGet(clientfd, (STC_COMMAND_SEQ_STATUS_GET*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_ADD:
+            status = HandleCueStoreAdd(clientfd, (STC_COMMAND_CUESTORE_ADD*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_DELETE:
+            status = HandleCueStoreDelete(clientfd, (STC_COMMAND_CUESTORE_DELETE*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_GET:
+            status = HandleCueStoreGet(clientfd, (STC_COMMAND_CUESTORE_GET*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_SET:
+            status = HandleCueStoreSet(clientfd, (STC_COMMAND_CUESTORE_SET*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_FIND:
+            status = HandleCueStoreFind(clientfd, (STC_COMMAND_CUESTORE_FIND*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_LIST:
+            status = HandleCueStoreList(clientfd, (STC_COMMAND_CUESTORE_LIST*)buf);
+            break;
+
+        case STC_CMD_CUESTORE_RECALL:
+            status = HandleCueStoreRecall(clientfd, (STC_COMMAND_CUESTORE_RECALL*)buf);
+            notify = true;
+            break;
+
+        case STC_CMD_CUESTORE_FILE:
+            status = HandleCueStoreFile(clientfd, (STC_COMMAND_CUESTORE_FILE*)buf);
+            break;
+
+        case STC_CMD_AUTO_PUNCH_START:
+            status = HandleAutoPunchStart(clientfd, (STC_COMMAND_AUTO_PUNCH_START*)buf);
+            break;
+
+        case STC_CMD_TIMELINE_ADD:
+            status = HandleTimelineAdd(clientfd, (STC_COMMAND_TIMELINE_ADD*)buf);
+            break;
+
+        case STC_CMD_TIMELINE_DELETE:
+            status = HandleTimelineDelete(clientfd, (STC_COMMAND_TIMELINE_DELETE*)buf);
+            break;
+
+        case STC_CMD_TIMELINE_GET:
+            status = HandleTimelineGet(clientfd, (STC_COMMAND_TIMELINE_GET*)buf);
+            break;
+
+        case STC_CMD_TAKE_LIST:
+            status = HandleTakeList(clientfd, (STC_COMMAND_TAKE_LIST*)buf);
+            break;
+
+        case STC_CMD_TAKE_GET:
+            status = HandleTakeGet(clientfd, (STC_COMMAND_TAKE_GET*)buf);
+            break;
+
+        case STC_CMD_TAKE_LOCATE:
+            status = HandleTakeLocate(clientfd, (STC_COMMAND_TAKE_LOCATE*)buf);
+            break;
+
+        case STC_CMD_TAKE_CLEAR:
+            status = HandleTakeClear(clientfd, (STC_COMMAND_TAKE_CLEAR*)buf);
+            break;
+
         default:
             break;
         }
@@ -1389,8 +1618,14 @@ uint16_t HandleAutoPunchSet(int fd, STC_COMMAND_AUTO_PUNCH_SET* cmd)
         SetButtonLedMask(0, STC_L_AUTO_PUNCH);
 
         g_sys.autoPunch = FALSE;
+
+        /* Disarming stops any auto punch running */
+        if (IsLocatorPunching())
+            LocateCancel();
     }
 
+    TransportState_publishSearch();
+
     /* Reply Header Data */
     cmd->hdr.length = sizeof(STC_COMMAND_AUTO_PUNCH_SET);
     cmd->hdr.index  = 0;
@@ -1741,12 +1976,26 @@ uint16_t HandleMachineConfigGet(int fd, STC_COMMAND_MACHINE_CONFIG_GET* cmd)
 uint16_t HandleMachineConfigSet(int fd, STC_COMMAND_MACHINE_CONFIG_SET* cmd)
 {
     int rc = IPC_ERR_SUCCESS;
+    uint32_t circumference = cmd->stc.rollerCircumference;
 
-    /* Copy STC config data into the STC config buffer */
-    memcpy(&g_sys.cfgSTC, &(cmd->stc), sizeof(STC_CONFIG_DATA));
+    /* A config from a client built for another layout of the config data
+     * or with a roller circumference the tape time conversions won't take
+     * is refused rather than half applied.
+     */
+    if ((cmd->stc.length != sizeof(STC_CONFIG_DATA)) ||
+        (circumference < ROLLER_CIRCUMFERENCE_MIN) ||
+        (circumference > ROLLER_CIRCUMFERENCE_MAX))
+    {
+        rc = 1;
+    }
+    else
+    {
+        /* Copy STC config data into the STC config buffer */
+        memcpy(&g_sys.cfgSTC, &(cmd->stc), sizeof(STC_CONFIG_DATA));
 
-    /* Send the DTC new config data via IPC */
-    rc = IPCToDTC_ConfigSet(g_sys.ipcToDTC, &cmd->dtc);
+        /* Send the DTC new config data via IPC */
+        rc = IPCToDTC_ConfigSet(g_sys.ipcToDTC, &cmd->dtc);
+    }
 
     /* Reply Header Data */
     cmd->hdr.length = sizeof(STC_COMMAND_HDR) + sizeof(STC_COMMAND_ARG);
@@ -1912,4 +2161,622 @@ uint16_t HandleSMPTETimeSet(int fd, STC_COMMAND_SMPTE_TIME_SET* cmd)
     return status;
 }
 
+
+uint16_t HandleSeqClear(int fd, STC_COMMAND_SEQ_CLEAR* cmd)
+{
+    uint16_t status = 0;
+
+    /* The cue list can't be cleared while it's running */
+    if (!SequenceClear())
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_SEQ_CLEAR);
+    cmd->hdr.index  = 0;
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = 0;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleSeqStepSet(int fd, STC_COMMAND_SEQ_STEP_SET* cmd)
+{
+    uint16_t status = 0;
+
+    /* index: cue list step number
+     * param1: step op code, STC_SEQ_xxx
+     * param2: cue point index or time in ms
+     * bitflags: step flags, STC_SEQ_F_xxx
+     */
+    if (!SequenceStepSet((size_t)cmd->hdr.index, cmd->arg.param1.U,
+                         cmd->arg.param2.U, (uint32_t)cmd->arg.bitflags))
+    {
+        status = 0xFFFF;
+    }
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_SEQ_STEP_SET);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = 0;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleSeqStepGet(int fd, STC_COMMAND_SEQ_STEP_GET* cmd)
+{
+    uint16_t status = 0;
+    uint32_t op = STC_SEQ_END;
+    uint32_t param = 0;
+    uint32_t flags = 0;
+
+    /* Steps past the end of the list read back as STC_SEQ_END */
+    if (!SequenceStepGet((size_t)cmd->hdr.index, &op, &param, &flags))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_SEQ_STEP_GET);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = op;
+    cmd->arg.param2.U = param;
+    cmd->arg.bitflags = (uint16_t)flags;
+
+    return status;
+}
+
+
+uint16_t HandleSeqStart(int fd, STC_COMMAND_SEQ_START* cmd)
+{
+    uint16_t status = 0;
+
+    /* Any locate or sequence running is canceled first. The
+     * sequence is stopped with STC_CMD_CANCEL.
+     */
+    if (IsLocating())
+        LocateCancel();
+
+    if (!LocateSequence((size_t)cmd->hdr.index))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_SEQ_START);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = 0;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleSeqStatusGet(int fd, STC_COMMAND_SEQ_STATUS_GET* cmd)
+{
+    size_t step = 0;
+    uint32_t remaining = 0;
+    Bool running;
+
+    running = SequenceStatus(&step, &remaining);
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_SEQ_STATUS_GET);
+    cmd->hdr.index  = (uint16_t)step;
+    cmd->hdr.status = 0;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = running ? 1 : 0;
+    cmd->arg.param2.U = remaining;      /* ms left in a timed step */
+    cmd->arg.bitflags = 0;
+
+    return 0;
+}
+
+uint16_t HandleCueStoreAdd(int fd, STC_COMMAND_CUESTORE_ADD* cmd)
+{
+    int handle;
+    int ipos = cmd->arg.param1.I;
+    uint16_t status = 0;
+
+    /* param1: tape position, or STC_CS_F_HERE for the current position
+     * param2: bank number 0-255
+     * name: cue name, cut short to STC_CUE_NAME_LEN-1 characters
+     */
+    if (cmd->arg.bitflags & STC_CS_F_HERE)
+        ipos = g_sys.tapePosition;
+
+    cmd->name[STC_CUE_NAME_LEN - 1] = '\0';
+
+    handle = CueStoreAdd(cmd->arg.param2.U, ipos, STC_CF_ACTIVE, cmd->name);
+
+    if (handle == CUE_NONE)
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_ADD);
+    cmd->hdr.index  = (handle == CUE_NONE) ? STC_CUE_NONE : (uint16_t)handle;
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.I = ipos;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreDelete(int fd, STC_COMMAND_CUESTORE_DELETE* cmd)
+{
+    size_t count = 0;
+    uint16_t status = 0;
+
+    /* Delete a single cue by handle, or all cues of bank param2 */
+    if (cmd->arg.bitflags & STC_CS_F_BANK)
+        count = CueStoreClearBank(cmd->arg.param2.U);
+    else if (CueStoreDelete((int)cmd->hdr.index))
+        count = 1;
+    else
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_DELETE);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = (uint32_t)count;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreGet(int fd, STC_COMMAND_CUESTORE_GET* cmd)
+{
+    int ipos = 0;
+    uint32_t bank = 0;
+    uint32_t flags = 0;
+    uint16_t status = 0;
+
+    memset(cmd->name, 0, STC_CUE_NAME_LEN);
+
+    if (!CueStoreGet((int)cmd->hdr.index, &ipos, &bank, &flags, cmd->name))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_GET);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.I = ipos;
+    cmd->arg.param2.U = bank;
+    cmd->arg.bitflags = (uint16_t)flags;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreSet(int fd, STC_COMMAND_CUESTORE_SET* cmd)
+{
+    int handle = (int)cmd->hdr.index;
+    int ipos = cmd->arg.param1.I;
+    uint16_t status = 0;
+
+    /* bitflags: STC_CS_F_MOVE to set the position from param1, or the
+     * current position with STC_CS_F_HERE, and STC_CS_F_RENAME to set
+     * the cue name.
+     */
+    if (cmd->arg.bitflags & STC_CS_F_HERE)
+        ipos = g_sys.tapePosition;
+
+    cmd->name[STC_CUE_NAME_LEN - 1] = '\0';
+
+    if (cmd->arg.bitflags & (STC_CS_F_MOVE | STC_CS_F_HERE))
+    {
+        if (!CueStoreMove(handle, ipos))
+            status = 0xFFFF;
+    }
+
+    if (cmd->arg.bitflags & STC_CS_F_RENAME)
+    {
+        if (!CueStoreRename(handle, cmd->name))
+            status = 0xFFFF;
+    }
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_SET);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = 0;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreFind(int fd, STC_COMMAND_CUESTORE_FIND* cmd)
+{
+    int handle;
+    int ipos = cmd->arg.param1.I;
+    uint32_t bank = 0;
+    uint32_t flags = 0;
+    uint16_t status = 0;
+
+    /* index: find mode, STC_CS_FIND_xxx
+     * param1: tape position, or STC_CS_F_HERE for the current position
+     * param2: bank number 0-255
+     * name: cue name for STC_CS_FIND_NAME
+     */
+    if (cmd->arg.bitflags & STC_CS_F_HERE)
+        ipos = g_sys.tapePosition;
+
+    cmd->name[STC_CUE_NAME_LEN - 1] = '\0';
+
+    handle = CueStoreFind(cmd->arg.param2.U, ipos, (uint32_t)cmd->hdr.index, cmd->name);
+
+    memset(cmd->name, 0, STC_CUE_NAME_LEN);
+
+    if ((handle == CUE_NONE) || !CueStoreGet(handle, &ipos, &bank, &flags, cmd->name))
+    {
+        handle = CUE_NONE;
+        ipos   = 0;
+        status = 0xFFFF;
+    }
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_FIND);
+    cmd->hdr.index  = (handle == CUE_NONE) ? STC_CUE_NONE : (uint16_t)handle;
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.I = ipos;
+    cmd->arg.param2.U = bank;
+    cmd->arg.bitflags = (uint16_t)flags;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreList(int fd, STC_COMMAND_CUESTORE_LIST* cmd)
+{
+    int handle;
+    int ipos = 0;
+    uint32_t flags = 0;
+    size_t count = 0;
+    uint16_t status = 0;
+
+    /* param1: cue number within the bank in tape position order
+     * param2: bank number 0-255
+     */
+    handle = CueStoreAt(cmd->arg.param2.U, (size_t)cmd->arg.param1.U, &count);
+
+    memset(cmd->name, 0, STC_CUE_NAME_LEN);
+
+    if ((handle == CUE_NONE) || !CueStoreGet(handle, &ipos, NULL, &flags, cmd->name))
+    {
+        handle = CUE_NONE;
+        status = 0xFFFF;
+    }
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_LIST);
+    cmd->hdr.index  = (handle == CUE_NONE) ? STC_CUE_NONE : (uint16_t)handle;
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.I = ipos;
+    cmd->arg.param2.U = (uint32_t)count;    /* cues in the bank */
+    cmd->arg.bitflags = (uint16_t)flags;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreRecall(int fd, STC_COMMAND_CUESTORE_RECALL* cmd)
+{
+    uint16_t status = 0;
+
+    /* index: cue handle
+     * param1: cue point memory to copy the cue to
+     */
+    if (!CueStoreRecall((int)cmd->hdr.index, (size_t)cmd->arg.param1.U))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_RECALL);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleCueStoreFile(int fd, STC_COMMAND_CUESTORE_FILE* cmd)
+{
+    Bool success = FALSE;
+    uint16_t status = 0;
+
+    /* param1: 0=load, 1=store
+     * name: file name without the extension, empty for the default
+     */
+    cmd->name[STC_CUE_NAME_LEN - 1] = '\0';
+
+    switch(cmd->arg.param1.U)
+    {
+    case 0:
+        success = CueStoreLoad(cmd->name);
+        break;
+
+    case 1:
+        success = CueStoreSave(cmd->name);
+        break;
+
+    default:
+        break;
+    }
+
+    if (!success)
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_CUESTORE_FILE);
+    cmd->hdr.index  = 0;
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleAutoPunchStart(int fd, STC_COMMAND_AUTO_PUNCH_START* cmd)
+{
+    uint16_t status = 0;
+    Bool rehearse;
+
+    /* param1: pre-roll ms, 0 for the default
+     * param2: post-roll ms, 0 for the default
+     * bitflags: STC_PUNCH_F_REHEARSE to switch monitors only
+     */
+    rehearse = (cmd->arg.bitflags & STC_PUNCH_F_REHEARSE) ? TRUE : FALSE;
+
+    /* Any locate or sequence running is canceled first */
+    if (IsLocating())
+        LocateCancel();
+
+    if (!LocatePunch(cmd->arg.param1.U, cmd->arg.param2.U, rehearse))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_AUTO_PUNCH_START);
+    cmd->hdr.index  = 0;
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = 0;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleTimelineAdd(int fd, STC_COMMAND_TIMELINE_ADD* cmd)
+{
+    int index;
+    uint16_t status = 0;
+
+    /* event: tape position, STC_TL_xxx action, STC_TL_F_xxx flags
+     *        and the action argument and parameter
+     */
+    index = TimelineAdd(cmd->event.ipos, cmd->event.action, cmd->event.flags,
+                        cmd->event.arg, cmd->event.param);
+
+    if (index == TL_NONE)
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TIMELINE_ADD);
+    cmd->hdr.index  = (index == TL_NONE) ? STC_TL_ALL : (uint16_t)index;
+    cmd->hdr.status = status;
+
+    return status;
+}
+
+
+uint16_t HandleTimelineDelete(int fd, STC_COMMAND_TIMELINE_DELETE* cmd)
+{
+    size_t count;
+    uint16_t status = 0;
+
+    /* Delete a single event by index, or all for STC_TL_ALL */
+    count = TimelineDelete((int)cmd->hdr.index);
+
+    if (!count && (cmd->hdr.index != STC_TL_ALL))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TIMELINE_DELETE);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = (uint32_t)count;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleTimelineGet(int fd, STC_COMMAND_TIMELINE_GET* cmd)
+{
+    int32_t ipos = 0;
+    uint32_t action = 0;
+    uint32_t flags = 0;
+    uint32_t arg = 0;
+    uint32_t param = 0;
+    size_t count;
+    uint16_t status = 0;
+
+    if (!TimelineGet((int)cmd->hdr.index, &ipos, &action, &flags, &arg, &param, &count))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TIMELINE_GET);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = (uint32_t)count;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    cmd->event.ipos   = ipos;
+    cmd->event.action = (uint8_t)action;
+    cmd->event.flags  = (uint8_t)flags;
+    cmd->event.arg    = (uint16_t)arg;
+    cmd->event.param  = param;
+
+    return status;
+}
+
+
+uint16_t HandleTakeList(int fd, STC_COMMAND_TAKE_LIST* cmd)
+{
+    TAKE_ENTRY entry;
+    size_t count = 0;
+    uint16_t status = 0;
+
+    /* param1: take number back from the newest take, zero for the newest */
+    memset(&entry, 0, sizeof(entry));
+
+    if (!TakeJournalAt((size_t)cmd->arg.param1.U, &entry, &count))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TAKE_LIST);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = entry.take;
+    cmd->arg.param2.U = (uint32_t)count;    /* take numbers held */
+    cmd->arg.bitflags = 0;
+
+    TakeInfo(&cmd->take, &entry);
+
+    return status;
+}
+
+
+uint16_t HandleTakeGet(int fd, STC_COMMAND_TAKE_GET* cmd)
+{
+    Bool found;
+    TAKE_ENTRY entry;
+    size_t count = 0;
+    uint16_t status = 0;
+
+    /* param1: take number, or with STC_TAKE_CMD_FIND a tape position
+     *         to find the newest take recorded over
+     */
+    memset(&entry, 0, sizeof(entry));
+
+    if (cmd->arg.bitflags & STC_TAKE_CMD_FIND)
+        found = TakeJournalFind(cmd->arg.param1.I, &entry, &count);
+    else
+        found = TakeJournalGet(cmd->arg.param1.U, &entry, &count);
+
+    if (!found)
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TAKE_GET);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = entry.take;
+    cmd->arg.param2.U = (uint32_t)count;    /* take numbers held */
+    cmd->arg.bitflags = 0;
+
+    TakeInfo(&cmd->take, &entry);
+
+    return status;
+}
+
+
+uint16_t HandleTakeLocate(int fd, STC_COMMAND_TAKE_LOCATE* cmd)
+{
+    Bool punch;
+    uint16_t status = 0;
+
+    /* param1: take number to locate to the start of
+     * param2: cue flags, STC_CF_AUTO_PLAY or STC_CF_AUTO_REC
+     * bitflags: STC_TAKE_CMD_PUNCH to set the punch points to the take
+     */
+    if (IsLocating())
+        LocateCancel();
+
+    punch = (cmd->arg.bitflags & STC_TAKE_CMD_PUNCH) ? TRUE : FALSE;
+
+    if (!TakeJournalLocate(cmd->arg.param1.U, cmd->arg.param2.U, punch))
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TAKE_LOCATE);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+
+uint16_t HandleTakeClear(int fd, STC_COMMAND_TAKE_CLEAR* cmd)
+{
+    uint16_t status = 0;
+
+    /* The main task clears the take history and the journal */
+    if (!TakeJournalClear())
+        status = 0xFFFF;
+
+    /* Reply Header Data */
+    cmd->hdr.length = sizeof(STC_COMMAND_TAKE_CLEAR);
+    cmd->hdr.status = status;
+
+    /* Reply Message Data */
+    cmd->arg.param1.U = 0;
+    cmd->arg.param2.U = 0;
+    cmd->arg.bitflags = 0;
+
+    return status;
+}
+
+/* Copy a take to the reply take info */
+static void TakeInfo(STC_TAKE_INFO* info, const TAKE_ENTRY* entry)
+{
+    info->take   = entry->take;
+    info->start  = entry->start;
+    info->end    = entry->end;
+    info->tracks = entry->tracks;
+    info->length = entry->length;
+    info->time   = entry->time;
+    info->flags  = entry->flags;
+}
+
 // End-Of-File
@@ -0,0 +1,45 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _IPCSIMFRAME_H_
+#define _IPCSIMFRAME_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The simulator codes frames with the firmware frame builder and parser */
+#include "IPCFrameDefs.h"
+#include "RAMPFrameDefs.h"
+#include "FrameBuild.h"
+#include "FrameParse.h"
+
+/*** IPC SIMULATOR FRAME DATA **********************************************/
+
+/* Same layout as IPC_MSG in IPCServer.h. The STC and the host are both
+ * little endian, so the message text is sent as is.
+ */
+typedef struct _SIM_MSG {
+    uint16_t        type;           /* the IPC message type code   */
+    uint16_t        opcode;         /* application defined op code */
+    union {
+        int32_t     I;
+        uint32_t    U;
+        float       F;
+    } param1;
+    union {
+        int32_t     I;
+        uint32_t    U;
+        float       F;
+    } param2;
+} SIM_MSG;
+
+#endif  /* _IPCSIMFRAME_H_ */
@@ -0,0 +1,333 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Host simulation of the MM-1200 transport under DTC-1200 control. The
+ * tape is wound between two reels whose inertia and lever arm change with
+ * the pack radius, so the acceleration the reel motors can give varies
+ * along the tape as it does on the machine. The DTC reel servo is a
+ * velocity loop limited by the motor torque, with dynamic braking in stop
+ * mode. Commands from the STC take effect after the IPC and servo lag.
+ * The tape drives the STC roller encoder with an optional slip.
+ *
+ * Each simulated machine is varied a little from the nominal constants
+ * by the seed, so the locate planner is run against a transport it has
+ * to learn rather than the one its defaults were set for.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "IPCMessage.h"
+#include "TransportSim.h"
+
+/* Static Function Prototypes */
+static double Inertia(double radius);
+static double Vary(TRANSPORT_SIM* sim, double value, double spread);
+static void Apply(TRANSPORT_SIM* sim, SIM_CMD* cmd);
+
+//*****************************************************************************
+// Set up a simulated machine stopped at pos inches into the tape.
+//*****************************************************************************
+
+void TransportSim_init(TRANSPORT_SIM* sim, uint32_t seed, double pos)
+{
+    /* Spread the seed bits so nearby seeds give different machines */
+    sim->seed = (seed * 2654435761U) ^ 0x5A17C0DEU;
+
+    if (!sim->seed)
+        sim->seed = 1;
+
+    TransportSim_random(sim);
+    TransportSim_random(sim);
+
+    sim->cmdLag    = Vary(sim, SIM_CMD_LAG, 0.10);
+    sim->cmdJitter = SIM_CMD_JITTER;
+    sim->velScale  = Vary(sim, SIM_VEL_SCALE, 0.03);
+    sim->torque    = Vary(sim, SIM_MOTOR_TORQUE, 0.10);
+    sim->slip      = 1.0 - (0.002 * TransportSim_random(sim));
+    sim->playVel   = 30.0;
+
+    sim->time        = 0.0;
+    sim->pos         = pos;
+    sim->vel         = 0.0;
+    sim->target      = 0.0;
+    sim->roller      = pos;
+    sim->mode        = MODE_STOP;
+    sim->modeChanged = true;
+    sim->eot         = false;
+    sim->playTime    = 0.0;
+    sim->recordOn    = 0.0;
+    sim->recordOff   = 0.0;
+    sim->recordTime  = 0.0;
+    sim->playOff     = 0.0;
+    sim->cmdHead     = 0;
+    sim->cmdTail     = 0;
+}
+
+//*****************************************************************************
+// Queue a transport command from the STC. It takes effect once the
+// command lag has passed.
+//*****************************************************************************
+
+void TransportSim_command(TRANSPORT_SIM* sim, uint32_t opcode, uint32_t param1, uint32_t param2)
+{
+    SIM_CMD* cmd;
+    double time;
+
+    /* Drop the command if too many are in flight */
+    if ((sim->cmdTail - sim->cmdHead) >= SIM_MAX_CMDS)
+        return;
+
+    time = sim->time + sim->cmdLag + (sim->cmdJitter * ((2.0 * TransportSim_random(sim)) - 1.0));
+
+    /* Commands are carried out in the order sent */
+    if (sim->cmdTail != sim->cmdHead)
+    {
+        cmd = &sim->cmd[(sim->cmdTail - 1) % SIM_MAX_CMDS];
+
+        if (time < cmd->time)
+            time = cmd->time;
+    }
+
+    cmd = &sim->cmd[sim->cmdTail++ % SIM_MAX_CMDS];
+
+    cmd->time   = time;
+    cmd->opcode = opcode;
+    cmd->param1 = param1;
+    cmd->param2 = param2;
+}
+
+//*****************************************************************************
+// Advance the simulation by one SIM_STEP.
+//*****************************************************************************
+
+void TransportSim_step(TRANSPORT_SIM* sim)
+{
+    double amax;
+    double a;
+    double dv;
+    double v;
+
+    /* Carry out any commands that are due */
+    while ((sim->cmdHead != sim->cmdTail) &&
+           (sim->cmd[sim->cmdHead % SIM_MAX_CMDS].time <= sim->time))
+    {
+        Apply(sim, &sim->cmd[sim->cmdHead++ % SIM_MAX_CMDS]);
+    }
+
+    amax = TransportSim_accel(sim);
+    v = sim->vel;
+
+    switch(sim->mode & MODE_MASK)
+    {
+    case MODE_STOP:
+        /* Torque limited braking plus the dynamic braking */
+        dv = ((SIM_BRAKE_TORQUE * amax) + (SIM_BRAKE_DRAG * fabs(v))) * SIM_STEP;
+        v = (fabs(v) <= dv) ? 0.0 : (v - ((v > 0.0) ? dv : -dv));
+        break;
+
+    case MODE_PLAY:
+        sim->playTime += SIM_STEP;
+        /* fall through */
+    case MODE_FWD:
+    case MODE_REW:
+        /* Velocity loop limited by the motor torque */
+        a = SIM_VEL_GAIN * (sim->target - v);
+
+        if (a > amax)
+            a = amax;
+        else if (a < -amax)
+            a = -amax;
+
+        v += a * SIM_STEP;
+        break;
+
+    case MODE_HALT:
+    default:
+        v = 0.0;
+        break;
+    }
+
+    sim->vel     = v;
+    sim->pos    += v * SIM_STEP;
+    sim->roller += v * SIM_STEP * sim->slip;
+    sim->time   += SIM_STEP;
+
+    /* Halt if the tape runs off either reel */
+    if ((sim->pos <= 0.0) || (sim->pos >= SIM_TAPE_LENGTH))
+    {
+        sim->pos = (sim->pos <= 0.0) ? 0.0 : SIM_TAPE_LENGTH;
+        sim->vel = 0.0;
+
+        if ((sim->mode & MODE_MASK) != MODE_HALT)
+        {
+            sim->mode = MODE_HALT;
+            sim->modeChanged = true;
+            sim->eot = true;
+        }
+    }
+}
+
+//*****************************************************************************
+// Return the roller encoder count.
+//*****************************************************************************
+
+int32_t TransportSim_encoder(TRANSPORT_SIM* sim)
+{
+    return (int32_t)floor((sim->roller / SIM_ROLLER_CIRCUM) * SIM_ROLLER_TICKS);
+}
+
+//*****************************************************************************
+// Return the tape pack radius of the take-up or supply reel in inches.
+//*****************************************************************************
+
+double TransportSim_radius(TRANSPORT_SIM* sim, bool takeup)
+{
+    double len = takeup ? sim->pos : (SIM_TAPE_LENGTH - sim->pos);
+
+    return sqrt((SIM_HUB_RADIUS * SIM_HUB_RADIUS) + ((len * SIM_TAPE_THICKNESS) / M_PI));
+}
+
+//*****************************************************************************
+// Return the DTC reel tach. The DTC averages the turning speed of the two
+// reels, given here as the tape speed that would be at the hub radius, so
+// its ratio to the tape speed changes as the tape winds across.
+//*****************************************************************************
+
+double TransportSim_tach(TRANSPORT_SIM* sim)
+{
+    double rate = (1.0 / TransportSim_radius(sim, true)) + (1.0 / TransportSim_radius(sim, false));
+
+    return 0.5 * fabs(sim->vel) * SIM_HUB_RADIUS * rate;
+}
+
+//*****************************************************************************
+// Return the most acceleration in IPS/sec the reel motors can give the
+// tape at the current pack radii.
+//*****************************************************************************
+
+double TransportSim_accel(TRANSPORT_SIM* sim)
+{
+    double rs = TransportSim_radius(sim, false);
+    double rt = TransportSim_radius(sim, true);
+    double mass;
+
+    /* Inertia of both reels seen at the tape */
+    mass = (Inertia(rs) / (rs * rs)) + (Inertia(rt) / (rt * rt));
+
+    return (sim->torque * ((1.0 / rs) + (1.0 / rt))) / mass;
+}
+
+//*****************************************************************************
+// Return a uniform random number in [0, 1).
+//*****************************************************************************
+
+double TransportSim_random(TRANSPORT_SIM* sim)
+{
+    uint32_t x = sim->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    sim->seed = x;
+
+    return (double)x / 4294967296.0;
+}
+
+//*****************************************************************************
+// Return true once the tape has stopped and no commands are in flight.
+//*****************************************************************************
+
+bool TransportSim_idle(TRANSPORT_SIM* sim)
+{
+    return (sim->vel == 0.0) && (sim->cmdHead == sim->cmdTail);
+}
+
+//*****************************************************************************
+// Carry out a transport command on the reel servo.
+//*****************************************************************************
+
+static void Apply(TRANSPORT_SIM* sim, SIM_CMD* cmd)
+{
+    uint32_t mode = sim->mode;
+    double vel;
+
+    /* The DTC ignores commands once halted at the end of the tape */
+    if ((mode & MODE_MASK) == MODE_HALT)
+        return;
+
+    switch(cmd->opcode)
+    {
+    case OP_MODE_STOP:
+        mode = MODE_STOP;
+        sim->target = 0.0;
+        break;
+
+    case OP_MODE_PLAY:
+        mode = MODE_PLAY | (cmd->param1 & M_RECORD);
+        sim->target = sim->playVel;
+        break;
+
+    case OP_MODE_FWD:
+    case OP_MODE_REW:
+        vel = cmd->param1 ? ((double)cmd->param1 * sim->velScale) : SIM_SHUTTLE_VEL;
+        mode = ((cmd->opcode == OP_MODE_FWD) ? MODE_FWD : MODE_REW) | (cmd->param2 & M_NOSLOW);
+        sim->target = (cmd->opcode == OP_MODE_FWD) ? vel : -vel;
+        break;
+
+    case OP_MODE_FWD_LIB:
+    case OP_MODE_REW_LIB:
+        mode = ((cmd->opcode == OP_MODE_FWD_LIB) ? MODE_FWD : MODE_REW) | M_LIBWIND;
+        sim->target = (cmd->opcode == OP_MODE_FWD_LIB) ? SIM_LIB_VEL : -SIM_LIB_VEL;
+        break;
+
+    default:
+        return;
+    }
+
+    if (mode != sim->mode)
+    {
+        /* Note where on the tape record began and ended */
+        if ((mode & M_RECORD) && !(sim->mode & M_RECORD))
+            sim->recordOn = sim->roller;
+        else if (!(mode & M_RECORD) && (sim->mode & M_RECORD))
+            sim->recordOff = sim->roller;
+
+        if ((mode ^ sim->mode) & M_RECORD)
+            sim->recordTime = sim->time;
+
+        /* Note where on the tape play ended */
+        if (((sim->mode & MODE_MASK) == MODE_PLAY) && ((mode & MODE_MASK) != MODE_PLAY))
+            sim->playOff = sim->roller;
+
+        sim->mode = mode;
+        sim->modeChanged = true;
+    }
+}
+
+/* Reel inertia at the pack radius given */
+static double Inertia(double radius)
+{
+    double h4 = SIM_HUB_RADIUS * SIM_HUB_RADIUS * SIM_HUB_RADIUS * SIM_HUB_RADIUS;
+
+    return SIM_HUB_INERTIA + (SIM_PACK_INERTIA * ((radius * radius * radius * radius) - h4));
+}
+
+/* Vary a machine constant randomly by up to the fraction given */
+static double Vary(TRANSPORT_SIM* sim, double value, double spread)
+{
+    return value * (1.0 + (spread * ((2.0 * TransportSim_random(sim)) - 1.0)));
+}
+
+/* End-Of-File */
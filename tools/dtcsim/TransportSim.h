@@ -0,0 +1,115 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+#ifndef _TRANSPORTSIM_H_
+#define _TRANSPORTSIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** CONSTANTS AND CONFIGURATION *******************************************/
+
+/* Plant integration step in seconds. Encoder edges are timed to this. */
+#define SIM_STEP                0.00025
+
+/* Tape pack. A 14 inch NAB reel holds about 5000 feet of 1.5 mil tape. */
+#define SIM_TAPE_LENGTH         60000.0     /* inches of tape           */
+#define SIM_TAPE_THICKNESS      0.0015      /* inches                   */
+#define SIM_HUB_RADIUS          2.25        /* NAB hub radius, inches   */
+
+/* Reel inertia is a fixed hub and flange part plus the tape pack, which
+ * goes as the fourth power of the pack radius. The units are arbitrary
+ * and only the ratio to the motor torque matters.
+ */
+#define SIM_HUB_INERTIA         1.0
+#define SIM_PACK_INERTIA        0.05
+#define SIM_MOTOR_TORQUE        1000.0
+
+/* DTC reel servo. The velocity loop gain is in 1/sec and the dynamic
+ * braking in stop mode adds SIM_BRAKE_DRAG IPS/sec per IPS of speed to
+ * the torque limited braking.
+ */
+#define SIM_VEL_GAIN            25.0
+#define SIM_BRAKE_TORQUE        0.25
+#define SIM_BRAKE_DRAG          0.8
+
+/* DTC velocity units. A shuttle velocity of zero selects the DTC default
+ * shuttle speed.
+ */
+#define SIM_VEL_SCALE           0.25        /* IPS per DTC velocity unit */
+#define SIM_SHUTTLE_VEL         380.0       /* default shuttle IPS       */
+#define SIM_LIB_VEL             180.0       /* library wind IPS          */
+
+/* Seconds from a command sent to the reel servo acting on it */
+#define SIM_CMD_LAG             0.050
+#define SIM_CMD_JITTER          0.005
+
+/* Roller encoder, 80 ticks per revolution of a 5.0014 inch roller */
+#define SIM_ROLLER_TICKS        80
+#define SIM_ROLLER_CIRCUM       5.0014
+
+/* Maximum commands held in flight through the command lag */
+#define SIM_MAX_CMDS            64
+
+/*** TRANSPORT SIMULATOR DATA **********************************************/
+
+typedef struct _SIM_CMD {
+    double      time;           /* time the command takes effect    */
+    uint32_t    opcode;         /* OP_MODE_xxx                      */
+    uint32_t    param1;         /* velocity for shuttle modes       */
+    uint32_t    param2;         /* mode flags                       */
+} SIM_CMD;
+
+typedef struct _TRANSPORT_SIM {
+    /* Machine parameters, set by TransportSim_init() */
+    double      cmdLag;         /* command lag in seconds           */
+    double      cmdJitter;      /* random spread of the lag         */
+    double      velScale;       /* IPS per DTC velocity unit        */
+    double      torque;         /* reel motor torque                */
+    double      slip;           /* roller travel per tape inch      */
+    double      playVel;        /* play speed in IPS                */
+    /* Transport state */
+    double      time;           /* seconds since start              */
+    double      pos;            /* inches of tape on the take-up    */
+    double      vel;            /* tape velocity, + is forward      */
+    double      target;         /* servo target velocity            */
+    double      roller;         /* roller travel in inches          */
+    uint32_t    mode;           /* MODE_xxx plus M_xxx flags        */
+    bool        modeChanged;    /* mode changed since last polled   */
+    bool        eot;            /* ran off the end of the tape      */
+    double      playTime;       /* seconds spent in play mode       */
+    double      recordOn;       /* roller inches record last began  */
+    double      recordOff;      /* roller inches record last ended  */
+    double      recordTime;     /* time record last began or ended  */
+    double      playOff;        /* roller inches play last ended    */
+    /* Commands in flight */
+    SIM_CMD     cmd[SIM_MAX_CMDS];
+    uint32_t    cmdHead;
+    uint32_t    cmdTail;
+    uint32_t    seed;           /* random number state              */
+} TRANSPORT_SIM;
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+void TransportSim_init(TRANSPORT_SIM* sim, uint32_t seed, double pos);
+void TransportSim_command(TRANSPORT_SIM* sim, uint32_t opcode, uint32_t param1, uint32_t param2);
+void TransportSim_step(TRANSPORT_SIM* sim);
+
+int32_t TransportSim_encoder(TRANSPORT_SIM* sim);
+double TransportSim_radius(TRANSPORT_SIM* sim, bool takeup);
+double TransportSim_tach(TRANSPORT_SIM* sim);
+double TransportSim_accel(TRANSPORT_SIM* sim);
+double TransportSim_random(TRANSPORT_SIM* sim);
+
+bool TransportSim_idle(TRANSPORT_SIM* sim);
+
+#endif  /* _TRANSPORTSIM_H_ */
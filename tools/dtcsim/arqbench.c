@@ -0,0 +1,769 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* IPC link loopback test of the selective repeat ARQ in IPCArq.c. An STC
+ * and a DTC node are joined by a simulated 250 kbaud serial line in each
+ * direction that flips bits at the error rate given. The nodes build
+ * frames with FrameBuild.c, receive them with FrameParse.c and run the
+ * ARQ as the IPC server tasks do, the writer sending ACKs, NAKs and
+ * resends ahead of new frames and the reader delivering frames in order.
+ * Time is simulated, not real, and a reader drops a frame the line goes
+ * quiet in for the UART read timeout, as IPC_FrameRx() does.
+ *
+ * The DTC sends transport notifications in bursts of three, the STC sends
+ * datagrams and transactions the DTC replies to, at random times. Each
+ * error rate is run with the ARQ off, as the server was, and on. It is run
+ * a third time with the ARQ on at the STC only, against a DTC running the
+ * deployed firmware, which sends unsequenced frames and never ACKs. The
+ * messages delivered, lost, delivered twice and out of order are counted,
+ * with the goodput and the latency from posting a message to delivering
+ * it, or to the reply for a transaction. The exit status is 1 if the ARQ
+ * delivers a message twice or out of order, or loses one with no errors
+ * on the line, with both ends running it.
+ *
+ * Usage:
+ *   arqbench [-t seconds] [-s seed] [-b ber] [-l load]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "IPCSimFrame.h"
+#include "IPCArq.h"
+
+/* Line rate, a start, 8 data and a stop bit a byte at 250 kbaud */
+#define BYTE_US                 40
+
+/* Bytes a line can have in flight */
+#define LINE_SIZE               4096
+
+/* Reader UART timeout, a frame stalled this long is dropped */
+#define READ_TIMEOUT_US         10000
+
+/* IPC_Transaction() timeout */
+#define TRANS_TIMEOUT_US        2000000
+
+/* DTC time to answer a transaction */
+#define REPLY_US                300
+
+/* Messages a node can have posted and not yet sent */
+#define QUEUE_SIZE              256
+
+/* Mean message rates per second at load 1 */
+#define RATE_NOTIFY             50.0        /* DTC bursts of three */
+#define RATE_DATAGRAM           50.0
+#define RATE_TRANSACT           100.0
+
+/* Message kinds, in the message type field */
+#define KIND_NOTIFY             1
+#define KIND_DATAGRAM           2
+#define KIND_REQUEST            3
+#define KIND_REPLY              4
+
+/* One direction of the serial line */
+typedef struct _LINE {
+    uint8_t     data[LINE_SIZE];
+    uint64_t    time[LINE_SIZE];    /* us each byte arrives         */
+    uint32_t    head;
+    uint32_t    tail;
+    uint64_t    idle;               /* us the line is next free     */
+    uint32_t    bytes;
+    uint32_t    flips;
+} LINE;
+
+/* A message posted */
+typedef struct _POST {
+    SIM_MSG     msg;
+    IPC_FCB     fcb;
+    uint64_t    ready;              /* us it can be sent            */
+} POST;
+
+/* A message sent and what became of it */
+typedef struct _TRACK {
+    uint64_t    posted;
+    uint64_t    done;               /* us delivered or answered     */
+    uint16_t    count;              /* times delivered              */
+} TRACK;
+
+typedef struct _NODE {
+    const char* name;
+    LINE*       tx;
+    LINE*       rx;
+    IPC_ARQ     arq;
+    bool        arqOn;              /* the node runs the ARQ        */
+    FRAME_PARSER parser;
+    uint8_t     frame[IPC_FRAME_MAX];
+    uint64_t    lastByte;           /* us the last byte was read    */
+    uint8_t     seqnum;             /* sequence number, ARQ off     */
+    POST        queue[QUEUE_SIZE];
+    uint32_t    qhead;
+    uint32_t    qtail;
+    uint32_t    lastNotify;         /* last notification delivered  */
+} NODE;
+
+/* A run of the two nodes */
+typedef struct _RUN {
+    bool        arq;
+    bool        legacy;             /* the DTC never ACKs           */
+    double      ber;
+    uint64_t    end;                /* us messages stop being posted */
+    uint32_t    seed;
+    LINE        down;               /* STC to DTC                   */
+    LINE        up;                 /* DTC to STC                   */
+    NODE        stc;
+    NODE        dtc;
+    TRACK*      track[KIND_REPLY];  /* by kind less one, then id    */
+    uint32_t    posted[KIND_REPLY];
+    uint32_t    max;
+    uint32_t    corrupt;            /* bad messages passing the CRC */
+    uint32_t    misordered;
+    uint32_t    dueErrors;          /* IPCArq_due() said not yet    */
+} RUN;
+
+/* Results of a run */
+typedef struct _RESULT {
+    uint32_t    posted;
+    uint32_t    delivered;
+    uint32_t    lost;
+    uint32_t    twice;
+    uint32_t    failed;             /* transactions not answered in time */
+    double      avg;                /* ms */
+    double      p99;
+    double      max;
+} RESULT;
+
+static const double s_bers[] = { 0.0, 1e-5, 1e-4, 3e-4, 1e-3 };
+
+/* Static Function Prototypes */
+static uint32_t Run(RUN* r, double seconds, double load, bool print);
+static void Tick(RUN* r, NODE* node, uint64_t now);
+static void Send(RUN* r, NODE* node, IPC_FCB* fcb, SIM_MSG* msg, uint64_t now);
+static void Receive(RUN* r, NODE* node, uint64_t now);
+static void Deliver(RUN* r, NODE* node, IPC_FCB* fcb, SIM_MSG* msg, uint64_t now);
+static void Post(RUN* r, NODE* node, int kind, uint8_t acknak, uint32_t id, uint64_t ready);
+static void Tally(RUN* r, int kind, RESULT* res);
+static uint32_t Mark(uint32_t id, int kind);
+static double Exp(uint32_t* seed, double rate);
+static double Uniform(uint32_t* seed);
+static uint32_t Random(uint32_t* seed);
+static int Compare(const void* a, const void* b);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    static RUN run;
+    double seconds = 60.0;
+    double load = 1.0;
+    double ber = -1.0;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    size_t i, n;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:s:b:l:")) != -1)
+    {
+        switch(opt)
+        {
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            ber = atof(optarg);
+            break;
+        case 'l':
+            load = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-s seed] [-b ber] [-l load]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("ipc link: %.0f s at 250 kbaud, load %.1f, seed %u\n", seconds, load, seed);
+    printf("%.0f notify/s in bursts of 3 from the DTC, %.0f datagrams/s and %.0f "
+           "transactions/s from the STC\n\n", RATE_NOTIFY * 3 * load, RATE_DATAGRAM * load,
+           RATE_TRANSACT * load);
+
+    printf("%-7s %-3s %-9s %7s %7s %6s %5s %6s %8s %8s %8s %8s\n", "ber", "arq", "messages",
+           "posted", "lost", "twice", "order", "failed", "avg ms", "p99 ms", "max ms",
+           "msg/s");
+
+    /* The error rates in the table, or the one given */
+    n = (ber >= 0.0) ? 1 : (sizeof(s_bers) / sizeof(s_bers[0]));
+
+    for (i=0; i < n; i++)
+    {
+        run.ber = (ber >= 0.0) ? ber : s_bers[i];
+
+        run.arq  = false;
+        run.seed = seed;
+        Run(&run, seconds, load, true);
+
+        run.arq  = true;
+        run.seed = seed;
+        errors += Run(&run, seconds, load, true);
+
+        run.legacy = true;
+        run.seed   = seed;
+        Run(&run, seconds, load, true);
+        run.legacy = false;
+
+        printf("\n");
+    }
+
+    printf("lost: never delivered or answered, twice: delivered more than once,\n");
+    printf("order: notifications delivered out of order, failed: transactions\n");
+    printf("not answered within 2 s. Latency is post to delivery, or to the\n");
+    printf("reply for a transaction. resent: frames sent again, acks: ACK/NAK\n");
+    printf("frames, held: frames received ahead of a missing one. old: the ARQ\n");
+    printf("on at the STC to DTC firmware that never ACKs\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Run the link for the time given. Returns the check errors. */
+static uint32_t Run(RUN* r, double seconds, double load, bool print)
+{
+    static const char* names[] = { "notify", "datagram", "transact" };
+    RESULT res[3];
+    uint64_t now, last;
+    uint64_t next[3];
+    double rates[3];
+    uint32_t errors = 0;
+    uint32_t id;
+    int k, j;
+
+    r->max = (uint32_t)(seconds * (RATE_NOTIFY * 3 + RATE_DATAGRAM + RATE_TRANSACT) * load * 2)
+             + 1000;
+
+    for (k=0; k < KIND_REPLY; k++)
+    {
+        free(r->track[k]);
+        r->track[k]  = calloc(r->max, sizeof(TRACK));
+        r->posted[k] = 0;
+    }
+
+    memset(&r->down, 0, sizeof(LINE));
+    memset(&r->up, 0, sizeof(LINE));
+    memset(&r->stc, 0, sizeof(NODE));
+    memset(&r->dtc, 0, sizeof(NODE));
+
+    r->corrupt    = 0;
+    r->misordered = 0;
+    r->dueErrors  = 0;
+
+    r->stc.name = "stc";
+    r->stc.arqOn = r->arq;
+    r->stc.tx   = &r->down;
+    r->stc.rx   = &r->up;
+    r->dtc.name = "dtc";
+    r->dtc.arqOn = r->arq && !r->legacy;
+    r->dtc.tx   = &r->up;
+    r->dtc.rx   = &r->down;
+
+    IPCArq_init(&r->stc.arq);
+    IPCArq_init(&r->dtc.arq);
+
+    FrameParse_init(&r->stc.parser, FRAME_IPC, r->stc.frame, sizeof(r->stc.frame));
+    FrameParse_init(&r->dtc.parser, FRAME_IPC, r->dtc.frame, sizeof(r->dtc.frame));
+
+    r->stc.seqnum = IPC_MIN_SEQ;
+    r->dtc.seqnum = IPC_MIN_SEQ;
+
+    rates[0] = RATE_NOTIFY * load;
+    rates[1] = RATE_DATAGRAM * load;
+    rates[2] = RATE_TRANSACT * load;
+
+    for (k=0; k < 3; k++)
+        next[k] = (uint64_t)(Exp(&r->seed, rates[k]) * 1e6);
+
+    r->end = (uint64_t)(seconds * 1e6);
+
+    /* Post for the time given then let the link drain */
+    last = r->end + 10000000;
+
+    for (now=0; now < last; now += BYTE_US)
+    {
+        if (now < r->end)
+        {
+            for (k=0; k < 3; k++)
+            {
+                if (now < next[k])
+                    continue;
+
+                next[k] = now + (uint64_t)(Exp(&r->seed, rates[k]) * 1e6);
+
+                switch(k)
+                {
+                case 0:
+                    for (j=0; j < 3; j++)
+                    {
+                        id = r->posted[KIND_NOTIFY - 1]++;
+                        Post(r, &r->dtc, KIND_NOTIFY, 0, id, now);
+                    }
+                    break;
+
+                case 1:
+                    id = r->posted[KIND_DATAGRAM - 1]++;
+                    Post(r, &r->stc, KIND_DATAGRAM, 0, id, now);
+                    break;
+
+                case 2:
+                    id = r->posted[KIND_REQUEST - 1]++;
+                    Post(r, &r->stc, KIND_REQUEST, 0, id, now);
+                    break;
+                }
+            }
+        }
+
+        Tick(r, &r->stc, now);
+        Tick(r, &r->dtc, now);
+    }
+
+    for (k=0; k < 3; k++)
+        Tally(r, k + 1, &res[k]);
+
+    for (k=0; k < 3; k++)
+    {
+        if (print)
+        {
+            printf("%-7.0e %-3s %-9s %7u %7u %6u %5u %6u %8.2f %8.2f %8.2f %8.1f\n",
+                   r->ber, r->legacy ? "old" : (r->arq ? "on" : "off"), names[k],
+                   res[k].posted, res[k].lost, res[k].twice, (k == 0) ? r->misordered : 0, res[k].failed, res[k].avg,
+                   res[k].p99, res[k].max, res[k].delivered / seconds);
+        }
+
+        if (r->arq && !r->legacy && (res[k].twice || ((r->ber == 0.0) && res[k].lost)))
+            errors++;
+    }
+
+    if (print)
+    {
+        IPC_ARQ_STATS* a = &r->stc.arq.stats;
+        IPC_ARQ_STATS* b = &r->dtc.arq.stats;
+
+        printf("%-7s %-3s line %u+%u bytes, %u bits flipped, %u bad frames passed the CRC",
+               "", "", r->down.bytes, r->up.bytes, r->down.flips + r->up.flips, r->corrupt);
+
+        if (r->arq)
+        {
+            printf("\n%-7s %-3s resent %u (%u timeout, %u nak), given up %u, acks %u, "
+                   "held %u, rto %u", "", "",
+                   a->txResent + b->txResent, a->txTimeouts + b->txTimeouts,
+                   a->txNaks + b->txNaks, a->txFailed + b->txFailed, a->txAcks + b->txAcks,
+                   a->rxHeld + b->rxHeld, r->stc.arq.rto);
+
+            if (r->dtc.arqOn)
+                printf("/%u", r->dtc.arq.rto);
+
+            printf(" ms");
+        }
+
+        printf("\n");
+    }
+
+    if (r->arq && !r->legacy && (r->misordered || r->dueErrors))
+    {
+        printf("%u misordered, %u poll/due mismatches\n", r->misordered, r->dueErrors);
+        errors++;
+    }
+
+    return errors;
+}
+
+/* Run a node for a byte time, reading what has arrived and starting the
+ * next frame if the line is free.
+ */
+static void Tick(RUN* r, NODE* node, uint64_t now)
+{
+    IPC_FCB fcb;
+    SIM_MSG msg;
+    POST* post;
+    uint16_t len;
+    uint32_t ms = (uint32_t)(now / 1000);
+
+    Receive(r, node, now);
+
+    if (node->arqOn)
+    {
+        /* Frames held behind one given up on */
+        while (IPCArq_rxNext(&node->arq, &fcb, &msg, &len, ms))
+        {
+            if (len == sizeof(SIM_MSG))
+                Deliver(r, node, &fcb, &msg, now);
+        }
+    }
+
+    /* The writer blocks until the last frame is out */
+    if (node->tx->idle > now)
+        return;
+
+    if (node->arqOn)
+    {
+        uint32_t due = IPCArq_due(&node->arq, ms);
+
+        /* ACKs, NAKs and resends go ahead of new frames */
+        if (IPCArq_poll(&node->arq, ms, &fcb, &msg, &len))
+        {
+            if (due)
+                r->dueErrors++;
+
+            Send(r, node, &fcb, len ? &msg : NULL, now);
+            return;
+        }
+    }
+
+    if (node->qhead == node->qtail)
+        return;
+
+    post = &node->queue[node->qhead % QUEUE_SIZE];
+
+    if (post->ready > now)
+        return;
+
+    if (node->arqOn)
+    {
+        /* Held back while the window is full */
+        if (!IPCArq_reserve(&node->arq, &post->fcb, &post->msg, sizeof(SIM_MSG)))
+            return;
+
+        IPCArq_sent(&node->arq, post->fcb.seqnum, ms);
+    }
+    else if ((post->fcb.type & IPC_F_DATAGRAM) == 0)
+    {
+        post->fcb.seqnum = node->seqnum;
+        node->seqnum = IPC_INC_SEQ(node->seqnum);
+    }
+
+    Send(r, node, &post->fcb, &post->msg, now);
+
+    node->qhead++;
+}
+
+/* Put a frame on the line, flipping bits at the error rate */
+static void Send(RUN* r, NODE* node, IPC_FCB* fcb, SIM_MSG* msg, uint64_t now)
+{
+    uint8_t frame[IPC_FRAME_MAX];
+    LINE* line = node->tx;
+    uint64_t t;
+    size_t len, i;
+    int bit;
+
+    len = IPC_FrameBuild(frame, fcb, msg, msg ? sizeof(SIM_MSG) : 0);
+
+    t = (line->idle > now) ? line->idle : now;
+
+    for (i=0; i < len; i++)
+    {
+        uint8_t b = frame[i];
+
+        if (r->ber > 0.0)
+        {
+            for (bit=0; bit < 8; bit++)
+            {
+                if (Uniform(&r->seed) < r->ber)
+                {
+                    b ^= (uint8_t)(1 << bit);
+                    line->flips++;
+                }
+            }
+        }
+
+        t += BYTE_US;
+
+        line->data[line->head % LINE_SIZE] = b;
+        line->time[line->head % LINE_SIZE] = t;
+        line->head++;
+    }
+
+    line->idle   = t;
+    line->bytes += (uint32_t)len;
+}
+
+/* Parse the bytes that have arrived and take each frame as the reader
+ * task does.
+ */
+static void Receive(RUN* r, NODE* node, uint64_t now)
+{
+    LINE* line = node->rx;
+    FRAME_STATS* stats = &node->parser.stats;
+    FRAME_RX frame;
+    IPC_FCB fcb;
+    SIM_MSG msg;
+    uint16_t len;
+    uint32_t bad;
+    uint32_t ms = (uint32_t)(now / 1000);
+    size_t used;
+    int rc;
+
+    while ((line->tail != line->head) && (line->time[line->tail % LINE_SIZE] <= now))
+    {
+        uint8_t b = line->data[line->tail % LINE_SIZE];
+
+        line->tail++;
+        node->lastByte = now;
+
+        bad = stats->crc + stats->length;
+
+        if (!FrameParse_feed(&node->parser, &b, 1, &used, &frame))
+        {
+            /* A frame failed, NAK the one expected */
+            if (node->arqOn && (stats->crc + stats->length != bad))
+                IPCArq_rxError(&node->arq);
+
+            continue;
+        }
+
+        do {
+            fcb.type   = frame.type;
+            fcb.seqnum = frame.seqnum;
+            fcb.acknak = frame.acknak;
+            fcb.rsvd   = 0;
+
+            len = frame.textlen;
+
+            if (len == sizeof(SIM_MSG))
+                memcpy(&msg, frame.text, sizeof(SIM_MSG));
+
+            if (!node->arqOn)
+            {
+                if (((fcb.type & IPC_TYPE_MASK) != IPC_ACK_ONLY) &&
+                    ((fcb.type & IPC_TYPE_MASK) != IPC_NAK_ONLY) && (len == sizeof(SIM_MSG)))
+                    Deliver(r, node, &fcb, &msg, now);
+                continue;
+            }
+
+            rc = IPCArq_rxFrame(&node->arq, &fcb, &msg, len, ms);
+
+            if ((rc == IPC_ARQ_DELIVER) && (len == sizeof(SIM_MSG)))
+                Deliver(r, node, &fcb, &msg, now);
+
+            while (IPCArq_rxNext(&node->arq, &fcb, &msg, &len, ms))
+            {
+                if (len == sizeof(SIM_MSG))
+                    Deliver(r, node, &fcb, &msg, now);
+            }
+        } while (FrameParse_next(&node->parser, &frame));
+    }
+
+    /* The UART read times out on a frame cut short */
+    if ((node->parser.state != FRAME_HUNT) && (now - node->lastByte >= READ_TIMEOUT_US))
+    {
+        FrameParse_abort(&node->parser);
+        node->lastByte = now;
+    }
+}
+
+/* The application takes a message */
+static void Deliver(RUN* r, NODE* node, IPC_FCB* fcb, SIM_MSG* msg, uint64_t now)
+{
+    TRACK* t;
+    int kind = msg->type;
+    uint32_t id = msg->param1.U;
+
+    if ((kind < KIND_NOTIFY) || (kind > KIND_REPLY) || (msg->param2.U != Mark(id, kind)) ||
+        (id >= r->posted[(kind == KIND_REPLY) ? (KIND_REQUEST - 1) : (kind - 1)]))
+    {
+        r->corrupt++;
+        return;
+    }
+
+    switch(kind)
+    {
+    case KIND_NOTIFY:
+        t = &r->track[KIND_NOTIFY - 1][id];
+
+        if (t->count == 0)
+        {
+            if (id && (id < node->lastNotify))
+                r->misordered++;
+
+            node->lastNotify = id;
+        }
+        break;
+
+    case KIND_DATAGRAM:
+        t = &r->track[KIND_DATAGRAM - 1][id];
+        break;
+
+    case KIND_REQUEST:
+        /* Answer it as the DTC does, with a MSG+ACK reply */
+        t = &r->track[KIND_REQUEST - 1][id];
+        Post(r, node, KIND_REPLY, fcb->seqnum, id, now + REPLY_US);
+        return;
+
+    default:
+        /* A reply completes the transaction */
+        t = &r->track[KIND_REQUEST - 1][id];
+        break;
+    }
+
+    if (!t->count++)
+        t->done = now;
+}
+
+/* Post a message for a node to send */
+static void Post(RUN* r, NODE* node, int kind, uint8_t acknak, uint32_t id, uint64_t ready)
+{
+    POST* post;
+
+    if ((node->qtail - node->qhead) >= QUEUE_SIZE)
+        return;
+
+    post = &node->queue[node->qtail++ % QUEUE_SIZE];
+
+    post->msg.type     = (uint16_t)kind;
+    post->msg.opcode   = 0;
+    post->msg.param1.U = id;
+    post->msg.param2.U = Mark(id, kind);
+
+    post->fcb.seqnum = IPC_NULL_SEQ;
+    post->fcb.acknak = acknak;
+    post->fcb.rsvd   = 0;
+
+    switch(kind)
+    {
+    case KIND_NOTIFY:
+    case KIND_DATAGRAM:
+        post->fcb.type = IPC_MAKETYPE(IPC_F_DATAGRAM, IPC_MSG_ONLY);
+        break;
+
+    case KIND_REQUEST:
+        post->fcb.type = IPC_MAKETYPE(IPC_F_ACKNAK, IPC_MSG_ONLY);
+        break;
+
+    default:
+        post->fcb.type = IPC_MAKETYPE(IPC_F_ACKNAK, IPC_MSG_ACK);
+        break;
+    }
+
+    post->ready = ready;
+
+    if (kind != KIND_REPLY)
+        r->track[kind - 1][id].posted = ready;
+}
+
+/* Count what became of the messages of a kind */
+static void Tally(RUN* r, int kind, RESULT* res)
+{
+    TRACK* t = r->track[kind - 1];
+    double* lat;
+    uint32_t n = 0;
+    uint32_t i;
+    double sum = 0.0;
+    double ms;
+
+    memset(res, 0, sizeof(RESULT));
+
+    res->posted = r->posted[kind - 1];
+
+    lat = malloc((res->posted + 1) * sizeof(double));
+
+    for (i=0; i < res->posted; i++)
+    {
+        if (!t[i].count)
+        {
+            res->lost++;
+
+            if (kind == KIND_REQUEST)
+                res->failed++;
+
+            continue;
+        }
+
+        if (t[i].count > 1)
+            res->twice++;
+
+        ms = (double)(t[i].done - t[i].posted) / 1000.0;
+
+        if ((kind == KIND_REQUEST) && (t[i].done - t[i].posted > TRANS_TIMEOUT_US))
+            res->failed++;
+
+        res->delivered++;
+
+        lat[n++] = ms;
+        sum += ms;
+    }
+
+    if (n)
+    {
+        qsort(lat, n, sizeof(double), Compare);
+
+        res->avg = sum / n;
+        res->p99 = lat[(size_t)((n - 1) * 0.99)];
+        res->max = lat[n - 1];
+    }
+
+    free(lat);
+}
+
+/* Check word for a message, to spot bad frames that pass the CRC */
+static uint32_t Mark(uint32_t id, int kind)
+{
+    return (id * 2654435761u) ^ ((uint32_t)kind << 28) ^ 0x5A5AA5A5u;
+}
+
+/* Exponential time to the next event at the rate given */
+static double Exp(uint32_t* seed, double rate)
+{
+    double u = Uniform(seed);
+
+    if (u <= 0.0)
+        u = 1e-12;
+
+    return -log1p(-u) / rate;
+}
+
+/* Uniform in [0, 1) */
+static double Uniform(uint32_t* seed)
+{
+    return (double)Random(seed) / 4294967296.0;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+static int Compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+/* End-Of-File */
@@ -0,0 +1,350 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Roller calibration test. Tape is played past a simulated timer roller
+ * in runs of one to three minutes with a locate between each. The SMPTE
+ * time code recorded on the tape is read at every frame, a little late
+ * by the decoder latency, and each frame goes to RollerCal_addPoint() with
+ * the roller encoder count it was read at, as the SMPTE task does.
+ *
+ * The roller's real circumference is off nominal for wear or steady
+ * slip, or drifts through the run. Each locate slips the roller count by
+ * a few ticks, so each run has its own offset. Some cases also drop
+ * time code frames, or play a run in reverse where the reader gives
+ * falling time code.
+ *
+ * The result is taken every ROLLER_CAL_MIN_POINTS frames, as the SMPTE
+ * task takes it. It must be within the limit of the same pooled fit made
+ * from the exact roller angle, which is the real circumference unless it
+ * drifts. A drifting roller is averaged over all the play since the
+ * calibration started, and how far the result lags the roller at the end
+ * is shown. The tape time error an hour from zero is also shown for the
+ * nominal and calibrated circumference. The exit status is 1 if any
+ * result is over the limit.
+ *
+ * Usage:
+ *   calbench [-m minutes] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "TapeTime.h"
+#include "RollerCal.h"
+
+#define FPS                     30.0
+
+/* Time code decoder latency, up to */
+#define DECODE_LATENCY          0.001
+
+/* Roller count slip at each locate, up to ticks either way */
+#define LOCATE_SLIP             8
+
+/* Play runs in seconds */
+#define RUN_MIN                 60.0
+#define RUN_MAX                 180.0
+
+/* A roller and tape case */
+typedef struct _CASE {
+    const char* name;
+    uint32_t    ips;
+    double      circStart;          /* real circumference, inches   */
+    double      circEnd;            /* at the end of the play time  */
+    double      dropRate;           /* time code frames missed      */
+    bool        reverse;            /* a reverse run now and then   */
+    double      errMax;             /* micro-inch limit             */
+} CASE;
+
+/* The pooled fit made from the exact roller angle */
+typedef struct _REF {
+    double      x0, y0;
+    double      sx, sy, sxx, sxy;
+    double      pxx, pxy;
+    uint32_t    n;
+} REF;
+
+static const CASE s_cases[] = {
+    { "nominal 30 IPS",     30, 5.0014, 5.0014, 0.00, false,  50.0 },
+    { "nominal 15 IPS",     15, 5.0014, 5.0014, 0.00, false,  50.0 },
+    { "worn -0.3% 30 IPS",  30, 4.9864, 4.9864, 0.00, false,  50.0 },
+    { "slip +0.5% 15 IPS",  15, 5.0264, 5.0264, 0.00, false,  50.0 },
+    { "dropouts 30 IPS",    30, 4.9950, 4.9950, 0.05, false,  50.0 },
+    { "reverse runs",       30, 5.0100, 5.0100, 0.00, true,   50.0 },
+    { "drift -0.2% 30 IPS", 30, 5.0014, 4.9914, 0.01, false,  50.0 },
+    { "drift +0.2% 15 IPS", 15, 5.0014, 5.0114, 0.01, true,   50.0 },
+};
+
+#define NUM_CASES   (sizeof(s_cases) / sizeof(s_cases[0]))
+
+/* Static Function Prototypes */
+static bool Run(const CASE* c, double minutes, uint32_t* seed);
+static void RefAdd(REF* ref, double ticks, double seconds);
+static void RefEnd(REF* ref);
+static double RefResult(REF* ref, uint32_t ips);
+static double HourError(double circUsed, double circReal, uint32_t ips);
+static double Uniform(uint32_t* seed);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    double minutes = 20.0;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'm':
+            minutes = atof(optarg);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-m minutes] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (minutes < 2.0)
+    {
+        fprintf(stderr, "play time must be at least 2 minutes\n");
+        return 1;
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("roller calibration: %.0f minutes of play, result every %d frames, seed %u\n\n",
+           minutes, ROLLER_CAL_MIN_POINTS, seed);
+
+    printf("%-20s %6s %4s %8s %8s %6s %6s %6s %8s %8s %6s\n", "case", "frames", "runs",
+           "real uin", "cal uin", "err", "max", "lag", "nom fr", "cal fr", "check");
+
+    for (i=0; i < NUM_CASES; i++)
+    {
+        if (!Run(&s_cases[i], minutes, &seed))
+            errors++;
+    }
+
+    printf("\nreal: roller circumference at the end, cal: the last result, both in\n");
+    printf("micro-inches. err: the last result less the exact fit, max: the worst\n");
+    printf("of every result, lag: the last result less real. nom fr, cal fr: time\n");
+    printf("code frames out an hour from zero with the nominal and the calibrated\n");
+    printf("circumference on the roller at the end\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Play one case. Returns false if a result is over the limit. */
+static bool Run(const CASE* c, double minutes, uint32_t* seed)
+{
+    ROLLER_CAL cal;
+    REF ref;
+    double total = minutes * 60.0;
+    double played = 0.0;
+    double tape = 600.0 * c->ips;           /* inches from zero     */
+    double angle = tape / c->circStart;     /* roller revolutions   */
+    double circ = c->circStart;
+    double ips = (double)c->ips;
+    double run, x, jump, err, maxErr = 0.0;
+    double lastCal = 0.0, lastErr = 0.0;
+    uint32_t frames = 0, runs = 0;
+    uint32_t result;
+    int32_t ticks;
+    double dir;
+    bool ok = true;
+
+    RollerCal_init(&cal);
+    memset(&ref, 0, sizeof(REF));
+
+    while (played < total)
+    {
+        run = RUN_MIN + (Uniform(seed) * (RUN_MAX - RUN_MIN));
+
+        if (run > (total - played))
+            run = total - played;
+
+        /* Now and then play backwards, where time code runs down */
+        dir = (c->reverse && !(Random(seed) % 4)) ? -1.0 : 1.0;
+
+        runs++;
+
+        /* Start on a frame edge */
+        tape = floor(tape / c->ips * FPS) * c->ips / FPS;
+
+        for (x=0.0; x < run; x += 1.0 / FPS)
+        {
+            /* Roller wear or slip changes slowly over the play time */
+            circ = c->circStart + ((c->circEnd - c->circStart) * (played + x) / total);
+
+            tape  += dir * ips / FPS;
+            angle += dir * ips / FPS / circ;
+
+            if (Uniform(seed) < c->dropRate)
+                continue;
+
+            /* The frame is read a little after its edge passes */
+            ticks = (int32_t)floor((angle + (dir * ips * Uniform(seed) * DECODE_LATENCY / circ)) *
+                                   ROLLER_TICKS_PER_REV);
+
+            RollerCal_addPoint(&cal, ticks, tape / c->ips);
+
+            /* Reverse reads each end a segment, so only forward counts */
+            if (dir > 0.0)
+            {
+                RefAdd(&ref, angle * ROLLER_TICKS_PER_REV, tape / c->ips);
+                frames++;
+            }
+
+            /* Take the result as often as the SMPTE task does */
+            if ((cal.points + cal.n) % ROLLER_CAL_MIN_POINTS)
+                continue;
+
+            if (!RollerCal_result(&cal, c->ips, &result))
+                continue;
+
+            lastCal = (double)result;
+            lastErr = lastCal - RefResult(&ref, c->ips);
+
+            err = fabs(lastErr);
+
+            if (err > maxErr)
+                maxErr = err;
+        }
+
+        played += run;
+
+        /* Locate somewhere else, the roller count slips a little */
+        RollerCal_segmentEnd(&cal);
+        RefEnd(&ref);
+
+        jump = (Uniform(seed) - 0.5) * 1200.0 * c->ips;
+
+        if ((tape + jump) < 0.0)
+            jump = -jump;
+
+        tape  += jump;
+        angle += jump / circ;
+        angle += (double)((int32_t)(Random(seed) % (LOCATE_SLIP * 2 + 1)) - LOCATE_SLIP) /
+                 ROLLER_TICKS_PER_REV;
+    }
+
+    circ *= 1.0e6;
+
+    if ((lastCal == 0.0) || (maxErr > c->errMax))
+        ok = false;
+
+    printf("%-20s %6u %4u %8.0f %8.0f %6.1f %6.1f %6.0f %8.2f %8.2f %6s\n", c->name, frames, runs,
+           circ, lastCal, lastErr, maxErr, lastCal - circ,
+           HourError(ROLLER_CIRCUMFERENCE_UIN, circ, c->ips), HourError(lastCal, circ, c->ips),
+           ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+/* Add a point to the exact fit, ticks being the roller angle unrounded */
+static void RefAdd(REF* ref, double ticks, double seconds)
+{
+    double dx, dy;
+
+    if (!ref->n)
+    {
+        ref->x0 = ticks;
+        ref->y0 = seconds;
+        ref->sx = ref->sy = ref->sxx = ref->sxy = 0.0;
+    }
+
+    dx = ticks - ref->x0;
+    dy = seconds - ref->y0;
+
+    ref->sx  += dx;
+    ref->sy  += dy;
+    ref->sxx += dx * dx;
+    ref->sxy += dx * dy;
+    ref->n++;
+}
+
+/* End a run in the exact fit */
+static void RefEnd(REF* ref)
+{
+    double n = (double)ref->n;
+
+    if (ref->n > 1)
+    {
+        ref->pxx += ref->sxx - ((ref->sx * ref->sx) / n);
+        ref->pxy += ref->sxy - ((ref->sx * ref->sy) / n);
+    }
+
+    ref->n = 0;
+}
+
+/* Circumference in micro-inches from the exact fit so far */
+static double RefResult(REF* ref, uint32_t ips)
+{
+    double n = (double)ref->n;
+    double pxx = ref->pxx;
+    double pxy = ref->pxy;
+
+    if (ref->n > 1)
+    {
+        pxx += ref->sxx - ((ref->sx * ref->sx) / n);
+        pxy += ref->sxy - ((ref->sx * ref->sy) / n);
+    }
+
+    return (pxx > 0.0) ? (pxy / pxx) * ips * ROLLER_TICKS_PER_REV * 1.0e6 : 0.0;
+}
+
+/* Frames the tape time is out an hour from zero, counting the roller
+ * turns with one circumference and taking the tape travel from another.
+ */
+static double HourError(double circUsed, double circReal, uint32_t ips)
+{
+    double turns = 3600.0 * ips / circReal;
+
+    return ((turns * circUsed / ips) - 3600.0) * FPS;
+}
+
+/* Uniform in [0, 1) */
+static double Uniform(uint32_t* seed)
+{
+    return (double)Random(seed) / 4294967296.0;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
@@ -0,0 +1,303 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* CRC16 conformance test and benchmark. CRC16Block() is checked against
+ * CRC16Update() summed a byte at a time, for every block length up to
+ * 4096 bytes and random lengths, starting offsets and CRC seeds, and for
+ * blocks summed in two pieces. CRC16XmodemBlock() is checked the same way
+ * against the bitwise XMODEM CRC that xmodem.c used, and against the
+ * CRC-16/XMODEM check value for "123456789".
+ *
+ * Then blocks of the sizes the firmware sums are timed both ways, giving
+ * ns and, on x86, TSC cycles per byte. Build with -DCRC16_SLICE=4 to time
+ * the four byte slices. The exit status is 1 if any CRC differs.
+ *
+ * Usage:
+ *   crcbench [-n blocks] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TSC               1
+#else
+#define BENCH_TSC               0
+#endif
+
+#include "CRC16.h"
+
+/* Longest block checked at every length */
+#define CHECK_MAX_LEN           4096
+
+/* CRC-16/XMODEM of "123456789" */
+#define XMODEM_CHECK            0x31C3
+
+/* Block sizes timed */
+typedef struct _BENCH_CASE {
+    const char* name;
+    bool        xmodem;         /* XMODEM CRC, else the frame CRC   */
+    size_t      len;
+} BENCH_CASE;
+
+static const BENCH_CASE s_cases[] = {
+    { "IPC message",    false, 16       },
+    { "IPC max text",   false, 520      },
+    { "RAMP display",   false, 1042     },
+    { "RAMP max text",  false, 2058     },
+    { "64K block",      false, 65536    },
+    { "XMODEM block",   true,  128      },
+    { "64K XMODEM",     true,  65536    },
+};
+
+static uint8_t s_data[65536 + 8];
+
+/* Static Function Prototypes */
+static uint16_t ByteFrame(uint16_t crc, const uint8_t* p, size_t len);
+static uint16_t BitXmodem(uint16_t crc, const uint8_t* p, size_t len);
+static uint32_t Check(const char* name, size_t len, size_t off, uint16_t seed,
+                      uint16_t got, uint16_t want);
+static double Now(void);
+static uint64_t Cycles(void);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t blocks = 100000;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t checks = 0;
+    uint32_t i, ops;
+    size_t len, off, cut, c;
+    uint16_t crc, want;
+    volatile uint16_t sink = 0;
+    double t, told, tnew;
+    uint64_t k, kold, knew;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            blocks = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n blocks] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("crc check: slice %d, %u random blocks, seed %u\n", CRC16_SLICE, blocks, seed);
+
+    for (i=0; i < sizeof(s_data); i++)
+        s_data[i] = (uint8_t)Random(&seed);
+
+    /* The known XMODEM check value, both ways */
+    errors += Check("xmodem check", 9, 0, 0,
+                    CRC16XmodemBlock(0, "123456789", 9), XMODEM_CHECK);
+    errors += Check("xmodem bitwise", 9, 0, 0,
+                    BitXmodem(0, (const uint8_t*)"123456789", 9), XMODEM_CHECK);
+    checks += 2;
+
+    /* Every length and starting alignment */
+    for (len=0; len <= CHECK_MAX_LEN; len++)
+    {
+        off = len & 7;
+        crc = (uint16_t)Random(&seed);
+
+        errors += Check("frame", len, off, crc, CRC16Block(crc, &s_data[off], len),
+                        ByteFrame(crc, &s_data[off], len));
+        errors += Check("xmodem", len, off, crc, CRC16XmodemBlock(crc, &s_data[off], len),
+                        BitXmodem(crc, &s_data[off], len));
+        checks += 2;
+    }
+
+    /* Random blocks, also summed in two pieces */
+    for (i=0; i < blocks; i++)
+    {
+        len = Random(&seed) % (CHECK_MAX_LEN * 2);
+        off = Random(&seed) % (sizeof(s_data) - len);
+        cut = len ? (Random(&seed) % len) : 0;
+        crc = (uint16_t)Random(&seed);
+
+        want = ByteFrame(crc, &s_data[off], len);
+
+        errors += Check("frame", len, off, crc, CRC16Block(crc, &s_data[off], len), want);
+        errors += Check("frame split", len, off, crc,
+                        CRC16Block(CRC16Block(crc, &s_data[off], cut),
+                                   &s_data[off + cut], len - cut), want);
+
+        want = BitXmodem(crc, &s_data[off], len);
+
+        errors += Check("xmodem", len, off, crc, CRC16XmodemBlock(crc, &s_data[off], len),
+                        want);
+        errors += Check("xmodem split", len, off, crc,
+                        CRC16XmodemBlock(CRC16XmodemBlock(crc, &s_data[off], cut),
+                                         &s_data[off + cut], len - cut), want);
+        checks += 4;
+    }
+
+    printf("%u CRCs checked, %u differ\n\n", checks, errors);
+
+    /* Time each block size both ways */
+    printf("%-14s %6s %10s %10s %9s %9s %9s %9s\n", "block", "bytes",
+           "byte ns/B", "block ns/B", "byte c/B", "block c/B", "MB/s", "speedup");
+
+    for (c=0; c < sizeof(s_cases) / sizeof(s_cases[0]); c++)
+    {
+        const BENCH_CASE* bc = &s_cases[c];
+
+        ops = (uint32_t)(200000000 / (bc->len + 16));
+
+        if (bc->xmodem)
+            ops /= 4;
+
+        /* A byte at a time, as the firmware summed it before */
+        t = Now();
+        k = Cycles();
+        for (i=0; i < ops; i++)
+        {
+            if (bc->xmodem)
+                sink += BitXmodem((uint16_t)i, s_data, bc->len);
+            else
+                sink += ByteFrame((uint16_t)i, s_data, bc->len);
+        }
+        kold = Cycles() - k;
+        told = Now() - t;
+
+        /* The block functions */
+        t = Now();
+        k = Cycles();
+        for (i=0; i < ops; i++)
+        {
+            if (bc->xmodem)
+                sink += CRC16XmodemBlock((uint16_t)i, s_data, bc->len);
+            else
+                sink += CRC16Block((uint16_t)i, s_data, bc->len);
+        }
+        knew = Cycles() - k;
+        tnew = Now() - t;
+
+        printf("%-14s %6zu %10.3f %10.3f %9.2f %9.2f %9.0f %8.2fx\n", bc->name, bc->len,
+               told * 1.0e9 / ((double)ops * bc->len),
+               tnew * 1.0e9 / ((double)ops * bc->len),
+               (double)kold / ((double)ops * bc->len),
+               (double)knew / ((double)ops * bc->len),
+               tnew ? ((double)ops * bc->len / tnew * 1.0e-6) : 0.0,
+               tnew ? (told / tnew) : 0.0);
+    }
+
+    printf("\nbyte: CRC16Update() a byte at a time for the frame CRC, the bitwise\n");
+    printf("xmodem_crc() for XMODEM. block: CRC16Block(), CRC16XmodemBlock().\n");
+#if (BENCH_TSC > 0)
+    printf("c/B: TSC cycles per byte, MB/s for the block functions\n");
+#else
+    printf("c/B: no cycle counter on this host, MB/s for the block functions\n");
+#endif
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* The frame CRC a byte at a time */
+static uint16_t ByteFrame(uint16_t crc, const uint8_t* p, size_t len)
+{
+    while (len--)
+        crc = CRC16Update(crc, *p++);
+
+    return crc;
+}
+
+/* The XMODEM CRC as xmodem.c summed it, a bit at a time */
+static uint16_t BitXmodem(uint16_t crc, const uint8_t* p, size_t len)
+{
+    int i;
+
+    while (len--)
+    {
+        crc = crc ^ ((uint16_t)*p++ << 8);
+
+        for (i=0; i < 8; i++)
+        {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc <<= 1;
+        }
+    }
+
+    return crc;
+}
+
+/* Report a CRC that differs, returns the error count */
+static uint32_t Check(const char* name, size_t len, size_t off, uint16_t seed,
+                      uint16_t got, uint16_t want)
+{
+    if (got == want)
+        return 0;
+
+    printf("%s CRC differs: %zu bytes at %zu seed %04X, %04X against %04X\n",
+           name, len, off, seed, got, want);
+
+    return 1;
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+static uint64_t Cycles(void)
+{
+#if (BENCH_TSC > 0)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
@@ -0,0 +1,467 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Cue store benchmark. Fills the named cue store built for the host with
+ * random cues spread over a number of banks and times adding the cues,
+ * the next, previous and nearest cue queries used for jog-to-cue, paging
+ * through a bank, finding a cue by name, moving cues and removing them.
+ * The next cue query is also timed as a linear scan of the cues, as a
+ * flat cue table would need, for comparison.
+ *
+ * Every query result is checked against a linear scan of the cues, and
+ * the store is copied through the save and load path to check that the
+ * handles and index come back the same. The exit status is 1 if any check
+ * fails.
+ *
+ * Usage:
+ *   cuebench [-n cues] [-b banks] [-l lookups] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "CueStore.h"
+
+/* Cue positions are spread over a reel of this many encoder counts */
+#define BENCH_REEL_COUNTS       (2400L * 80L)
+
+/* Number of cues moved and removed to test the index upkeep */
+#define BENCH_CHURN             1000
+
+typedef enum {
+    FIND_NEXT=0,
+    FIND_PREV,
+    FIND_NEAREST
+} FIND_MODE;
+
+static CUE_STORE s_store;
+static CUE_STORE s_copy;
+
+/* Static Function Prototypes */
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+static int32_t RandomPos(uint32_t* seed);
+static int Scan(CUE_STORE* cs, uint32_t bank, int32_t ipos, FIND_MODE mode);
+static bool Same(CUE_STORE* cs, int a, int b, int32_t ipos, FIND_MODE mode);
+static bool CheckIndex(CUE_STORE* cs);
+static bool CheckCopy(CUE_STORE* cs, CUE_STORE* copy);
+static void Report(const char* name, double seconds, uint32_t ops);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t cues = 10000;
+    uint32_t banks = 16;
+    uint32_t lookups = 100000;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t i, r;
+    uint32_t* qbank;
+    int32_t* qpos;
+    int* handles;
+    int* result;
+    char name[CUE_NAME_LEN];
+    volatile int sink = 0;
+    size_t n, total;
+    double t;
+    int opt, h;
+
+    while ((opt = getopt(argc, argv, "n:b:l:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            cues = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            banks = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            lookups = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n cues] [-b banks] [-l lookups] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    if ((cues > CUE_STORE_MAX) || (cues < BENCH_CHURN) || !banks || (banks > 256) || !lookups)
+    {
+        fprintf(stderr, "cues must be %d to %d and banks 1 to 256\n", BENCH_CHURN, CUE_STORE_MAX);
+        return 1;
+    }
+
+    handles = calloc(cues, sizeof(int));
+    result  = calloc(lookups, sizeof(int));
+    qbank   = calloc(lookups, sizeof(uint32_t));
+    qpos    = calloc(lookups, sizeof(int32_t));
+
+    printf("cue store: %u cues in %u banks, %u lookups, %zu bytes\n\n",
+           cues, banks, lookups, sizeof(CUE_STORE));
+
+    /* Random cues added in no particular order */
+    CueStore_init(&s_store);
+
+    t = Now();
+
+    for (i=0; i < cues; i++)
+    {
+        snprintf(name, sizeof(name), "cue%05u", i);
+
+        handles[i] = CueStore_add(&s_store, Random(&seed) % banks, RandomPos(&seed), STC_CF_ACTIVE, name);
+    }
+
+    Report("add", Now() - t, cues);
+
+    for (i=0; i < cues; i++)
+    {
+        if (handles[i] == CUE_NONE)
+            errors++;
+    }
+
+    if (!CheckIndex(&s_store))
+        errors++;
+
+    for (i=0; i < lookups; i++)
+    {
+        qbank[i] = Random(&seed) % banks;
+        qpos[i]  = RandomPos(&seed);
+    }
+
+    /* Jog-to-cue queries from random positions, then checked */
+    t = Now();
+    for (i=0; i < lookups; i++)
+        result[i] = CueStore_next(&s_store, qbank[i], qpos[i]);
+    Report("next", Now() - t, lookups);
+
+    for (i=0; i < lookups; i++)
+    {
+        if (!Same(&s_store, result[i], Scan(&s_store, qbank[i], qpos[i], FIND_NEXT), qpos[i], FIND_NEXT))
+            errors++;
+    }
+
+    t = Now();
+    for (i=0; i < lookups; i++)
+        result[i] = CueStore_prev(&s_store, qbank[i], qpos[i]);
+    Report("prev", Now() - t, lookups);
+
+    for (i=0; i < lookups; i++)
+    {
+        if (!Same(&s_store, result[i], Scan(&s_store, qbank[i], qpos[i], FIND_PREV), qpos[i], FIND_PREV))
+            errors++;
+    }
+
+    t = Now();
+    for (i=0; i < lookups; i++)
+        result[i] = CueStore_nearest(&s_store, qbank[i], qpos[i]);
+    Report("nearest", Now() - t, lookups);
+
+    for (i=0; i < lookups; i++)
+    {
+        if (!Same(&s_store, result[i], Scan(&s_store, qbank[i], qpos[i], FIND_NEAREST), qpos[i], FIND_NEAREST))
+            errors++;
+    }
+
+    /* The same next cue queries as a scan of every cue */
+    t = Now();
+    for (i=0; i < lookups; i++)
+        sink += Scan(&s_store, qbank[i], qpos[i], FIND_NEXT);
+    Report("next (scan)", Now() - t, lookups);
+
+    /* Paging through each bank must give every cue once, in order */
+    t = Now();
+
+    for (i=0, total=0; i < banks; i++)
+    {
+        int32_t last = INT32_MIN;
+
+        for (n=0; (h = CueStore_at(&s_store, i, n)) != CUE_NONE; n++)
+        {
+            if ((s_store.entry[h].bank != i) || (s_store.entry[h].ipos < last))
+                errors++;
+
+            last = s_store.entry[h].ipos;
+        }
+
+        if (n != CueStore_count(&s_store, i))
+            errors++;
+
+        total += n;
+    }
+
+    Report("at", Now() - t, (uint32_t)total);
+
+    if (total != cues)
+        errors++;
+
+    /* Find by name scans a bank */
+    t = Now();
+
+    for (i=0; i < lookups; i++)
+    {
+        r = Random(&seed) % cues;
+
+        snprintf(name, sizeof(name), "cue%05u", r);
+
+        result[i] = CueStore_find(&s_store, s_store.entry[handles[r]].bank, name);
+
+        if (result[i] != handles[r])
+            errors++;
+    }
+
+    Report("find", Now() - t, lookups);
+
+    /* Move cues to new positions and check the index still holds */
+    t = Now();
+
+    for (i=0; i < BENCH_CHURN; i++)
+    {
+        if (!CueStore_move(&s_store, handles[Random(&seed) % cues], RandomPos(&seed)))
+            errors++;
+    }
+
+    Report("move", Now() - t, BENCH_CHURN);
+
+    if (!CheckIndex(&s_store))
+        errors++;
+
+    /* Copy the store the way it is saved and loaded */
+    CueStore_init(&s_copy);
+
+    for (h = CueStore_scan(&s_store, 0); h != CUE_NONE; h = CueStore_scan(&s_store, h + 1))
+    {
+        if (!CueStore_put(&s_copy, h, &s_store.entry[h]))
+            errors++;
+    }
+
+    if (!CheckCopy(&s_store, &s_copy))
+        errors++;
+
+    /* Remove cues, then add them back into the freed handles */
+    t = Now();
+
+    for (i=0; i < BENCH_CHURN; i++)
+    {
+        if (!CueStore_remove(&s_store, handles[i]))
+            errors++;
+    }
+
+    Report("remove", Now() - t, BENCH_CHURN);
+
+    if (!CheckIndex(&s_store) || (s_store.count != (cues - BENCH_CHURN)))
+        errors++;
+
+    for (i=0; i < BENCH_CHURN; i++)
+    {
+        if ((handles[i] = CueStore_add(&s_store, 0, RandomPos(&seed), STC_CF_ACTIVE, "again")) == CUE_NONE)
+            errors++;
+    }
+
+    if (!CheckIndex(&s_store))
+        errors++;
+
+    /* Clearing a bank takes all its cues */
+    n = CueStore_count(&s_store, 0);
+
+    if ((CueStore_clearBank(&s_store, 0) != n) || CueStore_count(&s_store, 0) || !CheckIndex(&s_store))
+        errors++;
+
+    printf("\n%u check errors\n", errors);
+
+    (void)sink;
+
+    free(handles);
+    free(result);
+    free(qbank);
+    free(qpos);
+
+    return errors ? 1 : 0;
+}
+
+//*****************************************************************************
+// Find a cue by scanning every cue in the store.
+//*****************************************************************************
+
+static int Scan(CUE_STORE* cs, uint32_t bank, int32_t ipos, FIND_MODE mode)
+{
+    int64_t dist;
+    int64_t best = INT64_MAX;
+    int found = CUE_NONE;
+    int h;
+
+    for (h=0; h < CUE_STORE_MAX; h++)
+    {
+        if (!(cs->used[h / 32] & (1U << (h % 32))) || (cs->entry[h].bank != bank))
+            continue;
+
+        dist = (int64_t)cs->entry[h].ipos - ipos;
+
+        if (mode == FIND_NEXT)
+        {
+            if (dist <= 0)
+                continue;
+        }
+        else if (mode == FIND_PREV)
+        {
+            if (dist >= 0)
+                continue;
+            dist = -dist;
+        }
+        else if (dist < 0)
+        {
+            dist = -dist;
+        }
+
+        if (dist < best)
+        {
+            best  = dist;
+            found = h;
+        }
+    }
+
+    return found;
+}
+
+//*****************************************************************************
+// Check that two query results are the same distance from the position.
+// Cues at the same position may be found in either order.
+//*****************************************************************************
+
+static bool Same(CUE_STORE* cs, int a, int b, int32_t ipos, FIND_MODE mode)
+{
+    int64_t da, db;
+
+    if ((a == CUE_NONE) || (b == CUE_NONE))
+        return a == b;
+
+    da = (int64_t)cs->entry[a].ipos - ipos;
+    db = (int64_t)cs->entry[b].ipos - ipos;
+
+    if (mode == FIND_NEAREST)
+        return llabs(da) == llabs(db);
+
+    return da == db;
+}
+
+//*****************************************************************************
+// Check the index holds every cue in use once, sorted by bank and position.
+//*****************************************************************************
+
+static bool CheckIndex(CUE_STORE* cs)
+{
+    static uint8_t seen[CUE_STORE_MAX];
+    const CUE_ENTRY* a;
+    const CUE_ENTRY* b;
+    size_t i, used = 0;
+    int h;
+
+    memset(seen, 0, sizeof(seen));
+
+    for (i=0; i < cs->count; i++)
+    {
+        h = cs->index[i];
+
+        if (!CueStore_get(cs, h) || seen[h]++)
+            return false;
+
+        if (i)
+        {
+            a = &cs->entry[cs->index[i - 1]];
+            b = &cs->entry[h];
+
+            if ((a->bank > b->bank) || ((a->bank == b->bank) && (a->ipos > b->ipos)))
+                return false;
+        }
+    }
+
+    for (h = CueStore_scan(cs, 0); h != CUE_NONE; h = CueStore_scan(cs, h + 1))
+        used++;
+
+    return used == cs->count;
+}
+
+//*****************************************************************************
+// Check a copy of the store has the same cues under the same handles.
+//*****************************************************************************
+
+static bool CheckCopy(CUE_STORE* cs, CUE_STORE* copy)
+{
+    const CUE_ENTRY* a;
+    const CUE_ENTRY* b;
+    int h;
+
+    if ((cs->count != copy->count) || !CheckIndex(copy))
+        return false;
+
+    for (h=0; h < CUE_STORE_MAX; h++)
+    {
+        a = CueStore_get(cs, h);
+        b = CueStore_get(copy, h);
+
+        if ((a == NULL) != (b == NULL))
+            return false;
+
+        if (a && memcmp(a, b, sizeof(CUE_ENTRY)))
+            return false;
+    }
+
+    return true;
+}
+
+/* Print the time per operation */
+static void Report(const char* name, double seconds, uint32_t ops)
+{
+    printf("%-12s %8u ops %10.1f ns/op\n", name, ops, ops ? (seconds * 1.0e9 / ops) : 0.0);
+}
+
+/* Seconds on the monotonic clock */
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+/* Park-Miller random numbers, repeatable for a seed */
+static uint32_t Random(uint32_t* seed)
+{
+    *seed = (uint32_t)(((uint64_t)*seed * 48271U) % 2147483647U);
+
+    return *seed;
+}
+
+/* Random tape position, some cues before the zero point */
+static int32_t RandomPos(uint32_t* seed)
+{
+    return (int32_t)(Random(seed) % BENCH_REEL_COUNTS) - (int32_t)(BENCH_REEL_COUNTS / 20);
+}
+
+/* End-Of-File */
@@ -0,0 +1,535 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Seven segment display packet test. Every time the display can show, with
+ * every combination of the sign, blink and blank flags, is built into a
+ * standard packet and checked byte for byte against the packet the old
+ * position task wrote a byte at a time. Extended packets are checked for
+ * every tenths and frame digit over the first two hours.
+ *
+ * Each packet is also fed a byte at a time to a model of the display end,
+ * which syncs on the preamble, checks the length and checksum, and lights
+ * each digit from a seven segment table. The segments lit must read back
+ * as the time sent. Each packet is then sent again with one byte changed,
+ * and the display must not take it.
+ *
+ * Last, a tape run of play, shuttle, search and stop is sent over the link
+ * with Disp7_update() on every 5 ms position task pass, and with the old
+ * refresh every 20 passes, across the 32 bit tick wrap. The bytes sent and
+ * how long the display is left showing an old time are compared. The exit
+ * status is 1 if any check fails.
+ *
+ * Usage:
+ *   dispbench [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "TapeTime.h"
+#include "Display7Seg.h"
+
+/* Position task pass period in ms, and the old refresh count */
+#define PASS_MS                 5
+#define LEGACY_PASSES           20
+
+/* Hours checked with every tenths and frame digit */
+#define EXT_HOURS               2
+
+/* Seven segment patterns, bit 0 is segment a through bit 6 segment g */
+static const uint8_t s_segments[10] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+};
+
+/* Flag combinations sent */
+static const uint8_t s_flags[] = {
+    0, F_PLUS, F_BLINK, F_PLUS | F_BLINK, F_BLANK, F_BLANK | F_PLUS,
+    F_BLANK | F_BLINK, F_BLANK | F_PLUS | F_BLINK
+};
+
+#define NUM_FLAGS   (sizeof(s_flags) / sizeof(s_flags[0]))
+
+/* The display end of the link */
+typedef struct _DISPLAY {
+    uint8_t     buf[DISP7_PACKET_MAX];
+    size_t      len;                /* bytes of the packet so far   */
+    size_t      want;               /* packet length once known     */
+    uint8_t     digit[9];           /* segments lit, H MM SS t FF   */
+    uint8_t     flags;
+    bool        extended;           /* last packet was extended     */
+    uint32_t    packets;            /* packets taken                */
+    uint32_t    rejects;            /* packets failing the checksum */
+} DISPLAY;
+
+/* A stretch of the tape run */
+typedef struct _SEGMENT {
+    const char* name;
+    uint32_t    ms;
+    double      ips;
+    bool        blink;
+} SEGMENT;
+
+static const SEGMENT s_run[] = {
+    { "stop",       3000,    0.0, false },
+    { "play",      20000,   30.0, false },
+    { "search",     8000, -380.0, true  },
+    { "stop",       5000,    0.0, false },
+    { "shuttle",   10000,  380.0, false },
+    { "play",      10000,   30.0, false },
+};
+
+#define NUM_RUN     (sizeof(s_run) / sizeof(s_run[0]))
+
+/* Static Function Prototypes */
+static uint32_t CheckTable(uint32_t* seed, bool extended);
+static uint32_t CheckRun(void);
+static bool Send(DISPLAY* d, const TAPETIME* t, const uint8_t* buf, size_t len);
+static void DisplayInit(DISPLAY* d);
+static bool DisplayByte(DISPLAY* d, uint8_t b);
+static bool DisplayShows(DISPLAY* d, const TAPETIME* t, bool extended);
+static int Digit(uint8_t segments);
+static size_t LegacyPacket(TAPETIME* p, uint8_t* buf);
+static void TapeTimeAt(double seconds, uint8_t flags, TAPETIME* t);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t i, j;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("7-segment display: packets %d and %d bytes, keep alive %d ms, seed %u\n\n",
+           DISP7_PACKET_STD, DISP7_PACKET_EXT, DISP7_KEEPALIVE, seed);
+
+    /* Every digit must have its own pattern */
+    for (i=0; i < 10; i++)
+    {
+        for (j=0; j < 10; j++)
+        {
+            if ((i != j) && (s_segments[i] == s_segments[j]))
+                errors++;
+        }
+    }
+
+    printf("%-10s %10s %10s %10s %8s\n", "packet", "times", "matched", "corrupted", "errors");
+
+    errors += CheckTable(&seed, false);
+    errors += CheckTable(&seed, true);
+
+    printf("\n");
+
+    errors += CheckRun();
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Every time the display can show through the encoder and the display
+ * end, with one corrupted copy of each. Returns the check errors.
+ */
+static uint32_t CheckTable(uint32_t* seed, bool extended)
+{
+    DISPLAY d;
+    TAPETIME t;
+    uint8_t buf[DISP7_PACKET_MAX];
+    uint8_t old[DISP7_PACKET_MAX];
+    uint32_t times = 0, matched = 0, corrupted = 0, errors = 0;
+    uint32_t hour, mins, secs, tens, frame, f;
+    uint32_t tensMax = extended ? 10 : 1;
+    uint32_t frameMax = extended ? 30 : 1;
+    uint32_t hourMax = extended ? EXT_HOURS : 10;
+    size_t len, at;
+
+    DisplayInit(&d);
+    memset(&t, 0, sizeof(TAPETIME));
+
+    for (hour=0; hour < hourMax; hour++)
+    {
+        for (mins=0; mins < 60; mins++)
+        {
+            for (secs=0; secs < 60; secs++)
+            {
+                for (tens=0; tens < tensMax; tens++)
+                {
+                    for (frame=0; frame < frameMax; frame += (extended ? 1 : 30))
+                    {
+                        for (f=0; f < NUM_FLAGS; f++)
+                        {
+                            t.hour  = (uint8_t)hour;
+                            t.mins  = (uint8_t)mins;
+                            t.secs  = (uint8_t)secs;
+                            t.tens  = (uint8_t)tens;
+                            t.frame = (uint8_t)frame;
+                            t.flags = s_flags[f];
+
+                            times++;
+
+                            len = Disp7_encode(&t, buf, extended);
+
+                            if (len != (extended ? DISP7_PACKET_EXT : DISP7_PACKET_STD))
+                            {
+                                errors++;
+                                continue;
+                            }
+
+                            /* The standard packet is what was always sent */
+                            if (!extended && ((LegacyPacket(&t, old) != len) ||
+                                              memcmp(buf, old, len)))
+                            {
+                                errors++;
+                                continue;
+                            }
+
+                            if (!Send(&d, &t, buf, len))
+                            {
+                                errors++;
+                                continue;
+                            }
+
+                            matched++;
+
+                            /* Change a byte after the preamble, a new
+                             * display packet must still be taken after.
+                             */
+                            at = 2 + (Random(seed) % (len - 2));
+                            buf[at] ^= (uint8_t)(1 + (Random(seed) % 255));
+
+                            if (Send(&d, &t, buf, len) || !DisplayShows(&d, &t, extended))
+                                errors++;
+                            else
+                                corrupted++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%-10s %10u %10u %10u %8u\n", extended ? "extended" : "standard", times, matched,
+           corrupted, errors);
+
+    return errors;
+}
+
+/* A tape run over the link, new and old refresh. Returns the check errors. */
+static uint32_t CheckRun(void)
+{
+    DISP7_LINK link;
+    DISPLAY d[2];
+    TAPETIME t;
+    uint8_t buf[DISP7_PACKET_MAX];
+    uint32_t bytes[2] = { 0, 0 };
+    uint32_t stale[2] = { 0, 0 };
+    uint32_t since[2] = { 0, 0 };
+    uint32_t quiet = 0, maxQuiet = 0;
+    uint32_t errors = 0;
+    uint32_t start = 0xFFFFFFFFu - 30000;
+    uint32_t now = start;
+    uint32_t ms, pass = 0;
+    double seconds = 1800.0;
+    size_t len, i, k;
+
+    Disp7_init(&link, false);
+    DisplayInit(&d[0]);
+    DisplayInit(&d[1]);
+
+    printf("%-10s %8s %8s %8s %8s %10s\n", "refresh", "secs", "bytes", "bytes/s", "packets",
+           "stale ms");
+
+    for (i=0; i < NUM_RUN; i++)
+    {
+        for (ms=0; ms < s_run[i].ms; ms += PASS_MS, now += PASS_MS, pass++)
+        {
+            seconds += s_run[i].ips * PASS_MS / 1000.0 / 30.0;
+
+            TapeTimeAt(seconds, s_run[i].blink ? F_BLINK : 0, &t);
+
+            /* On change or keep alive */
+            len = Disp7_update(&link, &t, buf, now);
+
+            if (len)
+            {
+                bytes[0] += (uint32_t)len;
+
+                if (!Send(&d[0], &t, buf, len))
+                    errors++;
+
+                if (quiet > maxQuiet)
+                    maxQuiet = quiet;
+
+                quiet = 0;
+            }
+            else
+            {
+                quiet += PASS_MS;
+            }
+
+            /* The old refresh every 20 passes */
+            if (!(pass % LEGACY_PASSES))
+            {
+                len = LegacyPacket(&t, buf);
+                bytes[1] += (uint32_t)len;
+
+                if (!Send(&d[1], &t, buf, len))
+                    errors++;
+            }
+
+            /* How long each display has been showing an old time */
+            for (k=0; k < 2; k++)
+            {
+                if (DisplayShows(&d[k], &t, false))
+                    since[k] = 0;
+                else
+                    since[k] += PASS_MS;
+
+                if (since[k] > stale[k])
+                    stale[k] = since[k];
+            }
+        }
+    }
+
+    ms = now - start;
+
+    printf("%-10s %8.1f %8u %8.1f %8u %10u\n", "on change", ms / 1000.0, bytes[0],
+           bytes[0] * 1000.0 / ms, d[0].packets, stale[0]);
+    printf("%-10s %8.1f %8u %8.1f %8u %10u\n", "20 passes", ms / 1000.0, bytes[1],
+           bytes[1] * 1000.0 / ms, d[1].packets, stale[1]);
+
+    printf("\nlongest gap between packets %u ms, keep alive %d ms\n", maxQuiet, DISP7_KEEPALIVE);
+
+    printf("\ntimes: packets built, matched: taken by the display and read back from\n");
+    printf("the segments, corrupted: copies with a byte changed the display refused.\n");
+    printf("stale ms: the longest the display showed an old time\n");
+
+    /* The display is never behind and the keep alive is kept */
+    if (stale[0] || (maxQuiet >= DISP7_KEEPALIVE) || (maxQuiet < (DISP7_KEEPALIVE - PASS_MS)))
+        errors++;
+
+    return errors;
+}
+
+/* Send a packet a byte at a time. Returns true if the display took it and
+ * now shows the time.
+ */
+static bool Send(DISPLAY* d, const TAPETIME* t, const uint8_t* buf, size_t len)
+{
+    bool took = false;
+    size_t i;
+
+    for (i=0; i < len; i++)
+        took |= DisplayByte(d, buf[i]);
+
+    return took && DisplayShows(d, t, (len == DISP7_PACKET_EXT));
+}
+
+static void DisplayInit(DISPLAY* d)
+{
+    memset(d, 0, sizeof(DISPLAY));
+}
+
+/* The display end receiving a byte. Returns true when a whole packet with
+ * a good checksum has been taken and the digits lit from it.
+ */
+static bool DisplayByte(DISPLAY* d, uint8_t b)
+{
+    uint8_t csum = 0;
+    size_t i;
+
+    /* Sync on the preamble */
+    if (d->len == 0)
+    {
+        if (b == DISP7_PREAMBLE)
+            d->buf[d->len++] = b;
+
+        return false;
+    }
+
+    if (d->len == 1)
+    {
+        if (b == DISP7_PREAMBLE_STD)
+            d->want = DISP7_PACKET_STD;
+        else if (b == DISP7_PREAMBLE_EXT)
+            d->want = DISP7_PACKET_EXT;
+        else
+            d->len = (b == DISP7_PREAMBLE) ? 1 : 0;
+
+        if (d->len)
+            d->buf[d->len++] = b;
+
+        return false;
+    }
+
+    d->buf[d->len++] = b;
+
+    if (d->len < d->want)
+        return false;
+
+    d->len = 0;
+
+    for (i=2; i < (d->want - 1); i++)
+        csum += d->buf[i];
+
+    if (csum != d->buf[d->want - 1])
+    {
+        d->rejects++;
+        return false;
+    }
+
+    /* Light the digits */
+    d->digit[0] = s_segments[d->buf[4] % 10];
+    d->digit[1] = s_segments[d->buf[3] / 10 % 10];
+    d->digit[2] = s_segments[d->buf[3] % 10];
+    d->digit[3] = s_segments[d->buf[2] / 10 % 10];
+    d->digit[4] = s_segments[d->buf[2] % 10];
+    d->flags    = d->buf[5];
+    d->extended = (d->want == DISP7_PACKET_EXT);
+
+    if (d->extended)
+    {
+        d->digit[5] = s_segments[d->buf[6] % 10];
+        d->digit[6] = s_segments[d->buf[7] / 10 % 10];
+        d->digit[7] = s_segments[d->buf[7] % 10];
+    }
+
+    d->packets++;
+
+    return true;
+}
+
+/* Returns true if the segments lit read back as the time given */
+static bool DisplayShows(DISPLAY* d, const TAPETIME* t, bool extended)
+{
+    if (!d->packets || (d->extended != extended) || (d->flags != t->flags))
+        return false;
+
+    if ((Digit(d->digit[0]) != t->hour) ||
+        ((Digit(d->digit[1]) * 10 + Digit(d->digit[2])) != t->mins) ||
+        ((Digit(d->digit[3]) * 10 + Digit(d->digit[4])) != t->secs))
+        return false;
+
+    if (extended && ((Digit(d->digit[5]) != t->tens) ||
+                     ((Digit(d->digit[6]) * 10 + Digit(d->digit[7])) != t->frame)))
+        return false;
+
+    return true;
+}
+
+/* The digit a segment pattern reads as, or -1 */
+static int Digit(uint8_t segments)
+{
+    int i;
+
+    for (i=0; i < 10; i++)
+    {
+        if (s_segments[i] == segments)
+            return i;
+    }
+
+    return -1;
+}
+
+/* The packet the old position task wrote a byte at a time */
+static size_t LegacyPacket(TAPETIME* p, uint8_t* buf)
+{
+    uint16_t csum = 0;
+    size_t n = 0;
+    uint8_t b;
+
+    b = 0x89;
+    buf[n++] = b;
+
+    b = 0xFC;
+    buf[n++] = b;
+
+    b = p->secs;
+    csum += b;
+    buf[n++] = b;
+
+    b = p->mins;
+    csum += b;
+    buf[n++] = b;
+
+    b = p->hour;
+    csum += b;
+    buf[n++] = b;
+
+    b = p->flags;
+    csum += b;
+    buf[n++] = b;
+
+    b = csum & 0xFF;
+    buf[n++] = b;
+
+    return n;
+}
+
+/* Tape time for a number of seconds from zero */
+static void TapeTimeAt(double seconds, uint8_t flags, TAPETIME* t)
+{
+    uint32_t tenths;
+
+    memset(t, 0, sizeof(TAPETIME));
+
+    if (seconds < 0.0)
+        seconds = -seconds;
+    else
+        flags |= F_PLUS;
+
+    tenths = (uint32_t)(seconds * 10.0);
+
+    t->tens  = (uint8_t)(tenths % 10);
+    t->secs  = (uint8_t)((tenths / 10) % 60);
+    t->mins  = (uint8_t)((tenths / 600) % 60);
+    t->hour  = (uint8_t)((tenths / 36000) % 10);
+    t->flags = flags;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
@@ -0,0 +1,654 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* DTC-1200 simulator for the host. It plays the DTC side of the IPC link
+ * on a pseudo-terminal and runs the simulated transport in real time, so
+ * an STC, or any program speaking the IPC frame protocol, can be pointed
+ * at the slave device in place of the DTC serial port.
+ *
+ * Transport datagrams (OP_MODE_xxx and OP_NOTIFY_BUTTON) drive the
+ * transport, transactions are answered with a MSG+ACK reply and the mode
+ * changes are sent back as OP_NOTIFY_TRANSPORT, OP_NOTIFY_LAMP and
+ * OP_NOTIFY_EOT datagrams as the DTC sends them.
+ *
+ * By default the simulator speaks the link as the deployed DTC firmware
+ * does, sending unsequenced datagrams and never ACKing. With -a frames run
+ * through the firmware ARQ module, for an STC built with IPC_ARQ_ENABLED,
+ * so they are ACKed, resent and delivered in order. Unsequenced frames from
+ * an STC without the ARQ are taken as they come.
+ *
+ * The roller encoder is wired to the STC QEI and isn't on the IPC link,
+ * so the simulator prints the encoder count with the tape position.
+ *
+ *   usage: dtcsim [-s seed] [-p inches] [-l link] [-t ms] [-a] [-v]
+ */
+
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#include "IPCMessage.h"
+#include "IPCSimFrame.h"
+#include "IPCArq.h"
+#include "TransportSim.h"
+
+/* Tape speed reported to the STC */
+#define DTC_TAPE_SPEED          30
+
+typedef struct _DTC_SIM {
+    TRANSPORT_SIM   sim;
+    int             fd;             /* pty master                   */
+    uint32_t        shuttleVel;     /* OP_GET/SET_SHUTTLE_VELOCITY  */
+    bool            verbose;
+    bool            arqOn;          /* run the link ARQ             */
+    uint8_t         seqnum;         /* next sequence number, no ARQ */
+    /* Receive frame parser */
+    FRAME_PARSER    rxParser;
+    uint8_t         rxFrame[IPC_FRAME_MAX];
+    /* Link ARQ */
+    IPC_ARQ         arq;
+    uint32_t        rxBad;          /* parser errors seen by the ARQ */
+} DTC_SIM;
+
+/* Static Function Prototypes */
+static int OpenPty(const char* link);
+static double Now(void);
+static uint32_t Ms(void);
+static void Receive(DTC_SIM* dtc);
+static void Message(DTC_SIM* dtc, IPC_FCB* fcb, const uint8_t* text, uint16_t textlen);
+static void Service(DTC_SIM* dtc);
+static void Datagram(DTC_SIM* dtc, SIM_MSG* msg);
+static void Transaction(DTC_SIM* dtc, SIM_MSG* msg, IPC_FCB* fcb);
+static void Button(DTC_SIM* dtc, uint32_t mask);
+static void Command(DTC_SIM* dtc, uint32_t opcode, uint32_t param1, uint32_t param2);
+static void Notify(DTC_SIM* dtc, uint16_t opcode, uint32_t param1, uint32_t param2);
+static void Post(DTC_SIM* dtc, IPC_FCB* fcb, SIM_MSG* msg);
+static void Send(DTC_SIM* dtc, IPC_FCB* fcb, const void* text, uint16_t textlen);
+static uint32_t LampMask(uint32_t mode);
+static void Status(DTC_SIM* dtc);
+static uint32_t BadFrames(FRAME_STATS* stats);
+static void Usage(void);
+
+static volatile sig_atomic_t s_quit = 0;
+
+static void Quit(int sig)
+{
+    (void)sig;
+    s_quit = 1;
+}
+
+//*****************************************************************************
+// Main
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    static DTC_SIM dtc;
+    const char* link = NULL;
+    uint32_t seed = 1;
+    double pos = SIM_TAPE_LENGTH / 2.0;
+    double period = 0.0;
+    double start;
+    double status = 0.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:p:l:t:av")) != -1)
+    {
+        switch(opt)
+        {
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            pos = atof(optarg);
+            break;
+        case 'l':
+            link = optarg;
+            break;
+        case 't':
+            period = atof(optarg) / 1000.0;
+            break;
+        case 'a':
+            dtc.arqOn = true;
+            break;
+        case 'v':
+            dtc.verbose = true;
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+
+    if ((pos <= 0.0) || (pos >= SIM_TAPE_LENGTH))
+    {
+        fprintf(stderr, "position must be inside the tape (0 to %.0f)\n", SIM_TAPE_LENGTH);
+        return 1;
+    }
+
+    if ((dtc.fd = OpenPty(link)) < 0)
+        return 1;
+
+    TransportSim_init(&dtc.sim, seed, pos);
+
+    IPCArq_init(&dtc.arq);
+    dtc.seqnum = IPC_MIN_SEQ;
+
+    FrameParse_init(&dtc.rxParser, FRAME_IPC, dtc.rxFrame, sizeof(dtc.rxFrame));
+    dtc.shuttleVel = (uint32_t)(SIM_SHUTTLE_VEL / dtc.sim.velScale);
+
+    signal(SIGINT, Quit);
+    signal(SIGTERM, Quit);
+
+    start = Now();
+
+    while (!s_quit)
+    {
+        struct timeval tv = { 0, 1000 };
+        fd_set rfds;
+        double t;
+
+        FD_ZERO(&rfds);
+        FD_SET(dtc.fd, &rfds);
+
+        if (select(dtc.fd + 1, &rfds, NULL, NULL, &tv) > 0)
+            Receive(&dtc);
+
+        Service(&dtc);
+
+        /* Run the transport up to the wall clock */
+        t = Now() - start;
+
+        while (dtc.sim.time < t)
+        {
+            TransportSim_step(&dtc.sim);
+
+            if (dtc.sim.modeChanged)
+            {
+                dtc.sim.modeChanged = false;
+
+                Notify(&dtc, OP_NOTIFY_TRANSPORT, dtc.sim.mode, 0);
+                Notify(&dtc, OP_NOTIFY_LAMP, LampMask(dtc.sim.mode), DTC_TAPE_SPEED);
+
+                if (dtc.sim.eot)
+                {
+                    dtc.sim.eot = false;
+                    Notify(&dtc, OP_NOTIFY_EOT, 0, 0);
+                }
+
+                Status(&dtc);
+            }
+        }
+
+        if ((period > 0.0) && (t >= status))
+        {
+            status = t + period;
+            Status(&dtc);
+        }
+    }
+
+    if (link)
+        unlink(link);
+
+    close(dtc.fd);
+
+    return 0;
+}
+
+//*****************************************************************************
+// Open a pseudo-terminal in raw mode and return the master side. The slave
+// path is printed, and linked to the path given if any.
+//*****************************************************************************
+
+static int OpenPty(const char* link)
+{
+    struct termios tio;
+    const char* name;
+    int fd;
+    int slave;
+
+    if ((fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+
+    if ((grantpt(fd) < 0) || (unlockpt(fd) < 0) || !(name = ptsname(fd)))
+    {
+        perror("pty");
+        close(fd);
+        return -1;
+    }
+
+    /* Set the line discipline raw from the slave side. The slave is left
+     * open so the master doesn't see a hangup between STC sessions.
+     */
+    if ((slave = open(name, O_RDWR | O_NOCTTY)) < 0)
+    {
+        perror(name);
+        close(fd);
+        return -1;
+    }
+
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B230400);
+    cfsetospeed(&tio, B230400);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    if (link)
+    {
+        unlink(link);
+
+        if (symlink(name, link) < 0)
+            perror(link);
+    }
+
+    printf("DTC simulator on %s\n", link ? link : name);
+    fflush(stdout);
+
+    return fd;
+}
+
+//*****************************************************************************
+// Read what the pty has and handle each complete frame in it.
+//*****************************************************************************
+
+static void Receive(DTC_SIM* dtc)
+{
+    IPC_FCB fcb;
+    FRAME_RX frame;
+    uint8_t text[IPC_ARQ_TEXT_MAX];
+    uint16_t textlen;
+    FRAME_STATS* stats = &dtc->rxParser.stats;
+    uint8_t data[256];
+    const uint8_t* p = data;
+    uint32_t errors = BadFrames(stats);
+    size_t used;
+    size_t len;
+    ssize_t n;
+
+    n = read(dtc->fd, data, sizeof(data));
+
+    if (n <= 0)
+        return;
+
+    len = (size_t)n;
+
+    while (FrameParse_feed(&dtc->rxParser, p, len, &used, &frame))
+    {
+        p   += used;
+        len -= used;
+
+        /* A frame failing its CRC may have been the one expected next */
+        if ((stats->crc + stats->length) != dtc->rxBad)
+        {
+            dtc->rxBad = stats->crc + stats->length;
+
+            if (dtc->arqOn)
+                IPCArq_rxError(&dtc->arq);
+        }
+
+        fcb.type   = frame.type;
+        fcb.seqnum = frame.seqnum;
+        fcb.acknak = frame.acknak;
+        fcb.rsvd   = 0;
+
+        /* Without the ARQ every message frame is taken as it comes */
+        if (!dtc->arqOn)
+        {
+            if (((fcb.type & IPC_TYPE_MASK) != IPC_ACK_ONLY) &&
+                ((fcb.type & IPC_TYPE_MASK) != IPC_NAK_ONLY))
+                Message(dtc, &fcb, frame.text, frame.textlen);
+            continue;
+        }
+
+        if (IPCArq_rxFrame(&dtc->arq, &fcb, frame.text, frame.textlen, Ms()) == IPC_ARQ_DELIVER)
+            Message(dtc, &fcb, frame.text, frame.textlen);
+
+        /* Deliver what the frame put in order */
+        while (IPCArq_rxNext(&dtc->arq, &fcb, text, &textlen, Ms()))
+            Message(dtc, &fcb, text, textlen);
+    }
+
+    if (dtc->verbose && (BadFrames(stats) != errors))
+    {
+        printf("%9.3f rx errors %u (%u crc, %u length, %u bytes skipped)\n",
+               dtc->sim.time, BadFrames(stats), stats->crc, stats->length,
+               stats->skipped);
+    }
+}
+
+//*****************************************************************************
+// Handle a message frame delivered by the ARQ.
+//*****************************************************************************
+
+static void Message(DTC_SIM* dtc, IPC_FCB* fcb, const uint8_t* text, uint16_t textlen)
+{
+    SIM_MSG msg;
+
+    /* The DTC ignores replies and short messages */
+    if (((fcb->type & IPC_TYPE_MASK) != IPC_MSG_ONLY) || (textlen < sizeof(SIM_MSG)))
+        return;
+
+    memcpy(&msg, text, sizeof(SIM_MSG));
+
+    if (dtc->verbose)
+    {
+        printf("%9.3f rx type %u op %u %08x %08x seq %u\n", dtc->sim.time,
+               msg.type, msg.opcode, msg.param1.U, msg.param2.U, fcb->seqnum);
+    }
+
+    if (fcb->type & IPC_F_DATAGRAM)
+        Datagram(dtc, &msg);
+    else
+        Transaction(dtc, &msg, fcb);
+}
+
+//*****************************************************************************
+// Deliver frames held too long for a missing one, and send the ACKs, NAKs
+// and resends the ARQ has due.
+//*****************************************************************************
+
+static void Service(DTC_SIM* dtc)
+{
+    IPC_FCB fcb;
+    uint8_t text[IPC_ARQ_TEXT_MAX];
+    uint16_t textlen;
+    uint32_t resent = dtc->arq.stats.txResent;
+
+    if (!dtc->arqOn)
+        return;
+
+    while (IPCArq_rxNext(&dtc->arq, &fcb, text, &textlen, Ms()))
+        Message(dtc, &fcb, text, textlen);
+
+    while (IPCArq_poll(&dtc->arq, Ms(), &fcb, text, &textlen))
+        Send(dtc, &fcb, text, textlen);
+
+    if (dtc->verbose && (dtc->arq.stats.txResent != resent))
+    {
+        printf("%9.3f tx resent %u (%u given up, rto %u ms)\n", dtc->sim.time,
+               dtc->arq.stats.txResent, dtc->arq.stats.txFailed, dtc->arq.rto);
+    }
+}
+
+//*****************************************************************************
+// Handle a datagram from the STC. No reply is sent.
+//*****************************************************************************
+
+static void Datagram(DTC_SIM* dtc, SIM_MSG* msg)
+{
+    switch(msg->type)
+    {
+    case IPC_TYPE_NOTIFY:
+        if (msg->opcode == OP_NOTIFY_BUTTON)
+            Button(dtc, msg->param1.U);
+        break;
+
+    case IPC_TYPE_TRANSPORT:
+        Command(dtc, msg->opcode, msg->param1.U, msg->param2.U);
+        break;
+    }
+}
+
+//*****************************************************************************
+// Handle a transaction from the STC and send the MSG+ACK reply. Unknown
+// requests are returned as sent, as the DTC does.
+//*****************************************************************************
+
+static void Transaction(DTC_SIM* dtc, SIM_MSG* msg, IPC_FCB* fcb)
+{
+    SIM_MSG reply;
+    IPC_FCB fcbReply;
+
+    memcpy(&reply, msg, sizeof(SIM_MSG));
+
+    switch(msg->type)
+    {
+    case IPC_TYPE_TRANSPORT:
+        switch(msg->opcode)
+        {
+        case OP_TRANSPORT_GET_MODE:
+            reply.param1.U = dtc->sim.mode;
+            reply.param2.U = DTC_TAPE_SPEED;
+            break;
+
+        case OP_TRANSPORT_GET_VELOCITY:
+            reply.param1.F = (float)dtc->sim.vel;
+            break;
+
+        case OP_TRANSPORT_GET_TACH:
+            reply.param1.F = (float)TransportSim_tach(&dtc->sim);
+            break;
+        }
+        break;
+
+    case IPC_TYPE_CONFIG:
+        switch(msg->opcode)
+        {
+        case OP_GET_SHUTTLE_VELOCITY:
+            reply.param1.U = dtc->shuttleVel;
+            break;
+
+        case OP_SET_SHUTTLE_VELOCITY:
+            dtc->shuttleVel = msg->param1.U;
+            break;
+        }
+        break;
+    }
+
+    fcbReply.type   = IPC_MAKETYPE(IPC_F_ACKNAK, IPC_MSG_ACK);
+    fcbReply.seqnum = IPC_NULL_SEQ;
+    fcbReply.acknak = fcb->seqnum;
+    fcbReply.rsvd   = 0;
+
+    Post(dtc, &fcbReply, &reply);
+}
+
+//*****************************************************************************
+// Carry out a transport button press sent by the STC.
+//*****************************************************************************
+
+static void Button(DTC_SIM* dtc, uint32_t mask)
+{
+    if (mask & S_STOP)
+        Command(dtc, OP_MODE_STOP, 0, 0);
+    else if (mask & S_PLAY)
+        Command(dtc, OP_MODE_PLAY, (mask & S_REC) ? M_RECORD : 0, 0);
+    else if (mask & S_FWD)
+        Command(dtc, OP_MODE_FWD, 0, 0);
+    else if (mask & S_REW)
+        Command(dtc, OP_MODE_REW, 0, 0);
+}
+
+//*****************************************************************************
+// Pass a transport command to the simulated transport. A zero shuttle
+// velocity selects the configured shuttle velocity.
+//*****************************************************************************
+
+static void Command(DTC_SIM* dtc, uint32_t opcode, uint32_t param1, uint32_t param2)
+{
+    if (((opcode == OP_MODE_FWD) || (opcode == OP_MODE_REW)) && !param1)
+        param1 = dtc->shuttleVel;
+
+    TransportSim_command(&dtc->sim, opcode, param1, param2);
+}
+
+//*****************************************************************************
+// Send a notification datagram to the STC.
+//*****************************************************************************
+
+static void Notify(DTC_SIM* dtc, uint16_t opcode, uint32_t param1, uint32_t param2)
+{
+    SIM_MSG msg;
+    IPC_FCB fcb;
+
+    msg.type     = IPC_TYPE_NOTIFY;
+    msg.opcode   = opcode;
+    msg.param1.U = param1;
+    msg.param2.U = param2;
+
+    fcb.type   = IPC_MAKETYPE(IPC_F_DATAGRAM, IPC_MSG_ONLY);
+    fcb.seqnum = IPC_NULL_SEQ;
+    fcb.acknak = 0;
+    fcb.rsvd   = 0;
+
+    Post(dtc, &fcb, &msg);
+}
+
+//*****************************************************************************
+// Number a message and send it. Through the ARQ it is dropped if the send
+// window is full, as the DTC drops it when its tx queue is. Without the ARQ
+// only frames that are not datagrams are numbered.
+//*****************************************************************************
+
+static void Post(DTC_SIM* dtc, IPC_FCB* fcb, SIM_MSG* msg)
+{
+    if (!dtc->arqOn)
+    {
+        if ((fcb->type & IPC_F_DATAGRAM) == 0)
+        {
+            fcb->seqnum = dtc->seqnum;
+            dtc->seqnum = IPC_INC_SEQ(dtc->seqnum);
+        }
+    }
+    else if (!IPCArq_reserve(&dtc->arq, fcb, msg, sizeof(SIM_MSG)))
+    {
+        if (dtc->verbose)
+            printf("%9.3f tx window full, op %u dropped\n", dtc->sim.time, msg->opcode);
+        return;
+    }
+    else
+    {
+        IPCArq_sent(&dtc->arq, fcb->seqnum, Ms());
+    }
+
+    Send(dtc, fcb, msg, sizeof(SIM_MSG));
+
+    if (dtc->verbose)
+    {
+        printf("%9.3f tx type %u op %u %08x %08x seq %u\n", dtc->sim.time,
+               msg->type, msg->opcode, msg->param1.U, msg->param2.U, fcb->seqnum);
+    }
+}
+
+//*****************************************************************************
+// Write a frame to the pty in one write.
+//*****************************************************************************
+
+static void Send(DTC_SIM* dtc, IPC_FCB* fcb, const void* text, uint16_t textlen)
+{
+    uint8_t frame[IPC_FRAME_MAX];
+    size_t len;
+
+    len = IPC_FrameBuild(frame, fcb, text, textlen);
+
+    /* Frames are dropped if nothing is reading the slave side, the ARQ
+     * sends them again if it is on.
+     */
+    if ((write(dtc->fd, frame, len) != (ssize_t)len) && dtc->verbose)
+        printf("%9.3f tx frame dropped\n", dtc->sim.time);
+}
+
+//*****************************************************************************
+// Return the DTC lamp mask for a transport mode.
+//*****************************************************************************
+
+static uint32_t LampMask(uint32_t mode)
+{
+    uint32_t mask = 0;
+
+    switch(mode & MODE_MASK)
+    {
+    case MODE_HALT:
+    case MODE_STOP:
+        mask = DTC_L_STOP;
+        break;
+    case MODE_PLAY:
+        mask = DTC_L_PLAY;
+        break;
+    case MODE_FWD:
+        mask = DTC_L_FWD;
+        break;
+    case MODE_REW:
+        mask = DTC_L_REW;
+        break;
+    }
+
+    if (mode & M_RECORD)
+        mask |= DTC_L_REC;
+
+    return mask;
+}
+
+//*****************************************************************************
+// Print the transport state and the roller encoder count.
+//*****************************************************************************
+
+static void Status(DTC_SIM* dtc)
+{
+    printf("%9.3f mode %02x pos %9.2f vel %7.2f enc %7d rxerr %u\n",
+           dtc->sim.time, dtc->sim.mode, dtc->sim.pos, dtc->sim.vel,
+           TransportSim_encoder(&dtc->sim), BadFrames(&dtc->rxParser.stats));
+    fflush(stdout);
+}
+
+/* Frames received bad, of any kind */
+static uint32_t BadFrames(FRAME_STATS* stats)
+{
+    return stats->preamble + stats->length + stats->crc + stats->aborted;
+}
+
+/* Seconds from the monotonic clock */
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+/* ms from the monotonic clock, the ARQ time */
+static uint32_t Ms(void)
+{
+    return (uint32_t)(uint64_t)(Now() * 1000.0);
+}
+
+static void Usage(void)
+{
+    fprintf(stderr,
+            "usage: dtcsim [-s seed] [-p inches] [-l link] [-t ms] [-a] [-v]\n"
+            "  -s seed    machine variation seed (default 1)\n"
+            "  -p inches  starting tape position (default mid reel)\n"
+            "  -l link    symlink to make to the pty slave device\n"
+            "  -t ms      print the transport state every ms\n"
+            "  -a         run the link ARQ, for an STC built with it\n"
+            "  -v         log the frames sent and received\n");
+}
+
+/* End-Of-File */
@@ -0,0 +1,537 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Frame assembly test and benchmark. The IPC and RAMP frame builders in
+ * FrameBuild.c are checked byte for byte against the encoders they
+ * replaced, kept here as they were: IPC_FrameTx() and RAMP_TxFrame()
+ * writing the frame to the UART a byte at a time. The UART writes go to
+ * a capture buffer that counts the calls.
+ *
+ * Random frames of every type code and flag bits, with random sequence
+ * numbers, addresses and text, including no text, no text buffer and text
+ * too long to send, are built both ways. The bytes written and the frame
+ * type left in the FCB must match. Then frames of the sizes the firmware
+ * sends are encoded both ways and timed, with the UART writes each takes.
+ * The exit status is 1 if any frame differs.
+ *
+ * Usage:
+ *   framebench [-n frames] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "CRC16.h"
+#include "IPCFrameDefs.h"
+#include "RAMPFrameDefs.h"
+#include "FrameBuild.h"
+
+/* Handle of the stand-in UART the legacy senders write to */
+typedef void* BENCH_UART;
+
+/* Bytes in the IPC_MSG the IPC server sends */
+#define BENCH_IPC_MSG           12
+
+/* Text bytes in a RAMP display frame */
+#define BENCH_RAMP_DISPLAY      (1024 + 8)
+
+/* Frame sizes timed */
+typedef struct _BENCH_CASE {
+    const char* name;
+    bool        ramp;           /* RAMP frame, else IPC             */
+    uint8_t     type;           /* frame type code                  */
+    uint16_t    textlen;
+} BENCH_CASE;
+
+static const BENCH_CASE s_cases[] = {
+    { "IPC ACK",        false, IPC_ACK_ONLY, 0                  },
+    { "IPC message",    false, IPC_MSG_ACK,  BENCH_IPC_MSG      },
+    { "IPC max text",   false, IPC_MSG_ONLY, IPC_MAX_TEXT_LEN   },
+    { "RAMP ACK",       true,  TYPE_ACK_ONLY, 0                 },
+    { "RAMP display",   true,  TYPE_MSG_ONLY, BENCH_RAMP_DISPLAY },
+    { "RAMP max text",  true,  TYPE_MSG_ONLY, MAX_TEXT_LEN      },
+};
+
+/* UART capture */
+static uint8_t s_wire[RAMP_FRAME_MAX + IPC_FRAME_MAX];
+static size_t s_wireLen;
+static uint32_t s_writes;
+
+/* Static Function Prototypes */
+static int UART_write(BENCH_UART handle, const void* buffer, size_t size);
+static int LegacyIPCTx(BENCH_UART handle, IPC_FCB* fcb, void* txtbuf, uint16_t txtlen);
+static int LegacyRAMPTx(BENCH_UART handle, RAMP_FCB* fcb, void* text, uint16_t textlen);
+static uint32_t Compare(const char* name, uint32_t n, const uint8_t* frame, size_t len,
+                        uint8_t type, uint8_t legacyType);
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    static uint8_t text[MAX_TEXT_LEN + 1];
+    static uint8_t frame[RAMP_FRAME_MAX];
+    uint32_t frames = 100000;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t i, ops, writes, kind;
+    uint32_t checked[2] = { 0, 0 };
+    uint16_t textlen, maxlen;
+    size_t len, c;
+    uint8_t* txtbuf;
+    IPC_FCB ipc, ipcOld;
+    RAMP_FCB ramp, rampOld;
+    volatile size_t sink = 0;
+    double t, told, tnew;
+    int rc, opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            frames = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("frame check: %u random frames, seed %u\n", frames, seed);
+
+    for (i=0; i < sizeof(text); i++)
+        text[i] = (uint8_t)Random(&seed);
+
+    for (i=0; i < frames; i++)
+    {
+        bool isRamp = (i & 1) ? true : false;
+
+        maxlen = isRamp ? MAX_TEXT_LEN : IPC_MAX_TEXT_LEN;
+
+        /* Mostly the message sizes sent, some of any length and a few
+         * with no text, no text buffer or too much text.
+         */
+        switch (kind = Random(&seed) % 16)
+        {
+        case 0:
+            textlen = 0;
+            break;
+        case 1:
+            textlen = maxlen;
+            break;
+        case 2:
+            textlen = maxlen + 1;
+            break;
+        case 3:
+        case 4:
+        case 5:
+            textlen = isRamp ? BENCH_RAMP_DISPLAY : BENCH_IPC_MSG;
+            break;
+        default:
+            textlen = (uint16_t)(Random(&seed) % (maxlen + 1));
+            break;
+        }
+
+        txtbuf = (kind == 15) ? NULL : &text[Random(&seed) % (sizeof(text) - textlen + 1)];
+
+        s_wireLen = 0;
+        s_writes  = 0;
+
+        if (isRamp)
+        {
+            ramp.type    = (uint8_t)Random(&seed);
+            ramp.seqnum  = (uint8_t)Random(&seed);
+            ramp.acknak  = (uint8_t)Random(&seed);
+            ramp.address = (uint8_t)Random(&seed);
+            rampOld = ramp;
+
+            rc  = LegacyRAMPTx(NULL, &rampOld, txtbuf, textlen);
+            len = RAMP_FrameBuild(frame, &ramp, txtbuf, textlen);
+
+            if ((rc == ERR_SUCCESS) != (len != 0))
+                errors++;
+
+            if (rc == ERR_SUCCESS)
+                errors += Compare("RAMP", i, frame, len, ramp.type, rampOld.type);
+        }
+        else
+        {
+            ipc.type   = (uint8_t)Random(&seed);
+            ipc.seqnum = (uint8_t)Random(&seed);
+            ipc.acknak = (uint8_t)Random(&seed);
+            ipc.rsvd   = 0;
+            ipcOld = ipc;
+
+            rc  = LegacyIPCTx(NULL, &ipcOld, txtbuf, textlen);
+            len = IPC_FrameBuild(frame, &ipc, txtbuf, textlen);
+
+            if ((rc == IPC_ERR_SUCCESS) != (len != 0))
+                errors++;
+
+            if (rc == IPC_ERR_SUCCESS)
+                errors += Compare("IPC", i, frame, len, ipc.type, ipcOld.type);
+        }
+
+        checked[isRamp ? 1 : 0]++;
+    }
+
+    printf("%u IPC and %u RAMP frames checked, %u differ\n\n", checked[0], checked[1], errors);
+
+    /* Time each frame size both ways */
+    printf("%-14s %6s %12s %12s %10s %10s\n", "frame", "bytes",
+           "per byte ns", "buffer ns", "writes", "speedup");
+
+    for (c=0; c < sizeof(s_cases) / sizeof(s_cases[0]); c++)
+    {
+        const BENCH_CASE* bc = &s_cases[c];
+
+        ops = 50000000 / (bc->textlen + 16);
+
+        memset(&ipc, 0, sizeof(ipc));
+        memset(&ramp, 0, sizeof(ramp));
+
+        ipc.type  = bc->type;
+        ramp.type = bc->type;
+
+        /* The encoders as they were, a UART write a byte */
+        s_writes = 0;
+        t = Now();
+        for (i=0; i < ops; i++)
+        {
+            s_wireLen = 0;
+
+            if (bc->ramp)
+                LegacyRAMPTx(NULL, &ramp, text, bc->textlen);
+            else
+                LegacyIPCTx(NULL, &ipc, text, bc->textlen);
+
+            sink += s_wire[s_wireLen - 1];
+        }
+        told = Now() - t;
+        writes = s_writes / ops;
+
+        /* Built in the frame buffer and written once */
+        s_writes = 0;
+        t = Now();
+        for (i=0; i < ops; i++)
+        {
+            s_wireLen = 0;
+
+            if (bc->ramp)
+                len = RAMP_FrameBuild(frame, &ramp, text, bc->textlen);
+            else
+                len = IPC_FrameBuild(frame, &ipc, text, bc->textlen);
+
+            UART_write(NULL, frame, len);
+
+            sink += s_wire[s_wireLen - 1];
+        }
+        tnew = Now() - t;
+
+        printf("%-14s %6zu %12.1f %12.1f %4u -> %-3u %9.2fx\n", bc->name, len,
+               told * 1.0e9 / ops, tnew * 1.0e9 / ops, writes, s_writes / ops,
+               tnew ? (told / tnew) : 0.0);
+    }
+
+    printf("\nper byte/buffer ns: host time to encode and write one frame\n");
+    printf("writes: UART_write() calls per frame, each a driver call and\n");
+    printf("semaphore wait for the uDMA transfer on the STC\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Capture the bytes written, as the UART would send them */
+static int UART_write(BENCH_UART handle, const void* buffer, size_t size)
+{
+    (void)handle;
+
+    memcpy(&s_wire[s_wireLen], buffer, size);
+
+    s_wireLen += size;
+    s_writes++;
+
+    return (int)size;
+}
+
+/* Check a frame built against the bytes the old encoder wrote */
+static uint32_t Compare(const char* name, uint32_t n, const uint8_t* frame, size_t len,
+                        uint8_t type, uint8_t legacyType)
+{
+    size_t i;
+
+    if ((len == s_wireLen) && !memcmp(frame, s_wire, len) && (type == legacyType))
+        return 0;
+
+    for (i=0; (i < len) && (i < s_wireLen); i++)
+    {
+        if (frame[i] != s_wire[i])
+            break;
+    }
+
+    printf("%s frame %u differs: %zu bytes against %zu, first at %zu, type %02X against %02X\n",
+           name, n, len, s_wireLen, i, type, legacyType);
+
+    return 1;
+}
+
+/* IPC_FrameTx() as it was, writing the frame a byte at a time */
+static int LegacyIPCTx(BENCH_UART handle, IPC_FCB* fcb, void* txtbuf, uint16_t txtlen)
+{
+    uint8_t b;
+    uint8_t type;
+    uint16_t i;
+    uint16_t framelen;
+    uint16_t crc;
+
+    uint8_t *textbuf = txtbuf;
+    uint16_t textlen = txtlen;
+
+    /* First check the text length is valid */
+    if (textlen > IPC_MAX_TEXT_LEN)
+        return IPC_ERR_TEXT_LEN;
+
+    /* Get the frame type less any flag bits */
+    type = (fcb->type & IPC_TYPE_MASK);
+
+    /* Are we sending a ACK or NAK only frame? */
+    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
+    {
+        textbuf = NULL;
+        textlen = 0;
+
+        framelen = IPC_ACK_FRAME_LEN;
+
+        /* Set the ACK/NAK flag bit */
+        fcb->type |= IPC_F_ACKNAK;
+    }
+    else
+    {
+        /* Build the frame length with text length given */
+        framelen = textlen + (IPC_FRAME_OVERHEAD - IPC_PREAMBLE_OVERHEAD);
+
+        /* If message is piggyback ACK/NAK, set flag bit also */
+        if ((type == IPC_MSG_ACK) || (type == IPC_MSG_NAK))
+            fcb->type |= IPC_F_ACKNAK;
+        else
+            fcb->type &= ~(IPC_F_ACKNAK);
+    }
+
+    b = IPC_PREAMBLE_MSB;
+    UART_write(handle, &b, 1);
+
+    b = IPC_PREAMBLE_LSB;
+    UART_write(handle, &b, 1);
+
+    crc = CRC16Update(0, IPC_CRC_SEED_BYTE);
+
+    b = (uint8_t)((framelen >> 8) & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(framelen & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(fcb->type & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
+    {
+        b = (uint8_t)(fcb->acknak & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+    }
+    else
+    {
+        b = (uint8_t)(fcb->seqnum & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        b = (uint8_t)(fcb->acknak & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        b = (uint8_t)((textlen >> 8) & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        b = (uint8_t)(textlen & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        if (textbuf && textlen)
+        {
+            for (i=0; i < textlen; i++)
+            {
+                b = *textbuf++;
+                crc = CRC16Update(crc, b);
+                UART_write(handle, &b, 1);
+            }
+        }
+    }
+
+    b = (uint8_t)(crc >> 8);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(crc & 0xFF);
+    UART_write(handle, &b, 1);
+
+    return IPC_ERR_SUCCESS;
+}
+
+/* RAMP_TxFrame() as it was, writing the header a byte at a time */
+static int LegacyRAMPTx(BENCH_UART handle, RAMP_FCB* fcb, void* text, uint16_t textlen)
+{
+    uint8_t b;
+    uint8_t type;
+    uint16_t i;
+    uint16_t framelen;
+    uint16_t crc = 0;
+    uint8_t *textbuf = (uint8_t*)text;
+
+    /* First check the text length is valid */
+    if (textlen > MAX_TEXT_LEN)
+        return ERR_TEXT_LEN;
+
+    /* Get the frame type less any flag bits */
+    type = (fcb->type & FRAME_TYPE_MASK);
+
+    /* Are we sending a ACK or NAK only frame? */
+    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
+    {
+        textbuf = NULL;
+        textlen = 0;
+
+        framelen = ACK_FRAME_LEN;
+
+        /* Set the ACK/NAK flag bit */
+        fcb->type |= F_ACKNAK;
+    }
+    else
+    {
+        framelen = textlen + (FRAME_OVERHEAD - PREAMBLE_OVERHEAD);
+
+        /* If message is piggyback ACK/NAK, set flag bit also */
+        if ((type == TYPE_MSG_ACK) || (type == TYPE_MSG_NAK))
+            fcb->type |= F_ACKNAK;
+        else
+            fcb->type &= ~(F_ACKNAK);
+    }
+
+    b = PREAMBLE_MSB;
+    UART_write(handle, &b, 1);
+
+    b = PREAMBLE_LSB;
+    UART_write(handle, &b, 1);
+
+    crc = CRC16Update(crc, CRC_SEED_BYTE);
+
+    b = (uint8_t)((framelen >> 8) & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(framelen & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(fcb->type & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(fcb->address & 0xFF);
+    crc = CRC16Update(crc, b);
+    UART_write(handle, &b, 1);
+
+    if ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY))
+    {
+        b = (uint8_t)(fcb->acknak & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+    }
+    else
+    {
+        b = (uint8_t)(fcb->seqnum & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        b = (uint8_t)(fcb->acknak & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        b = (uint8_t)((textlen >> 8) & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        b = (uint8_t)(textlen & 0xFF);
+        crc = CRC16Update(crc, b);
+        UART_write(handle, &b, 1);
+
+        /* The text block went out in one write */
+        if (textbuf && textlen)
+        {
+            UART_write(handle, textbuf, textlen);
+
+            for (i=0; i < textlen; i++)
+                crc = CRC16Update(crc, *textbuf++);
+        }
+    }
+
+    b = (uint8_t)(crc >> 8);
+    UART_write(handle, &b, 1);
+
+    b = (uint8_t)(crc & 0xFF);
+    UART_write(handle, &b, 1);
+
+    return ERR_SUCCESS;
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (*seed = x);
+}
+
+/* End-Of-File */
@@ -0,0 +1,406 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Roller index pulse check test. First, short scripted sequences of index
+ * pulses are given to IndexCheck_update() and each return checked: the
+ * index phase must be learned for each direction only once INDEX_VOTES of
+ * INDEX_WINDOW pulses agree, and a miscount corrected only once it has the
+ * same vote, with one odd pulse in the window let through.
+ *
+ * Then the roller is run back and forth in play and shuttle, the index
+ * edge being seen a few ticks apart in each direction. Interrupt latency
+ * now and then has the count sampled a tick late. Encoder miscounts are
+ * put in one at a time, and some cases drop index pulses or add spurious
+ * ones at a random roller angle. Every miscount must be corrected within
+ * a few revolutions, no correction may ever move the position further
+ * off, and a clean run must make no corrections. A miscount too large to
+ * be one is to be rejected. The exit status is 1 if any check fails.
+ *
+ * Usage:
+ *   indexbench [-n revolutions] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "TapeTime.h"
+#include "IndexCheck.h"
+
+/* Encoder ticks per inch of tape */
+#define TICKS_PER_INCH          (ROLLER_TICKS_PER_REV / 5.0014)
+
+/* The reverse index edge is seen this many ticks before the forward one */
+#define REW_EDGE                3
+
+/* Simulation step in seconds */
+#define STEP                    0.0001
+
+/* A miscount must be corrected within this many index pulses */
+#define CORRECT_PULSES          (INDEX_WINDOW * 2)
+
+/* A scripted index pulse and the correction expected for it */
+typedef struct _PULSE {
+    int32_t     dir;
+    int32_t     phase;
+    int32_t     expect;
+} PULSE;
+
+typedef struct _SCRIPT {
+    const char* name;
+    const PULSE* pulse;
+    size_t      count;
+    bool        fwdValid;           /* phases learned at the end     */
+    bool        rewValid;
+} SCRIPT;
+
+/* Forward phase 0 with one odd pulse among the five */
+static const PULSE s_learnFwd[] = {
+    { 1, 0, 0 }, { 1, 0, 0 }, { 1, 5, 0 }, { 1, 0, 0 }, { 1, 0, 0 },
+};
+
+/* Only three of five agree, so nothing is learned */
+static const PULSE s_noVote[] = {
+    { 1, 0, 0 }, { 1, 2, 0 }, { 1, 0, 0 }, { 1, 7, 0 }, { 1, 0, 0 },
+};
+
+/* Each direction learns its own phase and switching is not a miscount */
+static const PULSE s_bothWays[] = {
+    {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 },
+    { -1, 77, 0 }, { -1, 77, 0 }, { -1, 77, 0 }, { -1, 77, 0 }, { -1, 77, 0 },
+    {  1, 0, 0 }, {  1, 0, 0 }, { -1, 77, 0 }, {  1, 0, 0 }, { -1, 77, 0 },
+    {  1, 0, 0 }, { -1, 77, 0 }, {  1, 0, 0 }, { -1, 77, 0 }, {  1, 0, 0 },
+};
+
+/* A +2 miscount is taken out once four of the first five pulses after
+ * learning agree, with an odd pulse among them and across a direction
+ * change.
+ */
+static const PULSE s_miscount[] = {
+    {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 },
+    { -1, 77, 0 }, { -1, 77, 0 }, { -1, 77, 0 }, { -1, 77, 0 }, { -1, 77, 0 },
+    {  1, 2, 0 }, {  1, 6, 0 }, { -1, 79, 0 }, {  1, 2, 0 }, { -1, 79, -2 },
+    {  1, 2, 0 }, { -1, 79, 0 }, {  1, 2, 0 }, {  1, 2, 0 }, {  1, 2, 0 },
+};
+
+/* A miscount confirmed before the reverse phase is learned is taken out
+ * of the reverse phase.
+ */
+static const PULSE s_learnLate[] = {
+    {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 },
+    {  1, 79, 0 }, {  1, 79, 0 }, {  1, 79, 0 }, {  1, 79, 0 }, {  1, 79, 1 },
+    { -1, 76, 0 }, { -1, 76, 0 }, { -1, 76, 0 }, { -1, 76, 0 }, { -1, 76, 0 },
+    { -1, 76, 0 }, {  1, 79, 0 }, { -1, 76, 0 }, {  1, 79, 0 }, { -1, 76, 0 },
+};
+
+/* Pulses too far out to be a miscount are rejected */
+static const PULSE s_fault[] = {
+    {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 },
+    {  1, 12, 0 }, {  1, 12, 0 }, {  1, 12, 0 }, {  1, 12, 0 }, {  1, 12, 0 },
+    {  1, 40, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 }, {  1, 0, 0 },
+};
+
+#define SCRIPT(s, f, r)     { #s, s, sizeof(s) / sizeof(s[0]), f, r }
+
+static const SCRIPT s_scripts[] = {
+    SCRIPT(s_learnFwd,  true,  false),
+    SCRIPT(s_noVote,    false, false),
+    SCRIPT(s_bothWays,  true,  true),
+    SCRIPT(s_miscount,  true,  true),
+    SCRIPT(s_learnLate, true,  true),
+    SCRIPT(s_fault,     true,  false),
+};
+
+#define NUM_SCRIPTS (sizeof(s_scripts) / sizeof(s_scripts[0]))
+
+/* A roller run */
+typedef struct _CASE {
+    const char* name;
+    bool        shuttle;            /* change direction and speed    */
+    double      miscountRevs;       /* revolutions between miscounts */
+    int32_t     miscountMin;        /* ticks either way, from        */
+    int32_t     miscountMax;        /* and up to                     */
+    double      lateRate;           /* pulses sampled a tick late    */
+    double      missRate;           /* index pulses lost             */
+    double      spuriousRate;       /* extra pulses a revolution     */
+} CASE;
+
+static const CASE s_cases[] = {
+    { "clean play",         false,   0.0,  0,  0, 0.00, 0.00, 0.00 },
+    { "clean shuttle",      true,    0.0,  0,  0, 0.02, 0.00, 0.00 },
+    { "miscounts",          true,   40.0,  1,  3, 0.02, 0.00, 0.00 },
+    { "missing 10%",        true,   40.0,  1,  3, 0.02, 0.10, 0.00 },
+    { "spurious 10%",       true,   40.0,  1,  3, 0.02, 0.00, 0.10 },
+    { "missing+spurious",   true,   40.0,  1,  3, 0.02, 0.10, 0.10 },
+    { "too large",          true,   40.0, 12, 20, 0.02, 0.00, 0.00 },
+};
+
+#define NUM_CASES   (sizeof(s_cases) / sizeof(s_cases[0]))
+
+/* Static Function Prototypes */
+static bool Script(const SCRIPT* s);
+static bool Run(const CASE* c, uint32_t revs, uint32_t* seed);
+static double Uniform(uint32_t* seed);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t revs = 5000;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            revs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n revolutions] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("index check: %d of %d votes, %d ticks a turn, max error %d, seed %u\n\n",
+           INDEX_VOTES, INDEX_WINDOW, ROLLER_TICKS_PER_REV, INDEX_MAX_ERROR, seed);
+
+    printf("%-18s %6s %6s\n", "script", "pulses", "check");
+
+    for (i=0; i < NUM_SCRIPTS; i++)
+    {
+        if (!Script(&s_scripts[i]))
+            errors++;
+    }
+
+    printf("\n%-18s %6s %6s %6s %6s %6s %6s %6s %6s\n", "case", "revs", "put", "fixed",
+           "worst", "wrong", "faults", "off", "check");
+
+    for (i=0; i < NUM_CASES; i++)
+    {
+        if (!Run(&s_cases[i], revs, &seed))
+            errors++;
+    }
+
+    printf("\nput: miscounts put in, fixed: corrected, worst: most index pulses to\n");
+    printf("correct one, wrong: corrections that moved the position further off,\n");
+    printf("faults: pulses rejected, off: ticks the position is off at the end\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Give a scripted pulse sequence. Returns false if a return is wrong. */
+static bool Script(const SCRIPT* s)
+{
+    INDEX_CHECK ic;
+    int32_t raw;
+    size_t i;
+    bool ok = true;
+
+    IndexCheck_init(&ic);
+
+    for (i=0; i < s->count; i++)
+    {
+        raw = (int32_t)(((int32_t)i - 10) * ROLLER_TICKS_PER_REV) + s->pulse[i].phase;
+
+        if (IndexCheck_update(&ic, raw, s->pulse[i].dir) != s->pulse[i].expect)
+            ok = false;
+    }
+
+    if ((ic.refValid[0] != s->fwdValid) || (ic.refValid[1] != s->rewValid))
+        ok = false;
+
+    printf("%-18s %6zu %6s\n", s->name + 2, s->count, ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+/* Run the roller. Returns false if a check fails. */
+static bool Run(const CASE* c, uint32_t revs, uint32_t* seed)
+{
+    INDEX_CHECK ic;
+    double x = 1000.25 * ROLLER_TICKS_PER_REV;
+    double v = 30.0 * TICKS_PER_INCH;
+    double segment = 0.0;
+    double edge = 0.0;
+    int64_t turn, last;
+    int32_t miscount = 0;
+    int32_t applied = 0;
+    int32_t off, before, corr, raw, ticks;
+    uint32_t turns = 0;
+    uint32_t put = 0, fixed = 0, wrong = 0;
+    uint32_t pulses = 0, worst = 0;
+    bool waiting = false;
+    bool ok = true;
+
+    IndexCheck_init(&ic);
+
+    last = (int64_t)floor(x / ROLLER_TICKS_PER_REV);
+
+    while (turns < revs)
+    {
+        /* Change speed and direction every few revolutions */
+        if (c->shuttle && (segment <= 0.0))
+        {
+            segment = (3.0 + (Uniform(seed) * 40.0)) * ROLLER_TICKS_PER_REV;
+            v = ((Random(seed) % 3) ? 380.0 : 30.0) * TICKS_PER_INCH;
+
+            if (Random(seed) % 2)
+                v = -v;
+
+            /* The edge moves with the direction, which is not a pulse */
+            edge = (v > 0.0) ? 0.0 : -REW_EDGE;
+            last = (int64_t)floor((x - edge) / ROLLER_TICKS_PER_REV);
+        }
+
+        x += v * STEP;
+        segment -= fabs(v * STEP);
+
+        turn = (int64_t)floor((x - edge) / ROLLER_TICKS_PER_REV);
+
+        if (turn == last)
+            continue;
+
+        last = turn;
+        turns++;
+
+        /* An encoder miscount now and then once both phases are learned */
+        if ((c->miscountRevs > 0.0) && !waiting && ic.refValid[0] && ic.refValid[1] &&
+            (Uniform(seed) < (1.0 / c->miscountRevs)))
+        {
+            ticks = c->miscountMin + (int32_t)(Random(seed) %
+                                               (c->miscountMax - c->miscountMin + 1));
+
+            miscount += (Random(seed) % 2) ? ticks : -ticks;
+
+            waiting = true;
+            pulses = 0;
+            put++;
+        }
+
+        /* A spurious pulse at any roller angle */
+        if (Uniform(seed) < c->spuriousRate)
+        {
+            raw = (int32_t)floor(x) + miscount + (int32_t)(Random(seed) % ROLLER_TICKS_PER_REV);
+
+            before = miscount + applied;
+            corr = IndexCheck_update(&ic, raw, (v > 0.0) ? 1 : -1);
+            applied += corr;
+
+            if (corr && (abs(miscount + applied) >= abs(before)))
+                wrong++;
+        }
+
+        if (Uniform(seed) < c->missRate)
+            continue;
+
+        /* The count at the edge, or the next if the sample was late */
+        raw = (int32_t)((turn + ((v > 0.0) ? 0 : 1)) * ROLLER_TICKS_PER_REV) + (int32_t)edge +
+              miscount;
+
+        if (Uniform(seed) < c->lateRate)
+            raw += (v > 0.0) ? 1 : -1;
+
+        before = miscount + applied;
+        corr = IndexCheck_update(&ic, raw, (v > 0.0) ? 1 : -1);
+        applied += corr;
+
+        off = miscount + applied;
+
+        if (corr && (abs(off) >= abs(before)))
+            wrong++;
+
+        if (!waiting)
+            continue;
+
+        pulses++;
+
+        if (off == 0)
+        {
+            fixed++;
+            waiting = false;
+
+            if (pulses > worst)
+                worst = pulses;
+        }
+    }
+
+    off = miscount + applied;
+
+    if (wrong)
+        ok = false;
+
+    if (c->miscountMax > INDEX_MAX_ERROR)
+    {
+        /* Never corrected, only rejected */
+        if (applied || !ic.stats.faults)
+            ok = false;
+    }
+    else
+    {
+        if ((fixed + (waiting ? 1 : 0)) != put)
+            ok = false;
+
+        if (worst > CORRECT_PULSES)
+            ok = false;
+
+        if (!c->miscountRevs && (ic.stats.corrections || ic.stats.faults))
+            ok = false;
+
+        if (!c->spuriousRate && !waiting && off)
+            ok = false;
+    }
+
+    printf("%-18s %6u %6u %6u %6u %6u %6u %6d %6s\n", c->name, turns, put, fixed, worst, wrong,
+           ic.stats.faults, off, ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+/* Uniform in [0, 1) */
+static double Uniform(uint32_t* seed)
+{
+    return (double)Random(seed) / 4294967296.0;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
@@ -0,0 +1,1790 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Locate benchmark. Runs randomized locates against the simulated
+ * transport in simulated time, using the firmware locate planner, final
+ * approach servo and motion estimator built for the host. The locate loop
+ * below follows LocateTaskFxn(): it wakes on each new encoder sample or
+ * when the planner deadline runs out, predicts the tape position from the
+ * motion estimate, runs the planner and sends the planner's actions to the
+ * DTC as LocateAction() does. With -t it wakes every 1 ms instead, as the
+ * locate loop used to. The encoder is sampled as
+ * the QEI interrupt does: on the 25 ms velocity timer, at the roller
+ * index pulse and on a change of direction, with a poll sample when the
+ * position task has had none for 5 ms.
+ *
+ * For each locate it reports the time to the cue point, how far the tape
+ * went past the cue point, the stop error and the number of times the
+ * tape changed direction. The host CPU time spent in the locate loop and
+ * the number of times it woke are measured as well. The first locates of
+ * a run can be left out of the results while the planner learns the
+ * simulated machine. Each locate is also run from the same start on a copy
+ * of the machine with the locate state machine the planner replaced, which
+ * shuttles at a jog velocity picked by distance, brakes at fixed times to
+ * the cue and stops a fixed time short of it, waking every 1 ms.
+ *
+ * With -q the cue list sequencer is run instead: after the warmup locates
+ * the same cue lists of locate and timed play steps are run twice on the
+ * simulated machine. The first run locates straight on from the play
+ * segment before as the locate task does. The second stops the tape first
+ * as a separate locate request would. It reports how long each play
+ * segment really played for against its step time, the time taken to get
+ * from one segment to the next and the planned ETA error for that. The
+ * exit status is 1 if the mean play time error is over BENCH_SEQ_TOL.
+ *
+ * With -p auto punches are run instead: after the warmup locates each
+ * punch locates to the pre-roll point, plays and punches in and out of
+ * record with the firmware auto-punch timing, as the locate task does.
+ * The same punch is run four ways on the same machine: waking on each
+ * encoder sample or the punch deadline with the learned punch lag as the
+ * lead, waking on encoder samples only, with the locate planner command
+ * lag as the lead and with no lead. The punch lag is learned from the
+ * time the machine takes to go in and out of record. It reports
+ * the error in ms between the tape reaching each punch point and record
+ * starting or ending there, + is late. The exit status is 1 if the mean
+ * |error| waking on the deadline is over BENCH_PUNCH_TOL.
+ *
+ * With -l loops are run instead: after the warmup locates each loop is run
+ * round several passes two ways on the same machine. The first turns
+ * around with the firmware loop timing, locates back to the pre-roll point
+ * and sends play while the tape is still heading back, as the locate task
+ * does. The second turns around at the fixed time from mark-out and stops
+ * on mark-in before each pass, as the locate task used to. It reports the
+ * cycle time between mark-in crossings, the dead time in each cycle, the
+ * tape speed at mark-in and how much of the loop is cut at each end. The
+ * exit status is 1 if the pre-roll doesn't cut the dead time or too many
+ * passes reach mark-in below play speed.
+ *
+ * Usage:
+ *   locbench [-n locates] [-s seed] [-w warmup] [-L] [-t] [-c file.csv]
+ *   locbench -q segments [-s seed] [-w warmup]
+ *   locbench -p punches [-s seed] [-w warmup]
+ *   locbench -l loops [-s seed] [-w warmup]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+
+/* XDC types used by the firmware headers */
+typedef bool        Bool;
+typedef void        Void;
+typedef uintptr_t   UArg;
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "MotionEst.h"
+#include "LocatePlan.h"
+#include "LocateTask.h"
+#include "CueSeq.h"
+#include "AutoPunch.h"
+#include "LoopPlan.h"
+#include "IPCMessage.h"
+#include "TransportSim.h"
+
+/* Locate task period, position task poll period and QEI velocity timer
+ * period in seconds.
+ */
+#define BENCH_TASK_PERIOD       0.001
+#define BENCH_POLL_PERIOD       0.005
+#define BENCH_TIMER_PERIOD      0.025
+
+/* Give up on a locate after this many seconds */
+#define BENCH_TIMEOUT           180.0
+
+/* Stops further than this past the cue point count as an overshoot */
+#define BENCH_OVERSHOOT         0.25
+
+/* Tape speed below which a direction change is not counted */
+#define BENCH_REVERSE_VEL       0.5
+
+/* Results are also broken down by the locate distance in inches */
+#define BENCH_BANDS             4
+
+/* Cue list sequence segments are this many seconds of play, with the cue
+ * points up to BENCH_SEQ_DIST inches from the end of the last segment.
+ * Each run of the cue list uses each user cue point once.
+ */
+#define BENCH_SEQ_PLAY_MIN      1.0
+#define BENCH_SEQ_PLAY_MAX      10.0
+#define BENCH_SEQ_DIST          3000.0
+#define BENCH_SEQ_SEGS          STC_USER_CUE_POINTS
+
+/* Largest mean play time error in seconds the sequencer test passes */
+#define BENCH_SEQ_TOL           0.020
+
+/* Auto punch pre-roll seconds and post-roll ms. The punch points are up
+ * to BENCH_SEQ_DIST inches from the tape position and the record passes
+ * are BENCH_PUNCH_MIN to BENCH_PUNCH_MAX seconds long.
+ */
+#define BENCH_PUNCH_PREROLL     3.0f
+#define BENCH_PUNCH_POSTROLL    500
+#define BENCH_PUNCH_MIN         2.0
+#define BENCH_PUNCH_MAX         20.0
+
+/* Longest ms the punch loop sleeps, as LOCATE_WAIT_MAX in the locate task */
+#define BENCH_WAIT_MAX          50
+
+/* Largest mean |punch error| in seconds the punch test passes */
+#define BENCH_PUNCH_TOL         0.005
+
+/* Loops are BENCH_LOOP_MIN to BENCH_LOOP_MAX seconds of play, up to
+ * BENCH_SEQ_DIST inches from the tape position, and each is run round
+ * BENCH_LOOP_PASSES times. The locate task used to turn around once the
+ * tape was BENCH_LOOP_MARK_OUT seconds from mark-out. The loop test passes
+ * if the pre-roll leaves less dead time and no more than BENCH_LOOP_SLOW of
+ * its passes cross mark-in below play speed.
+ */
+#define BENCH_LOOP_MIN          2.0
+#define BENCH_LOOP_MAX          20.0
+#define BENCH_LOOP_PASSES       5
+#define BENCH_LOOP_MARK_OUT     0.250
+#define BENCH_LOOP_AT_SPEED     LOOP_AT_SPEED
+#define BENCH_LOOP_SLOW         0.05
+
+/* The locate state machine before the planner. The times are the seconds
+ * left to reach the cue point at the current tape velocity, the distances
+ * encoder ticks and the velocities IPS.
+ */
+#define LEGACY_DIST_FAR         9000        /* far jog velocity above    */
+#define LEGACY_DIST_MID         3000        /* mid jog velocity above    */
+#define LEGACY_TIME_FAR         3.250f      /* begin braking from far    */
+#define LEGACY_TIME_MID         1.750f      /* begin braking from mid    */
+#define LEGACY_TIME_NEAR        0.750f      /* begin braking from near   */
+#define LEGACY_TIME_ARRIVE      0.375f      /* stop at the cue point     */
+#define LEGACY_VEL_MIN          2.5f        /* floor for time estimates  */
+#define LEGACY_VEL_BRAKE        87.5f       /* brake state above this    */
+#define LEGACY_VEL_DYNAMIC      75.0f       /* dynamic brake above this  */
+#define LEGACY_VEL_SLOW         100.0f      /* slow shuttle below this   */
+
+typedef enum _LEGACY_STATE {
+    LEGACY_START,
+    LEGACY_SEARCH_FAR,
+    LEGACY_SEARCH_MID,
+    LEGACY_SEARCH_NEAR,
+    LEGACY_BRAKE_STATE,
+    LEGACY_BRAKE_VELOCITY,
+    LEGACY_ZERO_CROSS,
+} LEGACY_STATE;
+
+/* Ways the punch is timed for comparison */
+#define BENCH_PUNCH_DEADLINE    0           /* samples and deadline       */
+#define BENCH_PUNCH_SAMPLE      1           /* samples only               */
+#define BENCH_PUNCH_PLANLAG     2           /* planner lag as the lead    */
+#define BENCH_PUNCH_NOLEAD      3           /* no lead                    */
+#define BENCH_PUNCH_MODES       4
+
+static const double s_bandLimit[BENCH_BANDS] = { 200.0, 2000.0, 10000.0, 1.0e9 };
+static const char* s_bandName[BENCH_BANDS] = { "<200in", "200-2000in", "2000-10000in", ">10000in" };
+static const char* s_punchName[BENCH_PUNCH_MODES] = { "deadline", "samples", "planner lag", "no lead" };
+
+typedef struct _LOCATE_RESULT {
+    double      distance;       /* inches from the start to the cue */
+    double      time;           /* seconds to arrive at the cue     */
+    double      eta;            /* seconds the planner first gave   */
+    double      error;          /* stop error, + is past the cue    */
+    double      overshoot;      /* furthest past the cue, inches    */
+    uint32_t    reversals;      /* tape direction changes           */
+    uint32_t    speed;          /* jog velocity index used          */
+    uint32_t    retries;        /* planner approach retries         */
+    uint32_t    wakes;          /* times the locate loop ran        */
+    double      cpu;            /* seconds of host CPU in the loop  */
+    bool        timeout;        /* locate never arrived             */
+    bool        played;         /* play sent on the way round a loop */
+} LOCATE_RESULT;
+
+/* QEI sample state */
+typedef struct _BENCH_QEI {
+    int32_t     count;          /* encoder count last step          */
+    int         dir;            /* direction of the last count      */
+    double      sampleTime;     /* time of the last sample          */
+    double      timerTime;      /* time of the last velocity timer  */
+} BENCH_QEI;
+
+typedef struct _BENCH_STATS {
+    uint32_t    count;
+    uint32_t    timeouts;
+    uint32_t    overshoots;
+    uint32_t    reversed;
+    uint32_t    reversals;
+    double      time;
+    double      timeMax;
+    double      etaError;
+    double      error;
+    double      errorMax;
+    double      overshoot;
+    double      overshootMax;
+    double      wakes;
+    double      cpu;
+    double*     times;
+    bool        legacy;         /* no ETA from the old locator      */
+} BENCH_STATS;
+
+typedef struct _SEQ_STATS {
+    uint32_t    count;          /* play segments measured           */
+    double      error;          /* sum of play time errors          */
+    double      errorAbs;       /* sum of |play time error|         */
+    double      errorMax;       /* largest |play time error|        */
+    double      move;           /* sum of seconds between segments  */
+    double      moveMax;        /* longest time between segments    */
+    double      etaError;       /* sum of |planned - actual move|   */
+    uint32_t    moves;          /* moves between segments measured  */
+    double      stop;           /* sum of |stop error| at the cues  */
+} SEQ_STATS;
+
+typedef struct _LOOP_STATS {
+    uint32_t    cycles;         /* passes timed mark-in to mark-in  */
+    double      cycle;          /* sum of seconds per pass          */
+    double      cycleMax;       /* longest pass                     */
+    double      loop;           /* sum of seconds of loop per pass  */
+    uint32_t    starts;         /* passes started at mark-in        */
+    double      inVel;          /* sum of IPS at mark-in            */
+    uint32_t    slow;           /* passes below play speed at mark-in */
+    double      startLost;      /* sum of seconds from mark-in to speed */
+    uint32_t    ends;           /* passes ended at mark-out         */
+    double      endLost;        /* sum of seconds cut before mark-out */
+} LOOP_STATS;
+
+/* Static Function Prototypes */
+static void Loop(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                 bool learn, bool optimize, double in, double out, uint32_t passes,
+                 LOOP_STATS* stats);
+static void LoopPrint(const char* name, LOOP_STATS* stats);
+static bool Punch(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                  bool learn, uint32_t mode, double in, double out, double* err);
+static void PunchPrint(const char* name, const char* edge, double* err, uint32_t n, double ips);
+static void Sequence(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                     bool learn, bool follow, CUE_SEQ* seq, const double* cues,
+                     SEQ_STATS* stats);
+static double SeqPlan(STC_LOCATE_MODEL* model, double pos, double cue);
+static void SeqPrint(const char* name, SEQ_STATS* stats);
+static void Locate(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                   bool learn, bool tick, double cue, LOOP_PLAN* loop,
+                   LOCATE_RESULT* result);
+static void Legacy(TRANSPORT_SIM* sim, MOTION_EST* est, double cue, LOCATE_RESULT* result);
+static void LegacyShuttle(TRANSPORT_SIM* sim, int32_t dir, uint32_t velocity);
+static bool Step(TRANSPORT_SIM* sim, MOTION_EST* est, BENCH_QEI* qei);
+static double CpuTime(void);
+static bool Action(TRANSPORT_SIM* sim, LOCATE_PLAN* plan, PLAN_ACTION action);
+static void StatsAdd(BENCH_STATS* stats, LOCATE_RESULT* result);
+static void StatsPrint(const char* name, BENCH_STATS* stats);
+/* Seconds of CPU time used by this thread */
+static double CpuTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+static int CompareDouble(const void* a, const void* b);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    TRANSPORT_SIM sim;
+    MOTION_EST est;
+    STC_LOCATE_MODEL model;
+    LOCATE_RESULT result;
+    BENCH_STATS all;
+    BENCH_STATS band[BENCH_BANDS];
+    BENCH_STATS oldAll;
+    BENCH_STATS oldBand[BENCH_BANDS];
+    TRANSPORT_SIM simOld;
+    MOTION_EST estOld;
+    FILE* csv = NULL;
+    uint32_t locates = 2000;
+    uint32_t segments = 0;
+    uint32_t punches = 0;
+    uint32_t loops = 0;
+    uint32_t warmup = 100;
+    uint32_t seed = 1;
+    bool learn = true;
+    bool tick = false;
+    uint32_t i, b;
+    double cue;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:w:Ltc:q:p:l:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            locates = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            warmup = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'L':
+            learn = false;
+            break;
+        case 't':
+            tick = true;
+            break;
+        case 'q':
+            segments = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            punches = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            loops = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            if ((csv = fopen(optarg, "w")) == NULL)
+            {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n locates] [-s seed] [-w warmup] [-L] [-t] [-c file.csv] [-q segments] [-p punches] [-l loops]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    memset(&all, 0, sizeof(all));
+    memset(band, 0, sizeof(band));
+    memset(&oldAll, 0, sizeof(oldAll));
+    memset(oldBand, 0, sizeof(oldBand));
+
+    all.times    = calloc(locates + 1, sizeof(double));
+    oldAll.times = calloc(locates + 1, sizeof(double));
+    oldAll.legacy = true;
+
+    for (b=0; b < BENCH_BANDS; b++)
+    {
+        band[b].times    = calloc(locates + 1, sizeof(double));
+        oldBand[b].times = calloc(locates + 1, sizeof(double));
+        oldBand[b].legacy = true;
+    }
+
+    /* Start mid tape on a freshly seeded machine */
+    TransportSim_init(&sim, seed, SIM_TAPE_LENGTH * 0.5);
+
+    MotionEst_init(&est, 1000000, SIM_ROLLER_CIRCUM / SIM_ROLLER_TICKS);
+
+    LocatePlan_initModel(&model);
+
+    if (csv)
+        fprintf(csv, "locate,distance,speed,time,eta,error,overshoot,reversals,retries,timeout\n");
+
+    /* The sequencer, punches and loops run after the warmup locates */
+    if (segments || punches || loops)
+        locates = 0;
+
+    for (i=0; i < (warmup + locates); i++)
+    {
+        /* Pick a cue point with distances spread evenly on a log scale */
+        do {
+            double dist = exp(log(10.0) + (TransportSim_random(&sim) * (log(30000.0) - log(10.0))));
+            cue = sim.roller + ((TransportSim_random(&sim) < 0.5) ? dist : -dist);
+        } while ((cue < 500.0) || (cue > (SIM_TAPE_LENGTH - 500.0)));
+
+        /* The old locator from the same start on the same machine */
+        if (i >= warmup)
+        {
+            simOld = sim;
+            estOld = est;
+
+            Legacy(&simOld, &estOld, cue, &result);
+
+            StatsAdd(&oldAll, &result);
+
+            for (b=0; b < (BENCH_BANDS - 1); b++)
+            {
+                if (result.distance < s_bandLimit[b])
+                    break;
+            }
+
+            StatsAdd(&oldBand[b], &result);
+        }
+
+        Locate(&sim, &est, &model, learn, tick, cue, NULL, &result);
+
+        if (i < warmup)
+            continue;
+
+        if (csv)
+        {
+            fprintf(csv, "%u,%.2f,%u,%.3f,%.3f,%.3f,%.3f,%u,%u,%u\n", i - warmup,
+                    result.distance, result.speed, result.time, result.eta,
+                    result.error, result.overshoot, result.reversals,
+                    result.retries, result.timeout);
+        }
+
+        StatsAdd(&all, &result);
+
+        for (b=0; b < (BENCH_BANDS - 1); b++)
+        {
+            if (result.distance < s_bandLimit[b])
+                break;
+        }
+
+        StatsAdd(&band[b], &result);
+    }
+
+    if (segments)
+    {
+        TRANSPORT_SIM simStop;
+        MOTION_EST estStop;
+        STC_LOCATE_MODEL modelStop;
+        SEQ_STATS followStats;
+        SEQ_STATS stopStats;
+        CUE_SEQ seq;
+        double cues[STC_USER_CUE_POINTS];
+        double pos;
+        uint32_t n, k;
+
+        memset(&followStats, 0, sizeof(followStats));
+        memset(&stopStats, 0, sizeof(stopStats));
+
+        for (n=0; n < segments; n += k)
+        {
+            /* Build a cue list of locate and play steps. The cue points
+             * are picked from where the tape will be after the segment
+             * before.
+             */
+            CueSeq_init(&seq);
+
+            pos = sim.roller;
+
+            for (k=0; (k < BENCH_SEQ_SEGS) && ((n + k) < segments); k++)
+            {
+                double play = BENCH_SEQ_PLAY_MIN +
+                              (TransportSim_random(&sim) * (BENCH_SEQ_PLAY_MAX - BENCH_SEQ_PLAY_MIN));
+                size_t index = k;
+
+                do {
+                    cues[index] = pos + ((2.0 * TransportSim_random(&sim)) - 1.0) * BENCH_SEQ_DIST;
+                } while ((cues[index] < 500.0) || (cues[index] > (SIM_TAPE_LENGTH - 1000.0)));
+
+                pos = cues[index] + (sim.playVel * play);
+
+                CueSeq_set(&seq, k * 2, STC_SEQ_LOCATE, index, 0);
+                CueSeq_set(&seq, (k * 2) + 1, STC_SEQ_PLAY, (uint32_t)(play * 1000.0), 0);
+            }
+
+            /* The same cue list on the same machine both ways */
+            simStop   = sim;
+            estStop   = est;
+            modelStop = model;
+
+            Sequence(&sim, &est, &model, learn, true, &seq, cues, &followStats);
+            Sequence(&simStop, &estStop, &modelStop, learn, false, &seq, cues, &stopStats);
+        }
+
+        printf("sequence benchmark: %u segments, seed %u, warmup %u, learning %s\n",
+               segments, seed, warmup, learn ? "on" : "off");
+        sim.pos = SIM_TAPE_LENGTH * 0.5;
+        printf("machine: lag %.0f ms, accel %.0f IPS/s mid tape, velocity scale %.3f\n",
+               sim.cmdLag * 1000.0, TransportSim_accel(&sim), sim.velScale);
+        printf("\n%-13s %6s %8s %8s %8s %8s %8s %8s %8s\n", "locate", "count",
+               "err", "|err|", "err max", "move", "move max", "eta err", "stop");
+
+        SeqPrint("from play", &followStats);
+        SeqPrint("stop first", &stopStats);
+
+        printf("\nerr: seconds played minus the play step time, mean, mean |err| and max |err|\n");
+        printf("move: seconds from the end of a segment to arriving at the next cue\n");
+        printf("eta err: mean |move - ETA planned while the segment played|\n");
+        printf("stop: mean |stop error| at the cue points in inches\n");
+
+        if (!followStats.count || ((followStats.errorAbs / followStats.count) > BENCH_SEQ_TOL))
+        {
+            printf("\nFAIL: mean play time error over %.0f ms\n", BENCH_SEQ_TOL * 1000.0);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (punches)
+    {
+        TRANSPORT_SIM simRun;
+        MOTION_EST estRun;
+        STC_LOCATE_MODEL modelRun;
+        double* err[BENCH_PUNCH_MODES][2];
+        double e[2];
+        double in, out;
+        uint32_t n[BENCH_PUNCH_MODES];
+        uint32_t m;
+        int status = 0;
+
+        for (m=0; m < BENCH_PUNCH_MODES; m++)
+        {
+            err[m][0] = calloc(punches, sizeof(double));
+            err[m][1] = calloc(punches, sizeof(double));
+            n[m] = 0;
+        }
+
+        for (i=0; i < punches; i++)
+        {
+            /* Leave room for the pre-roll before the punch-in point */
+            do {
+                in = sim.roller + ((2.0 * TransportSim_random(&sim)) - 1.0) * BENCH_SEQ_DIST;
+            } while ((in < 1000.0) || (in > (SIM_TAPE_LENGTH - 2000.0)));
+
+            out = in + (sim.playVel * (BENCH_PUNCH_MIN + (TransportSim_random(&sim) *
+                                                          (BENCH_PUNCH_MAX - BENCH_PUNCH_MIN))));
+
+            /* The same punch on the same machine each way. The machine
+             * carries on from the punch timed on the deadline.
+             */
+            for (m=BENCH_PUNCH_MODES; m-- > 0; )
+            {
+                simRun   = sim;
+                estRun   = est;
+                modelRun = model;
+
+                if (Punch(&simRun, &estRun, &modelRun, learn, m, in, out, e))
+                {
+                    err[m][0][n[m]] = e[0];
+                    err[m][1][n[m]] = e[1];
+                    n[m]++;
+                }
+            }
+
+            sim   = simRun;
+            est   = estRun;
+            model = modelRun;
+        }
+
+        printf("punch benchmark: %u punches, seed %u, warmup %u, learning %s\n",
+               punches, seed, warmup, learn ? "on" : "off");
+        sim.pos = SIM_TAPE_LENGTH * 0.5;
+        printf("machine: lag %.0f ms +/-%.0f ms, learned punch lag %.1f ms, planner lag %.1f ms\n",
+               sim.cmdLag * 1000.0, sim.cmdJitter * 1000.0, model.punch * 1000.0,
+               model.lag[PLAN_FWD] * 1000.0);
+        printf("\n%-13s %-5s %6s %7s %7s %7s %7s %7s %7s\n", "timing", "edge", "count",
+               "err", "|err|", "p50", "p95", "max", "max in");
+
+        for (m=0; m < BENCH_PUNCH_MODES; m++)
+        {
+            PunchPrint(s_punchName[m], "in", err[m][0], n[m], sim.playVel);
+            PunchPrint(s_punchName[m], "out", err[m][1], n[m], sim.playVel);
+        }
+
+        printf("\nerr: mean ms from the tape at the punch point to record on or off, + is late\n");
+        printf("|err|/p50/p95/max: ms of |err|, max in: largest |err| in inches of tape\n");
+        printf("deadline: wake on each encoder sample or the punch deadline, punch lag lead\n");
+        printf("samples: wake on encoder samples only, punch lag lead\n");
+        printf("planner lag: locate planner command lag lead, no lead: no lead at all\n");
+
+        for (i=0; i < 2; i++)
+        {
+            double sum = 0.0;
+
+            for (m=0; m < n[BENCH_PUNCH_DEADLINE]; m++)
+                sum += fabs(err[BENCH_PUNCH_DEADLINE][i][m]);
+
+            if (!n[BENCH_PUNCH_DEADLINE] || ((sum / n[BENCH_PUNCH_DEADLINE]) > BENCH_PUNCH_TOL))
+                status = 1;
+        }
+
+        if (n[BENCH_PUNCH_DEADLINE] != punches)
+            status = 1;
+
+        if (status)
+            printf("\nFAIL: punch missed or mean punch error over %.0f ms\n", BENCH_PUNCH_TOL * 1000.0);
+
+        return status;
+    }
+
+    if (loops)
+    {
+        TRANSPORT_SIM simStop;
+        MOTION_EST estStop;
+        STC_LOCATE_MODEL modelStop;
+        LOOP_STATS rollStats;
+        LOOP_STATS stopStats;
+        double in, out;
+        double dead[2];
+
+        memset(&rollStats, 0, sizeof(rollStats));
+        memset(&stopStats, 0, sizeof(stopStats));
+
+        for (i=0; i < loops; i++)
+        {
+            /* Leave room for the pre-roll before the mark-in point */
+            do {
+                in = sim.roller + ((2.0 * TransportSim_random(&sim)) - 1.0) * BENCH_SEQ_DIST;
+            } while ((in < 1000.0) || (in > (SIM_TAPE_LENGTH - 2000.0)));
+
+            out = in + (sim.playVel * (BENCH_LOOP_MIN + (TransportSim_random(&sim) *
+                                                         (BENCH_LOOP_MAX - BENCH_LOOP_MIN))));
+
+            /* The same loop on the same machine both ways. The machine
+             * carries on from the loop with the pre-roll.
+             */
+            simStop   = sim;
+            estStop   = est;
+            modelStop = model;
+
+            Loop(&simStop, &estStop, &modelStop, learn, false, in, out, BENCH_LOOP_PASSES, &stopStats);
+            Loop(&sim, &est, &model, learn, true, in, out, BENCH_LOOP_PASSES, &rollStats);
+        }
+
+        printf("loop benchmark: %u loops of %u passes, seed %u, warmup %u, learning %s\n",
+               loops, BENCH_LOOP_PASSES, seed, warmup, learn ? "on" : "off");
+        sim.pos = SIM_TAPE_LENGTH * 0.5;
+        printf("machine: lag %.0f ms, accel %.0f IPS/s mid tape, learned spin-up %.2f in\n",
+               sim.cmdLag * 1000.0, TransportSim_accel(&sim), model.spinup);
+        printf("\n%-13s %6s %7s %7s %7s %7s %6s %7s %7s\n", "loop", "passes",
+               "cycle", "max", "dead", "in IPS", "slow", "start", "end");
+
+        LoopPrint("pre-roll", &rollStats);
+        LoopPrint("stop on in", &stopStats);
+
+        printf("\ncycle/max: seconds from crossing mark-in to crossing it again\n");
+        printf("dead: mean seconds of each cycle not playing the loop at play speed\n");
+        printf("in IPS: mean tape speed at mark-in, slow: passes below %.0f%% of play speed there\n",
+               BENCH_LOOP_AT_SPEED * 100.0);
+        printf("start: mean ms from mark-in to play speed, end: mean ms of loop cut before mark-out\n");
+
+        dead[0] = rollStats.cycles ? ((rollStats.cycle - rollStats.loop) / rollStats.cycles) : 0.0;
+        dead[1] = stopStats.cycles ? ((stopStats.cycle - stopStats.loop) / stopStats.cycles) : 0.0;
+
+        printf("\npre-roll saves %.2f s per pass, %.1f%% of the cycle\n", dead[1] - dead[0],
+               stopStats.cycle ? (100.0 * (1.0 - (rollStats.cycle / rollStats.cycles) /
+                                               (stopStats.cycle / stopStats.cycles))) : 0.0);
+
+        if (!rollStats.cycles || (dead[0] >= dead[1]) ||
+            (rollStats.slow > (rollStats.starts * BENCH_LOOP_SLOW)))
+        {
+            printf("\nFAIL: loop not shorter or over %.0f%% of passes slow at mark-in\n",
+                   BENCH_LOOP_SLOW * 100.0);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    printf("locate benchmark: %u locates, seed %u, warmup %u, learning %s, %s loop\n",
+           locates, seed, warmup, learn ? "on" : "off", tick ? "1 ms tick" : "event");
+    /* Machine constants the seed picked */
+    sim.pos = SIM_TAPE_LENGTH * 0.5;
+
+    printf("machine: lag %.0f ms, accel %.0f IPS/s mid tape, velocity scale %.3f, roller slip %.2f%%\n",
+           sim.cmdLag * 1000.0, TransportSim_accel(&sim), sim.velScale, (1.0 - sim.slip) * 100.0);
+    printf("\n%-13s %6s %7s %7s %7s %7s %7s %7s %7s %6s %6s %5s\n", "distance", "count",
+           "time", "p50", "p95", "max", "eta err", "err", "err max", "over", "omax", "rev");
+
+    for (b=0; b < BENCH_BANDS; b++)
+        StatsPrint(s_bandName[b], &band[b]);
+
+    StatsPrint("all", &all);
+
+    printf("\n%-13s\n", "old locator");
+
+    for (b=0; b < BENCH_BANDS; b++)
+        StatsPrint(s_bandName[b], &oldBand[b]);
+
+    StatsPrint("all", &oldAll);
+
+    printf("\ntime/p50/p95/max: seconds to arrive at the cue point\n");
+    printf("eta err: mean |first ETA - time|, err: mean |stop error| in inches\n");
+    printf("over: stops more than %.2f in past the cue, omax: furthest past the cue in inches\n",
+           BENCH_OVERSHOOT);
+    printf("rev: locates with a tape direction change (total changes %u, old %u), timeouts %u, old %u\n",
+           all.reversals, oldAll.reversals, all.timeouts, oldAll.timeouts);
+    printf("\nlocate loop: %.0f wakes/s, %.1f us host CPU per locate second, %.0f ns per wake\n",
+           all.wakes / all.time, (all.cpu * 1.0e6) / all.time, (all.cpu * 1.0e9) / all.wakes);
+    printf("old locator: %.0f wakes/s, %.1f us host CPU per locate second, %.0f ns per wake\n",
+           oldAll.wakes / oldAll.time, (oldAll.cpu * 1.0e6) / oldAll.time,
+           (oldAll.cpu * 1.0e9) / oldAll.wakes);
+
+    if (csv)
+        fclose(csv);
+
+    return 0;
+}
+
+//*****************************************************************************
+// Run one locate to the cue point given in roller inches, the way the
+// locate task does, and measure it. If a loop plan is given, play is sent
+// and the locate ends once the plan says to, as the locate task does on
+// the way back round a loop.
+//*****************************************************************************
+
+static void Locate(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                   bool learn, bool tick, double cue, LOOP_PLAN* loop,
+                   LOCATE_RESULT* result)
+{
+    static const uint32_t jog_vel[STC_PLAN_SPEEDS] = { JOG_VEL_FAR, JOG_VEL_MID, JOG_VEL_NEAR };
+    float ipt = (float)(SIM_ROLLER_CIRCUM / SIM_ROLLER_TICKS);
+    int32_t cueTicks = (int32_t)floor((cue / SIM_ROLLER_CIRCUM) * SIM_ROLLER_TICKS);
+    BENCH_QEI qei;
+    double start = sim->time;
+    double next = sim->time;
+    double past;
+    double cpu;
+    uint32_t now;
+    uint32_t wait;
+    bool sample;
+    int32_t tape_pos;
+    int dir = 0;
+    int moving;
+    MOTION_STATE motion;
+    LOCATE_PLAN plan;
+    PLAN_ACTION action;
+    LOOP_ACTION turn = LOOP_NONE;
+    bool begun = false;
+
+    memset(result, 0, sizeof(*result));
+
+    qei.count      = TransportSim_encoder(sim);
+    qei.dir        = 0;
+    qei.sampleTime = sim->time;
+    qei.timerTime  = sim->time;
+
+    result->distance = fabs(cue - sim->roller);
+
+    cue = (double)cueTicks * ipt;
+
+    if (cue > sim->roller)
+        dir = 1;
+    else if (cue < sim->roller)
+        dir = -1;
+
+    moving = 0;
+
+    while (true)
+    {
+        sample = Step(sim, est, &qei);
+
+        /* Track the furthest the tape goes past the cue point */
+        past = (sim->roller - cue) * dir;
+
+        if (past > result->overshoot)
+            result->overshoot = past;
+
+        /* Count tape direction changes */
+        if (fabs(sim->vel) >= BENCH_REVERSE_VEL)
+        {
+            int d = (sim->vel > 0.0) ? 1 : -1;
+
+            if (moving && (d != moving))
+                result->reversals++;
+
+            moving = d;
+        }
+
+        /* The loop wakes on the position update event or its timeout */
+        if ((sim->time < next) && (tick || !sample))
+            continue;
+
+        now = (uint32_t)(sim->time * 1000.0);
+
+        cpu = CpuTime();
+
+        /* Predicted tape position as PositionPredict() returns it */
+        MotionEst_getState(est, &motion);
+
+        tape_pos = motion.position +
+                   (int32_t)lroundf(MotionEst_predict(est, &motion, (uint32_t)(sim->time * 1.0e6)));
+
+        if (!begun)
+        {
+            begun = true;
+
+            if (tape_pos == cueTicks)
+                break;
+
+            action = LocatePlan_begin(&plan, model, jog_vel, SHUTTLE_SLOW_VEL, learn,
+                                      ipt, cueTicks, tape_pos, motion.velocity,
+                                      (uint32_t)(sim->time * 1000.0));
+
+            result->eta   = plan.eta;
+            result->speed = plan.speed;
+        }
+        else if (loop && ((turn = LoopPlan_return(loop, tape_pos, motion.velocity)) == LOOP_PLAY))
+        {
+            /* Play with the tape still moving back round the loop */
+            TransportSim_command(sim, OP_MODE_PLAY, 0, 0);
+
+            result->cpu += CpuTime() - cpu;
+            result->wakes++;
+            result->played = true;
+            break;
+        }
+        else if (loop && (turn == LOOP_HOLD))
+        {
+            /* The loop plan holds off the planner on the way back */
+            action = PLAN_NONE;
+        }
+        else
+        {
+            turn = LOOP_NONE;
+
+            action = LocatePlan_update(&plan, tape_pos, motion.velocity,
+                                       (uint32_t)(sim->time * 1000.0));
+        }
+
+        /* Sleep until the next tick or the planner deadline */
+        if (tick)
+            wait = 1;
+        else if (turn == LOOP_HOLD)
+            wait = (LoopPlan_deadline(loop) < BENCH_WAIT_MAX) ? LoopPlan_deadline(loop) : BENCH_WAIT_MAX;
+        else
+            wait = LocatePlan_deadline(&plan, tape_pos, motion.velocity, now);
+
+        if (!wait)
+            wait = 1;
+
+        next = (double)(now + wait) * 0.001;
+
+        if (Action(sim, &plan, action))
+        {
+            result->cpu += CpuTime() - cpu;
+            result->wakes++;
+            break;
+        }
+
+        result->cpu += CpuTime() - cpu;
+        result->wakes++;
+
+        if ((sim->time - start) >= BENCH_TIMEOUT)
+        {
+            result->timeout = true;
+            TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+            break;
+        }
+    }
+
+    result->time = sim->time - start;
+
+    if (begun)
+        result->retries = plan.retries;
+
+    /* The tape carries on round the loop without stopping */
+    if (result->played)
+        return;
+
+    /* Let the transport come to rest for the stop error */
+    while (!TransportSim_idle(sim))
+        Step(sim, est, &qei);
+
+    result->error = (sim->roller - cue) * (dir ? dir : 1);
+
+    if (result->error > result->overshoot)
+        result->overshoot = result->error;
+}
+
+//*****************************************************************************
+// Run one locate to the cue point given in roller inches with the locate
+// state machine the planner replaced, and measure it. The old locate loop
+// woke every 1 ms on its mailbox timeout.
+//*****************************************************************************
+
+static void Legacy(TRANSPORT_SIM* sim, MOTION_EST* est, double cue, LOCATE_RESULT* result)
+{
+    float ipt = (float)(SIM_ROLLER_CIRCUM / SIM_ROLLER_TICKS);
+    int32_t cueTicks = (int32_t)floor((cue / SIM_ROLLER_CIRCUM) * SIM_ROLLER_TICKS);
+    LEGACY_STATE state = LEGACY_START;
+    MOTION_STATE motion;
+    BENCH_QEI qei;
+    double start = sim->time;
+    double next = sim->time;
+    double past;
+    double cpu;
+    int32_t tape_pos;
+    int32_t cue_dist;
+    int32_t cue_from = 0;
+    int32_t abs_dist;
+    int32_t ldir = 0;
+    float velocity;
+    float time;
+    int dir = 0;
+    int moving = 0;
+    bool done = false;
+
+    memset(result, 0, sizeof(*result));
+
+    qei.count      = TransportSim_encoder(sim);
+    qei.dir        = 0;
+    qei.sampleTime = sim->time;
+    qei.timerTime  = sim->time;
+
+    result->distance = fabs(cue - sim->roller);
+
+    cue = (double)cueTicks * ipt;
+
+    if (cue > sim->roller)
+        dir = 1;
+    else if (cue < sim->roller)
+        dir = -1;
+
+    while (true)
+    {
+        Step(sim, est, &qei);
+
+        /* Track the furthest the tape goes past the cue point */
+        past = (sim->roller - cue) * dir;
+
+        if (past > result->overshoot)
+            result->overshoot = past;
+
+        /* Count tape direction changes */
+        if (fabs(sim->vel) >= BENCH_REVERSE_VEL)
+        {
+            int d = (sim->vel > 0.0) ? 1 : -1;
+
+            if (moving && (d != moving))
+                result->reversals++;
+
+            moving = d;
+        }
+
+        if (sim->time < next)
+            continue;
+
+        next = sim->time + BENCH_TASK_PERIOD;
+
+        cpu = CpuTime();
+
+        MotionEst_getState(est, &motion);
+
+        tape_pos = motion.position +
+                   (int32_t)lroundf(MotionEst_predict(est, &motion, (uint32_t)(sim->time * 1.0e6)));
+
+        cue_dist = cueTicks - tape_pos;
+        abs_dist = abs(cue_dist);
+
+        if (state == LEGACY_START)
+            cue_from = cue_dist ? cue_dist : 1;
+
+        if ((velocity = fabsf(motion.velocity)) < LEGACY_VEL_MIN)
+            velocity = LEGACY_VEL_MIN;
+
+        time = ((float)abs_dist * ipt) / velocity;
+
+        switch(state)
+        {
+        case LEGACY_START:
+            if (cue_dist > 0)
+            {
+                ldir = 1;
+            }
+            else if (cue_dist < 0)
+            {
+                ldir = -1;
+            }
+            else
+            {
+                done = true;
+                break;
+            }
+
+            /* The shuttle speed range from the distance out */
+            if (abs_dist > LEGACY_DIST_FAR)
+            {
+                result->speed = PLAN_SPEED_FAR;
+                state = LEGACY_SEARCH_FAR;
+                LegacyShuttle(sim, ldir, JOG_VEL_FAR);
+            }
+            else if (abs_dist > LEGACY_DIST_MID)
+            {
+                result->speed = PLAN_SPEED_MID;
+                state = LEGACY_SEARCH_MID;
+                LegacyShuttle(sim, ldir, JOG_VEL_MID);
+            }
+            else
+            {
+                result->speed = PLAN_SPEED_NEAR;
+                state = LEGACY_SEARCH_NEAR;
+                LegacyShuttle(sim, ldir, JOG_VEL_NEAR);
+            }
+            break;
+
+        case LEGACY_SEARCH_FAR:
+        case LEGACY_SEARCH_MID:
+            if (time < ((state == LEGACY_SEARCH_FAR) ? LEGACY_TIME_FAR : LEGACY_TIME_MID))
+            {
+                if (velocity > LEGACY_VEL_BRAKE)
+                    state = LEGACY_BRAKE_STATE;
+                else
+                    state = LEGACY_BRAKE_VELOCITY;
+            }
+            break;
+
+        case LEGACY_SEARCH_NEAR:
+            if (time < LEGACY_TIME_NEAR)
+                state = LEGACY_BRAKE_VELOCITY;
+            break;
+
+        case LEGACY_BRAKE_STATE:
+            /* Dynamic brake from speed, or coast down in slow shuttle */
+            if (velocity > LEGACY_VEL_DYNAMIC)
+            {
+                TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+                state = LEGACY_BRAKE_VELOCITY;
+            }
+            else
+            {
+                LegacyShuttle(sim, ldir, SHUTTLE_SLOW_VEL);
+                state = LEGACY_ZERO_CROSS;
+            }
+            /* fall through */
+
+        case LEGACY_BRAKE_VELOCITY:
+            /* Wait for the tape to slow to slow shuttle speed */
+            if (velocity > LEGACY_VEL_SLOW)
+                break;
+
+            LegacyShuttle(sim, ldir, SHUTTLE_SLOW_VEL);
+            state = LEGACY_ZERO_CROSS;
+            /* fall through */
+
+        case LEGACY_ZERO_CROSS:
+            /* Further from the cue than at the start */
+            if ((ldir > 0) ? (cue_from < cue_dist) : (cue_from > cue_dist))
+            {
+                TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+                done = true;
+                break;
+            }
+
+            if (time < LEGACY_TIME_ARRIVE)
+            {
+                TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+                done = true;
+            }
+            break;
+        }
+
+        result->cpu += CpuTime() - cpu;
+        result->wakes++;
+
+        if (done)
+            break;
+
+        if ((sim->time - start) >= BENCH_TIMEOUT)
+        {
+            result->timeout = true;
+            TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+            break;
+        }
+    }
+
+    result->time = sim->time - start;
+
+    /* Let the transport come to rest for the stop error */
+    while (!TransportSim_idle(sim))
+        Step(sim, est, &qei);
+
+    result->error = (sim->roller - cue) * (dir ? dir : 1);
+
+    if (result->error > result->overshoot)
+        result->overshoot = result->error;
+}
+
+/* Shuttle toward the cue as the old locator did, with auto slow off */
+static void LegacyShuttle(TRANSPORT_SIM* sim, int32_t dir, uint32_t velocity)
+{
+    TransportSim_command(sim, (dir > 0) ? OP_MODE_FWD : OP_MODE_REW, velocity, M_NOSLOW);
+}
+
+//*****************************************************************************
+// Run a cue list the way the locate task does. Locate steps are run as in
+// Locate(), starting from the tape motion at the end of the play segment
+// before if follow is set, or after a stop command if not. The locate
+// time to the next cue is planned as each timed play step starts, as
+// SequencePlan() does. The time each segment spent in play mode is
+// measured against its step time.
+//*****************************************************************************
+
+static void Sequence(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                     bool learn, bool follow, CUE_SEQ* seq, const double* cues,
+                     SEQ_STATS* stats)
+{
+    const SEQ_STEP* step;
+    const SEQ_STEP* next;
+    LOCATE_RESULT result;
+    BENCH_QEI qei;
+    double played = 0.0;
+    double playEnd = 0.0;
+    double eta = 0.0;
+    double move;
+    uint32_t length = 0;
+
+    qei.count      = TransportSim_encoder(sim);
+    qei.dir        = 0;
+    qei.sampleTime = sim->time;
+    qei.timerTime  = sim->time;
+
+    CueSeq_start(seq, 0, (uint32_t)(sim->time * 1000.0));
+
+    while (true)
+    {
+        step = CueSeq_next(seq, (uint32_t)(sim->time * 1000.0));
+
+        /* The locate task stops the transport once the cue list has run out */
+        if (!step)
+        {
+            TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+
+            while (!TransportSim_idle(sim))
+                Step(sim, est, &qei);
+        }
+
+        /* The segment before has ended once the next one starts */
+        if (length && (!step || (step->op == STC_SEQ_PLAY)))
+        {
+            double err = (sim->playTime - played) - ((double)length * 0.001);
+
+            stats->count++;
+            stats->error    += err;
+            stats->errorAbs += fabs(err);
+
+            if (fabs(err) > stats->errorMax)
+                stats->errorMax = fabs(err);
+
+            length = 0;
+        }
+
+        if (!step)
+            break;
+
+        switch(step->op)
+        {
+        case STC_SEQ_LOCATE:
+            /* A separate locate request stops the transport first */
+            if (!follow)
+                TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+
+            Locate(sim, est, model, learn, false, cues[step->param], NULL, &result);
+
+            stats->stop += fabs(result.error);
+
+            if (playEnd > 0.0)
+            {
+                move = sim->time - playEnd;
+
+                stats->moves++;
+                stats->move     += move;
+                stats->etaError += fabs(move - eta);
+
+                if (move > stats->moveMax)
+                    stats->moveMax = move;
+            }
+            break;
+
+        case STC_SEQ_PLAY:
+            TransportSim_command(sim, OP_MODE_PLAY, 0, 0);
+
+            played = sim->playTime;
+            length = step->param;
+
+            /* Plan the next locate while this segment plays */
+            eta = 0.0;
+
+            if ((next = CueSeq_peek(seq)) && (next->op == STC_SEQ_LOCATE))
+                eta = SeqPlan(model, sim->roller + (sim->playVel * (double)length * 0.001),
+                              cues[next->param]);
+
+            while (CueSeq_deadline(seq, (uint32_t)(sim->time * 1000.0)))
+                Step(sim, est, &qei);
+
+            playEnd = sim->time;
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+// Run an auto punch the way the locate task does. Locate to the pre-roll
+// point, play and send the punch-in and punch-out as the auto-punch timing
+// gives them, then stop after the post-roll. The loop wakes on each new
+// encoder sample, and on the punch deadline unless timed on samples only.
+// Returns the seconds from the tape reaching the punch-in and punch-out
+// points to record starting and ending there in err[0] and err[1].
+//*****************************************************************************
+
+static bool Punch(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                  bool learn, uint32_t mode, double in, double out, double* err)
+{
+    double ipt = SIM_ROLLER_CIRCUM / SIM_ROLLER_TICKS;
+    int32_t inTicks = (int32_t)floor(in / ipt);
+    int32_t outTicks = (int32_t)floor(out / ipt);
+    int32_t preroll;
+    int32_t tape_pos;
+    LOCATE_RESULT result;
+    BENCH_QEI qei;
+    AUTO_PUNCH ap;
+    MOTION_STATE motion;
+    PUNCH_ACTION action = PUNCH_NONE;
+    double start;
+    double next;
+    float lead;
+    uint32_t now;
+    uint32_t wait;
+    bool punched = false;
+    bool sample;
+
+    /* Locate to the pre-roll point and roll */
+    preroll = AutoPunch_preroll(inTicks, BENCH_PUNCH_PREROLL, (float)sim->playVel, (float)ipt);
+
+    Locate(sim, est, model, learn, false, ((double)preroll + 0.5) * ipt, NULL, &result);
+
+    if (result.timeout)
+        return false;
+
+    TransportSim_command(sim, OP_MODE_PLAY, 0, 0);
+
+    if (mode == BENCH_PUNCH_PLANLAG)
+        lead = model->lag[PLAN_FWD];
+    else if (mode == BENCH_PUNCH_NOLEAD)
+        lead = 0.0f;
+    else
+        lead = model->punch;
+
+    AutoPunch_begin(&ap, inTicks, outTicks, (float)ipt, lead, BENCH_PUNCH_POSTROLL);
+
+    qei.count      = TransportSim_encoder(sim);
+    qei.dir        = 0;
+    qei.sampleTime = sim->time;
+    qei.timerTime  = sim->time;
+
+    start = next = sim->time;
+
+    while (action != PUNCH_END)
+    {
+        sample = Step(sim, est, &qei);
+
+        /* The loop wakes on the position update event or its timeout */
+        if ((sim->time < next) && !sample)
+            continue;
+
+        now = (uint32_t)(sim->time * 1000.0);
+
+        /* Predicted tape position as PositionPredict() returns it */
+        MotionEst_getState(est, &motion);
+
+        tape_pos = motion.position +
+                   (int32_t)lroundf(MotionEst_predict(est, &motion, (uint32_t)(sim->time * 1.0e6)));
+
+        /* Learn the punch lag as the DTC reports record on or off */
+        if (learn && (lead == model->punch))
+            AutoPunch_response(&ap, (sim->mode & M_RECORD) != 0,
+                               (uint32_t)(sim->recordTime * 1000.0), &model->punch);
+
+        action = AutoPunch_update(&ap, (float)tape_pos, motion.velocity, now);
+
+        switch(action)
+        {
+        case PUNCH_IN:
+            TransportSim_command(sim, OP_MODE_PLAY, M_RECORD, 0);
+            break;
+
+        case PUNCH_OUT:
+            TransportSim_command(sim, OP_MODE_PLAY, 0, 0);
+            punched = true;
+            break;
+
+        case PUNCH_END:
+            TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+            break;
+
+        default:
+            break;
+        }
+
+        wait = (mode == BENCH_PUNCH_SAMPLE) ? BENCH_WAIT_MAX : AutoPunch_deadline(&ap);
+
+        if (wait > BENCH_WAIT_MAX)
+            wait = BENCH_WAIT_MAX;
+        else if (!wait)
+            wait = 1;
+
+        next = (double)(now + wait) * 0.001;
+
+        if ((sim->time - start) >= BENCH_TIMEOUT)
+        {
+            TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+            break;
+        }
+    }
+
+    while (!TransportSim_idle(sim))
+        Step(sim, est, &qei);
+
+    if (!punched)
+        return false;
+
+    err[0] = (sim->recordOn - ((double)inTicks * ipt)) / sim->playVel;
+    err[1] = (sim->recordOff - ((double)outTicks * ipt)) / sim->playVel;
+
+    return true;
+}
+
+//*****************************************************************************
+// Run a loop between the mark in and out points given in roller inches the
+// way the locate task does, for the number of passes given. With optimize
+// set each pass locates back to the loop plan pre-roll point, sending play
+// on the way once the plan says to, and turns around the learned command
+// lag ahead of mark-out. Without it each pass stops on mark-in and plays
+// from there, and turns around BENCH_LOOP_MARK_OUT seconds ahead of
+// mark-out at the current speed, as the locate task used to. The loop
+// wakes on each new encoder sample or the turnaround deadline.
+//*****************************************************************************
+
+static void Loop(TRANSPORT_SIM* sim, MOTION_EST* est, STC_LOCATE_MODEL* model,
+                 bool learn, bool optimize, double in, double out, uint32_t passes,
+                 LOOP_STATS* stats)
+{
+    double ipt = SIM_ROLLER_CIRCUM / SIM_ROLLER_TICKS;
+    double play = sim->playVel * BENCH_LOOP_AT_SPEED;
+    double last = 0.0;
+    double cross = 0.0;
+    double prev;
+    double next;
+    double mark;
+    float velocity;
+    int32_t tape_pos;
+    LOCATE_RESULT result;
+    BENCH_QEI qei;
+    LOOP_PLAN loop;
+    MOTION_STATE motion;
+    uint32_t pass;
+    uint32_t now;
+    uint32_t wait;
+    bool crossed;
+    bool rolling;
+    bool turn;
+    bool sample;
+
+    LoopPlan_begin(&loop, model, learn, (int32_t)floor(in / ipt), (int32_t)floor(out / ipt),
+                   (float)ipt, (float)sim->playVel, optimize);
+
+    memset(&result, 0, sizeof(result));
+
+    for (pass=0; pass < passes; pass++)
+    {
+        /* Locate back to the start of the loop, from wherever the tape is
+         * on the first pass and from the turnaround after that.
+         */
+        Locate(sim, est, model, learn, false, ((double)LoopPlan_preroll(&loop) + 0.5) * ipt,
+               optimize ? &loop : NULL, &result);
+
+        if (result.timeout)
+            return;
+
+        if (!result.played)
+            TransportSim_command(sim, OP_MODE_PLAY, 0, 0);
+
+        MotionEst_getState(est, &motion);
+
+        tape_pos = motion.position +
+                   (int32_t)lroundf(MotionEst_predict(est, &motion, (uint32_t)(sim->time * 1.0e6)));
+
+        LoopPlan_play(&loop, tape_pos, motion.velocity);
+
+        /* The end of the pass before, where play ended */
+        if (pass)
+        {
+            stats->endLost += (out - sim->playOff) / sim->playVel;
+            stats->ends++;
+        }
+
+        qei.count      = TransportSim_encoder(sim);
+        qei.dir        = 0;
+        qei.sampleTime = sim->time;
+        qei.timerTime  = sim->time;
+
+        /* A pass stopped on or past mark-in starts as play is sent */
+        crossed = (sim->roller >= in) && (sim->vel >= 0.0);
+        rolling = false;
+        cross   = sim->time;
+        next    = sim->time;
+
+        if (crossed)
+            stats->inVel += sim->vel;
+
+        while (true)
+        {
+            prev = sim->roller;
+
+            sample = Step(sim, est, &qei);
+
+            if (!crossed && (prev < in) && (sim->roller >= in))
+            {
+                crossed = true;
+                cross   = sim->time;
+
+                stats->inVel += sim->vel;
+            }
+
+            /* Time from mark-in to the tape reaching play speed */
+            if (crossed && !rolling && (sim->vel >= play))
+            {
+                rolling = true;
+
+                if (sim->time > cross)
+                {
+                    stats->startLost += sim->time - cross;
+                    stats->slow++;
+                }
+            }
+
+            /* The loop wakes on the position update event or its timeout */
+            if ((sim->time < next) && !sample)
+                continue;
+
+            now = (uint32_t)(sim->time * 1000.0);
+
+            /* Predicted tape position as PositionPredict() returns it */
+            MotionEst_getState(est, &motion);
+
+            tape_pos = motion.position +
+                       (int32_t)lroundf(MotionEst_predict(est, &motion, (uint32_t)(sim->time * 1.0e6)));
+
+            if (optimize)
+            {
+                turn = (LoopPlan_update(&loop, tape_pos, motion.velocity) == LOOP_TURN);
+                wait = LoopPlan_deadline(&loop);
+            }
+            else
+            {
+                /* Learn the spin-up all the same, for the pre-roll */
+                LoopPlan_update(&loop, tape_pos, motion.velocity);
+
+                if ((velocity = fabsf(motion.velocity)) < LOOP_VEL_MIN)
+                    velocity = LOOP_VEL_MIN;
+
+                mark = (fabs((double)(loop.out - tape_pos)) * ipt) / velocity;
+
+                turn = (mark < BENCH_LOOP_MARK_OUT);
+                wait = (mark - BENCH_LOOP_MARK_OUT <= 0.001) ? 1 :
+                       (uint32_t)((mark - BENCH_LOOP_MARK_OUT) * 1000.0);
+            }
+
+            if (turn)
+                break;
+
+            if (wait > BENCH_WAIT_MAX)
+                wait = BENCH_WAIT_MAX;
+            else if (!wait)
+                wait = 1;
+
+            next = (double)(now + wait) * 0.001;
+        }
+
+        /* Time from mark-in to mark-in */
+        if (pass)
+        {
+            stats->cycle += cross - last;
+            stats->loop  += (out - in) / sim->playVel;
+            stats->cycles++;
+
+            if ((cross - last) > stats->cycleMax)
+                stats->cycleMax = cross - last;
+        }
+
+        stats->starts++;
+
+        last = cross;
+    }
+
+    /* Stop once round the loop */
+    TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+
+    while (!TransportSim_idle(sim))
+        Step(sim, est, &qei);
+
+    stats->endLost += (out - sim->playOff) / sim->playVel;
+    stats->ends++;
+}
+
+/* Seconds the planner gives to locate from pos to the cue in inches */
+static double SeqPlan(STC_LOCATE_MODEL* model, double pos, double cue)
+{
+    int32_t dir = (cue < pos) ? PLAN_REW : PLAN_FWD;
+    float dist = (float)fabs(cue - pos);
+    float eta = LocatePlan_time(model, dir, PLAN_SPEED_FAR, dist);
+    float t;
+    uint32_t speed;
+
+    for (speed=PLAN_SPEED_MID; speed < STC_PLAN_SPEEDS; speed++)
+    {
+        if ((t = LocatePlan_time(model, dir, speed, dist)) < eta)
+            eta = t;
+    }
+
+    return eta;
+}
+
+//*****************************************************************************
+// Advance the transport one step and feed the motion estimator with the
+// encoder samples the QEI interrupt and position task would take.
+//*****************************************************************************
+
+static bool Step(TRANSPORT_SIM* sim, MOTION_EST* est, BENCH_QEI* qei)
+{
+    int32_t ticks;
+    bool sample = false;
+    int dir;
+
+    TransportSim_step(sim);
+
+    ticks = TransportSim_encoder(sim);
+
+    if (ticks != qei->count)
+    {
+        dir = (ticks > qei->count) ? 1 : -1;
+
+        /* Direction change interrupt */
+        if (qei->dir && (dir != qei->dir))
+            sample = true;
+
+        /* Index pulse once per roller revolution */
+        if ((ticks / SIM_ROLLER_TICKS) != (qei->count / SIM_ROLLER_TICKS))
+            sample = true;
+
+        qei->count = ticks;
+        qei->dir   = dir;
+    }
+
+    /* Velocity timer interrupt */
+    if ((sim->time - qei->timerTime) >= BENCH_TIMER_PERIOD)
+    {
+        qei->timerTime = sim->time;
+        sample = true;
+    }
+
+    /* Poll sample requested by the position task */
+    if ((sim->time - qei->sampleTime) >= BENCH_POLL_PERIOD)
+        sample = true;
+
+    if (sample)
+    {
+        qei->sampleTime = sim->time;
+
+        MotionEst_update(est, ticks, (uint32_t)(sim->time * 1.0e6));
+    }
+
+    return sample;
+}
+
+//*****************************************************************************
+// Carry out a planner action as LocateAction() does in the locate task.
+//*****************************************************************************
+
+static bool Action(TRANSPORT_SIM* sim, LOCATE_PLAN* plan, PLAN_ACTION action)
+{
+    switch(action)
+    {
+    case PLAN_SHUTTLE:
+        if ((plan->dir == PLAN_FWD) != plan->reverse)
+            TransportSim_command(sim, OP_MODE_FWD, plan->velocity, M_NOSLOW);
+        else
+            TransportSim_command(sim, OP_MODE_REW, plan->velocity, M_NOSLOW);
+        break;
+
+    case PLAN_STOP:
+        TransportSim_command(sim, OP_MODE_STOP, 0, 0);
+        break;
+
+    case PLAN_ARRIVED:
+        return true;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+//*****************************************************************************
+// Add a locate to the statistics.
+//*****************************************************************************
+
+static void StatsAdd(BENCH_STATS* stats, LOCATE_RESULT* result)
+{
+    double err = fabs(result->error);
+
+    stats->times[stats->count++] = result->time;
+
+    stats->time += result->time;
+
+    if (result->time > stats->timeMax)
+        stats->timeMax = result->time;
+
+    stats->etaError += fabs(result->eta - result->time);
+
+    stats->error += err;
+
+    if (err > stats->errorMax)
+        stats->errorMax = err;
+
+    stats->overshoot += result->overshoot;
+
+    if (result->overshoot > stats->overshootMax)
+        stats->overshootMax = result->overshoot;
+
+    if (result->error > BENCH_OVERSHOOT)
+        stats->overshoots++;
+
+    if (result->reversals)
+        stats->reversed++;
+
+    stats->reversals += result->reversals;
+
+    if (result->timeout)
+        stats->timeouts++;
+
+    stats->wakes += result->wakes;
+    stats->cpu   += result->cpu;
+}
+
+//*****************************************************************************
+// Print a line of statistics.
+//*****************************************************************************
+
+static void StatsPrint(const char* name, BENCH_STATS* stats)
+{
+    uint32_t n = stats->count;
+
+    if (!n)
+    {
+        printf("%-13s %6u\n", name, n);
+        return;
+    }
+
+    qsort(stats->times, n, sizeof(double), CompareDouble);
+
+    if (stats->legacy)
+    {
+        printf("%-13s %6u %7.2f %7.2f %7.2f %7.2f %7s %7.3f %7.3f %6u %6.2f %5u\n",
+               name, n,
+               stats->time / n,
+               stats->times[n / 2],
+               stats->times[(n * 95) / 100],
+               stats->timeMax,
+               "-",
+               stats->error / n,
+               stats->errorMax,
+               stats->overshoots,
+               stats->overshootMax,
+               stats->reversed);
+        return;
+    }
+
+    printf("%-13s %6u %7.2f %7.2f %7.2f %7.2f %7.2f %7.3f %7.3f %6u %6.2f %5u\n",
+           name, n,
+           stats->time / n,
+           stats->times[n / 2],
+           stats->times[(n * 95) / 100],
+           stats->timeMax,
+           stats->etaError / n,
+           stats->error / n,
+           stats->errorMax,
+           stats->overshoots,
+           stats->overshootMax,
+           stats->reversed);
+}
+
+/* Print a line of sequence statistics */
+static void SeqPrint(const char* name, SEQ_STATS* stats)
+{
+    uint32_t n = stats->count ? stats->count : 1;
+    uint32_t m = stats->moves ? stats->moves : 1;
+
+    printf("%-13s %6u %8.3f %8.3f %8.3f %8.2f %8.2f %8.2f %8.3f\n",
+           name, stats->count,
+           stats->error / n,
+           stats->errorAbs / n,
+           stats->errorMax,
+           stats->move / m,
+           stats->moveMax,
+           stats->etaError / m,
+           stats->stop / n);
+}
+
+/* Print a line of loop statistics */
+static void LoopPrint(const char* name, LOOP_STATS* stats)
+{
+    uint32_t n = stats->cycles ? stats->cycles : 1;
+    uint32_t s = stats->starts ? stats->starts : 1;
+    uint32_t e = stats->ends ? stats->ends : 1;
+
+    printf("%-13s %6u %7.2f %7.2f %7.2f %7.1f %6u %7.0f %7.0f\n",
+           name, stats->starts,
+           stats->cycle / n,
+           stats->cycleMax,
+           (stats->cycle - stats->loop) / n,
+           stats->inVel / s,
+           stats->slow,
+           (stats->startLost / s) * 1000.0,
+           (stats->endLost / e) * 1000.0);
+}
+
+/* Print a line of punch error statistics, err in seconds at ips */
+static void PunchPrint(const char* name, const char* edge, double* err, uint32_t n, double ips)
+{
+    double* abserr;
+    double sum = 0.0;
+    double sumAbs = 0.0;
+    uint32_t i;
+
+    if (!n)
+    {
+        printf("%-13s %-5s %6u\n", name, edge, n);
+        return;
+    }
+
+    abserr = calloc(n, sizeof(double));
+
+    for (i=0; i < n; i++)
+    {
+        sum += err[i];
+        sumAbs += (abserr[i] = fabs(err[i]));
+    }
+
+    qsort(abserr, n, sizeof(double), CompareDouble);
+
+    printf("%-13s %-5s %6u %7.2f %7.2f %7.2f %7.2f %7.2f %7.3f\n",
+           name, edge, n,
+           (sum / n) * 1000.0,
+           (sumAbs / n) * 1000.0,
+           abserr[n / 2] * 1000.0,
+           abserr[(n * 95) / 100] * 1000.0,
+           abserr[n - 1] * 1000.0,
+           abserr[n - 1] * ips);
+
+    free(abserr);
+}
+
+static int CompareDouble(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+/* End-Of-File */
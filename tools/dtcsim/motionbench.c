@@ -0,0 +1,310 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Motion estimator test. A synthetic roller encoder follows a tape speed
+ * profile and is sampled as the firmware samples it: the 5 ms position
+ * task poll with some task latency, the 25 ms QEI velocity timer and the
+ * index pulse once a roller turn, so two samples can land a few us apart.
+ * The 80 MHz timestamp counter wraps partway through each run.
+ *
+ * Each sample goes through MotionEst_update(), and the estimated velocity
+ * and predicted position are compared with the true tape motion after a
+ * settling time. The creep cases run from 1 to 30 IPS and then stop dead.
+ * The tape must read as moving at every poll until it stops, and as
+ * stopped, with no velocity, soon after. The exit status is 1 if an error
+ * or the stop time is over the limit for its case.
+ *
+ * Usage:
+ *   motionbench [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "MotionEst.h"
+
+/* The firmware timestamp counter runs at the CPU clock */
+#define TIMESTAMP_FREQ          80000000.0
+
+#define ROLLER_TICKS            80
+#define ROLLER_CIRCUM           5.0014
+#define INCHES_PER_TICK         (ROLLER_CIRCUM / ROLLER_TICKS)
+
+/* Sample sources */
+#define POLL_PERIOD             0.005
+#define POLL_LATENCY            0.0005      /* task latency, up to  */
+#define TIMER_PERIOD            0.025
+
+/* Simulation step */
+#define STEP                    0.000005
+
+/* Errors are measured after this long */
+#define SETTLE_TIME             0.5
+
+/* A tape speed profile. The tape stops dead at the stop time. */
+typedef struct _CASE {
+    const char* name;
+    double      v0;                 /* IPS at the start             */
+    double      accel;              /* IPS/sec                      */
+    double      vmax;               /* IPS the ramp stops at        */
+    double      stop;               /* seconds to the stop          */
+    double      time;               /* seconds run                  */
+    double      rmsMax;             /* IPS rms velocity error limit */
+    double      posMax;             /* inches position error limit  */
+    double      stopMax;            /* ms to see the stop, limit    */
+} CASE;
+
+/* The stop limits are MOTION_STOP_EDGES tick periods, or MOTION_STOP_TIME
+ * if longer, and 10 ms for the sample spacing.
+ */
+static const CASE s_cases[] = {
+    { "creep 1 IPS",         1.0,    0.0,   1.0, 2.0, 2.5, 0.3, 0.1, 135.0 },
+    { "creep 2 IPS",         2.0,    0.0,   2.0, 2.0, 2.5, 0.3, 0.1,  73.0 },
+    { "creep 5 IPS",         5.0,    0.0,   5.0, 2.0, 2.5, 0.5, 0.1,  60.0 },
+    { "creep 10 IPS",       10.0,    0.0,  10.0, 2.0, 2.5, 0.5, 0.1,  60.0 },
+    { "creep -3 IPS",       -3.0,    0.0,  -3.0, 2.0, 2.5, 0.5, 0.1,  60.0 },
+    { "play 15 IPS",        15.0,    0.0,  15.0, 5.0, 5.0, 1.0, 0.1,   0.0 },
+    { "play 30 IPS",        30.0,    0.0,  30.0, 4.0, 5.0, 1.0, 0.1,  60.0 },
+    { "shuttle 380 IPS",   380.0,    0.0, 380.0, 5.0, 5.0, 1.0, 0.1,   0.0 },
+    { "ramp to 380 IPS",     0.0,  300.0, 380.0, 3.0, 3.0, 3.0, 0.2,   0.0 },
+    { "rewind 380 IPS",   -380.0,    0.0,-380.0, 5.0, 5.0, 1.0, 0.1,   0.0 },
+    { "brake from 380",    380.0, -300.0,   0.0, 1.267, 1.6, 3.0, 0.2,  60.0 },
+};
+
+#define NUM_CASES   (sizeof(s_cases) / sizeof(s_cases[0]))
+
+/* Static Function Prototypes */
+static bool Run(const CASE* c, uint32_t* seed);
+static double Speed(const CASE* c, double t);
+static double Uniform(uint32_t* seed);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("motion estimator: 5 ms poll, 25 ms timer and index samples, seed %u\n\n", seed);
+
+    printf("%-18s %8s %9s %9s %9s %6s %8s %6s\n", "case", "samples", "rms IPS", "max IPS",
+           "max in", "drops", "stop ms", "check");
+
+    for (i=0; i < NUM_CASES; i++)
+    {
+        if (!Run(&s_cases[i], &seed))
+            errors++;
+    }
+
+    printf("\nrms and max IPS: velocity error, in: predicted position error at\n");
+    printf("each poll, both after %.1f s. drops: polls the tape read as stopped\n", SETTLE_TIME);
+    printf("while moving, or with a velocity once stopped. stop ms: time from the\n");
+    printf("stop to the first poll that saw it\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Run one speed profile. Returns false if the errors are over the limits. */
+static bool Run(const CASE* c, uint32_t* seed)
+{
+    MOTION_EST est;
+    MOTION_STATE state;
+    double t = 0.0;
+    double x = 1000.0;
+    double v;
+    double nextPoll = 0.0;
+    double nextTimer = Uniform(seed) * TIMER_PERIOD;
+    double sumV = 0.0, maxV = 0.0, maxX = 0.0;
+    double stopTime = -1.0;
+    double err, pos;
+    uint32_t samples = 0, n = 0;
+    uint32_t drops = 0;
+    uint32_t base;
+    int64_t ticks, last;
+    bool sample, poll;
+    bool ok;
+
+    /* Start the timestamp so it wraps partway through */
+    base = 0xFFFFFFFFu - (uint32_t)(c->time * 0.5 * TIMESTAMP_FREQ);
+
+    MotionEst_init(&est, (uint32_t)TIMESTAMP_FREQ, (float)INCHES_PER_TICK);
+
+    last = (int64_t)floor(x / INCHES_PER_TICK);
+
+    while (t < c->time)
+    {
+        v  = Speed(c, t);
+        x += v * STEP;
+        t += STEP;
+
+        ticks  = (int64_t)floor(x / INCHES_PER_TICK);
+        sample = false;
+        poll   = false;
+
+        /* Index pulse once a roller turn */
+        if ((ticks / ROLLER_TICKS) != (last / ROLLER_TICKS))
+            sample = true;
+
+        last = ticks;
+
+        if (t >= nextTimer)
+        {
+            nextTimer += TIMER_PERIOD;
+            sample = true;
+        }
+
+        if (t >= nextPoll)
+        {
+            nextPoll += POLL_PERIOD + (Uniform(seed) * POLL_LATENCY);
+            sample = poll = true;
+        }
+
+        if (!sample)
+            continue;
+
+        MotionEst_update(&est, ticks, base + (uint32_t)(t * TIMESTAMP_FREQ));
+        samples++;
+
+        if (!poll || (t < SETTLE_TIME))
+            continue;
+
+        MotionEst_getState(&est, &state);
+
+        if (t < c->stop)
+        {
+            if (!state.moving)
+                drops++;
+        }
+        else if (state.moving)
+        {
+            continue;
+        }
+        else
+        {
+            if (stopTime < 0.0)
+                stopTime = t - c->stop;
+
+            /* Nothing left over from the edge velocity */
+            if ((state.velocity != 0.0f) || (state.accel != 0.0f))
+                drops++;
+        }
+
+        err = fabs((double)state.velocity - Speed(c, t));
+
+        if (!isfinite(err))
+            err = 1e9;
+
+        sumV += err * err;
+
+        if (err > maxV)
+            maxV = err;
+
+        /* Position the other tasks get from the state */
+        pos = ((double)state.position + MotionEst_predict(&est, &state, base +
+               (uint32_t)(t * TIMESTAMP_FREQ))) * INCHES_PER_TICK;
+
+        err = fabs(pos - x);
+
+        if (!isfinite(err))
+            err = 1e9;
+
+        if (err > maxX)
+            maxX = err;
+
+        n++;
+    }
+
+    sumV = n ? sqrt(sumV / n) : 0.0;
+
+    ok = (sumV <= c->rmsMax) && (maxX <= c->posMax) && !drops;
+
+    if (c->stop < c->time)
+    {
+        if ((stopTime < 0.0) || ((stopTime * 1000.0) > c->stopMax))
+            ok = false;
+
+        printf("%-18s %8u %9.3f %9.2f %9.4f %6u %8.1f %6s\n", c->name, samples, sumV, maxV,
+               maxX, drops, stopTime * 1000.0, ok ? "ok" : "FAIL");
+    }
+    else
+    {
+        printf("%-18s %8u %9.3f %9.2f %9.4f %6u %8s %6s\n", c->name, samples, sumV, maxV,
+               maxX, drops, "-", ok ? "ok" : "FAIL");
+    }
+
+    return ok;
+}
+
+/* True tape speed at a time */
+static double Speed(const CASE* c, double t)
+{
+    double v = c->v0 + (c->accel * t);
+
+    if (t >= c->stop)
+        return 0.0;
+
+    if ((c->accel > 0.0) && (v > c->vmax))
+        v = c->vmax;
+    else if ((c->accel < 0.0) && (v < c->vmax))
+        v = c->vmax;
+
+    return v;
+}
+
+/* Uniform in [0, 1) */
+static double Uniform(uint32_t* seed)
+{
+    return (double)Random(seed) / 4294967296.0;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
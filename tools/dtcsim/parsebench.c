@@ -0,0 +1,1118 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Frame parser test and benchmark. A receive stream of IPC or RAMP frames
+ * built with the firmware frame builder is mixed with line noise, stray
+ * preamble bytes, frames with bits flipped and frames cut short with the
+ * line going idle after them. It is then received four ways:
+ *
+ *   feed     the whole stream fed to FrameParse_feed() at once
+ *   chunks   the stream fed in chunks of random size
+ *   reads    UART reads through the parser ring as IPC_FrameRx() and
+ *            RAMP_RxFrame() read, timing out where the line goes idle
+ *   legacy   IPC_FrameRx() and RAMP_RxFrame() as they were, reading a
+ *            byte at a time, kept here as they were
+ *
+ * The frames received in chunks must be the frames received from the
+ * whole stream, and every frame put in whole must be received by the
+ * parser. Frames a reader missed, and any it received that weren't sent,
+ * are counted along with the UART reads each frame took.
+ *
+ * A stream can be written to a file with -w, and a file of bytes received,
+ * such as one captured from the port, can be read back with -r. A stream
+ * read from a file is received the same ways, but with no list of the
+ * frames sent only the chunk check is made.
+ *
+ * The exit status is 1 if the chunks and the whole stream differ, or the
+ * parser missed a frame with no false frame found to have taken it.
+ *
+ * Usage:
+ *   parsebench [-n frames] [-s seed] [-p ipc|ramp] [-c chunk] [-r file] [-w file]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "CRC16.h"
+#include "IPCFrameDefs.h"
+#include "RAMPFrameDefs.h"
+#include "FrameBuild.h"
+#include "FrameParse.h"
+
+/* Handle of the stand-in UART the receivers read from */
+typedef void* BENCH_UART;
+
+/* Bytes in the IPC_MSG the IPC server sends */
+#define BENCH_IPC_MSG           12
+
+/* Text bytes in a RAMP display frame */
+#define BENCH_RAMP_DISPLAY      (1024 + 8)
+
+/* Frames ahead of the next expected a frame received is matched to */
+#define BENCH_MATCH_WINDOW      256
+
+/* A frame sent or received */
+typedef struct _BENCH_FRAME {
+    uint8_t     type;
+    uint8_t     seqnum;
+    uint8_t     acknak;
+    uint8_t     address;
+    uint16_t    textlen;
+    uint32_t    hash;               /* of the text                  */
+} BENCH_FRAME;
+
+typedef struct _BENCH_LIST {
+    BENCH_FRAME* frame;
+    uint32_t    count;
+    uint32_t    size;
+} BENCH_LIST;
+
+/* A receive stream and the frames put in it whole */
+typedef struct _BENCH_STREAM {
+    uint8_t*    data;
+    size_t      len;
+    size_t      size;
+    size_t*     gap;                /* where the line goes idle     */
+    size_t      gaps;
+    size_t      gapSize;
+    BENCH_LIST  sent;
+    uint32_t    noise;              /* bytes of line noise          */
+    uint32_t    flipped;            /* frames with bits flipped     */
+    uint32_t    cut;                /* frames cut short             */
+} BENCH_STREAM;
+
+/* A receive pass */
+typedef struct _BENCH_RESULT {
+    BENCH_LIST  list;
+    uint32_t    missed;
+    uint32_t    extra;              /* received and not sent        */
+    uint32_t    reads;
+    double      time;
+    FRAME_STATS stats;
+} BENCH_RESULT;
+
+/* UART receive stub */
+static const BENCH_STREAM* s_rx;
+static size_t s_rxPos;
+static size_t s_rxGap;
+static uint32_t s_reads;
+
+/* Display buffer the legacy RAMP reader puts display frames in */
+static uint8_t s_screen[BENCH_RAMP_DISPLAY];
+
+/* Text length the legacy RAMP reader received, which it doesn't return */
+static uint16_t s_rampTextLen;
+
+/* Static Function Prototypes */
+static void Generate(BENCH_STREAM* st, int protocol, uint32_t frames, uint32_t* seed);
+static size_t Frame(BENCH_STREAM* st, int protocol, uint32_t* seed, BENCH_FRAME* bf);
+static void Feed(const BENCH_STREAM* st, int protocol, size_t chunk, uint32_t seed,
+                 BENCH_RESULT* res);
+static void Reads(const BENCH_STREAM* st, int protocol, BENCH_RESULT* res);
+static void Legacy(const BENCH_STREAM* st, int protocol, BENCH_RESULT* res);
+static int RingRx(BENCH_UART handle, FRAME_PARSER* parser, FRAME_RX* frame);
+static int LegacyIPCRx(BENCH_UART handle, IPC_FCB* fcb, void* txtbuf, uint16_t* txtlen);
+static int LegacyRAMPRx(BENCH_UART handle, RAMP_FCB* fcb, void* text, uint16_t textlen);
+static int UART_read(BENCH_UART handle, void* buffer, size_t size);
+static unsigned char* GrGetScreenBuffer(size_t offset);
+static void Rewind(const BENCH_STREAM* st);
+static void Score(const BENCH_LIST* sent, BENCH_RESULT* res);
+static bool Same(const BENCH_LIST* a, const BENCH_LIST* b);
+static void Add(BENCH_LIST* list, uint8_t type, uint8_t seqnum, uint8_t acknak,
+                uint8_t address, const uint8_t* text, uint16_t textlen);
+static void Put(BENCH_STREAM* st, const void* data, size_t len);
+static void Gap(BENCH_STREAM* st);
+static bool AckOnly(uint8_t type);
+static uint32_t Hash(const uint8_t* text, size_t len);
+static void* Grow(void* p, size_t* size, size_t need, size_t elem);
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    static const char* names[] = { "ipc", "ramp" };
+    uint32_t frames = 20000;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    size_t chunk = 512;
+    const char* rfile = NULL;
+    const char* wfile = NULL;
+    int first = FRAME_IPC;
+    int last = FRAME_RAMP;
+    int protocol, i, opt;
+    BENCH_STREAM st;
+    BENCH_RESULT res[4];
+    FILE* fp;
+
+    static const char* readers[] = { "feed", "chunks", "reads", "legacy" };
+
+    while ((opt = getopt(argc, argv, "n:s:p:c:r:w:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            frames = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            first = last = (strcmp(optarg, "ramp") == 0) ? FRAME_RAMP : FRAME_IPC;
+            break;
+        case 'c':
+            chunk = (size_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rfile = optarg;
+            break;
+        case 'w':
+            wfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames] [-s seed] [-p ipc|ramp] [-c chunk] "
+                    "[-r file] [-w file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    if (!chunk)
+        chunk = 1;
+
+    /* A stream file is of one protocol */
+    if ((rfile || wfile) && (first != last))
+        last = first;
+
+    for (protocol=first; protocol <= last; protocol++)
+    {
+        memset(&st, 0, sizeof(st));
+
+        if (rfile)
+        {
+            if ((fp = fopen(rfile, "rb")) == NULL)
+            {
+                perror(rfile);
+                return 1;
+            }
+
+            fseek(fp, 0, SEEK_END);
+            st.size = (size_t)ftell(fp) + 1;
+            st.data = malloc(st.size);
+            fseek(fp, 0, SEEK_SET);
+            st.len = fread(st.data, 1, st.size, fp);
+            fclose(fp);
+
+            printf("%s stream: %zu bytes from %s\n", names[protocol], st.len, rfile);
+        }
+        else
+        {
+            printf("%s stream: %u frames, seed %u\n", names[protocol], frames, seed);
+
+            Generate(&st, protocol, frames, &seed);
+
+            printf("%zu bytes, %u frames whole, %u with bits flipped, %u cut short, "
+                   "%u noise bytes\n", st.len, st.sent.count, st.flipped, st.cut, st.noise);
+        }
+
+        if (wfile)
+        {
+            if (((fp = fopen(wfile, "wb")) == NULL) ||
+                (fwrite(st.data, 1, st.len, fp) != st.len))
+            {
+                perror(wfile);
+                return 1;
+            }
+
+            fclose(fp);
+        }
+
+        memset(res, 0, sizeof(res));
+
+        Feed(&st, protocol, 0, seed, &res[0]);
+        Feed(&st, protocol, chunk, seed, &res[1]);
+        Reads(&st, protocol, &res[2]);
+        Legacy(&st, protocol, &res[3]);
+
+        printf("\n%-8s %8s %8s %8s %10s %9s %8s %8s %8s\n", "reader", "frames", "missed",
+               "false", "reads/frm", "MB/s", "crc", "length", "resyncs");
+
+        for (i=0; i < 4; i++)
+        {
+            if (!rfile)
+                Score(&st.sent, &res[i]);
+
+            printf("%-8s %8u %8u %8u %10.2f %9.1f", readers[i], res[i].list.count,
+                   res[i].missed, res[i].extra,
+                   res[i].list.count ? ((double)res[i].reads / res[i].list.count) : 0.0,
+                   res[i].time ? ((double)st.len / res[i].time / 1.0e6) : 0.0);
+
+            if (i < 3)
+                printf(" %8u %8u %8u\n", res[i].stats.crc, res[i].stats.length,
+                       res[i].stats.resyncs);
+            else
+                printf("\n");
+        }
+
+        if (!Same(&res[0].list, &res[1].list))
+        {
+            printf("frames received in chunks differ from the whole stream\n");
+            errors++;
+        }
+
+        for (i=0; i < 3; i++)
+        {
+            if (res[i].missed && !res[i].extra)
+            {
+                printf("%s missed frames sent whole\n", readers[i]);
+                errors++;
+            }
+        }
+
+        printf("skipped %u bytes, %u preamble errors, %u frames cut short\n\n",
+               res[2].stats.skipped, res[2].stats.preamble, res[2].stats.aborted);
+
+        for (i=0; i < 4; i++)
+            free(res[i].list.frame);
+
+        free(st.data);
+        free(st.gap);
+        free(st.sent.frame);
+    }
+
+    printf("reads/frm: UART_read() calls per frame received, each a driver\n");
+    printf("call and semaphore wait on the STC. MB/s is host time.\n");
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Build a stream of frames with line noise and damaged frames between */
+static void Generate(BENCH_STREAM* st, int protocol, uint32_t frames, uint32_t* seed)
+{
+    uint8_t msb = (protocol == FRAME_RAMP) ? PREAMBLE_MSB : IPC_PREAMBLE_MSB;
+    uint8_t lsb = (protocol == FRAME_RAMP) ? PREAMBLE_LSB : IPC_PREAMBLE_LSB;
+    uint8_t fake[4];
+    uint8_t b;
+    uint32_t bit[3];
+    uint32_t i, j, r, n, k;
+    size_t start, len;
+    BENCH_FRAME bf;
+
+    for (i=0; i < frames; i++)
+    {
+        r = Random(seed) % 100;
+
+        if (r < 15)
+        {
+            /* Line noise, with some preamble bytes in it */
+            for (n = 1 + (Random(seed) % 64); n; n--)
+            {
+                b = (Random(seed) % 8) ? (uint8_t)Random(seed) : msb;
+                Put(st, &b, 1);
+                st->noise++;
+            }
+        }
+        else if (r < 20)
+        {
+            /* A stray preamble, maybe with a frame length */
+            fake[0] = msb;
+            fake[1] = lsb;
+            fake[2] = (uint8_t)(Random(seed) & 0x07);
+            fake[3] = (uint8_t)Random(seed);
+            n = 1 + (Random(seed) % 4);
+            Put(st, fake, n);
+            st->noise += n;
+        }
+
+        start = st->len;
+        len = Frame(st, protocol, seed, &bf);
+        r = Random(seed) % 100;
+
+        if (r < 85)
+        {
+            Add(&st->sent, bf.type, bf.seqnum, bf.acknak, bf.address, NULL, 0);
+            st->sent.frame[st->sent.count - 1] = bf;
+
+            /* The line goes idle now and then */
+            if ((Random(seed) % 10) == 0)
+                Gap(st);
+        }
+        else if (r < 93)
+        {
+            /* Flip from one to three bits, all different */
+            k = 1 + (Random(seed) % 3);
+
+            for (j=0; j < k; j++)
+            {
+                do {
+                    bit[j] = Random(seed) % (uint32_t)(len * 8);
+                } while (((j > 0) && (bit[j] == bit[0])) || ((j > 1) && (bit[j] == bit[1])));
+
+                st->data[start + (bit[j] >> 3)] ^= (uint8_t)(1 << (bit[j] & 7));
+            }
+            st->flipped++;
+        }
+        else
+        {
+            /* Cut short and the line goes idle */
+            st->len = start + 1 + (Random(seed) % (len - 1));
+            st->cut++;
+            Gap(st);
+        }
+    }
+}
+
+/* Put a random frame of the sizes sent in the stream */
+static size_t Frame(BENCH_STREAM* st, int protocol, uint32_t* seed, BENCH_FRAME* bf)
+{
+    static uint8_t text[MAX_TEXT_LEN];
+    static uint8_t frame[RAMP_FRAME_MAX];
+    uint32_t r = Random(seed) % 100;
+    uint16_t textlen;
+    uint8_t type;
+    size_t i, len;
+    IPC_FCB ipc;
+    RAMP_FCB ramp;
+
+    if (r < 20)
+    {
+        type = (r & 1) ? IPC_NAK_ONLY : IPC_ACK_ONLY;
+        textlen = 0;
+    }
+    else if (protocol == FRAME_IPC)
+    {
+        type = IPC_MSG_ONLY + (uint8_t)(Random(seed) % 4);
+
+        if (r < 70)
+            textlen = BENCH_IPC_MSG;
+        else if (r < 75)
+            textlen = 0;
+        else
+            textlen = (uint16_t)(Random(seed) % (IPC_MAX_TEXT_LEN + 1));
+    }
+    else
+    {
+        if (r < 60)
+        {
+            type = TYPE_MSG_USER;
+            textlen = BENCH_RAMP_DISPLAY;
+        }
+        else
+        {
+            /* The display frames alone are user defined */
+            type = TYPE_MSG_ONLY + (uint8_t)(Random(seed) % 3);
+            textlen = (uint16_t)(Random(seed) % ((r < 80) ? 65 : (MAX_TEXT_LEN + 1)));
+        }
+    }
+
+    for (i=0; i < textlen; i++)
+        text[i] = (uint8_t)Random(seed);
+
+    if (protocol == FRAME_IPC)
+    {
+        ipc.type   = IPC_MAKETYPE(Random(seed) & 0xE0, type);
+        ipc.seqnum = (uint8_t)Random(seed);
+        ipc.acknak = (uint8_t)Random(seed);
+        len = IPC_FrameBuild(frame, &ipc, text, textlen);
+        type = ipc.type;
+        ramp.seqnum  = ipc.seqnum;
+        ramp.acknak  = ipc.acknak;
+        ramp.address = 0;
+    }
+    else
+    {
+        ramp.type    = MAKETYPE(Random(seed) & 0xE0, type);
+        ramp.seqnum  = (uint8_t)Random(seed);
+        ramp.acknak  = (uint8_t)Random(seed);
+        ramp.address = (uint8_t)Random(seed);
+        len = RAMP_FrameBuild(frame, &ramp, text, textlen);
+        type = ramp.type;
+    }
+
+    Put(st, frame, len);
+
+    bf->type    = type;
+    bf->seqnum  = AckOnly(type) ? 0 : ramp.seqnum;
+    bf->acknak  = ramp.acknak;
+    bf->address = ramp.address;
+    bf->textlen = textlen;
+    bf->hash    = Hash(text, textlen);
+
+    return len;
+}
+
+/* Feed the stream to the parser whole, or in chunks of random size */
+static void Feed(const BENCH_STREAM* st, int protocol, size_t chunk, uint32_t seed,
+                 BENCH_RESULT* res)
+{
+    static uint8_t buf[RAMP_FRAME_MAX];
+    FRAME_PARSER parser;
+    FRAME_RX frame;
+    size_t pos = 0;
+    size_t len, used;
+    double t;
+
+    FrameParse_init(&parser, protocol, buf, sizeof(buf));
+
+    t = Now();
+
+    while (pos < st->len)
+    {
+        len = st->len - pos;
+
+        if (chunk && (len > chunk))
+            len = 1 + (Random(&seed) % chunk);
+
+        res->reads++;
+
+        while (FrameParse_feed(&parser, &st->data[pos], len, &used, &frame))
+        {
+            Add(&res->list, frame.type, frame.seqnum, frame.acknak, frame.address,
+                frame.text, frame.textlen);
+            pos += used;
+            len -= used;
+        }
+
+        pos += len;
+    }
+
+    res->time  = Now() - t;
+    res->stats = parser.stats;
+}
+
+/* Receive the stream with UART reads through the parser ring */
+static void Reads(const BENCH_STREAM* st, int protocol, BENCH_RESULT* res)
+{
+    static uint8_t buf[RAMP_FRAME_MAX];
+    FRAME_PARSER parser;
+    FRAME_RX frame;
+    double t;
+
+    FrameParse_init(&parser, protocol, buf, sizeof(buf));
+
+    Rewind(st);
+
+    t = Now();
+
+    for (;;)
+    {
+        if (RingRx(NULL, &parser, &frame) == 0)
+        {
+            Add(&res->list, frame.type, frame.seqnum, frame.acknak, frame.address,
+                frame.text, frame.textlen);
+        }
+        else if (s_rxPos >= st->len)
+        {
+            break;
+        }
+    }
+
+    res->time  = Now() - t;
+    res->reads = s_reads;
+    res->stats = parser.stats;
+}
+
+/* Receive the stream with the old readers */
+static void Legacy(const BENCH_STREAM* st, int protocol, BENCH_RESULT* res)
+{
+    static uint8_t text[MAX_TEXT_LEN];
+    uint16_t textlen;
+    uint8_t type;
+    IPC_FCB ipc;
+    RAMP_FCB ramp;
+    double t;
+    int rc;
+
+    Rewind(st);
+
+    memset(&ipc, 0, sizeof(ipc));
+    memset(&ramp, 0, sizeof(ramp));
+
+    t = Now();
+
+    while (s_rxPos < st->len)
+    {
+        if (protocol == FRAME_IPC)
+        {
+            textlen = IPC_MAX_TEXT_LEN;
+
+            if ((rc = LegacyIPCRx(NULL, &ipc, text, &textlen)) != IPC_ERR_SUCCESS)
+                continue;
+
+            if (AckOnly(ipc.type))
+                ipc.seqnum = 0;
+
+            Add(&res->list, ipc.type, ipc.seqnum, ipc.acknak, 0, text, textlen);
+        }
+        else
+        {
+            if ((rc = LegacyRAMPRx(NULL, &ramp, text, MAX_TEXT_LEN)) != ERR_SUCCESS)
+                continue;
+
+            type = ramp.type & FRAME_TYPE_MASK;
+
+            if (AckOnly(ramp.type))
+                ramp.seqnum = 0;
+
+            if (AckOnly(ramp.type) && (s_rampTextLen == 0xFFFF))
+                s_rampTextLen = 0;
+
+            Add(&res->list, ramp.type, ramp.seqnum, ramp.acknak, ramp.address,
+                (type == TYPE_MSG_USER) ? s_screen : text, s_rampTextLen);
+        }
+    }
+
+    res->time  = Now() - t;
+    res->reads = s_reads;
+}
+
+/* IPC_FrameRx() and RAMP_RxFrame() reading through the parser */
+static int RingRx(BENCH_UART handle, FRAME_PARSER* parser, FRAME_RX* frame)
+{
+    int n;
+    size_t room;
+    uint8_t* ptr;
+
+    /* Take any frame the parser already holds before reading more */
+    while (!FrameParse_next(parser, frame))
+    {
+        room = FrameParse_space(parser, &ptr);
+
+        n = UART_read(handle, ptr, room);
+
+        if (n > 0)
+            FrameParse_commit(parser, (size_t)n);
+
+        if (n == (int)room)
+            continue;
+
+        /* Timed out, a frame may still be complete in the bytes read */
+        if (FrameParse_next(parser, frame))
+            break;
+
+        /* Drop any frame cut short, a frame may have started inside it */
+        FrameParse_abort(parser);
+
+        if (FrameParse_next(parser, frame))
+            break;
+
+        return IPC_ERR_TIMEOUT;
+    }
+
+    return IPC_ERR_SUCCESS;
+}
+
+/* IPC_FrameRx() as it was, reading the frame a byte at a time */
+static int LegacyIPCRx(BENCH_UART handle, IPC_FCB* fcb, void* txtbuf, uint16_t* txtlen)
+{
+    int i;
+    int rc = IPC_ERR_SUCCESS;
+    uint8_t b;
+    uint8_t type;
+    uint16_t lsb;
+    uint16_t msb;
+    uint16_t framelen;
+    uint16_t rxcrc;
+    uint16_t crc = 0;
+
+    uint8_t *textbuf = txtbuf;
+    uint16_t textlen = *txtlen;
+
+    /* No message text bytes received yet */
+    *txtlen = 0;
+
+    /* First, try to synchronize to 0x79 SOF byte */
+
+    i = 0;
+
+    do {
+
+        /* Read the preamble MSB for the frame start */
+        if (UART_read(handle, &b, 1) != 1)
+            return IPC_ERR_TIMEOUT;
+
+        /* Garbage flood check, synch lost?? */
+        if (i++ > (IPC_FRAME_OVERHEAD + IPC_PREAMBLE_OVERHEAD + IPC_MAX_TEXT_LEN))
+            return IPC_ERR_SYNC;
+
+    } while (b != IPC_PREAMBLE_MSB);
+
+    if (UART_read(handle, &b, 1) != 1)
+        return IPC_ERR_TIMEOUT;
+
+    if (b != IPC_PREAMBLE_LSB)
+        return IPC_ERR_SYNC;
+
+    /* CRC starts here, sum in the seed byte first */
+    crc = CRC16Update(crc, IPC_CRC_SEED_BYTE);
+
+    if (UART_read(handle, &b, 1) != 1)
+        return IPC_ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    msb = (uint16_t)b;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return IPC_ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    lsb = (uint16_t)b;
+
+    framelen = (size_t)((msb << 8) | lsb) & 0xFFFF;
+
+    if (framelen > IPC_MAX_FRAME_LEN)
+        return IPC_ERR_FRAME_LEN;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return IPC_ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    fcb->type = b;
+
+    type = (fcb->type & IPC_TYPE_MASK);
+
+    if ((type == IPC_ACK_ONLY) || (type == IPC_NAK_ONLY))
+    {
+        if (framelen != IPC_ACK_FRAME_LEN)
+            return IPC_ERR_ACK_LEN;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return IPC_ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        fcb->acknak = b;
+    }
+    else
+    {
+        if (UART_read(handle, &b, 1) != 1)
+            return IPC_ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        fcb->seqnum = b;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return IPC_ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        fcb->acknak = b;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return IPC_ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        msb = (uint16_t)b;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return IPC_ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        lsb = (uint16_t)b;
+
+        uint16_t rxtextlen = (size_t)((msb << 8) | lsb) & 0xFFFF;
+
+        *txtlen = rxtextlen;
+
+        if (rxtextlen + (IPC_FRAME_OVERHEAD - IPC_PREAMBLE_OVERHEAD) != framelen)
+            return IPC_ERR_TEXT_LEN;
+
+        for (i=0; i < rxtextlen; i++)
+        {
+            if (UART_read(handle, &b, 1) != 1)
+                return IPC_ERR_SHORT_FRAME;
+
+            crc = CRC16Update(crc, b);
+
+            if (i >= textlen)
+            {
+                rc = IPC_ERR_RX_OVERFLOW;
+                continue;
+            }
+
+            if (textbuf)
+                *textbuf++ = b;
+        }
+    }
+
+    if (UART_read(handle, &b, 1) != 1)
+        return IPC_ERR_SHORT_FRAME;
+
+    msb = (uint16_t)b & 0xFF;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return IPC_ERR_SHORT_FRAME;
+
+    lsb = (uint16_t)b & 0xFF;
+
+    rxcrc = (uint16_t)((msb << 8) | lsb) & 0xFFFF;
+
+    if (rxcrc != crc)
+        rc = IPC_ERR_CRC;
+
+    return rc;
+}
+
+/* RAMP_RxFrame() as it was, reading all but the text a byte at a time.
+ * The text length received is kept for the frame to be matched.
+ */
+static int LegacyRAMPRx(BENCH_UART handle, RAMP_FCB* fcb, void* text, uint16_t textlen)
+{
+    int i;
+    int rc = ERR_SUCCESS;
+    uint8_t b;
+    uint8_t type;
+    uint16_t lsb;
+    uint16_t msb;
+    uint16_t framelen;
+    uint16_t rxcrc;
+    uint16_t crc = 0;
+    uint8_t *textbuf = (uint8_t*)text;
+
+    s_rampTextLen = 0xFFFF;
+
+    i = 0;
+
+    do {
+
+        if (UART_read(handle, &b, 1) != 1)
+            return ERR_TIMEOUT;
+
+        if (i++ > (FRAME_OVERHEAD + PREAMBLE_OVERHEAD + MAX_TEXT_LEN))
+            return ERR_SYNC;
+
+    } while (b != PREAMBLE_MSB);
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_TIMEOUT;
+
+    if (b != PREAMBLE_LSB)
+        return ERR_SYNC;
+
+    crc = CRC16Update(crc, CRC_SEED_BYTE);
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    msb = (uint16_t)b;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    lsb = (uint16_t)b;
+
+    framelen = (size_t)((msb << 8) | lsb) & 0xFFFF;
+
+    if (framelen > MAX_FRAME_LEN)
+        return ERR_FRAME_LEN;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    fcb->type = b;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_SHORT_FRAME;
+
+    crc = CRC16Update(crc, b);
+    fcb->address = b;
+
+    type = (fcb->type & FRAME_TYPE_MASK);
+
+    if ((framelen == ACK_FRAME_LEN) && ((type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY)))
+    {
+        if (UART_read(handle, &b, 1) != 1)
+            return ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        fcb->acknak = b;
+    }
+    else
+    {
+        if (UART_read(handle, &b, 1) != 1)
+            return ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        fcb->seqnum = b;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        fcb->acknak = b;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        msb = (uint16_t)b;
+
+        if (UART_read(handle, &b, 1) != 1)
+            return ERR_SHORT_FRAME;
+
+        crc = CRC16Update(crc, b);
+        lsb = (uint16_t)b;
+
+        uint16_t rxtextlen = (size_t)((msb << 8) | lsb) & 0xFFFF;
+
+        s_rampTextLen = rxtextlen;
+
+        if (rxtextlen + (FRAME_OVERHEAD - PREAMBLE_OVERHEAD) != framelen)
+            return ERR_TEXT_LEN;
+
+        if (type == TYPE_MSG_USER)
+        {
+            textbuf = GrGetScreenBuffer(5);
+            textlen = 1024 + 8;
+        }
+
+        if (rxtextlen > textlen)
+        {
+            rc = ERR_RX_OVERFLOW;
+        }
+        else
+        {
+            if (UART_read(handle, textbuf, rxtextlen) != rxtextlen)
+                return ERR_SHORT_FRAME;
+
+            for (i=0; i < rxtextlen; i++)
+                crc = CRC16Update(crc, *textbuf++);
+        }
+    }
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_SHORT_FRAME;
+
+    msb = (uint16_t)b & 0xFF;
+
+    if (UART_read(handle, &b, 1) != 1)
+        return ERR_SHORT_FRAME;
+
+    lsb = (uint16_t)b & 0xFF;
+
+    rxcrc = (uint16_t)((msb << 8) | lsb) & 0xFFFF;
+
+    if (rxcrc != crc)
+        rc = ERR_CRC;
+
+    return rc;
+}
+
+/* Read from the stream, timing out where the line goes idle */
+static int UART_read(BENCH_UART handle, void* buffer, size_t size)
+{
+    size_t end = s_rx->len;
+    size_t n;
+
+    (void)handle;
+
+    s_reads++;
+
+    while ((s_rxGap < s_rx->gaps) && (s_rx->gap[s_rxGap] < s_rxPos))
+        s_rxGap++;
+
+    if ((s_rxGap < s_rx->gaps) && (s_rx->gap[s_rxGap] < end))
+        end = s_rx->gap[s_rxGap];
+
+    n = end - s_rxPos;
+
+    if (n > size)
+        n = size;
+
+    memcpy(buffer, &s_rx->data[s_rxPos], n);
+    s_rxPos += n;
+
+    /* The read timed out, the line is busy again after */
+    if ((n < size) && (s_rxGap < s_rx->gaps))
+        s_rxGap++;
+
+    return (int)n;
+}
+
+/* The display buffer at an offset */
+static unsigned char* GrGetScreenBuffer(size_t offset)
+{
+    (void)offset;
+
+    return s_screen;
+}
+
+/* Receive the stream from the start */
+static void Rewind(const BENCH_STREAM* st)
+{
+    s_rx    = st;
+    s_rxPos = 0;
+    s_rxGap = 0;
+    s_reads = 0;
+}
+
+/* Match the frames received to the frames sent whole, in order */
+static void Score(const BENCH_LIST* sent, BENCH_RESULT* res)
+{
+    const BENCH_FRAME* rx;
+    const BENCH_FRAME* tx;
+    uint32_t next = 0;
+    uint32_t i, j;
+
+    for (i=0; i < res->list.count; i++)
+    {
+        rx = &res->list.frame[i];
+
+        for (j=next; (j < sent->count) && (j < next + BENCH_MATCH_WINDOW); j++)
+        {
+            tx = &sent->frame[j];
+
+            if ((rx->type == tx->type) && (rx->seqnum == tx->seqnum) &&
+                (rx->acknak == tx->acknak) && (rx->address == tx->address) &&
+                (rx->textlen == tx->textlen) && (rx->hash == tx->hash))
+                break;
+        }
+
+        if ((j < sent->count) && (j < next + BENCH_MATCH_WINDOW))
+        {
+            res->missed += j - next;
+            next = j + 1;
+        }
+        else
+        {
+            res->extra++;
+        }
+    }
+
+    res->missed += sent->count - next;
+}
+
+/* The same frames in the same order */
+static bool Same(const BENCH_LIST* a, const BENCH_LIST* b)
+{
+    return (a->count == b->count) &&
+           (!a->count || !memcmp(a->frame, b->frame, a->count * sizeof(BENCH_FRAME)));
+}
+
+/* Add a frame to a list */
+static void Add(BENCH_LIST* list, uint8_t type, uint8_t seqnum, uint8_t acknak,
+                uint8_t address, const uint8_t* text, uint16_t textlen)
+{
+    size_t size = list->size;
+    BENCH_FRAME* bf;
+
+    if (list->count >= list->size)
+    {
+        list->frame = Grow(list->frame, &size, list->count + 1, sizeof(BENCH_FRAME));
+        list->size  = (uint32_t)size;
+    }
+
+    bf = &list->frame[list->count++];
+
+    memset(bf, 0, sizeof(BENCH_FRAME));
+
+    bf->type    = type;
+    bf->seqnum  = seqnum;
+    bf->acknak  = acknak;
+    bf->address = address;
+    bf->textlen = textlen;
+    bf->hash    = Hash(text, textlen);
+}
+
+/* Append bytes to the stream */
+static void Put(BENCH_STREAM* st, const void* data, size_t len)
+{
+    st->data = Grow(st->data, &st->size, st->len + len, 1);
+
+    memcpy(&st->data[st->len], data, len);
+    st->len += len;
+}
+
+/* The line goes idle at the end of the stream so far */
+static void Gap(BENCH_STREAM* st)
+{
+    st->gap = Grow(st->gap, &st->gapSize, st->gaps + 1, sizeof(size_t));
+    st->gap[st->gaps++] = st->len;
+}
+
+/* An ACK/NAK only frame type */
+static bool AckOnly(uint8_t type)
+{
+    type &= FRAME_TYPE_MASK;
+
+    return (type == TYPE_ACK_ONLY) || (type == TYPE_NAK_ONLY);
+}
+
+/* FNV-1a */
+static uint32_t Hash(const uint8_t* text, size_t len)
+{
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    for (i=0; i < len; i++)
+        h = (h ^ text[i]) * 16777619u;
+
+    return h;
+}
+
+/* Grow an array to hold at least the number of elements needed */
+static void* Grow(void* p, size_t* size, size_t need, size_t elem)
+{
+    size_t n = *size;
+
+    if (need <= n)
+        return p;
+
+    while (n < need)
+        n = n ? (n * 2) : 4096;
+
+    if ((p = realloc(p, n * elem)) == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    *size = n;
+
+    return p;
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (*seed = x);
+}
+
+/* End-Of-File */
@@ -0,0 +1,435 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* QEI sample ring test and benchmark. Every sample written carries its
+ * sequence number in all of its fields, so a sample read back torn from
+ * two writes, out of order or twice is seen.
+ *
+ * First a simulated QEI interrupt writes bursts of samples between reads
+ * by several readers, each reading a random number of samples at a time.
+ * Each reader must get every sample in order, or count the ones it lost
+ * to the producer as overruns, and the latest sample must always be the
+ * last one written.
+ *
+ * Then a producer thread writes samples while reader threads drain the
+ * ring and another keeps taking the latest sample. The producer yields
+ * after random bursts, of up to twice the ring length and then of a few
+ * samples, so the readers run between them on a single core too. On more
+ * than one core this is harder on the ring than the firmware, where the
+ * producer is an interrupt on the same core as the readers.
+ *
+ * Last, QEIRing_put() and QEIRing_get() are timed. The exit status is 1 if
+ * any check fails.
+ *
+ * Usage:
+ *   ringbench [-n samples] [-r readers] [-s seed]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "QEIRing.h"
+
+#define MAX_READERS             16
+
+/* Longest producer burst between yields in the second threaded run */
+#define SHORT_BURST             4
+
+typedef struct _READER {
+    QEI_READER      cursor;
+    uint32_t        next;               /* sequence number expected     */
+    uint64_t        read;
+    uint64_t        errors;
+} READER;
+
+typedef struct _THREAD {
+    pthread_t       thread;
+    READER          reader;
+    uint32_t        seed;
+} THREAD;
+
+static QEI_RING s_ring;
+
+static atomic_bool s_done;
+
+/* Static Function Prototypes */
+static uint32_t Interleaved(uint32_t samples, uint32_t readers, uint32_t seed);
+static uint32_t Threaded(uint32_t samples, uint32_t readers, uint32_t seed, uint32_t burst);
+static void Bench(uint32_t samples);
+static void* ReaderThread(void* arg);
+static void* LatestThread(void* arg);
+static void Make(uint32_t seq, QEI_SAMPLE* sample);
+static bool Valid(const QEI_SAMPLE* sample);
+static bool Read(READER* r);
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t samples = 1000000;
+    uint32_t readers = 4;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            samples = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            readers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n samples] [-r readers] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((readers < 1) || (readers > MAX_READERS))
+    {
+        fprintf(stderr, "readers must be 1 to %d\n", MAX_READERS);
+        return 1;
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("qei ring: %u samples, %d slots, %u readers, seed %u\n\n", samples, QEI_RING_SIZE,
+           readers, seed);
+
+    printf("%-12s %10s %10s %10s %8s\n", "test", "written", "read", "overruns", "errors");
+
+    errors += Interleaved(samples, readers, seed);
+    errors += Threaded(samples, readers, seed, QEI_RING_SIZE * 2);
+    errors += Threaded(samples / 10, readers, seed, SHORT_BURST);
+
+    printf("\n");
+
+    Bench(samples);
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Bursts of samples written between reads, as the interrupt preempts the
+ * readers. Returns the check errors.
+ */
+static uint32_t Interleaved(uint32_t samples, uint32_t readers, uint32_t seed)
+{
+    static READER r[MAX_READERS];
+    QEI_SAMPLE sample;
+    uint64_t read = 0, overruns = 0, errors = 0;
+    uint32_t written = 0;
+    uint32_t burst, n, i;
+
+    QEIRing_init(&s_ring);
+
+    if (QEIRing_latest(&s_ring, &sample))
+        errors++;
+
+    for (i=0; i < readers; i++)
+    {
+        memset(&r[i], 0, sizeof(READER));
+        QEIRing_readerInit(&s_ring, &r[i].cursor);
+    }
+
+    while (written < samples)
+    {
+        /* Mostly a few samples, now and then more than the ring holds */
+        burst = (Random(&seed) % 16 == 0) ? (Random(&seed) % (QEI_RING_SIZE * 2)) :
+                                            (Random(&seed) % 4);
+
+        for (n=0; (n < burst) && (written < samples); n++)
+        {
+            Make(written++, &sample);
+            QEIRing_put(&s_ring, &sample);
+        }
+
+        if (written && (!QEIRing_latest(&s_ring, &sample) ||
+                        (sample.count != (int64_t)(written - 1)) || !Valid(&sample)))
+            errors++;
+
+        for (i=0; i < readers; i++)
+        {
+            for (n = Random(&seed) % 8; n; n--)
+            {
+                if (!Read(&r[i]))
+                    break;
+            }
+        }
+    }
+
+    for (i=0; i < readers; i++)
+    {
+        while (Read(&r[i]))
+            continue;
+
+        /* Every sample was read or counted lost */
+        if ((r[i].read + r[i].cursor.overruns) != written)
+            r[i].errors++;
+
+        read     += r[i].read;
+        overruns += r[i].cursor.overruns;
+        errors   += r[i].errors;
+    }
+
+    printf("%-12s %10u %10llu %10llu %8llu\n", "interleaved", written,
+           (unsigned long long)read, (unsigned long long)overruns,
+           (unsigned long long)errors);
+
+    return (uint32_t)errors;
+}
+
+/* A producer thread against reader threads. Returns the check errors. */
+static uint32_t Threaded(uint32_t samples, uint32_t readers, uint32_t seed, uint32_t burst)
+{
+    static THREAD t[MAX_READERS];
+    pthread_t latest;
+    QEI_SAMPLE sample;
+    uint64_t read = 0, overruns = 0, errors = 0;
+    uint64_t latestErrors = 0;
+    uint32_t written;
+    uint32_t n = 0;
+    uint32_t i;
+
+    QEIRing_init(&s_ring);
+
+    atomic_store(&s_done, false);
+
+    for (i=0; i < readers; i++)
+    {
+        memset(&t[i].reader, 0, sizeof(READER));
+        QEIRing_readerInit(&s_ring, &t[i].reader.cursor);
+        t[i].seed = seed + i + 1;
+        pthread_create(&t[i].thread, NULL, ReaderThread, &t[i]);
+    }
+
+    pthread_create(&latest, NULL, LatestThread, &latestErrors);
+
+    for (written=0; written < samples; written++)
+    {
+        if (!n--)
+        {
+            sched_yield();
+            n = Random(&seed) % burst;
+        }
+
+        Make(written, &sample);
+        QEIRing_put(&s_ring, &sample);
+    }
+
+    atomic_store(&s_done, true);
+
+    for (i=0; i < readers; i++)
+    {
+        pthread_join(t[i].thread, NULL);
+
+        /* Every sample was read or counted lost */
+        if ((t[i].reader.read + t[i].reader.cursor.overruns) != written)
+            t[i].reader.errors++;
+
+        read     += t[i].reader.read;
+        overruns += t[i].reader.cursor.overruns;
+        errors   += t[i].reader.errors;
+    }
+
+    pthread_join(latest, NULL);
+
+    errors += latestErrors;
+
+    printf("%-12s %10u %10llu %10llu %8llu\n", (burst > SHORT_BURST) ? "threaded" : "short burst", written,
+           (unsigned long long)read, (unsigned long long)overruns,
+           (unsigned long long)errors);
+
+    return (uint32_t)errors;
+}
+
+/* Time the producer and a reader keeping up with it */
+static void Bench(uint32_t samples)
+{
+    READER r;
+    QEI_SAMPLE sample;
+    double t0, put, get;
+    uint32_t i;
+
+    QEIRing_init(&s_ring);
+
+    memset(&r, 0, sizeof(READER));
+    QEIRing_readerInit(&s_ring, &r.cursor);
+
+    Make(0, &sample);
+
+    t0 = Now();
+
+    for (i=0; i < samples; i++)
+    {
+        sample.count = i;
+        QEIRing_put(&s_ring, &sample);
+    }
+
+    put = (Now() - t0) / samples;
+
+    QEIRing_init(&s_ring);
+    QEIRing_readerInit(&s_ring, &r.cursor);
+
+    get = 0.0;
+
+    for (i=0; i < samples; i += QEI_RING_SIZE / 2)
+    {
+        uint32_t n;
+
+        for (n=0; n < QEI_RING_SIZE / 2; n++)
+            QEIRing_put(&s_ring, &sample);
+
+        t0 = Now();
+
+        while (QEIRing_get(&s_ring, &r.cursor, &sample))
+            continue;
+
+        get += Now() - t0;
+    }
+
+    get /= samples;
+
+    printf("QEIRing_put %.1f ns, QEIRing_get %.1f ns a sample\n", put * 1e9, get * 1e9);
+}
+
+/* A task draining the ring as it fills */
+static void* ReaderThread(void* arg)
+{
+    THREAD* t = (THREAD*)arg;
+    bool done;
+    uint32_t n;
+
+    do {
+        done = atomic_load(&s_done);
+
+        while (Read(&t->reader))
+            continue;
+
+        /* Fall behind now and then */
+        for (n = Random(&t->seed) % 2000; n; n--)
+            __asm__ __volatile__("" ::: "memory");
+
+    } while (!done);
+
+    return NULL;
+}
+
+/* A task taking the latest sample, which must never go backwards */
+static void* LatestThread(void* arg)
+{
+    uint64_t* errors = (uint64_t*)arg;
+    QEI_SAMPLE sample;
+    int64_t last = -1;
+
+    while (!atomic_load(&s_done))
+    {
+        if (!QEIRing_latest(&s_ring, &sample))
+            continue;
+
+        if (!Valid(&sample) || (sample.count < last))
+            (*errors)++;
+
+        last = sample.count;
+    }
+
+    return NULL;
+}
+
+/* A sample with every field taken from its sequence number */
+static void Make(uint32_t seq, QEI_SAMPLE* sample)
+{
+    sample->count     = (int64_t)seq;
+    sample->timestamp = seq * 2654435761u;
+    sample->position  = ~seq;
+    sample->velocity  = seq ^ 0xA5A5A5A5u;
+    sample->direction = (seq & 1) ? 1 : -1;
+    sample->source    = seq & 0x1F;
+}
+
+/* Returns true if a sample's fields all come from the same write */
+static bool Valid(const QEI_SAMPLE* sample)
+{
+    QEI_SAMPLE want;
+
+    Make((uint32_t)sample->count, &want);
+
+    return (sample->timestamp == want.timestamp) && (sample->position == want.position) &&
+           (sample->velocity == want.velocity) && (sample->direction == want.direction) &&
+           (sample->source == want.source);
+}
+
+/* Read a sample and check it follows the last, allowing for overruns */
+static bool Read(READER* r)
+{
+    QEI_SAMPLE sample;
+    uint32_t lost = r->cursor.overruns;
+
+    if (!QEIRing_get(&s_ring, &r->cursor, &sample))
+        return false;
+
+    r->next += r->cursor.overruns - lost;
+
+    if (!Valid(&sample) || ((uint32_t)sample.count != r->next))
+        r->errors++;
+
+    r->next = (uint32_t)sample.count + 1;
+    r->read++;
+
+    return true;
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
@@ -0,0 +1,587 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Sequence lock torture test. A record laid out like TRANSPORT_STATE is
+ * published the way TransportState.c publishes it: four writer threads,
+ * standing in for the position task, the IPC notification handlers, the
+ * locator and the cue editor, each update their own part of both copies
+ * under the lock. The writers are serialized with a mutex where the
+ * firmware disables the task scheduler. Reader threads take snapshots of
+ * the whole record as TransportState_get() does.
+ *
+ * Every field of a part carries the count of writes to that part, so a
+ * part torn between two writes is seen. The counts of all the parts must
+ * add up to the number of writes the snapshot's sequence says were done,
+ * so a snapshot taken across a write to another part is seen too, and
+ * neither may go backwards for a reader. The sequence starts just short
+ * of the 32 bit wrap so it wraps during the run.
+ *
+ * The same record is then written and read with no lock, which must show
+ * torn snapshots for the test to mean anything. On a single core this
+ * needs the scheduler to preempt a reader partway through a copy, so the
+ * unlocked count is shown but not checked. The exit status is 1 if a
+ * locked snapshot is ever inconsistent.
+ *
+ * Usage:
+ *   seqlockbench [-t seconds] [-r readers] [-s seed]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+/* The firmware needs no barrier on its single core. Host threads may run
+ * on different cores, so use a full fence.
+ */
+#define SEQLOCK_BARRIER()       __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#include "Seqlock.h"
+
+#define MAX_READERS             16
+
+/* Cue points in the record, as MAX_CUE_POINTS */
+#define CUE_POINTS              15
+
+/* Writes done before the sequence wraps */
+#define WRAP_WRITES             5000
+
+/* The parts of the record and their writers */
+#define PART_POSITION           0
+#define PART_MODE               1
+#define PART_SEARCH             2
+#define PART_CUES               3
+#define NUM_PARTS               4
+
+typedef struct _TIME_PART {
+    uint8_t     hour, mins, secs, tens, frame, flags;
+} TIME_PART;
+
+typedef struct _CUE_PART {
+    int32_t     ipos;
+    uint32_t    flags;
+} CUE_PART;
+
+/* A record with the parts and size of TRANSPORT_STATE */
+typedef struct _RECORD {
+    /* Position task */
+    int32_t     tapePosition;
+    uint32_t    tapePositionAbs;
+    int32_t     tapeDirection;
+    float       tapeTach;
+    float       tapeVelocity;
+    uint32_t    tapeTimestamp;
+    TIME_PART   tapeTime;
+    uint16_t    timelineEvent;
+    uint16_t    timelineCount;
+    /* DTC notifications */
+    uint32_t    transportMode;
+    uint32_t    tapeSpeed;
+    uint32_t    ledMaskTransport;
+    uint32_t    takeLast;
+    bool        takeRecording;
+    /* Locator */
+    int32_t     searchProgress;
+    uint32_t    searchETA;
+    bool        searching;
+    bool        autoLoop;
+    bool        autoPunch;
+    bool        sequencing;
+    bool        punching;
+    /* Cue editor */
+    CUE_PART    cuePoint[CUE_POINTS];
+} RECORD;
+
+typedef struct _READER {
+    pthread_t   thread;
+    uint32_t    seed;
+    bool        locked;
+    uint64_t    snapshots;
+    uint64_t    retries;
+    uint32_t    maxRetries;
+    uint64_t    torn;               /* a part torn between writes    */
+    uint64_t    skewed;             /* parts from different instants */
+    uint64_t    backwards;          /* older than a snapshot before  */
+} READER;
+
+typedef struct _WRITER {
+    pthread_t   thread;
+    uint32_t    seed;
+    uint32_t    part;
+    bool        locked;
+    uint64_t    writes;
+} WRITER;
+
+static SEQLOCK s_lock;
+static volatile RECORD s_record[2];
+static uint32_t s_start;
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static atomic_bool s_done;
+
+/* Static Function Prototypes */
+static uint32_t Run(bool locked, double seconds, uint32_t readers, uint32_t seed);
+static void* WriterThread(void* arg);
+static void* ReaderThread(void* arg);
+static void Publish(uint32_t part, uint32_t count);
+static void Update(volatile RECORD* p, uint32_t part, uint32_t count);
+static void Get(READER* r, RECORD* rec, uint32_t* seq);
+static bool Part(const RECORD* rec, uint32_t part, uint32_t* count);
+static double TimeGet(bool locked);
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    double seconds = 2.0;
+    uint32_t readers = 3;
+    uint32_t seed = 1;
+    uint32_t errors;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:r:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 'r':
+            readers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-r readers] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((readers < 1) || (readers > MAX_READERS))
+    {
+        fprintf(stderr, "readers must be 1 to %d\n", MAX_READERS);
+        return 1;
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("seqlock: %zu byte record, %d writers, %u readers, %.1f s a run, seed %u\n\n",
+           sizeof(RECORD), NUM_PARTS, readers, seconds, seed);
+
+    printf("%-9s %10s %11s %9s %7s %7s %7s %7s %9s\n", "run", "writes", "snapshots", "retries",
+           "max", "torn", "skewed", "back", "get ns");
+
+    errors = Run(true, seconds, readers, seed);
+
+    Run(false, seconds, readers, seed);
+
+    printf("\nretries: snapshots taken again, max: the most for one snapshot. torn: a\n");
+    printf("part from two writes, skewed: parts from different writes, back: older\n");
+    printf("than a snapshot the reader took before. Only the locked run is checked\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* One run with or without the lock. Returns the inconsistent snapshots. */
+static uint32_t Run(bool locked, double seconds, uint32_t readers, uint32_t seed)
+{
+    static READER r[MAX_READERS];
+    static WRITER w[NUM_PARTS];
+    uint64_t writes = 0, snapshots = 0, retries = 0;
+    uint64_t torn = 0, skewed = 0, backwards = 0;
+    uint32_t maxRetries = 0;
+    uint32_t i;
+    double t0, t;
+
+    Seqlock_init(&s_lock);
+
+    /* Start short of the wrap */
+    s_lock.sequence = (uint32_t)(0 - (2 * WRAP_WRITES));
+    s_start = s_lock.sequence;
+
+    memset((void*)s_record, 0, sizeof(s_record));
+
+    for (i=0; i < NUM_PARTS; i++)
+    {
+        Update(&s_record[0], i, 0);
+        Update(&s_record[1], i, 0);
+    }
+
+    atomic_store(&s_done, false);
+
+    for (i=0; i < readers; i++)
+    {
+        memset(&r[i], 0, sizeof(READER));
+        r[i].seed   = seed + i + 1;
+        r[i].locked = locked;
+        pthread_create(&r[i].thread, NULL, ReaderThread, &r[i]);
+    }
+
+    for (i=0; i < NUM_PARTS; i++)
+    {
+        memset(&w[i], 0, sizeof(WRITER));
+        w[i].seed   = seed + readers + i + 1;
+        w[i].part   = i;
+        w[i].locked = locked;
+        pthread_create(&w[i].thread, NULL, WriterThread, &w[i]);
+    }
+
+    t0 = Now();
+
+    while ((Now() - t0) < seconds)
+        usleep(10000);
+
+    atomic_store(&s_done, true);
+
+    for (i=0; i < NUM_PARTS; i++)
+    {
+        pthread_join(w[i].thread, NULL);
+        writes += w[i].writes;
+    }
+
+    for (i=0; i < readers; i++)
+    {
+        pthread_join(r[i].thread, NULL);
+
+        snapshots += r[i].snapshots;
+        retries   += r[i].retries;
+        torn      += r[i].torn;
+        skewed    += r[i].skewed;
+        backwards += r[i].backwards;
+
+        if (r[i].maxRetries > maxRetries)
+            maxRetries = r[i].maxRetries;
+    }
+
+    t = TimeGet(locked);
+
+    printf("%-9s %10llu %11llu %9llu %7u %7llu %7llu %7llu %9.1f\n",
+           locked ? "locked" : "unlocked", (unsigned long long)writes,
+           (unsigned long long)snapshots, (unsigned long long)retries, maxRetries,
+           (unsigned long long)torn, (unsigned long long)skewed,
+           (unsigned long long)backwards, t * 1e9);
+
+    /* The sequence must have wrapped for the run to count */
+    if (locked && (writes <= WRAP_WRITES))
+        return 1;
+
+    return (uint32_t)(torn + skewed + backwards);
+}
+
+/* A task publishing its part of the record */
+static void* WriterThread(void* arg)
+{
+    WRITER* w = (WRITER*)arg;
+    uint32_t n;
+
+    while (!atomic_load(&s_done))
+    {
+        w->writes++;
+
+        if (w->locked)
+        {
+            pthread_mutex_lock(&s_mutex);
+            Publish(w->part, (uint32_t)w->writes);
+            pthread_mutex_unlock(&s_mutex);
+        }
+        else
+        {
+            Update(&s_record[0], w->part, (uint32_t)w->writes);
+        }
+
+        /* Let the readers run between writes now and then */
+        n = Random(&w->seed);
+
+        if (!(n % 8))
+            sched_yield();
+
+        for (n %= 200; n; n--)
+            __asm__ __volatile__("" ::: "memory");
+    }
+
+    return NULL;
+}
+
+/* A task taking snapshots and checking them */
+static void* ReaderThread(void* arg)
+{
+    READER* r = (READER*)arg;
+    RECORD rec;
+    uint32_t last[NUM_PARTS] = { 0 };
+    uint32_t count[NUM_PARTS];
+    uint32_t lastSeq = s_start;
+    uint32_t seq, sum;
+    uint32_t i, n;
+    bool torn;
+
+    while (!atomic_load(&s_done))
+    {
+        Get(r, &rec, &seq);
+
+        r->snapshots++;
+
+        torn = false;
+        sum = 0;
+
+        for (i=0; i < NUM_PARTS; i++)
+        {
+            if (!Part(&rec, i, &count[i]))
+                torn = true;
+
+            sum += count[i];
+        }
+
+        if (torn)
+        {
+            r->torn++;
+            continue;
+        }
+
+        /* The counts say when the snapshot was taken */
+        if (r->locked && (sum != ((Seqlock_version(seq) - Seqlock_version(s_start)) & 0x7FFFFFFF)))
+            r->skewed++;
+
+        for (i=0; i < NUM_PARTS; i++)
+        {
+            if (count[i] < last[i])
+                r->backwards++;
+
+            last[i] = count[i];
+        }
+
+        if (r->locked && ((int32_t)(seq - lastSeq) < 0))
+            r->backwards++;
+
+        lastSeq = seq;
+
+        /* Do something else for a while */
+        for (n = Random(&r->seed) % 500; n; n--)
+            __asm__ __volatile__("" ::: "memory");
+    }
+
+    return NULL;
+}
+
+/* As TransportState.c publishes a part, the caller holding off writers */
+static void Publish(uint32_t part, uint32_t count)
+{
+    Seqlock_writeBegin(&s_lock);
+    Update(&s_record[0], part, count);
+
+    Seqlock_writeSwap(&s_lock);
+    Update(&s_record[1], part, count);
+}
+
+/* Write every field of a part from its count */
+static void Update(volatile RECORD* p, uint32_t part, uint32_t count)
+{
+    uint32_t i;
+
+    switch(part)
+    {
+    case PART_POSITION:
+        p->tapePosition     = (int32_t)count;
+        p->tapePositionAbs  = ~count;
+        p->tapeDirection    = (count & 1) ? 1 : -1;
+        p->tapeTach         = (float)(count & 0xFFFF);
+        p->tapeVelocity     = -(float)(count & 0xFFFF);
+        p->tapeTimestamp    = count * 2654435761u;
+        p->tapeTime.hour    = (uint8_t)count;
+        p->tapeTime.mins    = (uint8_t)(count >> 8);
+        p->tapeTime.secs    = (uint8_t)(count >> 16);
+        p->tapeTime.tens    = (uint8_t)(count >> 24);
+        p->tapeTime.frame   = (uint8_t)~count;
+        p->tapeTime.flags   = (uint8_t)(count ^ 0x5A);
+        p->timelineEvent    = (uint16_t)count;
+        p->timelineCount    = (uint16_t)(count >> 16);
+        break;
+
+    case PART_MODE:
+        p->transportMode    = count;
+        p->tapeSpeed        = count ^ 0xA5A5A5A5u;
+        p->ledMaskTransport = ~count;
+        p->takeLast         = count * 3u;
+        p->takeRecording    = (count & 1) ? true : false;
+        break;
+
+    case PART_SEARCH:
+        p->searchProgress   = (int32_t)count;
+        p->searchETA        = ~count;
+        p->searching        = (count & 1) ? true : false;
+        p->autoLoop         = (count & 2) ? true : false;
+        p->autoPunch        = (count & 4) ? true : false;
+        p->sequencing       = (count & 8) ? true : false;
+        p->punching         = (count & 16) ? true : false;
+        break;
+
+    case PART_CUES:
+        for (i=0; i < CUE_POINTS; i++)
+        {
+            p->cuePoint[i].ipos  = (int32_t)(count + i);
+            p->cuePoint[i].flags = ~(count + i);
+        }
+        break;
+    }
+}
+
+/* A snapshot as TransportState_get() takes it */
+static void Get(READER* r, RECORD* rec, uint32_t* seq)
+{
+    uint32_t retries = 0;
+
+    if (!r->locked)
+    {
+        *rec = s_record[0];
+        *seq = 0;
+        return;
+    }
+
+    do {
+        *seq = Seqlock_readBegin(&s_lock);
+
+        *rec = s_record[Seqlock_index(*seq)];
+
+    } while (Seqlock_readRetry(&s_lock, *seq) && ++retries);
+
+    r->retries += retries;
+
+    if (retries > r->maxRetries)
+        r->maxRetries = retries;
+}
+
+/* The count a part was written with. Returns false if its fields differ. */
+static bool Part(const RECORD* rec, uint32_t part, uint32_t* count)
+{
+    uint32_t c;
+    uint32_t i;
+
+    switch(part)
+    {
+    case PART_POSITION:
+        c = (uint32_t)rec->tapePosition;
+
+        *count = c;
+
+        return (rec->tapePositionAbs == ~c) &&
+               (rec->tapeDirection == ((c & 1) ? 1 : -1)) &&
+               (rec->tapeTach == (float)(c & 0xFFFF)) &&
+               (rec->tapeVelocity == -(float)(c & 0xFFFF)) &&
+               (rec->tapeTimestamp == c * 2654435761u) &&
+               (rec->tapeTime.hour == (uint8_t)c) &&
+               (rec->tapeTime.mins == (uint8_t)(c >> 8)) &&
+               (rec->tapeTime.secs == (uint8_t)(c >> 16)) &&
+               (rec->tapeTime.tens == (uint8_t)(c >> 24)) &&
+               (rec->tapeTime.frame == (uint8_t)~c) &&
+               (rec->tapeTime.flags == (uint8_t)(c ^ 0x5A)) &&
+               (rec->timelineEvent == (uint16_t)c) &&
+               (rec->timelineCount == (uint16_t)(c >> 16));
+
+    case PART_MODE:
+        c = rec->transportMode;
+
+        *count = c;
+
+        return (rec->tapeSpeed == (c ^ 0xA5A5A5A5u)) &&
+               (rec->ledMaskTransport == ~c) &&
+               (rec->takeLast == c * 3u) &&
+               (rec->takeRecording == ((c & 1) ? true : false));
+
+    case PART_SEARCH:
+        c = (uint32_t)rec->searchProgress;
+
+        *count = c;
+
+        return (rec->searchETA == ~c) &&
+               (rec->searching == ((c & 1) ? true : false)) &&
+               (rec->autoLoop == ((c & 2) ? true : false)) &&
+               (rec->autoPunch == ((c & 4) ? true : false)) &&
+               (rec->sequencing == ((c & 8) ? true : false)) &&
+               (rec->punching == ((c & 16) ? true : false));
+
+    case PART_CUES:
+        c = (uint32_t)rec->cuePoint[0].ipos;
+
+        *count = c;
+
+        for (i=0; i < CUE_POINTS; i++)
+        {
+            if ((rec->cuePoint[i].ipos != (int32_t)(c + i)) ||
+                (rec->cuePoint[i].flags != ~(c + i)))
+                return false;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+/* Seconds an uncontended snapshot takes */
+static double TimeGet(bool locked)
+{
+    READER r;
+    RECORD rec;
+    uint32_t seq;
+    uint32_t n;
+    double t0;
+
+    memset(&r, 0, sizeof(READER));
+    r.locked = locked;
+
+    t0 = Now();
+
+    for (n=0; n < 1000000; n++)
+        Get(&r, &rec, &seq);
+
+    return (Now() - t0) / n;
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
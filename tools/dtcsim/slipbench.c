@@ -0,0 +1,290 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Roller slip detection test. The simulated transport winds a whole reel
+ * across in fast forward or rewind. The roller encoder goes through the
+ * motion estimator every 5 ms as the position task samples it, and every
+ * 100 ms the estimated roller velocity and the DTC reel tach go to the
+ * slip detector, as the slip task gives them. The reel tach is the mean of
+ * the two reel speeds, so its ratio to the tape speed changes by half as
+ * the packs change across the wind.
+ *
+ * Some cases slip the roller on the tape for a while partway through. The
+ * learned roller to tach ratio must follow the pack changes closely enough
+ * that no slip is flagged on a clean wind. A slip over the threshold must
+ * be flagged once, soon after it starts, and the learned ratio must not
+ * move while it lasts. A slip under the threshold is not meant to be seen.
+ * The distance the detector gives back to correct the position is shown
+ * against the distance the roller missed. The exit status is 1 if any
+ * check fails.
+ *
+ * Usage:
+ *   slipbench [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "MotionEst.h"
+#include "SlipDetect.h"
+#include "IPCMessage.h"
+#include "TransportSim.h"
+
+/* Position task poll and slip task check periods in seconds */
+#define POLL_PERIOD             0.005
+#define CHECK_PERIOD            0.100
+
+/* Tape left on the supply reel when the wind is stopped, inches */
+#define WIND_MARGIN             1500.0
+
+/* A slip is to be flagged within this many checks of starting */
+#define FLAG_CHECKS             (SLIP_CHECKS + 1)
+
+/* The learned ratio may move this much while the roller slips */
+#define RATIO_HOLD              0.01
+
+/* A wind with a roller slip in it */
+typedef struct _CASE {
+    const char* name;
+    bool        rewind;
+    double      slipAt;             /* seconds into the wind        */
+    double      slipTime;           /* seconds the slip lasts       */
+    double      slip;               /* roller travel lost, fraction */
+} CASE;
+
+static const CASE s_cases[] = {
+    { "fwd wind",           false,   0.0, 0.0, 0.00 },
+    { "rew wind",           true,    0.0, 0.0, 0.00 },
+    { "fwd 20% slip 1 s",   false,  80.0, 1.0, 0.20 },
+    { "fwd 30% slip full",  false,  12.0, 0.5, 0.30 },
+    { "rew 50% slip 2 s",   true,   40.0, 2.0, 0.50 },
+    { "fwd 5% slip 2 s",    false,  80.0, 2.0, 0.05 },
+};
+
+#define NUM_CASES   (sizeof(s_cases) / sizeof(s_cases[0]))
+
+/* Static Function Prototypes */
+static bool Run(const CASE* c, uint32_t seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("slip detect: %.0f IPS wind, check every %.0f ms, threshold %.0f%%, seed %u\n\n",
+           SIM_SHUTTLE_VEL, CHECK_PERIOD * 1000.0, SLIP_THRESHOLD * 100.0, seed);
+
+    printf("%-18s %6s %7s %7s %7s %6s %7s %8s %8s %6s\n", "case", "secs", "ratio", "track",
+           "events", "flag", "moved", "missed", "corr", "check");
+
+    for (i=0; i < NUM_CASES; i++)
+    {
+        if (!Run(&s_cases[i], seed))
+            errors++;
+    }
+
+    printf("\nratio: the roller to tach ratio change across the wind, track: the\n");
+    printf("worst learned ratio error off the slip, both %%. flag: seconds from the\n");
+    printf("slip to it being flagged, moved: %% the learned ratio moved during the\n");
+    printf("slip. missed: inches the roller lost, corr: inches given back\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Wind one reel across. Returns false if a check fails. */
+static bool Run(const CASE* c, uint32_t seed)
+{
+    TRANSPORT_SIM sim;
+    MOTION_EST est;
+    MOTION_STATE motion;
+    SLIP_DETECT slip;
+    double nextPoll = 0.0;
+    double nextCheck = CHECK_PERIOD;
+    double start = 0.0;
+    double rollerSlip;
+    double ratio, rmin = 1e9, rmax = 0.0;
+    double track = 0.0, moved = 0.0;
+    double held = 0.0;
+    double flagTime = -1.0;
+    double missed = 0.0, corr = 0.0;
+    double roller, tape, err;
+    double t;
+    uint32_t flags;
+    bool slipping, wound = false;
+    bool ok = true;
+
+    TransportSim_init(&sim, seed, c->rewind ? (SIM_TAPE_LENGTH - WIND_MARGIN) : WIND_MARGIN);
+
+    rollerSlip = sim.slip;
+
+    MotionEst_init(&est, 1000000, SIM_ROLLER_CIRCUM / SIM_ROLLER_TICKS);
+    SlipDetect_init(&slip, 0);
+
+    TransportSim_command(&sim, c->rewind ? OP_MODE_REW : OP_MODE_FWD, 0, 0);
+
+    while (!TransportSim_idle(&sim) || !wound)
+    {
+        /* Stop with a little tape left on the reel */
+        if (!wound && (c->rewind ? (sim.pos < WIND_MARGIN) :
+                                   (sim.pos > (SIM_TAPE_LENGTH - WIND_MARGIN))))
+        {
+            TransportSim_command(&sim, OP_MODE_STOP, 0, 0);
+            wound = true;
+        }
+
+        /* Time into the wind once up to speed */
+        if ((start == 0.0) && (fabs(sim.vel) >= (SIM_SHUTTLE_VEL * 0.99)))
+            start = sim.time;
+
+        t = sim.time - start;
+
+        slipping = (start > 0.0) && (c->slip > 0.0) && (t >= c->slipAt) &&
+                   (t < (c->slipAt + c->slipTime));
+
+        sim.slip = slipping ? rollerSlip * (1.0 - c->slip) : rollerSlip;
+
+        roller = sim.roller;
+        tape   = sim.pos;
+
+        TransportSim_step(&sim);
+
+        if (slipping)
+            missed += fabs(sim.pos - tape) * rollerSlip - fabs(sim.roller - roller);
+
+        if (sim.time >= nextPoll)
+        {
+            nextPoll += POLL_PERIOD;
+            MotionEst_update(&est, TransportSim_encoder(&sim), (uint32_t)(sim.time * 1.0e6));
+        }
+
+        if (sim.time < nextCheck)
+            continue;
+
+        nextCheck += CHECK_PERIOD;
+
+        MotionEst_getState(&est, &motion);
+
+        /* The slip task leaves the IPC link alone while stopped */
+        if (!motion.moving)
+        {
+            SlipDetect_update(&slip, 0.0f, 0.0f, 0, false, CHECK_PERIOD);
+            continue;
+        }
+
+        flags = SlipDetect_update(&slip, motion.velocity, (float)TransportSim_tach(&sim), 0,
+                                  !wound, CHECK_PERIOD);
+
+        corr += SlipDetect_takeCorrection(&slip);
+
+        if ((flags & SLIP_F_SLIP) && (flagTime < 0.0))
+            flagTime = t - c->slipAt;
+
+        if ((start == 0.0) || wound || (fabs(sim.vel) < SIM_SHUTTLE_VEL * 0.99))
+            continue;
+
+        /* The real ratio without any slip */
+        ratio = (rollerSlip * fabs(sim.vel)) / TransportSim_tach(&sim);
+
+        if (ratio < rmin)
+            rmin = ratio;
+
+        if (ratio > rmax)
+            rmax = ratio;
+
+        if (!(flags & SLIP_F_LEARNED))
+            continue;
+
+        if (t < c->slipAt)
+            held = slip.ratio;
+
+        if ((t >= c->slipAt) && (t < (c->slipAt + c->slipTime + CHECK_PERIOD)) && (c->slip > 0.0))
+        {
+            err = fabs((slip.ratio / held) - 1.0);
+
+            if (err > moved)
+                moved = err;
+
+            continue;
+        }
+
+        /* Give the ratio time to settle after a slip */
+        if ((c->slip > 0.0) && (t >= c->slipAt) && (t < (c->slipAt + c->slipTime + 5.0)))
+            continue;
+
+        err = fabs((slip.ratio / ratio) - 1.0);
+
+        if (err > track)
+            track = err;
+    }
+
+    if (c->slip >= SLIP_THRESHOLD)
+    {
+        if ((slip.slipEvents != 1) || (flagTime < 0.0) ||
+            (flagTime > (FLAG_CHECKS * CHECK_PERIOD)) || (moved > RATIO_HOLD) ||
+            (corr > missed))
+            ok = false;
+    }
+    else if (slip.slipEvents)
+    {
+        ok = false;
+    }
+
+    if (track > (SLIP_THRESHOLD / 2.0))
+        ok = false;
+
+    if (flagTime >= 0.0)
+    {
+        printf("%-18s %6.1f %7.1f %7.2f %7u %6.2f %7.2f %8.1f %8.1f %6s\n", c->name,
+               sim.time, ((rmax / rmin) - 1.0) * 100.0, track * 100.0, slip.slipEvents,
+               flagTime, moved * 100.0, missed, corr, ok ? "ok" : "FAIL");
+    }
+    else
+    {
+        printf("%-18s %6.1f %7.1f %7.2f %7u %6s %7.2f %8.1f %8.1f %6s\n", c->name,
+               sim.time, ((rmax / rmin) - 1.0) * 100.0, track * 100.0, slip.slipEvents,
+               "-", moved * 100.0, missed, corr, ok ? "ok" : "FAIL");
+    }
+
+    return ok;
+}
+
+/* End-Of-File */
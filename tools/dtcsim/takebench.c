@@ -0,0 +1,477 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Take log test and benchmark. Runs random record passes through the take
+ * log built for the host, some too short to keep, and appends each take
+ * logged to a journal file the way the main task does. Every so often the
+ * power is cut: the last record may be left torn or cut short, and the
+ * journal is loaded into a new take log the way it is at power up.
+ *
+ * After each pass the take log is checked against a list of every take
+ * logged. Each take held must be found by number and by how many takes
+ * back it is, the takes the ring has dropped must not be, and the newest
+ * take over a tape position must match a scan of the list. After each
+ * power cut the journal loaded must hold every take fully written, and
+ * take numbers must carry on after the last. The lookups are then timed.
+ * The exit status is 1 if any check fails.
+ *
+ * Usage:
+ *   takebench [-n passes] [-c cut every n passes] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "TakeLog.h"
+
+/* Passes are recorded over a reel of this many encoder counts */
+#define BENCH_REEL_COUNTS       (2400L * 80L)
+
+/* Journal file written by the test */
+#define BENCH_JOURNAL           "takebench.jnl"
+
+static TAKE_LOG s_takeLog;
+
+/* Static Function Prototypes */
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+static bool Same(const TAKE_ENTRY* a, const TAKE_ENTRY* b);
+static uint32_t Check(TAKE_LOG* log, const TAKE_ENTRY* ref, uint32_t count, uint32_t oldest,
+                      uint32_t* seed);
+static FILE* JournalCreate(void);
+static bool JournalAppend(FILE* fp, const TAKE_ENTRY* entry);
+static size_t JournalLoad(TAKE_LOG* log, bool* torn);
+static void JournalCut(FILE* fp, uint32_t* seed);
+static void Report(const char* name, double seconds, uint32_t ops);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t passes = 20000;
+    uint32_t cutEvery = 500;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t now = 0;
+    uint32_t i, count, oldest, records, dropped, cuts, torn, ops;
+    int32_t ipos, len;
+    DATETIME time;
+    TAKE_ENTRY* ref;
+    const TAKE_ENTRY* entry;
+    FILE* fp;
+    bool isTorn;
+    size_t loaded;
+    volatile uintptr_t sink = 0;
+    double t;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            passes = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            cutEvery = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n passes] [-c cut every n passes] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    if (!passes || !cutEvery)
+    {
+        fprintf(stderr, "passes and cut interval must be non-zero\n");
+        return 1;
+    }
+
+    printf("take log: %d takes held, %u passes, %zu bytes\n\n",
+           TAKE_LOG_MAX, passes, sizeof(TAKE_LOG));
+
+    /* Every take logged, ref[take - 1] */
+    ref = calloc(passes, sizeof(TAKE_ENTRY));
+
+    memset(&time, 0, sizeof(time));
+
+    TakeLog_init(&s_takeLog);
+
+    if ((fp = JournalCreate()) == NULL)
+        return 1;
+
+    count   = 0;
+    oldest  = 1;
+    records = 0;
+    dropped = 0;
+    cuts    = 0;
+    torn    = 0;
+
+    for (i=0; i < passes; i++)
+    {
+        /* One in ten passes is only a blip into record */
+        len  = (Random(&seed) % 10) ? (int32_t)(TAKE_LENGTH_MIN + (Random(&seed) % 120000)) :
+                                      (int32_t)(Random(&seed) % TAKE_LENGTH_MIN);
+        ipos = (int32_t)(Random(&seed) % BENCH_REEL_COUNTS) - 1000;
+
+        time.sec  = (uint8_t)(i % 60);
+        time.min  = (uint8_t)((i / 60) % 60);
+        time.hour = (uint8_t)((i / 3600) % 24);
+
+        TakeLog_begin(&s_takeLog, ipos, Random(&seed) & 0xFFFFFF, &time, now,
+                      (Random(&seed) & 1) ? TAKE_F_PUNCH : 0);
+
+        now += (uint32_t)len;
+
+        /* About 64 counts per second at 30 IPS */
+        entry = TakeLog_end(&s_takeLog, ipos + (len / 16), now);
+
+        now += 1000 + (Random(&seed) % 30000);
+
+        if (len < TAKE_LENGTH_MIN)
+        {
+            if (entry)
+                errors++;
+
+            dropped++;
+        }
+        else if (!entry || (entry->take != count + 1))
+        {
+            errors++;
+        }
+        else
+        {
+            ref[count++] = *entry;
+
+            if (!JournalAppend(fp, entry))
+                errors++;
+
+            records++;
+        }
+
+        errors += Check(&s_takeLog, ref, count, oldest, &seed);
+
+        /* Cut the power, maybe part way through the last record */
+        if (((i + 1) % cutEvery) == 0)
+        {
+            JournalCut(fp, &seed);
+            fclose(fp);
+
+            loaded = JournalLoad(&s_takeLog, &isTorn);
+
+            if (loaded < ((records && isTorn) ? records - 1 : records))
+                errors++;
+
+            /* A torn record is the last take, which is then lost */
+            if (isTorn && records && (loaded == records - 1))
+            {
+                torn++;
+                count--;
+            }
+
+            /* Take numbers start again if no take was left */
+            if (!loaded)
+            {
+                count  = 0;
+                oldest = 1;
+            }
+
+            if (s_takeLog.next != count + 1)
+                errors++;
+
+            errors += Check(&s_takeLog, ref, count, oldest, &seed);
+
+            /* Start a clean journal from the takes held, as the
+             * firmware does once it finds a torn record
+             */
+            if ((fp = JournalCreate()) == NULL)
+                return 1;
+
+            records = 0;
+            oldest  = count + 1;
+
+            for (ops=s_takeLog.first; ops < s_takeLog.next; ops++)
+            {
+                if ((entry = TakeLog_get(&s_takeLog, ops)) != NULL)
+                {
+                    if (!records)
+                        oldest = entry->take;
+
+                    JournalAppend(fp, entry);
+                    records++;
+                }
+            }
+
+            cuts++;
+        }
+    }
+
+    fclose(fp);
+    remove(BENCH_JOURNAL);
+
+    printf("%u takes logged, %u passes too short, %u power cuts, %u torn\n\n",
+           count, dropped, cuts, torn);
+
+    /* Time the lookups on the full ring */
+    ops = 1000000;
+
+    t = Now();
+    for (i=0; i < ops; i++)
+        sink += (uintptr_t)TakeLog_get(&s_takeLog, s_takeLog.next - 1 - (i % TAKE_LOG_MAX));
+    Report("get", Now() - t, ops);
+
+    t = Now();
+    for (i=0; i < ops; i++)
+        sink += (uintptr_t)TakeLog_at(&s_takeLog, i % TAKE_LOG_MAX);
+    Report("at", Now() - t, ops);
+
+    ops = 100000;
+
+    t = Now();
+    for (i=0; i < ops; i++)
+        sink += (uintptr_t)TakeLog_find(&s_takeLog, (int32_t)(Random(&seed) % BENCH_REEL_COUNTS));
+    Report("find", Now() - t, ops);
+
+    printf("\n%u check errors\n", errors);
+
+    free(ref);
+
+    return errors ? 1 : 0;
+}
+
+/* Check the take log holds the newest takes logged and no others. Takes
+ * older than the oldest in the journal were lost at the last power cut.
+ */
+static uint32_t Check(TAKE_LOG* log, const TAKE_ENTRY* ref, uint32_t count, uint32_t oldest,
+                      uint32_t* seed)
+{
+    uint32_t errors = 0;
+    uint32_t low = (count >= TAKE_LOG_MAX) ? (count - TAKE_LOG_MAX + 1) : 1;
+    uint32_t held;
+    uint32_t take, n;
+    int32_t ipos;
+    const TAKE_ENTRY* entry;
+    const TAKE_ENTRY* want;
+
+    if (oldest > low)
+        low = oldest;
+
+    held = (count >= low) ? (count - low + 1) : 0;
+
+    if (TakeLog_count(log) != held)
+        errors++;
+
+    /* Spot check a few takes each time, by number and back from the newest */
+    for (n=0; n < 8; n++)
+    {
+        if (!count)
+            break;
+
+        take = 1 + (Random(seed) % count);
+
+        entry = TakeLog_get(log, take);
+
+        if ((take + held) > count)
+        {
+            if (!entry || !Same(entry, &ref[take - 1]))
+                errors++;
+
+            entry = TakeLog_at(log, count - take);
+
+            if (!entry || !Same(entry, &ref[take - 1]))
+                errors++;
+        }
+        else if (entry)
+        {
+            errors++;
+        }
+    }
+
+    if (TakeLog_get(log, count + 1) || TakeLog_get(log, 0) || TakeLog_at(log, held))
+        errors++;
+
+    /* The newest take over a tape position */
+    ipos = (held && (Random(seed) & 1)) ? ref[count - 1 - (Random(seed) % held)].start :
+                                           (int32_t)(Random(seed) % BENCH_REEL_COUNTS);
+
+    want = NULL;
+
+    for (take=count; take > (count - held); take--)
+    {
+        if ((ipos >= ref[take - 1].start) && (ipos <= ref[take - 1].end))
+        {
+            want = &ref[take - 1];
+            break;
+        }
+    }
+
+    entry = TakeLog_find(log, ipos);
+
+    if ((entry == NULL) != (want == NULL))
+        errors++;
+    else if (entry && !Same(entry, want))
+        errors++;
+
+    return errors;
+}
+
+static bool Same(const TAKE_ENTRY* a, const TAKE_ENTRY* b)
+{
+    return (a->take == b->take) && (a->start == b->start) && (a->end == b->end) &&
+           (a->tracks == b->tracks) && (a->length == b->length) && (a->flags == b->flags) &&
+           (memcmp(&a->time, &b->time, sizeof(DATETIME)) == 0);
+}
+
+/* Start the journal with just the file header */
+static FILE* JournalCreate(void)
+{
+    FILE* fp;
+    TAKE_FILE_HDR hdr;
+
+    if ((fp = fopen(BENCH_JOURNAL, "w+b")) == NULL)
+    {
+        perror(BENCH_JOURNAL);
+        return NULL;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+
+    hdr.magic   = TAKE_FILE_MAGIC;
+    hdr.version = TAKE_FILE_VERSION;
+
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+
+    return fp;
+}
+
+static bool JournalAppend(FILE* fp, const TAKE_ENTRY* entry)
+{
+    TAKE_FILE_REC rec;
+
+    TakeLog_seal(&rec, entry);
+
+    return (fwrite(&rec, sizeof(rec), 1, fp) == 1);
+}
+
+/* Load the journal into a new take log, returning the takes loaded */
+static size_t JournalLoad(TAKE_LOG* log, bool* torn)
+{
+    FILE* fp;
+    TAKE_FILE_HDR hdr;
+    TAKE_FILE_REC rec;
+    size_t loaded = 0;
+    size_t n = 0;
+
+    TakeLog_init(log);
+
+    *torn = false;
+
+    if ((fp = fopen(BENCH_JOURNAL, "rb")) == NULL)
+        return 0;
+
+    if ((fread(&hdr, sizeof(hdr), 1, fp) == 1) &&
+        (hdr.magic == TAKE_FILE_MAGIC) && (hdr.version == TAKE_FILE_VERSION))
+    {
+        while ((n = fread(&rec, 1, sizeof(rec), fp)) == sizeof(rec))
+        {
+            if (!TakeLog_load(log, &rec))
+                break;
+
+            loaded++;
+        }
+
+        *torn = (n != 0);
+    }
+
+    fclose(fp);
+
+    return loaded;
+}
+
+/* Leave the last record whole, cut short or with a bad byte */
+static void JournalCut(FILE* fp, uint32_t* seed)
+{
+    long size;
+    long pos;
+
+    fflush(fp);
+
+    fseek(fp, 0, SEEK_END);
+
+    if ((size = ftell(fp)) <= (long)sizeof(TAKE_FILE_HDR))
+        return;
+
+    switch(Random(seed) % 3)
+    {
+    case 1:
+        /* Cut short part way through the last record */
+        if (ftruncate(fileno(fp), size - 1 - (long)(Random(seed) % (sizeof(TAKE_FILE_REC) - 1))) != 0)
+            perror(BENCH_JOURNAL);
+        break;
+
+    case 2:
+        /* The last record only part written */
+        pos = size - (long)sizeof(TAKE_FILE_REC) + (long)(Random(seed) % sizeof(TAKE_FILE_REC));
+        fseek(fp, pos, SEEK_SET);
+        fputc(~0, fp);
+        break;
+
+    default:
+        break;
+    }
+
+    fflush(fp);
+}
+
+static void Report(const char* name, double seconds, uint32_t ops)
+{
+    printf("%-14s %8u ops %10.1f ns/op\n", name, ops, ops ? (seconds * 1.0e9 / ops) : 0.0);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (*seed = x);
+}
+
+/* End-Of-File */
@@ -0,0 +1,649 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Tape time conversion test and benchmark. The integer conversions in
+ * TapeTime.c are checked exhaustively over the hours of tape given, at
+ * 15 and 30 IPS and at 24, 25, 30 and 29.97 drop frame:
+ *
+ * - every encoder position either side of zero converts to the time the
+ *   exact 128-bit sum gives, and a drop frame label that counts back to
+ *   the same frame and is never one of the labels skipped
+ * - every tenth of a second and every time code frame converts to a
+ *   position that converts back to it, and the position before it does
+ *   not
+ *
+ * The same positions and tenths are run through the float conversions
+ * PositionTask.c had before, reading the speed switch on every call,
+ * and the times they get wrong are counted. Time codes at the largest
+ * hours a TAPETIME holds are checked against the exact sum for overflow,
+ * at the nominal roller size and at both ends of the calibration range.
+ *
+ * Last, both ways are timed. The exit status is 1 if any integer
+ * conversion is wrong.
+ *
+ * Usage:
+ *   tapebench [-h hours] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "TapeTime.h"
+
+/* Conversions timed */
+#define BENCH_CALLS             2000000
+
+typedef unsigned __int128 u128;
+
+/* A frame rate checked */
+typedef struct _RATE {
+    const char* name;
+    uint32_t    fps;
+    bool        drop;
+} RATE;
+
+static const RATE s_rates[] = {
+    { "24",     24, false },
+    { "25",     25, false },
+    { "30",     30, false },
+    { "29.97",  30, true  },
+};
+
+#define NUM_RATES   (sizeof(s_rates) / sizeof(s_rates[0]))
+
+/* Speed switch the old float conversions read */
+static uint32_t s_speedSelect;
+
+/* Static Function Prototypes */
+static uint32_t CheckPositions(uint32_t ips, const RATE* rate, uint32_t hours,
+                               uint64_t* floatWrong, double* floatMax);
+static uint32_t CheckTenths(uint32_t ips, uint32_t hours, uint64_t* floatWrong);
+static uint32_t CheckFrames(uint32_t ips, const RATE* rate, uint32_t hours);
+static uint32_t CheckLargeHours(uint32_t* seed);
+static void Bench(void);
+static void RefTime(int32_t pos, uint32_t ips, const RATE* rate, uint32_t circ, TAPETIME* t);
+static uint64_t RefPosition(uint64_t num, uint64_t den, uint32_t ips, uint32_t circ);
+static uint64_t RefFrames(const RATE* rate, const TAPETIME* t);
+static bool Dropped(const TAPETIME* t);
+static bool Same(const TAPETIME* a, const TAPETIME* b, bool frame);
+static int Earlier(const TAPETIME* a, const TAPETIME* b, bool frame);
+static void OldPositionToTapeTime(int tapePosition, TAPETIME* tapeTime);
+static void OldTapeTimeToPosition(TAPETIME* tapeTime, int* tapePosition);
+static void OldSecondsToTapeTime(float time, TAPETIME* p);
+static void OldTapeTimeToSeconds(TAPETIME* p, float* time);
+static void Configure(uint32_t ips, const RATE* rate);
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t hours = 1;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t e;
+    uint64_t floatWrong;
+    double floatMax;
+    uint32_t ips;
+    size_t r;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "h:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'h':
+            hours = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-h hours] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((hours < 1) || (hours > 24))
+    {
+        fprintf(stderr, "hours must be 1 to 24\n");
+        return 1;
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    printf("tape time: %u h either side of zero, roller %lu uin, seed %u\n\n", hours,
+           (unsigned long)ROLLER_CIRCUMFERENCE_UIN, seed);
+
+    printf("%-22s %4s %-6s %8s %12s %12s\n", "check", "ips", "fps", "errors", "float wrong",
+           "float max ms");
+
+    for (ips=15; ips <= 30; ips += 15)
+    {
+        for (r=0; r < NUM_RATES; r++)
+        {
+            e = CheckPositions(ips, &s_rates[r], hours, &floatWrong, &floatMax);
+
+            /* The old conversions only had tenths */
+            if (s_rates[r].fps == 30 && !s_rates[r].drop)
+                printf("%-22s %4u %-6s %8u %12llu %12.1f\n", "position to time", ips,
+                       s_rates[r].name, e, (unsigned long long)floatWrong, floatMax * 1000.0);
+            else
+                printf("%-22s %4u %-6s %8u %12s %12s\n", "position to time", ips,
+                       s_rates[r].name, e, "", "");
+
+            errors += e;
+        }
+
+        e = CheckTenths(ips, hours, &floatWrong);
+        printf("%-22s %4u %-6s %8u %12llu %12s\n", "tenths round trip", ips, "", e,
+               (unsigned long long)floatWrong, "");
+        errors += e;
+
+        for (r=0; r < NUM_RATES; r++)
+        {
+            e = CheckFrames(ips, &s_rates[r], hours);
+            printf("%-22s %4u %-6s %8u %12s %12s\n", "frames round trip", ips, s_rates[r].name,
+                   e, "", "");
+            errors += e;
+        }
+    }
+
+    e = CheckLargeHours(&seed);
+    printf("%-22s %4s %-6s %8u\n", "hours 200-255", "", "", e);
+    errors += e;
+
+    printf("\nfloat wrong: times the old float conversions got wrong, float max:\n");
+    printf("their largest error. A round trip is wrong if the time does not come\n");
+    printf("back, or the position before it gives the same time.\n\n");
+
+    Bench();
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Every position either side of zero to the time. Returns the errors. */
+static uint32_t CheckPositions(uint32_t ips, const RATE* rate, uint32_t hours,
+                               uint64_t* floatWrong, double* floatMax)
+{
+    TAPETIME got, want, old;
+    uint32_t errors = 0;
+    int64_t span;
+    int32_t pos;
+    double exact, err;
+
+    Configure(ips, rate);
+
+    *floatWrong = 0;
+    *floatMax   = 0.0;
+
+    span = ((int64_t)hours * 3600 * ips * ROLLER_TICKS_PER_REV * 1000000) /
+           ROLLER_CIRCUMFERENCE_UIN;
+
+    for (pos = (int32_t)-span; pos <= (int32_t)span; pos++)
+    {
+        PositionToTapeTime(pos, &got);
+        RefTime(pos, ips, rate, ROLLER_CIRCUMFERENCE_UIN, &want);
+
+        if (!Same(&got, &want, true) || !Same(&got, &want, false) || (got.flags != want.flags))
+            errors++;
+
+        if (rate->drop && (Dropped(&got) || (RefFrames(rate, &got) != RefFrames(rate, &want))))
+            errors++;
+
+        if ((rate->fps != 30) || rate->drop)
+            continue;
+
+        OldPositionToTapeTime(pos, &old);
+
+        if (!Same(&old, &want, false) || (old.flags != want.flags))
+        {
+            (*floatWrong)++;
+
+            /* Distance from the exact time to the tenth it showed */
+            exact = fabs((double)pos) * ROLLER_CIRCUMFERENCE_UIN /
+                    ((double)ROLLER_TICKS_PER_REV * ips * 1e6);
+            err = exact - ((old.hour * 3600.0) + (old.mins * 60.0) + old.secs +
+                           (old.tens / 10.0));
+
+            if (fabs(err) > *floatMax)
+                *floatMax = fabs(err);
+        }
+    }
+
+    return errors;
+}
+
+/* Every tenth of a second to a position and back. Returns the errors. */
+static uint32_t CheckTenths(uint32_t ips, uint32_t hours, uint64_t* floatWrong)
+{
+    TAPETIME t, back;
+    uint32_t errors = 0;
+    uint32_t tenths, secs;
+    int pos;
+
+    Configure(ips, &s_rates[2]);
+
+    *floatWrong = 0;
+
+    for (tenths=0; tenths < hours * 36000; tenths++)
+    {
+        secs = tenths / 10;
+
+        memset(&t, 0, sizeof(TAPETIME));
+
+        t.hour  = (uint8_t)(secs / 3600);
+        t.mins  = (uint8_t)((secs / 60) % 60);
+        t.secs  = (uint8_t)(secs % 60);
+        t.tens  = (uint8_t)(tenths % 10);
+        t.flags = F_PLUS;
+
+        TapeTimeToPosition(&t, &pos);
+
+        if (pos != (int)RefPosition(tenths, 10, ips, ROLLER_CIRCUMFERENCE_UIN))
+            errors++;
+
+        PositionToTapeTime(pos, &back);
+
+        if (!Same(&t, &back, false))
+            errors++;
+
+        if (pos > 0)
+        {
+            PositionToTapeTime(pos - 1, &back);
+
+            if (Earlier(&back, &t, false) >= 0)
+                errors++;
+        }
+
+        OldTapeTimeToPosition(&t, &pos);
+        OldPositionToTapeTime(pos, &back);
+
+        if (!Same(&t, &back, false))
+            (*floatWrong)++;
+    }
+
+    return errors;
+}
+
+/* Every time code frame to a position and back. Returns the errors. */
+static uint32_t CheckFrames(uint32_t ips, const RATE* rate, uint32_t hours)
+{
+    TAPETIME t, back;
+    uint32_t errors = 0;
+    uint32_t secs, frame;
+    uint64_t num, den;
+    int pos;
+
+    Configure(ips, rate);
+
+    for (secs=0; secs < hours * 3600; secs++)
+    {
+        for (frame=0; frame < rate->fps; frame++)
+        {
+            memset(&t, 0, sizeof(TAPETIME));
+
+            t.hour  = (uint8_t)(secs / 3600);
+            t.mins  = (uint8_t)((secs / 60) % 60);
+            t.secs  = (uint8_t)(secs % 60);
+            t.frame = (uint8_t)frame;
+            t.flags = F_PLUS;
+
+            if (rate->drop && Dropped(&t))
+                continue;
+
+            num = RefFrames(rate, &t) * (rate->drop ? 1001 : 1);
+            den = rate->drop ? 30000 : rate->fps;
+
+            TapeFramesToPosition(&t, &pos);
+
+            if (pos != (int)RefPosition(num, den, ips, ROLLER_CIRCUMFERENCE_UIN))
+                errors++;
+
+            PositionToTapeTime(pos, &back);
+
+            if (!Same(&t, &back, true))
+                errors++;
+
+            if (pos > 0)
+            {
+                PositionToTapeTime(pos - 1, &back);
+
+                if (Earlier(&back, &t, true) >= 0)
+                    errors++;
+            }
+        }
+    }
+
+    return errors;
+}
+
+/* Random time codes and times at the largest hours against the exact sum,
+ * where a 64-bit intermediate product could overflow. Returns the errors.
+ */
+static uint32_t CheckLargeHours(uint32_t* seed)
+{
+    static const uint32_t circs[] = { ROLLER_CIRCUMFERENCE_MIN, ROLLER_CIRCUMFERENCE_UIN,
+                                      ROLLER_CIRCUMFERENCE_MAX };
+    TAPETIME t;
+    uint32_t errors = 0;
+    uint32_t ips, c, i;
+    uint64_t tenths;
+    size_t r;
+    int pos;
+
+    for (c=0; c < 3; c++)
+    {
+        TapeTime_setCircumference(circs[c]);
+
+        for (ips=15; ips <= 30; ips += 15)
+        {
+            for (r=0; r < NUM_RATES; r++)
+            {
+                Configure(ips, &s_rates[r]);
+
+                for (i=0; i < 100000; i++)
+                {
+                    memset(&t, 0, sizeof(TAPETIME));
+
+                    t.hour  = (uint8_t)(200 + (Random(seed) % 56));
+                    t.mins  = (uint8_t)(Random(seed) % 60);
+                    t.secs  = (uint8_t)(Random(seed) % 60);
+                    t.tens  = (uint8_t)(Random(seed) % 10);
+                    t.frame = (uint8_t)(Random(seed) % s_rates[r].fps);
+
+                    if (s_rates[r].drop && Dropped(&t))
+                        t.frame = 2;
+
+                    TapeFramesToPosition(&t, &pos);
+
+                    if (pos != (int)RefPosition(RefFrames(&s_rates[r], &t) *
+                                                (s_rates[r].drop ? 1001 : 1),
+                                                s_rates[r].drop ? 30000 : s_rates[r].fps,
+                                                ips, circs[c]))
+                        errors++;
+
+                    tenths = ((((uint64_t)t.hour * 60) + t.mins) * 60 + t.secs) * 10 + t.tens;
+
+                    TapeTimeToPosition(&t, &pos);
+
+                    if (pos != (int)RefPosition(tenths, 10, ips, circs[c]))
+                        errors++;
+                }
+            }
+        }
+    }
+
+    TapeTime_setCircumference(ROLLER_CIRCUMFERENCE_UIN);
+
+    return errors;
+}
+
+/* Time both ways of converting */
+static void Bench(void)
+{
+    static volatile int sink;
+    TAPETIME t;
+    double t0, tInt, tOld, tIntBack, tOldBack;
+    int pos;
+    int i;
+
+    Configure(30, &s_rates[2]);
+
+    t0 = Now();
+
+    for (i=0; i < BENCH_CALLS; i++)
+    {
+        PositionToTapeTime(i * 7 - 1000000, &t);
+        sink += t.tens;
+    }
+
+    tInt = (Now() - t0) / BENCH_CALLS;
+
+    t0 = Now();
+
+    for (i=0; i < BENCH_CALLS; i++)
+    {
+        OldPositionToTapeTime(i * 7 - 1000000, &t);
+        sink += t.tens;
+    }
+
+    tOld = (Now() - t0) / BENCH_CALLS;
+
+    memset(&t, 0, sizeof(TAPETIME));
+
+    t0 = Now();
+
+    for (i=0; i < BENCH_CALLS; i++)
+    {
+        t.secs = (uint8_t)(i % 60);
+        t.tens = (uint8_t)(i % 10);
+        TapeTimeToPosition(&t, &pos);
+        sink += pos;
+    }
+
+    tIntBack = (Now() - t0) / BENCH_CALLS;
+
+    t0 = Now();
+
+    for (i=0; i < BENCH_CALLS; i++)
+    {
+        t.secs = (uint8_t)(i % 60);
+        t.tens = (uint8_t)(i % 10);
+        OldTapeTimeToPosition(&t, &pos);
+        sink += pos;
+    }
+
+    tOldBack = (Now() - t0) / BENCH_CALLS;
+
+    printf("%-22s %10s %10s\n", "ns a call", "integer", "float");
+    printf("%-22s %10.1f %10.1f\n", "position to time", tInt * 1e9, tOld * 1e9);
+    printf("%-22s %10.1f %10.1f\n", "time to position", tIntBack * 1e9, tOldBack * 1e9);
+    printf("The float path also read the speed switch GPIO on each call, which\n");
+    printf("is not timed here. The TM4C divides 64-bit integers in software\n");
+}
+
+/* Exact time for a position, worked out in 128 bits */
+static void RefTime(int32_t pos, uint32_t ips, const RATE* rate, uint32_t circ, TAPETIME* t)
+{
+    u128 dist = (u128)(pos < 0 ? -(int64_t)pos : pos) * circ;
+    u128 scale = (u128)ROLLER_TICKS_PER_REV * ips * 1000000;
+    uint64_t secs, frames, tenMins, rem;
+    uint32_t frame, tens;
+
+    if (rate->drop)
+    {
+        /* Frames elapsed, then the label counting 2 frame numbers skipped
+         * each minute but every tenth
+         */
+        frames  = (uint64_t)((dist * 30000) / (scale * 1001));
+        tenMins = frames / 17982;
+        rem     = frames % 17982;
+
+        frames += 18 * tenMins;
+
+        if (rem >= 2)
+            frames += 2 * ((rem - 2) / 1798);
+
+        secs  = frames / 30;
+        frame = (uint32_t)(frames % 30);
+        tens  = frame / 3;
+    }
+    else
+    {
+        secs  = (uint64_t)(dist / scale);
+        tens  = (uint32_t)(((dist % scale) * 10) / scale);
+        frame = (uint32_t)(((dist % scale) * rate->fps) / scale);
+    }
+
+    secs %= 86400;
+
+    memset(t, 0, sizeof(TAPETIME));
+
+    t->hour  = (uint8_t)(secs / 3600);
+    t->mins  = (uint8_t)((secs / 60) % 60);
+    t->secs  = (uint8_t)(secs % 60);
+    t->tens  = (uint8_t)tens;
+    t->frame = (uint8_t)frame;
+    t->flags = (pos < 0) ? 0 : F_PLUS;
+}
+
+/* Smallest position at or past num/den seconds, worked out in 128 bits */
+static uint64_t RefPosition(uint64_t num, uint64_t den, uint32_t ips, uint32_t circ)
+{
+    u128 n = (u128)num * ROLLER_TICKS_PER_REV * ips * 1000000;
+    u128 d = (u128)den * circ;
+
+    return (uint64_t)((n + d - 1) / d);
+}
+
+/* Frames counted up to a time code, skipping the dropped labels */
+static uint64_t RefFrames(const RATE* rate, const TAPETIME* t)
+{
+    uint64_t mins = ((uint64_t)t->hour * 60) + t->mins;
+    uint64_t frames = (((mins * 60) + t->secs) * rate->fps) + t->frame;
+
+    /* Two labels go at the start of each minute but every tenth */
+    if (rate->drop)
+        frames -= 2 * (mins - (mins / 10));
+
+    return frames;
+}
+
+/* Returns true for a drop frame label that is never used */
+static bool Dropped(const TAPETIME* t)
+{
+    return (t->secs == 0) && (t->frame < 2) && (t->mins % 10);
+}
+
+/* Compare the time shown, and the frame if asked */
+static bool Same(const TAPETIME* a, const TAPETIME* b, bool frame)
+{
+    if ((a->hour != b->hour) || (a->mins != b->mins) || (a->secs != b->secs))
+        return false;
+
+    return frame ? (a->frame == b->frame) : (a->tens == b->tens);
+}
+
+/* Compare two times to the frame, or to the tenth */
+static int Earlier(const TAPETIME* a, const TAPETIME* b, bool frame)
+{
+    int32_t x = ((((a->hour * 60) + a->mins) * 60) + a->secs) * 32;
+    int32_t y = ((((b->hour * 60) + b->mins) * 60) + b->secs) * 32;
+
+    x += frame ? a->frame : a->tens;
+    y += frame ? b->frame : b->tens;
+
+    return (x < y) ? -1 : (x > y);
+}
+
+/* The conversions PositionTask.c had before TapeTime.c, the speed switch
+ * read on each call
+ */
+#define INV_ROLLER_TICKS_PER_REV    (1.0f / ROLLER_TICKS_PER_REV_F)
+
+static void OldPositionToTapeTime(int tapePosition, TAPETIME* tapeTime)
+{
+    float position = (float)tapePosition;
+    float revolutions = position * INV_ROLLER_TICKS_PER_REV;
+    float distance = revolutions * ROLLER_CIRCUMFERENCE_F;
+    float invspeed = s_speedSelect ? (1.0f/30.0f) : (1.0f/15.0f);
+    float seconds = distance * invspeed;
+
+    OldSecondsToTapeTime(seconds, tapeTime);
+}
+
+static void OldTapeTimeToPosition(TAPETIME* tapeTime, int* tapePosition)
+{
+    float time;
+
+    OldTapeTimeToSeconds(tapeTime, &time);
+
+    float speed = s_speedSelect ? 30.0f : 15.0f;
+    float distance = speed * time;
+    float position = (distance / ROLLER_CIRCUMFERENCE_F) * ROLLER_TICKS_PER_REV_F;
+
+    *tapePosition = (int)position;
+}
+
+#define SECS_DAY    (24L * 60L * 60L)
+
+static void OldSecondsToTapeTime(float time, TAPETIME* p)
+{
+    float ftime = fabsf(time);
+    uint32_t dayclock = (uint32_t)ftime % SECS_DAY;
+    float intpart;
+    float fractpart = modff(ftime, &intpart);
+
+    p->hour  = (uint8_t)(dayclock / 3600);
+    p->mins  = (uint8_t)((dayclock % 3600) / 60);
+    p->secs  = (uint8_t)(dayclock % 60);
+    p->tens  = (uint8_t)(fractpart * 10.0f);
+    p->frame = (uint8_t)(fractpart * 30.0f);
+    p->flags = (time < 0.0f) ? 0 : F_PLUS;
+}
+
+static void OldTapeTimeToSeconds(TAPETIME* p, float* time)
+{
+    float secs;
+
+    secs  = (float)(p->hour * 3600);
+    secs += (float)(p->mins % 3600) * 60.0f;
+    secs += (float)(p->secs % 60);
+    secs += (float)(p->tens % 10) * 0.10f;
+
+    *time = secs + 0.1f;
+}
+
+/* Set the speed and frame rate for both ways of converting */
+static void Configure(uint32_t ips, const RATE* rate)
+{
+    TapeTime_configure(ips, rate->fps, rate->drop);
+
+    s_speedSelect = (ips >= 30);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+/* End-Of-File */
@@ -0,0 +1,513 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* Position timeline test and benchmark. Runs a synthetic encoder position
+ * feed through the timeline built for the host, the way the position task
+ * runs each encoder sample through it. The feed mixes play, fast winds in
+ * both directions, the count dithering back and forth about one spot when
+ * the tape is stopped, and the counter being zeroed. Events are added and
+ * deleted as the feed runs.
+ *
+ * The events fired for each sample are checked against a scan of all the
+ * events for those crossed between the last and new position, in the order
+ * the tape crossed them. The feed is then timed through timelines of more
+ * and more events, and the same feed timed as a scan of every event on
+ * each sample for comparison. The exit status is 1 if any check fails.
+ *
+ * Usage:
+ *   tlbench [-n events] [-f samples] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "TapeTime.h"
+#include "STC1200TCP.h"
+#include "Timeline.h"
+
+/* Event positions are spread over a reel of this many encoder counts */
+#define BENCH_REEL_COUNTS       (2400L * 80L)
+
+/* An event is added or deleted once every this many samples */
+#define BENCH_EDIT_SAMPLES      500
+
+/* Feed segment types */
+typedef enum {
+    FEED_PLAY=0,
+    FEED_WIND,
+    FEED_DITHER,
+    FEED_ZERO,
+    FEED_TYPES
+} FEED_TYPE;
+
+/* Events as kept for the check scan, in the order added */
+typedef struct _REF_EVENT {
+    int32_t     ipos;
+    uint8_t     flags;
+    bool        alive;
+} REF_EVENT;
+
+/* Events fired for one sample */
+typedef struct _FIRED {
+    uint32_t*   id;
+    size_t      count;
+    size_t      max;
+} FIRED;
+
+static TIMELINE s_timeline;
+
+/* Static Function Prototypes */
+static double Now(void);
+static uint32_t Random(uint32_t* seed);
+static int32_t RandomPos(uint32_t* seed);
+static uint8_t RandomFlags(uint32_t* seed);
+static int32_t* MakeFeed(uint32_t samples, uint32_t* seed, bool* zero);
+static void Fire(const TL_ENTRY* entry, int dir, void* arg);
+static void Count(const TL_ENTRY* entry, int dir, void* arg);
+static size_t Scan(REF_EVENT* ref, size_t count, int32_t last, int32_t ipos, uint32_t* out);
+static int Compare(const void* a, const void* b);
+static bool CheckOrder(TIMELINE* tl);
+static void Report(const char* name, double seconds, uint32_t ops);
+
+/* Position of each event id for sorting the scan results */
+static REF_EVENT* s_sortRef;
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    uint32_t events = 2000;
+    uint32_t samples = 200000;
+    uint32_t seed = 1;
+    uint32_t errors = 0;
+    uint32_t i, k, id, refs, fired;
+    uint32_t* expect;
+    int32_t* feed;
+    bool* zero;
+    REF_EVENT* ref;
+    TL_ENTRY entry;
+    FIRED got;
+    size_t n, max, sizes[4];
+    const TL_ENTRY* e;
+    volatile size_t sink = 0;
+    double t;
+    int opt, index;
+
+    while ((opt = getopt(argc, argv, "n:f:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            samples = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n events] [-f samples] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Zero would repeat forever */
+    if (!seed)
+        seed = 1;
+
+    if (!events || (events > (TIMELINE_MAX / 2)) || !samples)
+    {
+        fprintf(stderr, "events must be 1 to %d\n", TIMELINE_MAX / 2);
+        return 1;
+    }
+
+    max      = events + (samples / BENCH_EDIT_SAMPLES) + 1;
+    ref      = calloc(max, sizeof(REF_EVENT));
+    expect   = calloc(max, sizeof(uint32_t));
+    got.id   = calloc(max, sizeof(uint32_t));
+    got.max  = max;
+    zero     = calloc(samples, sizeof(bool));
+    feed     = MakeFeed(samples, &seed, zero);
+    s_sortRef = ref;
+
+    printf("timeline: %u events, %u samples, %zu bytes\n\n",
+           events, samples, sizeof(TIMELINE));
+
+    /* Random events added in no particular order. Some share the
+     * position of an event already added.
+     */
+    Timeline_init(&s_timeline);
+
+    for (refs=0; refs < events; refs++)
+    {
+        entry.ipos   = ((refs > 0) && !(Random(&seed) % 8)) ? ref[Random(&seed) % refs].ipos : RandomPos(&seed);
+        entry.action = STC_TL_EVENT;
+        entry.flags  = RandomFlags(&seed);
+        entry.arg    = 0;
+        entry.param  = refs;
+
+        ref[refs].ipos  = entry.ipos;
+        ref[refs].flags = entry.flags;
+        ref[refs].alive = true;
+
+        if (Timeline_add(&s_timeline, &entry) == TL_NONE)
+            errors++;
+    }
+
+    if (!CheckOrder(&s_timeline))
+        errors++;
+
+    /* Run the feed, checking the events fired on each sample against a
+     * scan of all the events.
+     */
+    Timeline_seek(&s_timeline, feed[0]);
+
+    for (i=1, fired=0; i < samples; i++)
+    {
+        got.count = 0;
+
+        if (zero[i])
+        {
+            Timeline_seek(&s_timeline, feed[i]);
+        }
+        else
+        {
+            n = Timeline_advance(&s_timeline, feed[i], Fire, &got);
+
+            k = (uint32_t)Scan(ref, refs, feed[i - 1], feed[i], expect);
+
+            if ((n != got.count) || (n != k) || memcmp(got.id, expect, k * sizeof(uint32_t)))
+                errors++;
+
+            fired += (uint32_t)n;
+        }
+
+        /* Edits must not fire anything */
+        if (!(i % BENCH_EDIT_SAMPLES))
+        {
+            if ((Random(&seed) & 1) && Timeline_count(&s_timeline))
+            {
+                index = (int)(Random(&seed) % Timeline_count(&s_timeline));
+
+                id = Timeline_get(&s_timeline, index)->param;
+
+                ref[id].alive = false;
+
+                if (!Timeline_remove(&s_timeline, index))
+                    errors++;
+            }
+            else
+            {
+                /* Often right at or next to the tape position */
+                entry.ipos   = (Random(&seed) & 1) ? feed[i] + (int32_t)(Random(&seed) % 3) - 1 : RandomPos(&seed);
+                entry.action = STC_TL_EVENT;
+                entry.flags  = RandomFlags(&seed);
+                entry.arg    = 0;
+                entry.param  = refs;
+
+                ref[refs].ipos  = entry.ipos;
+                ref[refs].flags = entry.flags;
+                ref[refs].alive = true;
+                refs++;
+
+                if (Timeline_add(&s_timeline, &entry) == TL_NONE)
+                    errors++;
+            }
+        }
+    }
+
+    if (!CheckOrder(&s_timeline))
+        errors++;
+
+    printf("%u events fired, %u checked against a scan\n\n", fired, samples - 1);
+
+    /* Time the feed through more and more events */
+    sizes[0] = 256;
+    sizes[1] = 2048;
+    sizes[2] = 8192;
+    sizes[3] = TIMELINE_MAX;
+
+    for (k=0; k < 4; k++)
+    {
+        char name[32];
+
+        Timeline_init(&s_timeline);
+
+        for (n=0; n < sizes[k]; n++)
+        {
+            entry.ipos   = RandomPos(&seed);
+            entry.action = STC_TL_EVENT;
+            entry.flags  = TL_F_FWD | TL_F_REW;
+            entry.arg    = 0;
+            entry.param  = (uint32_t)n;
+
+            Timeline_add(&s_timeline, &entry);
+        }
+
+        Timeline_seek(&s_timeline, feed[0]);
+
+        t = Now();
+
+        for (i=1; i < samples; i++)
+        {
+            if (zero[i])
+                Timeline_seek(&s_timeline, feed[i]);
+            else
+                sink += Timeline_advance(&s_timeline, feed[i], Count, NULL);
+        }
+
+        snprintf(name, sizeof(name), "advance %zu", sizes[k]);
+        Report(name, Now() - t, samples - 1);
+
+        /* The same feed as a scan of every event on each sample. Only
+         * a slice of the feed is scanned as it takes so long.
+         */
+        t = Now();
+
+        for (i=1; i < (samples / 10); i++)
+        {
+            int32_t lo = (feed[i - 1] < feed[i]) ? feed[i - 1] : feed[i];
+            int32_t hi = (feed[i - 1] < feed[i]) ? feed[i] : feed[i - 1];
+
+            for (n=0; n < s_timeline.count; n++)
+            {
+                e = &s_timeline.entry[n];
+
+                if ((e->ipos > lo) && (e->ipos <= hi))
+                    sink++;
+            }
+        }
+
+        snprintf(name, sizeof(name), "scan %zu", sizes[k]);
+        Report(name, Now() - t, (samples / 10) - 1);
+    }
+
+    printf("\n%u check errors\n", errors);
+
+    (void)sink;
+
+    free(ref);
+    free(expect);
+    free(got.id);
+    free(zero);
+    free(feed);
+
+    return errors ? 1 : 0;
+}
+
+/* Make the synthetic encoder position feed, one count per 1 ms sample */
+static int32_t* MakeFeed(uint32_t samples, uint32_t* seed, bool* zero)
+{
+    int32_t* feed = calloc(samples, sizeof(int32_t));
+    uint32_t i = 0, len, j;
+    double pos = (double)RandomPos(seed);
+    double step;
+    int32_t base;
+
+    while (i < samples)
+    {
+        len = 50 + (Random(seed) % 2000);
+
+        switch(Random(seed) % FEED_TYPES)
+        {
+        case FEED_PLAY:
+            /* 15 or 30 IPS is 0.24 or 0.48 counts per ms */
+            step = (Random(seed) & 1) ? 0.48 : 0.24;
+
+            for (j=0; (j < len) && (i < samples); j++, i++)
+                feed[i] = (int32_t)(pos += step);
+            break;
+
+        case FEED_WIND:
+            /* Up to 400 IPS either way, about 6 counts per ms */
+            step = (double)(Random(seed) % 1300) / 200.0;
+
+            if (Random(seed) & 1)
+                step = -step;
+
+            for (j=0; (j < len) && (i < samples); j++, i++)
+            {
+                pos += step;
+
+                /* Turn back at either end of the reel */
+                if ((pos < -1000.0) || (pos > (double)(BENCH_REEL_COUNTS + 1000)))
+                {
+                    step = -step;
+                    pos += 2.0 * step;
+                }
+
+                feed[i] = (int32_t)pos;
+            }
+            break;
+
+        case FEED_DITHER:
+            base = (int32_t)pos;
+
+            for (j=0; (j < len) && (i < samples); j++, i++)
+                feed[i] = base + (int32_t)(Random(seed) % 3) - 1;
+            break;
+
+        case FEED_ZERO:
+        default:
+            /* Only now and then, or the tape never gets anywhere */
+            if (Random(seed) % 8)
+                break;
+
+            pos = 0.0;
+            feed[i] = 0;
+            zero[i++] = true;
+            break;
+        }
+    }
+
+    return feed;
+}
+
+/* Keep the id of each event fired */
+static void Fire(const TL_ENTRY* entry, int dir, void* arg)
+{
+    FIRED* got = (FIRED*)arg;
+
+    (void)dir;
+
+    if (got->count < got->max)
+        got->id[got->count++] = entry->param;
+}
+
+/* Fire nothing, for timing the advance alone */
+static void Count(const TL_ENTRY* entry, int dir, void* arg)
+{
+    (void)entry;
+    (void)dir;
+    (void)arg;
+}
+
+/* Ids of the events crossed going from last to ipos, in crossing order */
+static size_t Scan(REF_EVENT* ref, size_t count, int32_t last, int32_t ipos, uint32_t* out)
+{
+    size_t i, n = 0;
+    uint32_t t;
+
+    for (i=0; i < count; i++)
+    {
+        if (!ref[i].alive)
+            continue;
+
+        if ((last < ipos) && (ref[i].ipos > last) && (ref[i].ipos <= ipos) && (ref[i].flags & TL_F_FWD))
+            out[n++] = (uint32_t)i;
+        else if ((last > ipos) && (ref[i].ipos > ipos) && (ref[i].ipos <= last) && (ref[i].flags & TL_F_REW))
+            out[n++] = (uint32_t)i;
+    }
+
+    qsort(out, n, sizeof(uint32_t), Compare);
+
+    /* Going backward the last event added at a position is crossed first */
+    if (last > ipos)
+    {
+        for (i=0; i < (n / 2); i++)
+        {
+            t = out[i];
+            out[i] = out[n - 1 - i];
+            out[n - 1 - i] = t;
+        }
+    }
+
+    return n;
+}
+
+/* Order event ids by position, then by the order added */
+static int Compare(const void* a, const void* b)
+{
+    uint32_t ia = *(const uint32_t*)a;
+    uint32_t ib = *(const uint32_t*)b;
+
+    if (s_sortRef[ia].ipos != s_sortRef[ib].ipos)
+        return (s_sortRef[ia].ipos < s_sortRef[ib].ipos) ? -1 : 1;
+
+    return (ia < ib) ? -1 : ((ia > ib) ? 1 : 0);
+}
+
+/* The events must be in position order with the cursor after the last */
+static bool CheckOrder(TIMELINE* tl)
+{
+    size_t i;
+
+    for (i=1; i < tl->count; i++)
+    {
+        if (tl->entry[i - 1].ipos > tl->entry[i].ipos)
+            return false;
+    }
+
+    if (tl->cursor > tl->count)
+        return false;
+
+    if ((tl->cursor > 0) && (tl->entry[tl->cursor - 1].ipos > tl->last))
+        return false;
+
+    if ((tl->cursor < tl->count) && (tl->entry[tl->cursor].ipos <= tl->last))
+        return false;
+
+    return true;
+}
+
+static void Report(const char* name, double seconds, uint32_t ops)
+{
+    printf("%-14s %8u ops %10.1f ns/op\n", name, ops, ops ? (seconds * 1.0e9 / ops) : 0.0);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1.0e-9);
+}
+
+/* Park-Miller minimal standard generator */
+static uint32_t Random(uint32_t* seed)
+{
+    *seed = (uint32_t)(((uint64_t)*seed * 48271U) % 2147483647U);
+
+    return *seed;
+}
+
+static int32_t RandomPos(uint32_t* seed)
+{
+    return (int32_t)(Random(seed) % BENCH_REEL_COUNTS);
+}
+
+/* Mostly both directions, some one way and a few that never fire */
+static uint8_t RandomFlags(uint32_t* seed)
+{
+    switch(Random(seed) % 8)
+    {
+    case 0:
+        return TL_F_FWD;
+    case 1:
+        return TL_F_REW;
+    case 2:
+        return 0;
+    default:
+        return TL_F_FWD | TL_F_REW;
+    }
+}
+
+/* End-Of-File */
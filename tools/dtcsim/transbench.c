@@ -0,0 +1,1065 @@
+/***************************************************************************
+ *
+ * DTC-1200 & STC-1200 Digital Transport Controllers for
+ * Ampex MM-1200 Tape Machines
+ *
+ * Copyright (C) 2016-2020, RTZ Professional Audio, LLC
+ * All Rights Reserved
+ *
+ * RTZ is registered trademark of RTZ Professional Audio, LLC
+ *
+ ***************************************************************************/
+
+/* IPC transaction stress test. Requester threads make transactions as the
+ * STC tasks do, through a host copy of the IPC server transaction paths,
+ * with a simulated DTC thread answering each after a random delay, so
+ * replies come back in a different order to the requests. A few requests
+ * are never answered and a few are answered after their timeout. A worker
+ * thread takes the replies as the IPC worker task does.
+ *
+ * Requests are numbered in a send window as the ARQ numbers them, holding
+ * a sequence number until its reply ACKs the request, or until a request
+ * never answered is given up on.
+ *
+ * Each request carries a token the reply must return. The test is run
+ * first as the server was, each reply posting one event that any waiting
+ * task takes and the task reading the reply buffer for its own sequence
+ * number, then with the transaction table in IPCTrans.c and a completion
+ * semaphore for each slot. In the second run half the requesters use the
+ * async callback API, keeping several requests each in flight.
+ *
+ * The exit status is 1 if the table gives a requester a reply to another
+ * request, or calls a callback other than once.
+ *
+ * Usage:
+ *   transbench [-t seconds] [-n requesters] [-s seed] [-d drop rate]
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#include "IPCSimFrame.h"
+#include "IPCTrans.h"
+#include "IPCMessage.h"
+
+/* Transaction timeout, scaled down from the firmware's 2000 ms */
+#define TRANS_TIMEOUT_MS        50
+
+/* A late reply comes this long after its request */
+#define LATE_MS                 75
+
+/* A request never answered is given up on and its sequence number freed
+ * after this long, as the ARQ does once it has resent it.
+ */
+#define GIVEUP_MS               100
+
+/* DTC time to answer a transaction */
+#define REPLY_MIN_US            200
+#define REPLY_MAX_US            2000
+
+/* Worker wait with nothing to time out, as IPC_TRANS_POLL */
+#define POLL_MS                 50
+
+/* Async requests a requester keeps in flight */
+#define ASYNC_DEPTH             4
+
+#define MAX_REQUESTERS          64
+#define LINK_MAX                64
+#define LAT_MAX                 (1 << 16)
+
+/* The reply token is the request token with these bits flipped */
+#define TOKEN_REPLY             0x5A5A5A5Au
+
+#define MODE_LEGACY             0
+#define MODE_TABLE              1
+
+/* A request or reply on the link */
+typedef struct _LINK_FRAME {
+    bool            used;
+    uint8_t         seqnum;             /* request number, reply ACK    */
+    uint64_t        due;                /* us the reply goes out        */
+    SIM_MSG         msg;
+} LINK_FRAME;
+
+typedef struct _BENCH BENCH;
+typedef struct _REQUESTER REQUESTER;
+
+/* An async request waiting on its callback */
+typedef struct _ASYNC_REQ {
+    REQUESTER*      r;
+    atomic_bool     busy;
+    uint32_t        calls;              /* callbacks for this request   */
+    uint32_t        token;
+    uint64_t        start;
+} ASYNC_REQ;
+
+struct _REQUESTER {
+    BENCH*          b;
+    pthread_t       thread;
+    uint32_t        id;
+    bool            async;
+    uint32_t        seed;
+    uint32_t        posted;
+    uint32_t        ok;                 /* right reply                  */
+    uint32_t        wrong;              /* reply to another request     */
+    uint32_t        timeouts;           /* no reply in the timeout      */
+    uint32_t        failed;             /* could not be posted          */
+    uint32_t        twice;              /* callback called again        */
+    uint32_t        missing;            /* callback never called        */
+    uint32_t        nlat;
+    float*          lat;                /* us post to reply             */
+    sem_t           credit;             /* async requests free          */
+    ASYNC_REQ       req[ASYNC_DEPTH];
+};
+
+struct _BENCH {
+    int             mode;
+    atomic_bool     stop;               /* requesters stop posting      */
+    atomic_bool     quit;               /* worker and DTC stop          */
+    uint64_t        epoch;
+
+    /* IPC server transaction table, the transGate and semaphores */
+    pthread_mutex_t gate;
+    IPC_TRANS_TABLE trans;
+    sem_t           transFree;
+    sem_t           transSem[IPC_TRANS_MAX];
+
+    /* The event and reply buffers the server had before the table */
+    pthread_mutex_t evLock;
+    pthread_cond_t  evCond;
+    uint32_t        events;
+    SIM_MSG         ackBuf[IPC_MAX_WINDOW];
+
+    /* Send window, numbering requests as the ARQ does */
+    pthread_mutex_t winLock;
+    pthread_cond_t  winCond;
+    uint8_t         txBase;
+    uint8_t         txNext;
+    uint8_t         txCount;
+    bool            acked[IPC_MAX_SEQ + 1];
+    uint64_t        sentAt[IPC_MAX_SEQ + 1];
+    uint32_t        givenUp;
+
+    /* Simulated DTC */
+    pthread_mutex_t dtcLock;
+    pthread_cond_t  dtcCond;
+    LINK_FRAME      dtc[LINK_MAX];
+    double          drop;
+    uint32_t        seed;
+    uint32_t        dtcSeed;
+    uint32_t        dropped;            /* requests never answered      */
+    uint32_t        late;               /* answered after the timeout   */
+
+    /* Replies to the worker */
+    pthread_mutex_t rxLock;
+    pthread_cond_t  rxCond;
+    LINK_FRAME      rx[LINK_MAX];
+    uint32_t        rxHead;
+    uint32_t        rxCount;
+
+    uint32_t        nreq;
+    REQUESTER       req[MAX_REQUESTERS];
+};
+
+/* Static Function Prototypes */
+static uint32_t Run(BENCH* b, int mode, double seconds);
+static void* Requester(void* arg);
+static void* AsyncRequester(void* arg);
+static void AsyncDone(void* arg, int status, const void* reply, uint16_t replylen);
+static void* Worker(void* arg);
+static void* Dtc(void* arg);
+static bool Transaction(BENCH* b, SIM_MSG* msgTx, SIM_MSG* msgRx, uint32_t timeout);
+static bool TransactionAsync(BENCH* b, SIM_MSG* msgTx, IPC_TRANS_FXN fxn, void* arg,
+                             uint32_t timeout);
+static bool LegacyTransaction(BENCH* b, SIM_MSG* msgTx, SIM_MSG* msgRx, uint32_t timeout);
+static int TransOpen(BENCH* b, IPC_TRANS_FXN fxn, void* arg, uint32_t timeout);
+static void TransClose(BENCH* b, int slot);
+static void TransReply(BENCH* b, LINK_FRAME* f);
+static uint32_t TransExpire(BENCH* b);
+static uint8_t Post(BENCH* b, SIM_MSG* msg, int slot, uint32_t timeout);
+static void WindowAck(BENCH* b, uint8_t seqnum);
+static void MakeRequest(REQUESTER* r, SIM_MSG* msg);
+static bool Check(const SIM_MSG* tx, const SIM_MSG* rx);
+static void Latency(REQUESTER* r, uint64_t start);
+static uint64_t NowUs(void);
+static uint32_t NowMs(BENCH* b);
+static void Deadline(struct timespec* ts, uint32_t us);
+static double Uniform(uint32_t* seed);
+static uint32_t Random(uint32_t* seed);
+static int Compare(const void* a, const void* b);
+
+//*****************************************************************************
+// Main program entry point.
+//*****************************************************************************
+
+int main(int argc, char* argv[])
+{
+    static BENCH bench;
+    double seconds = 5.0;
+    uint32_t errors = 0;
+    int opt;
+
+    bench.nreq = 16;
+    bench.drop = 0.001;
+    bench.seed = 1;
+
+    while ((opt = getopt(argc, argv, "t:n:s:d:")) != -1)
+    {
+        switch(opt)
+        {
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 'n':
+            bench.nreq = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            bench.seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            bench.drop = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-n requesters] [-s seed] [-d drop rate]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if ((bench.nreq < 1) || (bench.nreq > MAX_REQUESTERS))
+    {
+        fprintf(stderr, "requesters must be 1 to %d\n", MAX_REQUESTERS);
+        return 1;
+    }
+
+    /* Zero would repeat forever */
+    if (!bench.seed)
+        bench.seed = 1;
+
+    printf("ipc transactions: %.0f s a run, %u requesters, %d ms timeout, seed %u\n",
+           seconds, bench.nreq, TRANS_TIMEOUT_MS, bench.seed);
+    printf("DTC answers in %d-%d us, %.1f%% never and %.1f%% after %d ms\n\n",
+           REPLY_MIN_US, REPLY_MAX_US, bench.drop * 100.0, bench.drop * 100.0, LATE_MS);
+
+    printf("%-7s %5s %7s %7s %6s %7s %6s %6s %6s %7s %7s %7s %7s\n", "mode", "async",
+           "posted", "ok", "wrong", "timeout", "failed", "unans", "twice", "missing",
+           "avg ms", "p99 ms", "trans/s");
+
+    Run(&bench, MODE_LEGACY, seconds);
+    errors = Run(&bench, MODE_TABLE, seconds);
+
+    printf("\nwrong: reply to another request, timeout: no reply in %d ms, failed:\n",
+           TRANS_TIMEOUT_MS);
+    printf("async requests not posted in the timeout, unans: requests the DTC never\n");
+    printf("answered or answered late, twice and missing: callbacks called again\n");
+    printf("or never. A wait for the window or a slot counts to the timeouts.\n");
+    printf("Latency is post to reply for the transactions answered right\n");
+
+    printf("\n%u check errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+/* Run the requesters against the DTC for the time given in one mode.
+ * Returns the check errors.
+ */
+static uint32_t Run(BENCH* b, int mode, double seconds)
+{
+    pthread_t worker, dtc;
+    REQUESTER* r;
+    float* lat;
+    uint32_t posted = 0, ok = 0, wrong = 0, timeouts = 0, failed = 0;
+    uint32_t twice = 0, missing = 0, async = 0;
+    uint32_t errors = 0;
+    size_t n = 0;
+    double sum = 0.0;
+    double p99 = 0.0;
+    uint64_t start;
+    uint32_t i, k;
+
+    b->mode     = mode;
+    b->stop     = false;
+    b->quit     = false;
+    b->epoch    = NowUs();
+    b->events   = 0;
+    b->txBase   = IPC_MIN_SEQ;
+    b->txNext   = IPC_MIN_SEQ;
+    b->txCount  = 0;
+    b->givenUp  = 0;
+    b->dropped  = 0;
+    b->late     = 0;
+    b->dtcSeed  = b->seed;
+    b->rxHead   = 0;
+    b->rxCount  = 0;
+
+    memset(b->acked, 0, sizeof(b->acked));
+    memset(b->dtc, 0, sizeof(b->dtc));
+    memset(b->ackBuf, 0, sizeof(b->ackBuf));
+
+    pthread_mutex_init(&b->gate, NULL);
+    pthread_mutex_init(&b->evLock, NULL);
+    pthread_mutex_init(&b->winLock, NULL);
+    pthread_mutex_init(&b->dtcLock, NULL);
+    pthread_mutex_init(&b->rxLock, NULL);
+    pthread_cond_init(&b->evCond, NULL);
+    pthread_cond_init(&b->winCond, NULL);
+    pthread_cond_init(&b->dtcCond, NULL);
+    pthread_cond_init(&b->rxCond, NULL);
+
+    IPCTrans_init(&b->trans);
+    sem_init(&b->transFree, 0, IPC_TRANS_MAX);
+
+    for (i=0; i < IPC_TRANS_MAX; i++)
+        sem_init(&b->transSem[i], 0, 0);
+
+    pthread_create(&worker, NULL, Worker, b);
+    pthread_create(&dtc, NULL, Dtc, b);
+
+    start = NowUs();
+
+    for (i=0; i < b->nreq; i++)
+    {
+        r = &b->req[i];
+
+        lat = r->lat ? r->lat : malloc(LAT_MAX * sizeof(float));
+        memset(r, 0, sizeof(REQUESTER));
+
+        r->b     = b;
+        r->id    = i;
+        r->lat   = lat;
+        r->seed  = (b->seed * 2654435761u) ^ ((i + 1) * 40503u) ^ ((uint32_t)mode << 20);
+        r->async = (mode == MODE_TABLE) && (i & 1);
+
+        if (!r->seed)
+            r->seed = 1;
+
+        if (r->async)
+        {
+            sem_init(&r->credit, 0, ASYNC_DEPTH);
+            async++;
+        }
+
+        pthread_create(&r->thread, NULL, r->async ? AsyncRequester : Requester, r);
+    }
+
+    usleep((useconds_t)(seconds * 1e6));
+
+    b->stop = true;
+
+    for (i=0; i < b->nreq; i++)
+        pthread_join(b->req[i].thread, NULL);
+
+    seconds = (double)(NowUs() - start) / 1e6;
+
+    b->quit = true;
+
+    pthread_mutex_lock(&b->rxLock);
+    pthread_cond_broadcast(&b->rxCond);
+    pthread_mutex_unlock(&b->rxLock);
+
+    pthread_mutex_lock(&b->dtcLock);
+    pthread_cond_broadcast(&b->dtcCond);
+    pthread_mutex_unlock(&b->dtcLock);
+
+    pthread_join(worker, NULL);
+    pthread_join(dtc, NULL);
+
+    for (i=0; i < b->nreq; i++)
+    {
+        r = &b->req[i];
+
+        posted   += r->posted;
+        ok       += r->ok;
+        wrong    += r->wrong;
+        timeouts += r->timeouts;
+        failed   += r->failed;
+        twice    += r->twice;
+        missing  += r->missing;
+        n        += r->nlat;
+
+        if (r->async)
+            sem_destroy(&r->credit);
+    }
+
+    lat = malloc((n + 1) * sizeof(float));
+    n = 0;
+
+    for (i=0; i < b->nreq; i++)
+    {
+        for (k=0; k < b->req[i].nlat; k++)
+        {
+            lat[n++] = b->req[i].lat[k];
+            sum += b->req[i].lat[k];
+        }
+    }
+
+    if (n)
+    {
+        qsort(lat, n, sizeof(float), Compare);
+        p99 = lat[(size_t)((n - 1) * 0.99)];
+    }
+
+    printf("%-7s %5u %7u %7u %6u %7u %6u %6u %6u %7u %7.2f %7.2f %7.0f\n",
+           (mode == MODE_TABLE) ? "table" : "legacy", async, posted, ok, wrong, timeouts,
+           failed, b->dropped + b->late, twice, missing, n ? sum / n / 1000.0 : 0.0,
+           p99 / 1000.0, ok / seconds);
+
+    if (mode == MODE_TABLE)
+    {
+        printf("%-7s %u opened, %u completed, %u timed out, %u late replies dropped, "
+               "peak %u open\n", "", b->trans.stats.opened, b->trans.stats.completed,
+               b->trans.stats.timeouts, b->trans.stats.late, b->trans.stats.peak);
+
+        errors = wrong + twice + missing;
+
+        /* Every slot must be closed again */
+        if (b->trans.open)
+            errors++;
+    }
+
+    free(lat);
+
+    for (i=0; i < IPC_TRANS_MAX; i++)
+        sem_destroy(&b->transSem[i]);
+
+    sem_destroy(&b->transFree);
+
+    return errors;
+}
+
+/* A task making transactions and waiting on each */
+static void* Requester(void* arg)
+{
+    REQUESTER* r = (REQUESTER*)arg;
+    BENCH* b = r->b;
+    SIM_MSG msgTx, msgRx;
+    uint64_t start;
+    bool done;
+
+    while (!b->stop)
+    {
+        MakeRequest(r, &msgTx);
+
+        start = NowUs();
+
+        if (b->mode == MODE_TABLE)
+            done = Transaction(b, &msgTx, &msgRx, TRANS_TIMEOUT_MS);
+        else
+            done = LegacyTransaction(b, &msgTx, &msgRx, TRANS_TIMEOUT_MS);
+
+        r->posted++;
+
+        if (!done)
+        {
+            r->timeouts++;
+        }
+        else if (!Check(&msgTx, &msgRx))
+        {
+            r->wrong++;
+        }
+        else
+        {
+            r->ok++;
+            Latency(r, start);
+        }
+    }
+
+    return NULL;
+}
+
+/* A task keeping several async transactions in flight */
+static void* AsyncRequester(void* arg)
+{
+    REQUESTER* r = (REQUESTER*)arg;
+    BENCH* b = r->b;
+    ASYNC_REQ* q;
+    SIM_MSG msgTx;
+    struct timespec ts;
+    int i;
+
+    while (!b->stop)
+    {
+        sem_wait(&r->credit);
+
+        for (i=0; i < ASYNC_DEPTH; i++)
+        {
+            if (!r->req[i].busy)
+                break;
+        }
+
+        q = &r->req[i];
+
+        MakeRequest(r, &msgTx);
+
+        q->r     = r;
+        q->busy  = true;
+        q->calls = 0;
+        q->token = msgTx.param1.U;
+        q->start = NowUs();
+
+        r->posted++;
+
+        if (!TransactionAsync(b, &msgTx, AsyncDone, q, TRANS_TIMEOUT_MS))
+        {
+            r->failed++;
+            q->busy = false;
+            sem_post(&r->credit);
+        }
+    }
+
+    /* Every request must be called back once its timeout has passed */
+    for (i=0; i < ASYNC_DEPTH; i++)
+    {
+        Deadline(&ts, TRANS_TIMEOUT_MS * 4000);
+
+        if (sem_timedwait(&r->credit, &ts) != 0)
+            r->missing++;
+    }
+
+    return NULL;
+}
+
+/* Async transaction callback, called from the worker */
+static void AsyncDone(void* arg, int status, const void* reply, uint16_t replylen)
+{
+    ASYNC_REQ* q = (ASYNC_REQ*)arg;
+    REQUESTER* r = q->r;
+    SIM_MSG msgTx, msgRx;
+
+    if (q->calls++)
+    {
+        r->twice++;
+        return;
+    }
+
+    if (status != IPC_TRANS_OK)
+    {
+        r->timeouts++;
+    }
+    else
+    {
+        memset(&msgRx, 0, sizeof(SIM_MSG));
+        memcpy(&msgRx, reply, (replylen < sizeof(SIM_MSG)) ? replylen : sizeof(SIM_MSG));
+
+        msgTx.param1.U = q->token;
+
+        if (!Check(&msgTx, &msgRx))
+        {
+            r->wrong++;
+        }
+        else
+        {
+            r->ok++;
+            Latency(r, q->start);
+        }
+    }
+
+    q->busy = false;
+    sem_post(&r->credit);
+}
+
+/* The IPC worker task, taking the replies */
+static void* Worker(void* arg)
+{
+    BENCH* b = (BENCH*)arg;
+    LINK_FRAME f;
+    struct timespec ts;
+    uint32_t wait = POLL_MS;
+    bool got;
+
+    while (!b->quit)
+    {
+        pthread_mutex_lock(&b->rxLock);
+
+        Deadline(&ts, wait * 1000);
+
+        while (!b->rxCount && !b->quit)
+        {
+            if (pthread_cond_timedwait(&b->rxCond, &b->rxLock, &ts) == ETIMEDOUT)
+                break;
+        }
+
+        if ((got = (b->rxCount > 0)))
+        {
+            f = b->rx[b->rxHead];
+            b->rxHead = (b->rxHead + 1) % LINK_MAX;
+            b->rxCount--;
+        }
+
+        pthread_mutex_unlock(&b->rxLock);
+
+        if (got)
+        {
+            /* The reply ACKs the request */
+            WindowAck(b, f.seqnum);
+
+            if (b->mode == MODE_TABLE)
+            {
+                TransReply(b, &f);
+            }
+            else
+            {
+                uint32_t index = (f.seqnum - 1) % IPC_MAX_WINDOW;
+
+                pthread_mutex_lock(&b->evLock);
+                b->ackBuf[index] = f.msg;
+                b->events |= 1u << index;
+                pthread_cond_broadcast(&b->evCond);
+                pthread_mutex_unlock(&b->evLock);
+            }
+        }
+
+        if (b->mode == MODE_TABLE)
+            wait = TransExpire(b);
+    }
+
+    return NULL;
+}
+
+/* The DTC, answering each request after its reply delay */
+static void* Dtc(void* arg)
+{
+    BENCH* b = (BENCH*)arg;
+    LINK_FRAME* f;
+    struct timespec ts;
+    uint64_t now, next;
+    int i;
+
+    pthread_mutex_lock(&b->dtcLock);
+
+    while (!b->quit)
+    {
+        now  = NowUs();
+        next = now + POLL_MS * 1000;
+
+        for (i=0; i < LINK_MAX; i++)
+        {
+            f = &b->dtc[i];
+
+            if (!f->used)
+                continue;
+
+            if (f->due > now)
+            {
+                if (f->due < next)
+                    next = f->due;
+                continue;
+            }
+
+            /* Answer with the request echoed and the token flipped, as
+             * the handlers answer with the request they were given.
+             */
+            f->msg.param2.U = f->msg.param1.U ^ TOKEN_REPLY;
+            f->used = false;
+
+            pthread_mutex_lock(&b->rxLock);
+
+            if (b->rxCount < LINK_MAX)
+            {
+                b->rx[(b->rxHead + b->rxCount) % LINK_MAX] = *f;
+                b->rxCount++;
+                pthread_cond_signal(&b->rxCond);
+            }
+
+            pthread_mutex_unlock(&b->rxLock);
+        }
+
+        Deadline(&ts, (uint32_t)(next - now));
+        pthread_cond_timedwait(&b->dtcCond, &b->dtcLock, &ts);
+    }
+
+    pthread_mutex_unlock(&b->dtcLock);
+
+    return NULL;
+}
+
+/* IPC_Transaction() */
+static bool Transaction(BENCH* b, SIM_MSG* msgTx, SIM_MSG* msgRx, uint32_t timeout)
+{
+    struct timespec ts;
+    int slot;
+    bool done;
+
+    memset(msgRx, 0, sizeof(SIM_MSG));
+
+    if ((slot = TransOpen(b, NULL, NULL, timeout)) < 0)
+        return false;
+
+    if (!Post(b, msgTx, slot, timeout))
+    {
+        TransClose(b, slot);
+        return false;
+    }
+
+    Deadline(&ts, timeout * 1000);
+
+    while ((sem_timedwait(&b->transSem[slot], &ts) != 0) && (errno == EINTR))
+        continue;
+
+    pthread_mutex_lock(&b->gate);
+
+    if ((done = IPCTrans_done(&b->trans, slot)))
+        memcpy(msgRx, b->trans.slot[slot].reply, sizeof(SIM_MSG));
+
+    pthread_mutex_unlock(&b->gate);
+
+    TransClose(b, slot);
+
+    return done;
+}
+
+/* IPC_TransactionAsync() */
+static bool TransactionAsync(BENCH* b, SIM_MSG* msgTx, IPC_TRANS_FXN fxn, void* arg,
+                             uint32_t timeout)
+{
+    int slot;
+
+    if ((slot = TransOpen(b, fxn, arg, timeout)) < 0)
+        return false;
+
+    if (!Post(b, msgTx, slot, timeout))
+    {
+        TransClose(b, slot);
+        return false;
+    }
+
+    return true;
+}
+
+/* IPC_Transaction() as it was, waiting on any reply event */
+static bool LegacyTransaction(BENCH* b, SIM_MSG* msgTx, SIM_MSG* msgRx, uint32_t timeout)
+{
+    struct timespec ts;
+    uint32_t index;
+    uint32_t events = 0;
+    uint8_t seqnum;
+
+    memset(msgRx, 0, sizeof(SIM_MSG));
+
+    if ((seqnum = Post(b, msgTx, -1, timeout)) == IPC_NULL_SEQ)
+        return false;
+
+    index = (seqnum - 1) % IPC_MAX_WINDOW;
+
+    Deadline(&ts, timeout * 1000);
+
+    pthread_mutex_lock(&b->evLock);
+
+    while (!b->events)
+    {
+        if (pthread_cond_timedwait(&b->evCond, &b->evLock, &ts) == ETIMEDOUT)
+            break;
+    }
+
+    /* Event_pend() takes all the events posted */
+    if ((events = b->events) != 0)
+    {
+        b->events = 0;
+        *msgRx = b->ackBuf[index];
+    }
+
+    pthread_mutex_unlock(&b->evLock);
+
+    return (events != 0);
+}
+
+/* Wait for a free transaction slot and open it */
+static int TransOpen(BENCH* b, IPC_TRANS_FXN fxn, void* arg, uint32_t timeout)
+{
+    struct timespec ts;
+    int slot;
+
+    Deadline(&ts, timeout * 1000);
+
+    if (sem_timedwait(&b->transFree, &ts) != 0)
+        return -1;
+
+    pthread_mutex_lock(&b->gate);
+    slot = IPCTrans_open(&b->trans, fxn, arg, NowMs(b), timeout);
+    pthread_mutex_unlock(&b->gate);
+
+    /* Semaphore_reset() */
+    while (sem_trywait(&b->transSem[slot]) == 0)
+        continue;
+
+    return slot;
+}
+
+/* Free a transaction slot */
+static void TransClose(BENCH* b, int slot)
+{
+    pthread_mutex_lock(&b->gate);
+    IPCTrans_close(&b->trans, slot);
+    pthread_mutex_unlock(&b->gate);
+
+    sem_post(&b->transFree);
+}
+
+/* Complete the transaction a reply answers */
+static void TransReply(BENCH* b, LINK_FRAME* f)
+{
+    IPC_TRANS_FXN fxn = NULL;
+    void* arg = NULL;
+    int slot;
+
+    pthread_mutex_lock(&b->gate);
+
+    if ((slot = IPCTrans_reply(&b->trans, f->seqnum, &f->msg, sizeof(SIM_MSG))) >= 0)
+    {
+        fxn = b->trans.slot[slot].fxn;
+        arg = b->trans.slot[slot].arg;
+
+        if (!fxn)
+            sem_post(&b->transSem[slot]);
+    }
+
+    pthread_mutex_unlock(&b->gate);
+
+    if ((slot < 0) || !fxn)
+        return;
+
+    fxn(arg, IPC_TRANS_OK, &f->msg, sizeof(SIM_MSG));
+
+    TransClose(b, slot);
+}
+
+/* Call back the async transactions timed out. Returns the ms to wait. */
+static uint32_t TransExpire(BENCH* b)
+{
+    IPC_TRANS_FXN fxn;
+    void* arg;
+    uint32_t due = IPC_TRANS_FOREVER;
+    int slot;
+
+    while (1)
+    {
+        pthread_mutex_lock(&b->gate);
+
+        if ((slot = IPCTrans_expire(&b->trans, NowMs(b))) < 0)
+            due = IPCTrans_due(&b->trans, NowMs(b));
+
+        fxn = (slot >= 0) ? b->trans.slot[slot].fxn : NULL;
+        arg = (slot >= 0) ? b->trans.slot[slot].arg : NULL;
+
+        pthread_mutex_unlock(&b->gate);
+
+        if (slot < 0)
+            break;
+
+        fxn(arg, IPC_TRANS_TIMEOUT, NULL, 0);
+
+        TransClose(b, slot);
+    }
+
+    /* Round up so the wait does not end just short of the deadline */
+    return (due < POLL_MS) ? due + 1 : POLL_MS;
+}
+
+/* Number a request in the send window, key its transaction slot and send
+ * it to the DTC. Returns its sequence number, or IPC_NULL_SEQ if the window
+ * stayed full for the timeout.
+ */
+static uint8_t Post(BENCH* b, SIM_MSG* msg, int slot, uint32_t timeout)
+{
+    struct timespec ts;
+    LINK_FRAME* f;
+    uint64_t now;
+    uint8_t seqnum;
+    int i;
+
+    Deadline(&ts, timeout * 1000);
+
+    pthread_mutex_lock(&b->winLock);
+
+    while (b->txCount >= IPC_MAX_WINDOW)
+    {
+        /* Give up on the oldest request if it has gone unanswered */
+        if (NowUs() - b->sentAt[b->txBase] >= GIVEUP_MS * 1000)
+        {
+            b->givenUp++;
+            b->acked[b->txBase] = true;
+
+            while (b->txCount && b->acked[b->txBase])
+            {
+                b->txBase = IPC_INC_SEQ(b->txBase);
+                b->txCount--;
+            }
+
+            continue;
+        }
+
+        if (pthread_cond_timedwait(&b->winCond, &b->winLock, &ts) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&b->winLock);
+            return IPC_NULL_SEQ;
+        }
+    }
+
+    seqnum = b->txNext;
+
+    b->txNext = IPC_INC_SEQ(b->txNext);
+    b->txCount++;
+    b->acked[seqnum]  = false;
+    b->sentAt[seqnum] = NowUs();
+
+    pthread_mutex_unlock(&b->winLock);
+
+    /* Keyed before it is sent, or the reply could beat it */
+    if (slot >= 0)
+    {
+        pthread_mutex_lock(&b->gate);
+        IPCTrans_start(&b->trans, slot, seqnum);
+        pthread_mutex_unlock(&b->gate);
+    }
+
+    pthread_mutex_lock(&b->dtcLock);
+
+    for (i=0; i < LINK_MAX; i++)
+    {
+        if (!b->dtc[i].used)
+            break;
+    }
+
+    now = NowUs();
+
+    if (Uniform(&b->dtcSeed) < b->drop)
+    {
+        b->dropped++;
+    }
+    else if (i < LINK_MAX)
+    {
+        f = &b->dtc[i];
+
+        f->used   = true;
+        f->seqnum = seqnum;
+        f->msg    = *msg;
+
+        if (Uniform(&b->dtcSeed) < b->drop)
+        {
+            b->late++;
+            f->due = now + LATE_MS * 1000;
+        }
+        else
+        {
+            f->due = now + REPLY_MIN_US +
+                     (uint64_t)(Uniform(&b->dtcSeed) * (REPLY_MAX_US - REPLY_MIN_US));
+        }
+
+        pthread_cond_signal(&b->dtcCond);
+    }
+
+    pthread_mutex_unlock(&b->dtcLock);
+
+    return seqnum;
+}
+
+/* Free a request's sequence number once its reply has come */
+static void WindowAck(BENCH* b, uint8_t seqnum)
+{
+    pthread_mutex_lock(&b->winLock);
+
+    b->acked[seqnum] = true;
+
+    while (b->txCount && b->acked[b->txBase])
+    {
+        b->txBase = IPC_INC_SEQ(b->txBase);
+        b->txCount--;
+    }
+
+    pthread_cond_broadcast(&b->winCond);
+    pthread_mutex_unlock(&b->winLock);
+}
+
+/* A transport query carrying a token unique to the request */
+static void MakeRequest(REQUESTER* r, SIM_MSG* msg)
+{
+    static const uint16_t opcodes[] = {
+        OP_TRANSPORT_GET_MODE, OP_TRANSPORT_GET_VELOCITY, OP_TRANSPORT_GET_TACH
+    };
+
+    msg->type     = IPC_TYPE_TRANSPORT;
+    msg->opcode   = opcodes[Random(&r->seed) % 3];
+    msg->param1.U = (r->id << 24) | (r->posted & 0xFFFFFF);
+    msg->param2.U = 0;
+}
+
+/* Returns true if a reply answers the request */
+static bool Check(const SIM_MSG* tx, const SIM_MSG* rx)
+{
+    return (rx->param1.U == tx->param1.U) && (rx->param2.U == (tx->param1.U ^ TOKEN_REPLY));
+}
+
+static void Latency(REQUESTER* r, uint64_t start)
+{
+    if (r->nlat < LAT_MAX)
+        r->lat[r->nlat++] = (float)(NowUs() - start);
+}
+
+static uint64_t NowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* The 1 ms clock tick */
+static uint32_t NowMs(BENCH* b)
+{
+    return (uint32_t)((NowUs() - b->epoch) / 1000);
+}
+
+/* Absolute time for the timed waits, the us given from now */
+static void Deadline(struct timespec* ts, uint32_t us)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+
+    ts->tv_sec  += us / 1000000;
+    ts->tv_nsec += (long)(us % 1000000) * 1000;
+
+    if (ts->tv_nsec >= 1000000000)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+/* Uniform in [0, 1) */
+static double Uniform(uint32_t* seed)
+{
+    return (double)Random(seed) / 4294967296.0;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+static int Compare(const void* a, const void* b)
+{
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+
+    return (x > y) - (x < y);
+}
+
+/* End-Of-File */
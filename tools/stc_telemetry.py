@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# STC-1200 position telemetry stream decoder.
+#
+# Connects to the STC-1200 telemetry port (or reads a captured stream
+# from a file) and writes the samples out as CSV. See STC_TELEMETRY_HDR
+# and STC_TELEMETRY_REC in STC1200TCP.h for the stream format.
+#
+# Usage:
+#   stc_telemetry.py 192.168.1.50 > locate.csv
+#   stc_telemetry.py -f capture.bin > locate.csv
+#   nc 192.168.1.50 1202 > capture.bin
+#
+
+import argparse
+import socket
+import struct
+import sys
+
+STC_PORT_TELEMETRY = 1202
+STC_TELEMETRY_MAGIC = 0x4D4C4554
+
+ROLLER_TICKS_PER_REV = 80
+
+HDR = struct.Struct("<IHHIIII")
+REC = struct.Struct("<IifHBB")
+
+MODES = {0: "HALT", 1: "STOP", 2: "PLAY", 3: "FWD", 4: "REW", 5: "THREAD"}
+
+STC_M_RECORD = 0x0080
+STC_M_SEARCH = 0x0100
+STC_M_LOOP   = 0x0200
+STC_M_PUNCH  = 0x0400
+
+STC_TF_MOVING    = 0x01
+STC_TF_SLIP      = 0x02
+STC_TF_QEI_ERROR = 0x04
+
+
+def read_exact(stream, size):
+    buf = b""
+    while len(buf) < size:
+        data = stream.read(size - len(buf))
+        if not data:
+            return None
+        buf += data
+    return buf
+
+
+def resync(stream, head):
+    """Slide forward a byte at a time until the magic is found."""
+    magic = struct.pack("<I", STC_TELEMETRY_MAGIC)
+    while head[:4] != magic:
+        data = stream.read(1)
+        if not data:
+            return None
+        head = head[1:] + data
+    rest = read_exact(stream, HDR.size - len(head))
+    return None if rest is None else head + rest
+
+
+def decode(stream, out, count):
+    out.write("sequence,seconds,position,inches,velocity_ips,mode,"
+              "record,search,loop,punch,progress,moving,slip,qei_error\n")
+
+    t0 = None
+    last = None
+    written = 0
+    lost = 0
+
+    while count is None or written < count:
+        head = read_exact(stream, HDR.size)
+        if head is None:
+            break
+
+        magic, length, n, sequence, lost_total, freq, circ = HDR.unpack(head)
+
+        if magic != STC_TELEMETRY_MAGIC:
+            sys.stderr.write("bad packet magic, resyncing\n")
+            head = resync(stream, head)
+            if head is None:
+                break
+            magic, length, n, sequence, lost_total, freq, circ = HDR.unpack(head)
+
+        if length > HDR.size:
+            read_exact(stream, length - HDR.size)
+
+        body = read_exact(stream, n * REC.size)
+        if body is None:
+            break
+
+        if lost_total != lost:
+            sys.stderr.write("%d samples lost\n" % (lost_total - lost))
+            lost = lost_total
+
+        inches_per_tick = (circ / 1.0e6) / ROLLER_TICKS_PER_REV
+
+        for i in range(n):
+            ts, pos, vel, mode, progress, flags = REC.unpack_from(body, i * REC.size)
+
+            # Unwrap the 32-bit timestamp count
+            if t0 is None:
+                t0 = ts
+                elapsed = 0
+            else:
+                elapsed += (ts - last) & 0xFFFFFFFF
+            last = ts
+
+            out.write("%u,%.6f,%d,%.4f,%.3f,%s,%d,%d,%d,%d,%u,%d,%d,%d\n" % (
+                sequence + i,
+                elapsed / float(freq) if freq else 0.0,
+                pos,
+                pos * inches_per_tick,
+                vel,
+                MODES.get(mode & 0x07, str(mode & 0x07)),
+                1 if mode & STC_M_RECORD else 0,
+                1 if mode & STC_M_SEARCH else 0,
+                1 if mode & STC_M_LOOP else 0,
+                1 if mode & STC_M_PUNCH else 0,
+                progress,
+                1 if flags & STC_TF_MOVING else 0,
+                1 if flags & STC_TF_SLIP else 0,
+                1 if flags & STC_TF_QEI_ERROR else 0))
+
+            written += 1
+
+    out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode STC-1200 telemetry to CSV")
+    parser.add_argument("host", nargs="?", help="STC-1200 IP address")
+    parser.add_argument("-p", "--port", type=int, default=STC_PORT_TELEMETRY)
+    parser.add_argument("-f", "--file", help="read a captured stream file")
+    parser.add_argument("-n", "--count", type=int, help="stop after this many samples")
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as stream:
+            decode(stream, sys.stdout, args.count)
+    elif args.host:
+        sock = socket.create_connection((args.host, args.port))
+        try:
+            decode(sock.makefile("rb"), sys.stdout, args.count)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            sock.close()
+    else:
+        parser.error("a host or --file is required")
+
+
+if __name__ == "__main__":
+    main()
@@ -78,8 +78,10 @@
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Queue.h>
 #include <ti/sysbios/hal/Seconds.h>
+#include <ti/sysbios/gates/GateMutex.h>
 
 #include "xmodem.h"
+#include "CRC16.h"
 #include "board.h"
 
 /* Various definitions. */
@@ -101,6 +103,9 @@
 #define SUB         0x1a    /* final packet filler value */
 #define CRC         'C'
 
+/* One transfer at a time owns the packet buffer and the CRC module */
+static GateMutex_Struct xmodem_gate;
+
 /* XMODEM Packet Buffer */
 static uint8_t      xmodem_buff[PKT_SIZE_1K];
 #if USE_YMODEM
@@ -108,6 +113,10 @@ char                xmodem_name[32];
 uint32_t            xmodem_size;
 #endif
 
+/* Static Function Prototypes */
+static int receive_file(UART_Handle handle, FIL* fp);
+static int send_file(UART_Handle handle, FIL* fp);
+
 /******************************************************************************
  * Serial Interface Functions
  ******************************************************************************/
@@ -151,27 +160,6 @@ static int uart_getc(UART_Handle handle, int secs)
  * XMODEM Helper Functions
  ******************************************************************************/
 
-/*
- * Update the CRC16 value for the given byte.
- */
-
-static uint16_t xmodem_crc(uint16_t crc, uint8_t c)
-{
-    register int i;
-
-    crc = crc ^ ((uint16_t)c << 8);
-
-    for (i=0; i < 8; i++)
-    {
-        if (crc & 0x8000)
-            crc = (crc << 1) ^ 0x1021;
-        else
-            crc <<= 1;
-    }
-
-    return crc;
-}
-
 /*
  * Write a block of data to a file stream.
  */
@@ -204,11 +192,32 @@ static FRESULT xmodem_write_block(FIL* fp, uint8_t *buf, int32_t size)
  * and additions. We only support the CRC16 mode to ensure data validity.
  ***************************************************************************/
 
+/*
+ * Initialize the gate the transfers run under. Call once at startup.
+ */
+
+void xmodem_init(void)
+{
+    GateMutex_construct(&xmodem_gate, NULL);
+}
+
 /*
  * Receive a file using the XMODEM protocol.
  */
 
 int xmodem_receive(UART_Handle handle, FIL* fp)
+{
+    int rc;
+    IArg key = GateMutex_enter(GateMutex_handle(&xmodem_gate));
+
+    rc = receive_file(handle, fp);
+
+    GateMutex_leave(GateMutex_handle(&xmodem_gate), key);
+
+    return rc;
+}
+
+static int receive_file(UART_Handle handle, FIL* fp)
 {
     int i;
     int c;
@@ -365,8 +374,6 @@ int xmodem_receive(UART_Handle handle, FIL* fp)
                 continue;
             }
 
-            crc = 0;
-
             for (i=0; i < 128; i++)
             {
                 if ((c = uart_getc(handle, 5)) == -1)
@@ -374,9 +381,6 @@ int xmodem_receive(UART_Handle handle, FIL* fp)
 
                 /* Store data byte in our packet buffer */
                 xmodem_buff[i] = (uint8_t)c;
-
-                /* Sum the byte into the CRC */
-                crc = xmodem_crc(crc, xmodem_buff[i]);
             }
 
             /* Did we get a whole packet? */
@@ -392,6 +396,9 @@ int xmodem_receive(UART_Handle handle, FIL* fp)
                 continue;
             }
 
+            /* Sum the block into the CRC */
+            crc = CRC16XmodemBlock(0, xmodem_buff, 128);
+
             /* Read CRC high byte word */
             if ((c = uart_getc(handle, 3)) == -1)
             {
@@ -490,6 +497,18 @@ int xmodem_receive(UART_Handle handle, FIL* fp)
  */
 
 int xmodem_send(UART_Handle handle, FIL* fp)
+{
+    int rc;
+    IArg key = GateMutex_enter(GateMutex_handle(&xmodem_gate));
+
+    rc = send_file(handle, fp);
+
+    GateMutex_leave(GateMutex_handle(&xmodem_gate), key);
+
+    return rc;
+}
+
+static int send_file(UART_Handle handle, FIL* fp)
 {
     int i;
     int c;
@@ -583,7 +602,8 @@ int xmodem_send(UART_Handle handle, FIL* fp)
                     lastblock = true;
             }
 
-            crc = 0;
+            /* Sum the block into the CRC */
+            crc = CRC16XmodemBlock(0, xmodem_buff, 128);
             csum = 0;
 
             uart_putc(handle, SOH);
@@ -595,9 +615,6 @@ int xmodem_send(UART_Handle handle, FIL* fp)
                 /* send a byte out */
                 uart_putc(handle, xmodem_buff[i]);
 
-                /* Sum the byte into the CRC */
-                crc = xmodem_crc(crc, xmodem_buff[i]);
-
                 /* Sum the checksum */
                 csum += xmodem_buff[i];
             }
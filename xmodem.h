@@ -14,6 +14,7 @@ typedef enum XMODEM_ERROR {
 
 /* Interface Functions */
 
+void xmodem_init(void);
 int xmodem_receive(UART_Handle handle, FIL* fp);
 int xmodem_send(UART_Handle handle, FIL* fp);
 